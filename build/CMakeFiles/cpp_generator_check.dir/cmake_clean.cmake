@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/cpp_generator_check.dir/timings/cpp_generator_check.cpp.o"
+  "CMakeFiles/cpp_generator_check.dir/timings/cpp_generator_check.cpp.o.d"
+  "cpp_generator_check"
+  "cpp_generator_check.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/cpp_generator_check.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/csc_thread_check.dir/timings/csc_thread_check.cpp.o"
+  "CMakeFiles/csc_thread_check.dir/timings/csc_thread_check.cpp.o.d"
+  "csc_thread_check"
+  "csc_thread_check.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/csc_thread_check.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/engine_parity_check.dir/timings/engine_parity_check.cpp.o"
+  "CMakeFiles/engine_parity_check.dir/timings/engine_parity_check.cpp.o.d"
+  "engine_parity_check"
+  "engine_parity_check.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/engine_parity_check.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
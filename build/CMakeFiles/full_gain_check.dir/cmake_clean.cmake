@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/full_gain_check.dir/timings/full_gain_check.cpp.o"
+  "CMakeFiles/full_gain_check.dir/timings/full_gain_check.cpp.o.d"
+  "full_gain_check"
+  "full_gain_check.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/full_gain_check.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/histogram_check.dir/timings/histogram_check.cpp.o"
+  "CMakeFiles/histogram_check.dir/timings/histogram_check.cpp.o.d"
+  "histogram_check"
+  "histogram_check.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/histogram_check.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
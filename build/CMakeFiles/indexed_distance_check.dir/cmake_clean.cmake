@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/indexed_distance_check.dir/timings/indexed_distance_check.cpp.o"
+  "CMakeFiles/indexed_distance_check.dir/timings/indexed_distance_check.cpp.o.d"
+  "indexed_distance_check"
+  "indexed_distance_check.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/indexed_distance_check.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
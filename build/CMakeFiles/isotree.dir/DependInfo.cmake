@@ -0,0 +1,45 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/bin_plan.cpp" "CMakeFiles/isotree.dir/src/bin_plan.cpp.o" "gcc" "CMakeFiles/isotree.dir/src/bin_plan.cpp.o.d"
+  "/root/repo/src/bitvector_forest.cpp" "CMakeFiles/isotree.dir/src/bitvector_forest.cpp.o" "gcc" "CMakeFiles/isotree.dir/src/bitvector_forest.cpp.o.d"
+  "/root/repo/src/c_interface.cpp" "CMakeFiles/isotree.dir/src/c_interface.cpp.o" "gcc" "CMakeFiles/isotree.dir/src/c_interface.cpp.o.d"
+  "/root/repo/src/cache_blocking.cpp" "CMakeFiles/isotree.dir/src/cache_blocking.cpp.o" "gcc" "CMakeFiles/isotree.dir/src/cache_blocking.cpp.o.d"
+  "/root/repo/src/compiled_forest.cpp" "CMakeFiles/isotree.dir/src/compiled_forest.cpp.o" "gcc" "CMakeFiles/isotree.dir/src/compiled_forest.cpp.o.d"
+  "/root/repo/src/compiled_simd.cpp" "CMakeFiles/isotree.dir/src/compiled_simd.cpp.o" "gcc" "CMakeFiles/isotree.dir/src/compiled_simd.cpp.o.d"
+  "/root/repo/src/cpp_generator.cpp" "CMakeFiles/isotree.dir/src/cpp_generator.cpp.o" "gcc" "CMakeFiles/isotree.dir/src/cpp_generator.cpp.o.d"
+  "/root/repo/src/executor.cpp" "CMakeFiles/isotree.dir/src/executor.cpp.o" "gcc" "CMakeFiles/isotree.dir/src/executor.cpp.o.d"
+  "/root/repo/src/flat_model.cpp" "CMakeFiles/isotree.dir/src/flat_model.cpp.o" "gcc" "CMakeFiles/isotree.dir/src/flat_model.cpp.o.d"
+  "/root/repo/src/formatted_exporters.cpp" "CMakeFiles/isotree.dir/src/formatted_exporters.cpp.o" "gcc" "CMakeFiles/isotree.dir/src/formatted_exporters.cpp.o.d"
+  "/root/repo/src/indexer.cpp" "CMakeFiles/isotree.dir/src/indexer.cpp.o" "gcc" "CMakeFiles/isotree.dir/src/indexer.cpp.o.d"
+  "/root/repo/src/instantiate_template_headers.cpp" "CMakeFiles/isotree.dir/src/instantiate_template_headers.cpp.o" "gcc" "CMakeFiles/isotree.dir/src/instantiate_template_headers.cpp.o.d"
+  "/root/repo/src/merge_models.cpp" "CMakeFiles/isotree.dir/src/merge_models.cpp.o" "gcc" "CMakeFiles/isotree.dir/src/merge_models.cpp.o.d"
+  "/root/repo/src/oop_interface.cpp" "CMakeFiles/isotree.dir/src/oop_interface.cpp.o" "gcc" "CMakeFiles/isotree.dir/src/oop_interface.cpp.o.d"
+  "/root/repo/src/prediction_context.cpp" "CMakeFiles/isotree.dir/src/prediction_context.cpp.o" "gcc" "CMakeFiles/isotree.dir/src/prediction_context.cpp.o.d"
+  "/root/repo/src/reorder_nodes.cpp" "CMakeFiles/isotree.dir/src/reorder_nodes.cpp.o" "gcc" "CMakeFiles/isotree.dir/src/reorder_nodes.cpp.o.d"
+  "/root/repo/src/serialize.cpp" "CMakeFiles/isotree.dir/src/serialize.cpp.o" "gcc" "CMakeFiles/isotree.dir/src/serialize.cpp.o.d"
+  "/root/repo/src/sql.cpp" "CMakeFiles/isotree.dir/src/sql.cpp.o" "gcc" "CMakeFiles/isotree.dir/src/sql.cpp.o.d"
+  "/root/repo/src/stream_scorer.cpp" "CMakeFiles/isotree.dir/src/stream_scorer.cpp.o" "gcc" "CMakeFiles/isotree.dir/src/stream_scorer.cpp.o.d"
+  "/root/repo/src/subset_models.cpp" "CMakeFiles/isotree.dir/src/subset_models.cpp.o" "gcc" "CMakeFiles/isotree.dir/src/subset_models.cpp.o.d"
+  )
+
+# Pairs of files generated by the same build rule.
+set(CMAKE_MULTIPLE_OUTPUT_PAIRS
+  "/root/repo/build/libisotree.so" "/root/repo/build/libisotree.so.0.6.1"
+  "/root/repo/build/libisotree.so.0" "/root/repo/build/libisotree.so.0.6.1"
+  )
+
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
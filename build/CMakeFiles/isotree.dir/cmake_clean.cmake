@@ -0,0 +1,51 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/isotree.dir/src/bin_plan.cpp.o"
+  "CMakeFiles/isotree.dir/src/bin_plan.cpp.o.d"
+  "CMakeFiles/isotree.dir/src/bitvector_forest.cpp.o"
+  "CMakeFiles/isotree.dir/src/bitvector_forest.cpp.o.d"
+  "CMakeFiles/isotree.dir/src/c_interface.cpp.o"
+  "CMakeFiles/isotree.dir/src/c_interface.cpp.o.d"
+  "CMakeFiles/isotree.dir/src/cache_blocking.cpp.o"
+  "CMakeFiles/isotree.dir/src/cache_blocking.cpp.o.d"
+  "CMakeFiles/isotree.dir/src/compiled_forest.cpp.o"
+  "CMakeFiles/isotree.dir/src/compiled_forest.cpp.o.d"
+  "CMakeFiles/isotree.dir/src/compiled_simd.cpp.o"
+  "CMakeFiles/isotree.dir/src/compiled_simd.cpp.o.d"
+  "CMakeFiles/isotree.dir/src/cpp_generator.cpp.o"
+  "CMakeFiles/isotree.dir/src/cpp_generator.cpp.o.d"
+  "CMakeFiles/isotree.dir/src/executor.cpp.o"
+  "CMakeFiles/isotree.dir/src/executor.cpp.o.d"
+  "CMakeFiles/isotree.dir/src/flat_model.cpp.o"
+  "CMakeFiles/isotree.dir/src/flat_model.cpp.o.d"
+  "CMakeFiles/isotree.dir/src/formatted_exporters.cpp.o"
+  "CMakeFiles/isotree.dir/src/formatted_exporters.cpp.o.d"
+  "CMakeFiles/isotree.dir/src/indexer.cpp.o"
+  "CMakeFiles/isotree.dir/src/indexer.cpp.o.d"
+  "CMakeFiles/isotree.dir/src/instantiate_template_headers.cpp.o"
+  "CMakeFiles/isotree.dir/src/instantiate_template_headers.cpp.o.d"
+  "CMakeFiles/isotree.dir/src/merge_models.cpp.o"
+  "CMakeFiles/isotree.dir/src/merge_models.cpp.o.d"
+  "CMakeFiles/isotree.dir/src/oop_interface.cpp.o"
+  "CMakeFiles/isotree.dir/src/oop_interface.cpp.o.d"
+  "CMakeFiles/isotree.dir/src/prediction_context.cpp.o"
+  "CMakeFiles/isotree.dir/src/prediction_context.cpp.o.d"
+  "CMakeFiles/isotree.dir/src/reorder_nodes.cpp.o"
+  "CMakeFiles/isotree.dir/src/reorder_nodes.cpp.o.d"
+  "CMakeFiles/isotree.dir/src/serialize.cpp.o"
+  "CMakeFiles/isotree.dir/src/serialize.cpp.o.d"
+  "CMakeFiles/isotree.dir/src/sql.cpp.o"
+  "CMakeFiles/isotree.dir/src/sql.cpp.o.d"
+  "CMakeFiles/isotree.dir/src/stream_scorer.cpp.o"
+  "CMakeFiles/isotree.dir/src/stream_scorer.cpp.o.d"
+  "CMakeFiles/isotree.dir/src/subset_models.cpp.o"
+  "CMakeFiles/isotree.dir/src/subset_models.cpp.o.d"
+  "libisotree.pdb"
+  "libisotree.so"
+  "libisotree.so.0"
+  "libisotree.so.0.6.1"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/isotree.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
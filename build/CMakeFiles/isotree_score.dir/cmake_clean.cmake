@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/isotree_score.dir/cli/isotree_score.cpp.o"
+  "CMakeFiles/isotree_score.dir/cli/isotree_score.cpp.o.d"
+  "isotree_score"
+  "isotree_score.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/isotree_score.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/node_task_check.dir/timings/node_task_check.cpp.o"
+  "CMakeFiles/node_task_check.dir/timings/node_task_check.cpp.o.d"
+  "node_task_check"
+  "node_task_check.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/node_task_check.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
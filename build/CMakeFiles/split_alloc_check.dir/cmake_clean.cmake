@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/split_alloc_check.dir/timings/split_alloc_check.cpp.o"
+  "CMakeFiles/split_alloc_check.dir/timings/split_alloc_check.cpp.o.d"
+  "split_alloc_check"
+  "split_alloc_check.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/split_alloc_check.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/strided_fit_check.dir/timings/strided_fit_check.cpp.o"
+  "CMakeFiles/strided_fit_check.dir/timings/strided_fit_check.cpp.o.d"
+  "strided_fit_check"
+  "strided_fit_check.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/strided_fit_check.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
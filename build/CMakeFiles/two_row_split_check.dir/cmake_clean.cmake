@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/two_row_split_check.dir/timings/two_row_split_check.cpp.o"
+  "CMakeFiles/two_row_split_check.dir/timings/two_row_split_check.cpp.o.d"
+  "two_row_split_check"
+  "two_row_split_check.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/two_row_split_check.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,26 @@
+# CMake generated Testfile for 
+# Source directory: /root/repo
+# Build directory: /root/repo/build
+# 
+# This file includes the relevant testing commands required for 
+# testing this directory and lists subdirectories to be tested as well.
+add_test(split_alloc_check "/root/repo/build/split_alloc_check")
+set_tests_properties(split_alloc_check PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;350;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(node_task_check "/root/repo/build/node_task_check")
+set_tests_properties(node_task_check PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;354;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(full_gain_check "/root/repo/build/full_gain_check")
+set_tests_properties(full_gain_check PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;358;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(two_row_split_check "/root/repo/build/two_row_split_check")
+set_tests_properties(two_row_split_check PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;362;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(indexed_distance_check "/root/repo/build/indexed_distance_check")
+set_tests_properties(indexed_distance_check PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;366;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(strided_fit_check "/root/repo/build/strided_fit_check")
+set_tests_properties(strided_fit_check PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;370;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(cpp_generator_check "/root/repo/build/cpp_generator_check")
+set_tests_properties(cpp_generator_check PROPERTIES  ENVIRONMENT "CC=/usr/bin/cc" _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;374;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(histogram_check "/root/repo/build/histogram_check")
+set_tests_properties(histogram_check PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;379;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(csc_thread_check "/root/repo/build/csc_thread_check")
+set_tests_properties(csc_thread_check PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;383;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(engine_parity_check "/root/repo/build/engine_parity_check")
+set_tests_properties(engine_parity_check PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;387;add_test;/root/repo/CMakeLists.txt;0;")
@@ -0,0 +1,198 @@
+/*    Isolation forests and variations thereof, with adjustments for incorporation
+*     of categorical variables and missing values.
+*     Writen for C++11 standard and aimed at being used in R and Python.
+*     
+*     This library is based on the following works:
+*     [1] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation forest."
+*         2008 Eighth IEEE International Conference on Data Mining. IEEE, 2008.
+*     [2] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation-based anomaly detection."
+*         ACM Transactions on Knowledge Discovery from Data (TKDD) 6.1 (2012): 3.
+*     [3] Hariri, Sahand, Matias Carrasco Kind, and Robert J. Brunner.
+*         "Extended Isolation Forest."
+*         arXiv preprint arXiv:1811.02141 (2018).
+*     [4] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "On detecting clustered anomalies using SCiForest."
+*         Joint European Conference on Machine Learning and Knowledge Discovery in Databases. Springer, Berlin, Heidelberg, 2010.
+*     [5] https://sourceforge.net/projects/iforest/
+*     [6] https://math.stackexchange.com/questions/3388518/expected-number-of-paths-required-to-separate-elements-in-a-binary-tree
+*     [7] Quinlan, J. Ross. C4. 5: programs for machine learning. Elsevier, 2014.
+*     [8] Cortes, David.
+*         "Distance approximation using Isolation Forests."
+*         arXiv preprint arXiv:1910.12362 (2019).
+*     [9] Cortes, David.
+*         "Imputing missing values with unsupervised random trees."
+*         arXiv preprint arXiv:1911.06646 (2019).
+*     [10] https://math.stackexchange.com/questions/3333220/expected-average-depth-in-random-binary-tree-constructed-top-to-bottom
+*     [11] Cortes, David.
+*          "Revisiting randomized choices in isolation forests."
+*          arXiv preprint arXiv:2110.13402 (2021).
+*     [12] Guha, Sudipto, et al.
+*          "Robust random cut forest based anomaly detection on streams."
+*          International conference on machine learning. PMLR, 2016.
+*     [13] Cortes, David.
+*          "Isolation forests: looking beyond tree depth."
+*          arXiv preprint arXiv:2111.11639 (2021).
+*     [14] Ting, Kai Ming, Yue Zhu, and Zhi-Hua Zhou.
+*          "Isolation kernel and its effect on SVM"
+*          Proceedings of the 24th ACM SIGKDD
+*          International Conference on Knowledge Discovery & Data Mining. 2018.
+* 
+*     BSD 2-Clause License
+*     Copyright (c) 2019-2022, David Cortes
+*     All rights reserved.
+*     Redistribution and use in source and binary forms, with or without
+*     modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this
+*       list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*       this list of conditions and the following disclaimer in the documentation
+*       and/or other materials provided with the distribution.
+*     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+*     AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+*     IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*     FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*     DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*     SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*     CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*     OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*     OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* Command-line program for scoring large files with a serialized model, reading the
+   data in chunks so that memory usage stays bounded regardless of the input size.
+
+   Usage:
+     isotree_score --model <file> --ncols <n> [options]
+
+   Options:
+     --model <file>        Model serialized through 'IsolationForest::serialize' or the
+                           C interface (models serialized from R and Python are also accepted).
+     --ncols <n>           Number of numeric columns in each row of the input.
+     --input <file>        File with the data ("-" for standard input, which is the default).
+     --output <file>       File where to write the scores ("-" for standard output, the default).
+     --csv                 Input is delimited text with one row per line, instead of raw
+                           'double' values in row-major order.
+     --delimiter <char>    Delimiter for CSV inputs (default ','). Pass 'tab' for tabs.
+     --header              Skip the first line of CSV inputs.
+     --binary-output       Write scores as raw 'double' values instead of one per line.
+     --depth               Output average isolation depths instead of standardized scores.
+     --chunk-rows <n>      Number of rows to read at a time (default: around 8MB per chunk).
+     --nthreads <n>        Number of threads for scoring (default: all available). One more
+                           thread is used for reading and parsing the input.
+*/
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <iostream>
+#include <memory>
+#include "isotree_oop.hpp"
+
+static void print_usage()
+{
+    std::cerr << "Usage: isotree_score --model <file> --ncols <n> [--input <file>] [--output <file>]\n"
+                 "                     [--csv] [--delimiter <char>] [--header] [--binary-output]\n"
+                 "                     [--depth] [--chunk-rows <n>] [--nthreads <n>]\n";
+}
+
+static bool parse_size(const char *arg, size_t &out)
+{
+    char *end;
+    unsigned long long val = std::strtoull(arg, &end, 10);
+    if (end == arg || *end != '\0' || arg[0] == '-')
+        return false;
+    out = (size_t)val;
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    const char *model_file = NULL;
+    const char *input_file = "-";
+    const char *output_file = "-";
+    size_t ncols_numeric = 0;
+    size_t chunk_rows = 0;
+    size_t nthreads_arg = 0;
+    int nthreads = -1;
+    bool csv_input = false;
+    char delimiter = ',';
+    bool skip_header = false;
+    bool binary_output = false;
+    bool standardize = true;
+
+    for (int ix = 1; ix < argc; ix++)
+    {
+        std::string arg = argv[ix];
+        bool has_value = ix + 1 < argc;
+        if (arg == "--csv") csv_input = true;
+        else if (arg == "--header") skip_header = true;
+        else if (arg == "--binary-output") binary_output = true;
+        else if (arg == "--depth") standardize = false;
+        else if (arg == "--help" || arg == "-h") {
+            print_usage();
+            return EXIT_SUCCESS;
+        }
+        else if (!has_value) {
+            std::cerr << "Invalid or incomplete argument: " << arg << "\n";
+            print_usage();
+            return EXIT_FAILURE;
+        }
+        else if (arg == "--model") model_file = argv[++ix];
+        else if (arg == "--input") input_file = argv[++ix];
+        else if (arg == "--output") output_file = argv[++ix];
+        else if (arg == "--delimiter") {
+            std::string val = argv[++ix];
+            if (val == "tab" || val == "\\t") delimiter = '\t';
+            else if (val.size() == 1) delimiter = val[0];
+            else {
+                std::cerr << "Delimiter must be a single character.\n";
+                return EXIT_FAILURE;
+            }
+        }
+        else if (arg == "--ncols" || arg == "--chunk-rows" || arg == "--nthreads") {
+            size_t &dest = (arg == "--ncols")? ncols_numeric : ((arg == "--chunk-rows")? chunk_rows : nthreads_arg);
+            if (!parse_size(argv[++ix], dest)) {
+                std::cerr << "Invalid value for " << arg << ": " << argv[ix] << "\n";
+                return EXIT_FAILURE;
+            }
+            if (arg == "--nthreads") nthreads = (int)nthreads_arg;
+        }
+        else {
+            std::cerr << "Unrecognized argument: " << arg << "\n";
+            print_usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!model_file || !ncols_numeric) {
+        print_usage();
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        std::unique_ptr<FILE, int(*)(FILE*)> model_handle(std::fopen(model_file, "rb"), std::fclose);
+        if (!model_handle) {
+            std::cerr << "Could not open model file: " << model_file << "\n";
+            return EXIT_FAILURE;
+        }
+        isotree::IsolationForest iso = isotree::IsolationForest::deserialize(model_handle.get(), nthreads);
+        model_handle.reset();
+
+        size_t nrows = iso.predict_stream(input_file, output_file, ncols_numeric,
+                                          csv_input, delimiter, skip_header, binary_output,
+                                          standardize, chunk_rows);
+        std::cerr << "Scored " << nrows << " rows.\n";
+    }
+
+    catch (std::exception &e)
+    {
+        std::cerr << e.what();
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -69,6 +69,8 @@
 #include <cstdio>
 #include <string>
 #include <iostream>
+#include <memory>
+#include <functional>
 using std::size_t;
 
 /*  The library has overloaded functions supporting different input types.
@@ -112,6 +114,7 @@ typedef enum  UseDepthImp    {Lower=71,    Higher=0,       Same=72}    UseDepthI
 typedef enum  WeighImpRows   {Inverse=0,   Prop=81,        Flat=82}    WeighImpRows;   /* For NA imputation */
 typedef enum  ScoringMetric  {Depth=0,     Density=92,     BoxedDensity=94, BoxedDensity2=96, BoxedRatio=95,
                               AdjDepth=91, AdjDensity=93}              ScoringMetric;
+typedef enum  SplitSearch    {SortedSearch=0, HistogramSearch=101, PresortedSearch=102} SplitSearch;    /* For guided splits */
 
 /* Notes about new categorical action:
 *  - For single-variable case, if using 'Smallest', can then pass data at prediction time
@@ -225,6 +228,168 @@ typedef struct TreesIndexer {
     TreesIndexer() = default;
 } TreesIndexer;
 
+typedef struct CompiledIsoForest {
+    std::vector<uint32_t> col_num;
+    std::vector<uint32_t> tree_left;
+    std::vector<double>   num_split;
+    std::vector<float>    num_split_f;
+    std::vector<double>   score;
+    std::vector<size_t>   tree_offsets;
+    ScoringMetric         scoring_metric;
+    double                exp_avg_depth;
+    size_t                ncols_numeric;
+    bool                  float_thresholds;
+    CompiledIsoForest() = default;
+} CompiledIsoForest;
+
+typedef struct CompiledExtIsoForest {
+    std::vector<uint32_t> node_idx;
+    std::vector<double>   node_val;
+    std::vector<size_t>   tree_offsets;
+    ScoringMetric         scoring_metric;
+    double                exp_avg_depth;
+    size_t                ncols_numeric;
+    size_t                ndim;
+    CompiledExtIsoForest() = default;
+} CompiledExtIsoForest;
+
+typedef struct IsoForestView {
+    NewCategAction             new_cat_action;
+    CategSplit                 cat_split_type;
+    MissingAction              missing_action;
+    ScoringMetric              scoring_metric;
+    double                     exp_avg_depth;
+    double                     exp_avg_sep;
+    size_t                     orig_sample_size;
+    bool                       has_range_penalty;
+    std::vector<const char*>   trees;
+    std::vector<const char*>   nodes;
+    std::vector<size_t>        tree_first_node;
+    IsoForestView() = default;
+} IsoForestView;
+
+template <class idx_t, class val_t>
+struct FlatModelArrays {
+    const idx_t  *tree_offsets;
+    const idx_t  *tree_left;
+    const idx_t  *tree_right;
+    const val_t  *split;
+    const val_t  *score;
+    const val_t  *range_low;
+    const val_t  *range_high;
+    const val_t  *pct_tree_left;
+    const idx_t  *col_num;
+    const idx_t  *coef_offsets;
+    const idx_t  *coef_col;
+    const val_t  *coef;
+    const val_t  *mean;
+    const val_t  *fill_val;
+};
+
+typedef struct FlatModel {
+    std::shared_ptr<void>  mapped_file;
+    bool                   is_extended;
+    bool                   single_precision;
+    MissingAction          missing_action;
+    NewCategAction         new_cat_action;
+    CategSplit             cat_split_type;
+    ScoringMetric          scoring_metric;
+    bool                   has_range_penalty;
+    double                 exp_avg_depth;
+    double                 exp_avg_sep;
+    size_t                 orig_sample_size;
+    size_t                 ntrees;
+    size_t                 nnodes;
+    size_t                 ncols_numeric;
+    FlatModelArrays<uint64_t, double> arrays;
+    FlatModelArrays<uint32_t, float>  arrays_f;
+    FlatModel() = default;
+} FlatModel;
+
+typedef struct BitvectorIsoForest {
+    std::vector<double>   thresholds;
+    std::vector<uint32_t> cond_word;
+    std::vector<uint64_t> cond_mask;
+    std::vector<size_t>   col_offsets;
+    std::vector<double>   leaf_score;
+    std::vector<uint32_t> leaf_terminal;
+    std::vector<size_t>   leaf_offsets;
+    size_t                words_per_tree;
+    ScoringMetric         scoring_metric;
+    double                exp_avg_depth;
+    size_t                ncols_numeric;
+    BitvectorIsoForest() = default;
+} BitvectorIsoForest;
+
+typedef struct BinPlan {
+    std::vector<double>   thresholds;
+    std::vector<size_t>   col_offsets;
+    std::vector<uint32_t> col_num;
+    std::vector<uint32_t> tree_left;
+    std::vector<uint16_t> split_bin;
+    std::vector<double>   score;
+    std::vector<size_t>   tree_offsets;
+    ScoringMetric         scoring_metric;
+    double                exp_avg_depth;
+    size_t                ncols_numeric;
+    bool                  wide_bins;
+    BinPlan() = default;
+} BinPlan;
+
+typedef struct PredictionContext {
+    const IsoForest      *model_outputs = NULL;
+    const ExtIsoForest   *model_outputs_ext = NULL;
+    CompiledIsoForest    compiled;
+    CompiledExtIsoForest compiled_ext;
+    bool                 use_compiled = false;
+    bool                 standardize = true;
+    size_t               ntrees = 0;
+    PredictionContext() = default;
+} PredictionContext;
+
+class ISOTREE_EXPORTED Executor
+{
+public:
+    virtual ~Executor() = default;
+    virtual int num_workers() const noexcept = 0;
+    virtual void parallel_for(size_t n, const std::function<void(size_t, int)> &task) = 0;
+};
+
+class ISOTREE_EXPORTED ThreadPoolExecutor : public Executor
+{
+public:
+    explicit ThreadPoolExecutor(int nthreads);
+    ~ThreadPoolExecutor();
+    ThreadPoolExecutor(const ThreadPoolExecutor&) = delete;
+    ThreadPoolExecutor& operator=(const ThreadPoolExecutor&) = delete;
+    int num_workers() const noexcept override;
+    void parallel_for(size_t n, const std::function<void(size_t, int)> &task) override;
+private:
+    struct Pool;
+    std::unique_ptr<Pool> pool;
+};
+
+class ISOTREE_EXPORTED OpenMPExecutor : public Executor
+{
+public:
+    explicit OpenMPExecutor(int nthreads);
+    int num_workers() const noexcept override;
+    void parallel_for(size_t n, const std::function<void(size_t, int)> &task) override;
+private:
+    int nthreads;
+};
+
+class ISOTREE_EXPORTED ScopedExecutor
+{
+public:
+    explicit ScopedExecutor(Executor *executor) noexcept;
+    ~ScopedExecutor();
+    ScopedExecutor(const ScopedExecutor&) = delete;
+    ScopedExecutor& operator=(const ScopedExecutor&) = delete;
+private:
+    Executor *previous;
+};
+
 #endif /* ISOTREE_H */
 
 /*  Fit Isolation Forest model, or variant of it such as SCiForest
@@ -761,6 +926,98 @@ int fit_iforest(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
                 UseDepthImp depth_imp, WeighImpRows weigh_imp_rows, bool impute_at_fit,
                 uint64_t random_seed, bool use_long_double, int nthreads);
 
+/* Same as above, but the dense data can be passed in row-major order and/or with a leading
+   dimension that does not match its number of rows or columns, such as a view over a subset
+   of the columns of a larger array, without having to copy it beforehand.
+* 
+* Parameters:
+* ===========
+* - is_col_major
+*       Whether 'numeric_data' and 'categ_data' are in column-major order. If passing both, they
+*       must have the same orientation. If numeric data is passed in sparse format, categorical
+*       data must be passed in column-major order.
+* - ld_numeric
+*       Leading dimension of the array 'numeric_data'. If it is in row-major order, row 'n' is
+*       assumed to start at 'numeric_data + n*ld_numeric', and if it is in column-major order,
+*       column 'n' is assumed to start at 'numeric_data + n*ld_numeric'. Passing zero will take
+*       it as the number of columns (row-major) or of rows (column-major).
+* - ld_categ
+*       Leading dimension of the array 'categ_data', in the same format as 'ld_numeric'.
+* - split_search
+*       How to find the split thresholds when splits are decided by a gain criterion ('prob_pick_by_gain_avg',
+*       'prob_pick_by_gain_pl', 'prob_pick_by_dens'). Options are:
+*       a) 'SortedSearch', which sorts the values of a column at each node and evaluates the thresholds between
+*       each pair of consecutive values. This is what the function above does.
+*       b) 'HistogramSearch', which assigns the values of each numeric column to at most 255 bins (plus one for
+*       missing values) before fitting the trees, by quantiles of the data. The nodes then build a histogram of
+*       their rows for each column that they evaluate, and only the thresholds between bins are considered. A node
+*       can also obtain its histogram from those of its parent and of its sibling, by building the one with the fewest
+*       rows and subtracting it from the parent's. The gains are calculated in the same way, but the split thresholds
+*       are coarser, so the resulting trees will not be the same. This is much faster when the nodes have many rows.
+*       Only dense numeric columns in the single-variable model are split this way - sparse and categorical columns,
+*       hyperplanes in the extended model, 'prob_pick_by_full_gain', and nodes with few rows, still use sorted search.
+*       c) 'PresortedSearch', which finds the same splits as 'SortedSearch', but instead of sorting at each node,
+*       sorts the indices of the rows by each numeric column once per tree (or only once for the whole model and
+*       shared by all threads when each tree is fit to all of the rows without replacement), and then keeps the
+*       indices of each node sorted by partitioning them along with the rows when the node is split. This requires
+*       memory for one index per row and numeric column in each thread, and splitting a node then takes time
+*       proportional to its number of rows times the number of numeric columns, so it is typically faster with few
+*       columns and large sample sizes. After a node in which rows with missing values go to both branches
+*       ('missing_action=Divide'), its sub-trees go back to sorting at each node. As with 'HistogramSearch', this
+*       only applies to dense numeric columns in the single-variable model.
+* - node_task_rows
+*       If passing a number greater than zero, the nodes of a tree that have more rows than this are split
+*       on their own, with their left and right branches then grown as separate tasks that can run in
+*       different threads, so that the threads are not left idle when there are fewer trees than threads
+*       (e.g. when fitting a handful of deep trees to all of the rows for distances or imputations). In this
+*       case, the trees and the order of their nodes are the same regardless of the number of threads and of
+*       the value passed here (including zero), as nodes with more than 8192 rows always draw a seed for each
+*       of their branches, from which these start. Smaller numbers are taken as 8192, and when the sample
+*       size is not larger than that, each tree is grown in a single thread. The buffers for distances, depths,
+*       and imputations at fit time are allocated for every thread instead of for every tree, so memory usage
+*       increases when there are more threads than trees, and with data that is not in contiguous column-major
+*       order, the copy of the rows of each tree is kept until all of its tasks are done.
+*       Pass zero to grow each tree in a single thread as the function above does.
+* - reorder_nodes_after_fit
+*       Whether to re-arrange the nodes of each tree after fitting, for faster predictions (see
+*       'reorder_nodes' for details). The imputer passed here, if any, is re-arranged along with
+*       the model. Outputs calculated at fit time ('tmat', 'output_depths', 'impute_at_fit') are
+*       not affected by it.
+* 
+* All other parameters are the same as in the function above. Data that is not in contiguous
+* column-major order is not copied as a whole: each tree is fit to a column-major copy of the
+* rows that it takes (all of them when not using sub-sampling), held in the memory of the
+* thread that fits it and reused for its next tree, so there are as many of these copies as
+* there are threads (see 'node_task_rows' for an exception). Passes over the full data done
+* before fitting the trees (e.g. variable ranges or imputations at fit time) read it in place.
+* Categorical data is however copied once when the numeric data is passed in sparse format.
+*/
+ISOTREE_EXPORTED
+int fit_iforest(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
+                real_t numeric_data[],  size_t ncols_numeric,
+                int    categ_data[],    size_t ncols_categ,    int ncat[],
+                bool is_col_major, size_t ld_numeric, size_t ld_categ,
+                real_t Xc[], sparse_ix Xc_ind[], sparse_ix Xc_indptr[],
+                size_t ndim, size_t ntry, CoefType coef_type, bool coef_by_prop,
+                real_t sample_weights[], bool with_replacement, bool weight_as_sample,
+                size_t nrows, size_t sample_size, size_t ntrees,
+                size_t max_depth,   size_t ncols_per_tree,
+                bool   limit_depth, bool penalize_range, bool standardize_data,
+                ScoringMetric scoring_metric, bool fast_bratio,
+                bool   standardize_dist, double tmat[],
+                double output_depths[], bool standardize_depth,
+                real_t col_weights[], bool weigh_by_kurt,
+                double prob_pick_by_gain_pl, double prob_pick_by_gain_avg,
+                double prob_pick_by_full_gain, double prob_pick_by_dens,
+                double prob_pick_col_by_range, double prob_pick_col_by_var,
+                double prob_pick_col_by_kurt,
+                double min_gain, SplitSearch split_search, MissingAction missing_action,
+                CategSplit cat_split_type, NewCategAction new_cat_action,
+                bool   all_perm, Imputer *imputer, size_t min_imp_obs,
+                UseDepthImp depth_imp, WeighImpRows weigh_imp_rows, bool impute_at_fit,
+                uint64_t random_seed, bool use_long_double, size_t node_task_rows,
+                bool reorder_nodes_after_fit, int nthreads);
+
 
 
 /* Add additional trees to already-fitted isolation forest model
@@ -1538,6 +1795,591 @@ void build_tree_indices
     int nthreads,
     const bool with_distances
 );
+/* Re-arrange the nodes of each tree for a more cache-friendly memory layout
+* 
+* Trees are built depth-first, which leaves the right branch of each node far away from it in
+* memory. This re-arranges the nodes into blocks of connected nodes, each of which is a sub-tree
+* laid out breadth-first, which makes predictions faster. It can be applied to both freshly-fitted
+* models and de-serialized ones.
+* 
+* Parameters
+* ==========
+* - model / model_outputs / model_outputs_ext (in, out)
+*       Fitted model object whose nodes will be re-arranged. Predictions from the model will not
+*       change, but the terminal node numbers from predictions will be different afterwards.
+* - imputer (in, out)
+*       Imputation object associated to the model, which will be re-arranged along with it.
+*       Pass NULL if the model was built without an imputer.
+* - indexer (in, out)
+*       Indexer object associated to the model, which will be re-arranged along with it.
+*       Pass NULL if the model was built without an indexer.
+* - nthreads
+*       Number of parallel threads to use.
+*/
+ISOTREE_EXPORTED
+void reorder_nodes(IsoForest &model, Imputer *imputer, TreesIndexer *indexer, int nthreads);
+ISOTREE_EXPORTED
+void reorder_nodes(ExtIsoForest &model, Imputer *imputer, TreesIndexer *indexer, int nthreads);
+ISOTREE_EXPORTED
+void reorder_nodes(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
+                   Imputer *imputer, TreesIndexer *indexer, int nthreads);
+
+/* Build a flattened version of a single-variable model, which can make predictions faster
+* 
+* Parameters
+* ==========
+* - compiled (out)
+*       Object where the flattened model will be stored. Any previous contents will be overwritten.
+* - model
+*       Single-variable isolation forest model which has already been fit through 'fit_iforest'.
+*       Must have been fit to numeric-only data, with 'missing_action=Fail' and without range penalty.
+* - float_thresholds
+*       Whether to store the split thresholds as 'float' instead of 'double', which reduces the
+*       memory usage. Thresholds are rounded down, so that predictions on 'float' data are exactly
+*       the same as when using 'double' thresholds, but predictions on 'double' data might differ
+*       when values fall very close to a split threshold.
+* - nthreads
+*       Number of parallel threads to use.
+*/
+ISOTREE_EXPORTED
+void build_compiled_forest(CompiledIsoForest &compiled, const IsoForest &model, bool float_thresholds, int nthreads);
+
+/* Build a flattened version of an extended model, which can make predictions faster
+* 
+* Parameters
+* ==========
+* - compiled (out)
+*       Object where the flattened model will be stored. Any previous contents will be overwritten.
+* - model
+*       Extended isolation forest model which has already been fit through 'fit_iforest'.
+*       Must have been fit to numeric-only data, with 'missing_action=Fail' and without range penalty.
+*       Predictions from the flattened model are exactly the same as from the original model.
+* - nthreads
+*       Number of parallel threads to use.
+*/
+ISOTREE_EXPORTED
+void build_compiled_forest(CompiledExtIsoForest &compiled, const ExtIsoForest &model, int nthreads);
+
+/* Predict outlier scores using a flattened single-variable model
+* 
+* Parameters
+* ==========
+* - numeric_data[nrows * ncols_numeric]
+*       Pointer to numeric data for which to make predictions. Must be ordered by columns like Fortran,
+*       not ordered by rows like C (i.e. entries 1..n contain column 0, n+1..2n column 1, etc.),
+*       unless passing 'is_col_major=false'. Cannot contain missing values.
+* - is_col_major
+*       Whether 'numeric_data' comes in column-major order. If passing 'false', data must
+*       come in row-major order.
+* - ld_numeric
+*       Leading dimension of the array 'numeric_data', if it is passed in row-major format.
+*       Ignored when passing the data in column-major order.
+* - nrows
+*       Number of rows in 'numeric_data'.
+* - nthreads
+*       Number of parallel threads to use.
+* - standardize
+*       Whether to standardize the average depths for each row according to their relative magnitude
+*       compared to the expected average, in order to obtain an outlier score. If passing 'false',
+*       will output the average depth instead.
+* - compiled
+*       Flattened model object, as produced by 'build_compiled_forest'.
+* - output_depths[nrows] (out)
+*       Pointer to array where the output average depths or outlier scores will be written into.
+* - tree_num[nrows * ntrees] (out)
+*       Pointer to array where the output terminal node numbers will be written into, in the
+*       same format as 'predict_iforest' (column-major order, numbered from zero).
+*       Pass NULL if this type of output is not needed. Note that when this is not requested, predictions
+*       can use vectorized kernels (AVX2 or AVX512, when the CPU supports them) if 'numeric_data' is
+*       of the same type as the split thresholds ('double' or 'float' if built with 'float_thresholds').
+* - per_tree_depths[nrows * ntrees] (out)
+*       Pointer to array where to output per-tree depths for each row, in row-major order.
+*       Pass NULL if this type of output is not needed.
+*/
+ISOTREE_EXPORTED
+void predict_iforest_compiled(real_t numeric_data[], bool is_col_major, size_t ld_numeric,
+                              size_t nrows, int nthreads, bool standardize,
+                              const CompiledIsoForest &compiled,
+                              double output_depths[], sparse_ix tree_num[],
+                              double per_tree_depths[]);
+
+/* Predict outlier scores using a flattened extended model
+* 
+* Same as above, but taking an object produced by 'build_compiled_forest' from an extended model.
+* There are no vectorized kernels for this type of model, thus 'tree_num' does not make a difference
+* in the speed of predictions.
+*/
+ISOTREE_EXPORTED
+void predict_iforest_compiled(real_t numeric_data[], bool is_col_major, size_t ld_numeric,
+                              size_t nrows, int nthreads, bool standardize,
+                              const CompiledExtIsoForest &compiled,
+                              double output_depths[], sparse_ix tree_num[],
+                              double per_tree_depths[]);
+
+/* Decide whether outlier scores exceed a threshold, evaluating only as many trees as needed
+* 
+* Parameters
+* ==========
+* - numeric_data[nrows * ncols_numeric]
+*       Pointer to numeric data for which to make predictions. Must be ordered by columns like Fortran,
+*       not ordered by rows like C (i.e. entries 1..n contain column 0, n+1..2n column 1, etc.),
+*       unless passing 'is_col_major=false'. Cannot contain missing values.
+* - is_col_major
+*       Whether 'numeric_data' comes in column-major order. If passing 'false', data must
+*       come in row-major order.
+* - ld_numeric
+*       Leading dimension of the array 'numeric_data', if it is passed in row-major format.
+*       Ignored when passing the data in column-major order.
+* - nrows
+*       Number of rows in 'numeric_data'.
+* - nthreads
+*       Number of parallel threads to use.
+* - compiled
+*       Flattened model object, as produced by 'build_compiled_forest'.
+* - threshold
+*       Threshold for the standardized outlier score (as output by 'predict_iforest' with
+*       'standardize=true') above which a row is considered an outlier.
+* - confidence
+*       Probability with which the decision for each row should match the decision that would be
+*       made from the scores calculated with all the trees. Must be in the interval (0,1] - passing 1
+*       will evaluate all the trees for every row.
+*       Trees are evaluated in the order in which they are stored in the model, and after each tree,
+*       the average of the per-tree depths seen so far is bounded using both a Hoeffding-Serfling
+*       inequality (sampling without replacement from the trees of the model) based on the range of
+*       the depths of all terminal nodes, and an empirical Bernstein inequality based on the variance
+*       of the depths seen so far. Since the trees are fit independently of each other, the ones that
+*       come first in the model are as good as a random sample of them. Evaluation stops once the
+*       bounds on the score are both on the same side of the threshold. The failure probability is
+*       split evenly among both inequalities and all the points at which evaluation could have stopped.
+* - output_decisions[nrows] (out)
+*       Pointer to array where the decisions will be written into, with 1 for rows whose score is
+*       above the threshold and 0 for the rest.
+* - trees_used[nrows] (out)
+*       Pointer to array where the number of trees that were evaluated for each row will be written into.
+*       Pass NULL if this type of output is not needed.
+*/
+ISOTREE_EXPORTED
+void predict_iforest_decision(real_t numeric_data[], bool is_col_major, size_t ld_numeric,
+                              size_t nrows, int nthreads,
+                              const CompiledIsoForest &compiled,
+                              double threshold, double confidence,
+                              int output_decisions[], size_t trees_used[]);
+
+/* Get the executor that was set for the calling thread, if any
+* 
+* By default, functions that take an argument 'nthreads' run their parallel loops in OpenMP
+* thread teams. An application that manages its own threads can instead set an 'Executor'
+* for the calling thread by creating an object of class 'ScopedExecutor', which stays in effect
+* until the object is destroyed. While it is set, every parallel loop in the library (fitting,
+* predictions through any of the model representations, distances, imputations, indexers and
+* reference points, node reordering, and the exporters to other formats) is submitted to the
+* executor through 'Executor::parallel_for', using 'Executor::num_workers' in place of 'nthreads'.
+* 
+* The library provides 'ThreadPoolExecutor', which keeps a persistent pool of threads with
+* work-stealing (reusable across calls, thus avoiding the creation of new thread teams), and
+* 'OpenMPExecutor', which reproduces the default behavior. Results do not depend on which
+* executor is used nor on the number of workers. A 'ThreadPoolExecutor' runs one loop at a time:
+* if it is shared by different threads, loops submitted while another one is running wait until it
+* finishes, while loops submitted from inside one of its own tasks run in the thread that submits them.
+* 
+* Returns:
+* ========
+* Pointer to the executor for the calling thread, or NULL if none was set.
+*/
+ISOTREE_EXPORTED
+Executor* get_thread_executor() noexcept;
+
+/* Prepare a context for scoring single rows with low latency
+* 
+* Parameters
+* ==========
+* - context (out)
+*       Object where the context will be stored. Any previous contents will be overwritten.
+* - model_outputs
+*       Pointer to fitted single-variable model object from function 'fit_iforest'. Pass NULL
+*       if the predictions are to be made from an extended model. Can only pass one of
+*       'model_outputs' and 'model_outputs_ext'.
+* - model_outputs_ext
+*       Pointer to fitted extended model object from function 'fit_iforest'. Pass NULL
+*       if the predictions are to be made from a single-variable model. Can only pass one of
+*       'model_outputs' and 'model_outputs_ext'.
+* - standardize
+*       Whether the scores produced with this context should be standardized, as when passing
+*       'standardize=true' to 'predict_iforest'. If passing 'false', will produce the average
+*       isolation depth instead.
+* 
+* Note that the context keeps pointers to the model objects, which must therefore outlive it and
+* must not be modified while it is in use. If the model is modified afterwards (e.g. by adding trees
+* or re-arranging its nodes), the context must be built again.
+*/
+ISOTREE_EXPORTED
+void build_prediction_context(PredictionContext &context,
+                              const IsoForest *model_outputs, const ExtIsoForest *model_outputs_ext,
+                              bool standardize);
+
+/* Calculate the outlier score for a single row, using a context from 'build_prediction_context'
+* 
+* Parameters
+* ==========
+* - context
+*       Prediction context, as produced by 'build_prediction_context'.
+* - numeric_row[ncols_numeric]
+*       Pointer to the numeric columns of the row for which to make a prediction, in the same order
+*       as the data to which the model was fit. Missing values are handled as in 'predict_iforest'.
+*       Pass NULL if the model was fit to categorical data only.
+* - categ_row[ncols_categ]
+*       Pointer to the categorical columns of the row, encoded in the same way as for 'predict_iforest'.
+*       Pass NULL if the model was fit to numeric data only.
+* 
+* Returns
+* =======
+* The outlier score for the row, which is the same as what 'predict_iforest' would output for it
+* (standardized or not, according to how the context was built). This function does not allocate
+* any memory nor use multi-threading, so it can be called concurrently from different threads with
+* the same context.
+*/
+ISOTREE_EXPORTED
+double predict_iforest_row(const PredictionContext &context,
+                           const real_t numeric_row[], const int categ_row[]);
+
+/* Create a read-only view over a serialized single-variable model, which can be used for
+*  making predictions without de-serializing the model
+* 
+* Parameters
+* ==========
+* - view (out)
+*       Object where the view will be stored. Any previous contents will be overwritten.
+*       The view holds pointers into 'in', which must be kept alive (and unmodified) for as long
+*       as the view is in use. Creating it does not copy the nodes - it only stores a pointer to
+*       where each tree starts, plus a pointer to each node if the model has categorical subset splits.
+* - in
+*       Bytes of a model serialized through 'serialize_IsoForest' (the separate-object format,
+*       not the combined one), in a machine with the same endianness and the same sizes for
+*       'int' and 'size_t' as the current one.
+*/
+ISOTREE_EXPORTED
+void build_IsoForestView(IsoForestView &view, const char *in);
+
+/* Predict outlier scores or average depths using a view over a serialized single-variable model
+* 
+* Takes the same data arguments as 'predict_iforest', and produces the same results, but
+* reads the nodes directly from the serialized bytes and does not allocate any memory.
+* Terminal node numbers are not available for this function. Note that 'predict_iforest' has
+* faster routes for some types of inputs (e.g. numeric-only data with 'missing_action=Fail'),
+* so this is mostly advantageous when scoring a small number of rows with a model that would
+* otherwise need to be de-serialized first.
+* 
+* Parameters
+* ==========
+* - view
+*       View over a serialized model, as produced by 'build_IsoForestView'.
+* - per_tree_depths[nrows * ntrees] (out)
+*       Pointer to array where to output per-tree depths for each row, in row-major order.
+*       Pass NULL if this type of output is not needed.
+* - (rest)
+*       Same as for 'predict_iforest'.
+*/
+ISOTREE_EXPORTED
+void predict_iforest_view(real_t numeric_data[], int categ_data[],
+                          bool is_col_major, size_t ld_numeric, size_t ld_categ,
+                          real_t Xc[], sparse_ix Xc_ind[], sparse_ix Xc_indptr[],
+                          real_t Xr[], sparse_ix Xr_ind[], sparse_ix Xr_indptr[],
+                          size_t nrows, int nthreads, bool standardize,
+                          const IsoForestView &view,
+                          double output_depths[], double per_tree_depths[]);
+
+/* Serialize a model into the flat format, which can be memory-mapped for predictions
+* 
+* The flat format stores the nodes of all the trees as arrays aligned to 64 bytes, which
+* are used in place when loading it - thus, loading takes constant time regardless of the
+* model size, and several processes mapping the same file will share the same memory.
+* Only models fit to numeric-only data are supported. Files in this format can only be
+* loaded in machines with the same endianness as the one that produced them.
+* 
+* Parameters
+* ==========
+* - model
+*       Single-variable isolation forest model, or NULL if passing 'model_ext'.
+* - model_ext
+*       Extended isolation forest model, or NULL if passing 'model'.
+* - single_precision
+*       Whether to store the model with 32-bit indices and 'float' values (split thresholds,
+*       scores, coefficients, etc.) instead of 64-bit indices and 'double' values, which halves
+*       the size of the model. This introduces small differences in the predictions, which can be
+*       measured through 'get_flat_model_max_deviation'. For single-variable models, thresholds
+*       are rounded in such a way that 'float' inputs go through the same branches as with the
+*       original model, so the only differences for those come from rounding the scores.
+* - out (out)
+*       Array where to write the serialized model, which must have at least as many bytes
+*       as indicated by 'determine_flat_model_size'.
+* - fname
+*       File name where to save the model. Will be overwritten if it already exists.
+*/
+ISOTREE_EXPORTED
+size_t determine_flat_model_size(const IsoForest *model, const ExtIsoForest *model_ext, bool single_precision);
+ISOTREE_EXPORTED
+void serialize_flat_model(const IsoForest *model, const ExtIsoForest *model_ext, bool single_precision, char *out);
+ISOTREE_EXPORTED
+void serialize_flat_model_ToFile(const IsoForest *model, const ExtIsoForest *model_ext, bool single_precision,
+                                 const char *fname);
+
+/* Load a model in flat format, without copying its data
+* 
+* Parameters
+* ==========
+* - model (out)
+*       Object where the model will be loaded. Any previous contents will be overwritten.
+*       Its arrays point into the bytes from which it was loaded.
+* - in
+*       Bytes produced by 'serialize_flat_model', aligned to at least 8 bytes. These must be
+*       kept alive for as long as 'model' is in use.
+* - n_bytes
+*       Number of bytes in 'in'.
+* - fname
+*       File produced by 'serialize_flat_model_ToFile'. The file will be memory-mapped
+*       read-only, and the mapping will be released once 'model' and all of its copies
+*       are destroyed. The file should not be modified while it is mapped.
+*/
+ISOTREE_EXPORTED
+void load_flat_model(FlatModel &model, const char *in, size_t n_bytes);
+ISOTREE_EXPORTED
+void load_flat_model_FromFile(FlatModel &model, const char *fname);
+
+/* Predict outlier scores using a model in flat format
+* 
+* Parameters
+* ==========
+* - numeric_data[nrows * ncols_numeric]
+*       Pointer to numeric data for which to make predictions. Must be ordered by columns like Fortran,
+*       not ordered by rows like C (i.e. entries 1..n contain column 0, n+1..2n column 1, etc.),
+*       unless passing 'is_col_major=false'.
+* - is_col_major
+*       Whether 'numeric_data' comes in column-major order. If passing 'false', data must
+*       come in row-major order.
+* - ld_numeric
+*       Leading dimension of the array 'numeric_data', if it is passed in row-major format.
+*       Ignored when passing the data in column-major order.
+* - nrows
+*       Number of rows in 'numeric_data'.
+* - nthreads
+*       Number of parallel threads to use.
+* - standardize
+*       Whether to standardize the average depths for each row according to their relative magnitude
+*       compared to the expected average, in order to obtain an outlier score. If passing 'false',
+*       will output the average depth instead.
+* - model
+*       Model in flat format, as produced by 'load_flat_model' or 'load_flat_model_FromFile'.
+* - output_depths[nrows] (out)
+*       Pointer to array where the output average depths or outlier scores will be written into.
+* - tree_num[nrows * ntrees] (out)
+*       Pointer to array where the output terminal node numbers will be written into, in the
+*       same format as 'predict_iforest' (column-major order, numbered from zero).
+*       Pass NULL if this type of output is not needed.
+* - per_tree_depths[nrows * ntrees] (out)
+*       Pointer to array where to output per-tree depths for each row, in row-major order.
+*       Pass NULL if this type of output is not needed.
+*/
+ISOTREE_EXPORTED
+void predict_flat_model(real_t numeric_data[], bool is_col_major, size_t ld_numeric,
+                        size_t nrows, int nthreads, bool standardize,
+                        const FlatModel &model,
+                        double output_depths[], sparse_ix tree_num[],
+                        double per_tree_depths[]);
+
+/* Compute the largest absolute difference between the predictions from a model in flat format
+   and the predictions from the model out of which it was produced, for a given set of rows
+* 
+* This is meant for assessing the effect of saving a model in single precision, which changes
+* the scores of terminal nodes and the coefficients of extended models. For single-variable
+* models, thresholds are rounded such that 'float' inputs take the same branches as with the
+* original model, so differences will only come from the scores.
+* 
+* Parameters
+* ==========
+* - numeric_data[nrows * ncols_numeric]
+*       Pointer to numeric data, in the same format as for 'predict_flat_model'.
+* - is_col_major
+*       Whether 'numeric_data' comes in column-major order.
+* - ld_numeric
+*       Leading dimension of the array 'numeric_data', if it is passed in row-major format.
+* - nrows
+*       Number of rows in 'numeric_data'.
+* - nthreads
+*       Number of parallel threads to use.
+* - standardize
+*       Whether to compare standardized outlier scores (if passing 'true') or average depths.
+* - model_outputs
+*       Single-variable model from which 'flat_model' was produced, or NULL if it comes from
+*       an extended model.
+* - model_outputs_ext
+*       Extended model from which 'flat_model' was produced, or NULL if it comes from
+*       a single-variable model.
+* - flat_model
+*       Model in flat format.
+* 
+* Returns
+* =======
+* Maximum absolute difference in the outputs across the rows. If a row has a missing output
+* in one model but not in the other, will return infinity.
+*/
+ISOTREE_EXPORTED
+double get_flat_model_max_deviation(real_t numeric_data[], bool is_col_major, size_t ld_numeric,
+                                    size_t nrows, int nthreads, bool standardize,
+                                    IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
+                                    const FlatModel &flat_model);
+
+/* Build a version of a single-variable model which makes predictions on data converted to bins
+* 
+* Parameters
+* ==========
+* - plan (out)
+*       Object where the binned model will be stored. Any previous contents will be overwritten.
+* - model
+*       Single-variable isolation forest model which has already been fit through 'fit_iforest'.
+*       Must have been fit to numeric-only data, with 'missing_action=Fail' and without range penalty,
+*       and no column can have more than 65535 distinct split thresholds across all the trees.
+*       Data to predict on is converted to bin indices through 'bin_numeric_data', and predictions
+*       are then made with 'predict_iforest_binned'. The conversion needs a binary search per value,
+*       so this is most advantageous when the same rows are scored more than once (e.g. against
+*       several models built on the same plan, or when the binned rows are kept for later use),
+*       or when the data is already stored as bin indices.
+* - nthreads
+*       Number of parallel threads to use.
+*/
+ISOTREE_EXPORTED
+void build_bin_plan(BinPlan &plan, const IsoForest &model, int nthreads);
+
+/* Convert numeric data to the bin indices used by a binned model
+* 
+* Parameters
+* ==========
+* - numeric_data[nrows * ncols_numeric]
+*       Pointer to numeric data to convert. Must be ordered by columns like Fortran,
+*       not ordered by rows like C (i.e. entries 1..n contain column 0, n+1..2n column 1, etc.),
+*       unless passing 'is_col_major=false'. Missing values are assigned to the last bin
+*       of their column, which leads to the same results as 'predict_iforest' would give.
+* - is_col_major
+*       Whether 'numeric_data' comes in column-major order. If passing 'false', data must
+*       come in row-major order.
+* - ld_numeric
+*       Leading dimension of the array 'numeric_data', if it is passed in row-major format.
+*       Ignored when passing the data in column-major order.
+* - nrows
+*       Number of rows in 'numeric_data'.
+* - nthreads
+*       Number of parallel threads to use.
+* - plan
+*       Binned model object, as produced by 'build_bin_plan'. Only the first 'plan.ncols_numeric'
+*       columns of the data are converted.
+* - binned_data[nrows * plan.ncols_numeric] (out)
+*       Pointer to array where the bin indices will be written into, in row-major order.
+*       Must be of type 'uint16_t' if 'plan.wide_bins' is 'true', and can be of either
+*       'uint8_t' or 'uint16_t' otherwise.
+*/
+ISOTREE_EXPORTED
+void bin_numeric_data(real_t numeric_data[], bool is_col_major, size_t ld_numeric,
+                      size_t nrows, int nthreads,
+                      const BinPlan &plan, uint8_t binned_data[]);
+ISOTREE_EXPORTED
+void bin_numeric_data(real_t numeric_data[], bool is_col_major, size_t ld_numeric,
+                      size_t nrows, int nthreads,
+                      const BinPlan &plan, uint16_t binned_data[]);
+
+/* Predict outlier scores using a binned model on data that has been converted to bin indices
+* 
+* Parameters
+* ==========
+* - binned_data[nrows * plan.ncols_numeric]
+*       Pointer to bin indices for which to make predictions, in row-major order, as produced
+*       by 'bin_numeric_data'.
+* - nrows
+*       Number of rows in 'binned_data'.
+* - nthreads
+*       Number of parallel threads to use.
+* - standardize
+*       Whether to standardize the average depths for each row according to their relative magnitude
+*       compared to the expected average, in order to obtain an outlier score. If passing 'false',
+*       will output the average depth instead.
+* - plan
+*       Binned model object, as produced by 'build_bin_plan'.
+* - output_depths[nrows] (out)
+*       Pointer to array where the output average depths or outlier scores will be written into.
+* - tree_num[nrows * ntrees] (out)
+*       Pointer to array where the output terminal node numbers will be written into, in the
+*       same format as 'predict_iforest' (column-major order, numbered from zero).
+*       Pass NULL if this type of output is not needed.
+* - per_tree_depths[nrows * ntrees] (out)
+*       Pointer to array where to output per-tree depths for each row, in row-major order.
+*       Pass NULL if this type of output is not needed.
+*/
+ISOTREE_EXPORTED
+void predict_iforest_binned(const uint8_t binned_data[], size_t nrows, int nthreads, bool standardize,
+                            const BinPlan &plan,
+                            double output_depths[], sparse_ix tree_num[],
+                            double per_tree_depths[]);
+ISOTREE_EXPORTED
+void predict_iforest_binned(const uint16_t binned_data[], size_t nrows, int nthreads, bool standardize,
+                            const BinPlan &plan,
+                            double output_depths[], sparse_ix tree_num[],
+                            double per_tree_depths[]);
+
+/* Build a version of a single-variable model which evaluates the trees feature-by-feature
+* 
+* Parameters
+* ==========
+* - bv_forest (out)
+*       Object where the rearranged model will be stored. Any previous contents will be overwritten.
+* - model
+*       Single-variable isolation forest model which has already been fit through 'fit_iforest'.
+*       Must have been fit to numeric-only data, with 'missing_action=Fail' and without range penalty.
+*       This type of evaluation is most advantageous for shallow trees (e.g. the default of limiting
+*       the depth to log2(sample_size)) with many trees and columns, as it replaces the unpredictable
+*       branching of node traversal with sequential scans over the sorted thresholds.
+*/
+ISOTREE_EXPORTED
+void build_bitvector_forest(BitvectorIsoForest &bv_forest, const IsoForest &model);
+
+/* Predict outlier scores using a single-variable model arranged for feature-by-feature evaluation
+* 
+* Parameters
+* ==========
+* - numeric_data[nrows * ncols_numeric]
+*       Pointer to numeric data for which to make predictions. Must be ordered by columns like Fortran,
+*       not ordered by rows like C (i.e. entries 1..n contain column 0, n+1..2n column 1, etc.),
+*       unless passing 'is_col_major=false'. Cannot contain missing values.
+* - is_col_major
+*       Whether 'numeric_data' comes in column-major order. If passing 'false', data must
+*       come in row-major order.
+* - ld_numeric
+*       Leading dimension of the array 'numeric_data', if it is passed in row-major format.
+*       Ignored when passing the data in column-major order.
+* - nrows
+*       Number of rows in 'numeric_data'.
+* - nthreads
+*       Number of parallel threads to use.
+* - standardize
+*       Whether to standardize the average depths for each row according to their relative magnitude
+*       compared to the expected average, in order to obtain an outlier score. If passing 'false',
+*       will output the average depth instead.
+* - bv_forest
+*       Rearranged model object, as produced by 'build_bitvector_forest'.
+* - output_depths[nrows] (out)
+*       Pointer to array where the output average depths or outlier scores will be written into.
+* - tree_num[nrows * ntrees] (out)
+*       Pointer to array where the output terminal node numbers will be written into, in the
+*       same format as 'predict_iforest' (column-major order, numbered from zero).
+*       Pass NULL if this type of output is not needed.
+* - per_tree_depths[nrows * ntrees] (out)
+*       Pointer to array where to output per-tree depths for each row, in row-major order.
+*       Pass NULL if this type of output is not needed.
+*/
+ISOTREE_EXPORTED
+void predict_iforest_bitvector(real_t numeric_data[], bool is_col_major, size_t ld_numeric,
+                               size_t nrows, int nthreads, bool standardize,
+                               const BitvectorIsoForest &bv_forest,
+                               double output_depths[], sparse_ix tree_num[],
+                               double per_tree_depths[]);
+
 /* Gets the number of reference points stored in an indexer object */
 ISOTREE_EXPORTED
 size_t get_number_of_reference_points(const TreesIndexer &indexer) noexcept;
@@ -2121,6 +2963,46 @@ std::vector<std::string> generate_sql(const IsoForest *model_outputs, const ExtI
                                       int nthreads);
 
 
+/* Generate the source code of a C/C++ function which calculates outlier scores from a model
+* 
+* Parameters
+* ==========
+* - model_outputs
+*       Pointer to fitted single-variable model object from function 'fit_iforest'. Pass NULL
+*       if the predictions are to be made from an extended model. Can only pass one of
+*       'model_outputs' and 'model_outputs_ext'.
+* - model_outputs_ext
+*       Pointer to fitted extended model object from function 'fit_iforest'. Pass NULL
+*       if the predictions are to be made from a single-variable model. Can only pass one of
+*       'model_outputs' and 'model_outputs_ext'.
+* - function_name
+*       Name to give to the generated function. Must be a valid C identifier. The helper
+*       functions for each tree are declared 'static' and use this name as prefix.
+* - standardize
+*       Whether the generated function should output standardized outlier scores, as 'predict_iforest'
+*       does when passing 'standardize=true'. If passing 'false', will output the average depth instead.
+* - nthreads
+*       Number of parallel threads to use. Ignored when not building with OpenMP support.
+* 
+* Returns
+* =======
+* A string with a self-contained translation unit (valid as both C and C++) which defines the
+* following function, with C linkage:
+*     double <function_name>(const double *numeric_row, const int *categ_row)
+* Where 'numeric_row' contains the numeric columns of a single observation, in the same order as the
+* data to which the model was fit, and 'categ_row' contains its categorical columns, encoded in the same
+* way as for 'predict_iforest' (can be NULL if the model does not have categorical columns). Each tree is
+* unrolled into nested 'if' statements with the thresholds as literal constants, so that the model does
+* not need to be loaded at runtime. Outputs will be exactly the same as those from 'predict_iforest' if the
+* generated code is compiled without optimizations that change floating point results (e.g. 'fast-math'
+* or, for extended models, contraction of multiplications and additions into FMA instructions, which
+* can be disabled with '-ffp-contract=off'). Note that if the model was fitted with 'missing_action=Fail',
+* the generated code will not check for missing values in the inputs.
+*/
+ISOTREE_EXPORTED
+std::string generate_cpp(const IsoForest *model_outputs, const ExtIsoForest *model_outputs_ext,
+                         const std::string &function_name, bool standardize, int nthreads);
+
 /* Generate a GraphViz 'dot' representation of model trees, as a 'digraph' structure
 * 
 * Parameters
@@ -2216,3 +3098,67 @@ std::vector<std::string> generate_json(const IsoForest *model_outputs,
                                        const std::vector<std::vector<std::string>> &categ_levels,
                                        bool output_tree_num, bool index1, bool single_tree, size_t tree_num,
                                        int nthreads);
+
+/* Predict outlier scores for rows read from a stream, writing them to another stream
+* 
+* Parameters
+* ==========
+* - input
+*       Stream from which to read the numeric data, in row-major order. If passing 'csv_input=false',
+*       it should contain the raw bytes of the 'double' values of each row, one after another (as
+*       they are laid out in memory), in a machine with the same endianness as the current one,
+*       and should be opened in binary mode. If passing 'csv_input=true', it should contain one row
+*       per line, with the values separated by 'delimiter'. Empty fields and fields with value 'NA'
+*       are taken as missing values, which are handled as in 'predict_iforest'.
+* - output
+*       Stream to which to write the scores, in the same order as the rows of the input. If passing
+*       'binary_output=false', will write one score per line as text, otherwise will write the raw
+*       bytes of the 'double' values (in which case the stream should be opened in binary mode).
+* - ncols_numeric
+*       Number of columns in each row of the input. Must cover all of the columns used by the model.
+* - csv_input
+*       Whether the input is in text format (delimited values) or in raw binary format.
+* - delimiter
+*       Character that separates the values in each line, when passing 'csv_input=true'.
+* - skip_header
+*       Whether to skip the first line of the input, when passing 'csv_input=true'.
+* - binary_output
+*       Whether to write the scores in raw binary format or as text.
+* - chunk_rows
+*       Number of rows to read and score at a time. Memory usage is proportional to twice this number
+*       times 'ncols_numeric'. Pass zero to use chunks of around 8MB.
+* - nthreads
+*       Number of parallel threads to use for scoring each chunk, as in 'predict_iforest'. Reading
+*       and parsing the input is done in one additional thread, which runs at the same time as the
+*       scoring of the previous chunk.
+* - standardize
+*       Whether to output standardized outlier scores or average depths, as in 'predict_iforest'.
+* - model_outputs
+*       Pointer to fitted single-variable model object from function 'fit_iforest'. Pass NULL
+*       if the predictions are to be made from an extended model. Can only pass one of
+*       'model_outputs' and 'model_outputs_ext'.
+* - model_outputs_ext
+*       Pointer to fitted extended model object from function 'fit_iforest'. Pass NULL
+*       if the predictions are to be made from a single-variable model. Can only pass one of
+*       'model_outputs' and 'model_outputs_ext'.
+* 
+* The model must not have any splits on categorical columns, since those cannot be passed here.
+* 
+* Returns
+* =======
+* Number of rows that were scored.
+*/
+ISOTREE_EXPORTED
+size_t predict_iforest_stream(std::istream &input, std::ostream &output,
+                              size_t ncols_numeric, bool csv_input, char delimiter, bool skip_header,
+                              bool binary_output, size_t chunk_rows, int nthreads, bool standardize,
+                              IsoForest *model_outputs, ExtIsoForest *model_outputs_ext);
+
+/* Same as above, but reading from and writing to files. Passing NULL or "-" as file name will
+   read from standard input or write to standard output, respectively. Existing output files
+   will be overwritten. */
+ISOTREE_EXPORTED
+size_t predict_iforest_stream(const char *input_file, const char *output_file,
+                              size_t ncols_numeric, bool csv_input, char delimiter, bool skip_header,
+                              bool binary_output, size_t chunk_rows, int nthreads, bool standardize,
+                              IsoForest *model_outputs, ExtIsoForest *model_outputs_ext);
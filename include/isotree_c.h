@@ -238,6 +238,7 @@ typedef struct isotree_prediction_data {
 
 typedef void* isotree_parameters_t; /* <- do not confuse with 'isotree_parameters' */
 typedef void* isotree_model_t; /* <- it's a pointer to a C++ 'IsolationForest' object instance */
+typedef void* isotree_prediction_context_t; /* <- it's a pointer to a C++ 'PredictionContext' object */
 
 
 /*  Note: this returns an 'isotree_parameters' type, but the function that fits the
@@ -586,10 +587,55 @@ size_t isotree_get_ntrees(const isotree_model_t isotree_model);
 ISOTREE_EXPORTED
 isotree_exit_code isotree_build_indexer(isotree_model_t isotree_model, const isotree_bool with_distances);
 
+/*  Re-arranges the tree nodes in a more cache-friendly layout for faster predictions.
+    Note that terminal node numbers from predictions will change after calling this.  */
+ISOTREE_EXPORTED
+isotree_exit_code isotree_reorder_nodes(isotree_model_t isotree_model);
+
 /*  If an error occurs (e.g. passing a NULL pointer), will return NULL.  */
 ISOTREE_EXPORTED
 isotree_model_t isotree_copy_model(isotree_model_t isotree_model);
 
+/*  For scoring one row at a time with low latency, can build a context in advance and then
+    call 'isotree_score_row' with it, which will not allocate any memory nor use multiple threads.
+    The context refers to the model object, so it must be deleted and built again if the model is
+    modified (e.g. by calling 'isotree_reorder_nodes'), and must be deleted before the model.
+
+    If an error occurs (e.g. passing a NULL pointer), will return NULL.  */
+ISOTREE_EXPORTED
+isotree_prediction_context_t isotree_build_prediction_context(const isotree_model_t isotree_model,
+                                                              isotree_bool standardize_scores);
+
+ISOTREE_EXPORTED
+void isotree_delete_prediction_context(isotree_prediction_context_t prediction_context);
+
+/*  'numeric_row' and 'categ_row' contain the numeric and categorical columns of a single row,
+    in the same order as the data to which the model was fit. 'categ_row' may be NULL if the
+    model was fit to numeric data only. Passing a NULL context will return NAN.  */
+ISOTREE_EXPORTED
+double isotree_score_row(const isotree_prediction_context_t prediction_context,
+                         const double *numeric_row, const int *categ_row);
+
+/*  For data that does not fit in memory, will read rows in chunks from 'input_file' and write
+    their scores to 'output_file' (one per line as text, or as raw 'double' values if passing
+    'binary_output=true'), while the next chunk is read and parsed in a separate thread. Passing
+    NULL or "-" will use standard input or output instead of a file.
+
+    The input must contain 'ncols_numeric' numeric columns per row (categorical columns are not
+    supported), either as raw 'double' values in row-major order (as laid out in memory), or as
+    text with one row per line and values separated by 'delimiter' if passing 'csv_input=true',
+    in which case empty fields and 'NA' are taken as missing values. 'chunk_rows' is the number
+    of rows to read at a time (pass zero to use chunks of around 8MB), which determines memory usage.
+
+    If 'nrows_scored' is not NULL, will output there the number of rows that were scored.  */
+ISOTREE_EXPORTED
+isotree_exit_code isotree_predict_stream(isotree_model_t isotree_model,
+                                         const char *input_file, const char *output_file,
+                                         size_t ncols_numeric, isotree_bool csv_input,
+                                         char delimiter, isotree_bool skip_header,
+                                         isotree_bool binary_output, isotree_bool standardize_scores,
+                                         size_t chunk_rows, size_t *nrows_scored);
+
 #ifdef __cplusplus
 }
 #endif
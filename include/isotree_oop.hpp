@@ -127,6 +127,8 @@ public:
     double prob_pick_col_by_var = 0.;
     double prob_pick_col_by_kurt = 0.;
     double min_gain = 0.;
+    SplitSearch split_search = SortedSearch; /* only for ndim==1 */
+    size_t node_task_rows = 0; /* if >0, splits large nodes of a tree in parallel */
     MissingAction missing_action = Impute;
 
     /*  For categorical variables  */
@@ -141,7 +143,21 @@ public:
     UseDepthImp depth_imp = Higher;
     WeighImpRows weigh_imp_rows = Inverse;
 
-    /*  Internal objects which can be used with the non-OOP interface  */
+    /*  If 'true', will re-arrange the tree nodes after fitting for faster predictions
+        (see 'reorder_nodes' for details)  */
+    bool   reorder_nodes_after_fit = false;
+
+    /*  If 'true', will build a flattened copy of the model after fitting (see
+        'build_compiled'), which 'predict' then uses for dense numeric data. This
+        copy takes about as much memory as the trees themselves, and is kept for
+        as long as the object lives. If 'false', 'predict' builds a temporary copy
+        inside each call that has enough rows for it to pay off.  */
+    bool   keep_compiled_forest = false;
+
+    /*  Internal objects which can be used with the non-OOP interface. Note that if
+        the object keeps a flattened copy of the model (see 'build_compiled'), and the
+        trees in 'model' or 'model_ext' are modified directly (without going through
+        'get_model' or 'get_model_ext'), must call 'clear_compiled' afterwards.  */
     IsoForest model;
     ExtIsoForest model_ext;
     Imputer imputer;
@@ -193,6 +209,18 @@ public:
              int    categ_data[],     size_t ncols_categ,    int ncat[],
              double sample_weights[], double col_weights[]);
 
+    /*  Dense data may also be in row-major order (like C), and/or have leading
+        dimensions larger than its number of rows (column-major) or columns
+        (row-major), such as a view over some of the columns of a larger array.
+        Passing zero for 'ld_numeric' or 'ld_categ' will assume no padding.
+        The full data is not copied - each tree is fit to a copy of the rows
+        that it takes, of which there are at most as many at a time as there
+        are threads.  */
+    void fit(double numeric_data[],   size_t ncols_numeric,  size_t nrows,
+             int    categ_data[],     size_t ncols_categ,    int ncat[],
+             bool   is_col_major,     size_t ld_numeric,     size_t ld_categ,
+             double sample_weights[], double col_weights[]);
+
     /*  Numeric data may also be supplied as a sparse matrix, in which case it
         must be CSC format (colum-major). Categorical data is not supported in
         sparse format.  */
@@ -237,11 +265,34 @@ public:
         predictions in CSC format will be faster than in CSR (assuming that
         categorical data is either missing or column-major). Note that for CSC,
         parallelization is done by trees instead of by rows, and outputs are
-        subject to numerical rounding error between runs.  */
+        reproducible between runs and for any number of threads.  */
     void predict(double X_sparse[], int X_ind[], int X_indptr[], bool is_csc,
                  int categ_data[], bool is_col_major, size_t ld_categ, size_t nrows, bool standardize,
                  double output_depths[], int tree_num[], double per_tree_depths[]);
 
+    /*  For scoring one row at a time with low latency, can build a context in advance
+        and then call 'score_row' with it, which will not allocate any memory nor use
+        multiple threads. The context keeps a pointer to the model inside this object,
+        so it must be built again if the object is modified, moved, or destroyed.
+        'categ_row' may be NULL if the model was fit to numeric data only.  */
+    PredictionContext get_prediction_context(bool standardize=true) const;
+
+    static double score_row(const PredictionContext &context, const double numeric_row[], const int categ_row[]=nullptr);
+
+    /*  For data that does not fit in memory, can score rows read in chunks from a stream
+        or file (pass "-" for standard input/output) with numeric columns only, either as raw
+        binary 'double' values in row-major order or as delimited text, writing the scores one
+        per line (or as raw binary if passing 'binary_output=true'). Reading and parsing of the
+        next chunk is done in a separate thread while the current one is being scored. Returns
+        the number of rows scored. See 'predict_iforest_stream' for more details.  */
+    size_t predict_stream(std::istream &input, std::ostream &output, size_t ncols_numeric,
+                          bool csv_input, char delimiter, bool skip_header, bool binary_output,
+                          bool standardize, size_t chunk_rows=0);
+
+    size_t predict_stream(const char *input_file, const char *output_file, size_t ncols_numeric,
+                          bool csv_input, char delimiter, bool skip_header, bool binary_output,
+                          bool standardize, size_t chunk_rows=0);
+
     /*  Distances between observations will be returned either as a triangular matrix
         representing an upper diagonal (length is nrows*(nrows-1)/2), or as a full
         square matrix (length is nrows^2).  */
@@ -282,6 +333,13 @@ public:
 
     void build_indexer(const bool with_distances);
 
+    /*  Re-arranges the nodes of each tree (along with the imputer and indexer, if present)
+        in a more cache-friendly memory layout, which speeds up predictions. This is done
+        automatically after fitting if 'reorder_nodes_after_fit=true', and can also be
+        applied to de-serialized models. Note that terminal node numbers from predictions
+        will change after calling this.  */
+    void reorder_nodes();
+
     /*  Sets points as reference to later calculate distances or kernel from arbitrary points
         to these ones, without having to save these reference points's original features.  */
     void set_as_reference_points(double numeric_data[], int categ_data[], bool is_col_major,
@@ -336,6 +394,11 @@ public:
                        const std::vector<std::string> &categ_colnames,
                        const std::vector<std::vector<std::string>> &categ_levels) const;
 
+    /*  Generate the source code of a self-contained C/C++ function that calculates
+        the outlier score for a single row, with the model hard-coded into it.
+        See 'generate_cpp' in 'isotree.hpp' for details. */
+    std::string to_cpp(const std::string &function_name, bool standardize=true) const;
+
 
     /*  Serialize (save) the model to a file. See 'isotree.hpp' for compatibility
         details. Note that this does not save all the details of the object, but
@@ -402,9 +465,28 @@ public:
     /*  This checks whether 'predict' can output 'tree_num' and 'per_tree_depths'.  */
     bool check_can_predict_per_tree() const;
 
+    /*  This builds a flattened copy of the model that is kept inside the object and
+        used by 'predict' on dense numeric data (see 'build_compiled_forest' in
+        'isotree.hpp'), which is done automatically after fitting if passing
+        'keep_compiled_forest=true', and can also be done after de-serializing a model.
+        It will do nothing if the model cannot be compiled (only models with
+        'missing_action=Fail', no range penalty, and no categorical splits can be).
+        Note that 'predict' only reads this copy, so it can be called from multiple
+        threads on the same object, but this function and 'clear_compiled' cannot
+        run concurrently with 'predict'.  */
+    void build_compiled();
+
+    /*  This discards the flattened copy of the model, if it was built.  */
+    void clear_compiled();
+
 private:
     bool is_fitted = false;
+    bool has_compiled = false;
+    CompiledIsoForest compiled;
+    CompiledExtIsoForest compiled_ext;
 
+    bool predict_compiled(double numeric_data[], bool is_col_major, size_t nrows, size_t ld_numeric,
+                          bool standardize, double output_depths[], int tree_num[], double per_tree_depths[]) const;
     void override_previous_fit();
     void check_params();
     void check_is_fitted() const;
@@ -46,8 +46,24 @@ def _is_col_major(X_num):
     else:
         return X_num.strides[0] == X_num.dtype.itemsize
 
+def _copy_if_not_strided(X_num):
+    ### The fitting function accepts row-major or column-major data with a
+    ### leading dimension, so views only need to be copied when neither
+    ### dimension has unit stride
+    if (X_num is not None) and (not issparse(X_num)):
+        if (
+                (len(X_num.strides) != 2) or
+                (not X_num.flags.aligned) or
+                (not _is_row_major(X_num) and not _is_col_major(X_num)) or
+                (min(X_num.strides) < 0) or
+                (X_num.strides[0] % X_num.dtype.itemsize) or
+                (X_num.strides[1] % X_num.dtype.itemsize)
+            ):
+            X_num = np.require(X_num, requirements=["ENSUREARRAY", "F_CONTIGUOUS"])
+    return X_num
+
 def _copy_if_subview(X_num, prefer_row_major=False):
-    ### TODO: the C++ functions should accept a 'leading dimension'
+    ### TODO: the C++ prediction functions should accept a 'leading dimension'
     ### parameter so as to avoid copying the data here
     if (X_num is not None) and (not issparse(X_num)):
         col_major = _is_col_major(X_num)
@@ -1583,6 +1599,11 @@ class IsolationForest(BaseEstimator):
 
         self._reset_obj()
         X_num, X_cat, ncat, sample_weights, column_weights, nrows = self._process_data(X, None, column_weights)
+        if output_imputed:
+            ### imputations are written into the arrays that are passed, so
+            ### views of the input data are copied here as before
+            X_num = _copy_if_subview(X_num, False)
+            X_cat = _copy_if_subview(X_cat, False)
 
         if (X_cat is not None) and (self.prob_pick_col_by_range_):
             raise ValueError("'prob_pick_col_by_range' is incompatible with categorical data.")
@@ -1716,9 +1737,8 @@ class IsolationForest(BaseEstimator):
 
             ### https://stackoverflow.com/questions/25039626/how-do-i-find-numeric-columns-in-pandas
             X_num = X.select_dtypes(include = [np.number, np.datetime64]).to_numpy(copy=False)
-            X_num = np.require(X_num, requirements=["ENSUREARRAY", "F_CONTIGUOUS"])
             if X_num.dtype not in [ctypes.c_double, ctypes.c_float]:
-                X_num = np.require(X_num, dtype=ctypes.c_double, requirements=["ENSUREARRAY", "F_CONTIGUOUS"])
+                X_num = X_num.astype(ctypes.c_double)
             X_cat = X.select_dtypes(include = [pd.CategoricalDtype, "object", "bool"])
             if (X_num.shape[1] + X_cat.shape[1]) == 0:
                 raise ValueError("Input data has no columns of numeric or categorical type.")
@@ -1842,9 +1862,9 @@ class IsolationForest(BaseEstimator):
                         _sort_csc_indices(X)
                 
                 else:
-                    X = np.require(X, requirements=["ENSUREARRAY", "F_CONTIGUOUS"])
+                    X = np.asarray(X)
                     if X.dtype not in [ctypes.c_double, ctypes.c_float]:
-                        X = np.require(X, dtype=ctypes.c_double, requirements=["ENSUREARRAY", "F_CONTIGUOUS"])
+                        X = X.astype(ctypes.c_double)
 
             self._ncols_numeric = X.shape[1]
             self._ncols_categ   = 0 if (X_cat is None) else X_cat.shape[1]
@@ -1941,8 +1961,11 @@ class IsolationForest(BaseEstimator):
                     if self.new_categ_action == "auto":
                         self.new_categ_action_ = "weighted"
 
-        X_num = _copy_if_subview(X_num, False)
-        X_cat = _copy_if_subview(X_cat, False)
+        X_num = _copy_if_not_strided(X_num)
+        X_cat = _copy_if_not_strided(X_cat)
+        ### numeric and categorical data must have the same orientation
+        if (X_num is not None) and (not issparse(X_num)) and (X_cat is not None) and (_is_col_major(X_num) != _is_col_major(X_cat)):
+            X_num = np.require(X_num, requirements=["ENSUREARRAY", "F_CONTIGUOUS"])
 
         return X_num, X_cat, ncat, sample_weights, column_weights, nrows
 
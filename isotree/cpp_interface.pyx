@@ -124,6 +124,11 @@ cdef extern from "headers_joined.hpp":
         Prop = 81
         Flat = 82
 
+    ctypedef enum SplitSearch:
+        SortedSearch = 0
+        HistogramSearch = 101
+        PresortedSearch = 102
+
     ctypedef enum ScoringMetric:
         Depth = 0
         Density = 92
@@ -332,6 +337,7 @@ cdef extern from "headers_joined.hpp":
                     IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
                     real_t_ *numeric_data,  size_t ncols_numeric,
                     int    *categ_data,    size_t ncols_categ,    int *ncat,
+                    bool_t is_col_major, size_t ld_numeric, size_t ld_categ,
                     real_t_ *Xc, sparse_ix_ *Xc_ind, sparse_ix_ *Xc_indptr,
                     size_t ndim, size_t ntry, CoefType coef_type, bool_t coef_by_prop,
                     real_t_ *sample_weights, bool_t with_replacement, bool_t weight_as_sample,
@@ -346,11 +352,12 @@ cdef extern from "headers_joined.hpp":
                     double prob_pick_by_full_gain, double prob_pick_by_dens,
                     double prob_pick_col_by_range, double prob_pick_col_by_var,
                     double prob_pick_col_by_kurt,
-                    double min_gain, MissingAction missing_action,
+                    double min_gain, SplitSearch split_search, MissingAction missing_action,
                     CategSplit cat_split_type, NewCategAction new_cat_action,
                     bool_t all_perm, Imputer *imputer, size_t min_imp_obs,
                     UseDepthImp depth_imp, WeighImpRows weigh_imp_rows, bool_t impute_at_fit,
-                    uint64_t random_seed, bool_t use_long_double, int nthreads) except + nogil
+                    uint64_t random_seed, bool_t use_long_double, size_t node_task_rows,
+                    bool_t reorder_nodes_after_fit, int nthreads) except + nogil
 
     void predict_iforest[real_t_, sparse_ix_](
                          real_t_ *numeric_data, int *categ_data,
@@ -496,6 +503,14 @@ cdef int* get_ptr_int_mat(np.ndarray[int, ndim = 2] a):
 cdef float* get_ptr_float_mat(np.ndarray[float, ndim = 2] a):
     return &a[0, 0]
 
+cdef bool_t get_is_col_major(a):
+    return a.strides[0] == a.dtype.itemsize
+
+cdef size_t get_leading_dim(a, bool_t is_col_major):
+    if a.shape[1 if is_col_major else 0] <= 1:
+        return 0
+    return <size_t>(a.strides[1 if is_col_major else 0] / a.dtype.itemsize)
+
 def _get_has_openmp():
     return get_has_openmp()
 
@@ -714,6 +729,9 @@ cdef class isoforest_cpp_obj:
         cdef sparse_ix*  Xc_indptr_ptr       =  NULL
         cdef real_t*     sample_weights_ptr  =  NULL
         cdef real_t*     col_weights_ptr     =  NULL
+        cdef bool_t      is_col_major        =  True
+        cdef size_t      ld_numeric          =  0
+        cdef size_t      ld_categ            =  0
 
         if X_num is not None:
             if not issparse(X_num):
@@ -723,6 +741,8 @@ cdef class isoforest_cpp_obj:
                     if X_num.dtype != ctypes.c_double:
                         X_num = X_num.astype(ctypes.c_double)
                     numeric_data_ptr  =  get_ptr_dbl_mat(X_num)
+                is_col_major  =  get_is_col_major(X_num)
+                ld_numeric    =  get_leading_dim(X_num, is_col_major)
             else:
                 if real_t is float:
                     Xc_ptr         =  get_ptr_float_vec(X_num.data)
@@ -746,6 +766,9 @@ cdef class isoforest_cpp_obj:
         if X_cat is not None:
             categ_data_ptr     =  get_ptr_int_mat(X_cat)
             ncat_ptr           =  get_ptr_int_vec(ncat)
+            if (X_num is None) or (issparse(X_num)):
+                is_col_major   =  get_is_col_major(X_cat)
+            ld_categ           =  get_leading_dim(X_cat, is_col_major)
         if sample_weights is not None:
             if real_t is float:
                 sample_weights_ptr =  get_ptr_float_vec(sample_weights)
@@ -841,6 +864,7 @@ cdef class isoforest_cpp_obj:
             fit_iforest(model_ptr, ext_model_ptr,
                         numeric_data_ptr,  ncols_numeric,
                         categ_data_ptr,    ncols_categ,    ncat_ptr,
+                        is_col_major, ld_numeric, ld_categ,
                         Xc_ptr, Xc_ind_ptr, Xc_indptr_ptr,
                         ndim, ntry, coef_type_C, coef_by_prop,
                         sample_weights_ptr, with_replacement, weight_as_sample,
@@ -855,11 +879,11 @@ cdef class isoforest_cpp_obj:
                         prob_pick_by_full_gain, prob_pick_by_dens,
                         prob_pick_col_by_range, prob_pick_col_by_var,
                         prob_pick_col_by_kurt,
-                        min_gain, missing_action_C,
+                        min_gain, SortedSearch, missing_action_C,
                         cat_split_type_C, new_cat_action_C,
                         all_perm, imputer_ptr, min_imp_obs,
                         depth_imp_C, weigh_imp_rows_C, impute_at_fit,
-                        random_seed, use_long_double, nthreads)
+                        random_seed, use_long_double, 0, False, nthreads)
 
         if cy_check_interrupt_switch():
             cy_tick_off_interrupt_switch()
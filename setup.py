@@ -323,7 +323,11 @@ setup(
                                 sources=["isotree/cpp_interface.pyx",
                                          "src/indexer.cpp",
                                          "src/merge_models.cpp", "src/subset_models.cpp",
-                                         "src/serialize.cpp", "src/sql.cpp",
+                                         "src/bin_plan.cpp", "src/bitvector_forest.cpp",
+                                         "src/compiled_forest.cpp", "src/reorder_nodes.cpp",
+                                         "src/flat_model.cpp", "src/compiled_simd.cpp", "src/cache_blocking.cpp",
+                                         "src/prediction_context.cpp", "src/executor.cpp",
+                                         "src/serialize.cpp", "src/sql.cpp", "src/cpp_generator.cpp",
                                          "src/formatted_exporters.cpp"],
                                 include_dirs=[np.get_include(), ".", "./src"],
                                 language="c++",
@@ -0,0 +1,134 @@
+/*    Isolation forests and variations thereof, with adjustments for incorporation
+*     of categorical variables and missing values.
+*     Writen for C++11 standard and aimed at being used in R and Python.
+*     
+*     This library is based on the following works:
+*     [1] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation forest."
+*         2008 Eighth IEEE International Conference on Data Mining. IEEE, 2008.
+*     [2] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation-based anomaly detection."
+*         ACM Transactions on Knowledge Discovery from Data (TKDD) 6.1 (2012): 3.
+*     [3] Hariri, Sahand, Matias Carrasco Kind, and Robert J. Brunner.
+*         "Extended Isolation Forest."
+*         arXiv preprint arXiv:1811.02141 (2018).
+*     [4] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "On detecting clustered anomalies using SCiForest."
+*         Joint European Conference on Machine Learning and Knowledge Discovery in Databases. Springer, Berlin, Heidelberg, 2010.
+*     [5] https://sourceforge.net/projects/iforest/
+*     [6] https://math.stackexchange.com/questions/3388518/expected-number-of-paths-required-to-separate-elements-in-a-binary-tree
+*     [7] Quinlan, J. Ross. C4. 5: programs for machine learning. Elsevier, 2014.
+*     [8] Cortes, David.
+*         "Distance approximation using Isolation Forests."
+*         arXiv preprint arXiv:1910.12362 (2019).
+*     [9] Cortes, David.
+*         "Imputing missing values with unsupervised random trees."
+*         arXiv preprint arXiv:1911.06646 (2019).
+*     [10] https://math.stackexchange.com/questions/3333220/expected-average-depth-in-random-binary-tree-constructed-top-to-bottom
+*     [11] Cortes, David.
+*          "Revisiting randomized choices in isolation forests."
+*          arXiv preprint arXiv:2110.13402 (2021).
+*     [12] Guha, Sudipto, et al.
+*          "Robust random cut forest based anomaly detection on streams."
+*          International conference on machine learning. PMLR, 2016.
+*     [13] Cortes, David.
+*          "Isolation forests: looking beyond tree depth."
+*          arXiv preprint arXiv:2111.11639 (2021).
+*     [14] Ting, Kai Ming, Yue Zhu, and Zhi-Hua Zhou.
+*          "Isolation kernel and its effect on SVM"
+*          Proceedings of the 24th ACM SIGKDD
+*          International Conference on Knowledge Discovery & Data Mining. 2018.
+* 
+*     BSD 2-Clause License
+*     Copyright (c) 2019-2022, David Cortes
+*     All rights reserved.
+*     Redistribution and use in source and binary forms, with or without
+*     modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this
+*       list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*       this list of conditions and the following disclaimer in the documentation
+*       and/or other materials provided with the distribution.
+*     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+*     AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+*     IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*     FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*     DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*     SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*     CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*     OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*     OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "isotree.hpp"
+
+/* Build a version of a single-variable model which makes predictions on data converted to bins
+* 
+* Parameters
+* ==========
+* - plan (out)
+*       Object where the binned model will be stored. Any previous contents will be overwritten.
+* - model
+*       Single-variable isolation forest model which has already been fit through 'fit_iforest'.
+*       Must have been fit to numeric-only data, with 'missing_action=Fail' and without range penalty,
+*       and no column can have more than 65535 distinct split thresholds across all the trees.
+*       Data to predict on is converted to bin indices through 'bin_numeric_data', and predictions
+*       are then made with 'predict_iforest_binned'. The conversion needs a binary search per value,
+*       so this is most advantageous when the same rows are scored more than once (e.g. against
+*       several models built on the same plan, or when the binned rows are kept for later use),
+*       or when the data is already stored as bin indices.
+* - nthreads
+*       Number of parallel threads to use.
+*/
+void build_bin_plan(BinPlan &plan, const IsoForest &model, int nthreads)
+{
+    CompiledIsoForest compiled;
+    build_compiled_forest(compiled, model, false, nthreads);
+
+    const size_t ncols_numeric = compiled.ncols_numeric;
+    const size_t tot_nodes = compiled.num_split.size();
+    std::vector<std::vector<double>> col_thresholds(ncols_numeric);
+    for (size_t node = 0; node < tot_nodes; node++)
+    {
+        if (compiled.tree_left[node])
+            col_thresholds[compiled.col_num[node]].push_back(compiled.num_split[node]);
+    }
+
+    std::vector<size_t> col_offsets(ncols_numeric + 1);
+    col_offsets[0] = 0;
+    size_t max_thresholds = 0;
+    for (size_t col = 0; col < ncols_numeric; col++)
+    {
+        std::vector<double> &thresholds = col_thresholds[col];
+        std::sort(thresholds.begin(), thresholds.end());
+        thresholds.erase(std::unique(thresholds.begin(), thresholds.end()), thresholds.end());
+        max_thresholds = std::max(max_thresholds, thresholds.size());
+        col_offsets[col+1] = col_offsets[col] + thresholds.size();
+    }
+    if (unlikely(max_thresholds > (size_t)UINT16_MAX))
+        throw std::runtime_error("Model has too many distinct thresholds in a column for binning.\n");
+
+    plan.thresholds.resize(col_offsets.back());
+    for (size_t col = 0; col < ncols_numeric; col++)
+        std::copy(col_thresholds[col].begin(), col_thresholds[col].end(), plan.thresholds.begin() + col_offsets[col]);
+
+    plan.split_bin.assign(tot_nodes, 0);
+    for (size_t node = 0; node < tot_nodes; node++)
+    {
+        if (!compiled.tree_left[node]) continue;
+        const double *col_st = plan.thresholds.data() + col_offsets[compiled.col_num[node]];
+        const double *col_end = plan.thresholds.data() + col_offsets[compiled.col_num[node] + 1];
+        plan.split_bin[node] = std::lower_bound(col_st, col_end, compiled.num_split[node]) - col_st;
+    }
+
+    plan.col_offsets = std::move(col_offsets);
+    plan.col_num = std::move(compiled.col_num);
+    plan.tree_left = std::move(compiled.tree_left);
+    plan.score = std::move(compiled.score);
+    plan.tree_offsets = std::move(compiled.tree_offsets);
+    plan.scoring_metric = compiled.scoring_metric;
+    plan.exp_avg_depth = compiled.exp_avg_depth;
+    plan.ncols_numeric = ncols_numeric;
+    /* bins go from zero up to the number of thresholds, both inclusive */
+    plan.wide_bins = max_thresholds > (size_t)UINT8_MAX;
+}
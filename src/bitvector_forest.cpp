@@ -0,0 +1,211 @@
+/*    Isolation forests and variations thereof, with adjustments for incorporation
+*     of categorical variables and missing values.
+*     Writen for C++11 standard and aimed at being used in R and Python.
+*     
+*     This library is based on the following works:
+*     [1] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation forest."
+*         2008 Eighth IEEE International Conference on Data Mining. IEEE, 2008.
+*     [2] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation-based anomaly detection."
+*         ACM Transactions on Knowledge Discovery from Data (TKDD) 6.1 (2012): 3.
+*     [3] Hariri, Sahand, Matias Carrasco Kind, and Robert J. Brunner.
+*         "Extended Isolation Forest."
+*         arXiv preprint arXiv:1811.02141 (2018).
+*     [4] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "On detecting clustered anomalies using SCiForest."
+*         Joint European Conference on Machine Learning and Knowledge Discovery in Databases. Springer, Berlin, Heidelberg, 2010.
+*     [5] https://sourceforge.net/projects/iforest/
+*     [6] https://math.stackexchange.com/questions/3388518/expected-number-of-paths-required-to-separate-elements-in-a-binary-tree
+*     [7] Quinlan, J. Ross. C4. 5: programs for machine learning. Elsevier, 2014.
+*     [8] Cortes, David.
+*         "Distance approximation using Isolation Forests."
+*         arXiv preprint arXiv:1910.12362 (2019).
+*     [9] Cortes, David.
+*         "Imputing missing values with unsupervised random trees."
+*         arXiv preprint arXiv:1911.06646 (2019).
+*     [10] https://math.stackexchange.com/questions/3333220/expected-average-depth-in-random-binary-tree-constructed-top-to-bottom
+*     [11] Cortes, David.
+*          "Revisiting randomized choices in isolation forests."
+*          arXiv preprint arXiv:2110.13402 (2021).
+*     [12] Guha, Sudipto, et al.
+*          "Robust random cut forest based anomaly detection on streams."
+*          International conference on machine learning. PMLR, 2016.
+*     [13] Cortes, David.
+*          "Isolation forests: looking beyond tree depth."
+*          arXiv preprint arXiv:2111.11639 (2021).
+*     [14] Ting, Kai Ming, Yue Zhu, and Zhi-Hua Zhou.
+*          "Isolation kernel and its effect on SVM"
+*          Proceedings of the 24th ACM SIGKDD
+*          International Conference on Knowledge Discovery & Data Mining. 2018.
+* 
+*     BSD 2-Clause License
+*     Copyright (c) 2019-2022, David Cortes
+*     All rights reserved.
+*     Redistribution and use in source and binary forms, with or without
+*     modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this
+*       list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*       this list of conditions and the following disclaimer in the documentation
+*       and/or other materials provided with the distribution.
+*     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+*     AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+*     IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*     FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*     DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*     SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*     CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*     OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*     OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "isotree.hpp"
+
+struct BitvectorCondition {
+    double   threshold;
+    uint32_t word;
+    uint64_t mask;
+};
+
+/* Assigns to each node the range of terminal nodes under it, numbering them from left to right */
+static void assign_leaf_ranges(const std::vector<IsoTree> &tree, size_t node, uint32_t &n_leaves,
+                               uint32_t *restrict leaves_st, uint32_t *restrict leaves_end) noexcept
+{
+    leaves_st[node] = n_leaves;
+    if (tree[node].tree_left == 0)
+        n_leaves++;
+    else {
+        assign_leaf_ranges(tree, tree[node].tree_left, n_leaves, leaves_st, leaves_end);
+        assign_leaf_ranges(tree, tree[node].tree_right, n_leaves, leaves_st, leaves_end);
+    }
+    leaves_end[node] = n_leaves;
+}
+
+/* Mask that clears the bits for terminal nodes [leaves_st, leaves_end) within a given word */
+static uint64_t leaf_range_mask(size_t leaves_st, size_t leaves_end, size_t word) noexcept
+{
+    size_t bit_st = std::max(leaves_st, 64 * word) - 64 * word;
+    size_t bit_end = std::min(leaves_end, 64 * (word + 1)) - 64 * word;
+    uint64_t bits = (bit_end == 64)? ~(uint64_t)0 : (((uint64_t)1 << bit_end) - 1);
+    bits &= ~(uint64_t)0 << bit_st;
+    return ~bits;
+}
+
+/* Build a version of a single-variable model which evaluates the trees feature-by-feature
+* 
+* Parameters
+* ==========
+* - bv_forest (out)
+*       Object where the rearranged model will be stored. Any previous contents will be overwritten.
+* - model
+*       Single-variable isolation forest model which has already been fit through 'fit_iforest'.
+*       Must have been fit to numeric-only data, with 'missing_action=Fail' and without range penalty.
+*       This type of evaluation is most advantageous for shallow trees (e.g. the default of limiting
+*       the depth to log2(sample_size)) with many trees and columns, as it replaces the unpredictable
+*       branching of node traversal with sequential scans over the sorted thresholds.
+*/
+void build_bitvector_forest(BitvectorIsoForest &bv_forest, const IsoForest &model)
+{
+    if (model.missing_action != Fail)
+        throw std::runtime_error("Bitvector forests are only supported for models with 'missing_action=Fail'.\n");
+    if (model.has_range_penalty)
+        throw std::runtime_error("Bitvector forests are not supported for models with range penalty.\n");
+
+    const size_t ntrees = model.trees.size();
+    size_t ncols_numeric = 0;
+    size_t max_leaves = 0;
+    std::vector<size_t> leaf_offsets(ntrees + 1);
+    leaf_offsets[0] = 0;
+    for (size_t tree = 0; tree < ntrees; tree++)
+    {
+        if (unlikely(model.trees[tree].size() >= (size_t)UINT32_MAX))
+            throw std::runtime_error("Model has trees that are too large for bitvector evaluation.\n");
+        size_t n_leaves = 0;
+        for (const IsoTree &node : model.trees[tree])
+        {
+            if (node.tree_left == 0) {
+                n_leaves++;
+                continue;
+            }
+            if (node.col_type != Numeric)
+                throw std::runtime_error("Bitvector forests are only supported for models without categorical columns.\n");
+            ncols_numeric = std::max(ncols_numeric, node.col_num + 1);
+        }
+        max_leaves = std::max(max_leaves, n_leaves);
+        leaf_offsets[tree+1] = leaf_offsets[tree] + n_leaves;
+    }
+    const size_t words_per_tree = std::max((size_t)1, (max_leaves + 63) / 64);
+    if (unlikely(ntrees * words_per_tree > (size_t)UINT32_MAX))
+        throw std::runtime_error("Model is too large for bitvector evaluation.\n");
+
+    std::vector<std::vector<BitvectorCondition>> conditions(ncols_numeric);
+    std::vector<double> leaf_score(leaf_offsets.back());
+    std::vector<uint32_t> leaf_terminal(leaf_offsets.back());
+    std::vector<uint32_t> leaves_st, leaves_end;
+    for (size_t tree = 0; tree < ntrees; tree++)
+    {
+        const std::vector<IsoTree> &nodes = model.trees[tree];
+        leaves_st.resize(nodes.size());
+        leaves_end.resize(nodes.size());
+        uint32_t n_leaves = 0;
+        assign_leaf_ranges(nodes, 0, n_leaves, leaves_st.data(), leaves_end.data());
+
+        /* terminal nodes are numbered in the order in which they appear in the tree */
+        uint32_t n_terminal = 0;
+        for (size_t node = 0; node < nodes.size(); node++)
+        {
+            if (nodes[node].tree_left == 0)
+            {
+                leaf_score[leaf_offsets[tree] + leaves_st[node]] = nodes[node].score;
+                leaf_terminal[leaf_offsets[tree] + leaves_st[node]] = n_terminal++;
+            }
+
+            else
+            {
+                size_t left = nodes[node].tree_left;
+                for (size_t word = leaves_st[left] / 64; word <= (leaves_end[left] - 1) / 64; word++)
+                    conditions[nodes[node].col_num].push_back({
+                        nodes[node].num_split,
+                        (uint32_t)(tree * words_per_tree + word),
+                        leaf_range_mask(leaves_st[left], leaves_end[left], word)
+                    });
+            }
+        }
+    }
+
+    std::vector<size_t> col_offsets(ncols_numeric + 1);
+    col_offsets[0] = 0;
+    for (size_t col = 0; col < ncols_numeric; col++)
+        col_offsets[col+1] = col_offsets[col] + conditions[col].size();
+
+    const size_t n_conditions = col_offsets.back();
+    bv_forest.thresholds.resize(n_conditions);
+    bv_forest.cond_word.resize(n_conditions);
+    bv_forest.cond_mask.resize(n_conditions);
+    for (size_t col = 0; col < ncols_numeric; col++)
+    {
+        std::stable_sort(conditions[col].begin(), conditions[col].end(),
+                         [](const BitvectorCondition &a, const BitvectorCondition &b)
+                         {return a.threshold < b.threshold;});
+        size_t ix = col_offsets[col];
+        for (const BitvectorCondition &cond : conditions[col])
+        {
+            bv_forest.thresholds[ix] = cond.threshold;
+            bv_forest.cond_word[ix] = cond.word;
+            bv_forest.cond_mask[ix] = cond.mask;
+            ix++;
+        }
+        conditions[col].clear();
+        conditions[col].shrink_to_fit();
+    }
+
+    bv_forest.col_offsets = std::move(col_offsets);
+    bv_forest.leaf_score = std::move(leaf_score);
+    bv_forest.leaf_terminal = std::move(leaf_terminal);
+    bv_forest.leaf_offsets = std::move(leaf_offsets);
+    bv_forest.words_per_tree = words_per_tree;
+    bv_forest.scoring_metric = model.scoring_metric;
+    bv_forest.exp_avg_depth = model.exp_avg_depth;
+    bv_forest.ncols_numeric = ncols_numeric;
+}
@@ -931,6 +931,25 @@ uint8_t isotree_build_indexer(void *isotree_model, const uint8_t with_distances)
     return IsoTreeSuccess;
 }
 
+ISOTREE_EXPORTED
+uint8_t isotree_reorder_nodes(void *isotree_model)
+{
+    if (!isotree_model) {
+        cerr << "Passed NULL 'isotree_model' to 'isotree_reorder_nodes'." << std::endl;
+        return IsoTreeError;
+    }
+    IsolationForest *model = (IsolationForest*)isotree_model;
+    try {
+        model->reorder_nodes();
+    }
+    catch (std::exception &e) {
+        cerr << e.what();
+        cerr.flush();
+        return IsoTreeError;
+    }
+    return IsoTreeSuccess;
+}
+
 ISOTREE_EXPORTED
 void* isotree_copy_model(void *isotree_model)
 {
@@ -952,6 +971,74 @@ void* isotree_copy_model(void *isotree_model)
     return nullptr;
 }
 
+ISOTREE_EXPORTED
+void* isotree_build_prediction_context(const void *isotree_model, uint8_t standardize_scores)
+{
+    if (!isotree_model) {
+        cerr << "Passed NULL 'isotree_model' to 'isotree_build_prediction_context'." << std::endl;
+        return nullptr;
+    }
+    const IsolationForest *model = (const IsolationForest*)isotree_model;
+    try {
+        std::unique_ptr<PredictionContext> context(new PredictionContext());
+        *context = model->get_prediction_context((bool)standardize_scores);
+        return context.release();
+    }
+    catch (std::exception &e) {
+        cerr << e.what();
+        cerr.flush();
+        return nullptr;
+    }
+    return nullptr;
+}
+
+ISOTREE_EXPORTED
+void isotree_delete_prediction_context(void *prediction_context)
+{
+    PredictionContext *ptr = (PredictionContext*)prediction_context;
+    delete ptr;
+}
+
+ISOTREE_EXPORTED
+double isotree_score_row(const void *prediction_context, const double *numeric_row, const int *categ_row)
+{
+    if (!prediction_context) return NAN;
+    return IsolationForest::score_row(*(const PredictionContext*)prediction_context, numeric_row, categ_row);
+}
+
+ISOTREE_EXPORTED
+int isotree_predict_stream(void *isotree_model,
+                           const char *input_file, const char *output_file,
+                           size_t ncols_numeric, uint8_t csv_input,
+                           char delimiter, uint8_t skip_header,
+                           uint8_t binary_output, uint8_t standardize_scores,
+                           size_t chunk_rows, size_t *nrows_scored)
+{
+    if (!isotree_model) {
+        cerr << "Passed NULL 'isotree_model' to 'isotree_predict_stream'." << std::endl;
+        return IsoTreeError;
+    }
+
+    IsolationForest *model = (IsolationForest*)isotree_model;
+    try
+    {
+        size_t nrows = model->predict_stream(input_file, output_file, ncols_numeric,
+                                             (bool)csv_input, delimiter, (bool)skip_header,
+                                             (bool)binary_output, (bool)standardize_scores,
+                                             chunk_rows);
+        if (nrows_scored) *nrows_scored = nrows;
+        return IsoTreeSuccess;
+    }
+
+    catch (std::exception &e)
+    {
+        cerr << e.what();
+        cerr.flush();
+    }
+
+    return IsoTreeError;
+}
+
 
 } /* extern "C" */
 
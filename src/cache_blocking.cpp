@@ -0,0 +1,200 @@
+/*    Isolation forests and variations thereof, with adjustments for incorporation
+*     of categorical variables and missing values.
+*     Writen for C++11 standard and aimed at being used in R and Python.
+*     
+*     This library is based on the following works:
+*     [1] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation forest."
+*         2008 Eighth IEEE International Conference on Data Mining. IEEE, 2008.
+*     [2] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation-based anomaly detection."
+*         ACM Transactions on Knowledge Discovery from Data (TKDD) 6.1 (2012): 3.
+*     [3] Hariri, Sahand, Matias Carrasco Kind, and Robert J. Brunner.
+*         "Extended Isolation Forest."
+*         arXiv preprint arXiv:1811.02141 (2018).
+*     [4] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "On detecting clustered anomalies using SCiForest."
+*         Joint European Conference on Machine Learning and Knowledge Discovery in Databases. Springer, Berlin, Heidelberg, 2010.
+*     [5] https://sourceforge.net/projects/iforest/
+*     [6] https://math.stackexchange.com/questions/3388518/expected-number-of-paths-required-to-separate-elements-in-a-binary-tree
+*     [7] Quinlan, J. Ross. C4. 5: programs for machine learning. Elsevier, 2014.
+*     [8] Cortes, David.
+*         "Distance approximation using Isolation Forests."
+*         arXiv preprint arXiv:1910.12362 (2019).
+*     [9] Cortes, David.
+*         "Imputing missing values with unsupervised random trees."
+*         arXiv preprint arXiv:1911.06646 (2019).
+*     [10] https://math.stackexchange.com/questions/3333220/expected-average-depth-in-random-binary-tree-constructed-top-to-bottom
+*     [11] Cortes, David.
+*          "Revisiting randomized choices in isolation forests."
+*          arXiv preprint arXiv:2110.13402 (2021).
+*     [12] Guha, Sudipto, et al.
+*          "Robust random cut forest based anomaly detection on streams."
+*          International conference on machine learning. PMLR, 2016.
+*     [13] Cortes, David.
+*          "Isolation forests: looking beyond tree depth."
+*          arXiv preprint arXiv:2111.11639 (2021).
+*     [14] Ting, Kai Ming, Yue Zhu, and Zhi-Hua Zhou.
+*          "Isolation kernel and its effect on SVM"
+*          Proceedings of the 24th ACM SIGKDD
+*          International Conference on Knowledge Discovery & Data Mining. 2018.
+* 
+*     BSD 2-Clause License
+*     Copyright (c) 2019-2022, David Cortes
+*     All rights reserved.
+*     Redistribution and use in source and binary forms, with or without
+*     modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this
+*       list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*       this list of conditions and the following disclaimer in the documentation
+*       and/or other materials provided with the distribution.
+*     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+*     AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+*     IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*     FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*     DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*     SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*     CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*     OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*     OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "isotree.hpp"
+#if defined(__APPLE__)
+    #include <sys/types.h>
+    #include <sys/sysctl.h>
+#elif defined(__unix__) || defined(__unix)
+    #include <unistd.h>
+#endif
+
+/* Used when the size cannot be determined from the system, which is on the low end of
+   what current CPUs have per core. */
+#define DEFAULT_L2_CACHE_SIZE ((size_t)512 * (size_t)1024)
+#define MIN_ROWS_PER_BLOCK ((size_t)16)
+#define MAX_ROWS_PER_BLOCK ((size_t)1024)
+
+static size_t query_l2_cache_size() noexcept
+{
+    long cache_size = 0;
+    #if defined(__APPLE__)
+    int64_t cache_size_ = 0;
+    size_t len = sizeof(cache_size_);
+    if (sysctlbyname("hw.l2cachesize", &cache_size_, &len, NULL, 0) == 0)
+        cache_size = (long)cache_size_;
+    #elif defined(_SC_LEVEL2_CACHE_SIZE)
+    cache_size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    #endif
+    return (cache_size > 0)? (size_t)cache_size : DEFAULT_L2_CACHE_SIZE;
+}
+
+size_t get_l2_cache_size() noexcept
+{
+    static const size_t l2_cache_size = query_l2_cache_size();
+    return l2_cache_size;
+}
+
+static size_t get_tree_bytes(const std::vector<IsoTree> &tree) noexcept
+{
+    size_t n_bytes = tree.size() * sizeof(IsoTree);
+    for (const IsoTree &node : tree)
+        n_bytes += node.cat_split.size() * sizeof(signed char);
+    return n_bytes;
+}
+
+static size_t get_tree_bytes(const std::vector<IsoHPlane> &hplane) noexcept
+{
+    size_t n_bytes = hplane.size() * sizeof(IsoHPlane);
+    for (const IsoHPlane &node : hplane)
+    {
+        n_bytes += node.col_num.size() * (sizeof(size_t) + sizeof(ColType));
+        n_bytes += (node.coef.size() + node.mean.size() + node.fill_val.size() + node.fill_new.size()) * sizeof(double);
+        n_bytes += node.chosen_cat.size() * sizeof(int);
+        for (const auto &cat_coef : node.cat_coef)
+            n_bytes += cat_coef.size() * sizeof(double);
+    }
+    return n_bytes;
+}
+
+/* Splits the trees into contiguous blocks that fit in about half of the L2 cache, and the rows
+   into blocks whose data takes about a quarter of it, while leaving enough row blocks to keep
+   all threads busy. Returns 'false' if blocking is not worth it, which is the case when the
+   whole model fits in the cache to begin with, or when there are too few rows to reuse it. */
+template <class TreeBytes>
+static bool get_tree_blocks_internal(size_t ntrees, TreeBytes &tree_bytes,
+                                     size_t nrows, size_t row_bytes, int nthreads,
+                                     std::vector<size_t> &tree_blocks, size_t &row_block)
+{
+    if (nrows < 4 * MIN_ROWS_PER_BLOCK || ntrees <= 1)
+        return false;
+
+    const size_t cache_size = get_l2_cache_size();
+    size_t total_bytes = 0;
+    size_t block_bytes = 0;
+    tree_blocks.assign(1, (size_t)0);
+    for (size_t tree = 0; tree < ntrees; tree++)
+    {
+        size_t curr_bytes = tree_bytes(tree);
+        total_bytes += curr_bytes;
+        if (block_bytes && block_bytes + curr_bytes > cache_size / 2)
+        {
+            tree_blocks.push_back(tree);
+            block_bytes = 0;
+        }
+        block_bytes += curr_bytes;
+    }
+    tree_blocks.push_back(ntrees);
+
+    if (total_bytes <= cache_size)
+        return false;
+
+    row_block = (cache_size / 4) / std::max(row_bytes, (size_t)sizeof(double));
+    row_block = std::max(MIN_ROWS_PER_BLOCK, std::min(MAX_ROWS_PER_BLOCK, row_block));
+    if (nthreads > 1)
+    {
+        size_t rows_per_thread = (nrows + (size_t)nthreads - 1) / (size_t)nthreads;
+        row_block = std::max(MIN_ROWS_PER_BLOCK, std::min(row_block, rows_per_thread));
+    }
+    return true;
+}
+
+bool get_tree_blocks(const IsoForest &model, size_t nrows, size_t row_bytes, int nthreads,
+                     std::vector<size_t> &tree_blocks, size_t &row_block)
+{
+    auto tree_bytes = [&model](size_t tree) {return get_tree_bytes(model.trees[tree]);};
+    return get_tree_blocks_internal(model.trees.size(), tree_bytes, nrows, row_bytes, nthreads,
+                                    tree_blocks, row_block);
+}
+
+bool get_tree_blocks(const ExtIsoForest &model, size_t nrows, size_t row_bytes, int nthreads,
+                     std::vector<size_t> &tree_blocks, size_t &row_block)
+{
+    auto tree_bytes = [&model](size_t tree) {return get_tree_bytes(model.hplanes[tree]);};
+    return get_tree_blocks_internal(model.hplanes.size(), tree_bytes, nrows, row_bytes, nthreads,
+                                    tree_blocks, row_block);
+}
+
+bool get_tree_blocks(const CompiledIsoForest &compiled, size_t nrows, size_t row_bytes, int nthreads,
+                     std::vector<size_t> &tree_blocks, size_t &row_block)
+{
+    const size_t node_bytes = 2 * sizeof(uint32_t) + sizeof(double)
+                              + (compiled.float_thresholds? sizeof(float) : sizeof(double));
+    auto tree_bytes = [&compiled, node_bytes](size_t tree)
+    {
+        return (compiled.tree_offsets[tree + 1] - compiled.tree_offsets[tree]) * node_bytes;
+    };
+    return get_tree_blocks_internal(compiled.tree_offsets.size() - 1, tree_bytes, nrows, row_bytes, nthreads,
+                                    tree_blocks, row_block);
+}
+
+bool get_tree_blocks(const CompiledExtIsoForest &compiled, size_t nrows, size_t row_bytes, int nthreads,
+                     std::vector<size_t> &tree_blocks, size_t &row_block)
+{
+    const size_t node_bytes = (compiled.ndim + 2) * sizeof(uint32_t) + (2 * compiled.ndim + 1) * sizeof(double);
+    auto tree_bytes = [&compiled, node_bytes](size_t tree)
+    {
+        return (compiled.tree_offsets[tree + 1] - compiled.tree_offsets[tree]) * node_bytes;
+    };
+    return get_tree_blocks_internal(compiled.tree_offsets.size() - 1, tree_bytes, nrows, row_bytes, nthreads,
+                                    tree_blocks, row_block);
+}
@@ -0,0 +1,394 @@
+/*    Isolation forests and variations thereof, with adjustments for incorporation
+*     of categorical variables and missing values.
+*     Writen for C++11 standard and aimed at being used in R and Python.
+*     
+*     This library is based on the following works:
+*     [1] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation forest."
+*         2008 Eighth IEEE International Conference on Data Mining. IEEE, 2008.
+*     [2] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation-based anomaly detection."
+*         ACM Transactions on Knowledge Discovery from Data (TKDD) 6.1 (2012): 3.
+*     [3] Hariri, Sahand, Matias Carrasco Kind, and Robert J. Brunner.
+*         "Extended Isolation Forest."
+*         arXiv preprint arXiv:1811.02141 (2018).
+*     [4] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "On detecting clustered anomalies using SCiForest."
+*         Joint European Conference on Machine Learning and Knowledge Discovery in Databases. Springer, Berlin, Heidelberg, 2010.
+*     [5] https://sourceforge.net/projects/iforest/
+*     [6] https://math.stackexchange.com/questions/3388518/expected-number-of-paths-required-to-separate-elements-in-a-binary-tree
+*     [7] Quinlan, J. Ross. C4. 5: programs for machine learning. Elsevier, 2014.
+*     [8] Cortes, David.
+*         "Distance approximation using Isolation Forests."
+*         arXiv preprint arXiv:1910.12362 (2019).
+*     [9] Cortes, David.
+*         "Imputing missing values with unsupervised random trees."
+*         arXiv preprint arXiv:1911.06646 (2019).
+*     [10] https://math.stackexchange.com/questions/3333220/expected-average-depth-in-random-binary-tree-constructed-top-to-bottom
+*     [11] Cortes, David.
+*          "Revisiting randomized choices in isolation forests."
+*          arXiv preprint arXiv:2110.13402 (2021).
+*     [12] Guha, Sudipto, et al.
+*          "Robust random cut forest based anomaly detection on streams."
+*          International conference on machine learning. PMLR, 2016.
+*     [13] Cortes, David.
+*          "Isolation forests: looking beyond tree depth."
+*          arXiv preprint arXiv:2111.11639 (2021).
+*     [14] Ting, Kai Ming, Yue Zhu, and Zhi-Hua Zhou.
+*          "Isolation kernel and its effect on SVM"
+*          Proceedings of the 24th ACM SIGKDD
+*          International Conference on Knowledge Discovery & Data Mining. 2018.
+* 
+*     BSD 2-Clause License
+*     Copyright (c) 2019-2022, David Cortes
+*     All rights reserved.
+*     Redistribution and use in source and binary forms, with or without
+*     modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this
+*       list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*       this list of conditions and the following disclaimer in the documentation
+*       and/or other materials provided with the distribution.
+*     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+*     AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+*     IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*     FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*     DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*     SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*     CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*     OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*     OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "isotree.hpp"
+
+/* Thresholds are rounded towards minus infinity, so that comparisons 'x <= split' on
+   'float' inputs give exactly the same result as comparing them against the original
+   'double' thresholds. Rounding towards plus infinity does the same for 'x < split'. */
+float round_threshold_down(double num_split) noexcept
+{
+    float out = (float)num_split;
+    if ((double)out > num_split)
+        out = std::nextafter(out, -HUGE_VALF);
+    return out;
+}
+
+float round_threshold_up(double num_split) noexcept
+{
+    float out = (float)num_split;
+    if ((double)out < num_split)
+        out = std::nextafter(out, HUGE_VALF);
+    return out;
+}
+
+static void compile_single_tree(CompiledIsoForest &compiled, const std::vector<IsoTree> &tree,
+                                uint32_t *restrict new_pos, size_t offset) noexcept
+{
+    uint32_t *restrict col_num = compiled.col_num.data() + offset;
+    uint32_t *restrict tree_left = compiled.tree_left.data() + offset;
+    double *restrict score = compiled.score.data() + offset;
+    double *restrict num_split = compiled.float_thresholds? NULL : (compiled.num_split.data() + offset);
+    float *restrict num_split_f = compiled.float_thresholds? (compiled.num_split_f.data() + offset) : NULL;
+
+    /* Nodes in the original trees are in depth-first order, so parents always come before
+       their children, and a single pass is enough to assign new positions to every node. */
+    uint32_t next_pos = 1;
+    uint32_t n_terminal = 0;
+    new_pos[0] = 0;
+    for (size_t node = 0; node < tree.size(); node++)
+    {
+        uint32_t pos = new_pos[node];
+        score[pos] = tree[node].score;
+
+        if (tree[node].tree_left == 0)
+        {
+            col_num[pos] = n_terminal++;
+            tree_left[pos] = 0;
+            if (num_split != NULL)
+                num_split[pos] = 0;
+            else
+                num_split_f[pos] = 0;
+        }
+
+        else
+        {
+            new_pos[tree[node].tree_left] = next_pos;
+            new_pos[tree[node].tree_right] = next_pos + 1;
+            col_num[pos] = (uint32_t)tree[node].col_num;
+            tree_left[pos] = next_pos;
+            if (num_split != NULL)
+                num_split[pos] = tree[node].num_split;
+            else
+                num_split_f[pos] = round_threshold_down(tree[node].num_split);
+            next_pos += 2;
+        }
+    }
+}
+
+/* Build a flattened version of a single-variable model for faster predictions
+* 
+* Parameters
+* ==========
+* - compiled (out)
+*       Object where the flattened model will be stored. Any previous contents will be overwritten.
+* - model
+*       Single-variable isolation forest model which has already been fit through 'fit_iforest'.
+*       Must have been fit to numeric-only data, with 'missing_action=Fail' and without range penalty.
+* - float_thresholds
+*       Whether to store the split thresholds as 'float' instead of 'double', which reduces the
+*       memory usage. Thresholds are rounded down, so that predictions on 'float' data are exactly
+*       the same as when using 'double' thresholds, but predictions on 'double' data might differ
+*       when values fall very close to a split threshold.
+* - nthreads
+*       Number of parallel threads to use.
+*/
+void build_compiled_forest(CompiledIsoForest &compiled, const IsoForest &model, bool float_thresholds, int nthreads)
+{
+    if (model.missing_action != Fail)
+        throw std::runtime_error("Compiled forests are only supported for models with 'missing_action=Fail'.\n");
+    if (model.has_range_penalty)
+        throw std::runtime_error("Compiled forests are not supported for models with range penalty.\n");
+
+    size_t ntrees = model.trees.size();
+    std::vector<size_t> tree_offsets(ntrees + 1);
+    size_t ncols_numeric = 0;
+    tree_offsets[0] = 0;
+    for (size_t tree = 0; tree < ntrees; tree++)
+    {
+        if (unlikely(model.trees[tree].size() >= (size_t)UINT32_MAX))
+            throw std::runtime_error("Model has trees that are too large for compiling.\n");
+        for (const IsoTree &node : model.trees[tree])
+        {
+            if (node.tree_left == 0) continue;
+            if (node.col_type != Numeric)
+                throw std::runtime_error("Compiled forests are only supported for models without categorical columns.\n");
+            ncols_numeric = std::max(ncols_numeric, node.col_num + 1);
+        }
+        tree_offsets[tree+1] = tree_offsets[tree] + model.trees[tree].size();
+    }
+    if (unlikely(ncols_numeric > (size_t)UINT32_MAX))
+        throw std::runtime_error("Model has too many columns for compiling.\n");
+
+    size_t tot_nodes = tree_offsets.back();
+    compiled.col_num.resize(tot_nodes);
+    compiled.tree_left.resize(tot_nodes);
+    compiled.score.resize(tot_nodes);
+    if (float_thresholds) {
+        compiled.num_split.clear();
+        compiled.num_split_f.resize(tot_nodes);
+    }
+    else {
+        compiled.num_split_f.clear();
+        compiled.num_split.resize(tot_nodes);
+    }
+    compiled.num_split.shrink_to_fit();
+    compiled.num_split_f.shrink_to_fit();
+    compiled.tree_offsets = std::move(tree_offsets);
+    compiled.scoring_metric = model.scoring_metric;
+    compiled.exp_avg_depth = model.exp_avg_depth;
+    compiled.ncols_numeric = ncols_numeric;
+    compiled.float_thresholds = float_thresholds;
+
+    std::unique_ptr<uint32_t[]> new_pos(new uint32_t[tot_nodes]);
+    auto compile_tree = [&](size_t tree, int thread_id)
+    {
+        (void)thread_id;
+        compile_single_tree(compiled, model.trees[tree],
+                            new_pos.get() + compiled.tree_offsets[tree],
+                            compiled.tree_offsets[tree]);
+    };
+    run_parallel_for(get_thread_executor(), ntrees, nthreads, true, compile_tree);
+}
+
+static void compile_single_tree(CompiledExtIsoForest &compiled, const std::vector<IsoHPlane> &hplane,
+                                uint32_t *restrict new_pos, size_t offset) noexcept
+{
+    const size_t ndim = compiled.ndim;
+    const size_t idx_stride = ndim + 2;
+    const size_t val_stride = 2 * ndim + 1;
+    uint32_t *restrict node_idx = compiled.node_idx.data() + offset * idx_stride;
+    double *restrict node_val = compiled.node_val.data() + offset * val_stride;
+
+    uint32_t next_pos = 1;
+    uint32_t n_terminal = 0;
+    new_pos[0] = 0;
+    for (size_t node = 0; node < hplane.size(); node++)
+    {
+        uint32_t *restrict idx = node_idx + (size_t)new_pos[node] * idx_stride;
+        double *restrict val = node_val + (size_t)new_pos[node] * val_stride;
+
+        if (hplane[node].hplane_left == 0)
+        {
+            idx[0] = 0;
+            idx[1] = n_terminal++;
+            val[0] = hplane[node].score;
+        }
+
+        else
+        {
+            new_pos[hplane[node].hplane_left] = next_pos;
+            new_pos[hplane[node].hplane_right] = next_pos + 1;
+            idx[0] = next_pos;
+            idx[1] = (uint32_t)hplane[node].col_num.size();
+            val[0] = hplane[node].split_point;
+            for (size_t col = 0; col < hplane[node].col_num.size(); col++)
+            {
+                idx[col + 2] = (uint32_t)hplane[node].col_num[col];
+                val[col + 1] = hplane[node].coef[col];
+                val[col + 1 + ndim] = hplane[node].mean[col];
+            }
+            next_pos += 2;
+        }
+    }
+}
+
+/* Build a flattened version of an extended model for faster predictions
+* 
+* Parameters
+* ==========
+* - compiled (out)
+*       Object where the flattened model will be stored. Any previous contents will be overwritten.
+* - model
+*       Extended isolation forest model which has already been fit through 'fit_iforest'.
+*       Must have been fit to numeric-only data, with 'missing_action=Fail' and without range penalty.
+* - nthreads
+*       Number of parallel threads to use.
+*/
+void build_compiled_forest(CompiledExtIsoForest &compiled, const ExtIsoForest &model, int nthreads)
+{
+    if (model.missing_action != Fail)
+        throw std::runtime_error("Compiled forests are only supported for models with 'missing_action=Fail'.\n");
+    if (model.has_range_penalty)
+        throw std::runtime_error("Compiled forests are not supported for models with range penalty.\n");
+
+    size_t ntrees = model.hplanes.size();
+    std::vector<size_t> tree_offsets(ntrees + 1);
+    size_t ncols_numeric = 0;
+    size_t ndim = 1;
+    tree_offsets[0] = 0;
+    for (size_t tree = 0; tree < ntrees; tree++)
+    {
+        if (unlikely(model.hplanes[tree].size() >= (size_t)UINT32_MAX))
+            throw std::runtime_error("Model has trees that are too large for compiling.\n");
+        for (const IsoHPlane &node : model.hplanes[tree])
+        {
+            if (node.hplane_left == 0) continue;
+            for (size_t col = 0; col < node.col_num.size(); col++)
+            {
+                if (node.col_type[col] != Numeric)
+                    throw std::runtime_error("Compiled forests are only supported for models without categorical columns.\n");
+                ncols_numeric = std::max(ncols_numeric, node.col_num[col] + 1);
+            }
+            ndim = std::max(ndim, node.col_num.size());
+        }
+        tree_offsets[tree+1] = tree_offsets[tree] + model.hplanes[tree].size();
+    }
+    if (unlikely(ncols_numeric > (size_t)UINT32_MAX))
+        throw std::runtime_error("Model has too many columns for compiling.\n");
+
+    size_t tot_nodes = tree_offsets.back();
+    compiled.node_idx.assign(tot_nodes * (ndim + 2), 0);
+    compiled.node_val.assign(tot_nodes * (2 * ndim + 1), 0);
+    compiled.tree_offsets = std::move(tree_offsets);
+    compiled.scoring_metric = model.scoring_metric;
+    compiled.exp_avg_depth = model.exp_avg_depth;
+    compiled.ncols_numeric = ncols_numeric;
+    compiled.ndim = ndim;
+
+    std::unique_ptr<uint32_t[]> new_pos(new uint32_t[tot_nodes]);
+    auto compile_tree = [&](size_t tree, int thread_id)
+    {
+        (void)thread_id;
+        compile_single_tree(compiled, model.hplanes[tree],
+                            new_pos.get() + compiled.tree_offsets[tree],
+                            compiled.tree_offsets[tree]);
+    };
+    run_parallel_for(get_thread_executor(), ntrees, nthreads, true, compile_tree);
+}
+
+/* Compiling a forest has a cost proportional to the number of nodes, while predictions have a
+   cost proportional to the number of rows times the depth of the trees. In practice, compiling
+   takes about as long as traversing each tree with a handful of rows, and traversal of the
+   compiled trees is several times faster, so it pays off already with small batches. The
+   program 'timings/compiled_dispatch_benchmark.cpp' compares both: compiling on each call
+   starts winning at around one row per 4 nodes in a tree for single-variable models, and
+   one row per 8 nodes for extended models, whose nodes are slower to traverse. */
+bool should_use_compiled_forest(const IsoForest &model, size_t nrows)
+{
+    if (nrows < 16 || model.trees.empty() || model.missing_action != Fail || model.has_range_penalty)
+        return false;
+    size_t tot_nodes = 0;
+    for (const auto &tree : model.trees)
+        tot_nodes += tree.size();
+    return 4 * nrows >= tot_nodes / model.trees.size() && has_only_numeric_splits(model);
+}
+
+bool should_use_compiled_forest(const ExtIsoForest &model, size_t nrows)
+{
+    if (nrows < 16 || model.hplanes.empty() || model.missing_action != Fail || model.has_range_penalty)
+        return false;
+    size_t tot_nodes = 0;
+    for (const auto &tree : model.hplanes)
+        tot_nodes += tree.size();
+    return 8 * nrows >= tot_nodes / model.hplanes.size() && has_only_numeric_splits(model);
+}
+
+bool has_only_numeric_splits(const IsoForest &model) noexcept
+{
+    for (const auto &tree : model.trees)
+    {
+        for (const IsoTree &node : tree)
+        {
+            if (node.tree_left != 0 && node.col_type != Numeric)
+                return false;
+        }
+    }
+    return true;
+}
+
+bool has_only_numeric_splits(const ExtIsoForest &model) noexcept
+{
+    for (const auto &tree : model.hplanes)
+    {
+        for (const IsoHPlane &node : tree)
+        {
+            for (ColType col_type : node.col_type)
+            {
+                if (col_type != Numeric)
+                    return false;
+            }
+        }
+    }
+    return true;
+}
+
+size_t get_max_numeric_col(const IsoForest &model) noexcept
+{
+    size_t max_col = 0;
+    for (const auto &tree : model.trees)
+    {
+        for (const IsoTree &node : tree)
+        {
+            if (node.tree_left && node.col_type == Numeric)
+                max_col = std::max(max_col, node.col_num);
+        }
+    }
+    return max_col;
+}
+
+size_t get_max_numeric_col(const ExtIsoForest &model) noexcept
+{
+    size_t max_col = 0;
+    for (const auto &tree : model.hplanes)
+    {
+        for (const IsoHPlane &node : tree)
+        {
+            for (size_t col = 0; col < node.col_num.size(); col++)
+            {
+                if (node.col_type[col] == Numeric)
+                    max_col = std::max(max_col, node.col_num[col]);
+            }
+        }
+    }
+    return max_col;
+}
@@ -0,0 +1,380 @@
+/*    Isolation forests and variations thereof, with adjustments for incorporation
+*     of categorical variables and missing values.
+*     Writen for C++11 standard and aimed at being used in R and Python.
+*     
+*     This library is based on the following works:
+*     [1] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation forest."
+*         2008 Eighth IEEE International Conference on Data Mining. IEEE, 2008.
+*     [2] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation-based anomaly detection."
+*         ACM Transactions on Knowledge Discovery from Data (TKDD) 6.1 (2012): 3.
+*     [3] Hariri, Sahand, Matias Carrasco Kind, and Robert J. Brunner.
+*         "Extended Isolation Forest."
+*         arXiv preprint arXiv:1811.02141 (2018).
+*     [4] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "On detecting clustered anomalies using SCiForest."
+*         Joint European Conference on Machine Learning and Knowledge Discovery in Databases. Springer, Berlin, Heidelberg, 2010.
+*     [5] https://sourceforge.net/projects/iforest/
+*     [6] https://math.stackexchange.com/questions/3388518/expected-number-of-paths-required-to-separate-elements-in-a-binary-tree
+*     [7] Quinlan, J. Ross. C4. 5: programs for machine learning. Elsevier, 2014.
+*     [8] Cortes, David.
+*         "Distance approximation using Isolation Forests."
+*         arXiv preprint arXiv:1910.12362 (2019).
+*     [9] Cortes, David.
+*         "Imputing missing values with unsupervised random trees."
+*         arXiv preprint arXiv:1911.06646 (2019).
+*     [10] https://math.stackexchange.com/questions/3333220/expected-average-depth-in-random-binary-tree-constructed-top-to-bottom
+*     [11] Cortes, David.
+*          "Revisiting randomized choices in isolation forests."
+*          arXiv preprint arXiv:2110.13402 (2021).
+*     [12] Guha, Sudipto, et al.
+*          "Robust random cut forest based anomaly detection on streams."
+*          International conference on machine learning. PMLR, 2016.
+*     [13] Cortes, David.
+*          "Isolation forests: looking beyond tree depth."
+*          arXiv preprint arXiv:2111.11639 (2021).
+*     [14] Ting, Kai Ming, Yue Zhu, and Zhi-Hua Zhou.
+*          "Isolation kernel and its effect on SVM"
+*          Proceedings of the 24th ACM SIGKDD
+*          International Conference on Knowledge Discovery & Data Mining. 2018.
+* 
+*     BSD 2-Clause License
+*     Copyright (c) 2019-2022, David Cortes
+*     All rights reserved.
+*     Redistribution and use in source and binary forms, with or without
+*     modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this
+*       list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*       this list of conditions and the following disclaimer in the documentation
+*       and/or other materials provided with the distribution.
+*     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+*     AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+*     IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*     FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*     DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*     SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*     CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*     OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*     OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "isotree.hpp"
+
+/* Vectorized traversal of compiled forests, which advances several rows through the same
+   tree at once, using gathers for the node arrays and for the data. Lanes that already
+   reached a terminal node are kept in place through the comparison masks until all of
+   the lanes in the block have finished. The scores are accumulated per lane in the same
+   order as in the scalar version, so results are exactly the same.
+
+   The kernels are compiled for the instruction sets that they use through function
+   attributes, and selected at runtime according to what the CPU supports, so the
+   library doesn't need to be built with '-march=native' in order to use them. */
+#if defined(__GNUC__) && defined(__x86_64__) && !defined(ISOTREE_NO_SIMD)
+#   define ISOTREE_X86_KERNELS
+#   include <immintrin.h>
+#endif
+
+#ifdef ISOTREE_X86_KERNELS
+
+enum SimdLevel {NoSimd = 0, SimdAVX2 = 1, SimdAVX512 = 2};
+
+static SimdLevel detect_simd_level() noexcept
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return SimdAVX512;
+    if (__builtin_cpu_supports("avx2"))
+        return SimdAVX2;
+    return NoSimd;
+}
+
+static SimdLevel get_simd_level() noexcept
+{
+    static const SimdLevel simd_level = detect_simd_level();
+    return simd_level;
+}
+
+/* Each of these kernels traverses one tree for a group of rows, with one row per lane,
+   writing the score of the terminal node for each lane into 'tree_depths'. Rows are
+   indexed relative to 'row_numeric_data', which points at the first row in the group. */
+
+[[gnu::target("avx2")]]
+static void traverse_group_avx2(const uint32_t *restrict tree_left_, const uint32_t *restrict col_num_,
+                                const double *restrict split, const double *restrict score,
+                                const double *restrict row_numeric_data, const long long *restrict row_offsets,
+                                size_t col_stride, double *restrict tree_depths) noexcept
+{
+    const int *restrict tree_left = (const int*)tree_left_;
+    const int *restrict col_num = (const int*)col_num_;
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i all_ones = _mm256_set1_epi64x(-1);
+    const __m256i stride = _mm256_set1_epi64x((long long)col_stride);
+    const __m256i row_offset = _mm256_load_si256((const __m256i*)row_offsets);
+    __m256i node = zero;
+
+    while (true)
+    {
+        __m256i left = _mm256_cvtepu32_epi64(_mm256_i64gather_epi32(tree_left, node, 4));
+        __m256i active = _mm256_xor_si256(_mm256_cmpeq_epi64(left, zero), all_ones);
+        if (_mm256_testz_si256(active, active)) break;
+        __m256i col = _mm256_cvtepu32_epi64(_mm256_i64gather_epi32(col_num, node, 4));
+        __m256i ix = _mm256_add_epi64(row_offset, _mm256_mul_epu32(col, stride));
+        __m256d x = _mm256_mask_i64gather_pd(_mm256_setzero_pd(), row_numeric_data, ix,
+                                             _mm256_castsi256_pd(active), 8);
+        __m256d thr = _mm256_i64gather_pd(split, node, 8);
+        /* negated comparison, so that NaNs go to the right like in the scalar version */
+        __m256i go_right = _mm256_castpd_si256(_mm256_cmp_pd(x, thr, _CMP_NLE_UQ));
+        node = _mm256_blendv_epi8(node, _mm256_sub_epi64(left, go_right), active);
+    }
+
+    _mm256_store_pd(tree_depths, _mm256_i64gather_pd(score, node, 8));
+}
+
+[[gnu::target("avx2")]]
+static void traverse_group_avx2(const uint32_t *restrict tree_left_, const uint32_t *restrict col_num_,
+                                const float *restrict split, const double *restrict score,
+                                const float *restrict row_numeric_data, const int *restrict row_offsets,
+                                size_t col_stride, double *restrict tree_depths) noexcept
+{
+    const int *restrict tree_left = (const int*)tree_left_;
+    const int *restrict col_num = (const int*)col_num_;
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i all_ones = _mm256_set1_epi32(-1);
+    const __m256i stride = _mm256_set1_epi32((int)col_stride);
+    const __m256i row_offset = _mm256_load_si256((const __m256i*)row_offsets);
+    __m256i node = zero;
+
+    while (true)
+    {
+        __m256i left = _mm256_i32gather_epi32(tree_left, node, 4);
+        __m256i active = _mm256_xor_si256(_mm256_cmpeq_epi32(left, zero), all_ones);
+        if (_mm256_testz_si256(active, active)) break;
+        __m256i col = _mm256_i32gather_epi32(col_num, node, 4);
+        __m256i ix = _mm256_add_epi32(row_offset, _mm256_mullo_epi32(col, stride));
+        __m256 x = _mm256_mask_i32gather_ps(_mm256_setzero_ps(), row_numeric_data, ix,
+                                            _mm256_castsi256_ps(active), 4);
+        __m256 thr = _mm256_i32gather_ps(split, node, 4);
+        __m256i go_right = _mm256_castps_si256(_mm256_cmp_ps(x, thr, _CMP_NLE_UQ));
+        node = _mm256_blendv_epi8(node, _mm256_sub_epi32(left, go_right), active);
+    }
+
+    const __m256d all_lanes = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+    _mm256_store_pd(tree_depths, _mm256_mask_i32gather_pd(_mm256_setzero_pd(), score, _mm256_castsi256_si128(node),
+                                                          all_lanes, 8));
+    _mm256_store_pd(tree_depths + 4, _mm256_mask_i32gather_pd(_mm256_setzero_pd(), score, _mm256_extracti128_si256(node, 1),
+                                                              all_lanes, 8));
+}
+
+[[gnu::target("avx512f")]]
+static void traverse_group_avx512(const uint32_t *restrict tree_left_, const uint32_t *restrict col_num_,
+                                  const double *restrict split, const double *restrict score,
+                                  const double *restrict row_numeric_data, const long long *restrict row_offsets,
+                                  size_t col_stride, double *restrict tree_depths) noexcept
+{
+    const int *restrict tree_left = (const int*)tree_left_;
+    const int *restrict col_num = (const int*)col_num_;
+    const __mmask8 all_lanes = 0xff;
+    const __m512i one = _mm512_set1_epi64(1);
+    const __m512i stride = _mm512_set1_epi64((long long)col_stride);
+    const __m512i row_offset = _mm512_load_si512(row_offsets);
+    __m512i node = _mm512_setzero_si512();
+
+    while (true)
+    {
+        __m512i left = _mm512_maskz_cvtepu32_epi64(all_lanes,
+                                                   _mm512_mask_i64gather_epi32(_mm256_setzero_si256(), all_lanes,
+                                                                               node, tree_left, 4));
+        __mmask8 active = _mm512_test_epi64_mask(left, left);
+        if (!active) break;
+        __m512i col = _mm512_maskz_cvtepu32_epi64(all_lanes,
+                                                  _mm512_mask_i64gather_epi32(_mm256_setzero_si256(), active,
+                                                                              node, col_num, 4));
+        __m512i ix = _mm512_add_epi64(row_offset, _mm512_maskz_mul_epu32(all_lanes, col, stride));
+        __m512d x = _mm512_mask_i64gather_pd(_mm512_setzero_pd(), active, ix, row_numeric_data, 8);
+        __m512d thr = _mm512_mask_i64gather_pd(_mm512_setzero_pd(), active, node, split, 8);
+        __mmask8 go_right = _mm512_mask_cmp_pd_mask(active, x, thr, _CMP_NLE_UQ);
+        node = _mm512_mask_mov_epi64(node, active, _mm512_mask_add_epi64(left, go_right, left, one));
+    }
+
+    _mm512_store_pd(tree_depths, _mm512_mask_i64gather_pd(_mm512_setzero_pd(), all_lanes, node, score, 8));
+}
+
+[[gnu::target("avx512f")]]
+static void traverse_group_avx512(const uint32_t *restrict tree_left_, const uint32_t *restrict col_num_,
+                                  const float *restrict split, const double *restrict score,
+                                  const float *restrict row_numeric_data, const int *restrict row_offsets,
+                                  size_t col_stride, double *restrict tree_depths) noexcept
+{
+    const int *restrict tree_left = (const int*)tree_left_;
+    const int *restrict col_num = (const int*)col_num_;
+    const __m512i zero = _mm512_setzero_si512();
+    const __mmask16 all_lanes = 0xffff;
+    const __m512i one = _mm512_set1_epi32(1);
+    const __m512i stride = _mm512_set1_epi32((int)col_stride);
+    const __m512i row_offset = _mm512_load_si512(row_offsets);
+    __m512i node = zero;
+
+    while (true)
+    {
+        __m512i left = _mm512_mask_i32gather_epi32(zero, all_lanes, node, tree_left, 4);
+        __mmask16 active = _mm512_test_epi32_mask(left, left);
+        if (!active) break;
+        __m512i col = _mm512_mask_i32gather_epi32(zero, active, node, col_num, 4);
+        __m512i ix = _mm512_add_epi32(row_offset, _mm512_mullo_epi32(col, stride));
+        __m512 x = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), active, ix, row_numeric_data, 4);
+        __m512 thr = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), active, node, split, 4);
+        __mmask16 go_right = _mm512_mask_cmp_ps_mask(active, x, thr, _CMP_NLE_UQ);
+        node = _mm512_mask_mov_epi32(node, active, _mm512_mask_add_epi32(left, go_right, left, one));
+    }
+
+    _mm512_store_pd(tree_depths, _mm512_mask_i32gather_pd(_mm512_setzero_pd(), (__mmask8)0xff,
+                                                          _mm512_maskz_extracti64x4_epi64((__mmask8)0xf, node, 0),
+                                                          score, 8));
+    _mm512_store_pd(tree_depths + 8, _mm512_mask_i32gather_pd(_mm512_setzero_pd(), (__mmask8)0xff,
+                                                              _mm512_maskz_extracti64x4_epi64((__mmask8)0xf, node, 1),
+                                                              score, 8));
+}
+
+/* Rows are processed in blocks, and within a block, each tree is traversed for all of the
+   rows before moving on to the next tree, so that the upper levels of the tree stay in cache.
+   Depths are still summed in the same order as in the scalar version. When the last group
+   in a block has fewer rows than lanes, the remaining lanes repeat its last row, and their
+   results are discarded. */
+template <SimdLevel simd_level, class real_t>
+static void predict_block_simd(const real_t *restrict numeric_data, size_t row_stride, size_t col_stride,
+                               size_t row_st, size_t row_end,
+                               const CompiledIsoForest &compiled, const real_t *restrict num_split,
+                               double *restrict output_depths, double *restrict per_tree_depths) noexcept
+{
+    typedef typename std::conditional<std::is_same<real_t, float>::value, int, long long>::type ix_t;
+    constexpr size_t n_lanes = ((simd_level == SimdAVX512)? 64 : 32) / sizeof(real_t);
+    const size_t ntrees = compiled.tree_offsets.size() - 1;
+    alignas(64) ix_t row_offsets[n_lanes];
+    alignas(64) ix_t row_offsets_last[n_lanes];
+    alignas(64) double tree_depths[n_lanes];
+
+    const size_t n_last = (row_end - row_st) % n_lanes;
+    for (size_t lane = 0; lane < n_lanes; lane++)
+    {
+        row_offsets[lane] = (ix_t)(lane * row_stride);
+        row_offsets_last[lane] = (ix_t)(std::min(lane, n_last? (n_last - 1) : 0) * row_stride);
+    }
+
+    std::fill(output_depths + row_st, output_depths + row_end, 0.);
+    for (size_t tree = 0; tree < ntrees; tree++)
+    {
+        const size_t st = compiled.tree_offsets[tree];
+        for (size_t row = row_st; row < row_end; row += n_lanes)
+        {
+            const size_t n_valid = std::min(n_lanes, row_end - row);
+            const ix_t *restrict offsets = (n_valid == n_lanes)? row_offsets : row_offsets_last;
+            if (simd_level == SimdAVX512)
+                traverse_group_avx512(compiled.tree_left.data() + st, compiled.col_num.data() + st,
+                                      num_split + st, compiled.score.data() + st,
+                                      numeric_data + row * row_stride, offsets, col_stride, tree_depths);
+            else
+                traverse_group_avx2(compiled.tree_left.data() + st, compiled.col_num.data() + st,
+                                    num_split + st, compiled.score.data() + st,
+                                    numeric_data + row * row_stride, offsets, col_stride, tree_depths);
+
+            for (size_t lane = 0; lane < n_valid; lane++)
+                output_depths[row + lane] += tree_depths[lane];
+            if (unlikely(per_tree_depths != NULL))
+            {
+                for (size_t lane = 0; lane < n_valid; lane++)
+                    per_tree_depths[tree + (row + lane) * ntrees] = tree_depths[lane];
+            }
+        }
+    }
+}
+
+/* The 'float' kernels use 32-bit indices for both the nodes and the data, while the
+   'double' ones use 64-bit indices for the data but multiply the column numbers with
+   32-bit operations. */
+template <class real_t>
+static bool can_use_simd_kernel(size_t row_stride, size_t col_stride, size_t n_lanes,
+                                const CompiledIsoForest &compiled) noexcept
+{
+    if (col_stride > (size_t)INT32_MAX || row_stride > (size_t)INT32_MAX)
+        return false;
+    size_t max_tree_size = 0;
+    for (size_t tree = 0; tree < compiled.tree_offsets.size() - 1; tree++)
+        max_tree_size = std::max(max_tree_size, compiled.tree_offsets[tree+1] - compiled.tree_offsets[tree]);
+    if (max_tree_size > (size_t)INT32_MAX)
+        return false;
+    if (std::is_same<real_t, float>::value)
+    {
+        size_t max_ix = (n_lanes - 1) * row_stride;
+        if (compiled.ncols_numeric)
+            max_ix += (compiled.ncols_numeric - 1) * col_stride;
+        if (max_ix > (size_t)INT32_MAX)
+            return false;
+    }
+    return true;
+}
+
+template <class real_t>
+static bool predict_compiled_rows_simd_internal(const real_t *numeric_data, size_t row_stride, size_t col_stride,
+                                                size_t nrows, int nthreads,
+                                                const CompiledIsoForest &compiled, const real_t *num_split,
+                                                double *output_depths, double *per_tree_depths)
+{
+    const SimdLevel simd_level = get_simd_level();
+    if (simd_level == NoSimd)
+        return false;
+    const size_t n_lanes = ((simd_level == SimdAVX512)? 64 : 32) / sizeof(real_t);
+    if (!can_use_simd_kernel<real_t>(row_stride, col_stride, n_lanes, compiled))
+        return false;
+
+    const size_t block_size = 256;
+    const size_t n_blocks = (nrows + block_size - 1) / block_size;
+    auto predict_block = [&](size_t block, int thread_id)
+    {
+        (void)thread_id;
+        size_t row_st = block * block_size;
+        size_t row_end = std::min(nrows, row_st + block_size);
+        if (simd_level == SimdAVX512)
+            predict_block_simd<SimdAVX512>(numeric_data, row_stride, col_stride, row_st, row_end,
+                                           compiled, num_split, output_depths, per_tree_depths);
+        else
+            predict_block_simd<SimdAVX2>(numeric_data, row_stride, col_stride, row_st, row_end,
+                                         compiled, num_split, output_depths, per_tree_depths);
+    };
+    run_parallel_for(get_thread_executor(), n_blocks, nthreads, false, predict_block);
+    return true;
+}
+
+#endif /* ISOTREE_X86_KERNELS */
+
+/* Predict the sum of depths for a compiled forest using vectorized kernels, with the same
+   outputs as 'predict_compiled_forest' (without terminal node numbers).
+   Will return 'false' without doing anything if the CPU doesn't support any of the
+   instruction sets for which there are kernels, or if the data is too large for the
+   indices used by the gathers, in which case the scalar version should be used. */
+bool predict_compiled_rows_simd(const double *numeric_data, size_t row_stride, size_t col_stride,
+                                size_t nrows, int nthreads,
+                                const CompiledIsoForest &compiled, const double *num_split,
+                                double *output_depths, double *per_tree_depths)
+{
+    #ifdef ISOTREE_X86_KERNELS
+    return predict_compiled_rows_simd_internal(numeric_data, row_stride, col_stride, nrows, nthreads,
+                                               compiled, num_split, output_depths, per_tree_depths);
+    #else
+    return false;
+    #endif
+}
+
+bool predict_compiled_rows_simd(const float *numeric_data, size_t row_stride, size_t col_stride,
+                                size_t nrows, int nthreads,
+                                const CompiledIsoForest &compiled, const float *num_split,
+                                double *output_depths, double *per_tree_depths)
+{
+    #ifdef ISOTREE_X86_KERNELS
+    return predict_compiled_rows_simd_internal(numeric_data, row_stride, col_stride, nrows, nthreads,
+                                               compiled, num_split, output_depths, per_tree_depths);
+    #else
+    return false;
+    #endif
+}
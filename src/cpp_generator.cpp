@@ -0,0 +1,505 @@
+/*    Isolation forests and variations thereof, with adjustments for incorporation
+*     of categorical variables and missing values.
+*     Writen for C++11 standard and aimed at being used in R and Python.
+*     
+*     This library is based on the following works:
+*     [1] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation forest."
+*         2008 Eighth IEEE International Conference on Data Mining. IEEE, 2008.
+*     [2] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation-based anomaly detection."
+*         ACM Transactions on Knowledge Discovery from Data (TKDD) 6.1 (2012): 3.
+*     [3] Hariri, Sahand, Matias Carrasco Kind, and Robert J. Brunner.
+*         "Extended Isolation Forest."
+*         arXiv preprint arXiv:1811.02141 (2018).
+*     [4] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "On detecting clustered anomalies using SCiForest."
+*         Joint European Conference on Machine Learning and Knowledge Discovery in Databases. Springer, Berlin, Heidelberg, 2010.
+*     [5] https://sourceforge.net/projects/iforest/
+*     [6] https://math.stackexchange.com/questions/3388518/expected-number-of-paths-required-to-separate-elements-in-a-binary-tree
+*     [7] Quinlan, J. Ross. C4. 5: programs for machine learning. Elsevier, 2014.
+*     [8] Cortes, David.
+*         "Distance approximation using Isolation Forests."
+*         arXiv preprint arXiv:1910.12362 (2019).
+*     [9] Cortes, David.
+*         "Imputing missing values with unsupervised random trees."
+*         arXiv preprint arXiv:1911.06646 (2019).
+*     [10] https://math.stackexchange.com/questions/3333220/expected-average-depth-in-random-binary-tree-constructed-top-to-bottom
+*     [11] Cortes, David.
+*          "Revisiting randomized choices in isolation forests."
+*          arXiv preprint arXiv:2110.13402 (2021).
+*     [12] Guha, Sudipto, et al.
+*          "Robust random cut forest based anomaly detection on streams."
+*          International conference on machine learning. PMLR, 2016.
+*     [13] Cortes, David.
+*          "Isolation forests: looking beyond tree depth."
+*          arXiv preprint arXiv:2111.11639 (2021).
+*     [14] Ting, Kai Ming, Yue Zhu, and Zhi-Hua Zhou.
+*          "Isolation kernel and its effect on SVM"
+*          Proceedings of the 24th ACM SIGKDD
+*          International Conference on Knowledge Discovery & Data Mining. 2018.
+* 
+*     BSD 2-Clause License
+*     Copyright (c) 2019-2022, David Cortes
+*     All rights reserved.
+*     Redistribution and use in source and binary forms, with or without
+*     modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this
+*       list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*       this list of conditions and the following disclaimer in the documentation
+*       and/or other materials provided with the distribution.
+*     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+*     AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+*     IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*     FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*     DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*     SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*     CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*     OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*     OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "isotree.hpp"
+
+/* Generate the source code of a C/C++ function which calculates outlier scores from a model
+* 
+* Parameters
+* ==========
+* - model_outputs
+*       Pointer to fitted single-variable model object from function 'fit_iforest'. Pass NULL
+*       if the predictions are to be made from an extended model. Can only pass one of
+*       'model_outputs' and 'model_outputs_ext'.
+* - model_outputs_ext
+*       Pointer to fitted extended model object from function 'fit_iforest'. Pass NULL
+*       if the predictions are to be made from a single-variable model. Can only pass one of
+*       'model_outputs' and 'model_outputs_ext'.
+* - function_name
+*       Name to give to the generated function. Must be a valid C identifier. The helper
+*       functions for each tree are declared 'static' and use this name as prefix.
+* - standardize
+*       Whether the generated function should output standardized outlier scores, as 'predict_iforest'
+*       does when passing 'standardize=true'. If passing 'false', will output the average depth instead.
+* - nthreads
+*       Number of parallel threads to use. Ignored when not building with OpenMP support.
+* 
+* Returns
+* =======
+* A string with a self-contained translation unit (valid as both C and C++) which defines the
+* following function, with C linkage:
+*     double <function_name>(const double *numeric_row, const int *categ_row)
+* Where 'numeric_row' contains the numeric columns of a single observation, in the same order as the
+* data to which the model was fit, and 'categ_row' contains its categorical columns, encoded in the same
+* way as for 'predict_iforest' (can be NULL if the model does not have categorical columns). Each tree is
+* unrolled into nested 'if' statements with the thresholds as literal constants, so that the model does
+* not need to be loaded at runtime. Outputs will be exactly the same as those from 'predict_iforest' if the
+* generated code is compiled without optimizations that change floating point results (e.g. 'fast-math'
+* or, for extended models, contraction of multiplications and additions into FMA instructions, which
+* can be disabled with '-ffp-contract=off'). Note that if the model was fitted with 'missing_action=Fail',
+* the generated code will not check for missing values in the inputs.
+*/
+std::string generate_cpp(const IsoForest *model_outputs, const ExtIsoForest *model_outputs_ext,
+                         const std::string &function_name, bool standardize, int nthreads)
+{
+    if (!model_outputs && !model_outputs_ext) throw std::runtime_error("'generate_cpp' got a NULL pointer for model.\n");
+    if (model_outputs && model_outputs_ext) throw std::runtime_error("'generate_cpp' got two models as inputs.\n");
+    if (!std::regex_match(function_name, std::regex("[A-Za-z_][A-Za-z0-9_]*")))
+        throw std::runtime_error("'function_name' must be a valid C identifier.\n");
+
+    size_t ntrees = model_outputs? model_outputs->trees.size() : model_outputs_ext->hplanes.size();
+    bool has_categ = false;
+    if (model_outputs)
+    {
+        for (const auto &tree : model_outputs->trees)
+            for (const IsoTree &node : tree)
+                has_categ = has_categ || (node.tree_left != 0 && node.col_type == Categorical);
+    }
+    else
+    {
+        for (const auto &hplane : model_outputs_ext->hplanes)
+            for (const IsoHPlane &node : hplane)
+                for (ColType col_type : node.col_type)
+                    has_categ = has_categ || col_type == Categorical;
+    }
+
+    std::vector<std::string> tree_code(ntrees);
+    std::atomic<bool> threw_exception(false);
+    std::exception_ptr ex = NULL;
+
+    auto generate_tree = [&](size_t tree, int thread_id)
+    {
+        (void)thread_id;
+        if (threw_exception) return;
+        try
+        {
+            std::string prefix = function_name + "_tree" + std::to_string((size_t)tree);
+            if (model_outputs)
+                generate_cpp_itree(tree_code[tree], *model_outputs, model_outputs->trees[tree], prefix, has_categ);
+            else
+                generate_cpp_hplane(tree_code[tree], *model_outputs_ext, model_outputs_ext->hplanes[tree], prefix, has_categ);
+        }
+
+        catch (...)
+        {
+            catch_task_exception(threw_exception, ex);
+        }
+    };
+    run_parallel_for(get_thread_executor(), ntrees, nthreads, true, generate_tree);
+
+    if (threw_exception)
+        std::rethrow_exception(ex);
+
+    std::string out = "/* Outlier scores from an isolation forest model with "
+                      + std::to_string(ntrees)
+                      + " trees, generated by isotree */\n"
+                      + "#include <math.h>\n\n";
+    for (std::string &code : tree_code)
+    {
+        out += code;
+        code.clear();
+        code.shrink_to_fit();
+    }
+
+    const bool has_range_penalty = model_outputs? model_outputs->has_range_penalty : false;
+    const std::string args = has_categ? "numeric_row, categ_row" : "numeric_row";
+    out += "#ifdef __cplusplus\nextern \"C\"\n#endif\n"
+           "double " + function_name + "(const double *numeric_row, const int *categ_row)\n{\n";
+    if (!has_categ)
+        out += "    (void)categ_row;\n";
+    out += "    double depth = 0;\n";
+    for (size_t tree = 0; tree < ntrees; tree++)
+    {
+        std::string tree_fun = function_name + "_tree" + std::to_string(tree) + "_node0";
+        if (model_outputs)
+            out += "    depth += " + tree_fun + "(" + args + (has_range_penalty? ", 0.);\n" : ");\n");
+        else
+            out += "    " + tree_fun + "(" + args + ", &depth);\n";
+    }
+
+    /* same transformations as in 'depths_to_scores' */
+    ScoringMetric scoring_metric = model_outputs? model_outputs->scoring_metric : model_outputs_ext->scoring_metric;
+    double exp_avg_depth = model_outputs? model_outputs->exp_avg_depth : model_outputs_ext->exp_avg_depth;
+    bool is_density = scoring_metric == Density;
+    bool is_bratio  = scoring_metric == BoxedRatio;
+    bool is_bdens   = scoring_metric == BoxedDensity;
+    bool is_bdens2  = scoring_metric == BoxedDensity2;
+    std::string ntrees_str = format_cpp_double((double)ntrees);
+    std::string ntrees_neg = format_cpp_double(-(double)ntrees);
+    if (standardize)
+    {
+        if (is_density || is_bdens2)
+            out += "    return depth / " + ntrees_neg + ";\n";
+        else if (is_bdens)
+            out += "    return -exp(depth / " + ntrees_str + ");\n";
+        else if (is_bratio)
+            out += "    return depth / " + ntrees_str + ";\n";
+        else
+            out += "    return exp2(-depth / " + format_cpp_double((double)ntrees * exp_avg_depth) + ");\n";
+    }
+
+    else
+    {
+        if (is_density || is_bdens || is_bdens2)
+            out += "    return exp(depth / " + ntrees_str + ");\n";
+        else if (is_bratio)
+            out += "    return depth / " + ntrees_neg + ";\n";
+        else
+            out += "    return depth / " + ntrees_str + ";\n";
+    }
+    out += "}\n";
+    return out;
+}
+
+/* Literals are written with enough digits to recover exactly the same 'double' */
+std::string format_cpp_double(double x)
+{
+    if (std::isinf(x))
+        return (x > 0)? "HUGE_VAL" : "(-HUGE_VAL)";
+    if (std::isnan(x))
+        return "NAN";
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.17g", x);
+    std::string out(buffer);
+    if (out.find_first_of(".e") == std::string::npos)
+        out += ".";
+    if (out[0] == '-')
+        out = "(" + out + ")";
+    return out;
+}
+
+/* Split conditions that involve missing values or new categories might send the row to both branches
+   at the same time, weighting the results from each. In such cases, the branches are generated as
+   separate functions so that they can be called from both places. Very deep trees are also split
+   into functions in order not to run into compiler limits on the nesting of blocks. */
+#define MAX_CPP_NESTING 48
+
+static bool itree_node_splits_both_ways(const IsoForest &model, const IsoTree &node)
+{
+    if (model.missing_action == Divide)
+        return true;
+    return node.col_type == Categorical && model.cat_split_type == SubSet && model.new_cat_action == Weighted;
+}
+
+static std::string cpp_categ_member(const std::vector<signed char> &cat_split, const std::string &cval)
+{
+    std::string out;
+    for (size_t categ = 0; categ < cat_split.size(); categ++)
+    {
+        if (cat_split[categ])
+            out += (out.empty()? "" : " || ") + cval + " == " + std::to_string(categ);
+    }
+    return out.empty()? std::string("0") : ("(" + out + ")");
+}
+
+void generate_cpp_itree(std::string &out, const IsoForest &model, const std::vector<IsoTree> &tree,
+                        const std::string &prefix, bool has_categ)
+{
+    /* functions are emitted in reverse order of node index so that they are defined before being called */
+    std::vector<size_t> function_roots = {0};
+    std::vector<std::string> function_code;
+    std::vector<size_t> function_nodes;
+    for (size_t ix = 0; ix < function_roots.size(); ix++)
+    {
+        size_t root = function_roots[ix];
+        std::string code = "static double " + prefix + "_node" + std::to_string(root)
+                           + "(const double *x"
+                           + (has_categ? ", const int *c" : "")
+                           + (model.has_range_penalty? ", double p" : "")
+                           + ")\n{\n"
+                           + "    (void)x;\n"
+                           + (has_categ? "    (void)c;\n" : "");
+        generate_cpp_itree_node(code, model, tree, root, 1, prefix, has_categ, function_roots);
+        code += "}\n\n";
+        function_code.push_back(std::move(code));
+        function_nodes.push_back(root);
+    }
+
+    std::vector<size_t> order(function_nodes.size());
+    std::iota(order.begin(), order.end(), (size_t)0);
+    std::sort(order.begin(), order.end(), [&function_nodes](size_t a, size_t b)
+                                          {return function_nodes[a] > function_nodes[b];});
+    for (size_t ix : order)
+        out += function_code[ix];
+}
+
+void generate_cpp_itree_node(std::string &out, const IsoForest &model, const std::vector<IsoTree> &tree,
+                             size_t curr_node, size_t nesting, const std::string &prefix, bool has_categ,
+                             std::vector<size_t> &function_roots)
+{
+    const std::string indent(4 * nesting, ' ');
+    const IsoTree &node = tree[curr_node];
+    const std::string penalty = model.has_range_penalty? " - p" : "";
+    if (node.tree_left == 0)
+    {
+        out += indent + "return " + format_cpp_double(node.score) + penalty + ";\n";
+        return;
+    }
+
+    const std::string args = std::string("x") + (has_categ? ", c" : "");
+    auto call_child = [&](size_t child, const std::string &penalty_arg)
+    {
+        return prefix + "_node" + std::to_string(child) + "(" + args
+               + (model.has_range_penalty? (", " + penalty_arg) : "") + ")";
+    };
+    const std::string pct = format_cpp_double(node.pct_tree_left);
+    const std::string both_branches = "return " + pct + " * " + call_child(node.tree_left, "0.")
+                                      + " + (1. - " + pct + ") * " + call_child(node.tree_right, "0.")
+                                      + penalty + ";\n";
+    std::string cond;
+
+    if (node.col_type == Numeric)
+    {
+        const std::string xval = "x[" + std::to_string(node.col_num) + "]";
+        if (model.missing_action == Divide)
+            out += indent + "if (isnan(" + xval + ")) " + both_branches;
+        if (model.has_range_penalty)
+            out += indent + "p += (" + xval + " < " + format_cpp_double(node.range_low)
+                   + " || " + xval + " > " + format_cpp_double(node.range_high) + ");\n";
+        if (model.missing_action == Impute && node.pct_tree_left >= .5)
+            cond = "!(" + xval + " > " + format_cpp_double(node.num_split) + ")";
+        else
+            cond = xval + " <= " + format_cpp_double(node.num_split);
+    }
+
+    else
+    {
+        const std::string cval = "c[" + std::to_string(node.col_num) + "]";
+        const bool impute_left = model.missing_action == Impute && node.pct_tree_left >= .5;
+        if (model.missing_action == Divide)
+            out += indent + "if (" + cval + " < 0) " + both_branches;
+
+        if (model.cat_split_type == SingleCateg)
+        {
+            cond = cval + " == " + std::to_string(node.chosen_cat);
+        }
+
+        else if (node.cat_split.empty()) /* this is for binary columns */
+        {
+            if (model.new_cat_action == Weighted)
+                out += indent + "if (" + cval + " > 1) " + both_branches;
+            cond = cval + " == 0";
+            if (model.new_cat_action != Weighted && node.pct_tree_left < .5)
+                cond += " || " + cval + " > 1";
+        }
+
+        else
+        {
+            const std::string ncat = std::to_string(node.cat_split.size());
+            if (model.new_cat_action == Weighted)
+            {
+                std::string new_categs = cval + " >= " + ncat;
+                for (size_t categ = 0; categ < node.cat_split.size(); categ++)
+                {
+                    if (node.cat_split[categ] == -1)
+                        new_categs += " || " + cval + " == " + std::to_string(categ);
+                }
+                out += indent + "if (" + new_categs + ") " + both_branches;
+            }
+            cond = cpp_categ_member(node.cat_split, cval);
+            if (model.new_cat_action == Random)
+                cond += " || (" + cval + " >= " + ncat + " && "
+                        + cpp_categ_member(node.cat_split, "(" + cval + " % " + ncat + ")") + ")";
+            else if (model.new_cat_action == Smallest && node.pct_tree_left < .5)
+                cond += " || " + cval + " >= " + ncat;
+        }
+
+        if (impute_left)
+            cond += " || " + cval + " < 0";
+        else if (model.missing_action == Impute)
+            cond = cval + " >= 0 && (" + cond + ")";
+    }
+
+    out += indent + "if (" + cond + ") {\n";
+    for (size_t child : {node.tree_left, node.tree_right})
+    {
+        if (itree_node_splits_both_ways(model, node) || nesting >= MAX_CPP_NESTING)
+        {
+            function_roots.push_back(child);
+            out += indent + "    return " + call_child(child, "p") + ";\n";
+        }
+        else
+        {
+            generate_cpp_itree_node(out, model, tree, child, nesting + 1, prefix, has_categ, function_roots);
+        }
+        if (child == node.tree_left)
+            out += indent + "} else {\n";
+    }
+    out += indent + "}\n";
+}
+
+void generate_cpp_hplane(std::string &out, const ExtIsoForest &model, const std::vector<IsoHPlane> &hplane,
+                         const std::string &prefix, bool has_categ)
+{
+    std::vector<size_t> function_roots = {0};
+    std::vector<std::string> function_code;
+    std::vector<size_t> function_nodes;
+    for (size_t ix = 0; ix < function_roots.size(); ix++)
+    {
+        size_t root = function_roots[ix];
+        std::string code = "static void " + prefix + "_node" + std::to_string(root)
+                           + "(const double *x"
+                           + (has_categ? ", const int *c" : "")
+                           + ", double *depth)\n{\n"
+                           + "    (void)x;\n"
+                           + (has_categ? "    (void)c;\n" : "")
+                           + ((hplane[root].hplane_left != 0)? "    double h;\n" : "");
+        generate_cpp_hplane_node(code, model, hplane, root, 1, prefix, has_categ, function_roots);
+        code += "}\n\n";
+        function_code.push_back(std::move(code));
+        function_nodes.push_back(root);
+    }
+
+    std::vector<size_t> order(function_nodes.size());
+    std::iota(order.begin(), order.end(), (size_t)0);
+    std::sort(order.begin(), order.end(), [&function_nodes](size_t a, size_t b)
+                                          {return function_nodes[a] > function_nodes[b];});
+    for (size_t ix : order)
+        out += function_code[ix];
+}
+
+void generate_cpp_hplane_node(std::string &out, const ExtIsoForest &model, const std::vector<IsoHPlane> &hplane,
+                              size_t curr_node, size_t nesting, const std::string &prefix, bool has_categ,
+                              std::vector<size_t> &function_roots)
+{
+    const std::string indent(4 * nesting, ' ');
+    const IsoHPlane &node = hplane[curr_node];
+    if (node.hplane_left == 0)
+    {
+        out += indent + "*depth += " + format_cpp_double(node.score) + ";\n";
+        return;
+    }
+
+    /* the terms are added in the same order as in 'traverse_hplane' */
+    out += indent + "h = 0;\n";
+    size_t ncols_numeric = 0;
+    size_t ncols_categ = 0;
+    for (size_t col = 0; col < node.col_num.size(); col++)
+    {
+        std::string term;
+        if (node.col_type[col] == Numeric)
+        {
+            const std::string xval = "x[" + std::to_string(node.col_num[col]) + "]";
+            term = "(" + xval + " - " + format_cpp_double(node.mean[ncols_numeric]) + ") * "
+                   + format_cpp_double(node.coef[ncols_numeric]);
+            if (model.missing_action != Fail)
+                term = "isfinite(" + xval + ")? (" + term + ") : " + format_cpp_double(node.fill_val[col]);
+            ncols_numeric++;
+        }
+
+        else
+        {
+            const std::string cval = "c[" + std::to_string(node.col_num[col]) + "]";
+            if (model.cat_split_type == SingleCateg)
+            {
+                term = "(" + cval + " == " + std::to_string(node.chosen_cat[ncols_categ]) + ")? "
+                       + format_cpp_double(node.fill_new[ncols_categ]) + " : 0.";
+            }
+
+            else
+            {
+                const std::vector<double> &cat_coef = node.cat_coef[ncols_categ];
+                const std::string ncat = std::to_string(cat_coef.size());
+                std::string switch_expr;
+                for (size_t categ = 0; categ < cat_coef.size(); categ++)
+                    switch_expr += "(" + std::string((model.new_cat_action == Random)? "cv" : cval) + " == "
+                                   + std::to_string(categ) + ")? " + format_cpp_double(cat_coef[categ]) + " : ";
+                if (model.new_cat_action == Random)
+                {
+                    /* 'cv' is the category after mapping new ones with the modulus */
+                    out += indent + "{ const int cv = (" + cval + " >= " + ncat + ")? (" + cval + " % " + ncat
+                           + ") : " + cval + "; h += " + (model.missing_action != Fail? ("(" + cval + " < 0)? "
+                           + format_cpp_double(node.fill_val[col]) + " : (") : "(")
+                           + switch_expr + "0.); }\n";
+                    ncols_categ++;
+                    continue;
+                }
+                term = switch_expr + format_cpp_double(node.fill_new[ncols_categ]);
+            }
+            if (model.missing_action != Fail)
+                term = "(" + cval + " < 0)? " + format_cpp_double(node.fill_val[col]) + " : (" + term + ")";
+            ncols_categ++;
+        }
+        out += indent + "h += " + term + ";\n";
+    }
+
+    if (model.has_range_penalty)
+        out += indent + "*depth -= (h < " + format_cpp_double(node.range_low)
+               + " || h > " + format_cpp_double(node.range_high) + ");\n";
+    out += indent + "if (h <= " + format_cpp_double(node.split_point) + ") {\n";
+    for (size_t child : {node.hplane_left, node.hplane_right})
+    {
+        if (nesting >= MAX_CPP_NESTING)
+        {
+            function_roots.push_back(child);
+            out += indent + "    " + prefix + "_node" + std::to_string(child) + "(x"
+                   + (has_categ? ", c" : "") + ", depth);\n";
+        }
+        else
+        {
+            generate_cpp_hplane_node(out, model, hplane, child, nesting + 1, prefix, has_categ, function_roots);
+        }
+        if (child == node.hplane_left)
+            out += indent + "} else {\n";
+    }
+    out += indent + "}\n";
+}
@@ -864,15 +864,14 @@ double calc_kurtosis(size_t nrows, int x[], int ncat, size_t buffer_cnt[], doubl
 }
 
 
-/* TODO: this one should get a buffer preallocated from outside */
 template <class mapping, class ldouble_safe>
-double calc_kurtosis_weighted_internal(std::vector<ldouble_safe> &buffer_cnt, int x[], int ncat,
+double calc_kurtosis_weighted_internal(ldouble_safe *restrict buffer_cnt, int x[], int ncat,
                                        double buffer_prob[], MissingAction missing_action, CategSplit cat_split_type,
                                        RNG_engine &rnd_generator, mapping &restrict w)
 {
     double sum_kurt = 0;
 
-    ldouble_safe cnt = std::accumulate(buffer_cnt.begin(), buffer_cnt.end(), (ldouble_safe)0);
+    ldouble_safe cnt = std::accumulate(buffer_cnt, buffer_cnt + ncat + 1, (ldouble_safe)0);
 
     cnt -= buffer_cnt[ncat];
     if (unlikely(cnt <= 1)) return -HUGE_VAL;
@@ -947,10 +946,11 @@ double calc_kurtosis_weighted_internal(std::vector<ldouble_safe> &buffer_cnt, in
 
 template <class mapping, class ldouble_safe>
 double calc_kurtosis_weighted(size_t ix_arr[], size_t st, size_t end, int x[], int ncat, double buffer_prob[],
+                              ldouble_safe *restrict buffer_cnt,
                               MissingAction missing_action, CategSplit cat_split_type, RNG_engine &rnd_generator,
                               mapping &restrict w)
 {
-    std::vector<ldouble_safe> buffer_cnt(ncat+1, 0.);
+    std::fill(buffer_cnt, buffer_cnt + ncat + 1, (ldouble_safe)0);
     ldouble_safe w_this;
 
     for (size_t row = st; row <= end; row++)
@@ -970,10 +970,11 @@ double calc_kurtosis_weighted(size_t ix_arr[], size_t st, size_t end, int x[], i
 
 template <class real_t, class ldouble_safe>
 double calc_kurtosis_weighted(size_t nrows, int x[], int ncat, double *restrict buffer_prob,
+                              ldouble_safe *restrict buffer_cnt,
                               MissingAction missing_action, CategSplit cat_split_type,
                               RNG_engine &rnd_generator, real_t *restrict w)
 {
-    std::vector<ldouble_safe> buffer_cnt(ncat+1, 0.);
+    std::fill(buffer_cnt, buffer_cnt + ncat + 1, (ldouble_safe)0);
     ldouble_safe w_this;
 
     for (size_t row = 0; row < nrows; row++)
@@ -2331,7 +2332,10 @@ double find_split_full_gain_weighted(real_t *restrict x, size_t st, size_t end,
 
     if (best_gain  <= -HUGE_VAL) return best_gain;
     
-    split_point = midpoint(x[ix_arr[split_ix]], x[ix_arr[split_ix+1]]);
+    if (x_uses_ix_arr)
+        split_point = midpoint(x[ix_arr[split_ix]], x[ix_arr[split_ix+1]]);
+    else
+        split_point = midpoint(x[split_ix], x[split_ix+1]);
     return best_gain / wtot;
 }
 
@@ -2422,7 +2426,7 @@ double find_split_dens_shortform_weighted_t(real_t *restrict x, size_t n, double
         {
             best_gain = this_gain;
             best_w = w_left;
-            split_ix = xmid;
+            split_ix = ix;
         }
     }
 
@@ -2542,7 +2546,7 @@ double find_split_dens_shortform_weighted(real_t *restrict x, size_t *restrict i
     w_right = wtot - w_left;
     w_left = std::fmax(w_left, std::numeric_limits<double>::min());
     w_right = std::fmax(w_right, std::numeric_limits<double>::min());
-    split_point = midpoint(x[split_ix], x[split_ix+1]);
+    split_point = midpoint(x[ix_arr[split_ix]], x[ix_arr[split_ix+1]]);
     double rpct_left = split_point / xtot;
     rpct_left = std::fmax(rpct_left, std::numeric_limits<double>::min());
     double rpct_right = 1. - rpct_left;
@@ -2868,7 +2872,7 @@ template <class mapping, class int_t, class ldouble_safe>
 double find_split_dens_longform_weighted(int *restrict x, int ncat, size_t *restrict ix_arr, size_t st, size_t end,
                                          CategSplit cat_split_type, MissingAction missing_action,
                                          int &restrict chosen_cat, signed char *restrict split_categ, int *restrict saved_cat_mode,
-                                         int_t *restrict buffer_indices, mapping &restrict w)
+                                         int_t *restrict buffer_indices, ldouble_safe *restrict buffer_cnt, mapping &restrict w)
 {
     if (st >= end || ncat <= 1) return -HUGE_VAL;
     ldouble_safe w_missing = 0;
@@ -2876,8 +2880,7 @@ double find_split_dens_longform_weighted(int *restrict x, int ncat, size_t *rest
     size_t ix_;
 
     /* count categories */
-    /* TODO: allocate this buffer externally */
-    std::vector<ldouble_safe> buffer_cnt(ncat, (ldouble_safe)0);
+    std::fill(buffer_cnt, buffer_cnt + ncat, (ldouble_safe)0);
     if (missing_action == Fail)
     {
         for (size_t row = st; row <= end; row++)
@@ -2902,9 +2905,9 @@ double find_split_dens_longform_weighted(int *restrict x, int ncat, size_t *rest
 
         if (w_missing)
         {
-            auto idxmax = std::max_element(buffer_cnt.begin(), buffer_cnt.end());
+            auto idxmax = std::max_element(buffer_cnt, buffer_cnt + ncat);
             *idxmax += w_missing;
-            *saved_cat_mode = (int)std::distance(buffer_cnt.begin(), idxmax);
+            *saved_cat_mode = (int)std::distance(buffer_cnt, idxmax);
         }
     }
 
@@ -2975,7 +2978,7 @@ double find_split_dens_longform_weighted(int *restrict x, int ncat, size_t *rest
                 (buffer_cnt[buffer_indices[curr]] + buffer_cnt[buffer_indices[curr+1]]);
     }
 
-    ldouble_safe ntot = std::accumulate(buffer_cnt.begin(), buffer_cnt.end(), (ldouble_safe)0);
+    ldouble_safe ntot = std::accumulate(buffer_cnt, buffer_cnt + ncat, (ldouble_safe)0);
     if (unlikely(ntot <= 0)) unexpected_error();
 
     switch (cat_split_type)
@@ -3059,6 +3062,195 @@ double find_split_dens_longform_weighted(int *restrict x, int ncat, size_t *rest
     return -HUGE_VAL;
 }
 
+/* Guided splits through histograms: the values of a column at a node are accumulated into the bins
+   that were assigned to them before fitting ('X_binned'), and the split point is searched only between
+   consecutive bins, which avoids sorting the rows at each node. The sums in each bin are centered at a
+   value from within the bin, and the bins are then merged with the pairwise formula of Chan et al. in
+   order to obtain the standard deviations at each side of each possible split. */
+static inline void init_histogram(HistBin *restrict hist)
+{
+    for (int bin = 0; bin <= HIST_MAX_BINS; bin++)
+        hist[bin] = {0, 0., 0., 0., HUGE_VAL, -HUGE_VAL};
+}
+
+template <class real_t_>
+void build_histogram(size_t *restrict ix_arr, size_t st, size_t end,
+                     real_t_ *restrict x, const uint8_t *restrict x_binned,
+                     const double *restrict bin_ref, HistBin *restrict hist)
+{
+    init_histogram(hist);
+    double xval, xc;
+    for (size_t row = st; row <= end; row++)
+    {
+        size_t ix = ix_arr[row];
+        HistBin &bin = hist[x_binned[ix]];
+        bin.cnt++;
+        if (unlikely(x_binned[ix] == HIST_NA_BIN)) continue;
+        xval = x[ix];
+        xc = xval - bin_ref[x_binned[ix]];
+        bin.sum += xc;
+        bin.ssq += square(xc);
+        bin.xmin = std::fmin(bin.xmin, xval);
+        bin.xmax = std::fmax(bin.xmax, xval);
+    }
+
+    for (int bin = 0; bin <= HIST_MAX_BINS; bin++)
+        hist[bin].w = (double)hist[bin].cnt;
+}
+
+template <class real_t_, class mapping>
+void build_histogram_weighted(size_t *restrict ix_arr, size_t st, size_t end,
+                              real_t_ *restrict x, const uint8_t *restrict x_binned,
+                              const double *restrict bin_ref, HistBin *restrict hist,
+                              mapping &restrict w)
+{
+    init_histogram(hist);
+    double xval, xc, w_this;
+    for (size_t row = st; row <= end; row++)
+    {
+        size_t ix = ix_arr[row];
+        HistBin &bin = hist[x_binned[ix]];
+        w_this = w[ix];
+        bin.cnt++;
+        bin.w += w_this;
+        if (unlikely(x_binned[ix] == HIST_NA_BIN)) continue;
+        xval = x[ix];
+        xc = xval - bin_ref[x_binned[ix]];
+        bin.sum += w_this * xc;
+        bin.ssq += w_this * square(xc);
+        bin.xmin = std::fmin(bin.xmin, xval);
+        bin.xmax = std::fmax(bin.xmax, xval);
+    }
+}
+
+/* Turns the histogram of a node's sibling into the histogram of the node itself. The minimum and maximum
+   of each bin are taken from the parent, so they are only bounds for the values in the node. */
+static inline void subtract_histogram(const HistBin *restrict parent, HistBin *restrict hist)
+{
+    for (int bin = 0; bin <= HIST_MAX_BINS; bin++)
+    {
+        hist[bin].cnt = parent[bin].cnt - hist[bin].cnt;
+        if (!hist[bin].cnt)
+        {
+            hist[bin] = {0, 0., 0., 0., HUGE_VAL, -HUGE_VAL};
+            continue;
+        }
+        hist[bin].w = std::fmax(parent[bin].w - hist[bin].w, 0.);
+        hist[bin].sum = parent[bin].sum - hist[bin].sum;
+        hist[bin].ssq = std::fmax(parent[bin].ssq - hist[bin].ssq, 0.);
+        hist[bin].xmin = parent[bin].xmin;
+        hist[bin].xmax = parent[bin].xmax;
+    }
+}
+
+#define add_bin_to_running_stats(w_run, mean_run, m2_run, w_bin, mean_bin, m2_bin) \
+{ \
+    real_t delta = (mean_bin) - (mean_run); \
+    real_t w_new = (w_run) + (w_bin); \
+    (mean_run) += delta * ((w_bin) / w_new); \
+    (m2_run) += (m2_bin) + square(delta) * ((w_run) * (w_bin) / w_new); \
+    (w_run) = w_new; \
+}
+
+template <class real_t>
+double find_split_hist_t(const HistBin *restrict hist, const double *restrict bin_ref, int nbins,
+                         double *restrict sd_arr, GainCriterion criterion, double min_gain, bool as_relative_gain,
+                         double &restrict split_point, double &restrict xmin, double &restrict xmax)
+{
+    int first = 0, last = nbins - 1;
+    while (first < nbins && (!hist[first].cnt || hist[first].w <= 0)) first++;
+    while (last > first && (!hist[last].cnt || hist[last].w <= 0)) last--;
+    if (first >= last) return -HUGE_VAL;
+    xmin = hist[first].xmin;
+    xmax = hist[last].xmax;
+
+    /* mean and centered sum of squares of the values in a bin */
+    auto bin_mean = [&hist, &bin_ref](int bin) -> real_t {
+        return (real_t)bin_ref[bin] + (real_t)hist[bin].sum / (real_t)hist[bin].w;
+    };
+    auto bin_m2 = [&hist](int bin) -> real_t {
+        return std::fmax((real_t)hist[bin].ssq - square((real_t)hist[bin].sum) / (real_t)hist[bin].w, (real_t)0);
+    };
+
+    /* right-to-left pass, obtaining the totals along the way */
+    real_t w_tot = 0, mean_tot = 0, m2_tot = 0;
+    for (int bin = last; bin >= first; bin--)
+    {
+        if (hist[bin].cnt && hist[bin].w > 0)
+            add_bin_to_running_stats(w_tot, mean_tot, m2_tot, (real_t)hist[bin].w, bin_mean(bin), bin_m2(bin));
+        sd_arr[bin] = std::sqrt(m2_tot / w_tot);
+    }
+    real_t full_sd = sd_arr[first];
+
+    bool use_rel_gain = criterion == Pooled && as_relative_gain && min_gain <= 0;
+    if (criterion == DensityCrit) min_gain = 0;
+    real_t w_left = 0, mean_left = 0, m2_left = 0;
+    real_t this_gain, best_gain = -HUGE_VAL;
+    int best_bin = first, best_next = last;
+    int bin = first, next;
+    while (bin < last)
+    {
+        add_bin_to_running_stats(w_left, mean_left, m2_left, (real_t)hist[bin].w, bin_mean(bin), bin_m2(bin));
+        for (next = bin + 1; !hist[next].cnt || hist[next].w <= 0; next++) { }
+
+        if (use_rel_gain)
+        {
+            real_t sum_left = w_left * (mean_left - mean_tot);
+            this_gain = square(sum_left) * ((real_t)1 / w_left + (real_t)1 / (w_tot - w_left));
+        }
+
+        else if (criterion == DensityCrit)
+        {
+            double xmid = midpoint(hist[bin].xmax, hist[next].xmin);
+            real_t xleft = xmid - xmin;
+            real_t xright = xmax - xmid;
+            if (unlikely(!xleft || !xright)) { bin = next; continue; }
+            real_t pct_left = w_left / w_tot;
+            real_t pct_right = (real_t)1 - pct_left;
+            this_gain = square(pct_left) / (xleft / (xmax - xmin)) + square(pct_right) / (xright / (xmax - xmin));
+            if (unlikely(is_na_or_inf(this_gain))) { bin = next; continue; }
+        }
+
+        else
+        {
+            real_t sd_left = std::sqrt(m2_left / w_left);
+            this_gain = (criterion == Pooled)?
+                        pooled_gain(full_sd, w_tot, sd_left, sd_arr[next], w_left, w_tot - w_left)
+                            :
+                        sd_gain(full_sd, sd_left, sd_arr[next]);
+        }
+
+        if (this_gain > best_gain && (use_rel_gain || this_gain > min_gain))
+        {
+            best_gain = this_gain;
+            best_bin = bin;
+            best_next = next;
+        }
+        bin = next;
+    }
+
+    if (best_gain <= -HUGE_VAL) return best_gain;
+    split_point = midpoint(hist[best_bin].xmax, hist[best_next].xmin);
+    if (use_rel_gain)
+        return std::fmax((double)best_gain, std::numeric_limits<double>::epsilon());
+    return best_gain;
+}
+
+#undef add_bin_to_running_stats
+
+template <class ldouble_safe>
+double find_split_hist(const HistBin *restrict hist, const double *restrict bin_ref, int nbins, size_t n,
+                       double *restrict sd_arr, GainCriterion criterion, double min_gain, bool as_relative_gain,
+                       double &restrict split_point, double &restrict xmin, double &restrict xmax)
+{
+    if (n < THRESHOLD_LONG_DOUBLE)
+        return find_split_hist_t<double>(hist, bin_ref, nbins, sd_arr, criterion, min_gain, as_relative_gain,
+                                         split_point, xmin, xmax);
+    else
+        return find_split_hist_t<ldouble_safe>(hist, bin_ref, nbins, sd_arr, criterion, min_gain, as_relative_gain,
+                                               split_point, xmin, xmax);
+}
+
 /* for split-criterion in hyperplanes (see below for version aimed at single-variable splits) */
 template <class ldouble_safe>
 double eval_guided_crit(double *restrict x, size_t n, GainCriterion criterion,
@@ -3067,6 +3259,7 @@ double eval_guided_crit(double *restrict x, size_t n, GainCriterion criterion,
                         size_t *restrict ix_arr_plus_st,
                         size_t *restrict cols_use, size_t ncols_use, bool force_cols_use,
                         double *restrict X_row_major, size_t ncols,
+                        size_t *restrict buffer_argsorted, double *restrict buffer_sorted,
                         double *restrict Xr, size_t *restrict Xr_ind, size_t *restrict Xr_indptr)
 {
     /* Note: the input 'x' is supposed to be a linear combination of standardized variables, so
@@ -3088,23 +3281,20 @@ double eval_guided_crit(double *restrict x, size_t n, GainCriterion criterion,
 
     if (criterion == FullGain)
     {
-        /* TODO: these buffers should be allocated externally */
-        std::vector<size_t> argsorted(n);
-        std::iota(argsorted.begin(), argsorted.end(), (size_t)0);
-        std::sort(argsorted.begin(), argsorted.end(),
+        std::iota(buffer_argsorted, buffer_argsorted + n, (size_t)0);
+        std::sort(buffer_argsorted, buffer_argsorted + n,
                   [&x](const size_t a, const size_t b){return x[a] < x[b];});
-        if (x[argsorted[0]] == x[argsorted[n-1]]) return -HUGE_VAL;
-        std::vector<double> temp_buffer(n + mult2(ncols));
-        for (size_t ix = 0; ix < n; ix++) temp_buffer[ix] = x[argsorted[ix]];
+        if (x[buffer_argsorted[0]] == x[buffer_argsorted[n-1]]) return -HUGE_VAL;
+        for (size_t ix = 0; ix < n; ix++) buffer_sorted[ix] = x[buffer_argsorted[ix]];
         for (size_t ix = 0; ix < n; ix++)
-            argsorted[ix] = ix_arr_plus_st[argsorted[ix]];
+            buffer_argsorted[ix] = ix_arr_plus_st[buffer_argsorted[ix]];
         size_t ignored;
         return find_split_full_gain<double, ldouble_safe>(
-                                    temp_buffer.data(), (size_t)0, n-1, argsorted.data(),
+                                    buffer_sorted, (size_t)0, n-1, buffer_argsorted,
                                     cols_use, ncols_use, force_cols_use,
                                     X_row_major, ncols,
                                     Xr, Xr_ind, Xr_indptr,
-                                    temp_buffer.data() + n, temp_buffer.data() + n + ncols,
+                                    buffer_sorted + n, buffer_sorted + n + ncols,
                                     ignored, split_point,
                                     false);
     }
@@ -3132,6 +3322,7 @@ double eval_guided_crit_weighted(double *restrict x, size_t n, GainCriterion cri
                                  size_t *restrict ix_arr_plus_st,
                                  size_t *restrict cols_use, size_t ncols_use, bool force_cols_use,
                                  double *restrict X_row_major, size_t ncols,
+                                 double *restrict buffer_sorted,
                                  double *restrict Xr, size_t *restrict Xr_ind, size_t *restrict Xr_indptr)
 {
     /* Note: the input 'x' is supposed to be a linear combination of standardized variables, so
@@ -3164,22 +3355,17 @@ double eval_guided_crit_weighted(double *restrict x, size_t n, GainCriterion cri
         gain = find_split_dens_shortform_weighted<double, double *restrict, ldouble_safe>(x, n, split_point, w, buffer_indices);
     else if (criterion == FullGain)
     {
-        std::vector<size_t> argsorted(n);
-        std::iota(argsorted.begin(), argsorted.end(), (size_t)0);
-        std::sort(argsorted.begin(), argsorted.end(),
-                  [&x](const size_t a, const size_t b){return x[a] < x[b];});
-        if (x[argsorted[0]] == x[argsorted[n-1]]) return -HUGE_VAL;
-        std::vector<double> temp_buffer(n + mult2(ncols));
-        for (size_t ix = 0; ix < n; ix++) temp_buffer[ix] = x[argsorted[ix]];
+        /* 'buffer_indices' is already sorted, and is not needed afterwards */
+        for (size_t ix = 0; ix < n; ix++) buffer_sorted[ix] = x[buffer_indices[ix]];
         for (size_t ix = 0; ix < n; ix++)
-            argsorted[ix] = ix_arr_plus_st[argsorted[ix]];
+            buffer_indices[ix] = ix_arr_plus_st[buffer_indices[ix]];
         size_t ignored;
         gain = find_split_full_gain_weighted<double, double *restrict, ldouble_safe>(
-                                             temp_buffer.data(), (size_t)0, n-1, argsorted.data(),
+                                             buffer_sorted, (size_t)0, n-1, buffer_indices,
                                              cols_use, ncols_use, force_cols_use,
                                              X_row_major, ncols,
                                              Xr, Xr_ind, Xr_indptr,
-                                             temp_buffer.data() + n, temp_buffer.data() + n + ncols,
+                                             buffer_sorted + n, buffer_sorted + n + ncols,
                                              ignored, split_point,
                                              false,
                                              w);
@@ -3194,24 +3380,33 @@ double eval_guided_crit(size_t *restrict ix_arr, size_t st, size_t end, real_t_
                         double *restrict buffer_sd, bool as_relative_gain,
                         double *restrict buffer_imputed_x, double *restrict saved_xmedian,
                         size_t &split_ix, double &restrict split_point, double &restrict xmin, double &restrict xmax,
-                        GainCriterion criterion, double min_gain, MissingAction missing_action,
+                        GainCriterion criterion, double min_gain, MissingAction missing_action, bool is_presorted,
                         size_t *restrict cols_use, size_t ncols_use, bool force_cols_use,
-                        double *restrict X_row_major, size_t ncols,
+                        double *restrict X_row_major, size_t ncols, double *restrict buffer_sums,
                         double *restrict Xr, size_t *restrict Xr_ind, size_t *restrict Xr_indptr)
 {
     size_t st_orig = st;
     double gain = 0;
     if (criterion == DensityCrit || criterion == FullGain) min_gain = 0;
 
-    /* move NAs to the front if there's any, exclude them from calculations */
+    /* move NAs to the front if there's any, exclude them from calculations
+       (when the indices come presorted, the NAs are already at the front) */
     if (missing_action != Fail)
-        st = move_NAs_to_front(ix_arr, st, end, x);
+    {
+        if (is_presorted)
+            while (st <= end && is_na_or_inf(x[ix_arr[st]])) st++;
+        else
+            st = move_NAs_to_front(ix_arr, st, end, x);
+    }
 
     if (unlikely(st >= end)) return -HUGE_VAL;
     else if (unlikely(st == (end-1)))
     {
         if (x[ix_arr[st]] == x[ix_arr[end]])
             return -HUGE_VAL;
+        /* the caller takes the rows as already split, so they need to be in ascending order */
+        if (x[ix_arr[st]] > x[ix_arr[end]])
+            std::swap(ix_arr[st], ix_arr[end]);
         split_point = midpoint_with_reorder(x[ix_arr[st]], x[ix_arr[end]]);
         split_ix    = st;
         gain        = 1.;
@@ -3222,7 +3417,8 @@ double eval_guided_crit(size_t *restrict ix_arr, size_t st, size_t end, real_t_
     }
 
     /* sort in ascending order */
-    std::sort(ix_arr + st, ix_arr + end + 1, [&x](const size_t a, const size_t b){return x[a] < x[b];});
+    if (!is_presorted)
+        std::sort(ix_arr + st, ix_arr + end + 1, [&x](const size_t a, const size_t b){return x[a] < x[b];});
     if (x[ix_arr[st]] == x[ix_arr[end]]) return -HUGE_VAL;
     xmin = x[ix_arr[st]]; xmax = x[ix_arr[end]];
 
@@ -3250,14 +3446,12 @@ double eval_guided_crit(size_t *restrict ix_arr, size_t st, size_t end, real_t_
             gain = find_split_dens<double, ldouble_safe>(buffer_imputed_x, ix_arr, st_orig, end, split_point, split_ix);
         else if (criterion == FullGain)
         {
-            /* TODO: this buffer should be allocated from outside */
-            std::vector<double> temp_buffer(mult2(ncols));
             gain = find_split_full_gain<double, ldouble_safe>(
                                         buffer_imputed_x, st_orig, end, ix_arr,
                                         cols_use, ncols_use, force_cols_use,
                                         X_row_major, ncols,
                                         Xr, Xr_ind, Xr_indptr,
-                                        temp_buffer.data(), temp_buffer.data() + ncols,
+                                        buffer_sums, buffer_sums + ncols,
                                         split_ix, split_point, true);
         }
 
@@ -3276,14 +3470,12 @@ double eval_guided_crit(size_t *restrict ix_arr, size_t st, size_t end, real_t_
             gain = find_split_dens<real_t_, ldouble_safe>(x, ix_arr, st, end, split_point, split_ix);
         else if (criterion == FullGain)
         {
-            /* TODO: this buffer should be allocated from outside */
-            std::vector<double> temp_buffer(mult2(ncols));
             gain = find_split_full_gain<real_t_, ldouble_safe>(
                                         x, st, end, ix_arr,
                                         cols_use, ncols_use, force_cols_use,
                                         X_row_major, ncols,
                                         Xr, Xr_ind, Xr_indptr,
-                                        temp_buffer.data(), temp_buffer.data() + ncols,
+                                        buffer_sums, buffer_sums + ncols,
                                         split_ix, split_point, true);
         }
     }
@@ -3297,9 +3489,9 @@ double eval_guided_crit_weighted(size_t *restrict ix_arr, size_t st, size_t end,
                                  double *restrict buffer_sd, bool as_relative_gain,
                                  double *restrict buffer_imputed_x, double *restrict saved_xmedian,
                                  size_t &split_ix, double &restrict split_point, double &restrict xmin, double &restrict xmax,
-                                 GainCriterion criterion, double min_gain, MissingAction missing_action,
+                                 GainCriterion criterion, double min_gain, MissingAction missing_action, bool is_presorted,
                                  size_t *restrict cols_use, size_t ncols_use, bool force_cols_use,
-                                 double *restrict X_row_major, size_t ncols,
+                                 double *restrict X_row_major, size_t ncols, double *restrict buffer_sums,
                                  double *restrict Xr, size_t *restrict Xr_ind, size_t *restrict Xr_indptr,
                                  mapping &restrict w)
 {
@@ -3307,15 +3499,24 @@ double eval_guided_crit_weighted(size_t *restrict ix_arr, size_t st, size_t end,
     double gain = 0;
     if (criterion == DensityCrit || criterion == FullGain) min_gain = 0;
 
-    /* move NAs to the front if there's any, exclude them from calculations */
+    /* move NAs to the front if there's any, exclude them from calculations
+       (when the indices come presorted, the NAs are already at the front) */
     if (missing_action != Fail)
-        st = move_NAs_to_front(ix_arr, st, end, x);
+    {
+        if (is_presorted)
+            while (st <= end && is_na_or_inf(x[ix_arr[st]])) st++;
+        else
+            st = move_NAs_to_front(ix_arr, st, end, x);
+    }
 
     if (unlikely(st >= end)) return -HUGE_VAL;
     else if (unlikely(st == (end-1)))
     {
         if (x[ix_arr[st]] == x[ix_arr[end]])
             return -HUGE_VAL;
+        /* the caller takes the rows as already split, so they need to be in ascending order */
+        if (x[ix_arr[st]] > x[ix_arr[end]])
+            std::swap(ix_arr[st], ix_arr[end]);
         split_point = midpoint_with_reorder(x[ix_arr[st]], x[ix_arr[end]]);
         split_ix    = st;
         gain        = 1.;
@@ -3326,7 +3527,8 @@ double eval_guided_crit_weighted(size_t *restrict ix_arr, size_t st, size_t end,
     }
 
     /* sort in ascending order */
-    std::sort(ix_arr + st, ix_arr + end + 1, [&x](const size_t a, const size_t b){return x[a] < x[b];});
+    if (!is_presorted)
+        std::sort(ix_arr + st, ix_arr + end + 1, [&x](const size_t a, const size_t b){return x[a] < x[b];});
     if (x[ix_arr[st]] == x[ix_arr[end]]) return -HUGE_VAL;
     xmin = x[ix_arr[st]]; xmax = x[ix_arr[end]];
 
@@ -3358,13 +3560,12 @@ double eval_guided_crit_weighted(size_t *restrict ix_arr, size_t st, size_t end,
             gain = find_split_dens_weighted<double, mapping, ldouble_safe>(buffer_imputed_x, ix_arr, st_orig, end, split_point, split_ix, w);
         else if (criterion == FullGain)
         {
-            std::vector<double> temp_buffer(mult2(ncols));
             gain = find_split_full_gain_weighted<double, mapping, ldouble_safe>(
                                                  buffer_imputed_x, st_orig, end, ix_arr,
                                                  cols_use, ncols_use, force_cols_use,
                                                  X_row_major, ncols,
                                                  Xr, Xr_ind, Xr_indptr,
-                                                 temp_buffer.data(), temp_buffer.data() + ncols,
+                                                 buffer_sums, buffer_sums + ncols,
                                                  split_ix, split_point, true,
                                                  w);
         }
@@ -3380,13 +3581,12 @@ double eval_guided_crit_weighted(size_t *restrict ix_arr, size_t st, size_t end,
             gain = find_split_dens_weighted<real_t_, mapping, ldouble_safe>(x, ix_arr, st, end, split_point, split_ix, w);
         else if (criterion == FullGain)
         {
-            std::vector<double> temp_buffer(mult2(ncols));
             gain = find_split_full_gain_weighted<real_t_, mapping, ldouble_safe>(
                                                  x, st, end, ix_arr,
                                                  cols_use, ncols_use, force_cols_use,
                                                  X_row_major, ncols,
                                                  Xr, Xr_ind, Xr_indptr,
-                                                 temp_buffer.data(), temp_buffer.data() + ncols,
+                                                 buffer_sums, buffer_sums + ncols,
                                                  split_ix, split_point, true,
                                                  w);
         }
@@ -3409,7 +3609,7 @@ double eval_guided_crit(size_t ix_arr[], size_t st, size_t end,
                         double &split_point, double &xmin, double &xmax,
                         GainCriterion criterion, double min_gain, MissingAction missing_action,
                         size_t *restrict cols_use, size_t ncols_use, bool force_cols_use,
-                        double *restrict X_row_major, size_t ncols,
+                        double *restrict X_row_major, size_t ncols, double *restrict buffer_sums,
                         double *restrict Xr, size_t *restrict Xr_ind, size_t *restrict Xr_indptr)
 {
     size_t ignored;
@@ -3456,9 +3656,9 @@ double eval_guided_crit(size_t ix_arr[], size_t st, size_t end,
     return eval_guided_crit<double, ldouble_safe>(
                             buffer_pos, 0, end - st, buffer_arr, buffer_arr + tot,
                             as_relative_gain, saved_xmedian, (double*)NULL, ignored, split_point,
-                            xmin, xmax, criterion, min_gain, missing_action,
+                            xmin, xmax, criterion, min_gain, missing_action, false,
                             cols_use, ncols_use, force_cols_use,
-                            X_row_major, ncols,
+                            X_row_major, ncols, buffer_sums,
                             Xr, Xr_ind, Xr_indptr);
 }
 
@@ -3470,9 +3670,9 @@ double eval_guided_crit_weighted(size_t ix_arr[], size_t st, size_t end,
                                  double &restrict split_point, double &restrict xmin, double &restrict xmax,
                                  GainCriterion criterion, double min_gain, MissingAction missing_action,
                                  size_t *restrict cols_use, size_t ncols_use, bool force_cols_use,
-                                 double *restrict X_row_major, size_t ncols,
+                                 double *restrict X_row_major, size_t ncols, double *restrict buffer_sums,
                                  double *restrict Xr, size_t *restrict Xr_ind, size_t *restrict Xr_indptr,
-                                 mapping &restrict w)
+                                 double *restrict buffer_w, mapping &restrict w)
 {
     size_t ignored;
 
@@ -3517,18 +3717,16 @@ double eval_guided_crit_weighted(size_t ix_arr[], size_t st, size_t end,
 
 
     no_nas:
-    /* TODO: allocate this buffer externally */
-    std::vector<double> buffer_w(tot);
     for (size_t row = st; row <= end; row++)
         buffer_w[row-st] = w[ix_arr[row]];
     /* TODO: in this case, as the weights match with the order of the indices, could use a faster version
        with a weighted rel_gain function instead (not yet implemented). */
-    return eval_guided_crit_weighted<double, std::vector<double>, ldouble_safe>(
+    return eval_guided_crit_weighted<double, double *restrict, ldouble_safe>(
                                      buffer_pos, 0, end - st, buffer_arr, buffer_arr + tot,
                                      as_relative_gain, saved_xmedian, (double*)NULL, ignored, split_point,
-                                     xmin, xmax, criterion, min_gain, missing_action,
+                                     xmin, xmax, criterion, min_gain, missing_action, false,
                                      cols_use, ncols_use, force_cols_use,
-                                     X_row_major, ncols,
+                                     X_row_major, ncols, buffer_sums,
                                      Xr, Xr_ind, Xr_indptr,
                                      buffer_w);
 }
@@ -3887,7 +4085,7 @@ double eval_guided_crit(size_t *restrict ix_arr, size_t st, size_t end, int *res
 template <class mapping, class ldouble_safe>
 double eval_guided_crit_weighted(size_t *restrict ix_arr, size_t st, size_t end, int *restrict x, int ncat,
                                  int *restrict saved_cat_mode,
-                                 size_t *restrict buffer_pos, double *restrict buffer_prob,
+                                 size_t *restrict buffer_pos, double *restrict buffer_prob, ldouble_safe *restrict buffer_cnt,
                                  int &restrict chosen_cat, signed char *restrict split_categ, signed char *restrict buffer_split,
                                  GainCriterion criterion, double min_gain, bool all_perm,
                                  MissingAction missing_action, CategSplit cat_split_type,
@@ -3898,15 +4096,14 @@ double eval_guided_crit_weighted(size_t *restrict ix_arr, size_t st, size_t end,
                                                  x, ncat, ix_arr, st, end,
                                                  cat_split_type, missing_action,
                                                  chosen_cat, split_categ, saved_cat_mode,
-                                                 buffer_pos, w);
+                                                 buffer_pos, buffer_cnt, w);
     if (st >= end) return -HUGE_VAL;
     ldouble_safe w_missing = 0;
     int xval;
     size_t ix_;
 
     /* count categories */
-    /* TODO: allocate this buffer externally */
-    std::vector<ldouble_safe> buffer_cnt(ncat, (ldouble_safe)0);
+    std::fill(buffer_cnt, buffer_cnt + ncat, (ldouble_safe)0);
     if (missing_action == Fail)
     {
         for (size_t row = st; row <= end; row++)
@@ -3931,9 +4128,9 @@ double eval_guided_crit_weighted(size_t *restrict ix_arr, size_t st, size_t end,
 
         if (w_missing)
         {
-            auto idxmax = std::max_element(buffer_cnt.begin(), buffer_cnt.end());
+            auto idxmax = std::max_element(buffer_cnt, buffer_cnt + ncat);
             *idxmax += w_missing;
-            *saved_cat_mode = (int)std::distance(buffer_cnt.begin(), idxmax);
+            *saved_cat_mode = (int)std::distance(buffer_cnt, idxmax);
         }
     }
 
@@ -3947,7 +4144,7 @@ double eval_guided_crit_weighted(size_t *restrict ix_arr, size_t st, size_t end,
         }
     }
 
-    ldouble_safe cnt = std::accumulate(buffer_cnt.begin(), buffer_cnt.end(), (ldouble_safe)0);
+    ldouble_safe cnt = std::accumulate(buffer_cnt, buffer_cnt + ncat, (ldouble_safe)0);
 
     double this_gain = -HUGE_VAL;
     double best_gain = -HUGE_VAL;
@@ -3992,7 +4189,7 @@ double eval_guided_crit_weighted(size_t *restrict ix_arr, size_t st, size_t end,
                     {
                         this_gain = sd_gain(sd_full,
                                             0.0,
-                                            (expected_sd_cat_single<ldouble_safe, size_t, ldouble_safe>(buffer_cnt.data(), buffer_prob, ncat_present, buffer_pos + st_pos, pos - st_pos, cnt))
+                                            (expected_sd_cat_single<ldouble_safe, size_t, ldouble_safe>(buffer_cnt, buffer_prob, ncat_present, buffer_pos + st_pos, pos - st_pos, cnt))
                                             );
                         if (this_gain > min_gain && this_gain > best_gain)
                         {
@@ -4086,8 +4283,8 @@ double eval_guided_crit_weighted(size_t *restrict ix_arr, size_t st, size_t end,
                         buffer_split[buffer_pos[pos]] = 1;
                         /* TODO: is this correct? */
                         this_gain = sd_gain(sd_full,
-                                            (expected_sd_cat<ldouble_safe, size_t, ldouble_safe>(buffer_cnt.data(), buffer_prob, pos - st_pos + 1, buffer_pos + st_pos)),
-                                            (expected_sd_cat<ldouble_safe, size_t, ldouble_safe>(buffer_cnt.data(), buffer_prob, (size_t)ncat - pos - 1, buffer_pos + pos + 1))
+                                            (expected_sd_cat<ldouble_safe, size_t, ldouble_safe>(buffer_cnt, buffer_prob, pos - st_pos + 1, buffer_pos + st_pos)),
+                                            (expected_sd_cat<ldouble_safe, size_t, ldouble_safe>(buffer_cnt, buffer_prob, (size_t)ncat - pos - 1, buffer_pos + pos + 1))
                                             );
                         if (this_gain > min_gain && this_gain > best_gain)
                         {
@@ -382,14 +382,17 @@ void calc_similarity_internal(
             throw std::runtime_error("Number of rows implies too large distance matrix (integer overflow).");
     }
 
-    if ((size_t)nthreads > ntrees)
-        nthreads = (int)ntrees;
+    Executor *executor = get_thread_executor();
+    if (executor != NULL)
+        nthreads = executor->num_workers();
     #ifdef _OPENMP
-    std::vector<WorkerForSimilarity> worker_memory(nthreads);
+    else if ((size_t)nthreads > ntrees)
+        nthreads = (int)ntrees;
     #else
-    std::vector<WorkerForSimilarity> worker_memory(1);
-    nthreads = 1;
+    else
+        nthreads = 1;
     #endif
+    std::vector<WorkerForSimilarity> worker_memory(nthreads);
 
     /* Global variable that determines if the procedure receives a stop signal */
     SignalSwitcher ss = SignalSwitcher();
@@ -398,7 +401,7 @@ void calc_similarity_internal(
     if (interrupt_switch) return;
     #endif
     /* For handling exceptions */
-    bool threw_exception = false;
+    std::atomic<bool> threw_exception(false);
     std::exception_ptr ex = NULL;
 
     if (
@@ -414,17 +417,15 @@ void calc_similarity_internal(
 
     if (model_outputs != NULL)
     {
-        #pragma omp parallel for schedule(dynamic) num_threads(nthreads) \
-                shared(ntrees, worker_memory, prediction_data, model_outputs, ex, threw_exception, n_from)
-        for (size_t_for tree = 0; tree < (decltype(tree))ntrees; tree++)
+        auto traverse_tree = [&](size_t tree, int thread_id)
         {
-            if (threw_exception || interrupt_switch) continue;
+            if (threw_exception || interrupt_switch) return;
             try
             {
-                initialize_worker_for_sim(worker_memory[omp_get_thread_num()], prediction_data,
+                initialize_worker_for_sim(worker_memory[thread_id], prediction_data,
                                           model_outputs, NULL, n_from, assume_full_distr);
                 traverse_tree_sim<PredictionData<real_t, sparse_ix>, ldouble_safe>(
-                                  worker_memory[omp_get_thread_num()],
+                                  worker_memory[thread_id],
                                   prediction_data,
                                   *model_outputs,
                                   model_outputs->trees[tree],
@@ -434,31 +435,23 @@ void calc_similarity_internal(
 
             catch (...)
             {
-                #pragma omp critical
-                {
-                    if (!threw_exception)
-                    {
-                        threw_exception = true;
-                        ex = std::current_exception();
-                    }
-                }
+                catch_task_exception(threw_exception, ex);
             }
-        }
+        };
+        run_parallel_for(executor, ntrees, nthreads, true, traverse_tree);
     }
 
     else
     {
-        #pragma omp parallel for schedule(dynamic) num_threads(nthreads) \
-                shared(ntrees, worker_memory, prediction_data, model_outputs_ext, ex, threw_exception, n_from)
-        for (size_t_for hplane = 0; hplane < (decltype(hplane))ntrees; hplane++)
+        auto traverse_hplane = [&](size_t hplane, int thread_id)
         {
-            if (threw_exception || interrupt_switch) continue;
+            if (threw_exception || interrupt_switch) return;
             try
             {
-                initialize_worker_for_sim(worker_memory[omp_get_thread_num()], prediction_data,
+                initialize_worker_for_sim(worker_memory[thread_id], prediction_data,
                                           NULL, model_outputs_ext, n_from, assume_full_distr);
                 traverse_hplane_sim<PredictionData<real_t, sparse_ix>, ldouble_safe>(
-                                    worker_memory[omp_get_thread_num()],
+                                    worker_memory[thread_id],
                                     prediction_data,
                                     *model_outputs_ext,
                                     model_outputs_ext->hplanes[hplane],
@@ -468,16 +461,10 @@ void calc_similarity_internal(
 
             catch (...)
             {
-                #pragma omp critical
-                {
-                    if (!threw_exception)
-                    {
-                        threw_exception = true;
-                        ex = std::current_exception();
-                    }
-                }
+                catch_task_exception(threw_exception, ex);
             }
-        }    
+        };
+        run_parallel_for(executor, ntrees, nthreads, true, traverse_hplane);
     }
 
     check_interrupt_switch(ss);
@@ -1083,7 +1070,6 @@ void gather_sim_result(std::vector<WorkerForSimilarity> *worker_memory,
     size_t ncomb = calc_ncomb(nrows);
     size_t n_to  = (prediction_data != NULL)? (prediction_data->nrows - n_from) : 0;
 
-    #ifdef _OPENMP
     if (nthreads > 1)
     {
         if (worker_memory != NULL)
@@ -1092,15 +1078,21 @@ void gather_sim_result(std::vector<WorkerForSimilarity> *worker_memory,
             {
                 if (!w.tmat_sep.empty())
                 {
-                    #pragma omp parallel for schedule(static) num_threads(nthreads) shared(ncomb, tmat, w, worker_memory)
-                    for (size_t_for ix = 0; ix < (decltype(ix))ncomb; ix++)
+                    auto add_tmat = [&](size_t ix, int thread_id)
+                    {
+                        (void)thread_id;
                         tmat[ix] += w.tmat_sep[ix];
+                    };
+                    run_parallel_for(get_thread_executor(), ncomb, nthreads, false, add_tmat);
                 }
                 else if (!w.rmat.empty())
                 {
-                    #pragma omp parallel for schedule(static) num_threads(nthreads) shared(rmat, w, worker_memory)
-                    for (size_t_for ix = 0; ix < (decltype(ix))w.rmat.size(); ix++)
+                    auto add_rmat = [&](size_t ix, int thread_id)
+                    {
+                        (void)thread_id;
                         rmat[ix] += w.rmat[ix];
+                    };
+                    run_parallel_for(get_thread_executor(), w.rmat.size(), nthreads, false, add_rmat);
                 }
             }
         }
@@ -1111,16 +1103,18 @@ void gather_sim_result(std::vector<WorkerForSimilarity> *worker_memory,
             {
                 if (!w.tmat_sep.empty())
                 {
-                    #pragma omp parallel for schedule(static) num_threads(nthreads) shared(ncomb, tmat, w, worker_memory_m)
-                    for (size_t_for ix = 0; ix < (decltype(ix))ncomb; ix++)
+                    auto add_tmat = [&](size_t ix, int thread_id)
+                    {
+                        (void)thread_id;
                         tmat[ix] += w.tmat_sep[ix];
+                    };
+                    run_parallel_for(get_thread_executor(), ncomb, nthreads, false, add_tmat);
                 }
             }
         }
     }
     
     else
-    #endif
     {
         if (worker_memory != NULL)
         {
@@ -1257,6 +1251,19 @@ void initialize_worker_for_sim(WorkerForSimilarity  &workspace,
     }
 }
 
+/* Note: terminal node numbers from the indexer are not the same as the node indices in the tree */
+static inline void get_terminal_nodes(std::vector<size_t> &terminal_nodes, const SingleTreeIndex &tree_index,
+                                      const std::vector<IsoTree> *tree, const std::vector<IsoHPlane> *hplane)
+{
+    terminal_nodes.resize(tree_index.n_terminal);
+    size_t tree_size = (tree != NULL)? tree->size() : hplane->size();
+    for (size_t node = 0; node < tree_size; node++)
+    {
+        if ((tree != NULL)? ((*tree)[node].tree_left == 0) : ((*hplane)[node].hplane_left == 0))
+            terminal_nodes[tree_index.terminal_node_mappings[node]] = node;
+    }
+}
+
 template <class real_t, class sparse_ix>
 void calc_similarity_from_indexer
 (
@@ -1283,8 +1290,12 @@ void calc_similarity_from_indexer
                     indexer);
     ignored.reset();
 
+    Executor *executor = get_thread_executor();
+    if (executor != NULL)
+        nthreads = executor->num_workers();
     #ifndef _OPENMP
-    nthreads = 1;
+    else
+        nthreads = 1;
     #endif
 
     check_interrupt_switch(ss);
@@ -1305,24 +1316,21 @@ void calc_similarity_from_indexer
         std::vector<std::vector<size_t>> thread_sorted_nodes(nthreads);
         for (auto &v : thread_sorted_nodes) v.reserve(nrows); /* <- could shrink to max number of terminal nodes */
 
+        std::vector<std::vector<size_t>> thread_terminal_nodes(nthreads);
 
-        bool threw_exception = false;
+        std::atomic<bool> threw_exception(false);
         std::exception_ptr ex = NULL;
-        #pragma omp parallel for schedule(static) num_threads(nthreads) \
-                shared(model_outputs, model_outputs_ext, nthreads, indexer, nrows, ncomb, terminal_indices, \
-                       sum_separations, thread_argsorted_nodes, thread_sorted_nodes, tmat, \
-                       threw_exception, ex)
-        for (size_t_for tree = 0; tree < (decltype(tree))ntrees; tree++)
+        auto sum_separations_tree = [&](size_t tree, int thread_id)
         {
-            if (interrupt_switch || threw_exception) continue;
+            if (interrupt_switch || threw_exception) return;
 
             if (unlikely(indexer->indices[tree].n_terminal <= 1))
             {
-                for (auto &el : sum_separations[omp_get_thread_num()]) el += 1.;
-                continue;
+                for (auto &el : sum_separations[thread_id]) el += 1.;
+                return;
             }
 
-            double *restrict ptr_this_sep = sum_separations[omp_get_thread_num()].data();
+            double *restrict ptr_this_sep = sum_separations[thread_id].data();
             if (nthreads == 1) ptr_this_sep = tmat;
             double *restrict node_dist_this = indexer->indices[tree].node_distances.data();
             double *restrict node_depths_this = indexer->indices[tree].node_depths.data();
@@ -1375,19 +1383,12 @@ void calc_similarity_from_indexer
 
                 catch (...)
                 {
-                    #pragma omp critical
-                    {
-                        if (!threw_exception)
-                        {
-                            threw_exception = true;
-                            ex = std::current_exception();
-                        }
-                    }
+                    catch_task_exception(threw_exception, ex);
                 }
 
                 if (likely(!nodes_w_repeated.empty()))
                 {
-                    std::vector<size_t> *restrict argsorted_nodes = &thread_argsorted_nodes[omp_get_thread_num()];
+                    std::vector<size_t> *restrict argsorted_nodes = &thread_argsorted_nodes[thread_id];
                     std::iota(argsorted_nodes->begin(), argsorted_nodes->end(), (size_t)0);
                     std::sort(argsorted_nodes->begin(), argsorted_nodes->end(),
                               [&terminal_indices_this](const size_t a, const size_t b)
@@ -1395,9 +1396,11 @@ void calc_similarity_from_indexer
                     std::vector<size_t>::iterator curr_begin = argsorted_nodes->begin();
                     std::vector<size_t>::iterator new_begin;
 
-                    std::vector<size_t> *restrict sorted_nodes = &thread_sorted_nodes[omp_get_thread_num()];
+                    std::vector<size_t> *restrict sorted_nodes = &thread_sorted_nodes[thread_id];
                     sorted_nodes->assign(nodes_w_repeated.begin(), nodes_w_repeated.end());
                     std::sort(sorted_nodes->begin(), sorted_nodes->end());
+                    std::vector<size_t> *restrict terminal_nodes = &thread_terminal_nodes[thread_id];
+                    get_terminal_nodes(*terminal_nodes, indexer->indices[tree], tree_this, hplane_this);
                     for (size_t node_ix : *sorted_nodes)
                     {
                         curr_begin = std::lower_bound(curr_begin, argsorted_nodes->end(),
@@ -1414,9 +1417,9 @@ void calc_similarity_from_indexer
                         n_this
                             +
                         ((tree_this != NULL)?
-                         (*tree_this)[node_ix].remainder
+                         (*tree_this)[(*terminal_nodes)[node_ix]].remainder
                             :
-                         (*hplane_this)[node_ix].remainder);
+                         (*hplane_this)[(*terminal_nodes)[node_ix]].remainder);
                         double sep_this_ = expected_separation_depth(sep_this) + node_depths_this[node_ix];
 
                         size_t i, j;
@@ -1435,7 +1438,8 @@ void calc_similarity_from_indexer
                 }
 
             }
-        }
+        };
+        run_parallel_for(executor, ntrees, nthreads, false, sum_separations_tree);
 
         check_interrupt_switch(ss);
 
@@ -1518,23 +1522,21 @@ void calc_similarity_from_indexer
         std::vector<std::vector<size_t>> thread_sorted_nodes(nthreads);
         for (auto &v : thread_sorted_nodes) v.reserve(nrows); /* <- could shrink to max number of terminal nodes */
 
-        bool threw_exception = false;
+        std::vector<std::vector<size_t>> thread_terminal_nodes(nthreads);
+
+        std::atomic<bool> threw_exception(false);
         std::exception_ptr ex = NULL;
-        #pragma omp parallel for schedule(static) num_threads(nthreads) \
-                shared(model_outputs, model_outputs_ext, nthreads, indexer, nrows, ncomb, terminal_indices, \
-                       sum_separations, thread_argsorted_nodes, thread_sorted_nodes, thread_doubly_argsorted, rmat, n_to, n_from, \
-                       threw_exception, ex)
-        for (size_t_for tree = 0; tree < (decltype(tree))ntrees; tree++)
+        auto sum_separations_tree = [&](size_t tree, int thread_id)
         {
-            if (interrupt_switch || threw_exception) continue;
+            if (interrupt_switch || threw_exception) return;
 
             if (unlikely(indexer->indices[tree].n_terminal <= 1))
             {
-                for (auto &el : sum_separations[omp_get_thread_num()]) el += 1.;
-                continue;
+                for (auto &el : sum_separations[thread_id]) el += 1.;
+                return;
             }
 
-            double *restrict ptr_this_sep = sum_separations[omp_get_thread_num()].data();
+            double *restrict ptr_this_sep = sum_separations[thread_id].data();
             if (nthreads == 1) ptr_this_sep = rmat;
             double *restrict node_dist_this = indexer->indices[tree].node_distances.data();
             double *restrict node_depths_this = indexer->indices[tree].node_depths.data();
@@ -1588,7 +1590,7 @@ void calc_similarity_from_indexer
 
                     if (likely(!nodes_w_repeated.empty()))
                     {
-                        std::vector<size_t> *restrict argsorted_nodes = &thread_argsorted_nodes[omp_get_thread_num()];
+                        std::vector<size_t> *restrict argsorted_nodes = &thread_argsorted_nodes[thread_id];
                         std::iota(argsorted_nodes->begin(), argsorted_nodes->end(), (size_t)0);
                         std::sort(argsorted_nodes->begin(), argsorted_nodes->end(),
                                   [&terminal_indices_this](const size_t a, const size_t b)
@@ -1596,9 +1598,11 @@ void calc_similarity_from_indexer
                         std::vector<size_t>::iterator curr_begin = argsorted_nodes->begin();
                         std::vector<size_t>::iterator new_begin;
                         
-                        std::vector<size_t> *restrict sorted_nodes = &thread_sorted_nodes[omp_get_thread_num()];
+                        std::vector<size_t> *restrict sorted_nodes = &thread_sorted_nodes[thread_id];
                         sorted_nodes->assign(nodes_w_repeated.begin(), nodes_w_repeated.end());
                         std::sort(sorted_nodes->begin(), sorted_nodes->end());
+                        std::vector<size_t> *restrict terminal_nodes = &thread_terminal_nodes[thread_id];
+                        get_terminal_nodes(*terminal_nodes, indexer->indices[tree], tree_this, hplane_this);
                         for (size_t node_ix : *sorted_nodes)
                         {
                             curr_begin = std::lower_bound(curr_begin, argsorted_nodes->end(),
@@ -1616,12 +1620,12 @@ void calc_similarity_from_indexer
                             n_this
                                 +
                             ((tree_this != NULL)?
-                             (*tree_this)[node_ix].remainder
+                             (*tree_this)[(*terminal_nodes)[node_ix]].remainder
                                 :
-                             (*hplane_this)[node_ix].remainder);
+                             (*hplane_this)[(*terminal_nodes)[node_ix]].remainder);
                             double sep_this_ = expected_separation_depth(sep_this) + node_depths_this[node_ix];
 
-                            std::vector<size_t> *restrict doubly_argsorted = &thread_doubly_argsorted[omp_get_thread_num()];
+                            std::vector<size_t> *restrict doubly_argsorted = &thread_doubly_argsorted[thread_id];
                             doubly_argsorted->assign(curr_begin, curr_begin + n_this);
                             std::sort(doubly_argsorted->begin(), doubly_argsorted->end());
                             std::vector<size_t>::iterator pos_n_from = std::lower_bound(doubly_argsorted->begin(),
@@ -1649,17 +1653,11 @@ void calc_similarity_from_indexer
 
                 catch (...)
                 {
-                    #pragma omp critical
-                    {
-                        if (!threw_exception)
-                        {
-                            threw_exception = true;
-                            ex = std::current_exception();
-                        }
-                    }
+                    catch_task_exception(threw_exception, ex);
                 }
             }
-        }
+        };
+        run_parallel_for(executor, ntrees, nthreads, false, sum_separations_tree);
 
         check_interrupt_switch(ss);
 
@@ -1752,17 +1750,20 @@ void calc_similarity_from_indexer_with_references
                     indexer);
     ignored.reset();
 
+    Executor *executor = get_thread_executor();
+    if (executor != NULL)
+        nthreads = executor->num_workers();
     #ifndef _OPENMP
-    nthreads = 1;
+    else
+        nthreads = 1;
     #endif
 
     check_interrupt_switch(ss);
 
-    #pragma omp parallel for schedule(static) num_threads(nthreads) \
-            shared(rmat, terminal_indices, nrows, n_ref, indexer, ntrees)
-    for (size_t_for row = 0; row < (decltype(row))nrows; row++)
+    auto calc_row_distances = [&](size_t row, int thread_id)
     {
-        if (interrupt_switch) continue;
+        (void)thread_id;
+        if (interrupt_switch) return;
 
         size_t i, j;
         size_t n_terminal_this;
@@ -1792,7 +1793,8 @@ void calc_similarity_from_indexer_with_references
                     rmat_this[ref] += node_dist_this[ix_comb(i, j, n_terminal_this, ncomb_this)];
             }
         }
-    }
+    };
+    run_parallel_for(executor, nrows, nthreads, false, calc_row_distances);
 
     check_interrupt_switch(ss);
 
@@ -1846,13 +1848,14 @@ void kernel_to_references(TreesIndexer &indexer,
                     &indexer);
     ignored.reset();
 
+    Executor *executor = get_thread_executor();
+
     check_interrupt_switch(ss);
 
-    #pragma omp parallel for schedule(static) num_threads(nthreads) \
-            shared(indexer, terminal_indices, nrows, ntrees, n_ref, rmat)
-    for (size_t_for row = 0; row < (decltype(row))nrows; row++)
+    auto calc_row_kernel = [&](size_t row, int thread_id)
     {
-        if (interrupt_switch) continue;
+        (void)thread_id;
+        if (interrupt_switch) return;
 
         SingleTreeIndex *restrict index_node;
         size_t idx_this;
@@ -1871,7 +1874,8 @@ void kernel_to_references(TreesIndexer &indexer,
                 rmat_this[index_node->reference_mapping[ind]]++;
             }
         }
-    }
+    };
+    run_parallel_for(executor, nrows, nthreads, false, calc_row_kernel);
 
     check_interrupt_switch(ss);
 
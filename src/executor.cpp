@@ -0,0 +1,336 @@
+/*    Isolation forests and variations thereof, with adjustments for incorporation
+*     of categorical variables and missing values.
+*     Writen for C++11 standard and aimed at being used in R and Python.
+*     
+*     This library is based on the following works:
+*     [1] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation forest."
+*         2008 Eighth IEEE International Conference on Data Mining. IEEE, 2008.
+*     [2] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation-based anomaly detection."
+*         ACM Transactions on Knowledge Discovery from Data (TKDD) 6.1 (2012): 3.
+*     [3] Hariri, Sahand, Matias Carrasco Kind, and Robert J. Brunner.
+*         "Extended Isolation Forest."
+*         arXiv preprint arXiv:1811.02141 (2018).
+*     [4] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "On detecting clustered anomalies using SCiForest."
+*         Joint European Conference on Machine Learning and Knowledge Discovery in Databases. Springer, Berlin, Heidelberg, 2010.
+*     [5] https://sourceforge.net/projects/iforest/
+*     [6] https://math.stackexchange.com/questions/3388518/expected-number-of-paths-required-to-separate-elements-in-a-binary-tree
+*     [7] Quinlan, J. Ross. C4. 5: programs for machine learning. Elsevier, 2014.
+*     [8] Cortes, David.
+*         "Distance approximation using Isolation Forests."
+*         arXiv preprint arXiv:1910.12362 (2019).
+*     [9] Cortes, David.
+*         "Imputing missing values with unsupervised random trees."
+*         arXiv preprint arXiv:1911.06646 (2019).
+*     [10] https://math.stackexchange.com/questions/3333220/expected-average-depth-in-random-binary-tree-constructed-top-to-bottom
+*     [11] Cortes, David.
+*          "Revisiting randomized choices in isolation forests."
+*          arXiv preprint arXiv:2110.13402 (2021).
+*     [12] Guha, Sudipto, et al.
+*          "Robust random cut forest based anomaly detection on streams."
+*          International conference on machine learning. PMLR, 2016.
+*     [13] Cortes, David.
+*          "Isolation forests: looking beyond tree depth."
+*          arXiv preprint arXiv:2111.11639 (2021).
+*     [14] Ting, Kai Ming, Yue Zhu, and Zhi-Hua Zhou.
+*          "Isolation kernel and its effect on SVM"
+*          Proceedings of the 24th ACM SIGKDD
+*          International Conference on Knowledge Discovery & Data Mining. 2018.
+* 
+*     BSD 2-Clause License
+*     Copyright (c) 2019-2022, David Cortes
+*     All rights reserved.
+*     Redistribution and use in source and binary forms, with or without
+*     modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this
+*       list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*       this list of conditions and the following disclaimer in the documentation
+*       and/or other materials provided with the distribution.
+*     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+*     AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+*     IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*     FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*     DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*     SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*     CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*     OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*     OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "isotree.hpp"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+static thread_local Executor *thread_executor = NULL;
+
+/* Returns the executor that was set for the calling thread through 'ScopedExecutor', or NULL
+   if there isn't any, in which case parallel loops should use OpenMP. */
+Executor* get_thread_executor() noexcept
+{
+    return thread_executor;
+}
+
+ScopedExecutor::ScopedExecutor(Executor *executor) noexcept
+{
+    this->previous = thread_executor;
+    thread_executor = executor;
+}
+
+ScopedExecutor::~ScopedExecutor()
+{
+    thread_executor = this->previous;
+}
+
+/* The pool whose loop the calling thread is currently running, if any. A thread of the
+   pool that starts another loop on the same pool (e.g. a task that calls back into the
+   library) cannot wait for the other workers, so such loops are executed in that thread. */
+static thread_local const void *running_pool = NULL;
+
+/* Each worker starts with an even share of the iterations, which it processes in small chunks
+   from the front. Once it runs out of iterations, it steals the back half of the remaining
+   range of another worker, so that uneven costs (e.g. trees of different sizes) even out. */
+struct WorkRange {
+    std::mutex mtx;
+    size_t     begin = 0;
+    size_t     end = 0;
+};
+
+struct ThreadPoolExecutor::Pool {
+    int                                         nworkers;
+    std::vector<std::thread>                    threads;
+    std::unique_ptr<WorkRange[]>                ranges;
+    std::mutex                                  job_mtx;
+    std::mutex                                  mtx;
+    std::condition_variable                     cv_start;
+    std::condition_variable                     cv_done;
+    size_t                                      generation = 0;
+    int                                         n_running = 0;
+    bool                                        stop = false;
+    size_t                                      chunk_size = 1;
+    const std::function<void(size_t, int)>     *task = NULL;
+    std::atomic<bool>                           threw_exception;
+    std::exception_ptr                          ex = NULL;
+
+    void run_worker(int worker_id) noexcept;
+    bool steal_work(int worker_id) noexcept;
+    void worker_loop(int worker_id) noexcept;
+};
+
+void ThreadPoolExecutor::Pool::run_worker(int worker_id) noexcept
+{
+    WorkRange &own = this->ranges[worker_id];
+    while (true)
+    {
+        size_t st, end;
+        {
+            std::lock_guard<std::mutex> lock(own.mtx);
+            st = own.begin;
+            end = std::min(own.end, st + this->chunk_size);
+            own.begin = end;
+        }
+
+        if (st >= end)
+        {
+            if (this->steal_work(worker_id))
+                continue;
+            return;
+        }
+
+        for (size_t ix = st; ix < end; ix++)
+        {
+            if (this->threw_exception.load(std::memory_order_relaxed))
+                return;
+            try
+            {
+                (*this->task)(ix, worker_id);
+            }
+
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(this->mtx);
+                if (!this->threw_exception)
+                {
+                    this->ex = std::current_exception();
+                    this->threw_exception = true;
+                }
+            }
+        }
+    }
+}
+
+bool ThreadPoolExecutor::Pool::steal_work(int worker_id) noexcept
+{
+    for (int offset = 1; offset < this->nworkers; offset++)
+    {
+        WorkRange &victim = this->ranges[(worker_id + offset) % this->nworkers];
+        size_t st, end;
+        {
+            std::lock_guard<std::mutex> lock(victim.mtx);
+            if (victim.begin >= victim.end)
+                continue;
+            end = victim.end;
+            st = victim.begin + (victim.end - victim.begin) / 2;
+            victim.end = st;
+        }
+
+        WorkRange &own = this->ranges[worker_id];
+        std::lock_guard<std::mutex> lock(own.mtx);
+        own.begin = st;
+        own.end = end;
+        return true;
+    }
+    return false;
+}
+
+void ThreadPoolExecutor::Pool::worker_loop(int worker_id) noexcept
+{
+    running_pool = this;
+    size_t last_generation = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(this->mtx);
+            this->cv_start.wait(lock, [&]{return this->stop || this->generation != last_generation;});
+            if (this->stop) return;
+            last_generation = this->generation;
+        }
+
+        this->run_worker(worker_id);
+
+        {
+            std::lock_guard<std::mutex> lock(this->mtx);
+            this->n_running--;
+        }
+        this->cv_done.notify_all();
+    }
+}
+
+/* The calling thread acts as worker zero, so this only launches 'nthreads-1' additional threads */
+ThreadPoolExecutor::ThreadPoolExecutor(int nthreads)
+{
+    if (nthreads <= 0)
+        nthreads = std::max(1, (int)std::thread::hardware_concurrency() + nthreads + 1);
+    this->pool = std::unique_ptr<Pool>(new Pool());
+    this->pool->nworkers = nthreads;
+    this->pool->threw_exception = false;
+    this->pool->ranges = std::unique_ptr<WorkRange[]>(new WorkRange[nthreads]);
+    this->pool->threads.reserve(nthreads - 1);
+    for (int worker_id = 1; worker_id < nthreads; worker_id++)
+        this->pool->threads.emplace_back(&Pool::worker_loop, this->pool.get(), worker_id);
+}
+
+ThreadPoolExecutor::~ThreadPoolExecutor()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->pool->mtx);
+        this->pool->stop = true;
+    }
+    this->pool->cv_start.notify_all();
+    for (std::thread &thread : this->pool->threads)
+        thread.join();
+}
+
+int ThreadPoolExecutor::num_workers() const noexcept
+{
+    return this->pool->nworkers;
+}
+
+void ThreadPoolExecutor::parallel_for(size_t n, const std::function<void(size_t, int)> &task)
+{
+    if (!n) return;
+
+    if (running_pool == this->pool.get() || this->pool->nworkers == 1 || n == 1)
+    {
+        for (size_t ix = 0; ix < n; ix++)
+            task(ix, 0);
+        return;
+    }
+
+    /* Loops submitted concurrently from different threads wait for their turn */
+    std::lock_guard<std::mutex> job_lock(this->pool->job_mtx);
+    Pool &pool = *this->pool;
+    size_t nworkers = (size_t)pool.nworkers;
+    for (size_t worker = 0; worker < nworkers; worker++)
+    {
+        std::lock_guard<std::mutex> lock(pool.ranges[worker].mtx);
+        pool.ranges[worker].begin = (n * worker) / nworkers;
+        pool.ranges[worker].end = (n * (worker + 1)) / nworkers;
+    }
+    pool.chunk_size = std::max((size_t)1, n / (nworkers * 16));
+    pool.task = &task;
+    pool.threw_exception = false;
+    pool.ex = NULL;
+
+    {
+        std::lock_guard<std::mutex> lock(pool.mtx);
+        pool.n_running = pool.nworkers - 1;
+        pool.generation++;
+    }
+    pool.cv_start.notify_all();
+
+    const void *previous_pool = running_pool;
+    running_pool = &pool;
+    pool.run_worker(0);
+    running_pool = previous_pool;
+
+    {
+        std::unique_lock<std::mutex> lock(pool.mtx);
+        pool.cv_done.wait(lock, [&pool]{return pool.n_running == 0;});
+    }
+    pool.task = NULL;
+
+    if (pool.threw_exception)
+        std::rethrow_exception(pool.ex);
+}
+
+OpenMPExecutor::OpenMPExecutor(int nthreads)
+{
+    #ifdef _OPENMP
+    if (nthreads <= 0)
+        nthreads = std::max(1, omp_get_max_threads() + nthreads + 1);
+    this->nthreads = nthreads;
+    #else
+    this->nthreads = 1;
+    #endif
+}
+
+int OpenMPExecutor::num_workers() const noexcept
+{
+    return this->nthreads;
+}
+
+void OpenMPExecutor::parallel_for(size_t n, const std::function<void(size_t, int)> &task)
+{
+    bool threw_exception = false;
+    std::exception_ptr ex = NULL;
+
+    #pragma omp parallel for schedule(dynamic) num_threads(this->nthreads) shared(n, task, threw_exception, ex)
+    for (size_t_for ix = 0; ix < (decltype(ix))n; ix++)
+    {
+        if (threw_exception) continue;
+        try
+        {
+            task((size_t)ix, omp_get_thread_num());
+        }
+
+        catch (...)
+        {
+            #pragma omp critical
+            {
+                if (!threw_exception)
+                {
+                    threw_exception = true;
+                    ex = std::current_exception();
+                }
+            }
+        }
+    }
+
+    if (threw_exception)
+        std::rethrow_exception(ex);
+}
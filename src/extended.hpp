@@ -62,20 +62,24 @@
 */
 #include "isotree.hpp"
 
+/* Determines the split for the node at the end of 'hplanes', leaving the workspace set up for its left
+   branch, which is added as a new node. If the node ends up being terminal, calculates its score
+   instead and returns 'false'. The right branch is set up afterwards through 'split_hplane_right'. */
 template <class InputData, class WorkerMemory, class ldouble_safe>
-void split_hplane_recursive(std::vector<IsoHPlane>   &hplanes,
-                            WorkerMemory             &workspace,
-                            InputData                &input_data,
-                            ModelParams              &model_params,
-                            std::vector<ImputeNode> *impute_nodes,
-                            size_t                   curr_depth)
+bool split_hplane_node(std::vector<IsoHPlane>   &hplanes,
+                       WorkerMemory             &workspace,
+                       InputData                &input_data,
+                       ModelParams              &model_params,
+                       std::vector<ImputeNode> *impute_nodes,
+                       size_t                   curr_depth)
 {
-    if (interrupt_switch) return;
+    if (interrupt_switch) return false;
     ldouble_safe sum_weight = -HUGE_VAL;
     size_t hplane_from = hplanes.size() - 1;
-    std::unique_ptr<RecursionState> recursion_state;
-    std::vector<bool> col_is_taken;
-    hashed_set<size_t> col_is_taken_s;
+    std::vector<bool> &col_is_taken = workspace.col_is_taken;
+    hashed_set<size_t> &col_is_taken_s = workspace.col_is_taken_s;
+    col_is_taken.clear();
+    col_is_taken_s.clear();
 
     /* calculate imputation statistics if desired */
     if (impute_nodes != NULL)
@@ -330,7 +334,7 @@ void split_hplane_recursive(std::vector<IsoHPlane>   &hplanes,
                  workspace.col_sampler.sample_col(workspace.col_chosen, workspace.rnd_generator))
             )
         {
-            if (interrupt_switch) return;
+            if (interrupt_switch) return false;
 
             if (workspace.col_criterion != Uniformly) goto add_this_col;
             
@@ -387,6 +391,7 @@ void split_hplane_recursive(std::vector<IsoHPlane>   &hplanes,
                                                        model_params.ncols_per_tree < input_data.ncols_numeric,
                                                        input_data.X_row_major.data(),
                                                        input_data.ncols_numeric,
+                                                       workspace.split_scratch.buffer_ix.data(), workspace.split_scratch.buffer_x.data(),
                                                        input_data.Xr.data(),
                                                        input_data.Xr_ind.data(),
                                                        input_data.Xr_indptr.data());
@@ -403,6 +408,7 @@ void split_hplane_recursive(std::vector<IsoHPlane>   &hplanes,
                                                                 model_params.ncols_per_tree < input_data.ncols_numeric,
                                                                 input_data.X_row_major.data(),
                                                                 input_data.ncols_numeric,
+                                                                workspace.split_scratch.buffer_x.data(),
                                                                 input_data.Xr.data(),
                                                                 input_data.Xr_ind.data(),
                                                                 input_data.Xr_indptr.data());
@@ -419,6 +425,7 @@ void split_hplane_recursive(std::vector<IsoHPlane>   &hplanes,
                                                                 model_params.ncols_per_tree < input_data.ncols_numeric,
                                                                 input_data.X_row_major.data(),
                                                                 input_data.ncols_numeric,
+                                                                workspace.split_scratch.buffer_x.data(),
                                                                 input_data.Xr.data(),
                                                                 input_data.Xr_ind.data(),
                                                                 input_data.Xr_indptr.data());
@@ -427,7 +434,7 @@ void split_hplane_recursive(std::vector<IsoHPlane>   &hplanes,
         /* pass to the output object */
         if (workspace.ntry == 1 || workspace.this_gain > hplanes.back().score)
         {
-            /* these should be shrunk later according to what ends up used */
+            /* the columns are kept in the workspace and copied to the node once it is split */
             hplanes.back().score = workspace.this_gain;
             workspace.ntaken_best = workspace.ntaken;
             if (workspace.criterion != NoCrit)
@@ -439,16 +446,16 @@ void split_hplane_recursive(std::vector<IsoHPlane>   &hplanes,
                     hplanes.back().range_high = workspace.xmax - workspace.xmin + hplanes.back().split_point;
                 }
             }
-            hplanes.back().col_num.assign(workspace.col_take.begin(), workspace.col_take.begin() + workspace.ntaken);
-            hplanes.back().col_type.assign(workspace.col_take_type.begin(), workspace.col_take_type.begin() + workspace.ntaken);
+            workspace.hplane_best.col_num.assign(workspace.col_take.begin(), workspace.col_take.begin() + workspace.ntaken);
+            workspace.hplane_best.col_type.assign(workspace.col_take_type.begin(), workspace.col_take_type.begin() + workspace.ntaken);
             if (input_data.ncols_numeric)
             {
-                hplanes.back().coef.assign(workspace.ext_coef.begin(), workspace.ext_coef.begin() + workspace.ntaken);
-                hplanes.back().mean.assign(workspace.ext_mean.begin(), workspace.ext_mean.begin() + workspace.ntaken);
+                workspace.hplane_best.coef.assign(workspace.ext_coef.begin(), workspace.ext_coef.begin() + workspace.ntaken);
+                workspace.hplane_best.mean.assign(workspace.ext_mean.begin(), workspace.ext_mean.begin() + workspace.ntaken);
             }
 
             if (model_params.missing_action != Fail)
-                hplanes.back().fill_val.assign(workspace.ext_fill_val.begin(), workspace.ext_fill_val.begin() + workspace.ntaken);
+                workspace.hplane_best.fill_val.assign(workspace.ext_fill_val.begin(), workspace.ext_fill_val.begin() + workspace.ntaken);
 
             if (model_params.scoring_metric != Depth && !is_boxed_metric(model_params.scoring_metric))
             {
@@ -457,26 +464,26 @@ void split_hplane_recursive(std::vector<IsoHPlane>   &hplanes,
 
             if (input_data.ncols_categ)
             {
-                hplanes.back().fill_new.assign(workspace.ext_fill_new.begin(), workspace.ext_fill_new.begin() + workspace.ntaken);
+                workspace.hplane_best.fill_new.assign(workspace.ext_fill_new.begin(), workspace.ext_fill_new.begin() + workspace.ntaken);
                 switch(model_params.cat_split_type)
                 {
                     case SingleCateg:
                     {
-                        hplanes.back().chosen_cat.assign(workspace.chosen_cat.begin(),
-                                                         workspace.chosen_cat.begin() + workspace.ntaken);
+                        workspace.hplane_best.chosen_cat.assign(workspace.chosen_cat.begin(),
+                                                                workspace.chosen_cat.begin() + workspace.ntaken);
                         break;
                     }
 
                     case SubSet:
                     {
-                        if (hplanes.back().cat_coef.size() < workspace.ntaken)
-                             hplanes.back().cat_coef.assign(workspace.ext_cat_coef.begin(),
-                                                            workspace.ext_cat_coef.begin() + workspace.ntaken);
+                        if (workspace.hplane_best.cat_coef.size() < workspace.ntaken)
+                             workspace.hplane_best.cat_coef.assign(workspace.ext_cat_coef.begin(),
+                                                                   workspace.ext_cat_coef.begin() + workspace.ntaken);
                         else
                             for (size_t col = 0; col < workspace.ntaken_best; col++)
                                 std::copy(workspace.ext_cat_coef[col].begin(),
                                           workspace.ext_cat_coef[col].end(),
-                                          hplanes.back().cat_coef[col].begin());
+                                          workspace.hplane_best.cat_coef[col].begin());
                         break;
                     }
                 }
@@ -486,7 +493,6 @@ void split_hplane_recursive(std::vector<IsoHPlane>   &hplanes,
     }
 
     col_is_taken.clear();
-    col_is_taken.shrink_to_fit();
     col_is_taken_s.clear();
 
     /* if the best split is not good enough, don't split any further */
@@ -501,26 +507,26 @@ void split_hplane_recursive(std::vector<IsoHPlane>   &hplanes,
                   (double)0);
         for (size_t col = 0; col < workspace.ntaken_best; col++)
         {
-            switch(hplanes.back().col_type[col])
+            switch(workspace.hplane_best.col_type[col])
             {
                 case Numeric:
                 {
                     if (input_data.Xc_indptr == NULL)
                     {
                         add_linear_comb(workspace.ix_arr.data(), workspace.st, workspace.end, workspace.comb_val.data(),
-                                        input_data.numeric_data + hplanes.back().col_num[col] * input_data.nrows,
-                                        hplanes.back().coef[col], (double)0, hplanes.back().mean[col],
-                                        hplanes.back().fill_val.size()? hplanes.back().fill_val[col] : workspace.this_split_point, /* second case is not used */
+                                        input_data.numeric_data + workspace.hplane_best.col_num[col] * input_data.nrows,
+                                        workspace.hplane_best.coef[col], (double)0, workspace.hplane_best.mean[col],
+                                        workspace.hplane_best.fill_val.size()? workspace.hplane_best.fill_val[col] : workspace.this_split_point, /* second case is not used */
                                         model_params.missing_action, NULL, NULL, false);
                     }
 
                     else
                     {
                         add_linear_comb(workspace.ix_arr.data(), workspace.st, workspace.end,
-                                        hplanes.back().col_num[col], workspace.comb_val.data(),
+                                        workspace.hplane_best.col_num[col], workspace.comb_val.data(),
                                         input_data.Xc, input_data.Xc_ind, input_data.Xc_indptr,
-                                        hplanes.back().coef[col], (double)0, hplanes.back().mean[col],
-                                        hplanes.back().fill_val.size()? hplanes.back().fill_val[col] : workspace.this_split_point, /* second case is not used */
+                                        workspace.hplane_best.coef[col], (double)0, workspace.hplane_best.mean[col],
+                                        workspace.hplane_best.fill_val.size()? workspace.hplane_best.fill_val[col] : workspace.this_split_point, /* second case is not used */
                                         model_params.missing_action, NULL, NULL, false);
                     }
 
@@ -531,13 +537,13 @@ void split_hplane_recursive(std::vector<IsoHPlane>   &hplanes,
                 {
                     add_linear_comb<ldouble_safe>(
                                     workspace.ix_arr.data(), workspace.st, workspace.end, workspace.comb_val.data(),
-                                    input_data.categ_data + hplanes.back().col_num[col] * input_data.nrows,
-                                    input_data.ncat[hplanes.back().col_num[col]],
-                                    (model_params.cat_split_type == SubSet)? hplanes.back().cat_coef[col].data() : NULL,
-                                    (model_params.cat_split_type == SingleCateg)? hplanes.back().fill_new[col] : (double)0,
-                                    (model_params.cat_split_type == SingleCateg)? hplanes.back().chosen_cat[col] : 0,
-                                    (hplanes.back().fill_val.size())? hplanes.back().fill_val[col] : workspace.this_split_point, /* second case is not used */
-                                    (model_params.cat_split_type == SubSet)? hplanes.back().fill_new[col] : workspace.this_split_point, /* second case is not used */
+                                    input_data.categ_data + workspace.hplane_best.col_num[col] * input_data.nrows,
+                                    input_data.ncat[workspace.hplane_best.col_num[col]],
+                                    (model_params.cat_split_type == SubSet)? workspace.hplane_best.cat_coef[col].data() : NULL,
+                                    (model_params.cat_split_type == SingleCateg)? workspace.hplane_best.fill_new[col] : (double)0,
+                                    (model_params.cat_split_type == SingleCateg)? workspace.hplane_best.chosen_cat[col] : 0,
+                                    (workspace.hplane_best.fill_val.size())? workspace.hplane_best.fill_val[col] : workspace.this_split_point, /* second case is not used */
+                                    (model_params.cat_split_type == SubSet)? workspace.hplane_best.fill_new[col] : workspace.this_split_point, /* second case is not used */
                                     NULL, NULL, model_params.new_cat_action, model_params.missing_action,
                                     model_params.cat_split_type, false);
                     break;
@@ -589,11 +595,8 @@ void split_hplane_recursive(std::vector<IsoHPlane>   &hplanes,
     if (model_params.calc_dist && curr_depth > 0)
         add_separation_step(workspace, input_data, (double)(-1));
 
-    /* simplify vectors according to what ends up used */
-    if (input_data.ncols_categ || workspace.ntaken_best < model_params.ndim)
-        simplify_hplane(hplanes.back(), workspace, input_data, model_params);
-
-    shrink_to_fit_hplane(hplanes.back(), false);
+    /* copy the columns that ended up used */
+    simplify_hplane(hplanes.back(), workspace, input_data, model_params);
 
     /* if using a custom scoring metric, need to calculate it now */
     if (model_params.scoring_metric != Depth)
@@ -654,50 +657,14 @@ void split_hplane_recursive(std::vector<IsoHPlane>   &hplanes,
     /* now split */
 
     /* back-up where it was */
-    recursion_state = std::unique_ptr<RecursionState>(new RecursionState(workspace, true));
+    workspace.recursion_arena.push_state(workspace, true);
 
     /* follow left branch */
     hplanes[hplane_from].hplane_left = hplanes.size();
     hplanes.emplace_back();
     if (impute_nodes != NULL) impute_nodes->emplace_back(hplane_from);
     workspace.end = workspace.split_ix - 1;
-    split_hplane_recursive<InputData, WorkerMemory, ldouble_safe>(
-                           hplanes,
-                           workspace,
-                           input_data,
-                           model_params,
-                           impute_nodes,
-                           curr_depth + 1);
-
-
-    /* follow right branch */
-    hplanes[hplane_from].hplane_right = hplanes.size();
-    recursion_state->restore_state(workspace);
-    hplanes.emplace_back();
-
-    if (impute_nodes != NULL) impute_nodes->emplace_back(hplane_from);
-    if (is_boxed_metric(model_params.scoring_metric)) {
-        workspace.density_calculator.pop_bdens_ext();
-    }
-    else if (model_params.scoring_metric != Depth) {
-        workspace.density_calculator.pop();
-    }
-    workspace.st = workspace.split_ix;
-    split_hplane_recursive<InputData, WorkerMemory, ldouble_safe>(
-                           hplanes,
-                           workspace,
-                           input_data,
-                           model_params,
-                           impute_nodes,
-                           curr_depth + 1);
-    if (is_boxed_metric(model_params.scoring_metric)) {
-        workspace.density_calculator.pop_bdens_ext_right();
-    }
-    else if (model_params.scoring_metric != Depth) {
-        workspace.density_calculator.pop_right();
-    }
-
-    return;
+    return true;
 
     terminal_statistics:
     {
@@ -794,6 +761,151 @@ void split_hplane_recursive(std::vector<IsoHPlane>   &hplanes,
         if (model_params.impute_at_fit)
             add_from_impute_node(impute_nodes->back(), workspace, input_data);
     }
+
+    return false;
+}
+
+/* Restores the workspace as it was before following the left branch of node 'hplane_from', and
+   sets it up for the right branch, which is added as a new node */
+template <class WorkerMemory>
+void split_hplane_right(std::vector<IsoHPlane>   &hplanes,
+                        WorkerMemory             &workspace,
+                        ModelParams              &model_params,
+                        std::vector<ImputeNode> *impute_nodes,
+                        size_t                   hplane_from)
+{
+    hplanes[hplane_from].hplane_right = hplanes.size();
+    workspace.recursion_arena.pop_state(workspace);
+    hplanes.emplace_back();
+
+    if (impute_nodes != NULL) impute_nodes->emplace_back(hplane_from);
+    if (is_boxed_metric(model_params.scoring_metric)) {
+        workspace.density_calculator.pop_bdens_ext();
+    }
+    else if (model_params.scoring_metric != Depth) {
+        workspace.density_calculator.pop();
+    }
+    workspace.st = workspace.split_ix;
+}
+
+/* Undoes the changes from a node in the density calculator after both of its branches are done */
+template <class WorkerMemory>
+void finish_hplane_node(WorkerMemory &workspace, ModelParams &model_params)
+{
+    if (is_boxed_metric(model_params.scoring_metric)) {
+        workspace.density_calculator.pop_bdens_ext_right();
+    }
+    else if (model_params.scoring_metric != Depth) {
+        workspace.density_calculator.pop_right();
+    }
+}
+
+/* Grows a tree from the root node at the end of 'hplanes', in the same order as a recursive depth-first
+   procedure would, but through an explicit stack kept in the workspace so that deep trees do not
+   overflow the call stack. The root node might be a branch of a larger tree, at depth 'root_depth'. */
+template <class InputData, class WorkerMemory, class ldouble_safe>
+void grow_hplane_tree(std::vector<IsoHPlane>   &hplanes,
+                      WorkerMemory             &workspace,
+                      InputData                &input_data,
+                      ModelParams              &model_params,
+                      std::vector<ImputeNode> *impute_nodes,
+                      size_t                   root_depth)
+{
+    std::vector<GrowFrame> &stack = workspace.grow_stack;
+    stack.clear();
+    workspace.recursion_arena.clear();
+    workspace.fork_states.clear();
+    stack.push_back({hplanes.size() - 1, root_depth, SplitNode, false});
+
+    while (!stack.empty())
+    {
+        if (interrupt_switch) return;
+        GrowFrame frame = stack.back();
+        switch (frame.stage)
+        {
+            case SplitNode:
+            {
+                bool is_fork = workspace.end - workspace.st + 1 > NODE_TASK_MIN_ROWS;
+                if (split_hplane_node<InputData, WorkerMemory, ldouble_safe>(
+                                      hplanes, workspace, input_data, model_params,
+                                      impute_nodes, frame.depth))
+                {
+                    if (is_fork) fork_node(workspace);
+                    stack.back().stage = FollowRight;
+                    stack.back().is_fork = is_fork;
+                    stack.push_back({hplanes.size() - 1, frame.depth + 1, SplitNode, false});
+                }
+                else
+                {
+                    stack.pop_back();
+                }
+                break;
+            }
+
+            case FollowRight:
+            {
+                if (frame.is_fork) resume_fork_right(workspace);
+                split_hplane_right(hplanes, workspace, model_params, impute_nodes, frame.node);
+                stack.back().stage = FinishNode;
+                stack.push_back({hplanes.size() - 1, frame.depth + 1, SplitNode, false});
+                break;
+            }
+
+            case FinishNode:
+            {
+                finish_hplane_node(workspace, model_params);
+                stack.pop_back();
+                break;
+            }
+        }
+    }
+}
+
+/* Same as 'grow_itree_task', for the extended model */
+template <class InputData, class WorkerMemory, class ldouble_safe>
+void grow_hplane_task(NodeTask<WorkerMemory>  &task,
+                      WorkerMemory            &workspace,
+                      InputData               &input_data,
+                      ModelParams             &model_params,
+                      bool                    build_imputer)
+{
+    size_t hplane_from = task.n_chain;
+    task.hplanes.resize(hplane_from + 1);
+    std::vector<ImputeNode> *impute_nodes = NULL;
+    if (build_imputer)
+    {
+        impute_nodes = &task.impute_nodes;
+        impute_nodes->swap(task.impute_chain);
+        impute_nodes->emplace_back(hplane_from? (hplane_from - 1) : (size_t)0);
+    }
+
+    if (task.nrows <= model_params.node_task_rows)
+    {
+        grow_hplane_tree<InputData, WorkerMemory, ldouble_safe>(
+                         task.hplanes, workspace, input_data, model_params,
+                         impute_nodes, task.depth);
+        return;
+    }
+
+    workspace.recursion_arena.clear();
+    workspace.fork_states.clear();
+    if (!split_hplane_node<InputData, WorkerMemory, ldouble_safe>(
+                           task.hplanes, workspace, input_data, model_params,
+                           impute_nodes, task.depth))
+        return;
+    fork_node(workspace);
+
+    task.left = std::unique_ptr<NodeTask<WorkerMemory>>(new NodeTask<WorkerMemory>());
+    capture_node_task(*task.left, workspace, input_data, impute_nodes, hplane_from + 1, task.depth + 1);
+    resume_fork_right(workspace);
+    split_hplane_right(task.hplanes, workspace, model_params, impute_nodes, hplane_from);
+    task.right = std::unique_ptr<NodeTask<WorkerMemory>>(new NodeTask<WorkerMemory>());
+    capture_node_task(*task.right, workspace, input_data, impute_nodes, hplane_from + 1, task.depth + 1);
+
+    /* the branches are added by their own tasks */
+    task.hplanes.resize(hplane_from + 1);
+    if (impute_nodes != NULL)
+        impute_nodes->resize(hplane_from + 1);
 }
 
 
@@ -932,7 +1044,9 @@ void add_chosen_column(WorkerMemory &workspace, InputData &input_data, ModelPara
                                              input_data.numeric_data + workspace.col_chosen * input_data.nrows,
                                              workspace.ext_coef[workspace.ntaken], workspace.ext_sd, workspace.ext_mean[workspace.ntaken],
                                              workspace.ext_fill_val[workspace.ntaken], model_params.missing_action,
-                                             workspace.buffer_dbl.data(), workspace.buffer_szt.data(), true,
+                                             workspace.buffer_dbl.data(), workspace.buffer_szt.data(),
+                                             workspace.split_scratch.buffer_w.data(), workspace.split_scratch.buffer_ix.data(),
+                                             true,
                                              workspace.weights_arr);
                 }
 
@@ -985,7 +1099,9 @@ void add_chosen_column(WorkerMemory &workspace, InputData &input_data, ModelPara
                                              input_data.numeric_data + workspace.col_chosen * input_data.nrows,
                                              workspace.ext_coef[workspace.ntaken], workspace.ext_sd, workspace.ext_mean[workspace.ntaken],
                                              workspace.ext_fill_val[workspace.ntaken], model_params.missing_action,
-                                             workspace.buffer_dbl.data(), workspace.buffer_szt.data(), true,
+                                             workspace.buffer_dbl.data(), workspace.buffer_szt.data(),
+                                             workspace.split_scratch.buffer_w.data(), workspace.split_scratch.buffer_ix.data(),
+                                             true,
                                              workspace.weights_map);
                 }
             }
@@ -1098,7 +1214,9 @@ void add_chosen_column(WorkerMemory &workspace, InputData &input_data, ModelPara
                                              input_data.Xc, input_data.Xc_ind, input_data.Xc_indptr,
                                              workspace.ext_coef[workspace.ntaken], workspace.ext_sd, workspace.ext_mean[workspace.ntaken],
                                              workspace.ext_fill_val[workspace.ntaken], model_params.missing_action,
-                                             workspace.buffer_dbl.data(), workspace.buffer_szt.data(), true,
+                                             workspace.buffer_dbl.data(), workspace.buffer_szt.data(),
+                                             workspace.split_scratch.buffer_x.data(), workspace.split_scratch.buffer_w.data(), workspace.split_scratch.buffer_ix.data(),
+                                             true,
                                              workspace.weights_arr);
                 }
 
@@ -1156,7 +1274,9 @@ void add_chosen_column(WorkerMemory &workspace, InputData &input_data, ModelPara
                                              input_data.Xc, input_data.Xc_ind, input_data.Xc_indptr,
                                              workspace.ext_coef[workspace.ntaken], workspace.ext_sd, workspace.ext_mean[workspace.ntaken],
                                              workspace.ext_fill_val[workspace.ntaken], model_params.missing_action,
-                                             workspace.buffer_dbl.data(), workspace.buffer_szt.data(), true,
+                                             workspace.buffer_dbl.data(), workspace.buffer_szt.data(),
+                                             workspace.split_scratch.buffer_x.data(), workspace.split_scratch.buffer_w.data(), workspace.split_scratch.buffer_ix.data(),
+                                             true,
                                              workspace.weights_map);
                 }
 
@@ -1194,7 +1314,7 @@ void add_chosen_column(WorkerMemory &workspace, InputData &input_data, ModelPara
                                                  NULL, workspace.ext_fill_new[workspace.ntaken],
                                                  workspace.chosen_cat[workspace.ntaken],
                                                  workspace.ext_fill_val[workspace.ntaken], workspace.ext_fill_new[workspace.ntaken],
-                                                 NULL, model_params.new_cat_action, model_params.missing_action, SingleCateg, true,
+                                                 NULL, NULL, model_params.new_cat_action, model_params.missing_action, SingleCateg, true,
                                                  workspace.weights_arr);
                     }
 
@@ -1207,7 +1327,7 @@ void add_chosen_column(WorkerMemory &workspace, InputData &input_data, ModelPara
                                                  NULL, workspace.ext_fill_new[workspace.ntaken],
                                                  workspace.chosen_cat[workspace.ntaken],
                                                  workspace.ext_fill_val[workspace.ntaken], workspace.ext_fill_new[workspace.ntaken],
-                                                 NULL, model_params.new_cat_action, model_params.missing_action, SingleCateg, true,
+                                                 NULL, NULL, model_params.new_cat_action, model_params.missing_action, SingleCateg, true,
                                                  workspace.weights_map);
                     }
 
@@ -1262,7 +1382,7 @@ void add_chosen_column(WorkerMemory &workspace, InputData &input_data, ModelPara
                                                  input_data.ncat[workspace.col_chosen],
                                                  workspace.ext_cat_coef[workspace.ntaken].data(), (double)0, (int)0,
                                                  workspace.ext_fill_val[workspace.ntaken], workspace.ext_fill_new[workspace.ntaken],
-                                                 workspace.buffer_szt.data(),
+                                                 workspace.buffer_szt.data(), workspace.split_scratch.buffer_cnt.data(),
                                                  model_params.new_cat_action, model_params.missing_action, SubSet, true,
                                                  workspace.weights_arr);
                     }
@@ -1275,7 +1395,7 @@ void add_chosen_column(WorkerMemory &workspace, InputData &input_data, ModelPara
                                                  input_data.ncat[workspace.col_chosen],
                                                  workspace.ext_cat_coef[workspace.ntaken].data(), (double)0, (int)0,
                                                  workspace.ext_fill_val[workspace.ntaken], workspace.ext_fill_new[workspace.ntaken],
-                                                 workspace.buffer_szt.data(),
+                                                 workspace.buffer_szt.data(), workspace.split_scratch.buffer_cnt.data(),
                                                  model_params.new_cat_action, model_params.missing_action, SubSet, true,
                                                  workspace.weights_map);
                     }
@@ -1318,127 +1438,74 @@ void shrink_to_fit_hplane(IsoHPlane &hplane, bool clear_vectors)
     hplane.fill_new.shrink_to_fit();
 }
 
+/* Copies the linear combination saved in 'workspace.hplane_best' to the node, keeping only the columns that
+   ended up used, with the coefficients and categorical parameters put in the order of their column types.
+   The vectors of the node are only assigned here, so they get allocated with their exact sizes. */
 template <class InputData, class WorkerMemory>
 void simplify_hplane(IsoHPlane &hplane, WorkerMemory &workspace, InputData &input_data, ModelParams &model_params)
 {
-    if (workspace.ntaken_best < model_params.ndim)
-    {
-        hplane.col_num.resize(workspace.ntaken_best);
-        hplane.col_type.resize(workspace.ntaken_best);
-        if (model_params.missing_action != Fail)
-            hplane.fill_val.resize(workspace.ntaken_best);
-    }
+    IsoHPlane &best = workspace.hplane_best;
+    size_t ntaken = workspace.ntaken_best;
+    hplane.col_num.assign(best.col_num.begin(), best.col_num.begin() + ntaken);
+    hplane.col_type.assign(best.col_type.begin(), best.col_type.begin() + ntaken);
+    if (model_params.missing_action != Fail)
+        hplane.fill_val.assign(best.fill_val.begin(), best.fill_val.begin() + ntaken);
 
-    size_t ncols_numeric = 0;
-    size_t ncols_categ   = 0;
-
-    if (input_data.ncols_categ)
+    /* If there are no categorical columns, all of them will be numerical and there is no need to reorder */
+    if (!input_data.ncols_categ)
     {
-        for (size_t col = 0; col < workspace.ntaken_best; col++)
-        {
-            switch(hplane.col_type[col])
-            {
-                case Numeric:
-                {
-                    workspace.ext_coef[ncols_numeric] = hplane.coef[col];
-                    workspace.ext_mean[ncols_numeric] = hplane.mean[col];
-                    ncols_numeric++;
-                    break;
-                }
-
-                case Categorical:
-                {
-                    workspace.ext_fill_new[ncols_categ] = hplane.fill_new[col];
-                    switch(model_params.cat_split_type)
-                    {
-                        case SingleCateg:
-                        {
-                            workspace.chosen_cat[ncols_categ] = hplane.chosen_cat[col];
-                            break;
-                        }
-
-                        case SubSet:
-                        {
-                            std::copy(hplane.cat_coef[col].begin(),
-                                      hplane.cat_coef[col].begin() + input_data.ncat[hplane.col_num[col]],
-                                      workspace.ext_cat_coef[ncols_categ].begin());
-                            break;
-                        }
-                    }
-                    ncols_categ++;
-                    break;
-                }
-
-                default:
-                {
-                    unexpected_error();
-                    break;
-                }
-            }
-        }
+        hplane.coef.assign(best.coef.begin(), best.coef.begin() + ntaken);
+        hplane.mean.assign(best.mean.begin(), best.mean.begin() + ntaken);
+        return;
     }
 
+    size_t ncols_categ = std::count(best.col_type.begin(), best.col_type.begin() + ntaken, Categorical);
+    size_t ncols_numeric = ntaken - ncols_categ;
+    hplane.coef.reserve(ncols_numeric);
+    hplane.mean.reserve(ncols_numeric);
+    hplane.fill_new.reserve(ncols_categ);
+    if (model_params.cat_split_type == SingleCateg)
+        hplane.chosen_cat.reserve(ncols_categ);
     else
-    {
-        ncols_numeric = workspace.ntaken_best;
-    }
-
+        hplane.cat_coef.reserve(ncols_categ);
 
-    hplane.coef.resize(ncols_numeric);
-    hplane.mean.resize(ncols_numeric);
-    if (input_data.ncols_numeric)
+    for (size_t col = 0; col < ntaken; col++)
     {
-        std::copy(workspace.ext_coef.begin(), workspace.ext_coef.begin() + ncols_numeric, hplane.coef.begin());
-        std::copy(workspace.ext_mean.begin(), workspace.ext_mean.begin() + ncols_numeric, hplane.mean.begin());
-    }
-
-    /* If there are no categorical columns, all of them will be numerical and there is no need to reorder */
-    if (ncols_categ)
-    {
-        hplane.fill_new.resize(ncols_categ);
-        std::copy(workspace.ext_fill_new.begin(),
-                  workspace.ext_fill_new.begin() + ncols_categ,
-                  hplane.fill_new.begin());
-
-        hplane.cat_coef.resize(ncols_categ);
-        switch(model_params.cat_split_type)
+        switch(best.col_type[col])
         {
-            case SingleCateg:
+            case Numeric:
             {
-                hplane.chosen_cat.resize(ncols_categ);
-                std::copy(workspace.chosen_cat.begin(),
-                          workspace.chosen_cat.begin() + ncols_categ,
-                          hplane.chosen_cat.begin());
-                hplane.cat_coef.clear();
+                hplane.coef.push_back(best.coef[col]);
+                hplane.mean.push_back(best.mean[col]);
                 break;
             }
 
-            case SubSet:
+            case Categorical:
             {
-                hplane.chosen_cat.clear();
-                ncols_categ = 0;
-                for (size_t col = 0; col < workspace.ntaken_best; col++)
+                hplane.fill_new.push_back(best.fill_new[col]);
+                switch(model_params.cat_split_type)
                 {
-                    if (hplane.col_type[col] == Categorical)
+                    case SingleCateg:
                     {
-                        hplane.cat_coef[ncols_categ].resize(input_data.ncat[hplane.col_num[col]]);
-                        std::copy(workspace.ext_cat_coef[ncols_categ].begin(),
-                                  workspace.ext_cat_coef[ncols_categ].begin()
-                                   + input_data.ncat[hplane.col_num[col]],
-                                  hplane.cat_coef[ncols_categ].begin());
-                        hplane.cat_coef[ncols_categ].shrink_to_fit();
-                        ncols_categ++;
+                        hplane.chosen_cat.push_back(best.chosen_cat[col]);
+                        break;
+                    }
+
+                    case SubSet:
+                    {
+                        hplane.cat_coef.emplace_back(best.cat_coef[col].begin(),
+                                                     best.cat_coef[col].begin() + input_data.ncat[best.col_num[col]]);
+                        break;
                     }
                 }
                 break;
             }
-        }
-    }
 
-    else
-    {
-        hplane.cat_coef.clear();
-        hplane.chosen_cat.clear();
-        hplane.fill_new.clear();
+            default:
+            {
+                unexpected_error();
+                break;
+            }
+        }
     }
 }
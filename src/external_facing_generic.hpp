@@ -84,6 +84,31 @@ int fit_iforest(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
                 UseDepthImp depth_imp, WeighImpRows weigh_imp_rows, bool impute_at_fit,
                 uint64_t random_seed, bool use_long_double, int nthreads);
 ISOTREE_EXPORTED
+int fit_iforest(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
+                real_t numeric_data[],  size_t ncols_numeric,
+                int    categ_data[],    size_t ncols_categ,    int ncat[],
+                bool is_col_major, size_t ld_numeric, size_t ld_categ,
+                real_t Xc[], sparse_ix Xc_ind[], sparse_ix Xc_indptr[],
+                size_t ndim, size_t ntry, CoefType coef_type, bool coef_by_prop,
+                real_t sample_weights[], bool with_replacement, bool weight_as_sample,
+                size_t nrows, size_t sample_size, size_t ntrees,
+                size_t max_depth,   size_t ncols_per_tree,
+                bool   limit_depth, bool penalize_range, bool standardize_data,
+                ScoringMetric scoring_metric, bool fast_bratio,
+                bool   standardize_dist, double tmat[],
+                double output_depths[], bool standardize_depth,
+                real_t col_weights[], bool weigh_by_kurt,
+                double prob_pick_by_gain_pl, double prob_pick_by_gain_avg,
+                double prob_pick_by_full_gain, double prob_pick_by_dens,
+                double prob_pick_col_by_range, double prob_pick_col_by_var,
+                double prob_pick_col_by_kurt,
+                double min_gain, SplitSearch split_search, MissingAction missing_action,
+                CategSplit cat_split_type, NewCategAction new_cat_action,
+                bool   all_perm, Imputer *imputer, size_t min_imp_obs,
+                UseDepthImp depth_imp, WeighImpRows weigh_imp_rows, bool impute_at_fit,
+                uint64_t random_seed, bool use_long_double, size_t node_task_rows,
+                bool reorder_nodes_after_fit, int nthreads);
+ISOTREE_EXPORTED
 int add_tree(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
              real_t numeric_data[],  size_t ncols_numeric,
              int    categ_data[],    size_t ncols_categ,    int ncat[],
@@ -414,4 +439,68 @@ void set_reference_points(IsoForest *model_outputs, ExtIsoForest *model_outputs_
                           real_t *Xc, sparse_ix *Xc_ind, sparse_ix *Xc_indptr,
                           real_t *Xr, sparse_ix *Xr_ind, sparse_ix *Xr_indptr,
                           size_t nrows, int nthreads);
+ISOTREE_EXPORTED
+void bin_numeric_data(real_t numeric_data[], bool is_col_major, size_t ld_numeric,
+                      size_t nrows, int nthreads,
+                      const BinPlan &plan, uint8_t binned_data[]);
+ISOTREE_EXPORTED
+void bin_numeric_data(real_t numeric_data[], bool is_col_major, size_t ld_numeric,
+                      size_t nrows, int nthreads,
+                      const BinPlan &plan, uint16_t binned_data[]);
+ISOTREE_EXPORTED
+void predict_iforest_binned(const uint8_t binned_data[], size_t nrows, int nthreads, bool standardize,
+                            const BinPlan &plan,
+                            double output_depths[], sparse_ix tree_num[],
+                            double per_tree_depths[]);
+ISOTREE_EXPORTED
+void predict_iforest_binned(const uint16_t binned_data[], size_t nrows, int nthreads, bool standardize,
+                            const BinPlan &plan,
+                            double output_depths[], sparse_ix tree_num[],
+                            double per_tree_depths[]);
+ISOTREE_EXPORTED
+void predict_iforest_bitvector(real_t numeric_data[], bool is_col_major, size_t ld_numeric,
+                               size_t nrows, int nthreads, bool standardize,
+                               const BitvectorIsoForest &bv_forest,
+                               double output_depths[], sparse_ix tree_num[],
+                               double per_tree_depths[]);
+ISOTREE_EXPORTED
+void predict_iforest_compiled(real_t numeric_data[], bool is_col_major, size_t ld_numeric,
+                              size_t nrows, int nthreads, bool standardize,
+                              const CompiledIsoForest &compiled,
+                              double output_depths[], sparse_ix tree_num[],
+                              double per_tree_depths[]);
+ISOTREE_EXPORTED
+void predict_iforest_compiled(real_t numeric_data[], bool is_col_major, size_t ld_numeric,
+                              size_t nrows, int nthreads, bool standardize,
+                              const CompiledExtIsoForest &compiled,
+                              double output_depths[], sparse_ix tree_num[],
+                              double per_tree_depths[]);
+ISOTREE_EXPORTED
+void predict_iforest_decision(real_t numeric_data[], bool is_col_major, size_t ld_numeric,
+                              size_t nrows, int nthreads,
+                              const CompiledIsoForest &compiled,
+                              double threshold, double confidence,
+                              int output_decisions[], size_t trees_used[]);
+ISOTREE_EXPORTED
+double predict_iforest_row(const PredictionContext &context,
+                           const real_t numeric_row[], const int categ_row[]);
+ISOTREE_EXPORTED
+void predict_iforest_view(real_t numeric_data[], int categ_data[],
+                          bool is_col_major, size_t ld_numeric, size_t ld_categ,
+                          real_t Xc[], sparse_ix Xc_ind[], sparse_ix Xc_indptr[],
+                          real_t Xr[], sparse_ix Xr_ind[], sparse_ix Xr_indptr[],
+                          size_t nrows, int nthreads, bool standardize,
+                          const IsoForestView &view,
+                          double output_depths[], double per_tree_depths[]);
+ISOTREE_EXPORTED
+void predict_flat_model(real_t numeric_data[], bool is_col_major, size_t ld_numeric,
+                        size_t nrows, int nthreads, bool standardize,
+                        const FlatModel &model,
+                        double output_depths[], sparse_ix tree_num[],
+                        double per_tree_depths[]);
+ISOTREE_EXPORTED
+double get_flat_model_max_deviation(real_t numeric_data[], bool is_col_major, size_t ld_numeric,
+                                    size_t nrows, int nthreads, bool standardize,
+                                    IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
+                                    const FlatModel &flat_model);
 
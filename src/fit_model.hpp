@@ -595,18 +595,139 @@ int fit_iforest(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
                 bool   all_perm, Imputer *imputer, size_t min_imp_obs,
                 UseDepthImp depth_imp, WeighImpRows weigh_imp_rows, bool impute_at_fit,
                 uint64_t random_seed, bool use_long_double, int nthreads)
+{
+    return fit_iforest<real_t, sparse_ix>(
+        model_outputs, model_outputs_ext,
+        numeric_data,  ncols_numeric,
+        categ_data,    ncols_categ,    ncat,
+        true, nrows, nrows,
+        Xc, Xc_ind, Xc_indptr,
+        ndim, ntry, coef_type, coef_by_prop,
+        sample_weights, with_replacement, weight_as_sample,
+        nrows, sample_size, ntrees,
+        max_depth, ncols_per_tree,
+        limit_depth, penalize_range, standardize_data,
+        scoring_metric, fast_bratio,
+        standardize_dist, tmat,
+        output_depths, standardize_depth,
+        col_weights, weigh_by_kurt,
+        prob_pick_by_gain_pl, prob_pick_by_gain_avg,
+        prob_pick_by_full_gain, prob_pick_by_dens,
+        prob_pick_col_by_range, prob_pick_col_by_var,
+        prob_pick_col_by_kurt,
+        min_gain, SortedSearch, missing_action,
+        cat_split_type, new_cat_action,
+        all_perm, imputer, min_imp_obs,
+        depth_imp, weigh_imp_rows, impute_at_fit,
+        random_seed, use_long_double, (size_t)0, false, nthreads
+    );
+}
+
+/* Same as above, but the dense data can be passed in row-major order and/or with a leading
+   dimension that does not match its number of rows or columns, such as a view over a subset
+   of the columns of a larger array, without having to copy it beforehand.
+* 
+* Parameters:
+* ===========
+* - is_col_major
+*       Whether 'numeric_data' and 'categ_data' are in column-major order. If passing both, they
+*       must have the same orientation. If numeric data is passed in sparse format, categorical
+*       data must be passed in column-major order.
+* - ld_numeric
+*       Leading dimension of the array 'numeric_data'. If it is in row-major order, row 'n' is
+*       assumed to start at 'numeric_data + n*ld_numeric', and if it is in column-major order,
+*       column 'n' is assumed to start at 'numeric_data + n*ld_numeric'. Passing zero will take
+*       it as the number of columns (row-major) or of rows (column-major).
+* - ld_categ
+*       Leading dimension of the array 'categ_data', in the same format as 'ld_numeric'.
+* - split_search
+*       How to find the split thresholds when splits are decided by a gain criterion ('prob_pick_by_gain_avg',
+*       'prob_pick_by_gain_pl', 'prob_pick_by_dens'). Options are:
+*       a) 'SortedSearch', which sorts the values of a column at each node and evaluates the thresholds between
+*       each pair of consecutive values. This is what the function above does.
+*       b) 'HistogramSearch', which assigns the values of each numeric column to at most 255 bins (plus one for
+*       missing values) before fitting the trees, by quantiles of the data. The nodes then build a histogram of
+*       their rows for each column that they evaluate, and only the thresholds between bins are considered. A node
+*       can also obtain its histogram from those of its parent and of its sibling, by building the one with the fewest
+*       rows and subtracting it from the parent's. The gains are calculated in the same way, but the split thresholds
+*       are coarser, so the resulting trees will not be the same. This is much faster when the nodes have many rows.
+*       Only dense numeric columns in the single-variable model are split this way - sparse and categorical columns,
+*       hyperplanes in the extended model, 'prob_pick_by_full_gain', and nodes with few rows, still use sorted search.
+*       c) 'PresortedSearch', which finds the same splits as 'SortedSearch', but instead of sorting at each node,
+*       sorts the indices of the rows by each numeric column once per tree (or only once for the whole model and
+*       shared by all threads when each tree is fit to all of the rows without replacement), and then keeps the
+*       indices of each node sorted by partitioning them along with the rows when the node is split. This requires
+*       memory for one index per row and numeric column in each thread, and splitting a node then takes time
+*       proportional to its number of rows times the number of numeric columns, so it is typically faster with few
+*       columns and large sample sizes. After a node in which rows with missing values go to both branches
+*       ('missing_action=Divide'), its sub-trees go back to sorting at each node. As with 'HistogramSearch', this
+*       only applies to dense numeric columns in the single-variable model.
+* - node_task_rows
+*       If passing a number greater than zero, the nodes of a tree that have more rows than this are split
+*       on their own, with their left and right branches then grown as separate tasks that can run in
+*       different threads, so that the threads are not left idle when there are fewer trees than threads
+*       (e.g. when fitting a handful of deep trees to all of the rows for distances or imputations). In this
+*       case, the trees and the order of their nodes are the same regardless of the number of threads and of
+*       the value passed here (including zero), as nodes with more than 8192 rows always draw a seed for each
+*       of their branches, from which these start. Smaller numbers are taken as 8192, and when the sample
+*       size is not larger than that, each tree is grown in a single thread. The buffers for distances, depths,
+*       and imputations at fit time are allocated for every thread instead of for every tree, so memory usage
+*       increases when there are more threads than trees, and with data that is not in contiguous column-major
+*       order, the copy of the rows of each tree is kept until all of its tasks are done.
+*       Pass zero to grow each tree in a single thread as the function above does.
+* - reorder_nodes_after_fit
+*       Whether to re-arrange the nodes of each tree after fitting, for faster predictions (see
+*       'reorder_nodes' for details). The imputer passed here, if any, is re-arranged along with
+*       the model. Outputs calculated at fit time ('tmat', 'output_depths', 'impute_at_fit') are
+*       not affected by it.
+* 
+* All other parameters are the same as in the function above. Data that is not in contiguous
+* column-major order is not copied as a whole: each tree is fit to a column-major copy of the
+* rows that it takes (all of them when not using sub-sampling), held in the memory of the
+* thread that fits it and reused for its next tree, so there are as many of these copies as
+* there are threads (see 'node_task_rows' for an exception). Passes over the full data done
+* before fitting the trees (e.g. variable ranges or imputations at fit time) read it in place.
+* Categorical data is however copied once when the numeric data is passed in sparse format.
+*/
+template <class real_t, class sparse_ix>
+int fit_iforest(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
+                real_t numeric_data[],  size_t ncols_numeric,
+                int    categ_data[],    size_t ncols_categ,    int ncat[],
+                bool is_col_major, size_t ld_numeric, size_t ld_categ,
+                real_t Xc[], sparse_ix Xc_ind[], sparse_ix Xc_indptr[],
+                size_t ndim, size_t ntry, CoefType coef_type, bool coef_by_prop,
+                real_t sample_weights[], bool with_replacement, bool weight_as_sample,
+                size_t nrows, size_t sample_size, size_t ntrees,
+                size_t max_depth,   size_t ncols_per_tree,
+                bool   limit_depth, bool penalize_range, bool standardize_data,
+                ScoringMetric scoring_metric, bool fast_bratio,
+                bool   standardize_dist, double tmat[],
+                double output_depths[], bool standardize_depth,
+                real_t col_weights[], bool weigh_by_kurt,
+                double prob_pick_by_gain_pl, double prob_pick_by_gain_avg,
+                double prob_pick_by_full_gain, double prob_pick_by_dens,
+                double prob_pick_col_by_range, double prob_pick_col_by_var,
+                double prob_pick_col_by_kurt,
+                double min_gain, SplitSearch split_search, MissingAction missing_action,
+                CategSplit cat_split_type, NewCategAction new_cat_action,
+                bool   all_perm, Imputer *imputer, size_t min_imp_obs,
+                UseDepthImp depth_imp, WeighImpRows weigh_imp_rows, bool impute_at_fit,
+                uint64_t random_seed, bool use_long_double, size_t node_task_rows,
+                bool reorder_nodes_after_fit, int nthreads)
 {
     if (use_long_double && !has_long_double()) {
         use_long_double = false;
         print_errmsg("Passed 'use_long_double=true', but library was compiled without long double support.\n");
     }
+    int retcode;
     #ifndef NO_LONG_DOUBLE
     if (likely(!use_long_double))
     #endif
-        return fit_iforest_internal<real_t, sparse_ix, double>(
+        retcode = fit_iforest_internal<real_t, sparse_ix, double>(
             model_outputs, model_outputs_ext,
             numeric_data,  ncols_numeric,
             categ_data,    ncols_categ,    ncat,
+            is_col_major, ld_numeric, ld_categ,
             Xc, Xc_ind, Xc_indptr,
             ndim, ntry, coef_type, coef_by_prop,
             sample_weights, with_replacement, weight_as_sample,
@@ -621,18 +742,19 @@ int fit_iforest(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
             prob_pick_by_full_gain, prob_pick_by_dens,
             prob_pick_col_by_range, prob_pick_col_by_var,
             prob_pick_col_by_kurt,
-            min_gain, missing_action,
+            min_gain, split_search, missing_action,
             cat_split_type, new_cat_action,
             all_perm, imputer, min_imp_obs,
             depth_imp, weigh_imp_rows, impute_at_fit,
-            random_seed, nthreads
+            random_seed, node_task_rows, nthreads
         );
     #ifndef NO_LONG_DOUBLE
     else
-        return fit_iforest_internal<real_t, sparse_ix, long double>(
+        retcode = fit_iforest_internal<real_t, sparse_ix, long double>(
             model_outputs, model_outputs_ext,
             numeric_data,  ncols_numeric,
             categ_data,    ncols_categ,    ncat,
+            is_col_major, ld_numeric, ld_categ,
             Xc, Xc_ind, Xc_indptr,
             ndim, ntry, coef_type, coef_by_prop,
             sample_weights, with_replacement, weight_as_sample,
@@ -647,13 +769,17 @@ int fit_iforest(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
             prob_pick_by_full_gain, prob_pick_by_dens,
             prob_pick_col_by_range, prob_pick_col_by_var,
             prob_pick_col_by_kurt,
-            min_gain, missing_action,
+            min_gain, split_search, missing_action,
             cat_split_type, new_cat_action,
             all_perm, imputer, min_imp_obs,
             depth_imp, weigh_imp_rows, impute_at_fit,
-            random_seed, nthreads
+            random_seed, node_task_rows, nthreads
         );
     #endif
+
+    if (retcode == EXIT_SUCCESS && reorder_nodes_after_fit)
+        reorder_nodes(model_outputs, model_outputs_ext, imputer, (TreesIndexer*)NULL, nthreads);
+    return retcode;
 }
 
 template <class real_t, class sparse_ix, class ldouble_safe>
@@ -661,6 +787,7 @@ int fit_iforest_internal(
                 IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
                 real_t numeric_data[],  size_t ncols_numeric,
                 int    categ_data[],    size_t ncols_categ,    int ncat[],
+                bool is_col_major, size_t ld_numeric, size_t ld_categ,
                 real_t Xc[], sparse_ix Xc_ind[], sparse_ix Xc_indptr[],
                 size_t ndim, size_t ntry, CoefType coef_type, bool coef_by_prop,
                 real_t sample_weights[], bool with_replacement, bool weight_as_sample,
@@ -675,11 +802,11 @@ int fit_iforest_internal(
                 double prob_pick_by_full_gain, double prob_pick_by_dens,
                 double prob_pick_col_by_range, double prob_pick_col_by_var,
                 double prob_pick_col_by_kurt,
-                double min_gain, MissingAction missing_action,
+                double min_gain, SplitSearch split_search, MissingAction missing_action,
                 CategSplit cat_split_type, NewCategAction new_cat_action,
                 bool   all_perm, Imputer *imputer, size_t min_imp_obs,
                 UseDepthImp depth_imp, WeighImpRows weigh_imp_rows, bool impute_at_fit,
-                uint64_t random_seed, int nthreads)
+                uint64_t random_seed, size_t node_task_rows, int nthreads)
 {
     if (
         prob_pick_by_gain_avg  < 0 || prob_pick_by_gain_pl  < 0 ||
@@ -721,10 +848,28 @@ int fit_iforest_internal(
     }
 
 
-    /* TODO: this function should also accept the array as a memoryview with a
-       leading dimension that might not correspond to the number of columns,
-       so as to avoid having to make deep copies of memoryviews in python and to
-       allow using pointers to columns of dataframes in R and Python. */
+    /* if the caller set an executor, it determines the number of workers */
+    Executor *executor = get_thread_executor();
+    if (executor != NULL)
+        nthreads = executor->num_workers();
+    #ifndef _OPENMP
+    else
+        nthreads = 1;
+    #endif
+
+    /* dense data might come in row-major order or as a view with a larger leading dimension */
+    if (ld_numeric == 0)
+        ld_numeric = is_col_major? nrows : ncols_numeric;
+    if (ld_categ == 0)
+        ld_categ = is_col_major? nrows : ncols_categ;
+    if (numeric_data != NULL && ld_numeric < (is_col_major? nrows : ncols_numeric))
+        throw std::runtime_error("Leading dimension of 'numeric_data' is smaller than its number of entries per "
+                                 + std::string(is_col_major? "column" : "row") + ".\n");
+    if (categ_data != NULL && ld_categ < (is_col_major? nrows : ncols_categ))
+        throw std::runtime_error("Leading dimension of 'categ_data' is smaller than its number of entries per "
+                                 + std::string(is_col_major? "column" : "row") + ".\n");
+    if (!is_col_major && Xc_indptr != NULL && categ_data != NULL)
+        throw std::runtime_error("Categorical data must be in column-major order when passing sparse numeric data.\n");
 
     /* calculate maximum number of categories to use later */
     int max_categ = 0;
@@ -742,6 +887,25 @@ int fit_iforest_internal(
     if (ncols_per_tree == 0)
         ncols_per_tree = ncols_numeric + ncols_categ;
 
+    /* only nodes with more than 'NODE_TASK_MIN_ROWS' rows have seeds for their branches, so smaller
+       ones can't be split as tasks, and trees whose roots are not larger than that are not split */
+    if (node_task_rows)
+        node_task_rows = (sample_size > NODE_TASK_MIN_ROWS)? std::max(node_task_rows, NODE_TASK_MIN_ROWS) : 0;
+
+    /* data that is not in contiguous column-major order is fit through per-tree copies of the rows
+       that each tree takes, which without sub-sampling are all of them, so the full matrix is never
+       duplicated up front; the exception is categorical data passed along with sparse numeric data,
+       which gets copied here as the tiles only take dense data */
+    int *orig_categ_data = categ_data;
+    size_t orig_ld_categ = ld_categ;
+    std::vector<int> categ_data_colmajor;
+    if (Xc_indptr != NULL && categ_data != NULL && ld_categ != nrows)
+    {
+        copy_to_colmajor(categ_data, is_col_major, ld_categ, nrows, ncols_categ, categ_data_colmajor);
+        categ_data = categ_data_colmajor.data();
+        ld_categ = nrows;
+    }
+
     /* put data in structs to shorten function calls */
     InputData<real_t, sparse_ix>
               input_data     = {numeric_data, ncols_numeric, categ_data, ncat, max_categ, ncols_categ,
@@ -752,7 +916,9 @@ int fit_iforest_internal(
                                 std::vector<char>(), 0, NULL,
                                 (double*)NULL, (double*)NULL, (int*)NULL, std::vector<double>(),
                                 std::vector<double>(), std::vector<double>(),
-                                std::vector<size_t>(), std::vector<size_t>()};
+                                std::vector<size_t>(), std::vector<size_t>(),
+                                is_col_major, ld_numeric, ld_categ,
+                                (uint8_t*)NULL, (ColumnBins*)NULL, (size_t*)NULL};
     ModelParams model_params = {with_replacement, sample_size, ntrees, ncols_per_tree,
                                 limit_depth? log2ceil(sample_size) : max_depth? max_depth : (sample_size - 1),
                                 penalize_range, standardize_data, random_seed, weigh_by_kurt,
@@ -760,14 +926,15 @@ int fit_iforest_internal(
                                 prob_pick_by_full_gain, prob_pick_by_dens,
                                 prob_pick_col_by_range, prob_pick_col_by_var,
                                 prob_pick_col_by_kurt,
-                                min_gain, cat_split_type, new_cat_action, missing_action,
+                                min_gain, split_search, cat_split_type, new_cat_action, missing_action,
                                 scoring_metric, fast_bratio, all_perm,
                                 (model_outputs != NULL)? 0 : ndim, ntry,
                                 coef_type, coef_by_prop, calc_dist, (bool)(output_depths != NULL), impute_at_fit,
-                                depth_imp, weigh_imp_rows, min_imp_obs};
+                                depth_imp, weigh_imp_rows, min_imp_obs, node_task_rows};
 
-    /* if calculating full gain, need to produce copies of the data in row-major order */
-    if (prob_pick_by_full_gain)
+    /* if calculating full gain, need to produce copies of the data in row-major order
+       (when fitting to the rows of a tile, each tile produces its own copy instead) */
+    if (prob_pick_by_full_gain && is_contiguous_colmajor(input_data))
     {
         if (input_data.Xc_indptr == NULL)
             colmajor_to_rowmajor(input_data.numeric_data, input_data.nrows, input_data.ncols_numeric, input_data.X_row_major);
@@ -777,6 +944,35 @@ int fit_iforest_internal(
                                  input_data.Xr, input_data.Xr_ind, input_data.Xr_indptr);
     }
 
+    /* if searching guided splits through histograms, the values are assigned to bins only once */
+    ColumnBins col_bins;
+    std::vector<uint8_t> X_binned;
+    if (
+        model_params.split_search == HistogramSearch && model_outputs != NULL &&
+        input_data.numeric_data != NULL && model_params.sample_size >= HIST_MIN_ROWS &&
+        (prob_pick_by_gain_avg + prob_pick_by_gain_pl + prob_pick_by_dens) > 0
+    )
+    {
+        build_column_bins(input_data.numeric_data, input_data.is_col_major, input_data.ld_numeric,
+                          input_data.nrows, input_data.ncols_numeric, col_bins, X_binned, nthreads);
+        input_data.X_binned = X_binned.data();
+        input_data.col_bins = &col_bins;
+    }
+
+    /* if searching guided splits with presorted indices and each tree takes all rows, they are sorted only once */
+    std::vector<size_t> presorted_ix;
+    if (
+        model_params.split_search == PresortedSearch && model_outputs != NULL &&
+        input_data.numeric_data != NULL &&
+        model_params.sample_size == input_data.nrows && !model_params.with_replacement &&
+        (prob_pick_by_gain_avg + prob_pick_by_gain_pl + prob_pick_by_full_gain + prob_pick_by_dens) > 0
+    )
+    {
+        presort_all_columns(input_data.numeric_data, input_data.is_col_major, input_data.ld_numeric,
+                            input_data.nrows, input_data.ncols_numeric, presorted_ix, nthreads);
+        input_data.presorted_ix = presorted_ix.data();
+    }
+
     /* if using weights as sampling probability, build a binary tree for faster sampling */
     if (input_data.weight_as_sample && input_data.sample_weights != NULL)
     {
@@ -852,6 +1048,8 @@ int fit_iforest_internal(
         variable_ranges_high.resize(input_data.ncols_numeric);
 
         std::unique_ptr<unsigned char[]> buffer_cats;
+        std::vector<real_t> buffer_numeric;
+        std::vector<int> buffer_categ;
         size_t adj_col;
         if (is_boxed_metric(model_params.scoring_metric))
         {
@@ -872,7 +1070,8 @@ int fit_iforest_internal(
             {
                 if (input_data.Xc_indptr == NULL)
                 {
-                    get_range(input_data.numeric_data + nrows*col,
+                    get_range(get_strided_column(input_data.numeric_data, input_data.is_col_major,
+                                                 input_data.ld_numeric, input_data.nrows, col, buffer_numeric),
                               input_data.nrows,
                               model_params.missing_action,
                               variable_ranges_low[col],
@@ -912,7 +1111,9 @@ int fit_iforest_internal(
                 adj_col = col - input_data.ncols_numeric;
 
 
-                variable_ncats[adj_col] = count_ncateg_in_col(input_data.categ_data + input_data.nrows*adj_col,
+                variable_ncats[adj_col] = count_ncateg_in_col(get_strided_column(input_data.categ_data, input_data.is_col_major,
+                                                                                 input_data.ld_categ, input_data.nrows,
+                                                                                 adj_col, buffer_categ),
                                                               input_data.nrows, input_data.ncat[adj_col],
                                                               buffer_cats.get());
                 if (variable_ncats[adj_col] <= 1)
@@ -987,60 +1188,64 @@ int fit_iforest_internal(
         );
 
     /* initialize thread-private memory */
-    if ((size_t)nthreads > ntrees)
+    typedef WorkerMemory<ImputedData<sparse_ix, ldouble_safe>, ldouble_safe, real_t> WorkerMemoryT;
+    if (executor == NULL && (size_t)nthreads > ntrees && !model_params.node_task_rows)
         nthreads = (int)ntrees;
-    #ifdef _OPENMP
-        std::vector<WorkerMemory<ImputedData<sparse_ix, ldouble_safe>, ldouble_safe, real_t>> worker_memory(nthreads);
-    #else
-        std::vector<WorkerMemory<ImputedData<sparse_ix, ldouble_safe>, ldouble_safe, real_t>> worker_memory(1);
-    #endif
+    std::vector<WorkerMemoryT> worker_memory(nthreads);
+
+    /* when growing nodes as tasks, each tree keeps them here until they are all done */
+    std::vector<NodeTaskTree<WorkerMemoryT, decltype(input_data)>> task_trees(model_params.node_task_rows? ntrees : 0);
 
     /* Global variable that determines if the procedure receives a stop signal */
     SignalSwitcher ss = SignalSwitcher();
 
     /* For exception handling */
-    bool threw_exception = false;
+    std::atomic<bool> threw_exception(false);
     std::exception_ptr ex = NULL;
 
+    /* imputations at fit time are accumulated separately by each thread */
+    auto initialize_worker_imputations = [&](int thread_id)
+    {
+        if (
+            model_params.impute_at_fit &&
+            input_data.n_missing &&
+            !worker_memory[thread_id].impute_vec.size() &&
+            !worker_memory[thread_id].impute_map.size()
+            )
+        {
+            if (nthreads > 1)
+            {
+                worker_memory[thread_id].impute_vec = impute_vec;
+                worker_memory[thread_id].impute_map = impute_map;
+            }
+
+            else
+            {
+                worker_memory[0].impute_vec = std::move(impute_vec);
+                worker_memory[0].impute_map = std::move(impute_map);
+            }
+        }
+    };
+
     /* grow trees */
-    #pragma omp parallel for num_threads(nthreads) schedule(dynamic) shared(model_outputs, model_outputs_ext, worker_memory, input_data, model_params, threw_exception, ex)
-    for (size_t_for tree = 0; tree < (decltype(tree))ntrees; tree++)
+    auto grow_tree = [&](size_t tree, int thread_id)
     {
         if (interrupt_switch || threw_exception)
-            continue; /* Cannot break with OpenMP==2.0 (MSVC) */
+            return; /* Cannot break with OpenMP==2.0 (MSVC) */
 
         try
         {
-            if (
-                model_params.impute_at_fit &&
-                input_data.n_missing &&
-                !worker_memory[omp_get_thread_num()].impute_vec.size() &&
-                !worker_memory[omp_get_thread_num()].impute_map.size()
-                )
-            {
-                #ifdef _OPENMP
-                if (nthreads > 1)
-                {
-                    worker_memory[omp_get_thread_num()].impute_vec = impute_vec;
-                    worker_memory[omp_get_thread_num()].impute_map = impute_map;
-                }
-
-                else
-                #endif
-                {
-                    worker_memory[0].impute_vec = std::move(impute_vec);
-                    worker_memory[0].impute_map = std::move(impute_map);
-                }
-            }
+            initialize_worker_imputations(thread_id);
 
-            fit_itree<decltype(input_data), typename std::remove_pointer<decltype(worker_memory.data())>::type, ldouble_safe>(
+            fit_itree<decltype(input_data), WorkerMemoryT, ldouble_safe>(
                       (model_outputs != NULL)? &model_outputs->trees[tree] : NULL,
                       (model_outputs_ext != NULL)? &model_outputs_ext->hplanes[tree] : NULL,
-                      worker_memory[omp_get_thread_num()],
+                      worker_memory[thread_id],
                       input_data,
                       model_params,
                       (imputer != NULL)? &(imputer->imputer_tree[tree]) : NULL,
-                      tree);
+                      tree,
+                      model_params.node_task_rows? &task_trees[tree] : NULL);
 
             if ((model_outputs != NULL))
                 model_outputs->trees[tree].shrink_to_fit();
@@ -1050,15 +1255,129 @@ int fit_iforest_internal(
 
         catch (...)
         {
-            #pragma omp critical
+            catch_task_exception(threw_exception, ex);
+        }
+    };
+    run_parallel_for(executor, ntrees, nthreads, true, grow_tree);
+
+    /* with node tasks, the trees above were only set up, and their nodes get grown in waves of tasks from
+       the root downwards. Nodes with many rows are split one per task, passing their branches to the next
+       wave, and once there are none left, the sub-trees under the remaining nodes are grown in a last wave.
+       Since each task restores the workspace from what it saved, results do not depend on the threads, and
+       are the same as when growing each tree in a single thread. */
+    if (model_params.node_task_rows)
+    {
+        std::vector<std::pair<size_t, NodeTask<WorkerMemoryT>*>> wave, next_wave, last_wave;
+        for (size_t tree = 0; tree < ntrees; tree++)
+        {
+            task_trees[tree].n_pending = 0;
+            if (task_trees[tree].root)
+            {
+                next_wave.emplace_back(tree, task_trees[tree].root.get());
+                task_trees[tree].n_pending = 1;
+            }
+        }
+
+        auto grow_task = [&](size_t ix, int thread_id)
+        {
+            if (interrupt_switch || threw_exception)
+                return;
+
+            try
+            {
+                initialize_worker_imputations(thread_id);
+
+                size_t tree = wave[ix].first;
+                NodeTask<WorkerMemoryT> &task = *wave[ix].second;
+                auto &tree_data = task_trees[tree].has_tile? task_trees[tree].tile_data : input_data;
+                restore_node_task(task, task_trees[tree], worker_memory[thread_id], tree_data, model_params);
+                allocate_worker_buffers(worker_memory[thread_id], tree_data, model_params, model_outputs == NULL);
+                if (model_outputs != NULL)
+                    grow_itree_task<decltype(input_data), WorkerMemoryT, ldouble_safe>(
+                                    task, worker_memory[thread_id], tree_data, model_params, imputer != NULL);
+                else
+                    grow_hplane_task<decltype(input_data), WorkerMemoryT, ldouble_safe>(
+                                     task, worker_memory[thread_id], tree_data, model_params, imputer != NULL);
+            }
+
+            catch (...)
+            {
+                catch_task_exception(threw_exception, ex);
+            }
+        };
+
+        while ((!next_wave.empty() || !last_wave.empty()) && !interrupt_switch && !threw_exception)
+        {
+            wave.clear();
+            for (const auto &node_task : next_wave)
+            {
+                if (node_task.second->nrows > model_params.node_task_rows)
+                    wave.push_back(node_task);
+                else
+                    last_wave.push_back(node_task);
+            }
+            next_wave.clear();
+            if (wave.empty())
+                wave.swap(last_wave);
+
+            /* larger nodes go first, so that the smaller ones can fill the gaps at the end */
+            std::stable_sort(wave.begin(), wave.end(),
+                             [](const std::pair<size_t, NodeTask<WorkerMemoryT>*> &a,
+                                const std::pair<size_t, NodeTask<WorkerMemoryT>*> &b)
+                             {return a.second->nrows > b.second->nrows;});
+            run_parallel_for(executor, wave.size(), nthreads, true, grow_task);
+
+            for (const auto &node_task : wave)
+            {
+                auto &task_tree = task_trees[node_task.first];
+                task_tree.n_pending--;
+                if (node_task.second->left)
+                {
+                    next_wave.emplace_back(node_task.first, node_task.second->left.get());
+                    next_wave.emplace_back(node_task.first, node_task.second->right.get());
+                    task_tree.n_pending += 2;
+                }
+
+                /* the copy of the sampled rows is not needed after the last task of its tree */
+                else if (!task_tree.n_pending && task_tree.has_tile)
+                {
+                    task_tree.has_tile = false;
+                    task_tree.tile_data = decltype(input_data)();
+                    decltype(task_tree.tile_numeric)().swap(task_tree.tile_numeric);
+                    decltype(task_tree.tile_categ)().swap(task_tree.tile_categ);
+                    decltype(task_tree.tile_weights)().swap(task_tree.tile_weights);
+                    decltype(task_tree.tile_binned)().swap(task_tree.tile_binned);
+                }
+            }
+        }
+
+        if (!interrupt_switch && !threw_exception)
+        {
+            for (size_t tree = 0; tree < ntrees; tree++)
             {
-                if (!threw_exception)
+                std::vector<ImputeNode> *impute_nodes = (imputer != NULL)? &(imputer->imputer_tree[tree]) : NULL;
+                if (model_outputs != NULL)
                 {
-                    threw_exception = true;
-                    ex = std::current_exception();
+                    splice_node_tasks(*task_trees[tree].root, &NodeTask<WorkerMemoryT>::trees,
+                                      &IsoTree::tree_left, &IsoTree::tree_right,
+                                      model_outputs->trees[tree], impute_nodes);
+                    model_outputs->trees[tree].shrink_to_fit();
                 }
+                else
+                {
+                    splice_node_tasks(*task_trees[tree].root, &NodeTask<WorkerMemoryT>::hplanes,
+                                      &IsoHPlane::hplane_left, &IsoHPlane::hplane_right,
+                                      model_outputs_ext->hplanes[tree], impute_nodes);
+                    model_outputs_ext->hplanes[tree].shrink_to_fit();
+                }
+                if (impute_nodes != NULL)
+                    drop_nonterminal_imp_node(*impute_nodes,
+                                              (model_outputs != NULL)? &model_outputs->trees[tree] : NULL,
+                                              (model_outputs_ext != NULL)? &model_outputs_ext->hplanes[tree] : NULL);
+                task_trees[tree].root.reset();
             }
         }
+        task_trees.clear();
     }
 
     /* check if the procedure got interrupted */
@@ -1094,21 +1413,22 @@ int fit_iforest_internal(
     /* same for depths */
     if (output_depths != NULL)
     {
-        #ifdef _OPENMP
         if (nthreads > 1)
         {
             for (auto &w : worker_memory)
             {
                 if (w.row_depths.size())
                 {
-                    #pragma omp parallel for schedule(static) num_threads(nthreads) shared(input_data, output_depths, w, worker_memory)
-                    for (size_t_for row = 0; row < (decltype(row))input_data.nrows; row++)
+                    auto add_depths = [&](size_t row, int thread_id)
+                    {
+                        (void)thread_id;
                         output_depths[row] += w.row_depths[row];
+                    };
+                    run_parallel_for(executor, input_data.nrows, nthreads, false, add_depths);
                 }
             }
         }
         else
-        #endif
         {
             std::copy(worker_memory[0].row_depths.begin(), worker_memory[0].row_depths.end(), output_depths);
         }
@@ -1137,7 +1457,6 @@ int fit_iforest_internal(
     /* if imputing missing values, now need to reduce and write final values */
     if (model_params.impute_at_fit)
     {
-        #ifdef _OPENMP
         if (nthreads > 1)
         {
             for (auto &w : worker_memory)
@@ -1145,13 +1464,16 @@ int fit_iforest_internal(
         }
 
         else
-        #endif
         {
             impute_vec = std::move(worker_memory[0].impute_vec);
             impute_map = std::move(worker_memory[0].impute_map);
         }
 
         apply_imputation_results(impute_vec, impute_map, *imputer, input_data, nthreads);
+
+        /* imputations of categorical data that was copied were written into the copy, need to pass them to the original array */
+        if (orig_categ_data != categ_data)
+            copy_from_colmajor(categ_data_colmajor, true, orig_ld_categ, nrows, ncols_categ, orig_categ_data);
     }
 
     check_interrupt_switch(ss);
@@ -1531,7 +1853,9 @@ int add_tree_internal(
                                 std::vector<char>(), 0, NULL,
                                 (double*)NULL, (double*)NULL, (int*)NULL, std::vector<double>(),
                                 std::vector<double>(), std::vector<double>(),
-                                std::vector<size_t>(), std::vector<size_t>()};
+                                std::vector<size_t>(), std::vector<size_t>(),
+                                true, nrows, nrows,
+                                (uint8_t*)NULL, (ColumnBins*)NULL, (size_t*)NULL};
     ModelParams model_params = {false, nrows, (size_t)1, ncols_per_tree,
                                 max_depth? max_depth : (nrows - 1),
                                 penalize_range, standardize_data, random_seed, weigh_by_kurt,
@@ -1539,11 +1863,12 @@ int add_tree_internal(
                                 prob_pick_by_full_gain, prob_pick_by_dens,
                                 prob_pick_col_by_range, prob_pick_col_by_var,
                                 prob_pick_col_by_kurt,
-                                min_gain, cat_split_type, new_cat_action, missing_action,
+                                min_gain, SortedSearch, cat_split_type, new_cat_action, missing_action,
                                 (model_outputs != NULL)? model_outputs->scoring_metric : model_outputs_ext->scoring_metric,
                                 fast_bratio, all_perm,
                                 (model_outputs != NULL)? 0 : ndim, ntry,
-                                coef_type, coef_by_prop, false, false, false, depth_imp, weigh_imp_rows, min_imp_obs};
+                                coef_type, coef_by_prop, false, false, false, depth_imp, weigh_imp_rows, min_imp_obs,
+                                (size_t)0};
 
     if (prob_pick_by_full_gain)
     {
@@ -1598,7 +1923,8 @@ int add_tree_internal(
                   input_data,
                   model_params,
                   impute_nodes,
-                  last_tree);
+                  last_tree,
+                  (NodeTaskTree<typename std::remove_pointer<decltype(workspace.get())>::type, decltype(input_data)>*)NULL);
 
         check_interrupt_switch(ss);
 
@@ -1742,7 +2068,8 @@ void fit_itree(std::vector<IsoTree>    *tree_root,
                InputData                &input_data,
                ModelParams              &model_params,
                std::vector<ImputeNode> *impute_nodes,
-               size_t                   tree_num)
+               size_t                   tree_num,
+               NodeTaskTree<WorkerMemory, InputData> *task_tree)
 {
     /* initialize array for depths if called for */
     if (workspace.ix_arr.empty() && model_params.calc_depth)
@@ -1764,6 +2091,50 @@ void fit_itree(std::vector<IsoTree>    *tree_root,
     workspace.st  = 0;
     workspace.end = model_params.sample_size - 1;
 
+    /* data that is not in contiguous column-major order is fit through a copy of the sampled rows */
+    if (task_tree != NULL)
+        task_tree->has_tile = false;
+    if (!is_contiguous_colmajor(input_data))
+    {
+        InputData tile_data = InputData();
+        gather_sampled_rows(tile_data, input_data, workspace, model_params);
+        fit_itree_from_sample<InputData, WorkerMemory, ldouble_safe>(
+            tree_root, hplane_root,
+            workspace, tile_data, model_params,
+            impute_nodes, task_tree
+        );
+
+        /* when growing the nodes as tasks, the copy goes along with them */
+        if (task_tree != NULL)
+        {
+            task_tree->has_tile = true;
+            task_tree->tile_numeric.swap(workspace.tile_numeric);
+            task_tree->tile_categ.swap(workspace.tile_categ);
+            task_tree->tile_weights.swap(workspace.tile_weights);
+            task_tree->tile_binned.swap(workspace.tile_binned);
+            task_tree->tile_data = std::move(tile_data);
+            return;
+        }
+        workspace.tile_row_major.swap(tile_data.X_row_major);
+        return;
+    }
+
+    fit_itree_from_sample<InputData, WorkerMemory, ldouble_safe>(
+        tree_root, hplane_root,
+        workspace, input_data, model_params,
+        impute_nodes, task_tree
+    );
+}
+
+template <class InputData, class WorkerMemory, class ldouble_safe>
+void fit_itree_from_sample(std::vector<IsoTree>    *tree_root,
+                           std::vector<IsoHPlane>  *hplane_root,
+                           WorkerMemory             &workspace,
+                           InputData                &input_data,
+                           ModelParams              &model_params,
+                           std::vector<ImputeNode> *impute_nodes,
+                           NodeTaskTree<WorkerMemory, InputData> *task_tree)
+{
     /* in some cases, it's not possible to use column weights even if they are given,
        because every single column will always need to be checked or end up being used. */
     bool avoid_col_weights = (tree_root != NULL && model_params.ntry >= model_params.ncols_per_tree &&
@@ -1804,23 +2175,6 @@ void fit_itree(std::vector<IsoTree>    *tree_root,
         }
     }
 
-    /* initialize array with candidate categories if not already done */
-    if (workspace.categs.empty())
-        workspace.categs.resize(input_data.max_categ);
-
-    /* initialize array with per-node column weights if needed */
-    if ((model_params.prob_pick_col_by_range ||
-         model_params.prob_pick_col_by_var ||
-         model_params.prob_pick_col_by_kurt) && workspace.node_col_weights.empty())
-    {
-        workspace.node_col_weights.resize(input_data.ncols_tot);
-        if (tree_root != NULL || model_params.standardize_data || model_params.missing_action != Fail)
-        {
-            workspace.saved_stat1.resize(input_data.ncols_numeric);
-            workspace.saved_stat2.resize(input_data.ncols_numeric);
-        }
-    }
-
     /* IMPORTANT!!!!!
        The standard library implementation is likely going to use the Box-Muller method
        for normal sampling, which has some state memory in the **distribution object itself**
@@ -1838,45 +2192,6 @@ void fit_itree(std::vector<IsoTree>    *tree_root,
             workspace.coef_unif = UniformMinusOneToOne(-1, 1);
     }
 
-    /* for the extended model, initialize extra vectors and objects */
-    if (hplane_root != NULL && workspace.comb_val.empty())
-    {
-        workspace.comb_val.resize(model_params.sample_size);
-        workspace.col_take.resize(model_params.ndim);
-        workspace.col_take_type.resize(model_params.ndim);
-
-        if (input_data.ncols_numeric)
-        {
-            workspace.ext_offset.resize(input_data.ncols_tot);
-            workspace.ext_coef.resize(input_data.ncols_tot);
-            workspace.ext_mean.resize(input_data.ncols_tot);
-        }
-
-        if (input_data.ncols_categ)
-        {
-            workspace.ext_fill_new.resize(input_data.max_categ);
-            switch(model_params.cat_split_type)
-            {
-                case SingleCateg:
-                {
-                    workspace.chosen_cat.resize(input_data.max_categ);
-                    break;
-                }
-
-                case SubSet:
-                {
-                    workspace.ext_cat_coef.resize(input_data.ncols_tot);
-                    for (std::vector<double> &v : workspace.ext_cat_coef)
-                        v.resize(input_data.max_categ);
-                    break;
-                }
-            }
-        }
-
-        workspace.ext_fill_val.resize(input_data.ncols_tot);
-
-    }
-
     /* If there are density weights, need to standardize them to sum up to
        the sample size here. Note that weights for missing values with 'Divide'
        are only initialized on-demand later on. */
@@ -1940,171 +2255,41 @@ void fit_itree(std::vector<IsoTree>    *tree_root,
         }
     }
 
-    /* if producing distance/similarity, also need to initialize the triangular matrix */
-    if (model_params.calc_dist && workspace.tmat_sep.empty())
-        workspace.tmat_sep.resize((input_data.nrows * (input_data.nrows - 1)) / 2, 0);
-
     /* make space for buffers if not already allocated */
-    if (
-            (model_params.prob_pick_by_gain_avg    > 0  ||
-             model_params.prob_pick_by_gain_pl     > 0  ||
-             model_params.prob_pick_by_full_gain   > 0  ||
-             model_params.prob_pick_by_dens        > 0  ||
-             model_params.prob_pick_col_by_range   > 0  ||
-             model_params.prob_pick_col_by_var     > 0  ||
-             model_params.prob_pick_col_by_kurt    > 0  ||
-             model_params.weigh_by_kurt || hplane_root != NULL)
-                &&
-            (workspace.buffer_dbl.empty() && workspace.buffer_szt.empty() && workspace.buffer_chr.empty())
-        )
-    {
-        size_t min_size_dbl = 0;
-        size_t min_size_szt = 0;
-        size_t min_size_chr = 0;
+    allocate_worker_buffers(workspace, input_data, model_params, hplane_root != NULL);
 
-        bool gain = model_params.prob_pick_by_gain_avg  > 0 ||
-                    model_params.prob_pick_by_gain_pl   > 0 ||
-                    model_params.prob_pick_by_full_gain > 0 ||
-                    model_params.prob_pick_by_dens      > 0;
+    if (
+        (model_params.prob_pick_col_by_range || model_params.prob_pick_col_by_var) &&
+        model_params.weigh_by_kurt &&
+        model_params.sample_size == input_data.nrows && !model_params.with_replacement &&
+        (model_params.ncols_per_tree == input_data.ncols_tot) &&
+        !input_data.all_kurtoses.empty()
+    ) {
+        workspace.tree_kurtoses = input_data.all_kurtoses.data();
+    }
+    else {
+        workspace.tree_kurtoses = NULL;
+    }
 
-        if (input_data.ncols_categ)
-        {
-            min_size_szt = (size_t)2 * (size_t)input_data.max_categ;
-            min_size_dbl = input_data.max_categ + 1;
-            if (gain && model_params.cat_split_type == SubSet)
-                min_size_chr = input_data.max_categ;
-        }
+    /* weigh columns by kurtosis in the sample if required */
+    /* TODO: this one could probably be refactored to use the function in the helpers */
+    std::vector<double> kurt_weights;
+    bool avoid_leave_m_cols = false;
+    if (
+        model_params.weigh_by_kurt &&
+        !avoid_col_weights &&
+        (input_data.preinitialized_col_sampler == NULL
+            ||
+         ((model_params.prob_pick_col_by_range || model_params.prob_pick_col_by_var) && workspace.tree_kurtoses == NULL))
+    )
+    {
+        kurt_weights.resize(input_data.ncols_numeric + input_data.ncols_categ, 0.);
 
-        if (input_data.Xc_indptr != NULL && gain)
+        if (model_params.ncols_per_tree >= input_data.ncols_tot)
         {
-            min_size_szt = std::max(min_size_szt, model_params.sample_size);
-            min_size_dbl = std::max(min_size_dbl, model_params.sample_size);
-        }
 
-        /* TODO: revisit if this covers all the cases */
-        if (model_params.ntry > 1 || gain)
-        {
-            min_size_dbl = std::max(min_size_dbl, model_params.sample_size);
-            if (model_params.ndim < 2 && input_data.Xc_indptr != NULL)
-                min_size_dbl = std::max(min_size_dbl, (size_t)2*model_params.sample_size);
-        }
-
-        /* for sampled column choices */
-        if (model_params.prob_pick_col_by_var)
-        {
-            if (input_data.ncols_categ) {
-                min_size_szt = std::max(min_size_szt, (size_t)input_data.max_categ + 1);
-                min_size_dbl = std::max(min_size_dbl, (size_t)input_data.max_categ + 1);
-            }
-        }
-
-        if (model_params.prob_pick_col_by_kurt)
-        {
-            if (input_data.ncols_categ) {
-                min_size_szt = std::max(min_size_szt, (size_t)input_data.max_categ + 1);
-                min_size_dbl = std::max(min_size_dbl, (size_t)input_data.max_categ);
-            }
-
-        }
-
-        /* for the extended model */
-        if (hplane_root != NULL)
-        {
-            min_size_dbl = std::max(min_size_dbl, pow2(log2ceil(input_data.ncols_tot) + 1));
-            if (model_params.missing_action != Fail)
-            {
-                min_size_szt = std::max(min_size_szt, model_params.sample_size);
-                min_size_dbl = std::max(min_size_dbl, model_params.sample_size);
-            }
-
-            if (input_data.ncols_categ && model_params.cat_split_type == SubSet)
-            {
-                min_size_szt = std::max(min_size_szt, (size_t)2 * (size_t)input_data.max_categ + (size_t)1);
-                min_size_dbl = std::max(min_size_dbl, (size_t)input_data.max_categ);
-            }
-
-            if (model_params.weigh_by_kurt)
-                min_size_szt = std::max(min_size_szt, input_data.ncols_tot);
-
-            if (gain && (!workspace.weights_arr.empty() || !workspace.weights_map.empty()))
-            {
-                workspace.sample_weights.resize(model_params.sample_size);
-                min_size_szt = std::max(min_size_szt, model_params.sample_size);
-            }
-        }
-
-        /* now resize */
-        if (workspace.buffer_dbl.size() < min_size_dbl)
-            workspace.buffer_dbl.resize(min_size_dbl);
-
-        if (workspace.buffer_szt.size() < min_size_szt)
-            workspace.buffer_szt.resize(min_size_szt);
-
-        if (workspace.buffer_chr.size() < min_size_chr)
-            workspace.buffer_chr.resize(min_size_chr);
-
-        /* for guided column choice, need to also remember the best split so far */
-        if (
-            model_params.cat_split_type == SubSet &&
-            (
-                model_params.prob_pick_by_gain_avg  || 
-                model_params.prob_pick_by_gain_pl   ||
-                model_params.prob_pick_by_full_gain ||
-                model_params.prob_pick_by_dens
-            )
-           )
-        {
-            workspace.this_split_categ.resize(input_data.max_categ);
-        }
-
-    }
-
-    /* Other potentially necessary buffers */
-    if (
-        tree_root != NULL && model_params.missing_action == Impute &&
-        (model_params.prob_pick_by_gain_avg  || model_params.prob_pick_by_gain_pl ||
-         model_params.prob_pick_by_full_gain || model_params.prob_pick_by_dens) &&
-        input_data.Xc_indptr == NULL && input_data.ncols_numeric && workspace.imputed_x_buffer.empty()
-    )
-    {
-        workspace.imputed_x_buffer.resize(input_data.nrows);
-    }
-
-    if (model_params.prob_pick_by_full_gain && workspace.col_indices.empty())
-        workspace.col_indices.resize(model_params.ncols_per_tree);
-
-    if (
-        (model_params.prob_pick_col_by_range || model_params.prob_pick_col_by_var) &&
-        model_params.weigh_by_kurt &&
-        model_params.sample_size == input_data.nrows && !model_params.with_replacement &&
-        (model_params.ncols_per_tree == input_data.ncols_tot) &&
-        !input_data.all_kurtoses.empty()
-    ) {
-        workspace.tree_kurtoses = input_data.all_kurtoses.data();
-    }
-    else {
-        workspace.tree_kurtoses = NULL;
-    }
-
-    /* weigh columns by kurtosis in the sample if required */
-    /* TODO: this one could probably be refactored to use the function in the helpers */
-    std::vector<double> kurt_weights;
-    bool avoid_leave_m_cols = false;
-    if (
-        model_params.weigh_by_kurt &&
-        !avoid_col_weights &&
-        (input_data.preinitialized_col_sampler == NULL
-            ||
-         ((model_params.prob_pick_col_by_range || model_params.prob_pick_col_by_var) && workspace.tree_kurtoses == NULL))
-    )
-    {
-        kurt_weights.resize(input_data.ncols_numeric + input_data.ncols_categ, 0.);
-
-        if (model_params.ncols_per_tree >= input_data.ncols_tot)
-        {
-
-            if (input_data.Xc_indptr == NULL)
-            {
+            if (input_data.Xc_indptr == NULL)
+            {
 
                 for (size_t col = 0; col < input_data.ncols_numeric; col++)
                 {
@@ -2170,7 +2355,7 @@ void fit_itree(std::vector<IsoTree>    *tree_root,
                         calc_kurtosis_weighted<decltype(workspace.weights_arr), ldouble_safe>(
                                                workspace.ix_arr.data(), workspace.st, workspace.end,
                                                input_data.categ_data + col * input_data.nrows, input_data.ncat[col],
-                                               workspace.buffer_dbl.data(),
+                                               workspace.buffer_dbl.data(), workspace.split_scratch.buffer_cnt.data(),
                                                model_params.missing_action, model_params.cat_split_type, workspace.rnd_generator,
                                                workspace.weights_arr);
                 else
@@ -2178,7 +2363,7 @@ void fit_itree(std::vector<IsoTree>    *tree_root,
                         calc_kurtosis_weighted<decltype(workspace.weights_map), ldouble_safe>(
                                                workspace.ix_arr.data(), workspace.st, workspace.end,
                                                input_data.categ_data + col * input_data.nrows, input_data.ncat[col],
-                                               workspace.buffer_dbl.data(),
+                                               workspace.buffer_dbl.data(), workspace.split_scratch.buffer_cnt.data(),
                                                model_params.missing_action, model_params.cat_split_type, workspace.rnd_generator,
                                                workspace.weights_map);
             }
@@ -2290,7 +2475,7 @@ void fit_itree(std::vector<IsoTree>    *tree_root,
                                                    workspace.ix_arr.data(), workspace.st, workspace.end,
                                                    input_data.categ_data + (col - input_data.ncols_numeric) * input_data.nrows,
                                                    input_data.ncat[col - input_data.ncols_numeric],
-                                                   workspace.buffer_dbl.data(),
+                                                   workspace.buffer_dbl.data(), workspace.split_scratch.buffer_cnt.data(),
                                                    model_params.missing_action, model_params.cat_split_type, workspace.rnd_generator,
                                                    workspace.weights_arr);
                     else
@@ -2299,7 +2484,7 @@ void fit_itree(std::vector<IsoTree>    *tree_root,
                                                    workspace.ix_arr.data(), workspace.st, workspace.end,
                                                    input_data.categ_data + (col - input_data.ncols_numeric) * input_data.nrows,
                                                    input_data.ncat[col - input_data.ncols_numeric],
-                                                   workspace.buffer_dbl.data(),
+                                                   workspace.buffer_dbl.data(), workspace.split_scratch.buffer_cnt.data(),
                                                    model_params.missing_action, model_params.cat_split_type, workspace.rnd_generator,
                                                    workspace.weights_map);
                 }
@@ -2373,29 +2558,551 @@ void fit_itree(std::vector<IsoTree>    *tree_root,
                                                               col_sampler_is_fresh);
     }
 
+    workspace.presorted_valid = false;
+    if (
+        tree_root != NULL && model_params.split_search == PresortedSearch &&
+        input_data.numeric_data != NULL &&
+        (model_params.prob_pick_by_gain_avg  + model_params.prob_pick_by_gain_pl +
+         model_params.prob_pick_by_full_gain + model_params.prob_pick_by_dens) > 0
+    )
+        initialize_presorted(workspace, input_data);
+
+    /* when growing the nodes as separate tasks, the tree only gets set up here */
+    if (task_tree != NULL)
+    {
+        task_tree->kurt_weights.swap(kurt_weights);
+        task_tree->tree_kurtoses = workspace.tree_kurtoses;
+        task_tree->root = std::unique_ptr<NodeTask<WorkerMemory>>(new NodeTask<WorkerMemory>());
+        capture_node_task(*task_tree->root, workspace, input_data, impute_nodes, (size_t)0, (size_t)0);
+        if (tree_root != NULL)
+            tree_root->clear();
+        else
+            hplane_root->clear();
+        if (impute_nodes != NULL)
+            impute_nodes->clear();
+        return;
+    }
+
     if (tree_root != NULL)
     {
-        split_itree_recursive<InputData, WorkerMemory, ldouble_safe>(
-                              *tree_root,
-                              workspace,
-                              input_data,
-                              model_params,
-                              impute_nodes,
-                              0);
+        grow_itree<InputData, WorkerMemory, ldouble_safe>(
+                   *tree_root,
+                   workspace,
+                   input_data,
+                   model_params,
+                   impute_nodes,
+                   (size_t)0);
     }
 
     else
     {
-        split_hplane_recursive<InputData, WorkerMemory, ldouble_safe>(
-                               *hplane_root,
-                               workspace,
-                               input_data,
-                               model_params,
-                               impute_nodes,
-                               0);
+        grow_hplane_tree<InputData, WorkerMemory, ldouble_safe>(
+                         *hplane_root,
+                         workspace,
+                         input_data,
+                         model_params,
+                         impute_nodes,
+                         (size_t)0);
     }
 
     /* if producing imputation structs, only need to keep the ones for terminal nodes */
     if (impute_nodes != NULL)
         drop_nonterminal_imp_node(*impute_nodes, tree_root, hplane_root);
 }
+
+/* Makes space in the workspace for the buffers that the nodes need, if they are not already allocated */
+template <class InputData, class WorkerMemory>
+void allocate_worker_buffers(WorkerMemory &workspace, InputData &input_data, ModelParams &model_params, bool is_ext)
+{
+    /* initialize array with candidate categories if not already done */
+    if (workspace.categs.empty())
+        workspace.categs.resize(input_data.max_categ);
+
+    /* initialize array with per-node column weights if needed */
+    if ((model_params.prob_pick_col_by_range ||
+         model_params.prob_pick_col_by_var ||
+         model_params.prob_pick_col_by_kurt) && workspace.node_col_weights.empty())
+    {
+        workspace.node_col_weights.resize(input_data.ncols_tot);
+        if (!is_ext || model_params.standardize_data || model_params.missing_action != Fail)
+        {
+            workspace.saved_stat1.resize(input_data.ncols_numeric);
+            workspace.saved_stat2.resize(input_data.ncols_numeric);
+        }
+    }
+
+    /* for the extended model, initialize extra vectors and objects */
+    if (is_ext && workspace.comb_val.empty())
+    {
+        workspace.comb_val.resize(model_params.sample_size);
+        workspace.col_take.resize(model_params.ndim);
+        workspace.col_take_type.resize(model_params.ndim);
+
+        if (input_data.ncols_numeric)
+        {
+            workspace.ext_offset.resize(input_data.ncols_tot);
+            workspace.ext_coef.resize(input_data.ncols_tot);
+            workspace.ext_mean.resize(input_data.ncols_tot);
+        }
+
+        if (input_data.ncols_categ)
+        {
+            workspace.ext_fill_new.resize(input_data.max_categ);
+            switch(model_params.cat_split_type)
+            {
+                case SingleCateg:
+                {
+                    workspace.chosen_cat.resize(input_data.max_categ);
+                    break;
+                }
+
+                case SubSet:
+                {
+                    workspace.ext_cat_coef.resize(input_data.ncols_tot);
+                    for (std::vector<double> &v : workspace.ext_cat_coef)
+                        v.resize(input_data.max_categ);
+                    break;
+                }
+            }
+        }
+
+        workspace.ext_fill_val.resize(input_data.ncols_tot);
+
+    }
+
+    /* if producing distance/similarity, also need to initialize the triangular matrix */
+    if (model_params.calc_dist && workspace.tmat_sep.empty())
+        workspace.tmat_sep.resize((input_data.nrows * (input_data.nrows - 1)) / 2, 0);
+
+    /* buffers for the split criteria */
+    if (
+            (model_params.prob_pick_by_gain_avg    > 0  ||
+             model_params.prob_pick_by_gain_pl     > 0  ||
+             model_params.prob_pick_by_full_gain   > 0  ||
+             model_params.prob_pick_by_dens        > 0  ||
+             model_params.prob_pick_col_by_range   > 0  ||
+             model_params.prob_pick_col_by_var     > 0  ||
+             model_params.prob_pick_col_by_kurt    > 0  ||
+             model_params.weigh_by_kurt || is_ext)
+                &&
+            (workspace.buffer_dbl.empty() && workspace.buffer_szt.empty() && workspace.buffer_chr.empty())
+        )
+    {
+        size_t min_size_dbl = 0;
+        size_t min_size_szt = 0;
+        size_t min_size_chr = 0;
+
+        bool gain = model_params.prob_pick_by_gain_avg  > 0 ||
+                    model_params.prob_pick_by_gain_pl   > 0 ||
+                    model_params.prob_pick_by_full_gain > 0 ||
+                    model_params.prob_pick_by_dens      > 0;
+
+        if (input_data.ncols_categ)
+        {
+            min_size_szt = (size_t)2 * (size_t)input_data.max_categ;
+            min_size_dbl = input_data.max_categ + 1;
+            if (gain && model_params.cat_split_type == SubSet)
+                min_size_chr = input_data.max_categ;
+        }
+
+        if (input_data.Xc_indptr != NULL && gain)
+        {
+            min_size_szt = std::max(min_size_szt, model_params.sample_size);
+            min_size_dbl = std::max(min_size_dbl, model_params.sample_size);
+        }
+
+        /* TODO: revisit if this covers all the cases */
+        if (model_params.ntry > 1 || gain)
+        {
+            min_size_dbl = std::max(min_size_dbl, model_params.sample_size);
+            if (model_params.ndim < 2 && input_data.Xc_indptr != NULL)
+                min_size_dbl = std::max(min_size_dbl, (size_t)2*model_params.sample_size);
+        }
+
+        /* for sampled column choices */
+        if (model_params.prob_pick_col_by_var)
+        {
+            if (input_data.ncols_categ) {
+                min_size_szt = std::max(min_size_szt, (size_t)input_data.max_categ + 1);
+                min_size_dbl = std::max(min_size_dbl, (size_t)input_data.max_categ + 1);
+            }
+        }
+
+        if (model_params.prob_pick_col_by_kurt)
+        {
+            if (input_data.ncols_categ) {
+                min_size_szt = std::max(min_size_szt, (size_t)input_data.max_categ + 1);
+                min_size_dbl = std::max(min_size_dbl, (size_t)input_data.max_categ);
+            }
+
+        }
+
+        /* for the extended model */
+        if (is_ext)
+        {
+            min_size_dbl = std::max(min_size_dbl, pow2(log2ceil(input_data.ncols_tot) + 1));
+            if (model_params.missing_action != Fail)
+            {
+                min_size_szt = std::max(min_size_szt, model_params.sample_size);
+                min_size_dbl = std::max(min_size_dbl, model_params.sample_size);
+            }
+
+            if (input_data.ncols_categ && model_params.cat_split_type == SubSet)
+            {
+                min_size_szt = std::max(min_size_szt, (size_t)2 * (size_t)input_data.max_categ + (size_t)1);
+                min_size_dbl = std::max(min_size_dbl, (size_t)input_data.max_categ);
+            }
+
+            if (model_params.weigh_by_kurt)
+                min_size_szt = std::max(min_size_szt, input_data.ncols_tot);
+
+            if (gain && (!workspace.weights_arr.empty() || !workspace.weights_map.empty()))
+            {
+                workspace.sample_weights.resize(model_params.sample_size);
+                min_size_szt = std::max(min_size_szt, model_params.sample_size);
+            }
+        }
+
+        /* now resize */
+        if (workspace.buffer_dbl.size() < min_size_dbl)
+            workspace.buffer_dbl.resize(min_size_dbl);
+
+        if (workspace.buffer_szt.size() < min_size_szt)
+            workspace.buffer_szt.resize(min_size_szt);
+
+        if (workspace.buffer_chr.size() < min_size_chr)
+            workspace.buffer_chr.resize(min_size_chr);
+
+        /* sorted copies are only needed for guided splits and for medians in the extended model */
+        workspace.split_scratch.initialize(
+            (gain || (is_ext && model_params.missing_action != Fail))? model_params.sample_size : 0,
+            model_params.prob_pick_by_full_gain? input_data.ncols_numeric : 0,
+            input_data.ncols_categ? input_data.max_categ : 0
+        );
+
+        /* for guided column choice, need to also remember the best split so far */
+        if (
+            model_params.cat_split_type == SubSet &&
+            (
+                model_params.prob_pick_by_gain_avg  || 
+                model_params.prob_pick_by_gain_pl   ||
+                model_params.prob_pick_by_full_gain ||
+                model_params.prob_pick_by_dens
+            )
+           )
+        {
+            workspace.this_split_categ.resize(input_data.max_categ);
+        }
+
+    }
+
+    /* Other potentially necessary buffers */
+    if (
+        !is_ext && model_params.missing_action == Impute &&
+        (model_params.prob_pick_by_gain_avg  || model_params.prob_pick_by_gain_pl ||
+         model_params.prob_pick_by_full_gain || model_params.prob_pick_by_dens) &&
+        input_data.Xc_indptr == NULL && input_data.ncols_numeric && workspace.imputed_x_buffer.empty()
+    )
+    {
+        workspace.imputed_x_buffer.resize(input_data.nrows);
+    }
+
+    if (model_params.prob_pick_by_full_gain && workspace.col_indices.empty())
+        workspace.col_indices.resize(model_params.ncols_per_tree);
+
+    /* the single-variable model saves the rows with missing values of the nodes whose right branch
+       is still pending - these usually add up to less than the sample size, and reserving that much
+       keeps later trees from having to grow the buffers */
+    if (!is_ext && model_params.missing_action != Fail && workspace.recursion_arena.buffer_szt.capacity() == 0)
+        workspace.recursion_arena.buffer_szt.reserve(model_params.sample_size);
+}
+
+template <class InputData>
+bool is_contiguous_colmajor(const InputData &input_data)
+{
+    return input_data.is_col_major &&
+           (input_data.numeric_data == NULL || input_data.ld_numeric == input_data.nrows) &&
+           (input_data.categ_data == NULL || input_data.ld_categ == input_data.nrows);
+}
+
+/* Copies the rows sampled for a tree into column-major tiles with as many rows as the sample size,
+   and remaps the row indices in 'ix_arr' to positions in those tiles. Distinct rows are placed in
+   the tiles in increasing order of their original indices, so that the indices keep the same
+   relative ordering and the resulting tree is the same as when fitting to column-major data.
+   When the tree takes every row (no sub-sampling), the positions are the original row indices, so
+   the tile can share everything that was computed beforehand for the full data. */
+template <class InputData, class WorkerMemory>
+void gather_sampled_rows(InputData &tile_data, InputData &input_data,
+                         WorkerMemory &workspace, ModelParams &model_params)
+{
+    size_t tile_nrows = model_params.sample_size;
+
+    workspace.tile_rows.assign(workspace.ix_arr.begin(), workspace.ix_arr.end());
+    std::sort(workspace.tile_rows.begin(), workspace.tile_rows.end());
+    workspace.tile_rows.erase(std::unique(workspace.tile_rows.begin(), workspace.tile_rows.end()),
+                              workspace.tile_rows.end());
+    size_t n_unique = workspace.tile_rows.size();
+    bool takes_all_rows = n_unique == input_data.nrows;
+    if (!takes_all_rows)
+    {
+        for (size_t &ix : workspace.ix_arr)
+            ix = std::distance(workspace.tile_rows.begin(),
+                               std::lower_bound(workspace.tile_rows.begin(), workspace.tile_rows.end(), ix));
+    }
+    const size_t *restrict rows = workspace.tile_rows.data();
+
+    if (input_data.numeric_data != NULL)
+    {
+        workspace.tile_numeric.resize(tile_nrows * input_data.ncols_numeric);
+        auto *restrict tile = workspace.tile_numeric.data();
+        if (input_data.is_col_major)
+        {
+            for (size_t col = 0; col < input_data.ncols_numeric; col++)
+                for (size_t row = 0; row < n_unique; row++)
+                    tile[row + col*tile_nrows] = input_data.numeric_data[rows[row] + col*input_data.ld_numeric];
+        }
+
+        else
+        {
+            for (size_t row = 0; row < n_unique; row++)
+                for (size_t col = 0; col < input_data.ncols_numeric; col++)
+                    tile[row + col*tile_nrows] = input_data.numeric_data[rows[row]*input_data.ld_numeric + col];
+        }
+        tile_data.numeric_data = tile;
+
+        if (input_data.X_binned != NULL && takes_all_rows)
+        {
+            tile_data.X_binned = input_data.X_binned;
+            tile_data.col_bins = input_data.col_bins;
+        }
+
+        else if (input_data.X_binned != NULL)
+        {
+            workspace.tile_binned.resize(tile_nrows * input_data.ncols_numeric);
+            uint8_t *restrict tile_binned = workspace.tile_binned.data();
+            for (size_t col = 0; col < input_data.ncols_numeric; col++)
+                for (size_t row = 0; row < n_unique; row++)
+                    tile_binned[row + col*tile_nrows] = input_data.X_binned[rows[row] + col*input_data.nrows];
+            tile_data.X_binned = tile_binned;
+            tile_data.col_bins = input_data.col_bins;
+        }
+
+        if (model_params.prob_pick_by_full_gain)
+        {
+            tile_data.X_row_major.swap(workspace.tile_row_major);
+            colmajor_to_rowmajor(tile, tile_nrows, input_data.ncols_numeric, tile_data.X_row_major);
+        }
+    }
+
+    if (input_data.categ_data != NULL)
+    {
+        workspace.tile_categ.resize(tile_nrows * input_data.ncols_categ);
+        int *restrict tile = workspace.tile_categ.data();
+        if (input_data.is_col_major)
+        {
+            for (size_t col = 0; col < input_data.ncols_categ; col++)
+                for (size_t row = 0; row < n_unique; row++)
+                    tile[row + col*tile_nrows] = input_data.categ_data[rows[row] + col*input_data.ld_categ];
+        }
+
+        else
+        {
+            for (size_t row = 0; row < n_unique; row++)
+                for (size_t col = 0; col < input_data.ncols_categ; col++)
+                    tile[row + col*tile_nrows] = input_data.categ_data[rows[row]*input_data.ld_categ + col];
+        }
+        tile_data.categ_data = tile;
+    }
+
+    /* density weights are re-generated for each tile, as the indices change from one tree to another */
+    if (input_data.sample_weights != NULL && !input_data.weight_as_sample)
+    {
+        workspace.tile_weights.resize(tile_nrows);
+        for (size_t row = 0; row < n_unique; row++)
+            workspace.tile_weights[row] = input_data.sample_weights[rows[row]];
+        tile_data.sample_weights = workspace.tile_weights.data();
+        workspace.weights_arr.clear();
+        workspace.weights_map.clear();
+    }
+
+    tile_data.ncols_numeric = input_data.ncols_numeric;
+    tile_data.ncat = input_data.ncat;
+    tile_data.max_categ = input_data.max_categ;
+    tile_data.ncols_categ = input_data.ncols_categ;
+    tile_data.nrows = tile_nrows;
+    tile_data.ncols_tot = input_data.ncols_tot;
+    tile_data.weight_as_sample = input_data.weight_as_sample;
+    tile_data.col_weights = input_data.col_weights;
+    tile_data.preinitialized_col_sampler = input_data.preinitialized_col_sampler;
+    tile_data.is_col_major = true;
+    tile_data.ld_numeric = tile_nrows;
+    tile_data.ld_categ = tile_nrows;
+
+    /* these are only computed when every tree takes every row */
+    if (takes_all_rows)
+    {
+        tile_data.range_low = input_data.range_low;
+        tile_data.range_high = input_data.range_high;
+        tile_data.ncat_ = input_data.ncat_;
+        tile_data.all_kurtoses = input_data.all_kurtoses;
+        tile_data.has_missing = input_data.has_missing;
+        tile_data.n_missing = input_data.n_missing;
+        tile_data.presorted_ix = input_data.presorted_ix;
+    }
+}
+
+template <class real_t>
+void copy_to_colmajor(const real_t *restrict src, bool is_col_major, size_t ld,
+                      size_t nrows, size_t ncols, std::vector<real_t> &dst)
+{
+    dst.resize(nrows * ncols);
+    if (is_col_major)
+    {
+        for (size_t col = 0; col < ncols; col++)
+            std::copy(src + col*ld, src + col*ld + nrows, dst.begin() + col*nrows);
+    }
+
+    else
+    {
+        for (size_t row = 0; row < nrows; row++)
+            for (size_t col = 0; col < ncols; col++)
+                dst[row + col*nrows] = src[row*ld + col];
+    }
+}
+
+template <class real_t>
+void copy_from_colmajor(const std::vector<real_t> &src, bool is_col_major, size_t ld,
+                        size_t nrows, size_t ncols, real_t *restrict dst)
+{
+    if (is_col_major)
+    {
+        for (size_t col = 0; col < ncols; col++)
+            std::copy(src.begin() + col*nrows, src.begin() + (col+1)*nrows, dst + col*ld);
+    }
+
+    else
+    {
+        for (size_t row = 0; row < nrows; row++)
+            for (size_t col = 0; col < ncols; col++)
+                dst[row*ld + col] = src[row + col*nrows];
+    }
+}
+
+/* Returns a pointer to the start of a column of dense data, which is copied into 'buffer' if the
+   data is in row-major order. Columns in column-major order are used as they are, since these full
+   passes over a column do not depend on the leading dimension beyond the offset of its start. */
+template <class T>
+T* get_strided_column(T *data, bool is_col_major, size_t ld, size_t nrows, size_t col, std::vector<T> &buffer)
+{
+    if (is_col_major)
+        return data + col*ld;
+    buffer.resize(nrows);
+    for (size_t row = 0; row < nrows; row++)
+        buffer[row] = data[row*ld + col];
+    return buffer.data();
+}
+
+/* Assigns the values of the dense numeric columns to at most 'HIST_MAX_BINS' bins each (plus one for
+   missing values), which are used for finding guided splits through histograms. The bin limits are
+   taken as the midpoints between distinct values if there are few of them, or between quantiles
+   otherwise, in both cases determined from a systematic sub-sample of the rows. */
+template <class real_t>
+void build_column_bins(const real_t *restrict numeric_data, bool is_col_major, size_t ld_numeric,
+                       size_t nrows, size_t ncols, ColumnBins &col_bins, std::vector<uint8_t> &X_binned,
+                       int nthreads)
+{
+    col_bins.bin_edges.assign(ncols * HIST_MAX_BINS, HUGE_VAL);
+    col_bins.bin_ref.assign(ncols * HIST_MAX_BINS, 0.);
+    col_bins.nbins.assign(ncols, 0);
+    X_binned.resize(nrows * ncols);
+    size_t step = (nrows + HIST_SAMPLE_ROWS - 1) / HIST_SAMPLE_ROWS;
+    size_t row_stride = is_col_major? 1 : ld_numeric;
+    size_t col_stride = is_col_major? ld_numeric : 1;
+
+    auto bin_column = [&](size_t col, int)
+    {
+        const real_t *restrict x = numeric_data + col*col_stride;
+        double *restrict edges = col_bins.bin_edges.data() + col*HIST_MAX_BINS;
+        double *restrict ref = col_bins.bin_ref.data() + col*HIST_MAX_BINS;
+        uint8_t *restrict x_binned = X_binned.data() + col*nrows;
+
+        std::vector<double> sample;
+        sample.reserve(nrows / step + 1);
+        for (size_t row = 0; row < nrows; row += step)
+        {
+            double xval = x[row*row_stride];
+            if (likely(!is_na_or_inf(xval)))
+                sample.push_back(xval);
+        }
+        std::sort(sample.begin(), sample.end());
+        size_t n = sample.size();
+
+        int nbins = 0;
+        if (n)
+        {
+            size_t ndistinct = 1;
+            for (size_t ix = 1; ix < n && ndistinct <= HIST_MAX_BINS; ix++)
+                ndistinct += sample[ix] != sample[ix-1];
+
+            if (ndistinct <= HIST_MAX_BINS)
+            {
+                ref[0] = sample[0];
+                for (size_t ix = 1; ix < n; ix++)
+                {
+                    if (sample[ix] == sample[ix-1]) continue;
+                    edges[nbins++] = midpoint(sample[ix-1], sample[ix]);
+                    ref[nbins] = sample[ix];
+                }
+            }
+
+            else
+            {
+                size_t pos = 0;
+                size_t next;
+                while (pos < n)
+                {
+                    ref[nbins] = sample[pos];
+                    next = (nbins == HIST_MAX_BINS-1)? n : std::max(pos + 1, (n * (size_t)(nbins+1)) / HIST_MAX_BINS);
+                    while (next < n && sample[next] == sample[next-1]) next++;
+                    if (next >= n) break;
+                    edges[nbins++] = midpoint(sample[next-1], sample[next]);
+                    pos = next;
+                }
+            }
+
+            edges[nbins++] = HUGE_VAL;
+        }
+
+        for (size_t row = 0; row < nrows; row++)
+        {
+            double xval = x[row*row_stride];
+            if (unlikely(is_na_or_inf(xval)))
+                x_binned[row] = HIST_NA_BIN;
+            else if (unlikely(!nbins))
+                x_binned[row] = 0;
+            else
+                x_binned[row] = (uint8_t)std::distance(edges, std::lower_bound(edges, edges + (nbins - 1), xval));
+        }
+        col_bins.nbins[col] = nbins;
+    };
+
+    run_parallel_for(get_thread_executor(), ncols, nthreads, true, bin_column);
+}
+
+/* Sorts the indices of all rows by each numeric column, with missing values first, which are then
+   shared by all the trees when finding guided splits with presorted indices and no sub-sampling. */
+template <class real_t>
+void presort_all_columns(real_t *numeric_data, bool is_col_major, size_t ld_numeric,
+                         size_t nrows, size_t ncols, std::vector<size_t> &presorted_ix, int nthreads)
+{
+    presorted_ix.resize(nrows * ncols);
+    auto sort_column = [&](size_t col, int)
+    {
+        std::vector<real_t> buffer;
+        size_t *restrict sorted = presorted_ix.data() + col*nrows;
+        std::iota(sorted, sorted + nrows, (size_t)0);
+        presort_column(sorted, nrows, get_strided_column(numeric_data, is_col_major, ld_numeric, nrows, col, buffer));
+    };
+
+    run_parallel_for(get_thread_executor(), ncols, nthreads, true, sort_column);
+}
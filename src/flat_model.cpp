@@ -0,0 +1,582 @@
+/*    Isolation forests and variations thereof, with adjustments for incorporation
+*     of categorical variables and missing values.
+*     Writen for C++11 standard and aimed at being used in R and Python.
+*     
+*     This library is based on the following works:
+*     [1] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation forest."
+*         2008 Eighth IEEE International Conference on Data Mining. IEEE, 2008.
+*     [2] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation-based anomaly detection."
+*         ACM Transactions on Knowledge Discovery from Data (TKDD) 6.1 (2012): 3.
+*     [3] Hariri, Sahand, Matias Carrasco Kind, and Robert J. Brunner.
+*         "Extended Isolation Forest."
+*         arXiv preprint arXiv:1811.02141 (2018).
+*     [4] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "On detecting clustered anomalies using SCiForest."
+*         Joint European Conference on Machine Learning and Knowledge Discovery in Databases. Springer, Berlin, Heidelberg, 2010.
+*     [5] https://sourceforge.net/projects/iforest/
+*     [6] https://math.stackexchange.com/questions/3388518/expected-number-of-paths-required-to-separate-elements-in-a-binary-tree
+*     [7] Quinlan, J. Ross. C4. 5: programs for machine learning. Elsevier, 2014.
+*     [8] Cortes, David.
+*         "Distance approximation using Isolation Forests."
+*         arXiv preprint arXiv:1910.12362 (2019).
+*     [9] Cortes, David.
+*         "Imputing missing values with unsupervised random trees."
+*         arXiv preprint arXiv:1911.06646 (2019).
+*     [10] https://math.stackexchange.com/questions/3333220/expected-average-depth-in-random-binary-tree-constructed-top-to-bottom
+*     [11] Cortes, David.
+*          "Revisiting randomized choices in isolation forests."
+*          arXiv preprint arXiv:2110.13402 (2021).
+*     [12] Guha, Sudipto, et al.
+*          "Robust random cut forest based anomaly detection on streams."
+*          International conference on machine learning. PMLR, 2016.
+*     [13] Cortes, David.
+*          "Isolation forests: looking beyond tree depth."
+*          arXiv preprint arXiv:2111.11639 (2021).
+*     [14] Ting, Kai Ming, Yue Zhu, and Zhi-Hua Zhou.
+*          "Isolation kernel and its effect on SVM"
+*          Proceedings of the 24th ACM SIGKDD
+*          International Conference on Knowledge Discovery & Data Mining. 2018.
+* 
+*     BSD 2-Clause License
+*     Copyright (c) 2019-2022, David Cortes
+*     All rights reserved.
+*     Redistribution and use in source and binary forms, with or without
+*     modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this
+*       list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*       this list of conditions and the following disclaimer in the documentation
+*       and/or other materials provided with the distribution.
+*     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+*     AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+*     IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*     FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*     DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*     SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*     CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*     OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*     OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "isotree.hpp"
+
+#if defined(_WIN32) || defined(_WIN64)
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+    #define HAS_WINDOWS_MMAP
+#elif defined(__unix__) || defined(__unix) || defined(__APPLE__)
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #define HAS_POSIX_MMAP
+#endif
+
+/*  Flat format:
+    - A header of 64 x 64-bit words (see 'FlatHeaderField'), starting with a 16-byte watermark.
+    - One section per array, each starting at an offset (from the beginning) which is a multiple
+      of 64 bytes, with the offsets being stored in the header. Elements are either 64-bit
+      (unsigned integers and 'double'), or 32-bit (unsigned integers and 'float') for models
+      saved in single precision.
+    Arrays are stored in the byte order of the machine that produced them (which is recorded in
+    the header and checked at load time), so that they can be used directly from the file. */
+static const char flat_watermark[] = "isotree_flat_v1";
+static const size_t SIZE_FLAT_WATERMARK = 16;
+static const uint64_t FLAT_BYTE_ORDER_MARK = UINT64_C(0x0102030405060708);
+static const uint64_t FLAT_FORMAT_VERSION = 1;
+static const size_t FLAT_ALIGNMENT = 64;
+static const size_t FLAT_HEADER_WORDS = 64;
+
+enum FlatHeaderField {
+    FlatByteOrder = 2, FlatVersion, FlatModelType,
+    FlatMissingAction, FlatNewCatAction, FlatCatSplitType, FlatScoringMetric, FlatHasRangePenalty,
+    FlatExpAvgDepth, FlatExpAvgSep, FlatOrigSampleSize,
+    FlatNTrees, FlatNNodes, FlatNCoef, FlatNColsNumeric, FlatTotalSize, FlatSinglePrecision,
+    FlatSectionsStart /* <- offsets of the sections, in the order of 'FlatSection' */
+};
+enum FlatSection {
+    SecTreeOffsets, SecTreeLeft, SecTreeRight, SecSplit, SecScore, SecRangeLow, SecRangeHigh,
+    SecPctTreeLeft, SecColNum, SecCoefOffsets, SecCoefCol, SecCoef, SecMean, SecFillVal,
+    NumFlatSections
+};
+enum FlatModelCode {FlatSingleVarModel=1, FlatExtModel=2};
+
+static_assert(FlatSectionsStart + NumFlatSections <= FLAT_HEADER_WORDS, "Flat header is too small.");
+static_assert(sizeof(double) == sizeof(uint64_t), "Flat format requires 64-bit doubles.");
+static_assert(sizeof(float) == sizeof(uint32_t), "Flat format requires 32-bit floats.");
+
+static size_t get_flat_section_length(FlatSection section, bool is_extended,
+                                      size_t ntrees, size_t nnodes, size_t ncoef) noexcept
+{
+    switch (section)
+    {
+        case SecTreeOffsets: return ntrees + 1;
+        case SecPctTreeLeft: case SecColNum: return is_extended? 0 : nnodes;
+        case SecCoefOffsets: return is_extended? (nnodes + 1) : 0;
+        case SecCoefCol: case SecCoef: case SecMean: case SecFillVal: return is_extended? ncoef : 0;
+        default: return nnodes;
+    }
+}
+
+static size_t round_up_flat(size_t n) noexcept
+{
+    return ((n + FLAT_ALIGNMENT - 1) / FLAT_ALIGNMENT) * FLAT_ALIGNMENT;
+}
+
+static void check_flat_model_input(const IsoForest *model, const ExtIsoForest *model_ext)
+{
+    if ((model == NULL) == (model_ext == NULL))
+        throw std::runtime_error("Must pass exactly one of single-variable or extended model.\n");
+    if (model != NULL)
+    {
+        for (const auto &tree : model->trees)
+            for (const auto &node : tree)
+                if (node.tree_left && node.col_type != Numeric)
+                    throw std::runtime_error("Flat model format only supports models fit to numeric-only data.\n");
+    }
+
+    else
+    {
+        for (const auto &hplane : model_ext->hplanes)
+            for (const auto &node : hplane)
+                for (const auto coltype : node.col_type)
+                    if (coltype != Numeric)
+                        throw std::runtime_error("Flat model format only supports models fit to numeric-only data.\n");
+    }
+}
+
+static void build_flat_header(const IsoForest *model, const ExtIsoForest *model_ext, bool single_precision,
+                              uint64_t header[FLAT_HEADER_WORDS])
+{
+    memset(header, 0, FLAT_HEADER_WORDS * sizeof(uint64_t));
+    memcpy(header, flat_watermark, SIZE_FLAT_WATERMARK);
+
+    const bool is_extended = model_ext != NULL;
+    size_t ntrees = 0, nnodes = 0, ncoef = 0, ncols_numeric = 0;
+    if (!is_extended)
+    {
+        ntrees = model->trees.size();
+        for (const auto &tree : model->trees)
+        {
+            nnodes += tree.size();
+            for (const auto &node : tree)
+                if (node.tree_left) ncols_numeric = std::max(ncols_numeric, node.col_num + 1);
+        }
+    }
+
+    else
+    {
+        ntrees = model_ext->hplanes.size();
+        for (const auto &hplane : model_ext->hplanes)
+        {
+            nnodes += hplane.size();
+            for (const auto &node : hplane)
+            {
+                ncoef += node.col_num.size();
+                for (const auto col : node.col_num) ncols_numeric = std::max(ncols_numeric, col + 1);
+            }
+        }
+    }
+
+    if (single_precision && (nnodes >= (size_t)UINT32_MAX || ncoef >= (size_t)UINT32_MAX || ncols_numeric > (size_t)UINT32_MAX))
+        throw std::runtime_error("Model is too large to be saved in single precision.\n");
+
+    header[FlatByteOrder] = FLAT_BYTE_ORDER_MARK;
+    header[FlatVersion] = FLAT_FORMAT_VERSION;
+    header[FlatModelType] = is_extended? FlatExtModel : FlatSingleVarModel;
+    header[FlatMissingAction] = is_extended? model_ext->missing_action : model->missing_action;
+    header[FlatNewCatAction] = is_extended? model_ext->new_cat_action : model->new_cat_action;
+    header[FlatCatSplitType] = is_extended? model_ext->cat_split_type : model->cat_split_type;
+    header[FlatScoringMetric] = is_extended? model_ext->scoring_metric : model->scoring_metric;
+    header[FlatHasRangePenalty] = is_extended? model_ext->has_range_penalty : model->has_range_penalty;
+    double exp_avg_depth = is_extended? model_ext->exp_avg_depth : model->exp_avg_depth;
+    double exp_avg_sep = is_extended? model_ext->exp_avg_sep : model->exp_avg_sep;
+    memcpy(&header[FlatExpAvgDepth], &exp_avg_depth, sizeof(double));
+    memcpy(&header[FlatExpAvgSep], &exp_avg_sep, sizeof(double));
+    header[FlatOrigSampleSize] = is_extended? model_ext->orig_sample_size : model->orig_sample_size;
+    header[FlatNTrees] = ntrees;
+    header[FlatNNodes] = nnodes;
+    header[FlatNCoef] = ncoef;
+    header[FlatNColsNumeric] = ncols_numeric;
+    header[FlatSinglePrecision] = single_precision;
+
+    const size_t elem_size = single_precision? sizeof(uint32_t) : sizeof(uint64_t);
+    size_t curr_pos = FLAT_HEADER_WORDS * sizeof(uint64_t);
+    for (int section = 0; section < NumFlatSections; section++)
+    {
+        curr_pos = round_up_flat(curr_pos);
+        header[FlatSectionsStart + section] = curr_pos;
+        curr_pos += elem_size * get_flat_section_length((FlatSection)section, is_extended, ntrees, nnodes, ncoef);
+    }
+    header[FlatTotalSize] = round_up_flat(curr_pos);
+}
+
+static void write_flat_bytes(const void *ptr, size_t n_bytes, char *&out) noexcept
+{
+    memcpy(out, ptr, n_bytes);
+    out += n_bytes;
+}
+
+static void write_flat_bytes(const void *ptr, size_t n_bytes, FILE *&out)
+{
+    if (fwrite(ptr, 1, n_bytes, out) != n_bytes) throw_ferror(out);
+}
+
+template <class otype>
+static void write_flat_padding(size_t &curr_pos, size_t target_pos, otype &out)
+{
+    static const char zeros[FLAT_ALIGNMENT] = {0};
+    while (curr_pos < target_pos)
+    {
+        size_t n_write = std::min(target_pos - curr_pos, FLAT_ALIGNMENT);
+        write_flat_bytes(zeros, n_write, out);
+        curr_pos += n_write;
+    }
+}
+
+template <class dtype, class otype>
+static void write_flat_value(dtype value, size_t &curr_pos, otype &out)
+{
+    write_flat_bytes(&value, sizeof(dtype), out);
+    curr_pos += sizeof(dtype);
+}
+
+template <class otype>
+static void write_flat_index(uint64_t value, bool single_precision, size_t &curr_pos, otype &out)
+{
+    if (single_precision)
+        write_flat_value((uint32_t)value, curr_pos, out);
+    else
+        write_flat_value(value, curr_pos, out);
+}
+
+template <class otype>
+static void write_flat_real(double value, bool single_precision, size_t &curr_pos, otype &out)
+{
+    if (single_precision)
+        write_flat_value((float)value, curr_pos, out);
+    else
+        write_flat_value(value, curr_pos, out);
+}
+
+/* In single precision, the split thresholds and ranges of single-variable models are rounded
+   outwards so that comparisons against 'float' inputs give the same results as with the
+   original 'double' values - the only differences for such inputs come from the scores. */
+static double round_down_for_flat(double value, bool single_precision) noexcept
+{
+    return single_precision? (double)round_threshold_down(value) : value;
+}
+
+static double round_up_for_flat(double value, bool single_precision) noexcept
+{
+    return single_precision? (double)round_threshold_up(value) : value;
+}
+
+template <class otype>
+static void write_flat_section(const IsoForest &model, FlatSection section, bool single_precision,
+                               size_t &curr_pos, otype &out)
+{
+    if (section == SecTreeOffsets)
+    {
+        uint64_t offset = 0;
+        write_flat_index(offset, single_precision, curr_pos, out);
+        for (const auto &tree : model.trees)
+        {
+            offset += tree.size();
+            write_flat_index(offset, single_precision, curr_pos, out);
+        }
+        return;
+    }
+
+    for (const auto &tree : model.trees)
+    {
+        size_t n_terminal = 0;
+        for (const auto &node : tree)
+        {
+            switch (section)
+            {
+                case SecTreeLeft:    {write_flat_index(node.tree_left, single_precision, curr_pos, out); break;}
+                case SecTreeRight:   {write_flat_index(node.tree_left? node.tree_right : n_terminal++,
+                                                       single_precision, curr_pos, out); break;}
+                case SecSplit:       {write_flat_real(round_down_for_flat(node.num_split, single_precision),
+                                                      single_precision, curr_pos, out); break;}
+                case SecScore:       {write_flat_real(node.score, single_precision, curr_pos, out); break;}
+                case SecRangeLow:    {write_flat_real(round_up_for_flat(node.range_low, single_precision),
+                                                      single_precision, curr_pos, out); break;}
+                case SecRangeHigh:   {write_flat_real(round_down_for_flat(node.range_high, single_precision),
+                                                      single_precision, curr_pos, out); break;}
+                case SecPctTreeLeft: {write_flat_real(node.pct_tree_left, single_precision, curr_pos, out); break;}
+                case SecColNum:      {write_flat_index(node.col_num, single_precision, curr_pos, out); break;}
+                default:             {return;}
+            }
+        }
+    }
+}
+
+template <class otype>
+static void write_flat_section(const ExtIsoForest &model, FlatSection section, bool single_precision,
+                               size_t &curr_pos, otype &out)
+{
+    if (section == SecTreeOffsets)
+    {
+        uint64_t offset = 0;
+        write_flat_index(offset, single_precision, curr_pos, out);
+        for (const auto &hplane : model.hplanes)
+        {
+            offset += hplane.size();
+            write_flat_index(offset, single_precision, curr_pos, out);
+        }
+        return;
+    }
+
+    if (section == SecCoefOffsets)
+    {
+        uint64_t offset = 0;
+        write_flat_index(offset, single_precision, curr_pos, out);
+        for (const auto &hplane : model.hplanes)
+        {
+            for (const auto &node : hplane)
+            {
+                offset += node.col_num.size();
+                write_flat_index(offset, single_precision, curr_pos, out);
+            }
+        }
+        return;
+    }
+
+    for (const auto &hplane : model.hplanes)
+    {
+        size_t n_terminal = 0;
+        for (const auto &node : hplane)
+        {
+            switch (section)
+            {
+                case SecTreeLeft:    {write_flat_index(node.hplane_left, single_precision, curr_pos, out); break;}
+                case SecTreeRight:   {write_flat_index(node.hplane_left? node.hplane_right : n_terminal++,
+                                                       single_precision, curr_pos, out); break;}
+                case SecSplit:       {write_flat_real(node.split_point, single_precision, curr_pos, out); break;}
+                case SecScore:       {write_flat_real(node.score, single_precision, curr_pos, out); break;}
+                case SecRangeLow:    {write_flat_real(node.range_low, single_precision, curr_pos, out); break;}
+                case SecRangeHigh:   {write_flat_real(node.range_high, single_precision, curr_pos, out); break;}
+                case SecCoefCol:
+                {
+                    for (const auto col : node.col_num)
+                        write_flat_index(col, single_precision, curr_pos, out);
+                    break;
+                }
+                case SecCoef:
+                {
+                    for (const auto coef : node.coef)
+                        write_flat_real(coef, single_precision, curr_pos, out);
+                    break;
+                }
+                case SecMean:
+                {
+                    for (const auto mean : node.mean)
+                        write_flat_real(mean, single_precision, curr_pos, out);
+                    break;
+                }
+                case SecFillVal:
+                {
+                    /* these are empty when not imputing missing values */
+                    for (size_t col = 0; col < node.col_num.size(); col++)
+                        write_flat_real(node.fill_val.empty()? 0. : node.fill_val[col], single_precision, curr_pos, out);
+                    break;
+                }
+                default: {return;}
+            }
+        }
+    }
+}
+
+template <class otype>
+static void serialize_flat_model_internal(const IsoForest *model, const ExtIsoForest *model_ext,
+                                          bool single_precision, otype &out)
+{
+    check_flat_model_input(model, model_ext);
+    uint64_t header[FLAT_HEADER_WORDS];
+    build_flat_header(model, model_ext, single_precision, header);
+
+    size_t curr_pos = 0;
+    write_flat_bytes(header, sizeof(header), out);
+    curr_pos += sizeof(header);
+    for (int section = 0; section < NumFlatSections; section++)
+    {
+        write_flat_padding(curr_pos, header[FlatSectionsStart + section], out);
+        if (model != NULL)
+            write_flat_section(*model, (FlatSection)section, single_precision, curr_pos, out);
+        else
+            write_flat_section(*model_ext, (FlatSection)section, single_precision, curr_pos, out);
+    }
+    write_flat_padding(curr_pos, header[FlatTotalSize], out);
+}
+
+size_t determine_flat_model_size(const IsoForest *model, const ExtIsoForest *model_ext, bool single_precision)
+{
+    check_flat_model_input(model, model_ext);
+    uint64_t header[FLAT_HEADER_WORDS];
+    build_flat_header(model, model_ext, single_precision, header);
+    return header[FlatTotalSize];
+}
+
+void serialize_flat_model(const IsoForest *model, const ExtIsoForest *model_ext, bool single_precision, char *out)
+{
+    serialize_flat_model_internal(model, model_ext, single_precision, out);
+}
+
+void serialize_flat_model_ToFile(const IsoForest *model, const ExtIsoForest *model_ext, bool single_precision,
+                                 const char *fname)
+{
+    FileHandle f(fname, "wb");
+    serialize_flat_model_internal(model, model_ext, single_precision, f.handle);
+}
+
+template <class idx_t, class val_t>
+static void set_flat_arrays(FlatModelArrays<idx_t, val_t> &arrays, const char *sections[NumFlatSections]) noexcept
+{
+    arrays.tree_offsets = (const idx_t*)sections[SecTreeOffsets];
+    arrays.tree_left = (const idx_t*)sections[SecTreeLeft];
+    arrays.tree_right = (const idx_t*)sections[SecTreeRight];
+    arrays.split = (const val_t*)sections[SecSplit];
+    arrays.score = (const val_t*)sections[SecScore];
+    arrays.range_low = (const val_t*)sections[SecRangeLow];
+    arrays.range_high = (const val_t*)sections[SecRangeHigh];
+    arrays.pct_tree_left = (const val_t*)sections[SecPctTreeLeft];
+    arrays.col_num = (const idx_t*)sections[SecColNum];
+    arrays.coef_offsets = (const idx_t*)sections[SecCoefOffsets];
+    arrays.coef_col = (const idx_t*)sections[SecCoefCol];
+    arrays.coef = (const val_t*)sections[SecCoef];
+    arrays.mean = (const val_t*)sections[SecMean];
+    arrays.fill_val = (const val_t*)sections[SecFillVal];
+}
+
+void load_flat_model(FlatModel &model, const char *in, size_t n_bytes)
+{
+    if ((uintptr_t)in % sizeof(uint64_t))
+        throw std::runtime_error("Flat model bytes must be aligned to 8 bytes.\n");
+    if (n_bytes < FLAT_HEADER_WORDS * sizeof(uint64_t) || memcmp(in, flat_watermark, SIZE_FLAT_WATERMARK))
+        throw std::runtime_error("Error: input is not an isotree model in flat format.\n");
+
+    const uint64_t *header = (const uint64_t*)in;
+    if (header[FlatByteOrder] != FLAT_BYTE_ORDER_MARK)
+        throw std::runtime_error("Error: flat model was saved in a machine with different endianness.\n");
+    if (header[FlatVersion] != FLAT_FORMAT_VERSION)
+        throw std::runtime_error("Error: flat model was produced with an incompatible version of the library.\n");
+    if (header[FlatTotalSize] > n_bytes)
+        throw std::runtime_error("Error: flat model is incomplete.\n");
+    if (header[FlatModelType] != FlatSingleVarModel && header[FlatModelType] != FlatExtModel)
+        throw std::runtime_error("Error: flat model is corrupted.\n");
+
+    const bool is_extended = header[FlatModelType] == FlatExtModel;
+    const bool single_precision = (bool)header[FlatSinglePrecision];
+    const size_t elem_size = single_precision? sizeof(uint32_t) : sizeof(uint64_t);
+    const size_t ntrees = header[FlatNTrees];
+    const size_t nnodes = header[FlatNNodes];
+    const size_t ncoef = header[FlatNCoef];
+    /* counts that could not fit in the file would otherwise wrap around in the section lengths */
+    const size_t max_elems = n_bytes / elem_size;
+    if (ntrees >= max_elems || nnodes >= max_elems || ncoef >= max_elems)
+        throw std::runtime_error("Error: flat model is corrupted.\n");
+    const char *sections[NumFlatSections];
+    for (int section = 0; section < NumFlatSections; section++)
+    {
+        size_t offset = header[FlatSectionsStart + section];
+        size_t length = get_flat_section_length((FlatSection)section, is_extended, ntrees, nnodes, ncoef);
+        if (offset % FLAT_ALIGNMENT || offset > n_bytes || length > (n_bytes - offset) / elem_size)
+            throw std::runtime_error("Error: flat model is corrupted.\n");
+        sections[section] = length? (in + offset) : (const char*)NULL;
+    }
+    if (sections[SecTreeOffsets] == NULL)
+        throw std::runtime_error("Error: flat model is corrupted.\n");
+    size_t last_offset = single_precision? ((const uint32_t*)sections[SecTreeOffsets])[ntrees]
+                                         : ((const uint64_t*)sections[SecTreeOffsets])[ntrees];
+    if (last_offset != nnodes)
+        throw std::runtime_error("Error: flat model is corrupted.\n");
+
+    model.is_extended = is_extended;
+    model.single_precision = single_precision;
+    model.missing_action = (MissingAction)header[FlatMissingAction];
+    model.new_cat_action = (NewCategAction)header[FlatNewCatAction];
+    model.cat_split_type = (CategSplit)header[FlatCatSplitType];
+    model.scoring_metric = (ScoringMetric)header[FlatScoringMetric];
+    model.has_range_penalty = (bool)header[FlatHasRangePenalty];
+    memcpy(&model.exp_avg_depth, &header[FlatExpAvgDepth], sizeof(double));
+    memcpy(&model.exp_avg_sep, &header[FlatExpAvgSep], sizeof(double));
+    model.orig_sample_size = header[FlatOrigSampleSize];
+    model.ntrees = ntrees;
+    model.nnodes = nnodes;
+    model.ncols_numeric = header[FlatNColsNumeric];
+    model.arrays = FlatModelArrays<uint64_t, double>();
+    model.arrays_f = FlatModelArrays<uint32_t, float>();
+    if (!single_precision)
+        set_flat_arrays(model.arrays, sections);
+    else
+        set_flat_arrays(model.arrays_f, sections);
+    model.mapped_file.reset();
+}
+
+/* Note: when memory-mapping is not available, the file is read into an aligned buffer instead */
+void load_flat_model_FromFile(FlatModel &model, const char *fname)
+{
+    std::shared_ptr<void> mapping;
+    const char *bytes;
+    size_t n_bytes;
+
+    #if defined(HAS_POSIX_MMAP)
+    int fd = open(fname, O_RDONLY);
+    if (fd == -1) throw_errno();
+    struct stat file_info;
+    if (fstat(fd, &file_info) == -1) {
+        close(fd);
+        throw_errno();
+    }
+    n_bytes = (size_t)file_info.st_size;
+    if (!n_bytes) {
+        close(fd);
+        throw std::runtime_error("Error: input is not an isotree model in flat format.\n");
+    }
+    void *mapped = mmap(NULL, n_bytes, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) throw_errno();
+    mapping = std::shared_ptr<void>(mapped, [n_bytes](void *ptr){munmap(ptr, n_bytes);});
+    bytes = (const char*)mapped;
+
+    #elif defined(HAS_WINDOWS_MMAP)
+    HANDLE file = CreateFileA(fname, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("Error " + std::to_string(GetLastError()) + " opening file.\n");
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || !file_size.QuadPart) {
+        CloseHandle(file);
+        throw std::runtime_error("Error: input is not an isotree model in flat format.\n");
+    }
+    n_bytes = (size_t)file_size.QuadPart;
+    HANDLE file_mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (file_mapping == NULL)
+        throw std::runtime_error("Error " + std::to_string(GetLastError()) + " mapping file.\n");
+    void *mapped = MapViewOfFile(file_mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(file_mapping);
+    if (mapped == NULL)
+        throw std::runtime_error("Error " + std::to_string(GetLastError()) + " mapping file.\n");
+    mapping = std::shared_ptr<void>(mapped, [](void *ptr){UnmapViewOfFile(ptr);});
+    bytes = (const char*)mapped;
+
+    #else
+    FileHandle f(fname, "rb");
+    if (std::fseek(f.handle, 0, SEEK_END)) throw_ferror(f.handle);
+    n_bytes = (size_t)std::ftell(f.handle);
+    if (std::fseek(f.handle, 0, SEEK_SET)) throw_ferror(f.handle);
+    std::shared_ptr<uint64_t> buffer(new uint64_t[n_bytes / sizeof(uint64_t) + 1], std::default_delete<uint64_t[]>());
+    if (fread(buffer.get(), 1, n_bytes, f.handle) != n_bytes) throw_ferror(f.handle);
+    mapping = buffer;
+    bytes = (const char*)buffer.get();
+    #endif
+
+    load_flat_model(model, bytes, n_bytes);
+    model.mapped_file = mapping;
+}
@@ -151,14 +151,14 @@ std::vector<std::string> generate_dot(const IsoForest *model_outputs,
     SignalSwitcher ss = SignalSwitcher();
 
     /* For exception handling */
-    bool threw_exception = false;
+    std::atomic<bool> threw_exception(false);
     std::exception_ptr ex = NULL;
 
-    #pragma omp parallel for schedule(static) num_threads(nthreads) shared(out, index1, tree_num, threw_exception, ex)
-    for (size_t_for ix = 0; ix < (size_t_for)ntrees; ix++)
+    auto export_tree = [&](size_t ix, int thread_id)
     {
+        (void)thread_id;
         if (interrupt_switch || threw_exception)
-            continue; /* Cannot break with OpenMP==2.0 (MSVC) */
+            return;
 
         try
         {
@@ -175,16 +175,10 @@ std::vector<std::string> generate_dot(const IsoForest *model_outputs,
 
         catch (...)
         {
-            #pragma omp critical
-            {
-                if (!threw_exception)
-                {
-                    threw_exception = true;
-                    ex = std::current_exception();
-                }
-            }
+            catch_task_exception(threw_exception, ex);
         }
-    }
+    };
+    run_parallel_for(get_thread_executor(), ntrees, nthreads, false, export_tree);
 
     /* check if the procedure got interrupted */
     check_interrupt_switch(ss);
@@ -753,14 +747,14 @@ std::vector<std::string> generate_json(const IsoForest *model_outputs,
     SignalSwitcher ss = SignalSwitcher();
 
     /* For exception handling */
-    bool threw_exception = false;
+    std::atomic<bool> threw_exception(false);
     std::exception_ptr ex = NULL;
 
-    #pragma omp parallel for schedule(static) num_threads(nthreads) shared(out, index1, tree_num, threw_exception, ex)
-    for (size_t_for ix = 0; ix < (size_t_for)ntrees; ix++)
+    auto export_tree = [&](size_t ix, int thread_id)
     {
+        (void)thread_id;
         if (interrupt_switch || threw_exception)
-            continue; /* Cannot break with OpenMP==2.0 (MSVC) */
+            return;
 
         try
         {
@@ -777,16 +771,10 @@ std::vector<std::string> generate_json(const IsoForest *model_outputs,
 
         catch (...)
         {
-            #pragma omp critical
-            {
-                if (!threw_exception)
-                {
-                    threw_exception = true;
-                    ex = std::current_exception();
-                }
-            }
+            catch_task_exception(threw_exception, ex);
         }
-    }
+    };
+    run_parallel_for(get_thread_executor(), ntrees, nthreads, false, export_tree);
 
     /* check if the procedure got interrupted */
     check_interrupt_switch(ss);
@@ -71,6 +71,15 @@
 #include "isoforest.hpp"
 #include "mult.hpp"
 #include "predict.hpp"
+#include "predict_binned.hpp"
+#include "predict_bitvector.hpp"
+#include "predict_blocked.hpp"
+#include "predict_compiled.hpp"
+#include "predict_csr.hpp"
+#include "predict_decision.hpp"
+#include "predict_flat.hpp"
+#include "predict_row.hpp"
+#include "predict_view.hpp"
 #include "ref_indexer.hpp"
 #include "utils.hpp"
 
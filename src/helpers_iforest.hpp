@@ -234,9 +234,12 @@ void remap_terminal_trees(IsoForest *model_outputs, ExtIsoForest *model_outputs_
                 if (model_outputs->trees[tree][node].tree_left == 0)
                     tree_mapping[node] = curr_term++;
 
-            #pragma omp parallel for schedule(static) num_threads(nthreads) shared(tree_num, tree_mapping, tree, prediction_data)
-            for (size_t_for row = 0; row < (decltype(row))prediction_data.nrows; row++)
+            auto remap_row = [&](size_t row, int thread_id)
+            {
+                (void)thread_id;
                 tree_num[row + tree * prediction_data.nrows] = tree_mapping[tree_num[row + tree * prediction_data.nrows]];
+            };
+            run_parallel_for(get_thread_executor(), prediction_data.nrows, nthreads, false, remap_row);
         }
     }
 
@@ -256,94 +259,130 @@ void remap_terminal_trees(IsoForest *model_outputs, ExtIsoForest *model_outputs_
                 if (model_outputs_ext->hplanes[tree][node].hplane_left == 0)
                     tree_mapping[node] = curr_term++;
             
-            #pragma omp parallel for schedule(static) num_threads(nthreads) shared(tree_num, tree_mapping, tree, prediction_data)
-            for (size_t_for row = 0; row < (decltype(row))prediction_data.nrows; row++)
+            auto remap_row = [&](size_t row, int thread_id)
+            {
+                (void)thread_id;
                 tree_num[row + tree * prediction_data.nrows] = tree_mapping[tree_num[row + tree * prediction_data.nrows]];
+            };
+            run_parallel_for(get_thread_executor(), prediction_data.nrows, nthreads, false, remap_row);
         }
     }
 }
 
 
 template <class WorkerMemory>
-RecursionState::RecursionState(WorkerMemory &workspace, bool full_state)
+void RecursionArena::push_state(WorkerMemory &workspace, bool full_state)
 {
-    this->full_state = full_state;
-
-    this->split_ix         =  workspace.split_ix;
-    this->end              =  workspace.end;
+    RecursionState state;
+    state.full_state = full_state;
+    state.ix_arr_offset = this->buffer_szt.size();
+    state.ix_arr_size = 0;
+    state.col_weights_offset = this->buffer_dbl.size();
+    state.weights_offset = this->buffer_dbl.size();
+
+    state.split_ix         =  workspace.split_ix;
+    state.end              =  workspace.end;
+    state.presorted_valid  =  workspace.presorted_valid;
     if (!workspace.col_sampler.has_weights())
-        this->sampler_pos  =  workspace.col_sampler.curr_pos;
+        state.sampler_pos  =  workspace.col_sampler.curr_pos;
     else {
-        this->col_sampler_weights = workspace.col_sampler.tree_weights;
-        this->n_dropped           = workspace.col_sampler.n_dropped;
+        this->buffer_dbl.insert(this->buffer_dbl.end(),
+                                workspace.col_sampler.tree_weights.begin(),
+                                workspace.col_sampler.tree_weights.end());
+        state.weights_offset = this->buffer_dbl.size();
+        state.n_dropped    =  workspace.col_sampler.n_dropped;
     }
 
-    if (this->full_state)
+    if (state.full_state)
     {
-        this->st           = workspace.st;
-        this->st_NA        = workspace.st_NA;
-        this->end_NA       = workspace.end_NA;
+        state.st           = workspace.st;
+        state.st_NA        = workspace.st_NA;
+        state.end_NA       = workspace.end_NA;
 
-        this->changed_weights = workspace.changed_weights;
+        state.changed_weights = workspace.changed_weights;
 
         /* for the extended model, it's not necessary to copy everything */
         if (workspace.comb_val.empty() && workspace.st_NA < workspace.end_NA)
         {
-            this->ix_arr = std::vector<size_t>(workspace.ix_arr.begin() + workspace.st_NA,
-                                               workspace.ix_arr.begin() + workspace.end_NA);
-            if (this->changed_weights)
+            state.ix_arr_size = workspace.end_NA - workspace.st_NA;
+            this->buffer_szt.insert(this->buffer_szt.end(),
+                                    workspace.ix_arr.begin() + workspace.st_NA,
+                                    workspace.ix_arr.begin() + workspace.end_NA);
+            if (state.changed_weights)
             {
-                size_t tot = workspace.end_NA - workspace.st_NA;
-                this->weights_arr = std::unique_ptr<double[]>(new double[tot]);
                 if (!workspace.weights_arr.empty())
-                    for (size_t ix = 0; ix < tot; ix++)
-                        this->weights_arr[ix] = workspace.weights_arr[workspace.ix_arr[ix + workspace.st_NA]];
+                    for (size_t ix = workspace.st_NA; ix < workspace.end_NA; ix++)
+                        this->buffer_dbl.push_back(workspace.weights_arr[workspace.ix_arr[ix]]);
                 else
-                    for (size_t ix = 0; ix < tot; ix++)
-                        this->weights_arr[ix] = workspace.weights_map[workspace.ix_arr[ix + workspace.st_NA]];
+                    for (size_t ix = workspace.st_NA; ix < workspace.end_NA; ix++)
+                        this->buffer_dbl.push_back(workspace.weights_map[workspace.ix_arr[ix]]);
             }
         }
     }
+
+    this->states.push_back(state);
 }
 
 
 template <class WorkerMemory>
-void RecursionState::restore_state(WorkerMemory &workspace)
+void RecursionArena::pop_state(WorkerMemory &workspace)
 {
-    workspace.split_ix         =  this->split_ix;
-    workspace.end              =  this->end;
+    const RecursionState &state = this->states.back();
+
+    workspace.split_ix         =  state.split_ix;
+    workspace.end              =  state.end;
+    workspace.presorted_valid  =  state.presorted_valid;
     if (!workspace.col_sampler.has_weights())
-        workspace.col_sampler.curr_pos = this->sampler_pos;
+        workspace.col_sampler.curr_pos = state.sampler_pos;
     else  {
-        workspace.col_sampler.tree_weights  =  std::move(this->col_sampler_weights);
-        workspace.col_sampler.n_dropped     =  this->n_dropped;
+        std::copy(this->buffer_dbl.begin() + state.col_weights_offset,
+                  this->buffer_dbl.begin() + state.weights_offset,
+                  workspace.col_sampler.tree_weights.begin());
+        workspace.col_sampler.n_dropped     =  state.n_dropped;
     }
 
-    if (this->full_state)
+    if (state.full_state)
     {
-        workspace.st         =  this->st;
-        workspace.st_NA      =  this->st_NA;
-        workspace.end_NA     =  this->end_NA;
+        workspace.st         =  state.st;
+        workspace.st_NA      =  state.st_NA;
+        workspace.end_NA     =  state.end_NA;
 
-        workspace.changed_weights = this->changed_weights;
+        workspace.changed_weights = state.changed_weights;
 
-        if (workspace.comb_val.empty() && !this->ix_arr.empty())
+        if (workspace.comb_val.empty() && state.ix_arr_size)
         {
-            std::copy(this->ix_arr.begin(),
-                      this->ix_arr.end(),
-                      workspace.ix_arr.begin() + this->st_NA);
-            if (this->changed_weights)
+            std::copy(this->buffer_szt.begin() + state.ix_arr_offset,
+                      this->buffer_szt.begin() + state.ix_arr_offset + state.ix_arr_size,
+                      workspace.ix_arr.begin() + state.st_NA);
+            if (state.changed_weights)
             {
-                size_t tot = workspace.end_NA - workspace.st_NA;
+                const double *weights = this->buffer_dbl.data() + state.weights_offset;
                 if (!workspace.weights_arr.empty())
-                    for (size_t ix = 0; ix < tot; ix++)
-                        workspace.weights_arr[workspace.ix_arr[ix + workspace.st_NA]] = this->weights_arr[ix];
+                    for (size_t ix = 0; ix < state.ix_arr_size; ix++)
+                        workspace.weights_arr[workspace.ix_arr[ix + workspace.st_NA]] = weights[ix];
                 else
-                    for (size_t ix = 0; ix < tot; ix++)
-                        workspace.weights_map[workspace.ix_arr[ix + workspace.st_NA]] = this->weights_arr[ix];
+                    for (size_t ix = 0; ix < state.ix_arr_size; ix++)
+                        workspace.weights_map[workspace.ix_arr[ix + workspace.st_NA]] = weights[ix];
             }
         }
     }
+
+    this->buffer_szt.resize(state.ix_arr_offset);
+    this->buffer_dbl.resize(state.col_weights_offset);
+    this->states.pop_back();
+}
+
+template <class ldouble_safe>
+void SplitScratch<ldouble_safe>::initialize(size_t sample_size, size_t ncols_numeric, int max_categ)
+{
+    if (this->buffer_ix.size() < sample_size)
+        this->buffer_ix.resize(sample_size);
+    if (this->buffer_x.size() < sample_size + (size_t)2 * ncols_numeric)
+        this->buffer_x.resize(sample_size + (size_t)2 * ncols_numeric);
+    if (this->buffer_w.size() < sample_size)
+        this->buffer_w.resize(sample_size);
+    if (this->buffer_cnt.size() < (size_t)max_categ + 1)
+        this->buffer_cnt.resize((size_t)max_categ + 1);
 }
 
 template <class InputData, class ldouble_safe>
@@ -351,14 +390,21 @@ std::vector<double> calc_kurtosis_all_data(InputData &input_data, ModelParams &m
 {
     std::unique_ptr<double[]> buffer_double;
     std::unique_ptr<size_t[]> buffer_size_t;
+    std::unique_ptr<ldouble_safe[]> buffer_ldbl;
     if (input_data.ncols_categ)
     {
         buffer_double = std::unique_ptr<double[]>(new double[input_data.max_categ]);
         if (!(input_data.sample_weights != NULL && !input_data.weight_as_sample))
             buffer_size_t = std::unique_ptr<size_t[]>(new size_t[input_data.max_categ + 1]);
+        else
+            buffer_ldbl = std::unique_ptr<ldouble_safe[]>(new ldouble_safe[input_data.max_categ + 1]);
     }
 
 
+    /* dense data here might also be in row-major order or have a larger leading dimension */
+    std::vector<typename std::remove_pointer<decltype(input_data.numeric_data)>::type> buffer_numeric;
+    std::vector<int> buffer_categ;
+
     std::vector<double> kurt_weights(input_data.ncols_numeric + input_data.ncols_categ);
     for (size_t col = 0; col < input_data.ncols_tot; col++)
     {
@@ -370,7 +416,8 @@ std::vector<double> calc_kurtosis_all_data(InputData &input_data, ModelParams &m
                 {
                     kurt_weights[col]
                         = calc_kurtosis<typename std::remove_pointer<decltype(input_data.numeric_data)>::type, ldouble_safe>(
-                                        input_data.numeric_data + col * input_data.nrows,
+                                        get_strided_column(input_data.numeric_data, input_data.is_col_major,
+                                                           input_data.ld_numeric, input_data.nrows, col, buffer_numeric),
                                         input_data.nrows, model_params.missing_action);
                 }
 
@@ -379,7 +426,9 @@ std::vector<double> calc_kurtosis_all_data(InputData &input_data, ModelParams &m
                     kurt_weights[col]
                         = calc_kurtosis_weighted<typename std::remove_pointer<decltype(input_data.numeric_data)>::type,
                                                  ldouble_safe>(
-                                                 input_data.numeric_data + col * input_data.nrows, input_data.nrows,
+                                                 get_strided_column(input_data.numeric_data, input_data.is_col_major,
+                                                                    input_data.ld_numeric, input_data.nrows, col, buffer_numeric),
+                                                 input_data.nrows,
                                                  model_params.missing_action, input_data.sample_weights);
                 }
             }
@@ -416,7 +465,9 @@ std::vector<double> calc_kurtosis_all_data(InputData &input_data, ModelParams &m
             {
                 kurt_weights[col]
                         = calc_kurtosis<ldouble_safe>(input_data.nrows,
-                                        input_data.categ_data + (col- input_data.ncols_numeric) * input_data.nrows,
+                                        get_strided_column(input_data.categ_data, input_data.is_col_major,
+                                                           input_data.ld_categ, input_data.nrows,
+                                                           col - input_data.ncols_numeric, buffer_categ),
                                         input_data.ncat[col - input_data.ncols_numeric],
                                         buffer_size_t.get(), buffer_double.get(),
                                         model_params.missing_action, model_params.cat_split_type, rnd_generator);
@@ -428,9 +479,11 @@ std::vector<double> calc_kurtosis_all_data(InputData &input_data, ModelParams &m
                         = calc_kurtosis_weighted<typename std::remove_pointer<decltype(input_data.sample_weights)>::type,
                                                  ldouble_safe>(
                                                  input_data.nrows,
-                                                 input_data.categ_data + (col- input_data.ncols_numeric) * input_data.nrows,
+                                                 get_strided_column(input_data.categ_data, input_data.is_col_major,
+                                                                    input_data.ld_categ, input_data.nrows,
+                                                                    col - input_data.ncols_numeric, buffer_categ),
                                                  input_data.ncat[col - input_data.ncols_numeric],
-                                                 buffer_double.get(),
+                                                 buffer_double.get(), buffer_ldbl.get(),
                                                  model_params.missing_action, model_params.cat_split_type,
                                                  rnd_generator, input_data.sample_weights);
             }
@@ -775,7 +828,7 @@ void calc_kurt_all_cols(InputData &input_data, WorkerMemory &workspace, ModelPar
                                            workspace.ix_arr.data(), workspace.st, workspace.end,
                                            input_data.categ_data + col * input_data.nrows,
                                            input_data.ncat[col],
-                                           workspace.buffer_dbl.data(),
+                                           workspace.buffer_dbl.data(), workspace.split_scratch.buffer_cnt.data(),
                                            model_params.missing_action, model_params.cat_split_type,
                                            workspace.rnd_generator, workspace.weights_arr);
             }
@@ -787,7 +840,7 @@ void calc_kurt_all_cols(InputData &input_data, WorkerMemory &workspace, ModelPar
                                            workspace.ix_arr.data(), workspace.st, workspace.end,
                                            input_data.categ_data + col * input_data.nrows,
                                            input_data.ncat[col],
-                                           workspace.buffer_dbl.data(),
+                                           workspace.buffer_dbl.data(), workspace.split_scratch.buffer_cnt.data(),
                                            model_params.missing_action, model_params.cat_split_type,
                                            workspace.rnd_generator, workspace.weights_map);
             }
@@ -806,6 +859,412 @@ void calc_kurt_all_cols(InputData &input_data, WorkerMemory &workspace, ModelPar
     }
 }
 
+/* Evaluates a guided split on a dense numeric column through the histograms of its pre-computed bins.
+   Returns 'false' when the split should be searched by sorting the values instead, which is the case for
+   small nodes, for the full-gain criterion, for columns without bins, and for missing values that would
+   need to be imputed. If the parent of the node evaluated the same column and the other branch has fewer
+   rows, the histogram is obtained by building that of the other branch and subtracting it from the parent's,
+   as long as the exact range of the node is not needed afterwards. */
+template <class InputData, class WorkerMemory, class ldouble_safe>
+bool eval_guided_crit_hist(WorkerMemory &workspace, InputData &input_data, ModelParams &model_params,
+                           size_t col_num, size_t curr_depth, bool as_relative_gain, double &restrict split_point)
+{
+    if (input_data.X_binned == NULL || workspace.criterion == FullGain || workspace.criterion == NoCrit)
+        return false;
+    size_t n = workspace.end - workspace.st + 1;
+    int nbins = input_data.col_bins->nbins[col_num];
+    if (n < HIST_MIN_ROWS || nbins < 2)
+        return false;
+
+    HistLevel &level = workspace.hist_levels[curr_depth];
+    auto found = std::find(level.cols.begin(), level.cols.end(), col_num);
+    HistBin *restrict hist;
+    const double *restrict bin_ref = input_data.col_bins->bin_ref.data() + col_num * HIST_MAX_BINS;
+    if (found != level.cols.end())
+    {
+        hist = level.hists.data() + std::distance(level.cols.begin(), found) * (HIST_MAX_BINS + 1);
+    }
+
+    else
+    {
+        level.cols.push_back(col_num);
+        level.hists.resize(level.cols.size() * (HIST_MAX_BINS + 1));
+        hist = level.hists.data() + (level.cols.size() - 1) * (HIST_MAX_BINS + 1);
+
+        /* the rows of the other branch are those from the parent that are not in this node */
+        size_t st = workspace.st;
+        size_t end = workspace.end;
+        const HistBin *restrict parent_hist = NULL;
+        if (
+            curr_depth > 0 && workspace.hist_levels[curr_depth-1].can_subtract &&
+            !model_params.penalize_range && model_params.scoring_metric == Depth &&
+            workspace.criterion != DensityCrit
+        ) {
+            HistLevel &parent = workspace.hist_levels[curr_depth-1];
+            auto found_parent = std::find(parent.cols.begin(), parent.cols.end(), col_num);
+            if (
+                found_parent != parent.cols.end() &&
+                workspace.st >= parent.st && workspace.end <= parent.end &&
+                (workspace.st == parent.st || workspace.end == parent.end) &&
+                (parent.end - parent.st + 1) - n < n
+            ) {
+                parent_hist = parent.hists.data() + std::distance(parent.cols.begin(), found_parent) * (HIST_MAX_BINS + 1);
+                if (workspace.st == parent.st) {
+                    st = workspace.end + 1;
+                    end = parent.end;
+                }
+                else {
+                    st = parent.st;
+                    end = workspace.st - 1;
+                }
+            }
+        }
+
+        auto *restrict x = input_data.numeric_data + col_num * input_data.nrows;
+        const uint8_t *restrict x_binned = input_data.X_binned + col_num * input_data.nrows;
+        if (!workspace.changed_weights)
+            build_histogram(workspace.ix_arr.data(), st, end, x, x_binned, bin_ref, hist);
+        else if (!workspace.weights_arr.empty())
+            build_histogram_weighted(workspace.ix_arr.data(), st, end, x, x_binned, bin_ref, hist, workspace.weights_arr);
+        else
+            build_histogram_weighted(workspace.ix_arr.data(), st, end, x, x_binned, bin_ref, hist, workspace.weights_map);
+
+        if (parent_hist != NULL)
+            subtract_histogram(parent_hist, hist);
+    }
+
+    /* values inside a single bin might still be splittable, which is left to the sorted search,
+       and so is the case in which no split between bins is valid */
+    if (hist[HIST_NA_BIN].cnt && model_params.missing_action != Divide)
+        return false;
+    int n_nonempty = 0;
+    for (int bin = 0; bin < nbins && n_nonempty < 2; bin++)
+        n_nonempty += hist[bin].cnt > 0;
+    if (n_nonempty < 2)
+        return false;
+
+    double gain = find_split_hist<ldouble_safe>(hist, bin_ref, nbins, n - hist[HIST_NA_BIN].cnt,
+                                                workspace.buffer_dbl.data(),
+                                                workspace.criterion, model_params.min_gain, as_relative_gain,
+                                                split_point, workspace.xmin, workspace.xmax);
+    if (gain <= -HUGE_VAL)
+        return false;
+    workspace.this_gain = std::fmax(0., gain);
+    return true;
+}
+
+/* Sorts row indices by the values of a column, placing the missing values first */
+template <class real_t>
+void presort_column(size_t *restrict ix_arr, size_t n, const real_t *restrict x)
+{
+    size_t *st_non_na = std::partition(ix_arr, ix_arr + n, [&x](const size_t row){return is_na_or_inf(x[row]);});
+    std::sort(st_non_na, ix_arr + n, [&x](const size_t a, const size_t b){return x[a] < x[b];});
+}
+
+/* Sets up the rows in the sample of a tree sorted by each numeric column, for finding guided splits with
+   presorted indices. When the tree takes all of the rows, these are copied from the indices that were sorted
+   for the whole model, otherwise the rows in the sample are sorted here. */
+template <class InputData, class WorkerMemory>
+void initialize_presorted(WorkerMemory &workspace, InputData &input_data)
+{
+    size_t n = workspace.ix_arr.size();
+    workspace.presorted_ix.resize(n * input_data.ncols_numeric);
+    workspace.presorted_buffer.resize(n);
+    workspace.presorted_side.resize(input_data.nrows);
+
+    if (input_data.presorted_ix != NULL)
+    {
+        std::copy(input_data.presorted_ix, input_data.presorted_ix + n * input_data.ncols_numeric,
+                  workspace.presorted_ix.begin());
+    }
+
+    else
+    {
+        for (size_t col = 0; col < input_data.ncols_numeric; col++)
+        {
+            size_t *restrict sorted = workspace.presorted_ix.data() + col*n;
+            std::copy(workspace.ix_arr.begin(), workspace.ix_arr.end(), sorted);
+            presort_column(sorted, n, input_data.numeric_data + col*input_data.nrows);
+        }
+    }
+
+    workspace.presorted_valid = true;
+}
+
+/* Puts the rows of the current node in the order in which they are sorted by a numeric column,
+   if the presorted indices are being kept for it. Returns whether they were put in that order. */
+template <class WorkerMemory>
+bool take_presorted_order(WorkerMemory &workspace, size_t col_num)
+{
+    if (!workspace.presorted_valid)
+        return false;
+    const size_t *restrict sorted = workspace.presorted_ix.data() + col_num * workspace.ix_arr.size();
+    std::copy(sorted + workspace.st, sorted + workspace.end + 1, workspace.ix_arr.begin() + workspace.st);
+    return true;
+}
+
+/* After a node spanning up to 'end' is split, with its left branch spanning up to 'workspace.end', moves
+   the presorted indices of each column that went to the left branch in front of the ones that went to the
+   right branch, keeping their relative order, so that each branch finds its rows sorted in the same
+   positions as in 'ix_arr'. */
+template <class WorkerMemory>
+void partition_presorted(WorkerMemory &workspace, size_t ncols_numeric, size_t end)
+{
+    if (!workspace.presorted_valid)
+        return;
+
+    char *restrict goes_right = workspace.presorted_side.data();
+    for (size_t ix = workspace.st; ix <= workspace.end; ix++)
+        goes_right[workspace.ix_arr[ix]] = false;
+    for (size_t ix = workspace.end + 1; ix <= end; ix++)
+        goes_right[workspace.ix_arr[ix]] = true;
+
+    size_t n = workspace.ix_arr.size();
+    size_t *restrict buffer = workspace.presorted_buffer.data();
+    for (size_t col = 0; col < ncols_numeric; col++)
+    {
+        size_t *restrict sorted = workspace.presorted_ix.data() + col*n;
+        size_t pos_left = workspace.st;
+        size_t n_right = 0;
+        for (size_t ix = workspace.st; ix <= end; ix++)
+        {
+            if (goes_right[sorted[ix]])
+                buffer[n_right++] = sorted[ix];
+            else
+                sorted[pos_left++] = sorted[ix];
+        }
+        std::copy(buffer, buffer + n_right, sorted + pos_left);
+    }
+}
+
+/* Makes a branch of a node with more than 'NODE_TASK_MIN_ROWS' rows draw its random numbers from 'seed', and
+   keeps it from subtracting histograms from those of the node, which a separate task would not have */
+template <class WorkerMemory>
+void start_fork_branch(WorkerMemory &workspace, uint64_t seed)
+{
+    workspace.rnd_generator.seed(seed);
+    workspace.rbin = UniformUnitInterval(0, 1);
+    workspace.coef_unif = UniformMinusOneToOne(-1, 1);
+    workspace.coef_norm = StandardNormalDistr(0, 1);
+    for (HistLevel &level : workspace.hist_levels)
+        level.can_subtract = false;
+}
+
+/* To be called right after splitting a node with more than 'NODE_TASK_MIN_ROWS' rows, whether or not
+   its branches are grown as tasks: draws the seeds for its branches, saves the state that its right
+   branch starts from, and sets up the left branch */
+template <class WorkerMemory>
+void fork_node(WorkerMemory &workspace)
+{
+    uint64_t seed_left = (uint64_t)workspace.rnd_generator();
+    uint64_t seed_right = (uint64_t)workspace.rnd_generator();
+    workspace.fork_states.emplace_back();
+    auto &state = workspace.fork_states.back();
+    state.seed_right = seed_right;
+    state.try_all = workspace.try_all;
+    state.col_sampler = workspace.col_sampler;
+    state.density_calculator = workspace.density_calculator;
+    start_fork_branch(workspace, seed_left);
+}
+
+/* To be called before setting up the right branch of the last node passed to 'fork_node' */
+template <class WorkerMemory>
+void resume_fork_right(WorkerMemory &workspace)
+{
+    auto &state = workspace.fork_states.back();
+    workspace.try_all = state.try_all;
+    workspace.col_sampler = std::move(state.col_sampler);
+    workspace.density_calculator = std::move(state.density_calculator);
+    start_fork_branch(workspace, state.seed_right);
+    workspace.fork_states.pop_back();
+}
+
+/* Saves what is needed for growing the node that the workspace is currently set up for as a separate
+   task, which starts from the first 'n_chain' imputation nodes (the ones from its ancestors) */
+template <class InputData, class WorkerMemory>
+void capture_node_task(NodeTask<WorkerMemory> &task, WorkerMemory &workspace, InputData &input_data,
+                       std::vector<ImputeNode> *impute_nodes, size_t n_chain, size_t depth)
+{
+    task.depth = depth;
+    task.st = workspace.st;
+    task.nrows = workspace.end - workspace.st + 1;
+    task.ix_arr.assign(workspace.ix_arr.begin() + workspace.st, workspace.ix_arr.begin() + workspace.end + 1);
+
+    task.changed_weights = workspace.changed_weights;
+    task.weights_in_map = workspace.weights_arr.empty();
+    if (task.changed_weights)
+    {
+        task.weights.resize(task.nrows);
+        if (!task.weights_in_map)
+            for (size_t row = 0; row < task.nrows; row++)
+                task.weights[row] = workspace.weights_arr[task.ix_arr[row]];
+        else
+            for (size_t row = 0; row < task.nrows; row++)
+                task.weights[row] = workspace.weights_map[task.ix_arr[row]];
+    }
+
+    task.try_all = workspace.try_all;
+    task.presorted_valid = workspace.presorted_valid;
+    if (task.presorted_valid)
+    {
+        size_t n = workspace.ix_arr.size();
+        task.presorted_ix.resize(task.nrows * input_data.ncols_numeric);
+        for (size_t col = 0; col < input_data.ncols_numeric; col++)
+            std::copy(workspace.presorted_ix.begin() + col*n + workspace.st,
+                      workspace.presorted_ix.begin() + col*n + workspace.end + 1,
+                      task.presorted_ix.begin() + col*task.nrows);
+    }
+
+    task.col_sampler = workspace.col_sampler;
+    task.density_calculator = workspace.density_calculator;
+    task.rnd_generator = workspace.rnd_generator;
+    task.rbin = workspace.rbin;
+    task.coef_unif = workspace.coef_unif;
+    task.coef_norm = workspace.coef_norm;
+
+    task.n_chain = n_chain;
+    if (impute_nodes != NULL)
+        task.impute_chain.assign(impute_nodes->begin(), impute_nodes->begin() + n_chain);
+}
+
+/* Sets up the workspace for growing the node of a task, leaving the rows in the same positions of 'ix_arr'
+   that they had in the workspace from which the task was saved, and the random number generator in the state
+   that it had there. Tasks other than the root of a tree start at the branches of nodes that went through
+   'fork_node', so this is the same state that growing the tree in a single thread would have at that node. */
+template <class InputData, class WorkerMemory>
+void restore_node_task(NodeTask<WorkerMemory> &task, NodeTaskTree<WorkerMemory, InputData> &task_tree,
+                       WorkerMemory &workspace, InputData &input_data, ModelParams &model_params)
+{
+    if (workspace.ix_arr.size() != model_params.sample_size)
+        workspace.ix_arr.resize(model_params.sample_size);
+    if (model_params.calc_depth && workspace.row_depths.empty())
+        workspace.row_depths.resize(input_data.nrows, 0);
+
+    workspace.st = task.st;
+    workspace.end = task.st + task.nrows - 1;
+    std::copy(task.ix_arr.begin(), task.ix_arr.end(), workspace.ix_arr.begin() + workspace.st);
+
+    workspace.changed_weights = task.changed_weights;
+    workspace.weights_map.clear();
+    if (task.changed_weights)
+    {
+        if (!task.weights_in_map)
+        {
+            if (workspace.weights_arr.empty())
+                workspace.weights_arr.resize(input_data.nrows);
+            for (size_t row = 0; row < task.nrows; row++)
+                workspace.weights_arr[task.ix_arr[row]] = task.weights[row];
+        }
+
+        else
+        {
+            workspace.weights_map.reserve(task.nrows);
+            for (size_t row = 0; row < task.nrows; row++)
+                workspace.weights_map[task.ix_arr[row]] = task.weights[row];
+        }
+    }
+
+    workspace.try_all = task.try_all;
+    workspace.presorted_valid = task.presorted_valid;
+    if (task.presorted_valid)
+    {
+        size_t n = workspace.ix_arr.size();
+        workspace.presorted_ix.resize(n * input_data.ncols_numeric);
+        workspace.presorted_buffer.resize(n);
+        workspace.presorted_side.resize(input_data.nrows);
+        for (size_t col = 0; col < input_data.ncols_numeric; col++)
+            std::copy(task.presorted_ix.begin() + col*task.nrows,
+                      task.presorted_ix.begin() + (col+1)*task.nrows,
+                      workspace.presorted_ix.begin() + col*n + workspace.st);
+    }
+
+    workspace.col_sampler = std::move(task.col_sampler);
+    workspace.density_calculator = std::move(task.density_calculator);
+    workspace.tree_kurtoses = task_tree.tree_kurtoses;
+    for (HistLevel &level : workspace.hist_levels)
+        level.can_subtract = false;
+
+    workspace.rnd_generator = task.rnd_generator;
+    workspace.rbin = task.rbin;
+    workspace.coef_unif = task.coef_unif;
+    workspace.coef_norm = task.coef_norm;
+
+    /* the copies are not needed anymore after this */
+    task.ix_arr.clear();
+    task.ix_arr.shrink_to_fit();
+    task.weights.clear();
+    task.weights.shrink_to_fit();
+    task.presorted_ix.clear();
+    task.presorted_ix.shrink_to_fit();
+}
+
+/* Appends the nodes produced by the tasks of a tree to 'nodes', in the same depth-first order as if the
+   tree had been grown by a single task, updating the node numbers of their branches and imputation parents */
+template <class WorkerMemory, class Node>
+void splice_node_tasks(NodeTask<WorkerMemory> &root, std::vector<Node> NodeTask<WorkerMemory>::*task_nodes,
+                       size_t Node::*node_left, size_t Node::*node_right,
+                       std::vector<Node> &nodes, std::vector<ImputeNode> *impute_nodes)
+{
+    struct SpliceFrame {
+        NodeTask<WorkerMemory> *task;
+        size_t parent;
+        bool is_right;
+    };
+    std::vector<SpliceFrame> stack;
+    stack.push_back({&root, SIZE_MAX, false});
+
+    while (!stack.empty())
+    {
+        SpliceFrame frame = stack.back();
+        stack.pop_back();
+        NodeTask<WorkerMemory> &task = *frame.task;
+        std::vector<Node> &task_tree = task.*task_nodes;
+        size_t base = nodes.size();
+        size_t n_chain = task.n_chain;
+
+        if (frame.parent != SIZE_MAX)
+        {
+            if (frame.is_right)
+                nodes[frame.parent].*node_right = base;
+            else
+                nodes[frame.parent].*node_left = base;
+        }
+
+        for (size_t node = n_chain; node < task_tree.size(); node++)
+        {
+            nodes.push_back(std::move(task_tree[node]));
+            if (nodes.back().*node_left != 0)
+            {
+                nodes.back().*node_left = nodes.back().*node_left - n_chain + base;
+                nodes.back().*node_right = nodes.back().*node_right - n_chain + base;
+            }
+        }
+        task_tree.clear();
+        task_tree.shrink_to_fit();
+
+        if (impute_nodes != NULL)
+        {
+            for (size_t node = n_chain; node < task.impute_nodes.size(); node++)
+            {
+                impute_nodes->push_back(std::move(task.impute_nodes[node]));
+                if (node == n_chain)
+                    impute_nodes->back().parent = (frame.parent != SIZE_MAX)? frame.parent : 0;
+                else
+                    impute_nodes->back().parent = impute_nodes->back().parent - n_chain + base;
+            }
+            task.impute_nodes.clear();
+            task.impute_nodes.shrink_to_fit();
+        }
+
+        /* the left branch is pushed last so that its nodes come right after this one */
+        if (task.left)
+        {
+            stack.push_back({task.right.get(), base, true});
+            stack.push_back({task.left.get(), base, false});
+        }
+    }
+}
+
 bool is_boxed_metric(const ScoringMetric scoring_metric)
 {
     return scoring_metric == BoxedDensity ||
@@ -191,27 +191,29 @@ void impute_missing_values_internal(
     if (end == 0)
         return;
 
-    if ((size_t)nthreads > end)
-        nthreads = (int)end;
+    Executor *executor = get_thread_executor();
+    if (executor != NULL)
+        nthreads = executor->num_workers();
     #ifdef _OPENMP
-        std::vector<ImputedData<sparse_ix, ldouble_safe>> imp_memory(nthreads);
+    else if ((size_t)nthreads > end)
+        nthreads = (int)end;
     #else
-        std::vector<ImputedData<sparse_ix, ldouble_safe>> imp_memory(1);
+    else
+        nthreads = 1;
     #endif
+    std::vector<ImputedData<sparse_ix, ldouble_safe>> imp_memory(nthreads);
 
-    bool threw_exception = false;
+    std::atomic<bool> threw_exception(false);
     std::exception_ptr ex = NULL;
 
     if (model_outputs != NULL)
     {
-        #pragma omp parallel for schedule(dynamic) num_threads(nthreads) \
-                shared(end, imp_memory, prediction_data, model_outputs, ix_arr, imputer, ex, threw_exception)
-        for (size_t_for row = 0; row < (decltype(row))end; row++)
+        auto impute_row = [&](size_t row, int thread_id)
         {
-            if (threw_exception) continue;
+            if (threw_exception) return;
             try
             {
-                initialize_impute_calc(imp_memory[omp_get_thread_num()], prediction_data, imputer, ix_arr[row]);
+                initialize_impute_calc(imp_memory[thread_id], prediction_data, imputer, ix_arr[row]);
 
                 for (std::vector<IsoTree> &tree : model_outputs->trees)
                 {
@@ -219,7 +221,7 @@ void impute_missing_values_internal(
                                    *model_outputs,
                                    prediction_data,
                                    &imputer.imputer_tree[&tree - &(model_outputs->trees[0])],
-                                   &imp_memory[omp_get_thread_num()],
+                                   &imp_memory[thread_id],
                                    (double) 1,
                                    ix_arr[row],
                                    (sparse_ix*)NULL,
@@ -227,36 +229,26 @@ void impute_missing_values_internal(
                                    (size_t) 0);
                 }
 
-                apply_imputation_results(prediction_data, imp_memory[omp_get_thread_num()], imputer, (size_t) ix_arr[row]);
+                apply_imputation_results(prediction_data, imp_memory[thread_id], imputer, (size_t) ix_arr[row]);
             }
 
             catch(...)
             {
-                #pragma omp critical
-                {
-                    if (!threw_exception)
-                    {
-                        threw_exception = true;
-                        ex = std::current_exception();
-                    }
-                }
+                catch_task_exception(threw_exception, ex);
             }
-
-        }
+        };
+        run_parallel_for(executor, end, nthreads, true, impute_row);
     }
 
     else
     {
-        double temp;
-        #pragma omp parallel for schedule(dynamic) num_threads(nthreads) \
-                shared(end, imp_memory, prediction_data, model_outputs_ext, ix_arr, imputer, ex, threw_exception) \
-                private(temp)
-        for (size_t_for row = 0; row < (decltype(row))end; row++)
+        auto impute_row = [&](size_t row, int thread_id)
         {
-            if (threw_exception) continue;
+            if (threw_exception) return;
             try
             {
-                initialize_impute_calc(imp_memory[omp_get_thread_num()], prediction_data, imputer, ix_arr[row]);
+                double temp;
+                initialize_impute_calc(imp_memory[thread_id], prediction_data, imputer, ix_arr[row]);
 
                 for (std::vector<IsoHPlane> &hplane : model_outputs_ext->hplanes)
                 {
@@ -265,28 +257,21 @@ void impute_missing_values_internal(
                                     prediction_data,
                                     temp,
                                     &imputer.imputer_tree[&hplane - &(model_outputs_ext->hplanes[0])],
-                                    &imp_memory[omp_get_thread_num()],
+                                    &imp_memory[thread_id],
                                     (sparse_ix*)NULL,
                                     (double*)NULL,
                                     ix_arr[row]);
                 }
 
-                apply_imputation_results(prediction_data, imp_memory[omp_get_thread_num()], imputer, (size_t) ix_arr[row]);
+                apply_imputation_results(prediction_data, imp_memory[thread_id], imputer, (size_t) ix_arr[row]);
             }
 
             catch (...)
             {
-                #pragma omp critical
-                {
-                    if (!threw_exception)
-                    {
-                        threw_exception = true;
-                        ex = std::current_exception();
-                    }
-                }
+                catch_task_exception(threw_exception, ex);
             }
-
-        }
+        };
+        run_parallel_for(executor, end, nthreads, true, impute_row);
     }
 
     if (threw_exception)
@@ -314,31 +299,34 @@ void initialize_imputer(Imputer &imputer, InputData &input_data, size_t ntrees,
     imputer.imputer_tree = std::vector<std::vector<ImputeNode>>(ntrees);
 
     /* TODO: here should use sample weights if specified as density */
-    size_t offset, cnt;
+    /* note: dense data here might also be in row-major order or have a larger leading dimension */
+    Executor *executor = get_thread_executor();
     if (input_data.numeric_data != NULL)
     {
-        #pragma omp parallel for schedule(static) num_threads(nthreads) private(cnt, offset) shared(input_data, imputer)
-        for (size_t_for col = 0; col < (decltype(col))input_data.ncols_numeric; col++)
+        auto calc_col_mean = [&](size_t col, int thread_id)
         {
-            cnt    = input_data.nrows;
-            offset = col * input_data.nrows;
+            (void)thread_id;
+            size_t cnt    = input_data.nrows;
+            size_t offset = input_data.is_col_major? (col * input_data.ld_numeric) : col;
+            size_t stride = input_data.is_col_major? 1 : input_data.ld_numeric;
             for (size_t row = 0; row < input_data.nrows; row++)
             {
-                imputer.col_means[col] += (!is_na_or_inf(input_data.numeric_data[row + offset]))?
-                                           input_data.numeric_data[row + offset] : 0;
-                cnt -= is_na_or_inf(input_data.numeric_data[row + offset]);
+                imputer.col_means[col] += (!is_na_or_inf(input_data.numeric_data[row*stride + offset]))?
+                                           input_data.numeric_data[row*stride + offset] : 0;
+                cnt -= is_na_or_inf(input_data.numeric_data[row*stride + offset]);
             }
             imputer.col_means[col] /= (ldouble_safe) cnt;
             if (!cnt) imputer.col_means[col] = NAN;
-        }
+        };
+        run_parallel_for(executor, input_data.ncols_numeric, nthreads, false, calc_col_mean);
     }
 
     else if (input_data.Xc_indptr != NULL)
     {
-        #pragma omp parallel for schedule(dynamic) num_threads(nthreads) private(cnt) shared(input_data, imputer)
-        for (size_t_for col = 0; col < (decltype(col))input_data.ncols_numeric; col++)
+        auto calc_col_mean = [&](size_t col, int thread_id)
         {
-            cnt = input_data.nrows;
+            (void)thread_id;
+            size_t cnt = input_data.nrows;
             for (auto ix = input_data.Xc_indptr[col]; ix < input_data.Xc_indptr[col + 1]; ix++)
             {
                 imputer.col_means[col] += (!is_na_or_inf(input_data.Xc[ix]))?
@@ -347,26 +335,28 @@ void initialize_imputer(Imputer &imputer, InputData &input_data, size_t ntrees,
             }
             imputer.col_means[col] /= (ldouble_safe) cnt;
             if (!cnt) imputer.col_means[col] = NAN;
-        }
+        };
+        run_parallel_for(executor, input_data.ncols_numeric, nthreads, true, calc_col_mean);
     }
 
     if (input_data.categ_data != NULL)
     {
-        std::vector<size_t> cat_counts(input_data.max_categ);
-        #pragma omp parallel for schedule(static) num_threads(nthreads) firstprivate(cat_counts) private(offset) shared(input_data, imputer)
-        for (size_t_for col = 0; col < (decltype(col))input_data.ncols_categ; col++)
+        auto calc_col_mode = [&](size_t col, int thread_id)
         {
-            std::fill(cat_counts.begin(), cat_counts.end(), 0);
-            offset = col * input_data.nrows;
+            (void)thread_id;
+            std::vector<size_t> cat_counts(input_data.max_categ);
+            size_t offset = input_data.is_col_major? (col * input_data.ld_categ) : col;
+            size_t stride = input_data.is_col_major? 1 : input_data.ld_categ;
             for (size_t row = 0; row < input_data.nrows; row++)
             {
-                if (input_data.categ_data[row + offset] >= 0)
-                    cat_counts[input_data.categ_data[row + offset]]++;
+                if (input_data.categ_data[row*stride + offset] >= 0)
+                    cat_counts[input_data.categ_data[row*stride + offset]]++;
             }
             imputer.col_modes[col] = (int) std::distance(cat_counts.begin(),
                                                          std::max_element(cat_counts.begin(),
                                                                            cat_counts.begin() + input_data.ncat[col]));
-        }
+        };
+        run_parallel_for(executor, input_data.ncols_categ, nthreads, false, calc_col_mode);
     }
 }
 
@@ -808,18 +798,24 @@ void combine_tree_imputations(WorkerMemory &workspace,
 {
     if (workspace.impute_vec.size())
     {
-        #pragma omp parallel for schedule(dynamic) num_threads(nthreads) shared(has_missing, workspace, impute_vec)
-        for (size_t_for row = 0; row < (decltype(row))has_missing.size(); row++)
+        auto combine_row = [&](size_t row, int thread_id)
+        {
+            (void)thread_id;
             if (has_missing[row])
                 combine_imp_single(workspace.impute_vec[row], impute_vec[row]);
+        };
+        run_parallel_for(get_thread_executor(), has_missing.size(), nthreads, true, combine_row);
     }
 
     else if (workspace.impute_map.size())
     {
-        #pragma omp parallel for schedule(dynamic) num_threads(nthreads) shared(has_missing, workspace, impute_map)
-        for (size_t_for row = 0; row < (decltype(row))has_missing.size(); row++)
+        auto combine_row = [&](size_t row, int thread_id)
+        {
+            (void)thread_id;
             if (has_missing[row])
                 combine_imp_single(workspace.impute_map[row], impute_map[row]);
+        };
+        run_parallel_for(get_thread_executor(), has_missing.size(), nthreads, true, combine_row);
     }
 }
 
@@ -921,8 +917,6 @@ void apply_imputation_results(imp_arr    &impute_vec,
                               InputData  &input_data,
                               int        nthreads)
 {
-    size_t col;
-
     if (input_data.Xc_indptr != NULL)
     {
         std::vector<size_t> row_pos(input_data.nrows, 0);
@@ -952,20 +946,26 @@ void apply_imputation_results(imp_arr    &impute_vec,
         }
     }
 
-    #pragma omp parallel for schedule(dynamic) num_threads(nthreads) shared(input_data, impute_vec, imputer) private(col)
-    for (size_t_for row = 0; row < (decltype(row))input_data.nrows; row++)
+    /* dense data here might also be in row-major order or have a larger leading dimension */
+    size_t row_stride_num = input_data.is_col_major? 1 : input_data.ld_numeric;
+    size_t col_stride_num = input_data.is_col_major? input_data.ld_numeric : 1;
+    size_t row_stride_cat = input_data.is_col_major? 1 : input_data.ld_categ;
+    size_t col_stride_cat = input_data.is_col_major? input_data.ld_categ : 1;
+    auto apply_row = [&](size_t row, int thread_id)
     {
+        (void)thread_id;
+        size_t col;
         if (input_data.has_missing[row])
         {
             for (size_t ix = 0; ix < impute_vec[row].n_missing_num; ix++)
             {
                 col = impute_vec[row].missing_num[ix];
                 if (impute_vec[row].num_weight[ix] > 0 && !is_na_or_inf(impute_vec[row].num_sum[ix]))
-                    input_data.numeric_data[row + col * input_data.nrows]
+                    input_data.numeric_data[row*row_stride_num + col*col_stride_num]
                         =
                     impute_vec[row].num_sum[ix] / impute_vec[row].num_weight[ix];
                 else
-                    input_data.numeric_data[row + col * input_data.nrows]
+                    input_data.numeric_data[row*row_stride_num + col*col_stride_num]
                         =
                     imputer.col_means[col];
             }
@@ -973,19 +973,20 @@ void apply_imputation_results(imp_arr    &impute_vec,
             for (size_t ix = 0; ix < impute_vec[row].n_missing_cat; ix++)
             {
                 col = impute_vec[row].missing_cat[ix];
-                input_data.categ_data[row + col * input_data.nrows]
+                input_data.categ_data[row*row_stride_cat + col*col_stride_cat]
                     =
                 std::distance(impute_vec[row].cat_sum[col].begin(),
                               std::max_element(impute_vec[row].cat_sum[col].begin(),
                                                  impute_vec[row].cat_sum[col].end()));
 
-                if (input_data.categ_data[row + col * input_data.nrows] == 0 && impute_vec[row].cat_sum[col][0] <= 0)
-                    input_data.categ_data[row + col * input_data.nrows]
+                if (input_data.categ_data[row*row_stride_cat + col*col_stride_cat] == 0 && impute_vec[row].cat_sum[col][0] <= 0)
+                    input_data.categ_data[row*row_stride_cat + col*col_stride_cat]
                         =
                     imputer.col_modes[col];
             }
         }
-    }
+    };
+    run_parallel_for(get_thread_executor(), input_data.nrows, nthreads, true, apply_row);
 }
 
 template <class ImputedData, class InputData>
@@ -1130,8 +1131,10 @@ void initialize_impute_calc(ImputedData &imp, InputData &input_data, size_t row)
     if (input_data.numeric_data != NULL)
     {
         imp.missing_num.resize(input_data.ncols_numeric);
+        size_t offset = input_data.is_col_major? row : (row * input_data.ld_numeric);
+        size_t stride = input_data.is_col_major? input_data.ld_numeric : 1;
         for (size_t col = 0; col < input_data.ncols_numeric; col++)
-            if (is_na_or_inf(input_data.numeric_data[row + col * input_data.nrows]))
+            if (is_na_or_inf(input_data.numeric_data[col*stride + offset]))
                 imp.missing_num[imp.n_missing_num++] = col;
         imp.missing_num.resize(imp.n_missing_num);
         imp.num_sum.assign(imp.n_missing_num,    0);
@@ -1163,8 +1166,10 @@ void initialize_impute_calc(ImputedData &imp, InputData &input_data, size_t row)
     if (input_data.categ_data != NULL)
     {
         imp.missing_cat.resize(input_data.ncols_categ);
+        size_t offset = input_data.is_col_major? row : (row * input_data.ld_categ);
+        size_t stride = input_data.is_col_major? input_data.ld_categ : 1;
         for (size_t col = 0; col < input_data.ncols_categ; col++)
-            if (input_data.categ_data[row + col * input_data.nrows] < 0)
+            if (input_data.categ_data[col*stride + offset] < 0)
                 imp.missing_cat[imp.n_missing_cat++] = col;
         imp.missing_cat.resize(imp.n_missing_cat);
         imp.cat_weight.assign(imp.n_missing_cat, 0);
@@ -1286,10 +1291,13 @@ template <class ImputedData, class InputData>
 void allocate_imp_vec(std::vector<ImputedData> &impute_vec, InputData &input_data, int nthreads)
 {
     impute_vec.resize(input_data.nrows);
-    #pragma omp parallel for schedule(dynamic) num_threads(nthreads) shared(impute_vec, input_data)
-    for (size_t_for row = 0; row < (decltype(row))input_data.nrows; row++)
+    auto initialize_row = [&](size_t row, int thread_id)
+    {
+        (void)thread_id;
         if (input_data.has_missing[row])
             initialize_impute_calc(impute_vec[row], input_data, row);
+    };
+    run_parallel_for(get_thread_executor(), input_data.nrows, nthreads, true, initialize_row);
 }
 
 
@@ -1322,27 +1330,40 @@ void check_for_missing(InputData &input_data,
                        int nthreads)
 {
     input_data.has_missing.assign(input_data.nrows, false);
+    Executor *executor = get_thread_executor();
 
     if (input_data.Xc_indptr != NULL)
     {
+        /* each column is done in parallel separately, since different columns can have the same rows */
         for (size_t col = 0; col < input_data.ncols_numeric; col++)
-            #pragma omp parallel for schedule(static) num_threads(nthreads) shared(col, input_data)
-            for (size_t_for ix = input_data.Xc_indptr[col]; ix < (decltype(ix))input_data.Xc_indptr[col + 1]; ix++)
+        {
+            auto check_entry = [&](size_t pos, int thread_id)
+            {
+                (void)thread_id;
+                size_t ix = (size_t)input_data.Xc_indptr[col] + pos;
                 if (is_na_or_inf(input_data.Xc[ix]))
                     input_data.has_missing[input_data.Xc_ind[ix]] = true;
-            #pragma omp barrier
+            };
+            run_parallel_for(executor, (size_t)(input_data.Xc_indptr[col + 1] - input_data.Xc_indptr[col]),
+                             nthreads, false, check_entry);
+        }
     }
 
     if (input_data.numeric_data != NULL || input_data.categ_data != NULL)
     {
-        #pragma omp parallel for schedule(static) num_threads(nthreads) shared(input_data)
-        for (size_t_for row = 0; row < (decltype(row))input_data.nrows; row++)
+        /* dense data here might also be in row-major order or have a larger leading dimension */
+        size_t row_stride_num = input_data.is_col_major? 1 : input_data.ld_numeric;
+        size_t col_stride_num = input_data.is_col_major? input_data.ld_numeric : 1;
+        size_t row_stride_cat = input_data.is_col_major? 1 : input_data.ld_categ;
+        size_t col_stride_cat = input_data.is_col_major? input_data.ld_categ : 1;
+        auto check_row = [&](size_t row, int thread_id)
         {
+            (void)thread_id;
             if (input_data.Xc_indptr == NULL)
             {
                 for (size_t col = 0; col < input_data.ncols_numeric; col++)
                 {
-                    if (is_na_or_inf(input_data.numeric_data[row + col * input_data.nrows]))
+                    if (is_na_or_inf(input_data.numeric_data[row*row_stride_num + col*col_stride_num]))
                     {
                         input_data.has_missing[row] = true;
                         break;
@@ -1353,13 +1374,14 @@ void check_for_missing(InputData &input_data,
             if (!input_data.has_missing[row])
                 for (size_t col = 0; col < input_data.ncols_categ; col++)
                 {
-                    if (input_data.categ_data[row + col * input_data.nrows] < 0)
+                    if (input_data.categ_data[row*row_stride_cat + col*col_stride_cat] < 0)
                     {
                         input_data.has_missing[row] = true;
                         break;
                     }
                 }
-        }
+        };
+        run_parallel_for(executor, input_data.nrows, nthreads, false, check_row);
     }
 
     input_data.n_missing = std::accumulate(input_data.has_missing.begin(), input_data.has_missing.end(), (size_t)0);
@@ -1374,9 +1396,9 @@ size_t check_for_missing(PredictionData  &prediction_data,
 {
     std::vector<char> has_missing(prediction_data.nrows, false);
 
-    #pragma omp parallel for schedule(static) num_threads(nthreads) shared(has_missing, prediction_data, imputer)
-    for (size_t_for row = 0; row < (decltype(row))prediction_data.nrows; row++)
+    auto check_row = [&](size_t row, int thread_id)
     {
+        (void)thread_id;
         if (prediction_data.numeric_data != NULL)
         {
             if (prediction_data.is_col_major)
@@ -1442,7 +1464,8 @@ size_t check_for_missing(PredictionData  &prediction_data,
                 }
             }
         }
-    }
+    };
+    run_parallel_for(get_thread_executor(), prediction_data.nrows, nthreads, false, check_row);
 
     size_t st = 0;
     size_t temp;
@@ -154,12 +154,16 @@ static inline size_t get_idx_tree_right(const IsoHPlane &node)
     return node.hplane_right;
 }
 
+/* Terminal nodes are added to 'node_indices' in the order in which they are visited, so that
+   the terminal nodes under any given node always form a contiguous range, regardless of how
+   the nodes are ordered in the tree. Returns the position of the last terminal node that
+   was added under 'curr_node'. */
 template <class Node>
-void build_dindex_recursive
+size_t build_dindex_recursive
 (
     const size_t curr_node,
     const size_t n_terminal, const size_t ncomb,
-    const size_t st, const size_t end,
+    const size_t st,
     std::vector<size_t> &restrict node_indices, /* array with all terminal indices in 'tree' */
     const std::vector<size_t> &restrict node_mappings, /* tree_index : terminal_index */
     std::vector<double> &restrict node_distances, /* indexed by terminal_index */
@@ -168,63 +172,45 @@ void build_dindex_recursive
     const std::vector<Node> &tree
 )
 {
-    if (end > st)
+    if (is_terminal_node(tree[curr_node]))
     {
-        size_t i, j;
-        for (size_t el1 = st; el1 < end; el1++)
-        {
-            for (size_t el2 = el1 + 1; el2 <= end; el2++)
-            {
-                i = node_mappings[node_indices[el1]];
-                j = node_mappings[node_indices[el2]];
-                node_distances[ix_comb(i, j, n_terminal, ncomb)]++;
-            }
-        }
+        node_indices[st] = curr_node;
+        node_depths[node_mappings[curr_node]] = curr_depth;
+        return st;
     }
 
-    if (!is_terminal_node(tree[curr_node]))
+    curr_depth++;
+    size_t end_left = build_dindex_recursive<Node>(get_idx_tree_left(tree[curr_node]),
+                                                   n_terminal, ncomb,
+                                                   st,
+                                                   node_indices,
+                                                   node_mappings,
+                                                   node_distances,
+                                                   node_depths,
+                                                   curr_depth,
+                                                   tree);
+    size_t end = build_dindex_recursive<Node>(get_idx_tree_right(tree[curr_node]),
+                                              n_terminal, ncomb,
+                                              end_left + 1,
+                                              node_indices,
+                                              node_mappings,
+                                              node_distances,
+                                              node_depths,
+                                              curr_depth,
+                                              tree);
+
+    size_t i, j;
+    for (size_t el1 = st; el1 < end; el1++)
     {
-        const size_t delim = get_idx_tree_right(tree[curr_node]);
-        size_t frontier = st;
-        size_t temp;
-        for (size_t ix = st; ix <= end; ix++)
+        for (size_t el2 = el1 + 1; el2 <= end; el2++)
         {
-           if (node_indices[ix] < delim)
-            {
-                temp = node_indices[frontier];
-                node_indices[frontier] = node_indices[ix];
-                node_indices[ix] = temp;
-                frontier++;
-            }
+            i = node_mappings[node_indices[el1]];
+            j = node_mappings[node_indices[el2]];
+            node_distances[ix_comb(i, j, n_terminal, ncomb)]++;
         }
-
-        if (unlikely(frontier == st)) unexpected_error();
-
-        curr_depth++;
-        build_dindex_recursive<Node>(get_idx_tree_left(tree[curr_node]),
-                                     n_terminal, ncomb,
-                                     st, frontier-1,
-                                     node_indices,
-                                     node_mappings,
-                                     node_distances,
-                                     node_depths,
-                                     curr_depth,
-                                     tree);
-        build_dindex_recursive<Node>(get_idx_tree_right(tree[curr_node]),
-                                     n_terminal, ncomb,
-                                     frontier, end,
-                                     node_indices,
-                                     node_mappings,
-                                     node_distances,
-                                     node_depths,
-                                     curr_depth,
-                                     tree);
     }
 
-    else
-    {
-        node_depths[node_mappings[curr_node]] = curr_depth;
-    }
+    return end;
 }
 
 template <class Node>
@@ -242,19 +228,13 @@ void build_dindex
 
     std::fill(node_distances.begin(), node_distances.end(), 0.);
 
-    node_indices.clear();
-    for (size_t node = 0; node < tree.size(); node++)
-    {
-        if (is_terminal_node(tree[node]))
-            node_indices.push_back(node);
-    }
-
+    node_indices.resize(n_terminal);
     node_depths.resize(n_terminal);
 
     build_dindex_recursive<Node>(
         (size_t)0,
-        node_indices.size(), calc_ncomb(node_indices.size()),
-        0, node_indices.size()-1,
+        n_terminal, calc_ncomb(n_terminal),
+        0,
         node_indices,
         node_mappings,
         node_distances,
@@ -319,8 +299,12 @@ void build_distance_mappings(TreesIndexer &indexer, const Model &model, int nthr
     check_interrupt_switch(ss);
     if (max_n_terminal <= 1) return;
 
+    Executor *executor = get_thread_executor();
+    if (executor != NULL)
+        nthreads = executor->num_workers();
     #ifndef _OPENMP
-    nthreads = 1;
+    else
+        nthreads = 1;
     #endif
     std::vector<std::vector<size_t>> thread_buffer_indices(nthreads);
     for (std::vector<size_t> &v : thread_buffer_indices)
@@ -329,12 +313,11 @@ void build_distance_mappings(TreesIndexer &indexer, const Model &model, int nthr
 
     
     
-    bool threw_exception = false;
+    std::atomic<bool> threw_exception(false);
     std::exception_ptr ex = NULL;
-    #pragma omp parallel for schedule(dynamic) num_threads(nthreads) shared(indexer, model, n_terminal, threw_exception, ex)
-    for (size_t_for tree = 0; tree < (decltype(tree))ntrees; tree++)
+    auto build_tree_distances = [&](size_t tree, int thread_id)
     {
-        if (interrupt_switch || threw_exception) continue;
+        if (interrupt_switch || threw_exception) return;
 
         try
         {
@@ -343,7 +326,7 @@ void build_distance_mappings(TreesIndexer &indexer, const Model &model, int nthr
             indexer.indices[tree].node_distances.assign(ncomb, 0.);
             indexer.indices[tree].node_distances.shrink_to_fit();
             build_dindex(
-                thread_buffer_indices[omp_get_thread_num()],
+                thread_buffer_indices[thread_id],
                 indexer.indices[tree].terminal_node_mappings,
                 indexer.indices[tree].node_distances,
                 indexer.indices[tree].node_depths,
@@ -354,16 +337,10 @@ void build_distance_mappings(TreesIndexer &indexer, const Model &model, int nthr
 
         catch (...)
         {
-            #pragma omp critical
-            {
-                if (!threw_exception)
-                {
-                    threw_exception = true;
-                    ex = std::current_exception();
-                }
-            }
+            catch_task_exception(threw_exception, ex);
         }
-    }
+    };
+    run_parallel_for(executor, ntrees, nthreads, true, build_tree_distances);
 
     if (interrupt_switch || threw_exception)
     {
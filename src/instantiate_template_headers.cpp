@@ -79,6 +79,8 @@
 
 #ifndef NO_TEMPLATED_VERSIONS
 
+#define _NO_SPARSE_IX
+
 #define real_t double
 #define sparse_ix int64_t
 #include "instantiate_template_headers.hpp"
@@ -91,6 +93,8 @@
 #undef real_t
 #undef sparse_ix
 
+#undef _NO_SPARSE_IX
+
 #define _NO_REAL_T
 
 #define real_t float
@@ -99,6 +103,8 @@
 #undef real_t
 #undef sparse_ix
 
+#define _NO_SPARSE_IX
+
 #define real_t float
 #define sparse_ix int64_t
 #include "instantiate_template_headers.hpp"
@@ -111,6 +117,7 @@
 #undef real_t
 #undef sparse_ix
 
+#undef _NO_SPARSE_IX
 #undef _NO_REAL_T
 
 #endif /* NO_TEMPLATED_VERSIONS */
@@ -108,6 +108,57 @@ ISOTREE_EXPORTED int fit_iforest(IsoForest *model_outputs, ExtIsoForest *model_o
                 depth_imp, weigh_imp_rows, impute_at_fit,
                 random_seed, use_long_double, nthreads);
 }
+ISOTREE_EXPORTED int fit_iforest(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
+                real_t numeric_data[],  size_t ncols_numeric,
+                int    categ_data[],    size_t ncols_categ,    int ncat[],
+                bool is_col_major, size_t ld_numeric, size_t ld_categ,
+                real_t Xc[], sparse_ix Xc_ind[], sparse_ix Xc_indptr[],
+                size_t ndim, size_t ntry, CoefType coef_type, bool coef_by_prop,
+                real_t sample_weights[], bool with_replacement, bool weight_as_sample,
+                size_t nrows, size_t sample_size, size_t ntrees,
+                size_t max_depth,   size_t ncols_per_tree,
+                bool   limit_depth, bool penalize_range, bool standardize_data,
+                ScoringMetric scoring_metric, bool fast_bratio,
+                bool   standardize_dist, double tmat[],
+                double output_depths[], bool standardize_depth,
+                real_t col_weights[], bool weigh_by_kurt,
+                double prob_pick_by_gain_pl, double prob_pick_by_gain_avg,
+                double prob_pick_by_full_gain, double prob_pick_by_dens,
+                double prob_pick_col_by_range, double prob_pick_col_by_var,
+                double prob_pick_col_by_kurt,
+                double min_gain, SplitSearch split_search, MissingAction missing_action,
+                CategSplit cat_split_type, NewCategAction new_cat_action,
+                bool   all_perm, Imputer *imputer, size_t min_imp_obs,
+                UseDepthImp depth_imp, WeighImpRows weigh_imp_rows, bool impute_at_fit,
+                uint64_t random_seed, bool use_long_double, size_t node_task_rows,
+                bool reorder_nodes_after_fit, int nthreads)
+{
+    return fit_iforest<real_t, sparse_ix>
+               (model_outputs, model_outputs_ext,
+                numeric_data,  ncols_numeric,
+                categ_data,    ncols_categ,    ncat,
+                is_col_major, ld_numeric, ld_categ,
+                Xc, Xc_ind, Xc_indptr,
+                ndim, ntry, coef_type, coef_by_prop,
+                sample_weights, with_replacement, weight_as_sample,
+                nrows, sample_size, ntrees,
+                max_depth,   ncols_per_tree,
+                limit_depth, penalize_range, standardize_data,
+                scoring_metric, fast_bratio,
+                standardize_dist, tmat,
+                output_depths, standardize_depth,
+                col_weights, weigh_by_kurt,
+                prob_pick_by_gain_pl, prob_pick_by_gain_avg,
+                prob_pick_by_full_gain, prob_pick_by_dens,
+                prob_pick_col_by_range, prob_pick_col_by_var,
+                prob_pick_col_by_kurt,
+                min_gain, split_search, missing_action,
+                cat_split_type, new_cat_action,
+                all_perm, imputer, min_imp_obs,
+                depth_imp, weigh_imp_rows, impute_at_fit,
+                random_seed, use_long_double, node_task_rows,
+                reorder_nodes_after_fit, nthreads);
+}
 ISOTREE_EXPORTED int add_tree(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
              real_t numeric_data[],  size_t ncols_numeric,
              int    categ_data[],    size_t ncols_categ,    int ncat[],
@@ -226,8 +277,149 @@ ISOTREE_EXPORTED void set_reference_points(IsoForest *model_outputs, ExtIsoFores
                          Xr, Xr_ind, Xr_indptr,
                          nrows, nthreads);
 }
+ISOTREE_EXPORTED void predict_iforest_bitvector(real_t numeric_data[], bool is_col_major, size_t ld_numeric,
+                               size_t nrows, int nthreads, bool standardize,
+                               const BitvectorIsoForest &bv_forest,
+                               double output_depths[], sparse_ix tree_num[],
+                               double per_tree_depths[])
+{
+    predict_iforest_bitvector<real_t, sparse_ix>
+                             (numeric_data, is_col_major, ld_numeric,
+                              nrows, nthreads, standardize,
+                              bv_forest,
+                              output_depths, tree_num,
+                              per_tree_depths);
+}
+ISOTREE_EXPORTED void predict_iforest_compiled(real_t numeric_data[], bool is_col_major, size_t ld_numeric,
+                              size_t nrows, int nthreads, bool standardize,
+                              const CompiledIsoForest &compiled,
+                              double output_depths[], sparse_ix tree_num[],
+                              double per_tree_depths[])
+{
+    predict_iforest_compiled<real_t, sparse_ix>
+                            (numeric_data, is_col_major, ld_numeric,
+                             nrows, nthreads, standardize,
+                             compiled,
+                             output_depths, tree_num,
+                             per_tree_depths);
+}
+ISOTREE_EXPORTED void predict_iforest_compiled(real_t numeric_data[], bool is_col_major, size_t ld_numeric,
+                              size_t nrows, int nthreads, bool standardize,
+                              const CompiledExtIsoForest &compiled,
+                              double output_depths[], sparse_ix tree_num[],
+                              double per_tree_depths[])
+{
+    predict_iforest_compiled<real_t, sparse_ix>
+                            (numeric_data, is_col_major, ld_numeric,
+                             nrows, nthreads, standardize,
+                             compiled,
+                             output_depths, tree_num,
+                             per_tree_depths);
+}
+ISOTREE_EXPORTED void predict_iforest_view(real_t numeric_data[], int categ_data[],
+                          bool is_col_major, size_t ld_numeric, size_t ld_categ,
+                          real_t Xc[], sparse_ix Xc_ind[], sparse_ix Xc_indptr[],
+                          real_t Xr[], sparse_ix Xr_ind[], sparse_ix Xr_indptr[],
+                          size_t nrows, int nthreads, bool standardize,
+                          const IsoForestView &view,
+                          double output_depths[], double per_tree_depths[])
+{
+    predict_iforest_view<real_t, sparse_ix>
+                        (numeric_data, categ_data,
+                         is_col_major, ld_numeric, ld_categ,
+                         Xc, Xc_ind, Xc_indptr,
+                         Xr, Xr_ind, Xr_indptr,
+                         nrows, nthreads, standardize,
+                         view,
+                         output_depths, per_tree_depths);
+}
+ISOTREE_EXPORTED void predict_flat_model(real_t numeric_data[], bool is_col_major, size_t ld_numeric,
+                        size_t nrows, int nthreads, bool standardize,
+                        const FlatModel &model,
+                        double output_depths[], sparse_ix tree_num[],
+                        double per_tree_depths[])
+{
+    predict_flat_model<real_t, sparse_ix>
+                      (numeric_data, is_col_major, ld_numeric,
+                       nrows, nthreads, standardize,
+                       model,
+                       output_depths, tree_num,
+                       per_tree_depths);
+}
+
+#ifndef _NO_SPARSE_IX
+ISOTREE_EXPORTED void predict_iforest_decision(real_t numeric_data[], bool is_col_major, size_t ld_numeric,
+                              size_t nrows, int nthreads,
+                              const CompiledIsoForest &compiled,
+                              double threshold, double confidence,
+                              int output_decisions[], size_t trees_used[])
+{
+    predict_iforest_decision<real_t>
+                            (numeric_data, is_col_major, ld_numeric,
+                             nrows, nthreads,
+                             compiled,
+                             threshold, confidence,
+                             output_decisions, trees_used);
+}
+ISOTREE_EXPORTED double predict_iforest_row(const PredictionContext &context,
+                                            const real_t numeric_row[], const int categ_row[])
+{
+    return predict_iforest_row<real_t>(context, numeric_row, categ_row);
+}
+ISOTREE_EXPORTED void bin_numeric_data(real_t numeric_data[], bool is_col_major, size_t ld_numeric,
+                      size_t nrows, int nthreads,
+                      const BinPlan &plan, uint8_t binned_data[])
+{
+    bin_numeric_data<real_t, uint8_t>
+                    (numeric_data, is_col_major, ld_numeric,
+                     nrows, nthreads,
+                     plan, binned_data);
+}
+ISOTREE_EXPORTED void bin_numeric_data(real_t numeric_data[], bool is_col_major, size_t ld_numeric,
+                      size_t nrows, int nthreads,
+                      const BinPlan &plan, uint16_t binned_data[])
+{
+    bin_numeric_data<real_t, uint16_t>
+                    (numeric_data, is_col_major, ld_numeric,
+                     nrows, nthreads,
+                     plan, binned_data);
+}
+ISOTREE_EXPORTED double get_flat_model_max_deviation(real_t numeric_data[], bool is_col_major, size_t ld_numeric,
+                                    size_t nrows, int nthreads, bool standardize,
+                                    IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
+                                    const FlatModel &flat_model)
+{
+    return get_flat_model_max_deviation<real_t>
+                                       (numeric_data, is_col_major, ld_numeric,
+                                        nrows, nthreads, standardize,
+                                        model_outputs, model_outputs_ext,
+                                        flat_model);
+}
+#endif
 
 #ifndef _NO_REAL_T
+ISOTREE_EXPORTED void predict_iforest_binned(const uint8_t binned_data[], size_t nrows, int nthreads, bool standardize,
+                            const BinPlan &plan,
+                            double output_depths[], sparse_ix tree_num[],
+                            double per_tree_depths[])
+{
+    predict_iforest_binned<uint8_t, sparse_ix>
+                          (binned_data, nrows, nthreads, standardize,
+                           plan,
+                           output_depths, tree_num,
+                           per_tree_depths);
+}
+ISOTREE_EXPORTED void predict_iforest_binned(const uint16_t binned_data[], size_t nrows, int nthreads, bool standardize,
+                            const BinPlan &plan,
+                            double output_depths[], sparse_ix tree_num[],
+                            double per_tree_depths[])
+{
+    predict_iforest_binned<uint16_t, sparse_ix>
+                          (binned_data, nrows, nthreads, standardize,
+                           plan,
+                           output_depths, tree_num,
+                           per_tree_depths);
+}
 ISOTREE_EXPORTED void get_num_nodes(IsoForest &model_outputs, sparse_ix *n_nodes, sparse_ix *n_terminal, int nthreads) noexcept
 {
     get_num_nodes<sparse_ix>(model_outputs, n_nodes, n_terminal, nthreads);
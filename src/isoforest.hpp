@@ -62,15 +62,18 @@
 */
 #include "isotree.hpp"
 
+/* Determines the split for the node at the end of 'trees', leaving the workspace set up for its left
+   branch, which is added as a new node. If the node ends up being terminal, calculates its score
+   instead and returns 'false'. The right branch is set up afterwards through 'split_itree_right'. */
 template <class InputData, class WorkerMemory, class ldouble_safe>
-void split_itree_recursive(std::vector<IsoTree>     &trees,
-                           WorkerMemory             &workspace,
-                           InputData                &input_data,
-                           ModelParams              &model_params,
-                           std::vector<ImputeNode> *impute_nodes,
-                           size_t                   curr_depth)
+bool split_itree_node(std::vector<IsoTree>     &trees,
+                      WorkerMemory             &workspace,
+                      InputData                &input_data,
+                      ModelParams              &model_params,
+                      std::vector<ImputeNode> *impute_nodes,
+                      size_t                   curr_depth)
 {
-    if (interrupt_switch) return;
+    if (interrupt_switch) return false;
     ldouble_safe sum_weight = -HUGE_VAL;
 
     /* calculate imputation statistics if desired */
@@ -108,6 +111,28 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
     if (input_data.Xc_indptr != NULL && impute_nodes == NULL)
         std::sort(workspace.ix_arr.begin() + workspace.st, workspace.ix_arr.begin() + workspace.end + 1);
 
+    /* histograms for guided splits are kept by depth, so that the branches of this node can reuse them */
+    if (input_data.X_binned != NULL)
+    {
+        if (workspace.hist_levels.size() <= curr_depth)
+        {
+            /* new levels get room for as many columns as a node can evaluate */
+            size_t prev_levels = workspace.hist_levels.size();
+            size_t ncols_level = std::max((size_t)1, std::min(model_params.ntry, input_data.ncols_numeric));
+            workspace.hist_levels.resize(curr_depth + 1);
+            for (size_t level = prev_levels; level <= curr_depth; level++)
+            {
+                workspace.hist_levels[level].cols.reserve(ncols_level);
+                workspace.hist_levels[level].hists.reserve(ncols_level * (HIST_MAX_BINS + 1));
+            }
+        }
+        workspace.hist_levels[curr_depth].st = workspace.st;
+        workspace.hist_levels[curr_depth].end = workspace.end;
+        workspace.hist_levels[curr_depth].can_subtract = false;
+        workspace.hist_levels[curr_depth].cols.clear();
+        workspace.hist_levels[curr_depth].hists.clear();
+    }
+
     /* pick column to split according to criteria */
     workspace.prob_split_type = workspace.rbin(workspace.rnd_generator);
 
@@ -313,7 +338,7 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
         {
             while (workspace.col_sampler.sample_col(trees.back().col_num, workspace.rnd_generator))
             {
-                if (interrupt_switch) return;
+                if (interrupt_switch) return false;
                 
                 get_split_range(workspace, input_data, model_params, trees.back());
                 if (workspace.unsplittable)
@@ -338,7 +363,7 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
                     workspace.col_sampler.sample_col(trees.back().col_num, workspace.rnd_generator)
                    )
             {
-                if (interrupt_switch) return;
+                if (interrupt_switch) return false;
 
                 get_split_range(workspace, input_data, model_params, trees.back());
                 if (workspace.unsplittable)
@@ -370,8 +395,10 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
         else if (workspace.try_all && workspace.col_criterion == Uniformly)
             workspace.col_sampler.shuffle_remainder(workspace.rnd_generator);
 
-        std::vector<bool> col_is_taken;
-        hashed_set<size_t> col_is_taken_s;
+        std::vector<bool> &col_is_taken = workspace.col_is_taken;
+        hashed_set<size_t> &col_is_taken_s = workspace.col_is_taken_s;
+        col_is_taken.clear();
+        col_is_taken_s.clear();
         if (model_params.ntry < workspace.col_sampler.get_remaining_cols() && workspace.col_criterion == Uniformly)
         {
             if (input_data.ncols_tot < 1e5 ||
@@ -389,6 +416,7 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
         workspace.ntried = 0; /* <- used to determine when to shuffle the remainder */
         workspace.ntaken = 0; /* <- used to count how many columns have been evaluated */
         trees.back().score = -HUGE_VAL; /* this is used to track the best gain */
+        workspace.best_split_categ.clear();
 
         while (
                 (workspace.col_criterion != Uniformly)?
@@ -400,7 +428,7 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
                  workspace.col_sampler.sample_col(workspace.col_chosen, workspace.rnd_generator))
             )
         {
-            if (interrupt_switch) return;
+            if (interrupt_switch) return false;
 
             if (workspace.col_criterion != Uniformly)
             {
@@ -436,7 +464,15 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
                 {
                     if (input_data.Xc_indptr == NULL)
                     {
-                        if (!workspace.changed_weights)
+                        bool is_presorted = take_presorted_order(workspace, workspace.col_chosen);
+                        if (eval_guided_crit_hist<InputData, WorkerMemory, ldouble_safe>(
+                                                  workspace, input_data, model_params,
+                                                  workspace.col_chosen, curr_depth, false,
+                                                  workspace.this_split_point))
+                        {
+                            /* gain was obtained from the histogram of the column */
+                        }
+                        else if (!workspace.changed_weights)
                             workspace.this_gain = eval_guided_crit<typename std::remove_pointer<decltype(input_data.numeric_data)>::type,
                                                                    ldouble_safe>(
                                                                    workspace.ix_arr.data(), workspace.st, workspace.end,
@@ -447,12 +483,13 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
                                                                    workspace.split_ix, workspace.this_split_point,
                                                                    workspace.xmin, workspace.xmax,
                                                                    workspace.criterion, model_params.min_gain,
-                                                                   model_params.missing_action,
+                                                                   model_params.missing_action, is_presorted,
                                                                    workspace.col_indices.data(),
                                                                    workspace.col_sampler.get_remaining_cols(),
                                                                    model_params.ncols_per_tree < input_data.ncols_tot,
                                                                    input_data.X_row_major.data(),
                                                                    input_data.ncols_numeric,
+                                                                   workspace.split_scratch.buffer_x.data(),
                                                                    input_data.Xr.data(),
                                                                    input_data.Xr_ind.data(),
                                                                    input_data.Xr_indptr.data());
@@ -467,12 +504,13 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
                                                                             workspace.split_ix, workspace.this_split_point,
                                                                             workspace.xmin, workspace.xmax,
                                                                             workspace.criterion, model_params.min_gain,
-                                                                            model_params.missing_action,
+                                                                            model_params.missing_action, is_presorted,
                                                                             workspace.col_indices.data(),
                                                                             workspace.col_sampler.get_remaining_cols(),
                                                                             model_params.ncols_per_tree < input_data.ncols_tot,
                                                                             input_data.X_row_major.data(),
                                                                             input_data.ncols_numeric,
+                                                                            workspace.split_scratch.buffer_x.data(),
                                                                             input_data.Xr.data(),
                                                                             input_data.Xr_ind.data(),
                                                                             input_data.Xr_indptr.data(),
@@ -488,12 +526,13 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
                                                                             workspace.split_ix, workspace.this_split_point,
                                                                             workspace.xmin, workspace.xmax,
                                                                             workspace.criterion, model_params.min_gain,
-                                                                            model_params.missing_action,
+                                                                            model_params.missing_action, is_presorted,
                                                                             workspace.col_indices.data(),
                                                                             workspace.col_sampler.get_remaining_cols(),
                                                                             model_params.ncols_per_tree < input_data.ncols_tot,
                                                                             input_data.X_row_major.data(),
                                                                             input_data.ncols_numeric,
+                                                                            workspace.split_scratch.buffer_x.data(),
                                                                             input_data.Xr.data(),
                                                                             input_data.Xr_ind.data(),
                                                                             input_data.Xr_indptr.data(),
@@ -517,6 +556,7 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
                                                                    model_params.ncols_per_tree < input_data.ncols_tot,
                                                                    input_data.X_row_major.data(),
                                                                    input_data.ncols_numeric,
+                                                                   workspace.split_scratch.buffer_x.data(),
                                                                    input_data.Xr.data(),
                                                                    input_data.Xr_ind.data(),
                                                                    input_data.Xr_indptr.data());
@@ -535,9 +575,11 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
                                                                             model_params.ncols_per_tree < input_data.ncols_tot,
                                                                             input_data.X_row_major.data(),
                                                                             input_data.ncols_numeric,
+                                                                            workspace.split_scratch.buffer_x.data(),
                                                                             input_data.Xr.data(),
                                                                             input_data.Xr_ind.data(),
                                                                             input_data.Xr_indptr.data(),
+                                                                            workspace.split_scratch.buffer_w.data(),
                                                                             workspace.weights_arr);
                         else
                             workspace.this_gain = eval_guided_crit_weighted<typename std::remove_pointer<decltype(input_data.Xc)>::type,
@@ -555,9 +597,11 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
                                                                             model_params.ncols_per_tree < input_data.ncols_tot,
                                                                             input_data.X_row_major.data(),
                                                                             input_data.ncols_numeric,
+                                                                            workspace.split_scratch.buffer_x.data(),
                                                                             input_data.Xr.data(),
                                                                             input_data.Xr_ind.data(),
                                                                             input_data.Xr_indptr.data(),
+                                                                            workspace.split_scratch.buffer_w.data(),
                                                                             workspace.weights_map);
                     }
                 }
@@ -581,7 +625,8 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
                                                                         input_data.ncat[workspace.col_chosen - input_data.ncols_numeric],
                                                                         &workspace.saved_cat_mode,
                                                                         workspace.buffer_szt.data(),
-                                                                        workspace.buffer_dbl.data(), workspace.this_categ, workspace.this_split_categ.data(),
+                                                                        workspace.buffer_dbl.data(), workspace.split_scratch.buffer_cnt.data(),
+                                                                        workspace.this_categ, workspace.this_split_categ.data(),
                                                                         workspace.buffer_chr.data(), workspace.criterion, model_params.min_gain,
                                                                         model_params.all_perm, model_params.missing_action, model_params.cat_split_type,
                                                                         workspace.weights_arr);
@@ -592,7 +637,8 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
                                                                         input_data.ncat[workspace.col_chosen - input_data.ncols_numeric],
                                                                         &workspace.saved_cat_mode,
                                                                         workspace.buffer_szt.data(),
-                                                                        workspace.buffer_dbl.data(), workspace.this_categ, workspace.this_split_categ.data(),
+                                                                        workspace.buffer_dbl.data(), workspace.split_scratch.buffer_cnt.data(),
+                                                                        workspace.this_categ, workspace.this_split_categ.data(),
                                                                         workspace.buffer_chr.data(), workspace.criterion, model_params.min_gain,
                                                                         model_params.all_perm, model_params.missing_action, model_params.cat_split_type,
                                                                         workspace.weights_map);
@@ -639,9 +685,9 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
 
                             case SubSet:
                             {
-                                trees.back().cat_split.assign(workspace.this_split_categ.begin(),
-                                                              workspace.this_split_categ.begin()
-                                                                + input_data.ncat[trees.back().col_num]);
+                                workspace.best_split_categ.assign(workspace.this_split_categ.begin(),
+                                                                  workspace.this_split_categ.begin()
+                                                                    + input_data.ncat[trees.back().col_num]);
                                 break;
                             }
                         }
@@ -693,6 +739,10 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
             goto terminal_statistics;
         else
             trees.back().score = 0.;
+
+        /* the categories of the best split are copied to the node only once it is decided, so as to allocate them once */
+        if (!workspace.best_split_categ.empty())
+            trees.back().cat_split.assign(workspace.best_split_categ.begin(), workspace.best_split_categ.end());
     }
 
 
@@ -714,7 +764,16 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
                 {
                     if (input_data.Xc_indptr == NULL)
                     {
-                        if (!workspace.changed_weights)
+                        bool is_presorted = take_presorted_order(workspace, trees.back().col_num);
+                        bool used_hist = eval_guided_crit_hist<InputData, WorkerMemory, ldouble_safe>(
+                                                               workspace, input_data, model_params,
+                                                               trees.back().col_num, curr_depth, true,
+                                                               trees.back().num_split);
+                        if (used_hist)
+                        {
+                            /* gain was obtained from the histogram of the column */
+                        }
+                        else if (!workspace.changed_weights)
                             workspace.this_gain =
                                 eval_guided_crit<typename std::remove_pointer<decltype(input_data.numeric_data)>::type, ldouble_safe>(
                                                  workspace.ix_arr.data(), workspace.st, workspace.end,
@@ -725,12 +784,13 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
                                                  workspace.split_ix, trees.back().num_split,
                                                  workspace.xmin, workspace.xmax,
                                                  workspace.criterion, model_params.min_gain,
-                                                 model_params.missing_action,
+                                                 model_params.missing_action, is_presorted,
                                                  workspace.col_indices.data(),
                                                  workspace.col_sampler.get_remaining_cols(),
                                                  model_params.ncols_per_tree < input_data.ncols_tot,
                                                  input_data.X_row_major.data(),
                                                  input_data.ncols_numeric,
+                                                 workspace.split_scratch.buffer_x.data(),
                                                  input_data.Xr.data(),
                                                  input_data.Xr_ind.data(),
                                                  input_data.Xr_indptr.data());
@@ -745,12 +805,13 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
                                                           workspace.split_ix, trees.back().num_split,
                                                           workspace.xmin, workspace.xmax,
                                                           workspace.criterion, model_params.min_gain,
-                                                          model_params.missing_action,
+                                                          model_params.missing_action, is_presorted,
                                                           workspace.col_indices.data(),
                                                           workspace.col_sampler.get_remaining_cols(),
                                                           model_params.ncols_per_tree < input_data.ncols_tot,
                                                           input_data.X_row_major.data(),
                                                           input_data.ncols_numeric,
+                                                          workspace.split_scratch.buffer_x.data(),
                                                           input_data.Xr.data(),
                                                           input_data.Xr_ind.data(),
                                                           input_data.Xr_indptr.data(),
@@ -766,12 +827,13 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
                                                           workspace.split_ix, trees.back().num_split,
                                                           workspace.xmin, workspace.xmax,
                                                           workspace.criterion, model_params.min_gain,
-                                                          model_params.missing_action,
+                                                          model_params.missing_action, is_presorted,
                                                           workspace.col_indices.data(),
                                                           workspace.col_sampler.get_remaining_cols(),
                                                           model_params.ncols_per_tree < input_data.ncols_tot,
                                                           input_data.X_row_major.data(),
                                                           input_data.ncols_numeric,
+                                                          workspace.split_scratch.buffer_x.data(),
                                                           input_data.Xr.data(),
                                                           input_data.Xr_ind.data(),
                                                           input_data.Xr_indptr.data(),
@@ -781,10 +843,11 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
                             goto terminal_statistics;
 
                         if (
-                            model_params.missing_action == Fail
-                             ||
-                            (model_params.missing_action == Impute && input_data.Xc_indptr == NULL)
-                        ) /* data is already split in this case */
+                            !used_hist &&
+                            (model_params.missing_action == Fail
+                              ||
+                             (model_params.missing_action == Impute && input_data.Xc_indptr == NULL))
+                        ) /* data is already split in this case (the histogram search does not sort it) */
                         {
                             if (model_params.missing_action == Impute)
                             {
@@ -821,6 +884,7 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
                                                  model_params.ncols_per_tree < input_data.ncols_tot,
                                                  input_data.X_row_major.data(),
                                                  input_data.ncols_numeric,
+                                                 workspace.split_scratch.buffer_x.data(),
                                                  input_data.Xr.data(),
                                                  input_data.Xr_ind.data(),
                                                  input_data.Xr_indptr.data());
@@ -842,9 +906,11 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
                                                           model_params.ncols_per_tree < input_data.ncols_tot,
                                                           input_data.X_row_major.data(),
                                                           input_data.ncols_numeric,
+                                                          workspace.split_scratch.buffer_x.data(),
                                                           input_data.Xr.data(),
                                                           input_data.Xr_ind.data(),
                                                           input_data.Xr_indptr.data(),
+                                                          workspace.split_scratch.buffer_w.data(),
                                                           workspace.weights_arr);
                         else
                             workspace.this_gain =
@@ -864,9 +930,11 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
                                                           model_params.ncols_per_tree < input_data.ncols_tot,
                                                           input_data.X_row_major.data(),
                                                           input_data.ncols_numeric,
+                                                          workspace.split_scratch.buffer_x.data(),
                                                           input_data.Xr.data(),
                                                           input_data.Xr_ind.data(),
                                                           input_data.Xr_indptr.data(),
+                                                          workspace.split_scratch.buffer_w.data(),
                                                           workspace.weights_map);
                     }
 
@@ -956,7 +1024,8 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
                                                                   input_data.categ_data + trees.back().col_num * input_data.nrows, input_data.ncat[trees.back().col_num],
                                                                   &workspace.best_cat_mode,
                                                                   workspace.buffer_szt.data(),
-                                                                  workspace.buffer_dbl.data(), trees.back().chosen_cat, workspace.this_split_categ.data(),
+                                                                  workspace.buffer_dbl.data(), workspace.split_scratch.buffer_cnt.data(),
+                                                                  trees.back().chosen_cat, workspace.this_split_categ.data(),
                                                                   workspace.buffer_chr.data(), workspace.criterion, model_params.min_gain,
                                                                   model_params.all_perm, model_params.missing_action, model_params.cat_split_type,
                                                                   workspace.weights_arr);
@@ -967,7 +1036,8 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
                                                                   input_data.categ_data + trees.back().col_num * input_data.nrows, input_data.ncat[trees.back().col_num],
                                                                   &workspace.best_cat_mode,
                                                                   workspace.buffer_szt.data(),
-                                                                  workspace.buffer_dbl.data(), trees.back().chosen_cat, workspace.this_split_categ.data(),
+                                                                  workspace.buffer_dbl.data(), workspace.split_scratch.buffer_cnt.data(),
+                                                                  trees.back().chosen_cat, workspace.this_split_categ.data(),
                                                                   workspace.buffer_chr.data(), workspace.criterion, model_params.min_gain,
                                                                   model_params.all_perm, model_params.missing_action, model_params.cat_split_type,
                                                                   workspace.weights_map);
@@ -1038,7 +1108,8 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
                                                                   input_data.categ_data + trees.back().col_num * input_data.nrows, input_data.ncat[trees.back().col_num],
                                                                   &workspace.best_cat_mode,
                                                                   workspace.buffer_szt.data(),
-                                                                  workspace.buffer_dbl.data(), trees.back().chosen_cat, trees.back().cat_split.data(),
+                                                                  workspace.buffer_dbl.data(), workspace.split_scratch.buffer_cnt.data(),
+                                                                  trees.back().chosen_cat, trees.back().cat_split.data(),
                                                                   workspace.buffer_chr.data(), workspace.criterion, model_params.min_gain,
                                                                   model_params.all_perm, model_params.missing_action, model_params.cat_split_type,
                                                                   workspace.weights_arr);
@@ -1049,7 +1120,8 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
                                                                   input_data.categ_data + trees.back().col_num * input_data.nrows, input_data.ncat[trees.back().col_num],
                                                                   &workspace.best_cat_mode,
                                                                   workspace.buffer_szt.data(),
-                                                                  workspace.buffer_dbl.data(), trees.back().chosen_cat, trees.back().cat_split.data(),
+                                                                  workspace.buffer_dbl.data(), workspace.split_scratch.buffer_cnt.data(),
+                                                                  trees.back().chosen_cat, trees.back().cat_split.data(),
                                                                   workspace.buffer_chr.data(), workspace.criterion, model_params.min_gain,
                                                                   model_params.all_perm, model_params.missing_action, model_params.cat_split_type,
                                                                   workspace.weights_map);
@@ -1088,6 +1160,11 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
     /* if it hasn't reached the limit, continue splitting from here */
     follow_branches:
     {
+        /* the branches can subtract histograms from this node's only if they partition its rows */
+        if (input_data.X_binned != NULL)
+            workspace.hist_levels[curr_depth].can_subtract = !(model_params.missing_action == Divide &&
+                                                               workspace.st_NA < workspace.end_NA);
+
         /* add another round of separation depth for distance */
         if (model_params.calc_dist && curr_depth > 0)
             add_separation_step(workspace, input_data, (double)(-1));
@@ -1102,9 +1179,13 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
                                            workspace.end - workspace.st + 1);
         }
         
+        /* rows with missing values that go to both branches can't be kept sorted for either of them */
+        if (model_params.missing_action == Divide && workspace.st_NA < workspace.end_NA)
+            workspace.presorted_valid = false;
+
         size_t tree_from = trees.size() - 1;
-        std::unique_ptr<RecursionState>
-        recursion_state(new RecursionState(workspace, model_params.missing_action != Fail));
+        size_t end_node = workspace.end;
+        workspace.recursion_arena.push_state(workspace, model_params.missing_action != Fail);
         trees.back().score = -1;
 
         /* compute statistics for NAs and remember recursion indices/weights */
@@ -1222,6 +1303,9 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
             workspace.end = workspace.split_ix - 1;
         }
 
+        /* keep the rows of each branch sorted by every numeric column, if using presorted indices */
+        partition_presorted(workspace, input_data.ncols_numeric, end_node);
+
         /* Depending on the scoring metric, might need to calculate fractions of data and volume */
         if (model_params.scoring_metric != Depth && !is_boxed_metric(model_params.scoring_metric))
         {
@@ -1447,104 +1531,8 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
         trees.back().tree_left = trees.size();
         trees.emplace_back();
         if (impute_nodes != NULL) impute_nodes->emplace_back(tree_from);
-        split_itree_recursive<InputData, WorkerMemory, ldouble_safe>(
-                              trees,
-                              workspace,
-                              input_data,
-                              model_params,
-                              impute_nodes,
-                              curr_depth + 1);
-
-
-        /* right branch */
-        recursion_state->restore_state(workspace);
-        if (is_boxed_metric(model_params.scoring_metric))
-        {
-            if (trees[tree_from].col_type == Numeric)
-                workspace.density_calculator.pop_bdens(trees[tree_from].col_num);
-            else
-                workspace.density_calculator.pop_bdens_cat(trees[tree_from].col_num);
-        }
-        else if (model_params.scoring_metric != Depth)
-        {
-            workspace.density_calculator.pop();
-        }
-        if (model_params.missing_action != Fail)
-        {
-            switch(model_params.missing_action)
-            {
-                case Impute:
-                {
-                    if (trees[tree_from].pct_tree_left >= .5)
-                        workspace.st = workspace.end_NA;
-                    else
-                        workspace.st = workspace.st_NA;
-                    break;
-                }
-
-                case Divide:
-                {
-                    if (!workspace.changed_weights && workspace.st_NA < workspace.end_NA)
-                    {
-                        workspace.changed_weights = true;
-
-                        if (!workspace.weights_arr.empty()) {
-                            for (size_t row = workspace.st_NA; row <= workspace.end; row++)
-                                workspace.weights_arr[workspace.ix_arr[row]] = 1;
-                        }
-
-                        else {
-                            for (size_t row = workspace.st_NA; row <= workspace.end; row++)
-                                workspace.weights_map[workspace.ix_arr[row]] = 1;
-                        }
-                    }
-
-                    if (!workspace.weights_arr.empty())
-                        for (size_t row = workspace.st_NA; row < workspace.end_NA; row++)
-                            workspace.weights_arr[workspace.ix_arr[row]] *= (1. - trees[tree_from].pct_tree_left);
-                    else
-                        for (size_t row = workspace.st_NA; row < workspace.end_NA; row++)
-                            workspace.weights_map[workspace.ix_arr[row]] *= (1. - trees[tree_from].pct_tree_left);
-                    workspace.st = workspace.st_NA;
-                    break;
-                }
-
-                default:
-                {
-                    unexpected_error();
-                    break;
-                }
-            }
-        }
-
-        else
-        {
-            workspace.st = workspace.split_ix;
-        }
-
-        trees[tree_from].tree_right = trees.size();
-        trees.emplace_back();
-        if (impute_nodes != NULL) impute_nodes->emplace_back(tree_from);
-        split_itree_recursive<InputData, WorkerMemory, ldouble_safe>(
-                              trees,
-                              workspace,
-                              input_data,
-                              model_params,
-                              impute_nodes,
-                              curr_depth + 1);
-        if (is_boxed_metric(model_params.scoring_metric))
-        {
-            if (trees[tree_from].col_type == Numeric)
-                workspace.density_calculator.pop_bdens_right(trees[tree_from].col_num);
-            else
-                workspace.density_calculator.pop_bdens_cat_right(trees[tree_from].col_num);
-        }
-        else if (model_params.scoring_metric != Depth)
-        {
-            workspace.density_calculator.pop_right();
-        }
     }
-    return;
+    return true;
 
     /* if it reached the limit, calculate terminal statistics */
     terminal_statistics:
@@ -1656,4 +1644,216 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
             add_from_impute_node(impute_nodes->back(), workspace, input_data);
     }
 
+    return false;
+}
+
+/* Restores the workspace as it was before following the left branch of node 'tree_from', and
+   sets it up for the right branch, which is added as a new node */
+template <class InputData, class WorkerMemory>
+void split_itree_right(std::vector<IsoTree>     &trees,
+                       WorkerMemory             &workspace,
+                       InputData                &,
+                       ModelParams              &model_params,
+                       std::vector<ImputeNode> *impute_nodes,
+                       size_t                   tree_from)
+{
+    workspace.recursion_arena.pop_state(workspace);
+    if (is_boxed_metric(model_params.scoring_metric))
+    {
+        if (trees[tree_from].col_type == Numeric)
+            workspace.density_calculator.pop_bdens(trees[tree_from].col_num);
+        else
+            workspace.density_calculator.pop_bdens_cat(trees[tree_from].col_num);
+    }
+    else if (model_params.scoring_metric != Depth)
+    {
+        workspace.density_calculator.pop();
+    }
+    if (model_params.missing_action != Fail)
+    {
+        switch(model_params.missing_action)
+        {
+            case Impute:
+            {
+                if (trees[tree_from].pct_tree_left >= .5)
+                    workspace.st = workspace.end_NA;
+                else
+                    workspace.st = workspace.st_NA;
+                break;
+            }
+
+            case Divide:
+            {
+                if (!workspace.changed_weights && workspace.st_NA < workspace.end_NA)
+                {
+                    workspace.changed_weights = true;
+
+                    if (!workspace.weights_arr.empty()) {
+                        for (size_t row = workspace.st_NA; row <= workspace.end; row++)
+                            workspace.weights_arr[workspace.ix_arr[row]] = 1;
+                    }
+
+                    else {
+                        for (size_t row = workspace.st_NA; row <= workspace.end; row++)
+                            workspace.weights_map[workspace.ix_arr[row]] = 1;
+                    }
+                }
+
+                if (!workspace.weights_arr.empty())
+                    for (size_t row = workspace.st_NA; row < workspace.end_NA; row++)
+                        workspace.weights_arr[workspace.ix_arr[row]] *= (1. - trees[tree_from].pct_tree_left);
+                else
+                    for (size_t row = workspace.st_NA; row < workspace.end_NA; row++)
+                        workspace.weights_map[workspace.ix_arr[row]] *= (1. - trees[tree_from].pct_tree_left);
+                workspace.st = workspace.st_NA;
+                break;
+            }
+
+            default:
+            {
+                unexpected_error();
+                break;
+            }
+        }
+    }
+
+    else
+    {
+        workspace.st = workspace.split_ix;
+    }
+
+    trees[tree_from].tree_right = trees.size();
+    trees.emplace_back();
+    if (impute_nodes != NULL) impute_nodes->emplace_back(tree_from);
+}
+
+/* Undoes the changes from node 'tree_from' in the density calculator after both of its branches are done */
+template <class WorkerMemory>
+void finish_itree_node(std::vector<IsoTree>     &trees,
+                       WorkerMemory             &workspace,
+                       ModelParams              &model_params,
+                       size_t                   tree_from)
+{
+    if (is_boxed_metric(model_params.scoring_metric))
+    {
+        if (trees[tree_from].col_type == Numeric)
+            workspace.density_calculator.pop_bdens_right(trees[tree_from].col_num);
+        else
+            workspace.density_calculator.pop_bdens_cat_right(trees[tree_from].col_num);
+    }
+    else if (model_params.scoring_metric != Depth)
+    {
+        workspace.density_calculator.pop_right();
+    }
+}
+
+/* Grows a tree from the root node at the end of 'trees', in the same order as a recursive depth-first
+   procedure would, but through an explicit stack kept in the workspace so that deep trees do not
+   overflow the call stack. The root node might be a branch of a larger tree, at depth 'root_depth'. */
+template <class InputData, class WorkerMemory, class ldouble_safe>
+void grow_itree(std::vector<IsoTree>     &trees,
+                WorkerMemory             &workspace,
+                InputData                &input_data,
+                ModelParams              &model_params,
+                std::vector<ImputeNode> *impute_nodes,
+                size_t                   root_depth)
+{
+    std::vector<GrowFrame> &stack = workspace.grow_stack;
+    stack.clear();
+    workspace.recursion_arena.clear();
+    workspace.fork_states.clear();
+    stack.push_back({trees.size() - 1, root_depth, SplitNode, false});
+
+    while (!stack.empty())
+    {
+        if (interrupt_switch) return;
+        GrowFrame frame = stack.back();
+        switch (frame.stage)
+        {
+            case SplitNode:
+            {
+                bool is_fork = workspace.end - workspace.st + 1 > NODE_TASK_MIN_ROWS;
+                if (split_itree_node<InputData, WorkerMemory, ldouble_safe>(
+                                     trees, workspace, input_data, model_params,
+                                     impute_nodes, frame.depth))
+                {
+                    if (is_fork) fork_node(workspace);
+                    stack.back().stage = FollowRight;
+                    stack.back().is_fork = is_fork;
+                    stack.push_back({trees.size() - 1, frame.depth + 1, SplitNode, false});
+                }
+                else
+                {
+                    stack.pop_back();
+                }
+                break;
+            }
+
+            case FollowRight:
+            {
+                if (frame.is_fork) resume_fork_right(workspace);
+                split_itree_right(trees, workspace, input_data, model_params, impute_nodes, frame.node);
+                stack.back().stage = FinishNode;
+                stack.push_back({trees.size() - 1, frame.depth + 1, SplitNode, false});
+                break;
+            }
+
+            case FinishNode:
+            {
+                finish_itree_node(trees, workspace, model_params, frame.node);
+                stack.pop_back();
+                break;
+            }
+        }
+    }
+}
+
+/* Grows the node of a task in a workspace that was set up for it through 'restore_node_task'. If the node
+   has more than 'node_task_rows' rows, it is split here, and its branches are saved as new tasks in the
+   same state in which 'grow_itree' would start them. Otherwise, the whole sub-tree under it is grown in
+   this task. */
+template <class InputData, class WorkerMemory, class ldouble_safe>
+void grow_itree_task(NodeTask<WorkerMemory>  &task,
+                     WorkerMemory            &workspace,
+                     InputData               &input_data,
+                     ModelParams             &model_params,
+                     bool                    build_imputer)
+{
+    size_t tree_from = task.n_chain;
+    task.trees.resize(tree_from + 1);
+    std::vector<ImputeNode> *impute_nodes = NULL;
+    if (build_imputer)
+    {
+        impute_nodes = &task.impute_nodes;
+        impute_nodes->swap(task.impute_chain);
+        impute_nodes->emplace_back(tree_from? (tree_from - 1) : (size_t)0);
+    }
+
+    if (task.nrows <= model_params.node_task_rows)
+    {
+        grow_itree<InputData, WorkerMemory, ldouble_safe>(
+                   task.trees, workspace, input_data, model_params,
+                   impute_nodes, task.depth);
+        return;
+    }
+
+    workspace.recursion_arena.clear();
+    workspace.fork_states.clear();
+    if (!split_itree_node<InputData, WorkerMemory, ldouble_safe>(
+                          task.trees, workspace, input_data, model_params,
+                          impute_nodes, task.depth))
+        return;
+    fork_node(workspace);
+
+    task.left = std::unique_ptr<NodeTask<WorkerMemory>>(new NodeTask<WorkerMemory>());
+    capture_node_task(*task.left, workspace, input_data, impute_nodes, tree_from + 1, task.depth + 1);
+    resume_fork_right(workspace);
+    split_itree_right(task.trees, workspace, input_data, model_params, impute_nodes, tree_from);
+    task.right = std::unique_ptr<NodeTask<WorkerMemory>>(new NodeTask<WorkerMemory>());
+    capture_node_task(*task.right, workspace, input_data, impute_nodes, tree_from + 1, task.depth + 1);
+
+    /* the branches are added by their own tasks */
+    task.trees.resize(tree_from + 1);
+    if (impute_nodes != NULL)
+        impute_nodes->resize(tree_from + 1);
 }
@@ -88,6 +88,7 @@
 #include <cmath>
 #include <climits>
 #include <cstring>
+#include <cstdio>
 #include <cerrno>
 #include <vector>
 #include <iterator>
@@ -105,6 +106,8 @@
 #include <iostream>
 #include <string>
 #include <regex>
+#include <functional>
+#include <atomic>
 
 #ifdef _FOR_R
     extern "C" {
@@ -312,6 +315,19 @@ using std::memcpy;
 /* Some aggregation functions will prefer more precise data types when the data is large */
 #define THRESHOLD_LONG_DOUBLE (size_t)1e6
 
+/* When finding guided splits through histograms, numeric columns are assigned to at most 'HIST_MAX_BINS'
+   bins plus one for missing values, with the limits determined from at most 'HIST_SAMPLE_ROWS' rows.
+   Nodes with fewer than 'HIST_MIN_ROWS' rows are faster to split by sorting their values instead. */
+#define HIST_MAX_BINS 255
+#define HIST_NA_BIN 255
+#define HIST_SAMPLE_ROWS (size_t)262144
+#define HIST_MIN_ROWS (size_t)1024
+
+/* Nodes with more than this many rows draw a seed for each of their branches, which start from them instead of
+   from what the nodes before them left in the random number generator, so that the branches can be grown as
+   separate tasks (with 'node_task_rows') with the same result as when growing them one after the other */
+#define NODE_TASK_MIN_ROWS (size_t)8192
+
 /* Types used through the package */
 typedef enum  NewCategAction {Weighted=0,  Smallest=11,    Random=12}  NewCategAction; /* Weighted means Impute in the extended model */
 typedef enum  MissingAction  {Divide=21,   Impute=22,      Fail=0}     MissingAction;  /* Divide is only for non-extended model */
@@ -322,6 +338,7 @@ typedef enum  UseDepthImp    {Lower=71,    Higher=0,       Same=72}    UseDepthI
 typedef enum  WeighImpRows   {Inverse=0,   Prop=81,        Flat=82}    WeighImpRows;   /* For NA imputation */
 typedef enum  ScoringMetric  {Depth=0,     Density=92,     BoxedDensity=94, BoxedDensity2=96, BoxedRatio=95,
                               AdjDepth=91, AdjDensity=93}              ScoringMetric;
+typedef enum  SplitSearch    {SortedSearch=0, HistogramSearch=101, PresortedSearch=102} SplitSearch;    /* For guided splits */
 
 /* These are only used internally */
 typedef enum  ColCriterion   {Uniformly=0, ByRange=1, ByVar=2, ByKurt=3} ColCriterion;   /* For proportional choices */
@@ -452,8 +469,271 @@ typedef struct TreesIndexer {
     TreesIndexer() = default;
 } TreesIndexer;
 
+/* Flattened version of a single-variable model, which can be used for faster predictions
+   on numeric-only data without missing values. Nodes from all the trees are stored in the
+   same contiguous arrays, with each tree starting at position 'tree_offsets[tree]', and with
+   the children of a non-terminal node placed next to each other, so that the right branch
+   of a node is always at position 'tree_left+1'. */
+typedef struct CompiledIsoForest {
+    std::vector<uint32_t> col_num;       /* holds the terminal node number for terminal nodes */
+    std::vector<uint32_t> tree_left;     /* relative to the start of the tree, zero for terminal nodes */
+    std::vector<double>   num_split;     /* empty when using float thresholds */
+    std::vector<float>    num_split_f;   /* empty when using double thresholds */
+    std::vector<double>   score;
+    std::vector<size_t>   tree_offsets;  /* has 'ntrees+1' entries */
+    ScoringMetric         scoring_metric;
+    double                exp_avg_depth;
+    size_t                ncols_numeric; /* minimum number of columns that the data must have */
+    bool                  float_thresholds;
+
+    CompiledIsoForest() = default;
+} CompiledIsoForest;
+
+/* Flattened version of an extended model, for faster predictions on numeric-only data without
+   missing values. Trees are laid out in the same way as in 'CompiledIsoForest', and each node
+   takes a fixed number of entries in two arrays, so that evaluating a node does not require
+   following pointers to the arrays of the hyperplane:
+     - 'ndim+2' entries in 'node_idx': the left child (relative to the start of the tree, zero
+       for terminal nodes), then the number of columns in the hyperplane (or the terminal node
+       number for terminal nodes), then the column indices.
+     - '2*ndim+1' entries in 'node_val': the split point (or the score for terminal nodes),
+       then the coefficients, then the means.
+   Nodes with fewer than 'ndim' columns have the remaining entries set to zero. */
+typedef struct CompiledExtIsoForest {
+    std::vector<uint32_t> node_idx;
+    std::vector<double>   node_val;
+    std::vector<size_t>   tree_offsets;  /* has 'ntrees+1' entries, counted in nodes */
+    ScoringMetric         scoring_metric;
+    double                exp_avg_depth;
+    size_t                ncols_numeric; /* minimum number of columns that the data must have */
+    size_t                ndim;          /* maximum number of columns in a hyperplane */
+
+    CompiledExtIsoForest() = default;
+} CompiledExtIsoForest;
+
+/* Read-only view of a single-variable model in its serialized form (as produced by
+   'serialize_IsoForest'), which can be used for predictions without de-serializing it.
+   The nodes are read directly from the serialized bytes, which must outlive the view.
+   When none of the nodes has a categorical subset split, all of them have the same size
+   in bytes and are addressed by position within each tree; otherwise, a table of node
+   pointers is built when creating the view. */
+typedef struct IsoForestView {
+    NewCategAction             new_cat_action;
+    CategSplit                 cat_split_type;
+    MissingAction              missing_action;
+    ScoringMetric              scoring_metric;
+    double                     exp_avg_depth;
+    double                     exp_avg_sep;
+    size_t                     orig_sample_size;
+    bool                       has_range_penalty;
+    std::vector<const char*>   trees;           /* pointer to the first node of each tree */
+    std::vector<const char*>   nodes;           /* empty when all nodes have the same size */
+    std::vector<size_t>        tree_first_node; /* empty when all nodes have the same size */
+
+    IsoForestView() = default;
+} IsoForestView;
+
+/* Arrays of a model in flat format, which are stored either with 64-bit indices and 'double'
+   values, or with 32-bit indices and 'float' values.
+   For terminal nodes, 'tree_right' holds the terminal node number instead of a child index. */
+template <class idx_t, class val_t>
+struct FlatModelArrays {
+    const idx_t  *tree_offsets;    /* has 'ntrees+1' entries */
+    const idx_t  *tree_left;       /* relative to the start of the tree, zero for terminal nodes */
+    const idx_t  *tree_right;
+    const val_t  *split;
+    const val_t  *score;
+    const val_t  *range_low;
+    const val_t  *range_high;
+    const val_t  *pct_tree_left;   /* only for single-variable models */
+    const idx_t  *col_num;         /* only for single-variable models */
+    const idx_t  *coef_offsets;    /* only for extended models, has 'nnodes+1' entries */
+    const idx_t  *coef_col;        /* only for extended models */
+    const val_t  *coef;            /* only for extended models */
+    const val_t  *mean;            /* only for extended models */
+    const val_t  *fill_val;        /* only for extended models */
+};
+
+/* Model stored in a flat format made up of aligned arrays, as produced by 'serialize_flat_model',
+   which can be memory-mapped from a file and used for predictions in place. All the pointers point
+   into the same underlying bytes - when the model is loaded from a file, 'mapped_file' keeps the
+   mapping alive, so copies of this object can be shared between threads without copying the arrays. */
+typedef struct FlatModel {
+    std::shared_ptr<void>  mapped_file;     /* empty when the model is over user-supplied bytes */
+    bool                   is_extended;
+    bool                   single_precision; /* whether the arrays are in 'arrays_f' instead of 'arrays' */
+    MissingAction          missing_action;
+    NewCategAction         new_cat_action;
+    CategSplit             cat_split_type;
+    ScoringMetric          scoring_metric;
+    bool                   has_range_penalty;
+    double                 exp_avg_depth;
+    double                 exp_avg_sep;
+    size_t                 orig_sample_size;
+    size_t                 ntrees;
+    size_t                 nnodes;
+    size_t                 ncols_numeric;   /* minimum number of columns that the data must have */
+    FlatModelArrays<uint64_t, double> arrays;
+    FlatModelArrays<uint32_t, float>  arrays_f;
+
+    FlatModel() = default;
+} FlatModel;
+
+/* Single-variable model arranged for evaluating all of the trees feature-by-feature instead of
+   node-by-node (as in the QuickScorer algorithm for ranking forests). The split conditions from
+   all trees are grouped by column and sorted by threshold, and each tree keeps a bitvector of the
+   terminal nodes (ordered from left to right) that a row can still reach. Each time a row goes to
+   the right branch of a node, the terminal nodes under its left branch are cleared from the tree's
+   bitvector, and once all the columns are processed, the lowest bit that remains set in each tree
+   corresponds to the terminal node in which the row ends up. Nodes whose left branch spans more
+   than one word of the bitvector have one entry per word, all with the same threshold. */
+typedef struct BitvectorIsoForest {
+    std::vector<double>   thresholds;       /* sorted in ascending order within each column */
+    std::vector<uint32_t> cond_word;        /* position of the word to modify among all bitvectors */
+    std::vector<uint64_t> cond_mask;        /* mask that clears the terminal nodes under the left branch */
+    std::vector<size_t>   col_offsets;      /* has 'ncols_numeric+1' entries */
+    std::vector<double>   leaf_score;       /* terminal nodes of each tree, from left to right */
+    std::vector<uint32_t> leaf_terminal;    /* terminal node numbers as output by 'predict_iforest' */
+    std::vector<size_t>   leaf_offsets;     /* has 'ntrees+1' entries */
+    size_t                words_per_tree;   /* number of 64-bit words in the bitvector of each tree */
+    ScoringMetric         scoring_metric;
+    double                exp_avg_depth;
+    size_t                ncols_numeric;    /* minimum number of columns that the data must have */
+
+    BitvectorIsoForest() = default;
+} BitvectorIsoForest;
+
+/* Single-variable model in which the split thresholds are replaced by their positions among the
+   sorted distinct thresholds of each column, for evaluating rows that have been converted to bin
+   indices beforehand. A value 'x' is assigned to bin 'b' when exactly 'b' distinct thresholds of
+   its column are smaller than it, so that 'x <= threshold[k]' if and only if 'b <= k'. Bin
+   indices fit in one byte when no column has more than 255 distinct thresholds, and in two bytes
+   otherwise. The trees are laid out in the same way as in 'CompiledIsoForest'. */
+typedef struct BinPlan {
+    std::vector<double>   thresholds;    /* distinct thresholds of each column, in ascending order */
+    std::vector<size_t>   col_offsets;   /* has 'ncols_numeric+1' entries */
+    std::vector<uint32_t> col_num;       /* holds the terminal node number for terminal nodes */
+    std::vector<uint32_t> tree_left;     /* relative to the start of the tree, zero for terminal nodes */
+    std::vector<uint16_t> split_bin;     /* position of the threshold among those of its column */
+    std::vector<double>   score;
+    std::vector<size_t>   tree_offsets;  /* has 'ntrees+1' entries */
+    ScoringMetric         scoring_metric;
+    double                exp_avg_depth;
+    size_t                ncols_numeric; /* number of columns in the binned data */
+    bool                  wide_bins;     /* whether bin indices need 'uint16_t' instead of 'uint8_t' */
+
+    BinPlan() = default;
+} BinPlan;
+
+/* Everything that is needed for scoring single rows, prepared in advance so that scoring does not
+   need to allocate memory or enter parallel regions. The model objects are not copied, so they
+   must outlive the context. */
+typedef struct PredictionContext {
+    const IsoForest      *model_outputs = NULL;
+    const ExtIsoForest   *model_outputs_ext = NULL;
+    CompiledIsoForest    compiled;           /* only used when 'use_compiled=true' */
+    CompiledExtIsoForest compiled_ext;       /* only used when 'use_compiled=true' */
+    bool                 use_compiled = false;
+    bool                 standardize = true;
+    size_t               ntrees = 0;
+
+    PredictionContext() = default;
+} PredictionContext;
+
+/* Interface for running the parallel loops of the library on threads that are managed elsewhere,
+   as an alternative to creating OpenMP thread teams. An executor is set for the calling thread
+   through 'ScopedExecutor', after which fitting, prediction, distance calculations, imputation,
+   and indexer building will submit their parallel loops to it, ignoring the 'nthreads' argument. */
+class ISOTREE_EXPORTED Executor
+{
+public:
+    virtual ~Executor() = default;
+    /* Determines how many thread-local buffers get allocated for the loops */
+    virtual int num_workers() const noexcept = 0;
+    /* Must call 'task(ix, worker_id)' once for each 'ix' in [0, n), with 'worker_id' in
+       [0, num_workers()), without two calls sharing a 'worker_id' running at the same time,
+       and return once all of them have finished, rethrowing an exception if any task threw. */
+    virtual void parallel_for(size_t n, const std::function<void(size_t, int)> &task) = 0;
+};
+
+/* Persistent pool of threads with work-stealing, in which the calling thread also takes part */
+class ISOTREE_EXPORTED ThreadPoolExecutor : public Executor
+{
+public:
+    explicit ThreadPoolExecutor(int nthreads);
+    ~ThreadPoolExecutor();
+    ThreadPoolExecutor(const ThreadPoolExecutor&) = delete;
+    ThreadPoolExecutor& operator=(const ThreadPoolExecutor&) = delete;
+    int num_workers() const noexcept override;
+    void parallel_for(size_t n, const std::function<void(size_t, int)> &task) override;
+private:
+    struct Pool;
+    std::unique_ptr<Pool> pool;
+};
+
+/* Runs the loops as OpenMP parallel regions, same as when there is no executor */
+class ISOTREE_EXPORTED OpenMPExecutor : public Executor
+{
+public:
+    explicit OpenMPExecutor(int nthreads);
+    int num_workers() const noexcept override;
+    void parallel_for(size_t n, const std::function<void(size_t, int)> &task) override;
+private:
+    int nthreads;
+};
+
+/* Sets the executor for the calling thread during its lifetime, restoring the previous one after */
+class ISOTREE_EXPORTED ScopedExecutor
+{
+public:
+    explicit ScopedExecutor(Executor *executor) noexcept;
+    ~ScopedExecutor();
+    ScopedExecutor(const ScopedExecutor&) = delete;
+    ScopedExecutor& operator=(const ScopedExecutor&) = delete;
+private:
+    Executor *previous;
+};
+
+
+/* Settings that stay fixed throughout a prediction call, which are passed as template arguments
+   to the traversal kernels so that they do not need to be checked at every node */
+enum NumericConfig {DenseRowMajor, DenseColMajor, SparseCSR, SparseCSC};
+enum CategConfig {CategNone, CategSingle, CategSubSetRandom, CategSubSetSmallest};
 
 /* Structs that are only used internally */
+
+/* Bins to which the values of the dense numeric columns are assigned when finding guided splits through
+   histograms. Value 'x' in column 'col' goes to the first bin 'b' with 'x <= bin_edges[col*HIST_MAX_BINS + b]',
+   and missing values go to bin 'HIST_NA_BIN'. The last edge of each column is +Inf. */
+struct ColumnBins {
+    std::vector<double>  bin_edges;
+    std::vector<double>  bin_ref; /* value around which the sums of each bin are centered */
+    std::vector<int>     nbins;
+};
+
+/* Weighted sums of the values of a column at a node that fall into a given bin, centered at the
+   'bin_ref' of the bin. The minimum and maximum are only upper/lower bounds when the histogram was
+   obtained by subtracting that of the node's sibling from the parent's. */
+struct HistBin {
+    size_t  cnt;
+    double  w;
+    double  sum;
+    double  ssq;
+    double  xmin;
+    double  xmax;
+};
+
+/* Histograms built at a node currently being split, for each column that it evaluated ('HIST_MAX_BINS+1'
+   entries per column, including missing values). If the node's branches partition its rows (i.e. there
+   are no missing values sent to both), they can obtain their histograms from these ones. */
+struct HistLevel {
+    size_t  st;
+    size_t  end;
+    bool    can_subtract;
+    std::vector<size_t>   cols;
+    std::vector<HistBin>  hists;
+};
+
 template <class real_t, class sparse_ix>
 struct InputData {
     real_t*     numeric_data;
@@ -485,6 +765,14 @@ struct InputData {
     std::vector<double>  Xr;          /* created by this library, only used when calculating full gain */
     std::vector<size_t>  Xr_ind;      /* created by this library, only used when calculating full gain */
     std::vector<size_t>  Xr_indptr;   /* created by this library, only used when calculating full gain */
+
+    bool        is_col_major; /* row-major or strided dense data is fit through per-tree copies of the sampled rows */
+    size_t      ld_numeric;   /* only for dense data, leading dimension of 'numeric_data' */
+    size_t      ld_categ;     /* only for categorical data, leading dimension of 'categ_data' */
+
+    uint8_t*    X_binned;     /* only for histogram splits, bins of 'numeric_data' in column-major order */
+    const ColumnBins* col_bins; /* only for histogram splits */
+    const size_t* presorted_ix; /* only for presorted splits with no sub-sampling, row indices sorted by each column */
 };
 
 
@@ -522,6 +810,7 @@ typedef struct {
     double    prob_pick_col_by_var;
     double    prob_pick_col_by_kurt;
     double    min_gain;
+    SplitSearch     split_search;
     CategSplit      cat_split_type;
     NewCategAction  new_cat_action;
     MissingAction   missing_action;
@@ -541,6 +830,8 @@ typedef struct {
     UseDepthImp   depth_imp;      /* only when building NA imputer */
     WeighImpRows  weigh_imp_rows; /* only when building NA imputer */
     size_t        min_imp_obs;    /* only when building NA imputer */
+
+    size_t node_task_rows; /* nodes with more rows have their branches grown as separate tasks */
 } ModelParams;
 
 template <class sparse_ix, class ldouble_safe>
@@ -781,6 +1072,146 @@ public:
     void restore(const SingleNodeColumnSampler<ldouble_safe, real_t> &other);
 };
 
+/* State to restore before following the right branch of a node. The variable-sized parts are kept
+   in the buffers of the 'RecursionArena' that holds it, and are referenced by their offsets */
+struct RecursionState {
+    size_t  st;
+    size_t  st_NA;
+    size_t  end_NA;
+    size_t  split_ix;
+    size_t  end;
+    size_t  sampler_pos;
+    size_t  n_dropped;
+    bool    changed_weights;
+    bool    full_state;
+    bool    presorted_valid;
+    size_t  ix_arr_offset;
+    size_t  ix_arr_size;
+    size_t  col_weights_offset;
+    size_t  weights_offset;
+};
+
+/* Stack of recursion states for the nodes currently being split in a tree. Since states are restored
+   in the reverse order in which they were saved, the buffers behave as bump allocators: saving a
+   state appends to them and restoring it shrinks them back, so once their capacity has grown large
+   enough for a tree, no further allocations are made. */
+class RecursionArena {
+public:
+    std::vector<RecursionState> states;
+    std::vector<size_t>         buffer_szt;
+    std::vector<double>         buffer_dbl;
+
+    template <class WorkerMemory>
+    void push_state(WorkerMemory &workspace, bool full_state);
+    template <class WorkerMemory>
+    void pop_state(WorkerMemory &workspace);
+    void clear()
+    {
+        this->states.clear();
+        this->buffer_szt.clear();
+        this->buffer_dbl.clear();
+    }
+};
+
+/* Nodes that are pending when growing a tree through an explicit stack */
+enum GrowStage {SplitNode, FollowRight, FinishNode};
+struct GrowFrame {
+    size_t     node;
+    size_t     depth;
+    GrowStage  stage;
+    bool       is_fork; /* whether it was split with seeds for its branches (see 'NODE_TASK_MIN_ROWS') */
+};
+
+/* Node of a tree whose sub-tree is grown as a separate task when using 'node_task_rows'. It holds
+   what the workspace needs in order to resume from that node in any thread (the part of each
+   array that corresponds to the node's rows), and after running, the nodes that the task produced.
+   These start with as many placeholders as there are ancestors in 'impute_chain', so that node
+   numbers match with those of the imputation nodes. Nodes with more than 'node_task_rows' rows
+   produce only themselves and pass their branches to new tasks in 'left' and 'right'. */
+template <class WorkerMemory>
+struct NodeTask {
+    size_t               depth;
+    size_t               st;
+    size_t               nrows;
+    std::vector<size_t>  ix_arr;
+    bool                 changed_weights;
+    bool                 weights_in_map;
+    std::vector<double>  weights;         /* only when 'changed_weights' */
+    bool                 try_all;
+    bool                 presorted_valid;
+    std::vector<size_t>  presorted_ix;    /* only when 'presorted_valid' */
+    decltype(WorkerMemory::col_sampler)        col_sampler;
+    decltype(WorkerMemory::density_calculator) density_calculator;
+    decltype(WorkerMemory::rnd_generator)      rnd_generator;
+    decltype(WorkerMemory::rbin)               rbin;
+    decltype(WorkerMemory::coef_unif)          coef_unif;
+    decltype(WorkerMemory::coef_norm)          coef_norm;
+    std::vector<ImputeNode> impute_chain; /* ancestors from the root, only when building an imputer */
+    size_t               n_chain;
+
+    std::vector<IsoTree>    trees;
+    std::vector<IsoHPlane>  hplanes;
+    std::vector<ImputeNode> impute_nodes;
+    std::unique_ptr<NodeTask<WorkerMemory>> left;
+    std::unique_ptr<NodeTask<WorkerMemory>> right;
+
+    NodeTask() = default;
+    /* the tasks under this one are released one at a time, as deep trees would overflow the call stack otherwise */
+    ~NodeTask()
+    {
+        std::vector<std::unique_ptr<NodeTask<WorkerMemory>>> pending;
+        if (this->left) pending.push_back(std::move(this->left));
+        if (this->right) pending.push_back(std::move(this->right));
+        while (!pending.empty())
+        {
+            std::unique_ptr<NodeTask<WorkerMemory>> task = std::move(pending.back());
+            pending.pop_back();
+            if (task->left) pending.push_back(std::move(task->left));
+            if (task->right) pending.push_back(std::move(task->right));
+        }
+    }
+};
+
+/* What the tasks of a tree share after the tree is set up. When the tree is fit to a copy of its sampled rows,
+   the copy is kept here until its last task is done, as the tasks might run in threads other than the one that
+   made it, and 'tile_data' points to it. */
+template <class WorkerMemory, class InputData>
+struct NodeTaskTree {
+    std::unique_ptr<NodeTask<WorkerMemory>> root;
+    std::vector<double>  kurt_weights;
+    double*              tree_kurtoses;
+    size_t               n_pending;
+    bool                 has_tile;
+    InputData            tile_data;
+    decltype(WorkerMemory::tile_numeric) tile_numeric;
+    decltype(WorkerMemory::tile_categ)   tile_categ;
+    decltype(WorkerMemory::tile_weights) tile_weights;
+    decltype(WorkerMemory::tile_binned)  tile_binned;
+};
+
+/* Scratch space for the split criteria and for the linear combinations of the extended model, which
+   need sorted copies of the node's data or weighted category counts. It is sized before the first
+   tree is split, so that the split search at each node does not need to allocate memory. */
+template <class ldouble_safe>
+struct SplitScratch {
+    std::vector<size_t>        buffer_ix;  /* sorting indices, 'sample_size' */
+    std::vector<double>        buffer_x;   /* sorted/densified values plus full-gain sums, 'sample_size' + 2*'ncols' */
+    std::vector<double>        buffer_w;   /* observation weights, 'sample_size' */
+    std::vector<ldouble_safe>  buffer_cnt; /* weighted category counts, 'max_categ' + 1 */
+
+    void initialize(size_t sample_size, size_t ncols_numeric, int max_categ);
+};
+
+/* State of a node with more than 'NODE_TASK_MIN_ROWS' rows right after it is split. Its right branch starts
+   from it instead of from what the left branch left behind, as a separate task for the right branch would. */
+template <class ldouble_safe, class real_t>
+struct ForkState {
+    uint64_t  seed_right;
+    bool      try_all;
+    ColumnSampler<ldouble_safe> col_sampler;
+    DensityCalculator<ldouble_safe, real_t> density_calculator;
+};
+
 template <class ImputedData, class ldouble_safe, class real_t>
 struct WorkerMemory {
     std::vector<size_t>  ix_arr;
@@ -807,6 +1238,8 @@ struct WorkerMemory {
     ColumnSampler<ldouble_safe> col_sampler; /* columns can get eliminated, keep a copy for each thread */
     SingleNodeColumnSampler<ldouble_safe, real_t> node_col_sampler;
     SingleNodeColumnSampler<ldouble_safe, real_t> node_col_sampler_backup;
+    std::vector<bool>    col_is_taken;    /* columns already tried at a node, when sampling them uniformly */
+    hashed_set<size_t>   col_is_taken_s;  /* same, when there are too many columns for 'col_is_taken' */
 
     /* for split criterion */
     std::vector<double>  buffer_dbl;
@@ -819,6 +1252,7 @@ struct WorkerMemory {
     double               this_split_point;
     int                  this_categ;
     std::vector<signed char> this_split_categ;
+    std::vector<signed char> best_split_categ; /* categories of the best split so far at a node */
     bool                 determine_split;
     std::vector<double>  imputed_x_buffer;
     double               saved_xmedian;
@@ -826,6 +1260,7 @@ struct WorkerMemory {
     int                  saved_cat_mode;
     int                  best_cat_mode;
     std::vector<size_t>  col_indices;    /* only for full gain calculation */
+    SplitScratch<ldouble_safe> split_scratch;
 
     /* for weighted column choices */
     std::vector<double>  node_col_weights;
@@ -853,6 +1288,7 @@ struct WorkerMemory {
     std::vector<double>  ext_fill_new;
     std::vector<int>     chosen_cat;
     std::vector<std::vector<double>> ext_cat_coef;
+    IsoHPlane            hplane_best;    /* best combination found so far at a node, copied to it once it is split */
     UniformMinusOneToOne coef_unif;
     StandardNormalDistr  coef_norm;
     std::vector<double> sample_weights; /* when using weights and split criterion */
@@ -869,6 +1305,29 @@ struct WorkerMemory {
 
     /* for non-depth scoring metric */
     DensityCalculator<ldouble_safe, real_t> density_calculator;
+
+    /* for growing trees without recursion */
+    std::vector<GrowFrame> grow_stack;
+    RecursionArena         recursion_arena;
+    std::vector<ForkState<ldouble_safe, real_t>> fork_states;
+
+    /* when fitting to row-major or strided data with sub-sampling */
+    std::vector<size_t>  tile_rows;
+    std::vector<real_t>  tile_numeric;
+    std::vector<int>     tile_categ;
+    std::vector<real_t>  tile_weights;
+    std::vector<double>  tile_row_major;
+    std::vector<uint8_t> tile_binned;
+
+    /* for guided splits through histograms, indexed by depth */
+    std::vector<HistLevel> hist_levels;
+
+    /* for guided splits with presorted indices: for each numeric column, a copy of 'ix_arr' in which
+       the rows of each node are sorted by that column, with missing values first */
+    std::vector<size_t> presorted_ix;
+    std::vector<size_t> presorted_buffer;
+    std::vector<char>   presorted_side;  /* indexed by row, whether it goes to the right branch */
+    bool                presorted_valid; /* whether the current node is sorted in 'presorted_ix' */
 };
 
 typedef struct WorkerForSimilarity {
@@ -892,28 +1351,6 @@ typedef struct WorkerForPredictCSC {
     std::vector<double> depths;
 } WorkerForPredictCSC;
 
-class RecursionState {
-public:
-    size_t  st;
-    size_t  st_NA;
-    size_t  end_NA;
-    size_t  split_ix;
-    size_t  end;
-    size_t  sampler_pos;
-    size_t  n_dropped;
-    bool    changed_weights;
-    bool    full_state;
-    std::vector<size_t> ix_arr;
-    std::vector<bool>   cols_possible;
-    std::vector<double> col_sampler_weights;
-    std::unique_ptr<double[]> weights_arr;
-
-    RecursionState() = default;
-    template <class WorkerMemory>
-    RecursionState(WorkerMemory &workspace, bool full_state);
-    template <class WorkerMemory>
-    void restore_state(WorkerMemory &workspace);
-};
 
 /* Function prototypes */
 
@@ -923,6 +1360,7 @@ int fit_iforest_internal(
                 IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
                 real_t numeric_data[],  size_t ncols_numeric,
                 int    categ_data[],    size_t ncols_categ,    int ncat[],
+                bool is_col_major, size_t ld_numeric, size_t ld_categ,
                 real_t Xc[], sparse_ix Xc_ind[], sparse_ix Xc_indptr[],
                 size_t ndim, size_t ntry, CoefType coef_type, bool coef_by_prop,
                 real_t sample_weights[], bool with_replacement, bool weight_as_sample,
@@ -937,11 +1375,11 @@ int fit_iforest_internal(
                 double prob_pick_by_full_gain, double prob_pick_by_dens,
                 double prob_pick_col_by_range, double prob_pick_col_by_var,
                 double prob_pick_col_by_kurt,
-                double min_gain, MissingAction missing_action,
+                double min_gain, SplitSearch split_search, MissingAction missing_action,
                 CategSplit cat_split_type, NewCategAction new_cat_action,
                 bool   all_perm, Imputer *imputer, size_t min_imp_obs,
                 UseDepthImp depth_imp, WeighImpRows weigh_imp_rows, bool impute_at_fit,
-                uint64_t random_seed, int nthreads);
+                uint64_t random_seed, size_t node_task_rows, int nthreads);
 template <class real_t, class sparse_ix>
 int fit_iforest(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
                 real_t numeric_data[],  size_t ncols_numeric,
@@ -966,6 +1404,31 @@ int fit_iforest(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
                 UseDepthImp depth_imp, WeighImpRows weigh_imp_rows, bool impute_at_fit,
                 uint64_t random_seed, bool use_long_double, int nthreads);
 template <class real_t, class sparse_ix>
+int fit_iforest(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
+                real_t numeric_data[],  size_t ncols_numeric,
+                int    categ_data[],    size_t ncols_categ,    int ncat[],
+                bool is_col_major, size_t ld_numeric, size_t ld_categ,
+                real_t Xc[], sparse_ix Xc_ind[], sparse_ix Xc_indptr[],
+                size_t ndim, size_t ntry, CoefType coef_type, bool coef_by_prop,
+                real_t sample_weights[], bool with_replacement, bool weight_as_sample,
+                size_t nrows, size_t sample_size, size_t ntrees,
+                size_t max_depth,   size_t ncols_per_tree,
+                bool   limit_depth, bool penalize_range, bool standardize_data,
+                ScoringMetric scoring_metric, bool fast_bratio,
+                bool   standardize_dist, double tmat[],
+                double output_depths[], bool standardize_depth,
+                real_t col_weights[], bool weigh_by_kurt,
+                double prob_pick_by_gain_pl, double prob_pick_by_gain_avg,
+                double prob_pick_by_full_gain, double prob_pick_by_dens,
+                double prob_pick_col_by_range, double prob_pick_col_by_var,
+                double prob_pick_col_by_kurt,
+                double min_gain, SplitSearch split_search, MissingAction missing_action,
+                CategSplit cat_split_type, NewCategAction new_cat_action,
+                bool   all_perm, Imputer *imputer, size_t min_imp_obs,
+                UseDepthImp depth_imp, WeighImpRows weigh_imp_rows, bool impute_at_fit,
+                uint64_t random_seed, bool use_long_double, size_t node_task_rows,
+                bool reorder_nodes_after_fit, int nthreads);
+template <class real_t, class sparse_ix>
 int add_tree(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
              real_t numeric_data[],  size_t ncols_numeric,
              int    categ_data[],    size_t ncols_categ,    int ncat[],
@@ -1021,25 +1484,102 @@ void fit_itree(std::vector<IsoTree>    *tree_root,
                InputData                &input_data,
                ModelParams              &model_params,
                std::vector<ImputeNode> *impute_nodes,
-               size_t                   tree_num);
-
-/* isoforest.cpp */
+               size_t                   tree_num,
+               NodeTaskTree<WorkerMemory, InputData> *task_tree);
 template <class InputData, class WorkerMemory, class ldouble_safe>
-void split_itree_recursive(std::vector<IsoTree>     &trees,
+void fit_itree_from_sample(std::vector<IsoTree>    *tree_root,
+                           std::vector<IsoHPlane>  *hplane_root,
                            WorkerMemory             &workspace,
                            InputData                &input_data,
                            ModelParams              &model_params,
                            std::vector<ImputeNode> *impute_nodes,
-                           size_t                   curr_depth);
+                           NodeTaskTree<WorkerMemory, InputData> *task_tree);
+template <class InputData, class WorkerMemory>
+void allocate_worker_buffers(WorkerMemory &workspace, InputData &input_data, ModelParams &model_params, bool is_ext);
+template <class InputData>
+bool is_contiguous_colmajor(const InputData &input_data);
+template <class InputData, class WorkerMemory>
+void gather_sampled_rows(InputData &tile_data, InputData &input_data,
+                         WorkerMemory &workspace, ModelParams &model_params);
+template <class real_t>
+void copy_to_colmajor(const real_t *restrict src, bool is_col_major, size_t ld,
+                      size_t nrows, size_t ncols, std::vector<real_t> &dst);
+template <class real_t>
+void copy_from_colmajor(const std::vector<real_t> &src, bool is_col_major, size_t ld,
+                        size_t nrows, size_t ncols, real_t *restrict dst);
+template <class real_t>
+void build_column_bins(const real_t *restrict numeric_data, bool is_col_major, size_t ld_numeric,
+                       size_t nrows, size_t ncols, ColumnBins &col_bins, std::vector<uint8_t> &X_binned,
+                       int nthreads);
+template <class T>
+T* get_strided_column(T *data, bool is_col_major, size_t ld, size_t nrows, size_t col, std::vector<T> &buffer);
+template <class real_t>
+void presort_all_columns(real_t *numeric_data, bool is_col_major, size_t ld_numeric,
+                         size_t nrows, size_t ncols, std::vector<size_t> &presorted_ix, int nthreads);
+
+/* isoforest.cpp */
+template <class InputData, class WorkerMemory, class ldouble_safe>
+bool split_itree_node(std::vector<IsoTree>     &trees,
+                      WorkerMemory             &workspace,
+                      InputData                &input_data,
+                      ModelParams              &model_params,
+                      std::vector<ImputeNode> *impute_nodes,
+                      size_t                   curr_depth);
+template <class InputData, class WorkerMemory>
+void split_itree_right(std::vector<IsoTree>     &trees,
+                       WorkerMemory             &workspace,
+                       InputData                &input_data,
+                       ModelParams              &model_params,
+                       std::vector<ImputeNode> *impute_nodes,
+                       size_t                   tree_from);
+template <class WorkerMemory>
+void finish_itree_node(std::vector<IsoTree>     &trees,
+                       WorkerMemory             &workspace,
+                       ModelParams              &model_params,
+                       size_t                   tree_from);
+template <class InputData, class WorkerMemory, class ldouble_safe>
+void grow_itree(std::vector<IsoTree>     &trees,
+                WorkerMemory             &workspace,
+                InputData                &input_data,
+                ModelParams              &model_params,
+                std::vector<ImputeNode> *impute_nodes,
+                size_t                   root_depth);
+template <class InputData, class WorkerMemory, class ldouble_safe>
+void grow_itree_task(NodeTask<WorkerMemory>  &task,
+                     WorkerMemory            &workspace,
+                     InputData               &input_data,
+                     ModelParams             &model_params,
+                     bool                    build_imputer);
 
 /* extended.cpp */
 template <class InputData, class WorkerMemory, class ldouble_safe>
-void split_hplane_recursive(std::vector<IsoHPlane>   &hplanes,
-                            WorkerMemory             &workspace,
-                            InputData                &input_data,
-                            ModelParams              &model_params,
-                            std::vector<ImputeNode> *impute_nodes,
-                            size_t                   curr_depth);
+bool split_hplane_node(std::vector<IsoHPlane>   &hplanes,
+                       WorkerMemory             &workspace,
+                       InputData                &input_data,
+                       ModelParams              &model_params,
+                       std::vector<ImputeNode> *impute_nodes,
+                       size_t                   curr_depth);
+template <class WorkerMemory>
+void split_hplane_right(std::vector<IsoHPlane>   &hplanes,
+                        WorkerMemory             &workspace,
+                        ModelParams              &model_params,
+                        std::vector<ImputeNode> *impute_nodes,
+                        size_t                   hplane_from);
+template <class WorkerMemory>
+void finish_hplane_node(WorkerMemory &workspace, ModelParams &model_params);
+template <class InputData, class WorkerMemory, class ldouble_safe>
+void grow_hplane_tree(std::vector<IsoHPlane>   &hplanes,
+                      WorkerMemory             &workspace,
+                      InputData                &input_data,
+                      ModelParams              &model_params,
+                      std::vector<ImputeNode> *impute_nodes,
+                      size_t                   root_depth);
+template <class InputData, class WorkerMemory, class ldouble_safe>
+void grow_hplane_task(NodeTask<WorkerMemory>  &task,
+                      WorkerMemory            &workspace,
+                      InputData               &input_data,
+                      ModelParams             &model_params,
+                      bool                    build_imputer);
 template <class InputData, class WorkerMemory, class ldouble_safe>
 void add_chosen_column(WorkerMemory &workspace, InputData &input_data, ModelParams &model_params,
                        std::vector<bool> &col_is_taken, hashed_set<size_t> &col_is_taken_s);
@@ -1062,24 +1602,41 @@ void predict_iforest(real_t *restrict numeric_data, int *restrict categ_data,
                      double *restrict output_depths,   sparse_ix *restrict tree_num,
                      double *restrict per_tree_depths,
                      TreesIndexer *indexer);
-template <class real_t, class sparse_ix>
-[[gnu::hot]]
-void traverse_itree_fast(std::vector<IsoTree>  &tree,
-                         IsoForest             &model_outputs,
-                         real_t *restrict      row_numeric_data,
-                         double &restrict      output_depth,
-                         sparse_ix *restrict   tree_num,
-                         double *restrict      tree_depth,
-                         size_t                row) noexcept;
 template <class PredictionData, class sparse_ix>
+bool predict_itree_specialized(PredictionData &prediction_data, size_t nrows, int nthreads,
+                               const IsoForest &model_outputs,
+                               double *restrict output_depths, sparse_ix *restrict tree_num,
+                               double *restrict per_tree_depths);
+template <NumericConfig numeric_config, class PredictionData, class sparse_ix>
+void predict_itree_dispatch_categ(PredictionData &prediction_data, size_t nrows, int nthreads,
+                                  const IsoForest &model_outputs, CategConfig categ_config,
+                                  double *restrict output_depths, sparse_ix *restrict tree_num,
+                                  double *restrict per_tree_depths);
+template <NumericConfig numeric_config, CategConfig categ_config, class PredictionData, class sparse_ix>
+void predict_itree_dispatch_missing(PredictionData &prediction_data, size_t nrows, int nthreads,
+                                    const IsoForest &model_outputs,
+                                    double *restrict output_depths, sparse_ix *restrict tree_num,
+                                    double *restrict per_tree_depths);
+template <NumericConfig numeric_config, CategConfig categ_config, bool impute_missing, bool has_range_penalty,
+          class PredictionData, class sparse_ix>
+#ifndef _FOR_R
+[[gnu::optimize("no-trapping-math"), gnu::optimize("no-math-errno")]]
+#endif
+void predict_itree_kernel(PredictionData &prediction_data, size_t nrows, int nthreads,
+                          const IsoForest &model_outputs,
+                          double *restrict output_depths, sparse_ix *restrict tree_num,
+                          double *restrict per_tree_depths);
+template <NumericConfig numeric_config, CategConfig categ_config, bool impute_missing, bool has_range_penalty,
+          bool missing_as_nan = !impute_missing && (has_range_penalty || numeric_config == SparseCSR || numeric_config == SparseCSC),
+          class PredictionData, class sparse_ix>
 [[gnu::hot]]
-void traverse_itree_no_recurse(std::vector<IsoTree>  &tree,
-                               IsoForest             &model_outputs,
-                               PredictionData        &prediction_data,
-                               double &restrict      output_depth,
-                               sparse_ix *restrict   tree_num,
-                               double *restrict      tree_depth,
-                               size_t                row) noexcept;
+static inline double traverse_itree_specialized(const std::vector<IsoTree> &tree,
+                                                PredictionData            &prediction_data,
+                                                size_t                    row,
+                                                const sparse_ix           *row_st,
+                                                const sparse_ix           *row_end,
+                                                sparse_ix *restrict       tree_num,
+                                                double *restrict          tree_depth) noexcept;
 template <class PredictionData, class sparse_ix, class ImputedData>
 [[gnu::hot]]
 double traverse_itree(std::vector<IsoTree>     &tree,
@@ -1152,6 +1709,9 @@ void add_csc_range_penalty(WorkerForPredictCSC     &workspace,
                            double                  range_low,
                            double                  range_high);
 void throw_unsupported_pred_error();
+void depths_to_scores(double *restrict output_depths, double *restrict per_tree_depths,
+                      size_t nrows, size_t ntrees, double exp_avg_depth,
+                      ScoringMetric scoring_metric, bool standardize);
 template <class PredictionData>
 double extract_spC(const PredictionData &prediction_data, size_t row, size_t col_num) noexcept;
 template <class PredictionData, class sparse_ix>
@@ -1383,6 +1943,33 @@ void calc_var_all_cols(InputData &input_data, WorkerMemory &workspace, ModelPara
 template <class InputData, class WorkerMemory, class ldouble_safe>
 void calc_kurt_all_cols(InputData &input_data, WorkerMemory &workspace, ModelParams &model_params,
                         double *restrict kurtosis, double *restrict saved_xmin, double *restrict saved_xmax);
+template <class InputData, class WorkerMemory, class ldouble_safe>
+bool eval_guided_crit_hist(WorkerMemory &workspace, InputData &input_data, ModelParams &model_params,
+                           size_t col_num, size_t curr_depth, bool as_relative_gain, double &restrict split_point);
+template <class real_t>
+void presort_column(size_t *restrict ix_arr, size_t n, const real_t *restrict x);
+template <class InputData, class WorkerMemory>
+void initialize_presorted(WorkerMemory &workspace, InputData &input_data);
+template <class WorkerMemory>
+bool take_presorted_order(WorkerMemory &workspace, size_t col_num);
+template <class WorkerMemory>
+void partition_presorted(WorkerMemory &workspace, size_t ncols_numeric, size_t end);
+template <class WorkerMemory>
+void start_fork_branch(WorkerMemory &workspace, uint64_t seed);
+template <class WorkerMemory>
+void fork_node(WorkerMemory &workspace);
+template <class WorkerMemory>
+void resume_fork_right(WorkerMemory &workspace);
+template <class InputData, class WorkerMemory>
+void capture_node_task(NodeTask<WorkerMemory> &task, WorkerMemory &workspace, InputData &input_data,
+                       std::vector<ImputeNode> *impute_nodes, size_t n_chain, size_t depth);
+template <class InputData, class WorkerMemory>
+void restore_node_task(NodeTask<WorkerMemory> &task, NodeTaskTree<WorkerMemory, InputData> &task_tree,
+                       WorkerMemory &workspace, InputData &input_data, ModelParams &model_params);
+template <class WorkerMemory, class Node>
+void splice_node_tasks(NodeTask<WorkerMemory> &root, std::vector<Node> NodeTask<WorkerMemory>::*task_nodes,
+                       size_t Node::*node_left, size_t Node::*node_right,
+                       std::vector<Node> &nodes, std::vector<ImputeNode> *impute_nodes);
 bool is_boxed_metric(const ScoringMetric scoring_metric);
 
 
@@ -1571,7 +2158,8 @@ template <class real_t_, class mapping, class ldouble_safe>
 void add_linear_comb_weighted(const size_t ix_arr[], size_t st, size_t end, double *restrict res,
                               const real_t_ *restrict x, double &coef, double x_sd, double x_mean, double &restrict fill_val,
                               MissingAction missing_action, double *restrict buffer_arr,
-                              size_t *restrict buffer_NAs, bool first_run, mapping &restrict w);
+                              size_t *restrict buffer_NAs, double *restrict buffer_w, size_t *restrict buffer_ix,
+                              bool first_run, mapping &restrict w);
 template <class real_t_, class sparse_ix>
 void add_linear_comb(const size_t *restrict ix_arr, size_t st, size_t end, size_t col_num, double *restrict res,
                      const real_t_ *restrict Xc, const sparse_ix *restrict Xc_ind, const sparse_ix *restrict Xc_indptr,
@@ -1581,7 +2169,9 @@ template <class real_t_, class sparse_ix, class mapping, class ldouble_safe>
 void add_linear_comb_weighted(const size_t *restrict ix_arr, size_t st, size_t end, size_t col_num, double *restrict res,
                               const real_t_ *restrict Xc, const sparse_ix *restrict Xc_ind, const sparse_ix *restrict Xc_indptr,
                               double &restrict coef, double x_sd, double x_mean, double &restrict fill_val, MissingAction missing_action,
-                              double *restrict buffer_arr, size_t *restrict buffer_NAs, bool first_run, mapping &restrict w);
+                              double *restrict buffer_arr, size_t *restrict buffer_NAs,
+                              double *restrict buffer_x, double *restrict buffer_w, size_t *restrict buffer_ix,
+                              bool first_run, mapping &restrict w);
 template <class ldouble_safe>
 void add_linear_comb(const size_t *restrict ix_arr, size_t st, size_t end, double *restrict res,
                      const int x[], int ncat, double *restrict cat_coef, double single_cat_coef, int chosen_cat,
@@ -1590,7 +2180,8 @@ void add_linear_comb(const size_t *restrict ix_arr, size_t st, size_t end, doubl
 template <class mapping, class ldouble_safe>
 void add_linear_comb_weighted(const size_t *restrict ix_arr, size_t st, size_t end, double *restrict res,
                               const int x[], int ncat, double *restrict cat_coef, double single_cat_coef, int chosen_cat,
-                              double &restrict fill_val, double &restrict fill_new, size_t *restrict buffer_pos,
+                              double &restrict fill_val, double &restrict fill_new,
+                              size_t *restrict buffer_pos, ldouble_safe *restrict buffer_cnt,
                               NewCategAction new_cat_action, MissingAction missing_action, CategSplit cat_split_type,
                               bool first_run, mapping &restrict w);
 
@@ -1630,15 +2221,17 @@ template <class ldouble_safe>
 double calc_kurtosis(size_t nrows, int x[], int ncat, size_t buffer_cnt[], double buffer_prob[],
                      MissingAction missing_action, CategSplit cat_split_type, RNG_engine &rnd_generator);
 template <class mapping, class ldouble_safe>
-double calc_kurtosis_weighted_internal(std::vector<ldouble_safe> &buffer_cnt, int x[], int ncat,
+double calc_kurtosis_weighted_internal(ldouble_safe *restrict buffer_cnt, int x[], int ncat,
                                        double buffer_prob[], MissingAction missing_action, CategSplit cat_split_type,
                                        RNG_engine &rnd_generator, mapping &restrict w);
 template <class mapping, class ldouble_safe>
 double calc_kurtosis_weighted(size_t ix_arr[], size_t st, size_t end, int x[], int ncat, double buffer_prob[],
+                              ldouble_safe *restrict buffer_cnt,
                               MissingAction missing_action, CategSplit cat_split_type, RNG_engine &rnd_generator,
                               mapping &restrict w);
 template <class real_t, class ldouble_safe>
 double calc_kurtosis_weighted(size_t nrows, int x[], int ncat, double *restrict buffer_prob,
+                              ldouble_safe *restrict buffer_cnt,
                               MissingAction missing_action, CategSplit cat_split_type,
                               RNG_engine &rnd_generator, real_t *restrict w);
 template <class int_t, class ldouble_safe>
@@ -1755,7 +2348,24 @@ template <class mapping, class int_t, class ldouble_safe>
 double find_split_dens_longform_weighted(int *restrict x, int ncat, size_t *restrict ix_arr, size_t st, size_t end,
                                          CategSplit cat_split_type, MissingAction missing_action,
                                          int &restrict chosen_cat, signed char *restrict split_categ, int *restrict saved_cat_mode,
-                                         int_t *restrict buffer_indices, mapping &restrict w);
+                                         int_t *restrict buffer_indices, ldouble_safe *restrict buffer_cnt, mapping &restrict w);
+template <class real_t_>
+void build_histogram(size_t *restrict ix_arr, size_t st, size_t end,
+                     real_t_ *restrict x, const uint8_t *restrict x_binned,
+                     const double *restrict bin_ref, HistBin *restrict hist);
+template <class real_t_, class mapping>
+void build_histogram_weighted(size_t *restrict ix_arr, size_t st, size_t end,
+                              real_t_ *restrict x, const uint8_t *restrict x_binned,
+                              const double *restrict bin_ref, HistBin *restrict hist,
+                              mapping &restrict w);
+template <class real_t>
+double find_split_hist_t(const HistBin *restrict hist, const double *restrict bin_ref, int nbins,
+                         double *restrict sd_arr, GainCriterion criterion, double min_gain, bool as_relative_gain,
+                         double &restrict split_point, double &restrict xmin, double &restrict xmax);
+template <class ldouble_safe>
+double find_split_hist(const HistBin *restrict hist, const double *restrict bin_ref, int nbins, size_t n,
+                       double *restrict sd_arr, GainCriterion criterion, double min_gain, bool as_relative_gain,
+                       double &restrict split_point, double &restrict xmin, double &restrict xmax);
 template <class ldouble_safe>
 double eval_guided_crit(double *restrict x, size_t n, GainCriterion criterion,
                         double min_gain, bool as_relative_gain, double *restrict buffer_sd,
@@ -1763,6 +2373,7 @@ double eval_guided_crit(double *restrict x, size_t n, GainCriterion criterion,
                         size_t *restrict ix_arr_plus_st,
                         size_t *restrict cols_use, size_t ncols_use, bool force_cols_use,
                         double *restrict X_row_major, size_t ncols,
+                        size_t *restrict buffer_argsorted, double *restrict buffer_sorted,
                         double *restrict Xr, size_t *restrict Xr_ind, size_t *restrict Xr_indptr);
 template <class ldouble_safe>
 double eval_guided_crit_weighted(double *restrict x, size_t n, GainCriterion criterion,
@@ -1772,24 +2383,25 @@ double eval_guided_crit_weighted(double *restrict x, size_t n, GainCriterion cri
                                  size_t *restrict ix_arr_plus_st,
                                  size_t *restrict cols_use, size_t ncols_use, bool force_cols_use,
                                  double *restrict X_row_major, size_t ncols,
+                                 double *restrict buffer_sorted,
                                  double *restrict Xr, size_t *restrict Xr_ind, size_t *restrict Xr_indptr);
 template <class real_t_, class ldouble_safe>
 double eval_guided_crit(size_t *restrict ix_arr, size_t st, size_t end, real_t_ *restrict x,
                         double *restrict buffer_sd, bool as_relative_gain,
                         double *restrict buffer_imputed_x, double *restrict saved_xmedian,
                         size_t &split_ix, double &restrict split_point, double &restrict xmin, double &restrict xmax,
-                        GainCriterion criterion, double min_gain, MissingAction missing_action,
+                        GainCriterion criterion, double min_gain, MissingAction missing_action, bool is_presorted,
                         size_t *restrict cols_use, size_t ncols_use, bool force_cols_use,
-                        double *restrict X_row_major, size_t ncols,
+                        double *restrict X_row_major, size_t ncols, double *restrict buffer_sums,
                         double *restrict Xr, size_t *restrict Xr_ind, size_t *restrict Xr_indptr);
 template <class real_t_, class mapping, class ldouble_safe>
 double eval_guided_crit_weighted(size_t *restrict ix_arr, size_t st, size_t end, real_t_ *restrict x,
                                  double *restrict buffer_sd, bool as_relative_gain,
                                  double *restrict buffer_imputed_x, double *restrict saved_xmedian,
                                  size_t &split_ix, double &restrict split_point, double &restrict xmin, double &restrict xmax,
-                                 GainCriterion criterion, double min_gain, MissingAction missing_action,
+                                 GainCriterion criterion, double min_gain, MissingAction missing_action, bool is_presorted,
                                  size_t *restrict cols_use, size_t ncols_use, bool force_cols_use,
-                                 double *restrict X_row_major, size_t ncols,
+                                 double *restrict X_row_major, size_t ncols, double *restrict buffer_sums,
                                  double *restrict Xr, size_t *restrict Xr_ind, size_t *restrict Xr_indptr,
                                  mapping &restrict w);
 template <class real_t_, class sparse_ix, class ldouble_safe>
@@ -1800,7 +2412,7 @@ double eval_guided_crit(size_t ix_arr[], size_t st, size_t end,
                         double &split_point, double &xmin, double &xmax,
                         GainCriterion criterion, double min_gain, MissingAction missing_action,
                         size_t *restrict cols_use, size_t ncols_use, bool force_cols_use,
-                        double *restrict X_row_major, size_t ncols,
+                        double *restrict X_row_major, size_t ncols, double *restrict buffer_sums,
                         double *restrict Xr, size_t *restrict Xr_ind, size_t *restrict Xr_indptr);
 template <class real_t_, class sparse_ix, class mapping, class ldouble_safe>
 double eval_guided_crit_weighted(size_t ix_arr[], size_t st, size_t end,
@@ -1810,9 +2422,9 @@ double eval_guided_crit_weighted(size_t ix_arr[], size_t st, size_t end,
                                  double &restrict split_point, double &restrict xmin, double &restrict xmax,
                                  GainCriterion criterion, double min_gain, MissingAction missing_action,
                                  size_t *restrict cols_use, size_t ncols_use, bool force_cols_use,
-                                 double *restrict X_row_major, size_t ncols,
+                                 double *restrict X_row_major, size_t ncols, double *restrict buffer_sums,
                                  double *restrict Xr, size_t *restrict Xr_ind, size_t *restrict Xr_indptr,
-                                 mapping &restrict w);
+                                 double *restrict buffer_w, mapping &restrict w);
 template <class ldouble_safe>
 double eval_guided_crit(size_t *restrict ix_arr, size_t st, size_t end, int *restrict x, int ncat,
                         int *restrict saved_cat_mode,
@@ -1823,7 +2435,7 @@ double eval_guided_crit(size_t *restrict ix_arr, size_t st, size_t end, int *res
 template <class mapping, class ldouble_safe>
 double eval_guided_crit_weighted(size_t *restrict ix_arr, size_t st, size_t end, int *restrict x, int ncat,
                                  int *restrict saved_cat_mode,
-                                 size_t *restrict buffer_pos, double *restrict buffer_prob,
+                                 size_t *restrict buffer_pos, double *restrict buffer_prob, ldouble_safe *restrict buffer_cnt,
                                  int &restrict chosen_cat, signed char *restrict split_categ, signed char *restrict buffer_split,
                                  GainCriterion criterion, double min_gain, bool all_perm,
                                  MissingAction missing_action, CategSplit cat_split_type,
@@ -1837,11 +2449,11 @@ void build_terminal_node_mappings_single_tree(std::vector<size_t> &mappings, siz
 template <class Model>
 void build_terminal_node_mappings(TreesIndexer &indexer, const Model &model);
 template <class Node>
-void build_dindex_recursive
+size_t build_dindex_recursive
 (
     const size_t curr_node,
     const size_t n_terminal, const size_t ncomb,
-    const size_t st, const size_t end,
+    const size_t st,
     std::vector<size_t> &restrict node_indices, /* array with all terminal indices in 'tree' */
     const std::vector<size_t> &restrict node_mappings, /* tree_index : terminal_index */
     std::vector<double> &restrict node_distances, /* indexed by terminal_index */
@@ -1930,6 +2542,315 @@ void subset_model(const IsoForest*     model,      IsoForest*     model_new,
                   const TreesIndexer*  indexer,    TreesIndexer*  indexer_new,
                   const size_t *trees_take, size_t ntrees_take);
 
+/* bin_plan.cpp */
+ISOTREE_EXPORTED
+void build_bin_plan(BinPlan &plan, const IsoForest &model, int nthreads);
+
+/* predict_binned.hpp */
+template <class real_t, class bin_t>
+void bin_numeric_data(real_t *restrict numeric_data, bool is_col_major, size_t ld_numeric,
+                      size_t nrows, int nthreads,
+                      const BinPlan &plan, bin_t *restrict binned_data);
+template <class bin_t, class sparse_ix>
+#ifndef _FOR_R
+[[gnu::optimize("no-trapping-math"), gnu::optimize("no-math-errno"), gnu::hot]]
+#endif
+void predict_iforest_binned(const bin_t *restrict binned_data, size_t nrows, int nthreads, bool standardize,
+                            const BinPlan &plan,
+                            double *restrict output_depths, sparse_ix *restrict tree_num,
+                            double *restrict per_tree_depths);
+template <class bin_t>
+[[gnu::hot]]
+static inline size_t traverse_binned_tree(const uint32_t *restrict col_num,
+                                          const uint32_t *restrict tree_left,
+                                          const uint16_t *restrict split_bin,
+                                          const bin_t *restrict    row_binned_data) noexcept;
+
+/* bitvector_forest.cpp */
+ISOTREE_EXPORTED
+void build_bitvector_forest(BitvectorIsoForest &bv_forest, const IsoForest &model);
+
+/* predict_bitvector.hpp */
+template <class real_t, class sparse_ix>
+#ifndef _FOR_R
+[[gnu::optimize("no-trapping-math"), gnu::optimize("no-math-errno"), gnu::hot]]
+#endif
+void predict_iforest_bitvector(real_t *restrict numeric_data, bool is_col_major, size_t ld_numeric,
+                               size_t nrows, int nthreads, bool standardize,
+                               const BitvectorIsoForest &bv_forest,
+                               double *restrict output_depths, sparse_ix *restrict tree_num,
+                               double *restrict per_tree_depths);
+template <class real_t, class sparse_ix>
+[[gnu::hot]]
+static inline double evaluate_bitvector_row(const real_t *restrict row_numeric_data, size_t col_stride,
+                                            const BitvectorIsoForest &bv_forest, uint64_t *restrict bitvectors,
+                                            size_t row, size_t nrows,
+                                            sparse_ix *restrict tree_num, double *restrict per_tree_depths) noexcept;
+
+/* cache_blocking.cpp */
+size_t get_l2_cache_size() noexcept;
+bool get_tree_blocks(const IsoForest &model, size_t nrows, size_t row_bytes, int nthreads,
+                     std::vector<size_t> &tree_blocks, size_t &row_block);
+bool get_tree_blocks(const ExtIsoForest &model, size_t nrows, size_t row_bytes, int nthreads,
+                     std::vector<size_t> &tree_blocks, size_t &row_block);
+bool get_tree_blocks(const CompiledIsoForest &compiled, size_t nrows, size_t row_bytes, int nthreads,
+                     std::vector<size_t> &tree_blocks, size_t &row_block);
+bool get_tree_blocks(const CompiledExtIsoForest &compiled, size_t nrows, size_t row_bytes, int nthreads,
+                     std::vector<size_t> &tree_blocks, size_t &row_block);
+
+/* predict_blocked.hpp */
+template <class AddTreeDepth>
+void predict_by_tree_blocks(const std::vector<size_t> &tree_blocks, size_t row_block,
+                            size_t nrows, int nthreads,
+                            double *restrict output_depths, AddTreeDepth &add_tree_depth);
+template <class AddTreeDepth>
+void predict_by_rows(size_t nrows, size_t ntrees, int nthreads,
+                     double *restrict output_depths, AddTreeDepth &add_tree_depth);
+template <class PredictionData>
+static inline size_t get_row_bytes(const PredictionData &prediction_data) noexcept;
+
+/* predict_csr.hpp */
+template <class Model>
+bool should_scatter_csr_rows(const Model &model, size_t nrows, int nthreads, size_t &ncols_dense);
+template <class PredictionData, class real_t>
+static inline void scatter_csr_row(const PredictionData &prediction_data, size_t row,
+                                   real_t *restrict dense_row, size_t ncols_dense, bool reset) noexcept;
+template <class PredictionData, class PredictRow>
+void predict_by_scattered_rows(const PredictionData &prediction_data, size_t nrows, int nthreads,
+                               size_t ncols_dense, PredictRow &predict_row);
+
+/* compiled_forest.cpp */
+ISOTREE_EXPORTED
+void build_compiled_forest(CompiledIsoForest &compiled, const IsoForest &model, bool float_thresholds, int nthreads);
+ISOTREE_EXPORTED
+void build_compiled_forest(CompiledExtIsoForest &compiled, const ExtIsoForest &model, int nthreads);
+bool should_use_compiled_forest(const IsoForest &model, size_t nrows);
+bool should_use_compiled_forest(const ExtIsoForest &model, size_t nrows);
+bool has_only_numeric_splits(const IsoForest &model) noexcept;
+bool has_only_numeric_splits(const ExtIsoForest &model) noexcept;
+size_t get_max_numeric_col(const IsoForest &model) noexcept;
+size_t get_max_numeric_col(const ExtIsoForest &model) noexcept;
+float round_threshold_down(double num_split) noexcept;
+float round_threshold_up(double num_split) noexcept;
+template <class real_t, class sparse_ix>
+#ifndef _FOR_R
+[[gnu::optimize("no-trapping-math"), gnu::optimize("no-math-errno"), gnu::hot]]
+#endif
+void predict_iforest_compiled(real_t *restrict numeric_data, bool is_col_major, size_t ld_numeric,
+                              size_t nrows, int nthreads, bool standardize,
+                              const CompiledIsoForest &compiled,
+                              double *restrict output_depths, sparse_ix *restrict tree_num,
+                              double *restrict per_tree_depths);
+template <class real_t, class split_t, class sparse_ix>
+void predict_compiled_forest(real_t *restrict numeric_data, bool is_col_major, size_t ld_numeric,
+                             size_t nrows, int nthreads,
+                             const CompiledIsoForest &compiled, const split_t *restrict num_split,
+                             double *restrict output_depths, sparse_ix *restrict tree_num,
+                             double *restrict per_tree_depths);
+template <class real_t, class sparse_ix>
+#ifndef _FOR_R
+[[gnu::optimize("no-trapping-math"), gnu::optimize("no-math-errno"), gnu::hot]]
+#endif
+void predict_iforest_compiled(real_t *restrict numeric_data, bool is_col_major, size_t ld_numeric,
+                              size_t nrows, int nthreads, bool standardize,
+                              const CompiledExtIsoForest &compiled,
+                              double *restrict output_depths, sparse_ix *restrict tree_num,
+                              double *restrict per_tree_depths);
+template <class real_t, class sparse_ix>
+void predict_compiled_forest(real_t *restrict numeric_data, bool is_col_major, size_t ld_numeric,
+                             size_t nrows, int nthreads,
+                             const CompiledExtIsoForest &compiled,
+                             double *restrict output_depths, sparse_ix *restrict tree_num,
+                             double *restrict per_tree_depths);
+template <class real_t, class sparse_ix>
+void predict_compiled_forest_levelwise(real_t *restrict numeric_data, size_t row_stride, size_t col_stride,
+                                       size_t nrows, int nthreads,
+                                       const CompiledExtIsoForest &compiled,
+                                       double *restrict output_depths, sparse_ix *restrict tree_num,
+                                       double *restrict per_tree_depths);
+template <class real_t, class sparse_ix>
+static void traverse_compiled_tree_levelwise(WorkerForPredictCSC &workspace,
+                                             const CompiledExtIsoForest &compiled,
+                                             size_t tree, size_t node, size_t st, size_t end,
+                                             const real_t *restrict numeric_data,
+                                             size_t row_stride, size_t col_stride, size_t nrows,
+                                             double *restrict output_depths, sparse_ix *restrict tree_num,
+                                             double *restrict per_tree_depths) noexcept;
+template <class real_t>
+[[gnu::hot]]
+static inline size_t traverse_compiled_tree(const uint32_t *restrict node_idx,
+                                            const double *restrict   node_val,
+                                            size_t                   ndim,
+                                            const real_t *restrict   row_numeric_data,
+                                            size_t                   col_stride) noexcept;
+template <class real_t, class split_t>
+[[gnu::hot]]
+static inline size_t traverse_compiled_tree(const uint32_t *restrict col_num,
+                                            const uint32_t *restrict tree_left,
+                                            const split_t *restrict  num_split,
+                                            const real_t *restrict   row_numeric_data,
+                                            size_t                   col_stride) noexcept;
+
+/* compiled_simd.cpp */
+bool predict_compiled_rows_simd(const double *numeric_data, size_t row_stride, size_t col_stride,
+                                size_t nrows, int nthreads,
+                                const CompiledIsoForest &compiled, const double *num_split,
+                                double *output_depths, double *per_tree_depths);
+bool predict_compiled_rows_simd(const float *numeric_data, size_t row_stride, size_t col_stride,
+                                size_t nrows, int nthreads,
+                                const CompiledIsoForest &compiled, const float *num_split,
+                                double *output_depths, double *per_tree_depths);
+template <class real_t, class split_t>
+static inline bool predict_compiled_rows_simd(const real_t *numeric_data, size_t row_stride, size_t col_stride,
+                                              size_t nrows, int nthreads,
+                                              const CompiledIsoForest &compiled, const split_t *num_split,
+                                              double *output_depths, double *per_tree_depths) noexcept;
+
+/* predict_decision.hpp */
+template <class real_t>
+void predict_iforest_decision(real_t *restrict numeric_data, bool is_col_major, size_t ld_numeric,
+                              size_t nrows, int nthreads,
+                              const CompiledIsoForest &compiled,
+                              double threshold, double confidence,
+                              int *restrict output_decisions, size_t *restrict trees_used);
+template <class real_t, class split_t>
+#ifndef _FOR_R
+[[gnu::optimize("no-trapping-math"), gnu::optimize("no-math-errno"), gnu::hot]]
+#endif
+void predict_decision_compiled(real_t *restrict numeric_data, bool is_col_major, size_t ld_numeric,
+                               size_t nrows, int nthreads,
+                               const CompiledIsoForest &compiled, const split_t *restrict num_split,
+                               double threshold, double confidence,
+                               int *restrict output_decisions, size_t *restrict trees_used);
+
+/* executor.cpp */
+ISOTREE_EXPORTED
+Executor* get_thread_executor() noexcept;
+/* Runs 'task(ix, thread_id)' for each 'ix' in [0, n) on the executor of the calling thread if
+   there is one, or in an OpenMP thread team otherwise. Tasks are expected to catch their own
+   exceptions when running under OpenMP. */
+template <class Task>
+static inline void run_parallel_for(Executor *executor, size_t n, int nthreads, bool dynamic_schedule, Task &task)
+{
+    if (executor)
+    {
+        executor->parallel_for(n, std::function<void(size_t, int)>(std::ref(task)));
+        return;
+    }
+
+    if (dynamic_schedule)
+    {
+        #pragma omp parallel for schedule(dynamic) num_threads(nthreads) shared(n, task)
+        for (size_t_for ix = 0; ix < (decltype(ix))n; ix++)
+            task((size_t)ix, omp_get_thread_num());
+    }
+
+    else
+    {
+        #pragma omp parallel for if(n > 1) schedule(static) num_threads(nthreads) shared(n, task)
+        for (size_t_for ix = 0; ix < (decltype(ix))n; ix++)
+            task((size_t)ix, omp_get_thread_num());
+    }
+}
+
+/* Keeps the first exception thrown by the tasks of a loop run through 'run_parallel_for', to be called
+   from inside the 'catch' block. The tasks might run in the threads of an executor, where 'omp critical'
+   sections do nothing if the library was built without OpenMP, so only the thread that manages to set
+   the atomic flag stores its exception, which is then read after the loop finishes. */
+static inline void catch_task_exception(std::atomic<bool> &threw_exception, std::exception_ptr &ex) noexcept
+{
+    bool expected = false;
+    if (threw_exception.compare_exchange_strong(expected, true))
+        ex = std::current_exception();
+}
+
+/* prediction_context.cpp */
+ISOTREE_EXPORTED
+void build_prediction_context(PredictionContext &context,
+                              const IsoForest *model_outputs, const ExtIsoForest *model_outputs_ext,
+                              bool standardize);
+
+/* predict_row.hpp */
+template <class real_t>
+double predict_iforest_row(const PredictionContext &context,
+                           const real_t *restrict numeric_row, const int *restrict categ_row);
+template <class PredictionData>
+static inline bool predict_itree_row_specialized(PredictionData &prediction_data, const IsoForest &model_outputs,
+                                                 double &depth) noexcept;
+template <bool impute_missing, bool has_range_penalty, class PredictionData>
+static inline double predict_itree_row_dispatch(PredictionData &prediction_data, const IsoForest &model_outputs,
+                                                CategConfig categ_config) noexcept;
+template <CategConfig categ_config, bool impute_missing, bool has_range_penalty, class PredictionData>
+[[gnu::hot]]
+static inline double predict_itree_row_kernel(PredictionData &prediction_data, const IsoForest &model_outputs) noexcept;
+
+/* predict_view.hpp */
+template <class real_t, class sparse_ix>
+void predict_iforest_view(real_t *restrict numeric_data, int *restrict categ_data,
+                          bool is_col_major, size_t ld_numeric, size_t ld_categ,
+                          real_t *restrict Xc, sparse_ix *restrict Xc_ind, sparse_ix *restrict Xc_indptr,
+                          real_t *restrict Xr, sparse_ix *restrict Xr_ind, sparse_ix *restrict Xr_indptr,
+                          size_t nrows, int nthreads, bool standardize,
+                          const IsoForestView &view,
+                          double *restrict output_depths, double *restrict per_tree_depths);
+template <class PredictionData, class sparse_ix>
+double traverse_itree_view(const char *tree_start, const char *const *node_ptrs,
+                           const IsoForestView &view, PredictionData &prediction_data,
+                           size_t row, const sparse_ix *row_st, const sparse_ix *row_end,
+                           double *restrict tree_depth, size_t curr_lev);
+
+/* flat_model.cpp */
+ISOTREE_EXPORTED
+size_t determine_flat_model_size(const IsoForest *model, const ExtIsoForest *model_ext, bool single_precision);
+ISOTREE_EXPORTED
+void serialize_flat_model(const IsoForest *model, const ExtIsoForest *model_ext, bool single_precision, char *out);
+ISOTREE_EXPORTED
+void serialize_flat_model_ToFile(const IsoForest *model, const ExtIsoForest *model_ext, bool single_precision,
+                                 const char *fname);
+ISOTREE_EXPORTED
+void load_flat_model(FlatModel &model, const char *in, size_t n_bytes);
+ISOTREE_EXPORTED
+void load_flat_model_FromFile(FlatModel &model, const char *fname);
+
+/* predict_flat.hpp */
+template <class real_t, class sparse_ix>
+#ifndef _FOR_R
+[[gnu::optimize("no-trapping-math"), gnu::optimize("no-math-errno"), gnu::hot]]
+#endif
+void predict_flat_model(real_t *restrict numeric_data, bool is_col_major, size_t ld_numeric,
+                        size_t nrows, int nthreads, bool standardize,
+                        const FlatModel &model,
+                        double *restrict output_depths, sparse_ix *restrict tree_num,
+                        double *restrict per_tree_depths);
+template <class real_t>
+double get_flat_model_max_deviation(real_t *restrict numeric_data, bool is_col_major, size_t ld_numeric,
+                                    size_t nrows, int nthreads, bool standardize,
+                                    IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
+                                    const FlatModel &flat_model);
+template <class real_t, class sparse_ix, class idx_t, class val_t>
+void predict_flat_model_internal(real_t *restrict numeric_data, size_t row_stride, size_t col_stride,
+                                 size_t nrows, int nthreads,
+                                 const FlatModel &model, const FlatModelArrays<idx_t, val_t> &arrays,
+                                 double *restrict output_depths, sparse_ix *restrict tree_num,
+                                 double *restrict per_tree_depths);
+template <class real_t, class idx_t, class val_t>
+double traverse_flat_tree(const FlatModel &model, const FlatModelArrays<idx_t, val_t> &arrays, size_t st,
+                          const real_t *restrict row_numeric_data, size_t col_stride,
+                          size_t curr_lev, size_t &terminal) noexcept;
+template <class real_t, class idx_t, class val_t>
+void traverse_flat_hplane(const FlatModel &model, const FlatModelArrays<idx_t, val_t> &arrays, size_t st,
+                          const real_t *restrict row_numeric_data, size_t col_stride,
+                          double &restrict output_depth, size_t &terminal) noexcept;
+
+/* reorder_nodes.cpp */
+ISOTREE_EXPORTED
+void reorder_nodes(IsoForest &model, Imputer *imputer, TreesIndexer *indexer, int nthreads);
+ISOTREE_EXPORTED
+void reorder_nodes(ExtIsoForest &model, Imputer *imputer, TreesIndexer *indexer, int nthreads);
+ISOTREE_EXPORTED
+void reorder_nodes(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
+                   Imputer *imputer, TreesIndexer *indexer, int nthreads);
+
 /* serialize.cpp */
 [[noreturn]]
 void throw_errno();
@@ -2019,6 +2940,8 @@ ISOTREE_EXPORTED
 void deserialize_IsoForest_FromFile(IsoForest &model, const wchar_t *fname);
 #endif
 ISOTREE_EXPORTED
+void build_IsoForestView(IsoForestView &view, const char *in);
+ISOTREE_EXPORTED
 void serialize_ExtIsoForest(const ExtIsoForest &model, char *out);
 ISOTREE_EXPORTED
 void serialize_ExtIsoForest(const ExtIsoForest &model, FILE *out);
@@ -2373,6 +3296,22 @@ void extract_cond_ext_isotree(const ExtIsoForest &model, const IsoHPlane &hplane
                               const std::vector<std::string> &categ_colnames,
                               const std::vector<std::vector<std::string>> &categ_levels);
 
+/* cpp_generator.cpp */
+ISOTREE_EXPORTED
+std::string generate_cpp(const IsoForest *model_outputs, const ExtIsoForest *model_outputs_ext,
+                         const std::string &function_name, bool standardize, int nthreads);
+std::string format_cpp_double(double x);
+void generate_cpp_itree(std::string &out, const IsoForest &model, const std::vector<IsoTree> &tree,
+                        const std::string &prefix, bool has_categ);
+void generate_cpp_itree_node(std::string &out, const IsoForest &model, const std::vector<IsoTree> &tree,
+                             size_t curr_node, size_t nesting, const std::string &prefix, bool has_categ,
+                             std::vector<size_t> &function_roots);
+void generate_cpp_hplane(std::string &out, const ExtIsoForest &model, const std::vector<IsoHPlane> &hplane,
+                         const std::string &prefix, bool has_categ);
+void generate_cpp_hplane_node(std::string &out, const ExtIsoForest &model, const std::vector<IsoHPlane> &hplane,
+                              size_t curr_node, size_t nesting, const std::string &prefix, bool has_categ,
+                              std::vector<size_t> &function_roots);
+
 /* formatted_exporters.cpp */
 ISOTREE_EXPORTED
 std::vector<std::string> generate_dot(const IsoForest *model_outputs,
@@ -2465,6 +3404,18 @@ void traverse_ext_json
     bool output_tree_num, bool index1, size_t tree_num
 );
 
+/* stream_scorer.cpp */
+ISOTREE_EXPORTED
+size_t predict_iforest_stream(std::istream &input, std::ostream &output,
+                              size_t ncols_numeric, bool csv_input, char delimiter, bool skip_header,
+                              bool binary_output, size_t chunk_rows, int nthreads, bool standardize,
+                              IsoForest *model_outputs, ExtIsoForest *model_outputs_ext);
+ISOTREE_EXPORTED
+size_t predict_iforest_stream(const char *input_file, const char *output_file,
+                              size_t ncols_numeric, bool csv_input, char delimiter, bool skip_header,
+                              bool binary_output, size_t chunk_rows, int nthreads, bool standardize,
+                              IsoForest *model_outputs, ExtIsoForest *model_outputs_ext);
+
 #ifndef _FOR_R
     #if defined(__clang__)
         #pragma clang diagnostic pop
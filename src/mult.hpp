@@ -561,7 +561,8 @@ template <class real_t_, class mapping, class ldouble_safe>
 void add_linear_comb_weighted(const size_t ix_arr[], size_t st, size_t end, double *restrict res,
                               const real_t_ *restrict x, double &coef, double x_sd, double x_mean, double &restrict fill_val,
                               MissingAction missing_action, double *restrict buffer_arr,
-                              size_t *restrict buffer_NAs, bool first_run, mapping &restrict w)
+                              size_t *restrict buffer_NAs, double *restrict buffer_w, size_t *restrict buffer_ix,
+                              bool first_run, mapping &restrict w)
 {
     /* TODO: here don't need the buffer for NAs */
 
@@ -573,13 +574,6 @@ void add_linear_comb_weighted(const size_t ix_arr[], size_t st, size_t end, doub
     double *restrict res_write = res - st;
     ldouble_safe cumw = 0;
     double w_this;
-    /* TODO: these buffers should be allocated externally */
-    std::vector<double> obs_weight;
-
-    if (first_run && missing_action != Fail)
-    {
-        obs_weight.resize(end - st + 1, 0.);
-    }
 
     if (missing_action == Fail)
     {    
@@ -597,7 +591,7 @@ void add_linear_comb_weighted(const size_t ix_arr[], size_t st, size_t end, doub
                 {
                     w_this = w[ix_arr[row]];
                     res_write[row]     = std::fma(x[ix_arr[row]] - x_mean, coef, res_write[row]);
-                    obs_weight[cnt]    = w_this;
+                    buffer_w[cnt]      = w_this;
                     buffer_arr[cnt++]  = x[ix_arr[row]];
                     cumw += w_this;
                 }
@@ -621,22 +615,21 @@ void add_linear_comb_weighted(const size_t ix_arr[], size_t st, size_t end, doub
 
 
         ldouble_safe mid_point = cumw / (ldouble_safe)2;
-        std::vector<size_t> sorted_ix(cnt);
-        std::iota(sorted_ix.begin(), sorted_ix.end(), (size_t)0);
-        std::sort(sorted_ix.begin(), sorted_ix.end(),
+        std::iota(buffer_ix, buffer_ix + cnt, (size_t)0);
+        std::sort(buffer_ix, buffer_ix + cnt,
                   [&buffer_arr](const size_t a, const size_t b){return buffer_arr[a] < buffer_arr[b];});
         ldouble_safe currw = 0;
-        fill_val = buffer_arr[sorted_ix.back()]; /* <- will overwrite later */
+        fill_val = buffer_arr[buffer_ix[cnt-1]]; /* <- will overwrite later */
         /* TODO: is this median calculation correct? should it do a weighted interpolation? */
         for (size_t ix = 0; ix < cnt; ix++)
         {
-            currw += obs_weight[sorted_ix[ix]];
+            currw += buffer_w[buffer_ix[ix]];
             if (currw >= mid_point)
             {
                 if (currw == mid_point && ix < cnt-1)
-                    fill_val = buffer_arr[sorted_ix[ix]] + (buffer_arr[sorted_ix[ix+1]] - buffer_arr[sorted_ix[ix]]) / 2.0;
+                    fill_val = buffer_arr[buffer_ix[ix]] + (buffer_arr[buffer_ix[ix+1]] - buffer_arr[buffer_ix[ix]]) / 2.0;
                 else
-                    fill_val = buffer_arr[sorted_ix[ix]];
+                    fill_val = buffer_arr[buffer_ix[ix]];
                 break;
             }
         }
@@ -874,56 +867,53 @@ template <class real_t_, class sparse_ix, class mapping, class ldouble_safe>
 void add_linear_comb_weighted(const size_t *restrict ix_arr, size_t st, size_t end, size_t col_num, double *restrict res,
                               const real_t_ *restrict Xc, const sparse_ix *restrict Xc_ind, const sparse_ix *restrict Xc_indptr,
                               double &restrict coef, double x_sd, double x_mean, double &restrict fill_val, MissingAction missing_action,
-                              double *restrict buffer_arr, size_t *restrict buffer_NAs, bool first_run, mapping &restrict w)
+                              double *restrict buffer_arr, size_t *restrict buffer_NAs,
+                              double *restrict buffer_x, double *restrict buffer_w, size_t *restrict buffer_ix,
+                              bool first_run, mapping &restrict w)
 {
     /* TODO: there's likely a better way of doing this directly with sparse inputs.
        Think about some way of doing it efficiently. */
     if (first_run && missing_action != Fail)
     {
-        std::vector<double> denseX(end-st+1, 0.);
+        std::fill(buffer_x, buffer_x + (end-st+1), 0.);
         todense(ix_arr, st, end,
                 col_num, Xc, Xc_ind, Xc_indptr,
-                denseX.data());
-        std::vector<double> obs_weight(end-st+1);
+                buffer_x);
         for (size_t row = st; row <= end; row++)
-            obs_weight[row - st] = w[ix_arr[row]];
+            buffer_w[row - st] = w[ix_arr[row]];
 
         size_t end_new = end - st + 1;
         for (size_t ix = 0; ix < end-st+1; ix++)
         {
-            if (unlikely(is_na_or_inf(denseX[ix])))
+            if (unlikely(is_na_or_inf(buffer_x[ix])))
             {
-                std::swap(denseX[ix], denseX[--end_new]);
-                std::swap(obs_weight[ix], obs_weight[end_new]);
+                std::swap(buffer_x[ix], buffer_x[--end_new]);
+                std::swap(buffer_w[ix], buffer_w[end_new]);
             }
         }
 
-        ldouble_safe cumw = std::accumulate(obs_weight.begin(), obs_weight.begin() + end_new, (ldouble_safe)0);
+        ldouble_safe cumw = std::accumulate(buffer_w, buffer_w + end_new, (ldouble_safe)0);
         ldouble_safe mid_point = cumw / (ldouble_safe)2;
-        std::vector<size_t> sorted_ix(end_new);
-        std::iota(sorted_ix.begin(), sorted_ix.end(), (size_t)0);
-        std::sort(sorted_ix.begin(), sorted_ix.end(),
-                  [&denseX](const size_t a, const size_t b){return denseX[a] < denseX[b];});
+        std::iota(buffer_ix, buffer_ix + end_new, (size_t)0);
+        std::sort(buffer_ix, buffer_ix + end_new,
+                  [&buffer_x](const size_t a, const size_t b){return buffer_x[a] < buffer_x[b];});
         ldouble_safe currw = 0;
-        fill_val = denseX[sorted_ix.back()]; /* <- will overwrite later */
+        fill_val = buffer_x[buffer_ix[end_new-1]]; /* <- will overwrite later */
         /* TODO: is this median calculation correct? should it do a weighted interpolation? */
         for (size_t ix = 0; ix < end_new; ix++)
         {
-            currw += obs_weight[sorted_ix[ix]];
+            currw += buffer_w[buffer_ix[ix]];
             if (currw >= mid_point)
             {
                 if (currw == mid_point && ix < end_new-1)
-                    fill_val = denseX[sorted_ix[ix]] + (denseX[sorted_ix[ix+1]] - denseX[sorted_ix[ix]]) / 2.0;
+                    fill_val = buffer_x[buffer_ix[ix]] + (buffer_x[buffer_ix[ix+1]] - buffer_x[buffer_ix[ix]]) / 2.0;
                 else
-                    fill_val = denseX[sorted_ix[ix]];
+                    fill_val = buffer_x[buffer_ix[ix]];
                 break;
             }
         }
 
         fill_val = (fill_val - x_mean) * (coef / x_sd);
-        denseX.clear();
-        obs_weight.clear();
-        sorted_ix.clear();
         
         add_linear_comb(ix_arr, st, end, col_num, res,
                         Xc, Xc_ind, Xc_indptr,
@@ -1129,12 +1119,12 @@ void add_linear_comb(const size_t *restrict ix_arr, size_t st, size_t end, doubl
 template <class mapping, class ldouble_safe>
 void add_linear_comb_weighted(const size_t *restrict ix_arr, size_t st, size_t end, double *restrict res,
                               const int x[], int ncat, double *restrict cat_coef, double single_cat_coef, int chosen_cat,
-                              double &restrict fill_val, double &restrict fill_new, size_t *restrict buffer_pos,
+                              double &restrict fill_val, double &restrict fill_new,
+                              size_t *restrict buffer_pos, ldouble_safe *restrict buffer_cnt,
                               NewCategAction new_cat_action, MissingAction missing_action, CategSplit cat_split_type,
                               bool first_run, mapping &restrict w)
 {
     double *restrict res_write = res - st;
-    /* TODO: this buffer should be allocated externally */
 
     switch(cat_split_type)
     {
@@ -1232,8 +1222,7 @@ void add_linear_comb_weighted(const size_t *restrict ix_arr, size_t st, size_t e
                 return;
             }
 
-            /* TODO: this buffer should be allocated externally */
-            std::vector<ldouble_safe> buffer_cnt(ncat+1, 0.);
+            std::fill(buffer_cnt, buffer_cnt + ncat + 1, (ldouble_safe)0);
             switch(missing_action)
             {
                 case Fail:
@@ -1287,7 +1276,7 @@ void add_linear_comb_weighted(const size_t *restrict ix_arr, size_t st, size_t e
                 default:
                 {
                     /* Determine imputation value as the category in sorted order that gives 50% + 1 */
-                    ldouble_safe cnt_l = std::accumulate(buffer_cnt.begin(), buffer_cnt.begin() + ncat, (ldouble_safe)0);
+                    ldouble_safe cnt_l = std::accumulate(buffer_cnt, buffer_cnt + ncat, (ldouble_safe)0);
                     std::iota(buffer_pos, buffer_pos + ncat, (size_t)0);
                     std::sort(buffer_pos, buffer_pos + ncat, [&cat_coef](const size_t a, const size_t b){return cat_coef[a] < cat_coef[b];});
 
@@ -123,43 +123,25 @@ IsolationForest::IsolationForest
 
 void IsolationForest::fit(double X[], size_t nrows, size_t ncols)
 {
-    this->check_params();
-    this->override_previous_fit();
+    this->fit(X, ncols, nrows,
+              (int*)nullptr, (size_t)0, (int*)nullptr,
+              true, nrows, nrows,
+              (double*)nullptr, (double*)nullptr);
+}
 
-    auto retcode = fit_iforest(
-        (this->ndim == 1)? &this->model : nullptr,
-        (this->ndim != 1)? &this->model_ext : nullptr,
-        X,  ncols,
-        (int*)nullptr, (size_t)0, (int*)nullptr,
-        (double*)nullptr, (int*)nullptr, (int*)nullptr,
-        this->ndim, this->ntry, this->coef_type, this->coef_by_prop,
-        (double*)nullptr, this->with_replacement, this->weight_as_sample,
-        nrows, this->sample_size, this->ntrees,
-        this->max_depth, this->ncols_per_tree,
-        this->limit_depth, this->penalize_range, this->standardize_data,
-        this->scoring_metric, this->fast_bratio,
-        false, (double*)nullptr,
-        (double*)nullptr, true,
-        (double*)nullptr, this->weigh_by_kurt,
-        this->prob_pick_by_gain_pl,
-        this->prob_pick_by_gain_avg,
-        this->prob_pick_by_full_gain,
-        this->prob_pick_by_dens,
-        this->prob_pick_col_by_range,
-        this->prob_pick_col_by_var,
-        this->prob_pick_col_by_kurt,
-        this->min_gain, this->missing_action,
-        this->cat_split_type, this->new_cat_action,
-        this->all_perm, &this->imputer, this->min_imp_obs,
-        this->depth_imp, this->weigh_imp_rows, false,
-        this->random_seed, false, this->nthreads
-    );
-    if (retcode != EXIT_SUCCESS) unexpected_error();
-    this->is_fitted = true;
+void IsolationForest::fit(double numeric_data[],   size_t ncols_numeric,  size_t nrows,
+                          int    categ_data[],     size_t ncols_categ,    int ncat[],
+                          double sample_weights[], double col_weights[])
+{
+    this->fit(numeric_data, ncols_numeric, nrows,
+              categ_data, ncols_categ, ncat,
+              true, nrows, nrows,
+              sample_weights, col_weights);
 }
 
 void IsolationForest::fit(double numeric_data[],   size_t ncols_numeric,  size_t nrows,
                           int    categ_data[],     size_t ncols_categ,    int ncat[],
+                          bool   is_col_major,     size_t ld_numeric,     size_t ld_categ,
                           double sample_weights[], double col_weights[])
 {
     this->check_params();
@@ -170,6 +152,7 @@ void IsolationForest::fit(double numeric_data[],   size_t ncols_numeric,  size_t
         (this->ndim != 1)? &this->model_ext : nullptr,
         numeric_data,  ncols_numeric,
         categ_data, ncols_categ, ncat,
+        is_col_major, ld_numeric, ld_categ,
         (double*)nullptr, (int*)nullptr, (int*)nullptr,
         this->ndim, this->ntry, this->coef_type, this->coef_by_prop,
         sample_weights, this->with_replacement, this->weight_as_sample,
@@ -187,14 +170,17 @@ void IsolationForest::fit(double numeric_data[],   size_t ncols_numeric,  size_t
         this->prob_pick_col_by_range,
         this->prob_pick_col_by_var,
         this->prob_pick_col_by_kurt,
-        this->min_gain, this->missing_action,
+        this->min_gain, this->split_search, this->missing_action,
         this->cat_split_type, this->new_cat_action,
         this->all_perm, &this->imputer, this->min_imp_obs,
         this->depth_imp, this->weigh_imp_rows, false,
-        this->random_seed, false, this->nthreads
+        this->random_seed, false, this->node_task_rows,
+        this->reorder_nodes_after_fit, this->nthreads
     );
     if (retcode != EXIT_SUCCESS) unexpected_error();
     this->is_fitted = true;
+    if (this->keep_compiled_forest)
+        this->build_compiled();
 }
 
 void IsolationForest::fit(double Xc[], int Xc_ind[], int Xc_indptr[],
@@ -210,6 +196,7 @@ void IsolationForest::fit(double Xc[], int Xc_ind[], int Xc_indptr[],
         (this->ndim != 1)? &this->model_ext : nullptr,
         (double*)nullptr,  ncols_numeric,
         categ_data, ncols_categ, ncat,
+        true, (size_t)0, (size_t)0,
         Xc, Xc_ind, Xc_indptr,
         this->ndim, this->ntry, this->coef_type, this->coef_by_prop,
         sample_weights, this->with_replacement, this->weight_as_sample,
@@ -227,14 +214,17 @@ void IsolationForest::fit(double Xc[], int Xc_ind[], int Xc_indptr[],
         this->prob_pick_col_by_range,
         this->prob_pick_col_by_var,
         this->prob_pick_col_by_kurt,
-        this->min_gain, this->missing_action,
+        this->min_gain, this->split_search, this->missing_action,
         this->cat_split_type, this->new_cat_action,
         this->all_perm, &this->imputer, this->min_imp_obs,
         this->depth_imp, this->weigh_imp_rows, false,
-        this->random_seed, false, this->nthreads
+        this->random_seed, false, this->node_task_rows,
+        this->reorder_nodes_after_fit, this->nthreads
     );
     if (retcode != EXIT_SUCCESS) unexpected_error();
     this->is_fitted = true;
+    if (this->keep_compiled_forest)
+        this->build_compiled();
 }
 
 std::vector<double> IsolationForest::predict(double X[], size_t nrows, bool standardize)
@@ -242,6 +232,8 @@ std::vector<double> IsolationForest::predict(double X[], size_t nrows, bool stan
     this->check_is_fitted();
     this->check_nthreads();
     std::vector<double> out(nrows);
+    if (this->predict_compiled(X, true, nrows, (size_t)0, standardize, out.data(), (int*)nullptr, (double*)nullptr))
+        return out;
     predict_iforest(
         X, (int*)nullptr,
         true, (size_t)0, (size_t)0,
@@ -263,6 +255,10 @@ void IsolationForest::predict(double numeric_data[], int categ_data[], bool is_c
     this->check_nthreads();
     if ((tree_num || per_tree_depths) && !this->check_can_predict_per_tree())
         throw std::runtime_error("Cannot predict tree numbers/depths with this model.\n");
+    if (categ_data == nullptr &&
+        this->predict_compiled(numeric_data, is_col_major, nrows, ld_numeric, standardize,
+                               output_depths, tree_num, per_tree_depths))
+        return;
     predict_iforest(
         numeric_data, categ_data,
         is_col_major, ld_numeric, ld_categ,
@@ -296,6 +292,94 @@ void IsolationForest::predict(double X_sparse[], int X_ind[], int X_indptr[], bo
         (!this->indexer.indices.empty())? &this->indexer : nullptr);
 }
 
+bool IsolationForest::predict_compiled(double numeric_data[], bool is_col_major, size_t nrows, size_t ld_numeric,
+                                       bool standardize, double output_depths[], int tree_num[], double per_tree_depths[]) const
+{
+    if (!this->has_compiled)
+        return false;
+
+    if (!this->model.trees.empty())
+        predict_iforest_compiled(numeric_data, is_col_major, ld_numeric, nrows, this->nthreads, standardize,
+                                 this->compiled, output_depths, tree_num, per_tree_depths);
+    else
+        predict_iforest_compiled(numeric_data, is_col_major, ld_numeric, nrows, this->nthreads, standardize,
+                                 this->compiled_ext, output_depths, tree_num, per_tree_depths);
+    return true;
+}
+
+void IsolationForest::build_compiled()
+{
+    this->check_is_fitted();
+    this->check_nthreads();
+    this->clear_compiled();
+    if (!this->model.trees.empty())
+    {
+        if (this->model.missing_action != Fail || this->model.has_range_penalty || !has_only_numeric_splits(this->model))
+            return;
+        build_compiled_forest(this->compiled, this->model, false, this->nthreads);
+    }
+
+    else
+    {
+        if (this->model_ext.missing_action != Fail || this->model_ext.has_range_penalty || !has_only_numeric_splits(this->model_ext))
+            return;
+        build_compiled_forest(this->compiled_ext, this->model_ext, this->nthreads);
+    }
+    this->has_compiled = true;
+}
+
+void IsolationForest::clear_compiled()
+{
+    this->compiled = CompiledIsoForest();
+    this->compiled_ext = CompiledExtIsoForest();
+    this->has_compiled = false;
+}
+
+PredictionContext IsolationForest::get_prediction_context(bool standardize) const
+{
+    this->check_is_fitted();
+    PredictionContext context;
+    build_prediction_context(
+        context,
+        (!this->model.trees.empty())? &this->model : nullptr,
+        (!this->model_ext.hplanes.empty())? &this->model_ext : nullptr,
+        standardize);
+    return context;
+}
+
+double IsolationForest::score_row(const PredictionContext &context, const double numeric_row[], const int categ_row[])
+{
+    return predict_iforest_row(context, numeric_row, categ_row);
+}
+
+size_t IsolationForest::predict_stream(std::istream &input, std::ostream &output, size_t ncols_numeric,
+                                       bool csv_input, char delimiter, bool skip_header, bool binary_output,
+                                       bool standardize, size_t chunk_rows)
+{
+    this->check_is_fitted();
+    this->check_nthreads();
+    return predict_iforest_stream(
+        input, output, ncols_numeric,
+        csv_input, delimiter, skip_header, binary_output,
+        chunk_rows, this->nthreads, standardize,
+        (!this->model.trees.empty())? &this->model : nullptr,
+        (!this->model_ext.hplanes.empty())? &this->model_ext : nullptr);
+}
+
+size_t IsolationForest::predict_stream(const char *input_file, const char *output_file, size_t ncols_numeric,
+                                       bool csv_input, char delimiter, bool skip_header, bool binary_output,
+                                       bool standardize, size_t chunk_rows)
+{
+    this->check_is_fitted();
+    this->check_nthreads();
+    return predict_iforest_stream(
+        input_file, output_file, ncols_numeric,
+        csv_input, delimiter, skip_header, binary_output,
+        chunk_rows, this->nthreads, standardize,
+        (!this->model.trees.empty())? &this->model : nullptr,
+        (!this->model_ext.hplanes.empty())? &this->model_ext : nullptr);
+}
+
 std::vector<double> IsolationForest::predict_distance(double X[], size_t nrows,
                                                       bool as_kernel,
                                                       bool assume_full_distr, bool standardize,
@@ -470,6 +554,20 @@ void IsolationForest::build_indexer(const bool with_distances)
         unexpected_error();
 }
 
+void IsolationForest::reorder_nodes()
+{
+    this->check_is_fitted();
+    this->check_nthreads();
+    bool had_compiled = this->has_compiled;
+    this->clear_compiled();
+    ::reorder_nodes(
+        (!this->model.trees.empty())? &this->model : nullptr,
+        (!this->model_ext.hplanes.empty())? &this->model_ext : nullptr,
+        &this->imputer, &this->indexer, this->nthreads);
+    if (had_compiled)
+        this->build_compiled();
+}
+
 void IsolationForest::set_as_reference_points(double numeric_data[], int categ_data[], bool is_col_major,
                                               size_t nrows, size_t ld_numeric, size_t ld_categ,
                                               const bool with_distances)
@@ -594,6 +692,7 @@ IsoForest& IsolationForest::get_model()
 {
     if (this->ndim != 1)
         throw std::runtime_error("Error: class contains an 'ExtIsoForest' model only.\n");
+    this->clear_compiled();
     return this->model;
 }
 
@@ -601,6 +700,7 @@ ExtIsoForest& IsolationForest::get_model_ext()
 {
     if (this->ndim == 1)
         throw std::runtime_error("Error: class contains an 'IsoForest' model only.\n");
+    this->clear_compiled();
     return this->model_ext;
 }
 
@@ -675,6 +775,7 @@ void IsolationForest::override_previous_fit()
         this->imputer = Imputer();
         this->indexer = TreesIndexer();
     }
+    this->clear_compiled();
 }
 
 void IsolationForest::check_params()
@@ -709,6 +810,8 @@ void IsolationForest::check_params()
         throw std::runtime_error("Invalid 'coef_type'.\n");
     if (this->missing_action != Divide && this->missing_action != Impute && this->missing_action != Fail)
         throw std::runtime_error("Invalid 'missing_action'.\n");
+    if (this->split_search != SortedSearch && this->split_search != HistogramSearch && this->split_search != PresortedSearch)
+        throw std::runtime_error("Invalid 'split_search'.\n");
     if (this->cat_split_type != SubSet && this->cat_split_type != SingleCateg)
         throw std::runtime_error("Invalid 'cat_split_type'.\n");
     if (this->new_cat_action != Weighted && this->new_cat_action != Smallest && this->new_cat_action != Random)
@@ -944,4 +1047,15 @@ std::string IsolationForest::to_sql(bool output_tree_num, bool index1, size_t tr
     return out[0];
 }
 
+std::string IsolationForest::to_cpp(const std::string &function_name, bool standardize) const
+{
+    return generate_cpp(
+        (!this->model.trees.empty())? &this->model : nullptr,
+        (!this->model_ext.hplanes.empty())? &this->model_ext : nullptr,
+        function_name,
+        standardize,
+        this->nthreads
+    );
+}
+
 #endif
@@ -124,6 +124,8 @@ public:
     double prob_pick_col_by_var = 0.;
     double prob_pick_col_by_kurt = 0.;
     double min_gain = 0.;
+    SplitSearch split_search = SortedSearch; /* only for ndim==1 */
+    size_t node_task_rows = 0; /* if >0, splits large nodes of a tree in parallel */
     MissingAction missing_action = Impute;
 
     CategSplit cat_split_type = SubSet;
@@ -136,6 +138,9 @@ public:
     UseDepthImp depth_imp = Higher;
     WeighImpRows weigh_imp_rows = Inverse;
 
+    bool   reorder_nodes_after_fit = false;
+    bool   keep_compiled_forest = false;
+
     IsoForest model;
     ExtIsoForest model_ext;
     Imputer imputer;
@@ -170,6 +175,11 @@ public:
              int    categ_data[],     size_t ncols_categ,    int ncat[],
              double sample_weights[], double col_weights[]);
 
+    void fit(double numeric_data[],   size_t ncols_numeric,  size_t nrows,
+             int    categ_data[],     size_t ncols_categ,    int ncat[],
+             bool   is_col_major,     size_t ld_numeric,     size_t ld_categ,
+             double sample_weights[], double col_weights[]);
+
     void fit(double Xc[], int Xc_ind[], int Xc_indptr[],
              size_t ncols_numeric,      size_t nrows,
              int    categ_data[],       size_t ncols_categ,   int ncat[],
@@ -185,6 +195,18 @@ public:
                  int categ_data[], bool is_col_major, size_t ld_categ, size_t nrows, bool standardize,
                  double output_depths[], int tree_num[], double per_tree_depths[]);
 
+    PredictionContext get_prediction_context(bool standardize=true) const;
+
+    static double score_row(const PredictionContext &context, const double numeric_row[], const int categ_row[]=nullptr);
+
+    size_t predict_stream(std::istream &input, std::ostream &output, size_t ncols_numeric,
+                          bool csv_input, char delimiter, bool skip_header, bool binary_output,
+                          bool standardize, size_t chunk_rows=0);
+
+    size_t predict_stream(const char *input_file, const char *output_file, size_t ncols_numeric,
+                          bool csv_input, char delimiter, bool skip_header, bool binary_output,
+                          bool standardize, size_t chunk_rows=0);
+
     std::vector<double> predict_distance(double X[], size_t nrows,
                                          bool as_kernel,
                                          bool assume_full_distr, bool standardize,
@@ -213,6 +235,8 @@ public:
 
     void build_indexer(const bool with_distances);
 
+    void reorder_nodes();
+
     void set_as_reference_points(double numeric_data[], int categ_data[], bool is_col_major,
                                  size_t nrows, size_t ld_numeric, size_t ld_categ,
                                  const bool with_distances);
@@ -258,6 +282,8 @@ public:
                        const std::vector<std::string> &categ_colnames,
                        const std::vector<std::vector<std::string>> &categ_levels) const;
 
+    std::string to_cpp(const std::string &function_name, bool standardize=true) const;
+
     void serialize(FILE *out) const;
 
     void serialize(std::ostream &out) const;
@@ -284,9 +310,17 @@ public:
 
     bool check_can_predict_per_tree() const;
 
+    void build_compiled();
+    void clear_compiled();
+
 private:
     bool is_fitted = false;
+    bool has_compiled = false;
+    CompiledIsoForest compiled;
+    CompiledExtIsoForest compiled_ext;
 
+    bool predict_compiled(double numeric_data[], bool is_col_major, size_t nrows, size_t ld_numeric,
+                          bool standardize, double output_depths[], int tree_num[], double per_tree_depths[]) const;
     void override_previous_fit();
     void check_params();
     void check_is_fitted() const;
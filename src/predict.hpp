@@ -62,10 +62,6 @@
 */
 #include "isotree.hpp"
 
-/* TODO: should create versions of these functions that would work on the
-   serialized raw bytes instead, as it will likely be faster due to better
-   cache utilizations and those objects use less memory. */
-
 /* TODO: these trees are all created in a depth-first fashion, which will
    not be cache-friendly when predictions are sent to a right-side branch. In
    order to make predictions faster, could re-arrange the trees after-the-fact
@@ -212,6 +208,8 @@ void predict_iforest(real_t *restrict numeric_data, int *restrict categ_data,
     int nthreads_orig = nthreads;
     if ((size_t)nthreads > nrows)
         nthreads = nrows;
+    bool tree_num_is_mapped = false;
+    Executor *executor = get_thread_executor();
 
     /* For batch predictions of sparse CSC, will take a specialized route */
     if (prediction_data.Xc_indptr != NULL && (prediction_data.categ_data == NULL || prediction_data.is_col_major))
@@ -227,66 +225,33 @@ void predict_iforest(real_t *restrict numeric_data, int *restrict categ_data,
     {
         if (
             model_outputs->missing_action == Fail &&
-            (model_outputs->new_cat_action != Weighted || model_outputs->cat_split_type == SingleCateg || prediction_data.categ_data == NULL) &&
+            prediction_data.categ_data == NULL &&
             prediction_data.Xc_indptr == NULL && prediction_data.Xr_indptr == NULL &&
-            !model_outputs->has_range_penalty
+            !model_outputs->has_range_penalty &&
+            should_use_compiled_forest(*model_outputs, nrows)
             )
         {
-            if (prediction_data.categ_data == NULL && (nrows == 1 || !prediction_data.is_col_major))
-            {
-                #pragma omp parallel for if(nrows > 1) schedule(static) num_threads(nthreads) \
-                        shared(nrows, model_outputs, prediction_data, output_depths, tree_num, per_tree_depths)
-                for (size_t_for row = 0; row < (decltype(row))nrows; row++)
-                {
-                    double score = 0;
-                    for (size_t tree = 0; tree < model_outputs->trees.size(); tree++)
-                    {
-                        traverse_itree_fast(model_outputs->trees[tree],
-                                            *model_outputs,
-                                            prediction_data.numeric_data + row * prediction_data.ncols_numeric,
-                                            score,
-                                            (tree_num == NULL)? NULL : (tree_num + nrows * tree),
-                                            (per_tree_depths == NULL)?
-                                                NULL : (per_tree_depths + tree + row*model_outputs->trees.size()),
-                                            (size_t) row);
-                    }
-                    output_depths[row] = score;
-                }
-            }
-
-            else
-            {
-                #pragma omp parallel for if(nrows > 1) schedule(static) num_threads(nthreads) \
-                        shared(nrows, model_outputs, prediction_data, output_depths, tree_num, per_tree_depths)
-                for (size_t_for row = 0; row < (decltype(row))nrows; row++)
-                {
-                    double score = 0;
-                    for (size_t tree = 0; tree < model_outputs->trees.size(); tree++)
-                    {
-                        traverse_itree_no_recurse(model_outputs->trees[tree],
-                                                  *model_outputs,
-                                                  prediction_data,
-                                                  score,
-                                                  (tree_num == NULL)? NULL : (tree_num + nrows * tree),
-                                                  (per_tree_depths == NULL)?
-                                                      NULL : (per_tree_depths + tree + row*model_outputs->trees.size()),
-                                                  (size_t) row);
-                    }
-                    output_depths[row] = score;
-                }
-            }
+            CompiledIsoForest compiled;
+            build_compiled_forest(compiled, *model_outputs, false, nthreads);
+            predict_compiled_forest(prediction_data.numeric_data, prediction_data.is_col_major,
+                                    prediction_data.ncols_numeric, nrows, nthreads,
+                                    compiled, compiled.num_split.data(),
+                                    output_depths, tree_num, per_tree_depths);
+            tree_num_is_mapped = true;
         }
 
-        else
+        /* Cases that need to follow both branches of a node (e.g. 'missing_action=Divide')
+           or which have sparse CSC data with row-major categoricals take the generic route */
+        else if (!predict_itree_specialized(prediction_data, nrows, nthreads, *model_outputs,
+                                            output_depths, tree_num, per_tree_depths))
         {
-            bool threw_exception = false;
+            std::atomic<bool> threw_exception(false);
             std::exception_ptr ex = NULL;
 
-            #pragma omp parallel for if(nrows > 1) schedule(static) num_threads(nthreads) \
-                    shared(nrows, model_outputs, prediction_data, output_depths, tree_num, per_tree_depths, threw_exception, ex)
-            for (size_t_for row = 0; row < (decltype(row))nrows; row++)
+            auto predict_row = [&](size_t row, int thread_id)
             {
-                if (threw_exception) continue;
+                (void)thread_id;
+                if (threw_exception) return;
                 double score = 0;
                 try
                 {
@@ -308,16 +273,10 @@ void predict_iforest(real_t *restrict numeric_data, int *restrict categ_data,
                 }
                 catch (...)
                 {
-                    #pragma omp critical
-                    {
-                        if (!threw_exception)
-                        {
-                            threw_exception = true;
-                            ex = std::current_exception();
-                        }
-                    }
+                    catch_task_exception(threw_exception, ex);
                 }
-            }
+            };
+            run_parallel_for(executor, nrows, nthreads, false, predict_row);
 
             if (threw_exception)
                 std::rethrow_exception(ex);
@@ -325,186 +284,157 @@ void predict_iforest(real_t *restrict numeric_data, int *restrict categ_data,
     }
     
 
+    else if (
+        model_outputs_ext->missing_action == Fail &&
+        prediction_data.categ_data == NULL &&
+        prediction_data.Xc_indptr == NULL && prediction_data.Xr_indptr == NULL &&
+        !model_outputs_ext->has_range_penalty &&
+        should_use_compiled_forest(*model_outputs_ext, nrows)
+        )
+    {
+        CompiledExtIsoForest compiled;
+        build_compiled_forest(compiled, *model_outputs_ext, nthreads);
+        predict_compiled_forest(prediction_data.numeric_data, prediction_data.is_col_major,
+                                prediction_data.ncols_numeric, nrows, nthreads,
+                                compiled,
+                                output_depths, tree_num, per_tree_depths);
+        tree_num_is_mapped = true;
+    }
+
     else
     {
+        const size_t ntrees = model_outputs_ext->hplanes.size();
+
+        /* Large models are evaluated in blocks of trees that fit in the cache */
+        std::vector<size_t> tree_blocks;
+        size_t row_block = 1;
+        bool use_tree_blocks = prediction_data.Xr_indptr == NULL &&
+                               get_tree_blocks(*model_outputs_ext, nrows, get_row_bytes(prediction_data), nthreads,
+                                               tree_blocks, row_block);
+
+        bool fast_traversal = model_outputs_ext->missing_action == Fail &&
+                              prediction_data.categ_data == NULL &&
+                              prediction_data.Xc_indptr == NULL &&
+                              !model_outputs_ext->has_range_penalty;
+
+        /* Large batches of sparse CSR rows are scattered into dense rows instead of searching for each column */
+        size_t ncols_dense;
         if (
-            model_outputs_ext->missing_action == Fail &&
-            prediction_data.categ_data == NULL &&
-            prediction_data.Xc_indptr == NULL &&
-            prediction_data.Xr_indptr == NULL &&
-            !model_outputs_ext->has_range_penalty
+            prediction_data.Xr_indptr != NULL &&
+            (prediction_data.categ_data == NULL || !prediction_data.is_col_major) &&
+            should_scatter_csr_rows(*model_outputs_ext, nrows, nthreads, ncols_dense)
             )
         {
-            if (prediction_data.is_col_major && nrows > 1)
+            auto predict_row = [&](size_t row, decltype(prediction_data) &dense_data)
             {
-                #pragma omp parallel for if(nrows > 1) schedule(static) num_threads(nthreads) \
-                        shared(nrows, model_outputs_ext, prediction_data, output_depths, tree_num, per_tree_depths)
-                for (size_t_for row = 0; row < (decltype(row))nrows; row++)
+                double depth = 0;
+                for (size_t tree = 0; tree < ntrees; tree++)
                 {
-                    double score = 0;
-                    for (size_t tree = 0; tree < model_outputs_ext->hplanes.size(); tree++)
-                    {
-                        traverse_hplane_fast_colmajor(model_outputs_ext->hplanes[tree],
+                    if (fast_traversal)
+                        traverse_hplane_fast_rowmajor(model_outputs_ext->hplanes[tree],
                                                       *model_outputs_ext,
-                                                      prediction_data,
-                                                      score,
+                                                      dense_data.numeric_data,
+                                                      depth,
                                                       (tree_num == NULL)? NULL : (tree_num + nrows * tree),
                                                       (per_tree_depths == NULL)?
-                                                            NULL : (per_tree_depths + tree + row*model_outputs_ext->hplanes.size()),
-                                                      (size_t) row);
-                    }
-                    output_depths[row] = score;
+                                                            NULL : (per_tree_depths + tree + row*ntrees),
+                                                      row);
+                    else
+                        traverse_hplane(model_outputs_ext->hplanes[tree],
+                                        *model_outputs_ext,
+                                        dense_data,
+                                        depth,
+                                        (std::vector<ImputeNode>*)NULL,
+                                        (ImputedData<sparse_ix, double>*)NULL,
+                                        (tree_num == NULL)? NULL : (tree_num + nrows * tree),
+                                        (per_tree_depths == NULL)?
+                                            NULL : (per_tree_depths + tree + row*ntrees),
+                                        row);
                 }
+                output_depths[row] = depth;
+            };
+            predict_by_scattered_rows(prediction_data, nrows, nthreads, ncols_dense, predict_row);
+        }
+
+        else if (fast_traversal && prediction_data.Xr_indptr == NULL)
+        {
+            if (prediction_data.is_col_major && nrows > 1)
+            {
+                auto add_tree_depth = [&](size_t row, size_t tree, double &depth)
+                {
+                    traverse_hplane_fast_colmajor(model_outputs_ext->hplanes[tree],
+                                                  *model_outputs_ext,
+                                                  prediction_data,
+                                                  depth,
+                                                  (tree_num == NULL)? NULL : (tree_num + nrows * tree),
+                                                  (per_tree_depths == NULL)?
+                                                        NULL : (per_tree_depths + tree + row*ntrees),
+                                                  row);
+                };
+                if (use_tree_blocks)
+                    predict_by_tree_blocks(tree_blocks, row_block, nrows, nthreads, output_depths, add_tree_depth);
+                else
+                    predict_by_rows(nrows, ntrees, nthreads, output_depths, add_tree_depth);
             }
 
             else
             {
-                #pragma omp parallel for if(nrows > 1) schedule(static) num_threads(nthreads) \
-                        shared(nrows, model_outputs_ext, prediction_data, output_depths, tree_num, per_tree_depths)
-                for (size_t_for row = 0; row < (decltype(row))nrows; row++)
+                auto add_tree_depth = [&](size_t row, size_t tree, double &depth)
                 {
-                    double score = 0;
-                    for (size_t tree = 0; tree < model_outputs_ext->hplanes.size(); tree++)
-                    {
-                        traverse_hplane_fast_rowmajor(model_outputs_ext->hplanes[tree],
-                                                      *model_outputs_ext,
-                                                      prediction_data.numeric_data + row * prediction_data.ncols_numeric,
-                                                      score,
-                                                      (tree_num == NULL)? NULL : (tree_num + nrows * tree),
-                                                      (per_tree_depths == NULL)?
-                                                            NULL : (per_tree_depths + tree + row*model_outputs_ext->hplanes.size()),
-                                                      (size_t) row);
-                    }
-                    output_depths[row] = score;
-                }
+                    traverse_hplane_fast_rowmajor(model_outputs_ext->hplanes[tree],
+                                                  *model_outputs_ext,
+                                                  prediction_data.numeric_data + row * prediction_data.ncols_numeric,
+                                                  depth,
+                                                  (tree_num == NULL)? NULL : (tree_num + nrows * tree),
+                                                  (per_tree_depths == NULL)?
+                                                        NULL : (per_tree_depths + tree + row*ntrees),
+                                                  row);
+                };
+                if (use_tree_blocks)
+                    predict_by_tree_blocks(tree_blocks, row_block, nrows, nthreads, output_depths, add_tree_depth);
+                else
+                    predict_by_rows(nrows, ntrees, nthreads, output_depths, add_tree_depth);
             }
         }
 
         else
         {
-            #pragma omp parallel for if(nrows > 1) schedule(static) num_threads(nthreads) \
-                    shared(nrows, model_outputs_ext, prediction_data, output_depths, tree_num, per_tree_depths)
-            for (size_t_for row = 0; row < (decltype(row))nrows; row++)
+            auto add_tree_depth = [&](size_t row, size_t tree, double &depth)
             {
-                double score = 0;
-                for (size_t tree = 0; tree < model_outputs_ext->hplanes.size(); tree++)
-                {
-                    traverse_hplane(model_outputs_ext->hplanes[tree],
-                                    *model_outputs_ext,
-                                    prediction_data,
-                                    score,
-                                    (std::vector<ImputeNode>*)NULL,
-                                    (ImputedData<sparse_ix, double>*)NULL,
-                                    (tree_num == NULL)? NULL : (tree_num + nrows * tree),
-                                    (per_tree_depths == NULL)?
-                                        NULL : (per_tree_depths + tree + row*model_outputs_ext->hplanes.size()),
-                                    (size_t) row);
-                }
-                output_depths[row] = score;
-            }
+                traverse_hplane(model_outputs_ext->hplanes[tree],
+                                *model_outputs_ext,
+                                prediction_data,
+                                depth,
+                                (std::vector<ImputeNode>*)NULL,
+                                (ImputedData<sparse_ix, double>*)NULL,
+                                (tree_num == NULL)? NULL : (tree_num + nrows * tree),
+                                (per_tree_depths == NULL)?
+                                    NULL : (per_tree_depths + tree + row*ntrees),
+                                row);
+            };
+            if (use_tree_blocks)
+                predict_by_tree_blocks(tree_blocks, row_block, nrows, nthreads, output_depths, add_tree_depth);
+            else
+                predict_by_rows(nrows, ntrees, nthreads, output_depths, add_tree_depth);
         }
     }
 
     /* translate sum-of-depths to outlier score */
-    double ntrees, depth_divisor;
     if (model_outputs != NULL)
-    {
-        ntrees = (double) model_outputs->trees.size();
-        depth_divisor = ntrees * (model_outputs->exp_avg_depth);
-    }
-
-    else
-    {
-        ntrees = (double) model_outputs_ext->hplanes.size();
-        depth_divisor = ntrees * (model_outputs_ext->exp_avg_depth);
-    }
-
-    
-    /* for density and boxed_ratio, each tree will have 'log(d)'' instead of 'd' */
-    bool is_density = (model_outputs != NULL && model_outputs->scoring_metric == Density) ||
-                      (model_outputs_ext != NULL && model_outputs_ext->scoring_metric == Density);
-    bool is_bratio  = (model_outputs != NULL && model_outputs->scoring_metric == BoxedRatio) ||
-                      (model_outputs_ext != NULL && model_outputs_ext->scoring_metric == BoxedRatio);
-    bool is_bdens   = (model_outputs != NULL && model_outputs->scoring_metric == BoxedDensity) ||
-                      (model_outputs_ext != NULL && model_outputs_ext->scoring_metric == BoxedDensity);
-    bool is_bdens2  = (model_outputs != NULL && model_outputs->scoring_metric == BoxedDensity2) ||
-                      (model_outputs_ext != NULL && model_outputs_ext->scoring_metric == BoxedDensity2);
-
-    if (standardize)
-    {
-        if (is_density || is_bdens2)
-        {
-            ntrees = -ntrees;
-            for (size_t row = 0; row < nrows; row++)
-                output_depths[row] /= ntrees;
-        }
-
-        else if (is_bdens)
-        {
-            #ifndef _WIN32
-            #pragma omp simd
-            #endif
-            for (size_t row = 0; row < nrows; row++)
-                output_depths[row] = -std::exp(output_depths[row] / ntrees);
-        }
-
-        else if (is_bratio)
-        {
-            for (size_t row = 0; row < nrows; row++)
-                output_depths[row] = output_depths[row] / ntrees;
-        }
-
-        else
-        {
-            #ifndef _WIN32
-            #pragma omp simd
-            #endif
-            for (size_t row = 0; row < nrows; row++)
-                output_depths[row] = std::exp2( - output_depths[row] / depth_divisor );
-        }
-    }
-
+        depths_to_scores(output_depths, per_tree_depths,
+                         nrows, model_outputs->trees.size(), model_outputs->exp_avg_depth,
+                         model_outputs->scoring_metric, standardize);
     else
-    {
-        if (is_density || is_bdens || is_bdens2)
-        {
-            #ifndef _WIN32
-            #pragma omp simd
-            #endif
-            for (size_t row = 0; row < nrows; row++)
-                output_depths[row] = std::exp(output_depths[row] / ntrees);
-        }
-
-        else if (is_bratio)
-        {
-            ntrees = -ntrees;
-            for (size_t row = 0; row < nrows; row++)
-                output_depths[row] /= ntrees;
-        }
-
-        else
-        {
-            for (size_t row = 0; row < nrows; row++)
-                output_depths[row] /= ntrees;
-        }
-    }
-
-    if (per_tree_depths != NULL && (is_density || is_bdens || is_bdens2))
-    {
-        size_t ntrees = (model_outputs != NULL)? model_outputs->trees.size() : model_outputs_ext->hplanes.size();
-        #ifndef _WIN32
-        #pragma omp simd
-        #endif
-        for (size_t ix = 0; ix < nrows*ntrees; ix++)
-            per_tree_depths[ix] = std::exp(per_tree_depths[ix]);
-    }
+        depths_to_scores(output_depths, per_tree_depths,
+                         nrows, model_outputs_ext->hplanes.size(), model_outputs_ext->exp_avg_depth,
+                         model_outputs_ext->scoring_metric, standardize);
 
 
     /* re-map tree numbers to start at zero (if predicting tree numbers) */
     /* Note: usually this type of 'prediction' is not required,
        thus this mapping is not stored in the model objects so as to
        save memory */
-    if (tree_num != NULL)
+    if (tree_num != NULL && !tree_num_is_mapped)
     {
         if (indexer != NULL && !indexer->indices.empty())
         {
@@ -536,167 +466,301 @@ void predict_iforest(real_t *restrict numeric_data, int *restrict categ_data,
     }
 }
 
-template <class real_t, class sparse_ix>
-void traverse_itree_fast(std::vector<IsoTree>  &tree,
-                         IsoForest             &model_outputs,
-                         real_t *restrict      row_numeric_data,
-                         double &restrict      output_depth,
-                         sparse_ix *restrict   tree_num,
-                         double *restrict      tree_depth,
-                         size_t                row) noexcept
+/* Predict with single-variable trees through a traversal kernel that is specialized at compile time for
+   the format of the data and the settings of the model. Returns 'false' without doing anything when the
+   combination is not covered by the specialized kernels, in which case 'traverse_itree' should be used. */
+template <class PredictionData, class sparse_ix>
+bool predict_itree_specialized(PredictionData &prediction_data, size_t nrows, int nthreads,
+                               const IsoForest &model_outputs,
+                               double *restrict output_depths, sparse_ix *restrict tree_num,
+                               double *restrict per_tree_depths)
 {
-    size_t curr_lev = 0;
-    double xval;
-    while (true)
+    if (model_outputs.missing_action == Divide)
+        return false;
+
+    CategConfig categ_config;
+    if (prediction_data.categ_data == NULL)
+        categ_config = CategNone;
+    else if (model_outputs.cat_split_type == SingleCateg)
+        categ_config = CategSingle;
+    else if (model_outputs.new_cat_action == Random)
+        categ_config = CategSubSetRandom;
+    else if (model_outputs.new_cat_action == Smallest)
+        categ_config = CategSubSetSmallest;
+    else
+        return false;
+
+    if (prediction_data.Xr_indptr != NULL)
+        predict_itree_dispatch_categ<SparseCSR>(prediction_data, nrows, nthreads, model_outputs, categ_config,
+                                                output_depths, tree_num, per_tree_depths);
+    else if (prediction_data.Xc_indptr != NULL)
+        return false;
+    else if (prediction_data.is_col_major)
+        predict_itree_dispatch_categ<DenseColMajor>(prediction_data, nrows, nthreads, model_outputs, categ_config,
+                                                    output_depths, tree_num, per_tree_depths);
+    else
+        predict_itree_dispatch_categ<DenseRowMajor>(prediction_data, nrows, nthreads, model_outputs, categ_config,
+                                                    output_depths, tree_num, per_tree_depths);
+    return true;
+}
+
+template <NumericConfig numeric_config, class PredictionData, class sparse_ix>
+void predict_itree_dispatch_categ(PredictionData &prediction_data, size_t nrows, int nthreads,
+                                  const IsoForest &model_outputs, CategConfig categ_config,
+                                  double *restrict output_depths, sparse_ix *restrict tree_num,
+                                  double *restrict per_tree_depths)
+{
+    switch (categ_config)
     {
-        if (unlikely(tree[curr_lev].tree_left == 0))
+        case CategNone:
         {
-            output_depth += tree[curr_lev].score;
-            if (unlikely(tree_num != NULL))
-                tree_num[row] = curr_lev;
-            if (unlikely(tree_depth != NULL))
-                *tree_depth = tree[curr_lev].score;
+            predict_itree_dispatch_missing<numeric_config, CategNone>(prediction_data, nrows, nthreads, model_outputs,
+                                                                      output_depths, tree_num, per_tree_depths);
             break;
         }
 
-        else
+        case CategSingle:
+        {
+            predict_itree_dispatch_missing<numeric_config, CategSingle>(prediction_data, nrows, nthreads, model_outputs,
+                                                                        output_depths, tree_num, per_tree_depths);
+            break;
+        }
+
+        case CategSubSetRandom:
+        {
+            predict_itree_dispatch_missing<numeric_config, CategSubSetRandom>(prediction_data, nrows, nthreads, model_outputs,
+                                                                              output_depths, tree_num, per_tree_depths);
+            break;
+        }
+
+        case CategSubSetSmallest:
         {
-            xval     = row_numeric_data[tree[curr_lev].col_num];
-            curr_lev = (xval <= tree[curr_lev].num_split)?
-                        tree[curr_lev].tree_left : tree[curr_lev].tree_right;
+            predict_itree_dispatch_missing<numeric_config, CategSubSetSmallest>(prediction_data, nrows, nthreads, model_outputs,
+                                                                                output_depths, tree_num, per_tree_depths);
+            break;
         }
     }
 }
 
-template <class PredictionData, class sparse_ix>
-void traverse_itree_no_recurse(std::vector<IsoTree>  &tree,
-                               IsoForest             &model_outputs,
-                               PredictionData        &prediction_data,
-                               double &restrict      output_depth,
-                               sparse_ix *restrict   tree_num,
-                               double *restrict      tree_depth,
-                               size_t                row) noexcept
+template <NumericConfig numeric_config, CategConfig categ_config, class PredictionData, class sparse_ix>
+void predict_itree_dispatch_missing(PredictionData &prediction_data, size_t nrows, int nthreads,
+                                    const IsoForest &model_outputs,
+                                    double *restrict output_depths, sparse_ix *restrict tree_num,
+                                    double *restrict per_tree_depths)
+{
+    bool impute_missing = model_outputs.missing_action == Impute;
+    if (impute_missing && model_outputs.has_range_penalty)
+        predict_itree_kernel<numeric_config, categ_config, true, true>(prediction_data, nrows, nthreads, model_outputs,
+                                                                       output_depths, tree_num, per_tree_depths);
+    else if (impute_missing)
+        predict_itree_kernel<numeric_config, categ_config, true, false>(prediction_data, nrows, nthreads, model_outputs,
+                                                                        output_depths, tree_num, per_tree_depths);
+    else if (model_outputs.has_range_penalty)
+        predict_itree_kernel<numeric_config, categ_config, false, true>(prediction_data, nrows, nthreads, model_outputs,
+                                                                        output_depths, tree_num, per_tree_depths);
+    else
+        predict_itree_kernel<numeric_config, categ_config, false, false>(prediction_data, nrows, nthreads, model_outputs,
+                                                                         output_depths, tree_num, per_tree_depths);
+}
+
+template <NumericConfig numeric_config, CategConfig categ_config, bool impute_missing, bool has_range_penalty,
+          class PredictionData, class sparse_ix>
+void predict_itree_kernel(PredictionData &prediction_data, size_t nrows, int nthreads,
+                          const IsoForest &model_outputs,
+                          double *restrict output_depths, sparse_ix *restrict tree_num,
+                          double *restrict per_tree_depths)
+{
+    const size_t ntrees = model_outputs.trees.size();
+
+    /* Large batches of sparse CSR rows are scattered into dense rows instead of searching for each column */
+    size_t ncols_dense;
+    if (numeric_config == SparseCSR && should_scatter_csr_rows(model_outputs, nrows, nthreads, ncols_dense))
+    {
+        auto predict_row = [&](size_t row, PredictionData &dense_data)
+        {
+            double score = 0;
+            for (size_t tree = 0; tree < ntrees; tree++)
+            {
+                score += traverse_itree_specialized<DenseRowMajor, categ_config, impute_missing, has_range_penalty,
+                                                    !impute_missing>
+                                                   (model_outputs.trees[tree],
+                                                    dense_data,
+                                                    row, (const sparse_ix*)NULL, (const sparse_ix*)NULL,
+                                                    (tree_num == NULL)? NULL : (tree_num + nrows * tree),
+                                                    (per_tree_depths == NULL)?
+                                                        NULL : (per_tree_depths + tree + row*ntrees));
+            }
+            output_depths[row] = score;
+        };
+        predict_by_scattered_rows(prediction_data, nrows, nthreads, ncols_dense, predict_row);
+        return;
+    }
+
+    /* Large models are evaluated in blocks of trees that fit in the cache */
+    std::vector<size_t> tree_blocks;
+    size_t row_block = 1;
+    if (numeric_config != SparseCSR &&
+        get_tree_blocks(model_outputs, nrows, get_row_bytes(prediction_data), nthreads, tree_blocks, row_block))
+    {
+        auto add_tree_depth = [&](size_t row, size_t tree, double &depth)
+        {
+            depth += traverse_itree_specialized<numeric_config, categ_config, impute_missing, has_range_penalty>
+                                               (model_outputs.trees[tree],
+                                                prediction_data,
+                                                row, (const sparse_ix*)NULL, (const sparse_ix*)NULL,
+                                                (tree_num == NULL)? NULL : (tree_num + nrows * tree),
+                                                (per_tree_depths == NULL)?
+                                                    NULL : (per_tree_depths + tree + row*ntrees));
+        };
+        predict_by_tree_blocks(tree_blocks, row_block, nrows, nthreads, output_depths, add_tree_depth);
+        return;
+    }
+
+    auto predict_row = [&](size_t row, int thread_id)
+    {
+        (void)thread_id;
+        const sparse_ix *row_st = NULL, *row_end = NULL;
+        if (numeric_config == SparseCSR)
+        {
+            row_st  = prediction_data.Xr_ind + prediction_data.Xr_indptr[row];
+            row_end = prediction_data.Xr_ind + prediction_data.Xr_indptr[row + 1];
+        }
+
+        double score = 0;
+        for (size_t tree = 0; tree < ntrees; tree++)
+        {
+            score += traverse_itree_specialized<numeric_config, categ_config, impute_missing, has_range_penalty>
+                                               (model_outputs.trees[tree],
+                                                prediction_data,
+                                                (size_t) row, row_st, row_end,
+                                                (tree_num == NULL)? NULL : (tree_num + nrows * tree),
+                                                (per_tree_depths == NULL)?
+                                                    NULL : (per_tree_depths + tree + row*ntrees));
+        }
+        output_depths[row] = score;
+    };
+    run_parallel_for(get_thread_executor(), nrows, nthreads, false, predict_row);
+}
+
+/* Note: with 'missing_action=Fail', missing values are not checked for, and will go to the right branch, unless
+   passing 'missing_as_nan', in which case the score is NAN as in 'traverse_itree'. By default, this is done in the
+   same cases in which 'traverse_itree' was used instead of 'traverse_itree_no_recurse' for such models. */
+template <NumericConfig numeric_config, CategConfig categ_config, bool impute_missing, bool has_range_penalty,
+          bool missing_as_nan, class PredictionData, class sparse_ix>
+static inline double traverse_itree_specialized(const std::vector<IsoTree> &tree,
+                                                PredictionData            &prediction_data,
+                                                size_t                    row,
+                                                const sparse_ix           *row_st,
+                                                const sparse_ix           *row_end,
+                                                sparse_ix *restrict       tree_num,
+                                                double *restrict          tree_depth) noexcept
 {
+    const IsoTree *restrict nodes = tree.data();
     size_t curr_lev = 0;
+    double range_penalty = 0;
     double xval;
     int    cval;
-    while (true)
+
+    while (nodes[curr_lev].tree_left)
     {
-        // if (tree[curr_lev].score > 0)
-        if (unlikely(tree[curr_lev].tree_left == 0))
-        {
-            output_depth += tree[curr_lev].score;
-            if (unlikely(tree_num != NULL))
-                tree_num[row] = curr_lev;
-            if (unlikely(tree_depth != NULL))
-                *tree_depth = tree[curr_lev].score;
-            break;
-        }
+        const IsoTree &node = nodes[curr_lev];
 
-        else
+        if (categ_config == CategNone || node.col_type == Numeric)
         {
-            switch (tree[curr_lev].col_type)
+            switch (numeric_config)
             {
-                case Numeric:
+                case DenseRowMajor:
                 {
-                    xval =  prediction_data.numeric_data[
-                                prediction_data.is_col_major?
-                                (row + tree[curr_lev].col_num * prediction_data.nrows)
-                                    :
-                                (tree[curr_lev].col_num + row * prediction_data.ncols_numeric)
-                            ];
-                    curr_lev = (xval <= tree[curr_lev].num_split)?
-                                tree[curr_lev].tree_left : tree[curr_lev].tree_right;
+                    xval = prediction_data.numeric_data[node.col_num + row * prediction_data.ncols_numeric];
                     break;
                 }
 
-                case Categorical:
+                case DenseColMajor:
                 {
-                    cval =  prediction_data.categ_data[
-                                prediction_data.is_col_major?
-                                (row +  tree[curr_lev].col_num * prediction_data.nrows)
-                                    :
-                                (tree[curr_lev].col_num + row * prediction_data.ncols_categ)
-                            ];
-                    switch (model_outputs.cat_split_type)
-                    {
-                        case SubSet:
-                        {
+                    xval = prediction_data.numeric_data[row + node.col_num * prediction_data.nrows];
+                    break;
+                }
 
-                            if (tree[curr_lev].cat_split.empty()) /* this is for binary columns */
-                            {
-                                if (cval <= 1)
-                                {
-                                    curr_lev = (cval == 0)?
-                                                tree[curr_lev].tree_left : tree[curr_lev].tree_right;
-                                }
+                case SparseCSR:
+                {
+                    xval = extract_spR(prediction_data, row_st, row_end, node.col_num);
+                    break;
+                }
 
-                                else /* can only work with 'Smallest' + no NAs if reaching this point */
-                                {
-                                    curr_lev =  (tree[curr_lev].pct_tree_left < .5)? tree[curr_lev].tree_left : tree[curr_lev].tree_right;
-                                }
-                            }
+                default:
+                {
+                    xval = extract_spC(prediction_data, row, node.col_num);
+                    break;
+                }
+            }
 
-                            else
-                            {
+            if (impute_missing && unlikely(std::isnan(xval)))
+            {
+                curr_lev = (node.pct_tree_left >= .5)? node.tree_left : node.tree_right;
+                continue;
+            }
 
-                                switch (model_outputs.new_cat_action)
-                                {
-                                    case Random:
-                                    {
-                                        cval = (cval >= (int)tree[curr_lev].cat_split.size())?
-                                                (cval % (int)tree[curr_lev].cat_split.size()) : cval;
-                                        curr_lev = (tree[curr_lev].cat_split[cval])?
-                                                    tree[curr_lev].tree_left : tree[curr_lev].tree_right;
-                                        break;
-                                    }
+            if (missing_as_nan && unlikely(std::isnan(xval)))
+                return NAN;
 
-                                    case Smallest:
-                                    {
-                                        if (unlikely(cval >= (int)tree[curr_lev].cat_split.size()))
-                                        {
-                                            curr_lev =  (tree[curr_lev].pct_tree_left < .5)? tree[curr_lev].tree_left : tree[curr_lev].tree_right;
-                                        }
+            if (has_range_penalty)
+                range_penalty += (xval < node.range_low) || (xval > node.range_high);
+            curr_lev = (xval <= node.num_split)? node.tree_left : node.tree_right;
+        }
 
-                                        else
-                                        {
-                                            curr_lev = (tree[curr_lev].cat_split[cval])?
-                                                        tree[curr_lev].tree_left : tree[curr_lev].tree_right;
-                                        }
-                                        break;
-                                    }
+        else
+        {
+            cval =  prediction_data.categ_data[
+                        prediction_data.is_col_major?
+                        (row + node.col_num * prediction_data.nrows)
+                            :
+                        (node.col_num + row * prediction_data.ncols_categ)
+                    ];
+
+            if (impute_missing && unlikely(cval < 0))
+            {
+                curr_lev = (node.pct_tree_left >= .5)? node.tree_left : node.tree_right;
+                continue;
+            }
 
-                                    default:
-                                    {
-                                        assert(0);
-                                        break;
-                                    }
-                                }
-                            }
-                            break;
-                        }
+            if (missing_as_nan && unlikely(cval < 0))
+                return NAN;
 
-                        case SingleCateg:
-                        {
-                            curr_lev = (cval == tree[curr_lev].chosen_cat)?
-                                        tree[curr_lev].tree_left : tree[curr_lev].tree_right;
-                            break;
-                        }
-                    }
-                    break;
-                }
+            if (categ_config == CategSingle)
+            {
+                curr_lev = (cval == node.chosen_cat)? node.tree_left : node.tree_right;
+            }
 
-                default:
-                {
-                    assert(0);
-                    break;
-                }
+            else if (node.cat_split.empty()) /* this is for binary columns */
+            {
+                if (cval <= 1)
+                    curr_lev = (cval == 0)? node.tree_left : node.tree_right;
+                else
+                    curr_lev = (node.pct_tree_left < .5)? node.tree_left : node.tree_right;
+            }
+
+            else if (categ_config == CategSubSetRandom)
+            {
+                cval = (cval >= (int)node.cat_split.size())? (cval % (int)node.cat_split.size()) : cval;
+                curr_lev = (node.cat_split[cval])? node.tree_left : node.tree_right;
+            }
+
+            else
+            {
+                if (unlikely(cval >= (int)node.cat_split.size()))
+                    curr_lev = (node.pct_tree_left < .5)? node.tree_left : node.tree_right;
+                else
+                    curr_lev = (node.cat_split[cval])? node.tree_left : node.tree_right;
             }
         }
     }
-}
 
-enum NumericConfig {DenseRowMajor, DenseColMajor, SparseCSR, SparseCSC};
+    if (unlikely(tree_num != NULL))
+        tree_num[row] = curr_lev;
+    if (unlikely(tree_depth != NULL))
+        *tree_depth = nodes[curr_lev].score;
+    return nodes[curr_lev].score - range_penalty;
+}
 
 template <class PredictionData, class sparse_ix, class ImputedData>
 double traverse_itree(std::vector<IsoTree>     &tree,
@@ -1270,35 +1334,82 @@ void batched_csc_predict(PredictionData<real_t, sparse_ix> &prediction_data, int
                          double *restrict output_depths,   sparse_ix *restrict tree_num,
                          double *restrict per_tree_depths)
 {
-    #ifdef _OPENMP
     size_t ntrees = (model_outputs != NULL)? model_outputs->trees.size() : model_outputs_ext->hplanes.size();
-    if ((size_t)nthreads > ntrees)
+    Executor *executor = get_thread_executor();
+    if (executor != NULL)
+        nthreads = executor->num_workers();
+    #ifdef _OPENMP
+    else if ((size_t)nthreads > ntrees)
         nthreads = ntrees;
     #else
-    nthreads = 1;
+    else
+        nthreads = 1;
     #endif
+
+    /* Each tree starts from the rows in their original order and adds up its depths into a separate
+       buffer, and the buffers are then added to the output in the order of the trees, so that the
+       results are the same for any number of threads.
+       Trees are processed in rounds of as many trees as there are threads, with each tree in a round
+       using the buffer of its position in the round, which is swapped into the memory of the thread
+       that processes it. The buffers of a round are added up by rows, also in parallel. */
     std::vector<WorkerForPredictCSC> worker_memory(nthreads);
+    std::vector<std::vector<double>> round_depths(nthreads, std::vector<double>(prediction_data.nrows));
+    std::fill(output_depths, output_depths + prediction_data.nrows, (double)0);
+    const size_t rows_per_thread = (prediction_data.nrows + nthreads - 1) / nthreads;
+    size_t round_st, round_size;
 
-    bool threw_exception = false;
+    std::atomic<bool> threw_exception(false);
     std::exception_ptr ex = NULL;
 
+    auto predict_tree_in_round = [&](size_t pos, int thread_id, const std::function<void(size_t, int)> &predict_tree)
+    {
+        if (threw_exception) return;
+        std::vector<double> &depths = worker_memory[thread_id].depths;
+        depths.swap(round_depths[pos]);
+        std::fill(depths.begin(), depths.end(), (double)0);
+        predict_tree(round_st + pos, thread_id);
+        depths.swap(round_depths[pos]);
+    };
+
+    auto add_round_depths = [&](size_t chunk, int thread_id)
+    {
+        (void)thread_id;
+        size_t row_st = chunk * rows_per_thread;
+        size_t row_end = std::min(prediction_data.nrows, row_st + rows_per_thread);
+        for (size_t pos = 0; pos < round_size; pos++)
+        {
+            const double *restrict depths = round_depths[pos].data();
+            #if !defined(_MSC_VER) && !defined(_WIN32)
+            #pragma omp simd
+            #endif
+            for (size_t row = row_st; row < row_end; row++)
+                output_depths[row] += depths[row];
+        }
+    };
+
+    auto predict_all_rounds = [&](const std::function<void(size_t, int)> &predict_tree)
+    {
+        auto predict_pos = [&](size_t pos, int thread_id){predict_tree_in_round(pos, thread_id, predict_tree);};
+        for (round_st = 0; round_st < ntrees; round_st += nthreads)
+        {
+            round_size = std::min((size_t)nthreads, ntrees - round_st);
+            run_parallel_for(executor, round_size, nthreads, false, predict_pos);
+            if (threw_exception) return;
+            run_parallel_for(executor, (size_t)nthreads, nthreads, false, add_round_depths);
+        }
+    };
+
     if (model_outputs != NULL)
     {
-        #pragma omp parallel for schedule(dynamic) num_threads(nthreads) \
-                shared(worker_memory, model_outputs, prediction_data, tree_num, per_tree_depths, threw_exception, ex)
-        for (size_t_for tree = 0; tree < (decltype(tree))model_outputs->trees.size(); tree++)
+        auto predict_tree = [&](size_t tree, int thread_id)
         {
-            if (threw_exception) continue;
+            if (threw_exception) return;
             try
             {
-                WorkerForPredictCSC *ptr_worker = &worker_memory[omp_get_thread_num()];
-                if (!ptr_worker->depths.size())
+                WorkerForPredictCSC *ptr_worker = &worker_memory[thread_id];
+                if (!ptr_worker->ix_arr.size())
                 {
-                    ptr_worker->depths.resize(prediction_data.nrows);
                     ptr_worker->ix_arr.resize(prediction_data.nrows);
-                    std::iota(ptr_worker->ix_arr.begin(),
-                              ptr_worker->ix_arr.end(),
-                              (size_t)0);
 
                     if (model_outputs->missing_action == Divide ||
                         (model_outputs->new_cat_action == Weighted && model_outputs->cat_split_type == SubSet && prediction_data.categ_data != NULL)
@@ -1307,9 +1418,13 @@ void batched_csc_predict(PredictionData<real_t, sparse_ix> &prediction_data, int
                     }
                 }
 
+                /* the traversal leaves the rows in a different order, and does not always sort them again */
+                std::iota(ptr_worker->ix_arr.begin(),
+                          ptr_worker->ix_arr.end(),
+                          (size_t)0);
                 ptr_worker->st  = 0;
                 ptr_worker->end = prediction_data.nrows - 1;
-                if (model_outputs->missing_action == Divide)
+                if (!ptr_worker->weights_arr.empty())
                     std::fill(ptr_worker->weights_arr.begin(),
                               ptr_worker->weights_arr.end(),
                               (double)1);
@@ -1320,45 +1435,37 @@ void batched_csc_predict(PredictionData<real_t, sparse_ix> &prediction_data, int
                                    prediction_data,
                                    (tree_num == NULL)?
                                         ((sparse_ix*)NULL) : (tree_num + tree*prediction_data.nrows),
-                                   per_tree_depths,
+                                   (per_tree_depths == NULL)?
+                                       NULL : (per_tree_depths + tree),
                                    (size_t)0,
                                    model_outputs->has_range_penalty);
             }
 
             catch (...)
             {
-                #pragma omp critical
-                {
-                    if (!threw_exception)
-                    {
-                        threw_exception = true;
-                        ex = std::current_exception();
-                    }
-                }
+                catch_task_exception(threw_exception, ex);
             }
-        }
+        };
+        predict_all_rounds(predict_tree);
     }
 
     else
     {
-        #pragma omp parallel for schedule(dynamic) num_threads(nthreads) \
-                shared(worker_memory, model_outputs_ext, prediction_data, tree_num, per_tree_depths, threw_exception, ex)
-        for (size_t_for tree = 0; tree < (decltype(tree))model_outputs_ext->hplanes.size(); tree++)
+        auto predict_tree = [&](size_t tree, int thread_id)
         {
-            if (threw_exception) continue;
+            if (threw_exception) return;
             try
             {
-                WorkerForPredictCSC *ptr_worker = &worker_memory[omp_get_thread_num()];
-                if (!ptr_worker->depths.size())
+                WorkerForPredictCSC *ptr_worker = &worker_memory[thread_id];
+                if (!ptr_worker->ix_arr.size())
                 {
-                    ptr_worker->depths.resize(prediction_data.nrows);
                     ptr_worker->comb_val.resize(prediction_data.nrows);
                     ptr_worker->ix_arr.resize(prediction_data.nrows);
-                    std::iota(ptr_worker->ix_arr.begin(),
-                              ptr_worker->ix_arr.end(),
-                              (size_t)0);
                 }
 
+                std::iota(ptr_worker->ix_arr.begin(),
+                          ptr_worker->ix_arr.end(),
+                          (size_t)0);
                 ptr_worker->st  = 0;
                 ptr_worker->end = prediction_data.nrows - 1;
 
@@ -1368,48 +1475,22 @@ void batched_csc_predict(PredictionData<real_t, sparse_ix> &prediction_data, int
                                     prediction_data,
                                     (tree_num == NULL)?
                                         ((sparse_ix*)NULL) : (tree_num + tree*prediction_data.nrows),
-                                    per_tree_depths,
+                                    (per_tree_depths == NULL)?
+                                        NULL : (per_tree_depths + tree),
                                     (size_t)0,
                                     model_outputs_ext->has_range_penalty);
             }
 
             catch (...)
             {
-                #pragma omp critical
-                {
-                    if (!threw_exception)
-                    {
-                        threw_exception = true;
-                        ex = std::current_exception();
-                    }
-                }
+                catch_task_exception(threw_exception, ex);
             }
-        }
+        };
+        predict_all_rounds(predict_tree);
     }
 
     if (threw_exception)
         std::rethrow_exception(ex);
-
-    #ifdef _OPENMP
-    if (nthreads <= 1)
-    #endif
-    {
-        std::copy(worker_memory.front().depths.begin(), worker_memory.front().depths.end(), output_depths);
-    }
-
-    #ifdef _OPENMP
-    else
-    {
-        std::fill(output_depths, output_depths + prediction_data.nrows, (double)0);
-        for (auto &workspace : worker_memory)
-            if (workspace.depths.size())
-                #if !defined(_MSC_VER) && !defined(_WIN32)
-                #pragma omp simd
-                #endif
-                for (size_t row = 0; row < prediction_data.nrows; row++)
-                    output_depths[row] += workspace.depths[row];
-    }
-    #endif
 }
 
 template <class PredictionData, class sparse_ix>
@@ -1425,7 +1506,7 @@ void traverse_itree_csc(WorkerForPredictCSC   &workspace,
     // if (trees[curr_tree].score >= 0)
     if (unlikely(trees[curr_tree].tree_left == 0))
     {
-        if (model_outputs.missing_action != Divide)
+        if (workspace.weights_arr.empty())
             for (size_t row = workspace.st; row <= workspace.end; row++)
                 workspace.depths[workspace.ix_arr[row]] += trees[curr_tree].score;
         else
@@ -1436,12 +1517,14 @@ void traverse_itree_csc(WorkerForPredictCSC   &workspace,
                 tree_num[workspace.ix_arr[row]] = curr_tree;
         if (unlikely(per_tree_depths != NULL))
             for (size_t row = workspace.st; row <= workspace.end; row++)
-                per_tree_depths[workspace.ix_arr[row]] = trees[curr_tree].score;
+                per_tree_depths[workspace.ix_arr[row] * model_outputs.trees.size()] = trees[curr_tree].score;
         return;
     }
 
-    /* in this case, the indices are sorted in the csc penalty function */
-    if (!(has_range_penalty && model_outputs.missing_action != Divide && curr_tree > 0) && trees[curr_tree].col_type == Numeric)
+    /* the csc penalty function leaves the indices sorted, but not the categorical splits, nor
+       the rows with missing values that are added back to a branch */
+    if (trees[curr_tree].col_type == Numeric &&
+        !std::is_sorted(workspace.ix_arr.begin() + workspace.st, workspace.ix_arr.begin() + workspace.end + 1))
         std::sort(workspace.ix_arr.begin() + workspace.st, workspace.ix_arr.begin() + workspace.end + 1);
 
     /* TODO: should mix the splitting function with the range penalty */
@@ -1502,7 +1585,7 @@ void traverse_itree_csc(WorkerForPredictCSC   &workspace,
     }
 
     /* continue splitting recursively */
-    if (unlikely(model_outputs.new_cat_action == Weighted && model_outputs.cat_split_type == SubSet && prediction_data.categ_data != NULL))
+    if (unlikely(model_outputs.new_cat_action == Weighted && model_outputs.cat_split_type == SubSet && trees[curr_tree].col_type == Categorical))
         goto missing_action_divide;
     switch (model_outputs.missing_action)
     {
@@ -1520,7 +1603,7 @@ void traverse_itree_csc(WorkerForPredictCSC   &workspace,
                 if (has_range_penalty && trees[curr_tree].col_type == Numeric)
                     add_csc_range_penalty(workspace,
                                           prediction_data,
-                                          (double*)NULL,
+                                          workspace.weights_arr.empty()? (double*)NULL : workspace.weights_arr.data(),
                                           trees[curr_tree].col_num,
                                           trees[curr_tree].range_low,
                                           trees[curr_tree].range_high);
@@ -1544,7 +1627,7 @@ void traverse_itree_csc(WorkerForPredictCSC   &workspace,
                 if (has_range_penalty && trees[curr_tree].col_type == Numeric)
                     add_csc_range_penalty(workspace,
                                           prediction_data,
-                                          (double*)NULL,
+                                          workspace.weights_arr.empty()? (double*)NULL : workspace.weights_arr.data(),
                                           trees[curr_tree].col_num,
                                           trees[curr_tree].range_low,
                                           trees[curr_tree].range_high);
@@ -1570,8 +1653,10 @@ void traverse_itree_csc(WorkerForPredictCSC   &workspace,
             std::vector<size_t> ix_arr;
             if (end_NA > workspace.st)
             {
-                weights_arr.assign(workspace.weights_arr.begin(),
-                                   workspace.weights_arr.begin() + end_NA);
+                /* the weights are indexed by row number, so they are copied here by position in 'ix_arr' */
+                weights_arr.resize(end_NA);
+                for (size_t row = st_NA; row < end_NA; row++)
+                    weights_arr[row] = workspace.weights_arr[workspace.ix_arr[row]];
                 ix_arr.assign(workspace.ix_arr.data(),
                               workspace.ix_arr.data() + end_NA);
             }
@@ -1592,7 +1677,7 @@ void traverse_itree_csc(WorkerForPredictCSC   &workspace,
                                           trees[curr_tree].range_high);
                 }
 
-                if (workspace.end >= end_NA)
+                if (end >= end_NA)
                 {
                     workspace.st = end_NA;
                     workspace.end = end;
@@ -1631,12 +1716,11 @@ void traverse_itree_csc(WorkerForPredictCSC   &workspace,
                 workspace.end = orig_end;
                 if (weights_arr.size())
                 {
-                    std::copy(weights_arr.begin(),
-                              weights_arr.end(),
-                              workspace.weights_arr.begin());
                     std::copy(ix_arr.begin(),
                               ix_arr.end(),
                               workspace.ix_arr.begin());
+                    for (size_t row = st_NA; row < end_NA; row++)
+                        workspace.weights_arr[workspace.ix_arr[row]] = weights_arr[row];
                     weights_arr.clear();
                     weights_arr.shrink_to_fit();
                     ix_arr.clear();
@@ -1679,7 +1763,7 @@ void traverse_hplane_csc(WorkerForPredictCSC      &workspace,
                 tree_num[workspace.ix_arr[row]] = curr_tree;
         if (unlikely(per_tree_depths != NULL))
             for (size_t row = workspace.st; row <= workspace.end; row++)
-                per_tree_depths[workspace.ix_arr[row]] = hplanes[curr_tree].score;
+                per_tree_depths[workspace.ix_arr[row] * model_outputs.hplanes.size()] = hplanes[curr_tree].score;
         return;
     }
 
@@ -1895,6 +1979,90 @@ void throw_unsupported_pred_error()
     );
 }
 
+/* Translates the sums of depths across trees into average depths or outlier scores,
+   according to the scoring metric of the model */
+void depths_to_scores(double *restrict output_depths, double *restrict per_tree_depths,
+                      size_t nrows, size_t ntrees_, double exp_avg_depth,
+                      ScoringMetric scoring_metric, bool standardize)
+{
+    double ntrees = (double) ntrees_;
+    double depth_divisor = ntrees * exp_avg_depth;
+
+    /* for density and boxed_ratio, each tree will have 'log(d)'' instead of 'd' */
+    bool is_density = scoring_metric == Density;
+    bool is_bratio  = scoring_metric == BoxedRatio;
+    bool is_bdens   = scoring_metric == BoxedDensity;
+    bool is_bdens2  = scoring_metric == BoxedDensity2;
+
+    if (standardize)
+    {
+        if (is_density || is_bdens2)
+        {
+            ntrees = -ntrees;
+            for (size_t row = 0; row < nrows; row++)
+                output_depths[row] /= ntrees;
+        }
+
+        else if (is_bdens)
+        {
+            #ifndef _WIN32
+            #pragma omp simd
+            #endif
+            for (size_t row = 0; row < nrows; row++)
+                output_depths[row] = -std::exp(output_depths[row] / ntrees);
+        }
+
+        else if (is_bratio)
+        {
+            for (size_t row = 0; row < nrows; row++)
+                output_depths[row] = output_depths[row] / ntrees;
+        }
+
+        else
+        {
+            #ifndef _WIN32
+            #pragma omp simd
+            #endif
+            for (size_t row = 0; row < nrows; row++)
+                output_depths[row] = std::exp2( - output_depths[row] / depth_divisor );
+        }
+    }
+
+    else
+    {
+        if (is_density || is_bdens || is_bdens2)
+        {
+            #ifndef _WIN32
+            #pragma omp simd
+            #endif
+            for (size_t row = 0; row < nrows; row++)
+                output_depths[row] = std::exp(output_depths[row] / ntrees);
+        }
+
+        else if (is_bratio)
+        {
+            ntrees = -ntrees;
+            for (size_t row = 0; row < nrows; row++)
+                output_depths[row] /= ntrees;
+        }
+
+        else
+        {
+            for (size_t row = 0; row < nrows; row++)
+                output_depths[row] /= ntrees;
+        }
+    }
+
+    if (per_tree_depths != NULL && (is_density || is_bdens || is_bdens2))
+    {
+        #ifndef _WIN32
+        #pragma omp simd
+        #endif
+        for (size_t ix = 0; ix < nrows*ntrees_; ix++)
+            per_tree_depths[ix] = std::exp(per_tree_depths[ix]);
+    }
+}
+
 template <class PredictionData>
 double extract_spC(const PredictionData &prediction_data, size_t row, size_t col_num) noexcept
 {
@@ -1942,28 +2110,30 @@ template <class sparse_ix>
 void get_num_nodes(const IsoForest &model_outputs, sparse_ix *restrict n_nodes, sparse_ix *restrict n_terminal, int nthreads) noexcept
 {
     std::fill(n_terminal, n_terminal + model_outputs.trees.size(), 0);
-    #pragma omp parallel for schedule(static) num_threads(nthreads) shared(model_outputs, n_nodes, n_terminal)
-    for (size_t_for tree = 0; tree < (decltype(tree))model_outputs.trees.size(); tree++)
+    auto count_nodes = [&](size_t tree, int thread_id)
     {
+        (void)thread_id;
         n_nodes[tree] = model_outputs.trees[tree].size();
         for (const IsoTree &node : model_outputs.trees[tree])
         {
             n_terminal[tree] += (node.tree_left == 0);
         }
-    }
+    };
+    run_parallel_for(get_thread_executor(), model_outputs.trees.size(), nthreads, false, count_nodes);
 }
 
 template <class sparse_ix>
 void get_num_nodes(const ExtIsoForest &model_outputs, sparse_ix *restrict n_nodes, sparse_ix *restrict n_terminal, int nthreads) noexcept
 {
     std::fill(n_terminal, n_terminal + model_outputs.hplanes.size(), 0);
-    #pragma omp parallel for schedule(static) num_threads(nthreads) shared(model_outputs, n_nodes, n_terminal)
-    for (size_t_for hplane = 0; hplane <(decltype(hplane)) model_outputs.hplanes.size(); hplane++)
+    auto count_nodes = [&](size_t hplane, int thread_id)
     {
+        (void)thread_id;
         n_nodes[hplane] = model_outputs.hplanes[hplane].size();
         for (const IsoHPlane &node : model_outputs.hplanes[hplane])
         {
             n_terminal[hplane] += (node.hplane_left == 0);
         }
-    }
+    };
+    run_parallel_for(get_thread_executor(), model_outputs.hplanes.size(), nthreads, false, count_nodes);
 }
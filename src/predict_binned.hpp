@@ -0,0 +1,207 @@
+/*    Isolation forests and variations thereof, with adjustments for incorporation
+*     of categorical variables and missing values.
+*     Writen for C++11 standard and aimed at being used in R and Python.
+*     
+*     This library is based on the following works:
+*     [1] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation forest."
+*         2008 Eighth IEEE International Conference on Data Mining. IEEE, 2008.
+*     [2] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation-based anomaly detection."
+*         ACM Transactions on Knowledge Discovery from Data (TKDD) 6.1 (2012): 3.
+*     [3] Hariri, Sahand, Matias Carrasco Kind, and Robert J. Brunner.
+*         "Extended Isolation Forest."
+*         arXiv preprint arXiv:1811.02141 (2018).
+*     [4] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "On detecting clustered anomalies using SCiForest."
+*         Joint European Conference on Machine Learning and Knowledge Discovery in Databases. Springer, Berlin, Heidelberg, 2010.
+*     [5] https://sourceforge.net/projects/iforest/
+*     [6] https://math.stackexchange.com/questions/3388518/expected-number-of-paths-required-to-separate-elements-in-a-binary-tree
+*     [7] Quinlan, J. Ross. C4. 5: programs for machine learning. Elsevier, 2014.
+*     [8] Cortes, David.
+*         "Distance approximation using Isolation Forests."
+*         arXiv preprint arXiv:1910.12362 (2019).
+*     [9] Cortes, David.
+*         "Imputing missing values with unsupervised random trees."
+*         arXiv preprint arXiv:1911.06646 (2019).
+*     [10] https://math.stackexchange.com/questions/3333220/expected-average-depth-in-random-binary-tree-constructed-top-to-bottom
+*     [11] Cortes, David.
+*          "Revisiting randomized choices in isolation forests."
+*          arXiv preprint arXiv:2110.13402 (2021).
+*     [12] Guha, Sudipto, et al.
+*          "Robust random cut forest based anomaly detection on streams."
+*          International conference on machine learning. PMLR, 2016.
+*     [13] Cortes, David.
+*          "Isolation forests: looking beyond tree depth."
+*          arXiv preprint arXiv:2111.11639 (2021).
+*     [14] Ting, Kai Ming, Yue Zhu, and Zhi-Hua Zhou.
+*          "Isolation kernel and its effect on SVM"
+*          Proceedings of the 24th ACM SIGKDD
+*          International Conference on Knowledge Discovery & Data Mining. 2018.
+* 
+*     BSD 2-Clause License
+*     Copyright (c) 2019-2024, David Cortes
+*     All rights reserved.
+*     Redistribution and use in source and binary forms, with or without
+*     modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this
+*       list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*       this list of conditions and the following disclaimer in the documentation
+*       and/or other materials provided with the distribution.
+*     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+*     AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+*     IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*     FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*     DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*     SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*     CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*     OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*     OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "isotree.hpp"
+
+/* Convert numeric data to the bin indices used by a binned model
+* 
+* Parameters
+* ==========
+* - numeric_data[nrows * ncols_numeric]
+*       Pointer to numeric data to convert. Must be ordered by columns like Fortran,
+*       not ordered by rows like C (i.e. entries 1..n contain column 0, n+1..2n column 1, etc.),
+*       unless passing 'is_col_major=false'. Missing values are assigned to the last bin
+*       of their column, which leads to the same results as 'predict_iforest' would give.
+* - is_col_major
+*       Whether 'numeric_data' comes in column-major order. If passing 'false', data must
+*       come in row-major order.
+* - ld_numeric
+*       Leading dimension of the array 'numeric_data', if it is passed in row-major format.
+*       Ignored when passing the data in column-major order.
+* - nrows
+*       Number of rows in 'numeric_data'.
+* - nthreads
+*       Number of parallel threads to use.
+* - plan
+*       Binned model object, as produced by 'build_bin_plan'. Only the first 'plan.ncols_numeric'
+*       columns of the data are converted.
+* - binned_data[nrows * plan.ncols_numeric] (out)
+*       Pointer to array where the bin indices will be written into, in row-major order.
+*       Must be of type 'uint16_t' if 'plan.wide_bins' is 'true', and can be of either
+*       'uint8_t' or 'uint16_t' otherwise.
+*/
+template <class real_t, class bin_t>
+void bin_numeric_data(real_t *restrict numeric_data, bool is_col_major, size_t ld_numeric,
+                      size_t nrows, int nthreads,
+                      const BinPlan &plan, bin_t *restrict binned_data)
+{
+    if (unlikely(plan.wide_bins && sizeof(bin_t) < sizeof(uint16_t)))
+        throw std::runtime_error("Binned model requires 16-bit bin indices.\n");
+    if (unlikely(!nrows)) return;
+    if ((size_t)nthreads > nrows)
+        nthreads = nrows;
+
+    const size_t ncols_numeric = plan.ncols_numeric;
+    const size_t col_stride = is_col_major? nrows : 1;
+    const size_t row_stride = is_col_major? 1 : ld_numeric;
+
+    auto bin_row = [&](size_t row, int thread_id)
+    {
+        (void)thread_id;
+        const real_t *restrict row_numeric_data = numeric_data + row * row_stride;
+        bin_t *restrict row_binned_data = binned_data + row * ncols_numeric;
+        for (size_t col = 0; col < ncols_numeric; col++)
+        {
+            const double *col_st = plan.thresholds.data() + plan.col_offsets[col];
+            const double *col_end = plan.thresholds.data() + plan.col_offsets[col+1];
+            const double xval = row_numeric_data[col * col_stride];
+            /* NaNs go right on every node, so they are placed after all of the thresholds */
+            row_binned_data[col] = unlikely(std::isnan(xval))?
+                                   (bin_t)(col_end - col_st)
+                                       :
+                                   (bin_t)(std::lower_bound(col_st, col_end, xval) - col_st);
+        }
+    };
+    run_parallel_for(get_thread_executor(), nrows, nthreads, false, bin_row);
+}
+
+/* Predict outlier scores using a binned model on data that has been converted to bin indices
+* 
+* Parameters
+* ==========
+* - binned_data[nrows * plan.ncols_numeric]
+*       Pointer to bin indices for which to make predictions, in row-major order, as produced
+*       by 'bin_numeric_data'.
+* - nrows
+*       Number of rows in 'binned_data'.
+* - nthreads
+*       Number of parallel threads to use.
+* - standardize
+*       Whether to standardize the average depths for each row according to their relative magnitude
+*       compared to the expected average, in order to obtain an outlier score. If passing 'false',
+*       will output the average depth instead.
+* - plan
+*       Binned model object, as produced by 'build_bin_plan'.
+* - output_depths[nrows] (out)
+*       Pointer to array where the output average depths or outlier scores will be written into.
+* - tree_num[nrows * ntrees] (out)
+*       Pointer to array where the output terminal node numbers will be written into, in the
+*       same format as 'predict_iforest' (column-major order, numbered from zero).
+*       Pass NULL if this type of output is not needed.
+* - per_tree_depths[nrows * ntrees] (out)
+*       Pointer to array where to output per-tree depths for each row, in row-major order.
+*       Pass NULL if this type of output is not needed.
+*/
+template <class bin_t, class sparse_ix>
+void predict_iforest_binned(const bin_t *restrict binned_data, size_t nrows, int nthreads, bool standardize,
+                            const BinPlan &plan,
+                            double *restrict output_depths, sparse_ix *restrict tree_num,
+                            double *restrict per_tree_depths)
+{
+    if (unlikely(!nrows)) return;
+    if ((size_t)nthreads > nrows)
+        nthreads = nrows;
+
+    const size_t ntrees = plan.tree_offsets.size() - 1;
+    const size_t ncols_numeric = plan.ncols_numeric;
+    const size_t *restrict tree_offsets = plan.tree_offsets.data();
+    const uint32_t *restrict col_num = plan.col_num.data();
+    const uint32_t *restrict tree_left = plan.tree_left.data();
+    const uint16_t *restrict split_bin = plan.split_bin.data();
+    const double *restrict score = plan.score.data();
+
+    auto predict_row = [&](size_t row, int thread_id)
+    {
+        (void)thread_id;
+        const bin_t *restrict row_binned_data = binned_data + row * ncols_numeric;
+        double depth = 0;
+        for (size_t tree = 0; tree < ntrees; tree++)
+        {
+            size_t st = tree_offsets[tree];
+            size_t node = st + traverse_binned_tree(col_num + st, tree_left + st, split_bin + st,
+                                                    row_binned_data);
+            depth += score[node];
+            if (unlikely(tree_num != NULL))
+                tree_num[row + tree * nrows] = col_num[node];
+            if (unlikely(per_tree_depths != NULL))
+                per_tree_depths[tree + row * ntrees] = score[node];
+        }
+        output_depths[row] = depth;
+    };
+    run_parallel_for(get_thread_executor(), nrows, nthreads, false, predict_row);
+
+    depths_to_scores(output_depths, per_tree_depths,
+                     nrows, ntrees, plan.exp_avg_depth,
+                     plan.scoring_metric, standardize);
+}
+
+template <class bin_t>
+static inline size_t traverse_binned_tree(const uint32_t *restrict col_num,
+                                          const uint32_t *restrict tree_left,
+                                          const uint16_t *restrict split_bin,
+                                          const bin_t *restrict    row_binned_data) noexcept
+{
+    size_t node = 0;
+    while (tree_left[node])
+        node = tree_left[node] + (row_binned_data[col_num[node]] > split_bin[node]);
+    return node;
+}
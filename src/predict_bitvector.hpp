@@ -0,0 +1,187 @@
+/*    Isolation forests and variations thereof, with adjustments for incorporation
+*     of categorical variables and missing values.
+*     Writen for C++11 standard and aimed at being used in R and Python.
+*     
+*     This library is based on the following works:
+*     [1] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation forest."
+*         2008 Eighth IEEE International Conference on Data Mining. IEEE, 2008.
+*     [2] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation-based anomaly detection."
+*         ACM Transactions on Knowledge Discovery from Data (TKDD) 6.1 (2012): 3.
+*     [3] Hariri, Sahand, Matias Carrasco Kind, and Robert J. Brunner.
+*         "Extended Isolation Forest."
+*         arXiv preprint arXiv:1811.02141 (2018).
+*     [4] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "On detecting clustered anomalies using SCiForest."
+*         Joint European Conference on Machine Learning and Knowledge Discovery in Databases. Springer, Berlin, Heidelberg, 2010.
+*     [5] https://sourceforge.net/projects/iforest/
+*     [6] https://math.stackexchange.com/questions/3388518/expected-number-of-paths-required-to-separate-elements-in-a-binary-tree
+*     [7] Quinlan, J. Ross. C4. 5: programs for machine learning. Elsevier, 2014.
+*     [8] Cortes, David.
+*         "Distance approximation using Isolation Forests."
+*         arXiv preprint arXiv:1910.12362 (2019).
+*     [9] Cortes, David.
+*         "Imputing missing values with unsupervised random trees."
+*         arXiv preprint arXiv:1911.06646 (2019).
+*     [10] https://math.stackexchange.com/questions/3333220/expected-average-depth-in-random-binary-tree-constructed-top-to-bottom
+*     [11] Cortes, David.
+*          "Revisiting randomized choices in isolation forests."
+*          arXiv preprint arXiv:2110.13402 (2021).
+*     [12] Guha, Sudipto, et al.
+*          "Robust random cut forest based anomaly detection on streams."
+*          International conference on machine learning. PMLR, 2016.
+*     [13] Cortes, David.
+*          "Isolation forests: looking beyond tree depth."
+*          arXiv preprint arXiv:2111.11639 (2021).
+*     [14] Ting, Kai Ming, Yue Zhu, and Zhi-Hua Zhou.
+*          "Isolation kernel and its effect on SVM"
+*          Proceedings of the 24th ACM SIGKDD
+*          International Conference on Knowledge Discovery & Data Mining. 2018.
+* 
+*     BSD 2-Clause License
+*     Copyright (c) 2019-2024, David Cortes
+*     All rights reserved.
+*     Redistribution and use in source and binary forms, with or without
+*     modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this
+*       list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*       this list of conditions and the following disclaimer in the documentation
+*       and/or other materials provided with the distribution.
+*     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+*     AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+*     IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*     FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*     DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*     SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*     CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*     OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*     OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "isotree.hpp"
+
+/* Predict outlier scores using a single-variable model arranged for feature-by-feature evaluation
+* 
+* Parameters
+* ==========
+* - numeric_data[nrows * ncols_numeric]
+*       Pointer to numeric data for which to make predictions. Must be ordered by columns like Fortran,
+*       not ordered by rows like C (i.e. entries 1..n contain column 0, n+1..2n column 1, etc.),
+*       unless passing 'is_col_major=false'. Cannot contain missing values.
+* - is_col_major
+*       Whether 'numeric_data' comes in column-major order. If passing 'false', data must
+*       come in row-major order.
+* - ld_numeric
+*       Leading dimension of the array 'numeric_data', if it is passed in row-major format.
+*       Ignored when passing the data in column-major order.
+* - nrows
+*       Number of rows in 'numeric_data'.
+* - nthreads
+*       Number of parallel threads to use.
+* - standardize
+*       Whether to standardize the average depths for each row according to their relative magnitude
+*       compared to the expected average, in order to obtain an outlier score. If passing 'false',
+*       will output the average depth instead.
+* - bv_forest
+*       Rearranged model object, as produced by 'build_bitvector_forest'.
+* - output_depths[nrows] (out)
+*       Pointer to array where the output average depths or outlier scores will be written into.
+* - tree_num[nrows * ntrees] (out)
+*       Pointer to array where the output terminal node numbers will be written into, in the
+*       same format as 'predict_iforest' (column-major order, numbered from zero).
+*       Pass NULL if this type of output is not needed.
+* - per_tree_depths[nrows * ntrees] (out)
+*       Pointer to array where to output per-tree depths for each row, in row-major order.
+*       Pass NULL if this type of output is not needed.
+*/
+template <class real_t, class sparse_ix>
+void predict_iforest_bitvector(real_t *restrict numeric_data, bool is_col_major, size_t ld_numeric,
+                               size_t nrows, int nthreads, bool standardize,
+                               const BitvectorIsoForest &bv_forest,
+                               double *restrict output_depths, sparse_ix *restrict tree_num,
+                               double *restrict per_tree_depths)
+{
+    if (unlikely(!nrows)) return;
+    /* each worker needs its own bitvectors, so the executor, if any, determines how many are allocated */
+    Executor *executor = get_thread_executor();
+    if (executor != NULL)
+        nthreads = executor->num_workers();
+    else if ((size_t)nthreads > nrows)
+        nthreads = nrows;
+
+    const size_t ntrees = bv_forest.leaf_offsets.size() - 1;
+    const size_t col_stride = is_col_major? nrows : 1;
+    const size_t row_stride = is_col_major? 1 : ld_numeric;
+    const size_t bitvectors_size = ntrees * bv_forest.words_per_tree;
+    std::unique_ptr<uint64_t[]> bitvectors(new uint64_t[(size_t)nthreads * bitvectors_size]);
+
+    auto predict_row = [&](size_t row, int thread_id)
+    {
+        output_depths[row] = evaluate_bitvector_row(numeric_data + row * row_stride, col_stride,
+                                                    bv_forest,
+                                                    bitvectors.get() + (size_t)thread_id * bitvectors_size,
+                                                    row, nrows, tree_num, per_tree_depths);
+    };
+    run_parallel_for(executor, nrows, nthreads, false, predict_row);
+
+    depths_to_scores(output_depths, per_tree_depths,
+                     nrows, ntrees, bv_forest.exp_avg_depth,
+                     bv_forest.scoring_metric, standardize);
+}
+
+static inline size_t lowest_set_bit(uint64_t bits) noexcept
+{
+    #if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(bits);
+    #else
+    size_t pos = 0;
+    while (!(bits & 1)) {
+        bits >>= 1;
+        pos++;
+    }
+    return pos;
+    #endif
+}
+
+/* Note: this outputs the sum of depths and the terminal node numbers already mapped */
+template <class real_t, class sparse_ix>
+static inline double evaluate_bitvector_row(const real_t *restrict row_numeric_data, size_t col_stride,
+                                            const BitvectorIsoForest &bv_forest, uint64_t *restrict bitvectors,
+                                            size_t row, size_t nrows,
+                                            sparse_ix *restrict tree_num, double *restrict per_tree_depths) noexcept
+{
+    const size_t ntrees = bv_forest.leaf_offsets.size() - 1;
+    const size_t words_per_tree = bv_forest.words_per_tree;
+    const double *restrict thresholds = bv_forest.thresholds.data();
+    const uint32_t *restrict cond_word = bv_forest.cond_word.data();
+    const uint64_t *restrict cond_mask = bv_forest.cond_mask.data();
+    std::fill(bitvectors, bitvectors + ntrees * words_per_tree, ~(uint64_t)0);
+
+    /* Thresholds are sorted, so once the row goes left on a node, it also goes left on all the
+       remaining nodes for that column. Note that NaNs go right on every node, like in the
+       node-by-node traversal. */
+    for (size_t col = 0; col < bv_forest.ncols_numeric; col++)
+    {
+        const double xval = row_numeric_data[col * col_stride];
+        const size_t end = bv_forest.col_offsets[col+1];
+        for (size_t ix = bv_forest.col_offsets[col]; ix < end && !(xval <= thresholds[ix]); ix++)
+            bitvectors[cond_word[ix]] &= cond_mask[ix];
+    }
+
+    double depth = 0;
+    for (size_t tree = 0; tree < ntrees; tree++)
+    {
+        const uint64_t *restrict tree_bitvector = bitvectors + tree * words_per_tree;
+        size_t word = 0;
+        while (!tree_bitvector[word]) word++;
+        const size_t leaf = bv_forest.leaf_offsets[tree] + word * 64 + lowest_set_bit(tree_bitvector[word]);
+        depth += bv_forest.leaf_score[leaf];
+        if (unlikely(tree_num != NULL))
+            tree_num[row + tree * nrows] = bv_forest.leaf_terminal[leaf];
+        if (unlikely(per_tree_depths != NULL))
+            per_tree_depths[tree + row * ntrees] = bv_forest.leaf_score[leaf];
+    }
+    return depth;
+}
@@ -0,0 +1,131 @@
+/*    Isolation forests and variations thereof, with adjustments for incorporation
+*     of categorical variables and missing values.
+*     Writen for C++11 standard and aimed at being used in R and Python.
+*     
+*     This library is based on the following works:
+*     [1] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation forest."
+*         2008 Eighth IEEE International Conference on Data Mining. IEEE, 2008.
+*     [2] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation-based anomaly detection."
+*         ACM Transactions on Knowledge Discovery from Data (TKDD) 6.1 (2012): 3.
+*     [3] Hariri, Sahand, Matias Carrasco Kind, and Robert J. Brunner.
+*         "Extended Isolation Forest."
+*         arXiv preprint arXiv:1811.02141 (2018).
+*     [4] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "On detecting clustered anomalies using SCiForest."
+*         Joint European Conference on Machine Learning and Knowledge Discovery in Databases. Springer, Berlin, Heidelberg, 2010.
+*     [5] https://sourceforge.net/projects/iforest/
+*     [6] https://math.stackexchange.com/questions/3388518/expected-number-of-paths-required-to-separate-elements-in-a-binary-tree
+*     [7] Quinlan, J. Ross. C4. 5: programs for machine learning. Elsevier, 2014.
+*     [8] Cortes, David.
+*         "Distance approximation using Isolation Forests."
+*         arXiv preprint arXiv:1910.12362 (2019).
+*     [9] Cortes, David.
+*         "Imputing missing values with unsupervised random trees."
+*         arXiv preprint arXiv:1911.06646 (2019).
+*     [10] https://math.stackexchange.com/questions/3333220/expected-average-depth-in-random-binary-tree-constructed-top-to-bottom
+*     [11] Cortes, David.
+*          "Revisiting randomized choices in isolation forests."
+*          arXiv preprint arXiv:2110.13402 (2021).
+*     [12] Guha, Sudipto, et al.
+*          "Robust random cut forest based anomaly detection on streams."
+*          International conference on machine learning. PMLR, 2016.
+*     [13] Cortes, David.
+*          "Isolation forests: looking beyond tree depth."
+*          arXiv preprint arXiv:2111.11639 (2021).
+*     [14] Ting, Kai Ming, Yue Zhu, and Zhi-Hua Zhou.
+*          "Isolation kernel and its effect on SVM"
+*          Proceedings of the 24th ACM SIGKDD
+*          International Conference on Knowledge Discovery & Data Mining. 2018.
+* 
+*     BSD 2-Clause License
+*     Copyright (c) 2019-2024, David Cortes
+*     All rights reserved.
+*     Redistribution and use in source and binary forms, with or without
+*     modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this
+*       list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*       this list of conditions and the following disclaimer in the documentation
+*       and/or other materials provided with the distribution.
+*     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+*     AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+*     IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*     FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*     DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*     SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*     CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*     OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*     OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "isotree.hpp"
+
+/* Adds up the depths from each tree for each row, visiting the trees in the blocks given by
+   'tree_blocks' (as determined by 'get_tree_blocks'), and streaming blocks of 'row_block' rows
+   through each block of trees, so that a block stays in the CPU cache while it is used for
+   many rows instead of being evicted by the remaining trees at every row.
+
+   Each row accumulates its depths in the same order as when iterating over all the trees for
+   that row, so the results are exactly the same as without blocking.
+
+   'add_tree_depth(row, tree, depth)' should add the depth of 'row' in 'tree' to 'depth'. */
+template <class AddTreeDepth>
+void predict_by_tree_blocks(const std::vector<size_t> &tree_blocks, size_t row_block,
+                            size_t nrows, int nthreads,
+                            double *restrict output_depths, AddTreeDepth &add_tree_depth)
+{
+    const size_t n_row_blocks = (nrows + row_block - 1) / row_block;
+    const size_t n_tree_blocks = tree_blocks.size() - 1;
+
+    auto predict_row_block = [&](size_t block, int thread_id)
+    {
+        (void)thread_id;
+        size_t row_st = block * row_block;
+        size_t row_end = std::min(nrows, row_st + row_block);
+        std::fill(output_depths + row_st, output_depths + row_end, (double)0);
+
+        for (size_t tree_block = 0; tree_block < n_tree_blocks; tree_block++)
+        {
+            size_t tree_st = tree_blocks[tree_block];
+            size_t tree_end = tree_blocks[tree_block + 1];
+            for (size_t row = row_st; row < row_end; row++)
+            {
+                double depth = output_depths[row];
+                for (size_t tree = tree_st; tree < tree_end; tree++)
+                    add_tree_depth(row, tree, depth);
+                output_depths[row] = depth;
+            }
+        }
+    };
+    run_parallel_for(get_thread_executor(), n_row_blocks, nthreads, false, predict_row_block);
+}
+
+/* Same as above, but iterating over all the trees for one row at a time */
+template <class AddTreeDepth>
+void predict_by_rows(size_t nrows, size_t ntrees, int nthreads,
+                     double *restrict output_depths, AddTreeDepth &add_tree_depth)
+{
+    auto predict_row = [&](size_t row, int thread_id)
+    {
+        (void)thread_id;
+        double depth = 0;
+        for (size_t tree = 0; tree < ntrees; tree++)
+            add_tree_depth(row, tree, depth);
+        output_depths[row] = depth;
+    };
+    run_parallel_for(get_thread_executor(), nrows, nthreads, false, predict_row);
+}
+
+/* Size of the data for one row, used for determining how many rows to process per block. The
+   number of columns is not known for column-major data, in which case each column of a block
+   of rows is contiguous in memory anyway, and this returns zero. */
+template <class PredictionData>
+static inline size_t get_row_bytes(const PredictionData &prediction_data) noexcept
+{
+    if (prediction_data.is_col_major)
+        return 0;
+    return prediction_data.ncols_numeric * sizeof(*prediction_data.numeric_data)
+           + ((prediction_data.categ_data != NULL)? (prediction_data.ncols_categ * sizeof(int)) : 0);
+}
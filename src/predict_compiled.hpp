@@ -0,0 +1,423 @@
+/*    Isolation forests and variations thereof, with adjustments for incorporation
+*     of categorical variables and missing values.
+*     Writen for C++11 standard and aimed at being used in R and Python.
+*     
+*     This library is based on the following works:
+*     [1] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation forest."
+*         2008 Eighth IEEE International Conference on Data Mining. IEEE, 2008.
+*     [2] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation-based anomaly detection."
+*         ACM Transactions on Knowledge Discovery from Data (TKDD) 6.1 (2012): 3.
+*     [3] Hariri, Sahand, Matias Carrasco Kind, and Robert J. Brunner.
+*         "Extended Isolation Forest."
+*         arXiv preprint arXiv:1811.02141 (2018).
+*     [4] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "On detecting clustered anomalies using SCiForest."
+*         Joint European Conference on Machine Learning and Knowledge Discovery in Databases. Springer, Berlin, Heidelberg, 2010.
+*     [5] https://sourceforge.net/projects/iforest/
+*     [6] https://math.stackexchange.com/questions/3388518/expected-number-of-paths-required-to-separate-elements-in-a-binary-tree
+*     [7] Quinlan, J. Ross. C4. 5: programs for machine learning. Elsevier, 2014.
+*     [8] Cortes, David.
+*         "Distance approximation using Isolation Forests."
+*         arXiv preprint arXiv:1910.12362 (2019).
+*     [9] Cortes, David.
+*         "Imputing missing values with unsupervised random trees."
+*         arXiv preprint arXiv:1911.06646 (2019).
+*     [10] https://math.stackexchange.com/questions/3333220/expected-average-depth-in-random-binary-tree-constructed-top-to-bottom
+*     [11] Cortes, David.
+*          "Revisiting randomized choices in isolation forests."
+*          arXiv preprint arXiv:2110.13402 (2021).
+*     [12] Guha, Sudipto, et al.
+*          "Robust random cut forest based anomaly detection on streams."
+*          International conference on machine learning. PMLR, 2016.
+*     [13] Cortes, David.
+*          "Isolation forests: looking beyond tree depth."
+*          arXiv preprint arXiv:2111.11639 (2021).
+*     [14] Ting, Kai Ming, Yue Zhu, and Zhi-Hua Zhou.
+*          "Isolation kernel and its effect on SVM"
+*          Proceedings of the 24th ACM SIGKDD
+*          International Conference on Knowledge Discovery & Data Mining. 2018.
+* 
+*     BSD 2-Clause License
+*     Copyright (c) 2019-2024, David Cortes
+*     All rights reserved.
+*     Redistribution and use in source and binary forms, with or without
+*     modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this
+*       list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*       this list of conditions and the following disclaimer in the documentation
+*       and/or other materials provided with the distribution.
+*     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+*     AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+*     IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*     FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*     DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*     SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*     CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*     OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*     OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "isotree.hpp"
+
+/* Batches of extended models with at least this many rows are evaluated by nodes instead
+   of by rows (see 'predict_compiled_forest_levelwise'), in blocks of this many rows */
+#define MIN_ROWS_LEVELWISE ((size_t)256)
+#define ROWS_PER_BLOCK_LEVELWISE ((size_t)1024)
+
+/* Predict outlier scores using a flattened single-variable model
+* 
+* Parameters
+* ==========
+* - numeric_data[nrows * ncols_numeric]
+*       Pointer to numeric data for which to make predictions. Must be ordered by columns like Fortran,
+*       not ordered by rows like C (i.e. entries 1..n contain column 0, n+1..2n column 1, etc.),
+*       unless passing 'is_col_major=false'. Cannot contain missing values.
+* - is_col_major
+*       Whether 'numeric_data' comes in column-major order. If passing 'false', data must
+*       come in row-major order.
+* - ld_numeric
+*       Leading dimension of the array 'numeric_data', if it is passed in row-major format.
+*       Typically, this corresponds to the number of columns, but may be larger (the array will
+*       be accessed assuming that row 'n' starts at 'numeric_data + n*ld_numeric'). If passing
+*       'numeric_data' in column-major order, this is ignored and will be assumed that the
+*       leading dimension corresponds to the number of rows.
+* - nrows
+*       Number of rows in 'numeric_data'.
+* - nthreads
+*       Number of parallel threads to use.
+* - standardize
+*       Whether to standardize the average depths for each row according to their relative magnitude
+*       compared to the expected average, in order to obtain an outlier score. If passing 'false',
+*       will output the average depth instead.
+* - compiled
+*       Flattened model object, as produced by 'build_compiled_forest'.
+* - output_depths[nrows] (out)
+*       Pointer to array where the output average depths or outlier scores will be written into.
+* - tree_num[nrows * ntrees] (out)
+*       Pointer to array where the output terminal node numbers will be written into, in the
+*       same format as 'predict_iforest' (column-major order, numbered from zero).
+*       Pass NULL if this type of output is not needed. Note that when this is not requested, predictions
+*       can use vectorized kernels (AVX2 or AVX512, when the CPU supports them) if 'numeric_data' is
+*       of the same type as the split thresholds ('double' or 'float' if built with 'float_thresholds').
+* - per_tree_depths[nrows * ntrees] (out)
+*       Pointer to array where to output per-tree depths for each row, in row-major order.
+*       Pass NULL if this type of output is not needed.
+*/
+template <class real_t, class sparse_ix>
+void predict_iforest_compiled(real_t *restrict numeric_data, bool is_col_major, size_t ld_numeric,
+                              size_t nrows, int nthreads, bool standardize,
+                              const CompiledIsoForest &compiled,
+                              double *restrict output_depths, sparse_ix *restrict tree_num,
+                              double *restrict per_tree_depths)
+{
+    if (unlikely(!nrows)) return;
+    if ((size_t)nthreads > nrows)
+        nthreads = nrows;
+
+    if (compiled.float_thresholds)
+        predict_compiled_forest(numeric_data, is_col_major, ld_numeric, nrows, nthreads,
+                                compiled, compiled.num_split_f.data(),
+                                output_depths, tree_num, per_tree_depths);
+    else
+        predict_compiled_forest(numeric_data, is_col_major, ld_numeric, nrows, nthreads,
+                                compiled, compiled.num_split.data(),
+                                output_depths, tree_num, per_tree_depths);
+
+    depths_to_scores(output_depths, per_tree_depths,
+                     nrows, compiled.tree_offsets.size() - 1, compiled.exp_avg_depth,
+                     compiled.scoring_metric, standardize);
+}
+
+/* Predict outlier scores using a flattened extended model
+* 
+* Same parameters as above, but taking an object produced by 'build_compiled_forest' from
+* an extended model.
+*/
+template <class real_t, class sparse_ix>
+void predict_iforest_compiled(real_t *restrict numeric_data, bool is_col_major, size_t ld_numeric,
+                              size_t nrows, int nthreads, bool standardize,
+                              const CompiledExtIsoForest &compiled,
+                              double *restrict output_depths, sparse_ix *restrict tree_num,
+                              double *restrict per_tree_depths)
+{
+    if (unlikely(!nrows)) return;
+    if ((size_t)nthreads > nrows)
+        nthreads = nrows;
+
+    predict_compiled_forest(numeric_data, is_col_major, ld_numeric, nrows, nthreads,
+                            compiled,
+                            output_depths, tree_num, per_tree_depths);
+
+    depths_to_scores(output_depths, per_tree_depths,
+                     nrows, compiled.tree_offsets.size() - 1, compiled.exp_avg_depth,
+                     compiled.scoring_metric, standardize);
+}
+
+/* Note: this outputs the sum of depths and the terminal node numbers already mapped */
+template <class real_t, class split_t, class sparse_ix>
+void predict_compiled_forest(real_t *restrict numeric_data, bool is_col_major, size_t ld_numeric,
+                             size_t nrows, int nthreads,
+                             const CompiledIsoForest &compiled, const split_t *restrict num_split,
+                             double *restrict output_depths, sparse_ix *restrict tree_num,
+                             double *restrict per_tree_depths)
+{
+    const size_t ntrees = compiled.tree_offsets.size() - 1;
+    const size_t *restrict tree_offsets = compiled.tree_offsets.data();
+    const uint32_t *restrict col_num = compiled.col_num.data();
+    const uint32_t *restrict tree_left = compiled.tree_left.data();
+    const double *restrict score = compiled.score.data();
+    const size_t col_stride = is_col_major? nrows : 1;
+    const size_t row_stride = is_col_major? 1 : ld_numeric;
+
+    if (tree_num == NULL &&
+        predict_compiled_rows_simd(numeric_data, row_stride, col_stride, nrows, nthreads,
+                                   compiled, num_split, output_depths, per_tree_depths))
+        return;
+
+    std::vector<size_t> tree_blocks;
+    size_t row_block = 1;
+    if (get_tree_blocks(compiled, nrows, is_col_major? 0 : (ld_numeric * sizeof(real_t)), nthreads,
+                        tree_blocks, row_block))
+    {
+        auto add_tree_depth = [&](size_t row, size_t tree, double &depth)
+        {
+            size_t st = tree_offsets[tree];
+            size_t node = st + traverse_compiled_tree(col_num + st, tree_left + st, num_split + st,
+                                                      numeric_data + row * row_stride, col_stride);
+            depth += score[node];
+            if (unlikely(tree_num != NULL))
+                tree_num[row + tree * nrows] = col_num[node];
+            if (unlikely(per_tree_depths != NULL))
+                per_tree_depths[tree + row * ntrees] = score[node];
+        };
+        predict_by_tree_blocks(tree_blocks, row_block, nrows, nthreads, output_depths, add_tree_depth);
+        return;
+    }
+
+    auto predict_row = [&](size_t row, int thread_id)
+    {
+        (void)thread_id;
+        const real_t *restrict row_numeric_data = numeric_data + row * row_stride;
+        double depth = 0;
+        for (size_t tree = 0; tree < ntrees; tree++)
+        {
+            size_t st = tree_offsets[tree];
+            size_t node = st + traverse_compiled_tree(col_num + st, tree_left + st, num_split + st,
+                                                      row_numeric_data, col_stride);
+            depth += score[node];
+            if (unlikely(tree_num != NULL))
+                tree_num[row + tree * nrows] = col_num[node];
+            if (unlikely(per_tree_depths != NULL))
+                per_tree_depths[tree + row * ntrees] = score[node];
+        }
+        output_depths[row] = depth;
+    };
+    run_parallel_for(get_thread_executor(), nrows, nthreads, false, predict_row);
+}
+
+/* Note: this outputs the sum of depths and the terminal node numbers already mapped */
+template <class real_t, class sparse_ix>
+void predict_compiled_forest(real_t *restrict numeric_data, bool is_col_major, size_t ld_numeric,
+                             size_t nrows, int nthreads,
+                             const CompiledExtIsoForest &compiled,
+                             double *restrict output_depths, sparse_ix *restrict tree_num,
+                             double *restrict per_tree_depths)
+{
+    const size_t ntrees = compiled.tree_offsets.size() - 1;
+    const size_t ndim = compiled.ndim;
+    const size_t idx_stride = ndim + 2;
+    const size_t val_stride = 2 * ndim + 1;
+    const size_t *restrict tree_offsets = compiled.tree_offsets.data();
+    const uint32_t *restrict node_idx = compiled.node_idx.data();
+    const double *restrict node_val = compiled.node_val.data();
+    const size_t col_stride = is_col_major? nrows : 1;
+    const size_t row_stride = is_col_major? 1 : ld_numeric;
+
+    if (nrows >= MIN_ROWS_LEVELWISE)
+    {
+        predict_compiled_forest_levelwise(numeric_data, row_stride, col_stride, nrows, nthreads, compiled,
+                                          output_depths, tree_num, per_tree_depths);
+        return;
+    }
+
+    auto add_tree_depth = [&](size_t row, size_t tree, double &depth)
+    {
+        size_t st = tree_offsets[tree];
+        size_t node = st + traverse_compiled_tree(node_idx + st * idx_stride, node_val + st * val_stride, ndim,
+                                                  numeric_data + row * row_stride, col_stride);
+        double score = node_val[node * val_stride];
+        depth += score;
+        if (unlikely(tree_num != NULL))
+            tree_num[row + tree * nrows] = node_idx[node * idx_stride + 1];
+        if (unlikely(per_tree_depths != NULL))
+            per_tree_depths[tree + row * ntrees] = score;
+    };
+
+    std::vector<size_t> tree_blocks;
+    size_t row_block = 1;
+    if (get_tree_blocks(compiled, nrows, is_col_major? 0 : (ld_numeric * sizeof(real_t)), nthreads,
+                        tree_blocks, row_block))
+        predict_by_tree_blocks(tree_blocks, row_block, nrows, nthreads, output_depths, add_tree_depth);
+    else
+        predict_by_rows(nrows, ntrees, nthreads, output_depths, add_tree_depth);
+}
+
+/* Large batches are evaluated one node at a time over blocks of rows: all the rows in a block
+   start at the root of a tree, and each node calculates its hyperplane for all the rows that
+   reach it at once, iterating over columns in the outer loop and over rows in the inner loop
+   (which reads contiguous memory for column-major data, and in any case has no dependencies
+   between iterations), before partitioning the rows among its children, as in the predictions
+   for CSC data. Each row still adds up the products in the same order, so results are exactly
+   the same as when traversing the trees one row at a time. */
+template <class real_t, class sparse_ix>
+void predict_compiled_forest_levelwise(real_t *restrict numeric_data, size_t row_stride, size_t col_stride,
+                                       size_t nrows, int nthreads,
+                                       const CompiledExtIsoForest &compiled,
+                                       double *restrict output_depths, sparse_ix *restrict tree_num,
+                                       double *restrict per_tree_depths)
+{
+    const size_t ntrees = compiled.tree_offsets.size() - 1;
+    const size_t n_blocks = (nrows + ROWS_PER_BLOCK_LEVELWISE - 1) / ROWS_PER_BLOCK_LEVELWISE;
+    Executor *executor = get_thread_executor();
+    if (executor != NULL)
+        nthreads = executor->num_workers();
+    #ifdef _OPENMP
+    else if ((size_t)nthreads > n_blocks)
+        nthreads = n_blocks;
+    #else
+    else
+        nthreads = 1;
+    #endif
+    std::vector<WorkerForPredictCSC> worker_memory(nthreads);
+
+    auto predict_row_block = [&](size_t block, int thread_id)
+    {
+        WorkerForPredictCSC &workspace = worker_memory[thread_id];
+        if (workspace.ix_arr.empty())
+        {
+            workspace.ix_arr.resize(ROWS_PER_BLOCK_LEVELWISE);
+            workspace.comb_val.resize(ROWS_PER_BLOCK_LEVELWISE);
+        }
+
+        size_t row_st = block * ROWS_PER_BLOCK_LEVELWISE;
+        size_t row_end = std::min(nrows, row_st + ROWS_PER_BLOCK_LEVELWISE);
+        std::fill(output_depths + row_st, output_depths + row_end, (double)0);
+        for (size_t tree = 0; tree < ntrees; tree++)
+        {
+            std::iota(workspace.ix_arr.begin(), workspace.ix_arr.begin() + (row_end - row_st), row_st);
+            traverse_compiled_tree_levelwise(workspace, compiled, tree, (size_t)0,
+                                             (size_t)0, row_end - row_st,
+                                             numeric_data, row_stride, col_stride, nrows,
+                                             output_depths, tree_num, per_tree_depths);
+        }
+    };
+    run_parallel_for(executor, n_blocks, nthreads, false, predict_row_block);
+}
+
+/* Processes the rows at positions [st, end) of 'workspace.ix_arr', which are those that reach 'node' */
+template <class real_t, class sparse_ix>
+static void traverse_compiled_tree_levelwise(WorkerForPredictCSC &workspace,
+                                             const CompiledExtIsoForest &compiled,
+                                             size_t tree, size_t node, size_t st, size_t end,
+                                             const real_t *restrict numeric_data,
+                                             size_t row_stride, size_t col_stride, size_t nrows,
+                                             double *restrict output_depths, sparse_ix *restrict tree_num,
+                                             double *restrict per_tree_depths) noexcept
+{
+    const size_t ndim = compiled.ndim;
+    const size_t ntrees = compiled.tree_offsets.size() - 1;
+    const size_t tree_st = compiled.tree_offsets[tree];
+    const uint32_t *restrict idx = compiled.node_idx.data() + (tree_st + node) * (ndim + 2);
+    const double *restrict val = compiled.node_val.data() + (tree_st + node) * (2 * ndim + 1);
+    size_t *restrict ix_arr = workspace.ix_arr.data();
+    double *restrict hval = workspace.comb_val.data();
+
+    if (!idx[0])
+    {
+        for (size_t ix = st; ix < end; ix++)
+            output_depths[ix_arr[ix]] += val[0];
+        if (unlikely(tree_num != NULL))
+            for (size_t ix = st; ix < end; ix++)
+                tree_num[ix_arr[ix] + tree * nrows] = idx[1];
+        if (unlikely(per_tree_depths != NULL))
+            for (size_t ix = st; ix < end; ix++)
+                per_tree_depths[tree + ix_arr[ix] * ntrees] = val[0];
+        return;
+    }
+
+    std::fill(hval + st, hval + end, (double)0);
+    for (size_t col = 0; col < (size_t)idx[1]; col++)
+    {
+        const real_t *restrict col_data = numeric_data + (size_t)idx[col + 2] * col_stride;
+        const double coef = val[col + 1];
+        const double mean = val[col + 1 + ndim];
+        for (size_t ix = st; ix < end; ix++)
+            hval[ix] += (col_data[ix_arr[ix] * row_stride] - mean) * coef;
+    }
+
+    size_t split_ix = st;
+    for (size_t ix = st; ix < end; ix++)
+    {
+        if (hval[ix] <= val[0])
+            std::swap(ix_arr[split_ix++], ix_arr[ix]);
+    }
+
+    if (split_ix > st)
+        traverse_compiled_tree_levelwise(workspace, compiled, tree, (size_t)idx[0], st, split_ix,
+                                         numeric_data, row_stride, col_stride, nrows,
+                                         output_depths, tree_num, per_tree_depths);
+    if (end > split_ix)
+        traverse_compiled_tree_levelwise(workspace, compiled, tree, (size_t)idx[0] + 1, split_ix, end,
+                                         numeric_data, row_stride, col_stride, nrows,
+                                         output_depths, tree_num, per_tree_depths);
+}
+
+/* Vectorized kernels are only available when the data and the thresholds are of the same type */
+template <class real_t, class split_t>
+static inline bool predict_compiled_rows_simd(const real_t*, size_t, size_t,
+                                              size_t, int,
+                                              const CompiledIsoForest&, const split_t*,
+                                              double*, double*) noexcept
+{
+    return false;
+}
+
+template <class real_t, class split_t>
+static inline size_t traverse_compiled_tree(const uint32_t *restrict col_num,
+                                            const uint32_t *restrict tree_left,
+                                            const split_t *restrict  num_split,
+                                            const real_t *restrict   row_numeric_data,
+                                            size_t                   col_stride) noexcept
+{
+    size_t node = 0;
+    while (tree_left[node])
+        node = tree_left[node] + !(row_numeric_data[(size_t)col_num[node] * col_stride] <= num_split[node]);
+    return node;
+}
+
+/* The dot product is accumulated in the same order and with the same operations as in
+   'traverse_hplane_fast_rowmajor', so that results are exactly the same as from the model */
+template <class real_t>
+static inline size_t traverse_compiled_tree(const uint32_t *restrict node_idx,
+                                            const double *restrict   node_val,
+                                            size_t                   ndim,
+                                            const real_t *restrict   row_numeric_data,
+                                            size_t                   col_stride) noexcept
+{
+    const size_t idx_stride = ndim + 2;
+    const size_t val_stride = 2 * ndim + 1;
+    size_t node = 0;
+    while (true)
+    {
+        const uint32_t *restrict idx = node_idx + node * idx_stride;
+        if (!idx[0]) return node;
+        const double *restrict val = node_val + node * val_stride;
+        double hval = 0;
+        for (size_t col = 0; col < (size_t)idx[1]; col++)
+            hval += (row_numeric_data[(size_t)idx[col + 2] * col_stride] - val[col + 1 + ndim]) * val[col + 1];
+        node = idx[0] + !(hval <= val[0]);
+    }
+}
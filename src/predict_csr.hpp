@@ -0,0 +1,131 @@
+/*    Isolation forests and variations thereof, with adjustments for incorporation
+*     of categorical variables and missing values.
+*     Writen for C++11 standard and aimed at being used in R and Python.
+*     
+*     This library is based on the following works:
+*     [1] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation forest."
+*         2008 Eighth IEEE International Conference on Data Mining. IEEE, 2008.
+*     [2] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation-based anomaly detection."
+*         ACM Transactions on Knowledge Discovery from Data (TKDD) 6.1 (2012): 3.
+*     [3] Hariri, Sahand, Matias Carrasco Kind, and Robert J. Brunner.
+*         "Extended Isolation Forest."
+*         arXiv preprint arXiv:1811.02141 (2018).
+*     [4] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "On detecting clustered anomalies using SCiForest."
+*         Joint European Conference on Machine Learning and Knowledge Discovery in Databases. Springer, Berlin, Heidelberg, 2010.
+*     [5] https://sourceforge.net/projects/iforest/
+*     [6] https://math.stackexchange.com/questions/3388518/expected-number-of-paths-required-to-separate-elements-in-a-binary-tree
+*     [7] Quinlan, J. Ross. C4. 5: programs for machine learning. Elsevier, 2014.
+*     [8] Cortes, David.
+*         "Distance approximation using Isolation Forests."
+*         arXiv preprint arXiv:1910.12362 (2019).
+*     [9] Cortes, David.
+*         "Imputing missing values with unsupervised random trees."
+*         arXiv preprint arXiv:1911.06646 (2019).
+*     [10] https://math.stackexchange.com/questions/3333220/expected-average-depth-in-random-binary-tree-constructed-top-to-bottom
+*     [11] Cortes, David.
+*          "Revisiting randomized choices in isolation forests."
+*          arXiv preprint arXiv:2110.13402 (2021).
+*     [12] Guha, Sudipto, et al.
+*          "Robust random cut forest based anomaly detection on streams."
+*          International conference on machine learning. PMLR, 2016.
+*     [13] Cortes, David.
+*          "Isolation forests: looking beyond tree depth."
+*          arXiv preprint arXiv:2111.11639 (2021).
+*     [14] Ting, Kai Ming, Yue Zhu, and Zhi-Hua Zhou.
+*          "Isolation kernel and its effect on SVM"
+*          Proceedings of the 24th ACM SIGKDD
+*          International Conference on Knowledge Discovery & Data Mining. 2018.
+* 
+*     BSD 2-Clause License
+*     Copyright (c) 2019-2024, David Cortes
+*     All rights reserved.
+*     Redistribution and use in source and binary forms, with or without
+*     modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this
+*       list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*       this list of conditions and the following disclaimer in the documentation
+*       and/or other materials provided with the distribution.
+*     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+*     AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+*     IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*     FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*     DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*     SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*     CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*     OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*     OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "isotree.hpp"
+
+/* Batch predictions on sparse CSR data would otherwise need a binary search over the non-zero
+   entries of a row at each node that a row visits. Instead, each row can be scattered into a
+   dense array of zeros (one per thread), which is then passed to the dense traversal routines
+   as a row-major matrix with zero leading dimension, so that any row number maps to it. After
+   a row is done, only the entries that it had set are zeroed out again, so the cost per row
+   is proportional to its number of non-zeros rather than to the number of columns.
+
+   This is only worth it when the batch is large enough to amortize allocating and filling
+   the dense arrays, which have one entry per numeric column used by the model. */
+template <class Model>
+bool should_scatter_csr_rows(const Model &model, size_t nrows, int nthreads, size_t &ncols_dense)
+{
+    if (nrows < 64)
+        return false;
+    ncols_dense = get_max_numeric_col(model) + 1;
+    return (size_t)std::max(nthreads, 1) * ncols_dense <= nrows * get_ntrees(model) * 8;
+}
+
+/* Sets the entries of 'dense_row' from the non-zeros of CSR row 'row', or back to zero if
+   passing 'reset=true'. Columns beyond 'ncols_dense' are not used by the model. */
+template <class PredictionData, class real_t>
+static inline void scatter_csr_row(const PredictionData &prediction_data, size_t row,
+                                   real_t *restrict dense_row, size_t ncols_dense, bool reset) noexcept
+{
+    for (auto ix = prediction_data.Xr_indptr[row]; ix < prediction_data.Xr_indptr[row + 1]; ix++)
+    {
+        size_t col = prediction_data.Xr_ind[ix];
+        if (likely(col < ncols_dense))
+            dense_row[col] = reset? (real_t)0 : prediction_data.Xr[ix];
+    }
+}
+
+/* 'predict_row(row, dense_data)' should calculate the output for 'row' from 'dense_data', which
+   is a copy of 'prediction_data' that has its numeric data replaced with the dense row as
+   described above. Categorical data is taken from the original input, so it must be row-major
+   if the prediction routine determines the layout from 'is_col_major'. */
+template <class PredictionData, class PredictRow>
+void predict_by_scattered_rows(const PredictionData &prediction_data, size_t nrows, int nthreads,
+                               size_t ncols_dense, PredictRow &predict_row)
+{
+    typedef typename std::remove_pointer<decltype(prediction_data.Xr)>::type real_t;
+    Executor *executor = get_thread_executor();
+    if (executor != NULL)
+        nthreads = executor->num_workers();
+    std::vector<std::vector<real_t>> dense_rows(std::max(nthreads, 1));
+
+    auto predict_scattered_row = [&](size_t row, int thread_id)
+    {
+        std::vector<real_t> &dense_row = dense_rows[thread_id];
+        if (dense_row.empty())
+            dense_row.resize(ncols_dense, (real_t)0);
+
+        PredictionData dense_data = prediction_data;
+        dense_data.numeric_data = dense_row.data();
+        dense_data.ncols_numeric = 0;
+        dense_data.Xr = NULL;
+        dense_data.Xr_ind = NULL;
+        dense_data.Xr_indptr = NULL;
+        if (dense_data.categ_data == NULL)
+            dense_data.is_col_major = false;
+
+        scatter_csr_row(prediction_data, row, dense_row.data(), ncols_dense, false);
+        predict_row(row, dense_data);
+        scatter_csr_row(prediction_data, row, dense_row.data(), ncols_dense, true);
+    };
+    run_parallel_for(executor, nrows, nthreads, false, predict_scattered_row);
+}
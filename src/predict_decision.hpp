@@ -0,0 +1,224 @@
+/*    Isolation forests and variations thereof, with adjustments for incorporation
+*     of categorical variables and missing values.
+*     Writen for C++11 standard and aimed at being used in R and Python.
+*     
+*     This library is based on the following works:
+*     [1] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation forest."
+*         2008 Eighth IEEE International Conference on Data Mining. IEEE, 2008.
+*     [2] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation-based anomaly detection."
+*         ACM Transactions on Knowledge Discovery from Data (TKDD) 6.1 (2012): 3.
+*     [3] Hariri, Sahand, Matias Carrasco Kind, and Robert J. Brunner.
+*         "Extended Isolation Forest."
+*         arXiv preprint arXiv:1811.02141 (2018).
+*     [4] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "On detecting clustered anomalies using SCiForest."
+*         Joint European Conference on Machine Learning and Knowledge Discovery in Databases. Springer, Berlin, Heidelberg, 2010.
+*     [5] https://sourceforge.net/projects/iforest/
+*     [6] https://math.stackexchange.com/questions/3388518/expected-number-of-paths-required-to-separate-elements-in-a-binary-tree
+*     [7] Quinlan, J. Ross. C4. 5: programs for machine learning. Elsevier, 2014.
+*     [8] Cortes, David.
+*         "Distance approximation using Isolation Forests."
+*         arXiv preprint arXiv:1910.12362 (2019).
+*     [9] Cortes, David.
+*         "Imputing missing values with unsupervised random trees."
+*         arXiv preprint arXiv:1911.06646 (2019).
+*     [10] https://math.stackexchange.com/questions/3333220/expected-average-depth-in-random-binary-tree-constructed-top-to-bottom
+*     [11] Cortes, David.
+*          "Revisiting randomized choices in isolation forests."
+*          arXiv preprint arXiv:2110.13402 (2021).
+*     [12] Guha, Sudipto, et al.
+*          "Robust random cut forest based anomaly detection on streams."
+*          International conference on machine learning. PMLR, 2016.
+*     [13] Cortes, David.
+*          "Isolation forests: looking beyond tree depth."
+*          arXiv preprint arXiv:2111.11639 (2021).
+*     [14] Ting, Kai Ming, Yue Zhu, and Zhi-Hua Zhou.
+*          "Isolation kernel and its effect on SVM"
+*          Proceedings of the 24th ACM SIGKDD
+*          International Conference on Knowledge Discovery & Data Mining. 2018.
+* 
+*     BSD 2-Clause License
+*     Copyright (c) 2019-2024, David Cortes
+*     All rights reserved.
+*     Redistribution and use in source and binary forms, with or without
+*     modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this
+*       list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*       this list of conditions and the following disclaimer in the documentation
+*       and/or other materials provided with the distribution.
+*     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+*     AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+*     IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*     FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*     DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*     SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*     CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*     OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*     OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "isotree.hpp"
+
+/* Decide whether outlier scores exceed a threshold, evaluating only as many trees as needed
+* 
+* Parameters
+* ==========
+* - numeric_data[nrows * ncols_numeric]
+*       Pointer to numeric data for which to make predictions. Must be ordered by columns like Fortran,
+*       not ordered by rows like C (i.e. entries 1..n contain column 0, n+1..2n column 1, etc.),
+*       unless passing 'is_col_major=false'. Cannot contain missing values.
+* - is_col_major
+*       Whether 'numeric_data' comes in column-major order. If passing 'false', data must
+*       come in row-major order.
+* - ld_numeric
+*       Leading dimension of the array 'numeric_data', if it is passed in row-major format.
+*       Ignored when passing the data in column-major order.
+* - nrows
+*       Number of rows in 'numeric_data'.
+* - nthreads
+*       Number of parallel threads to use.
+* - compiled
+*       Flattened model object, as produced by 'build_compiled_forest'.
+* - threshold
+*       Threshold for the standardized outlier score (as output by 'predict_iforest' with
+*       'standardize=true') above which a row is considered an outlier.
+* - confidence
+*       Probability with which the decision for each row should match the decision that would be
+*       made from the scores calculated with all the trees. Must be in the interval (0,1] - passing 1
+*       will evaluate all the trees for every row.
+*       Trees are evaluated in the order in which they are stored in the model, and after each tree,
+*       the average of the per-tree depths seen so far is bounded using both a Hoeffding-Serfling
+*       inequality (sampling without replacement from the trees of the model) based on the range of
+*       the depths of all terminal nodes, and an empirical Bernstein inequality based on the variance
+*       of the depths seen so far. Since the trees are fit independently of each other, the ones that
+*       come first in the model are as good as a random sample of them. Evaluation stops once the
+*       bounds on the score are both on the same side of the threshold. The failure probability is
+*       split evenly among both inequalities and all the points at which evaluation could have stopped.
+* - output_decisions[nrows] (out)
+*       Pointer to array where the decisions will be written into, with 1 for rows whose score is
+*       above the threshold and 0 for the rest.
+* - trees_used[nrows] (out)
+*       Pointer to array where the number of trees that were evaluated for each row will be written into.
+*       Pass NULL if this type of output is not needed.
+*/
+template <class real_t>
+void predict_iforest_decision(real_t *restrict numeric_data, bool is_col_major, size_t ld_numeric,
+                              size_t nrows, int nthreads,
+                              const CompiledIsoForest &compiled,
+                              double threshold, double confidence,
+                              int *restrict output_decisions, size_t *restrict trees_used)
+{
+    if (std::isnan(threshold))
+        throw std::runtime_error("Decision threshold cannot be NaN.\n");
+    if (!(confidence > 0. && confidence <= 1.))
+        throw std::runtime_error("'confidence' must be in the interval (0,1].\n");
+    if (unlikely(!nrows)) return;
+    if ((size_t)nthreads > nrows)
+        nthreads = nrows;
+
+    if (compiled.float_thresholds)
+        predict_decision_compiled(numeric_data, is_col_major, ld_numeric, nrows, nthreads,
+                                  compiled, compiled.num_split_f.data(), threshold, confidence,
+                                  output_decisions, trees_used);
+    else
+        predict_decision_compiled(numeric_data, is_col_major, ld_numeric, nrows, nthreads,
+                                  compiled, compiled.num_split.data(), threshold, confidence,
+                                  output_decisions, trees_used);
+}
+
+template <class real_t, class split_t>
+void predict_decision_compiled(real_t *restrict numeric_data, bool is_col_major, size_t ld_numeric,
+                               size_t nrows, int nthreads,
+                               const CompiledIsoForest &compiled, const split_t *restrict num_split,
+                               double threshold, double confidence,
+                               int *restrict output_decisions, size_t *restrict trees_used)
+{
+    const size_t ntrees = compiled.tree_offsets.size() - 1;
+    const size_t *restrict tree_offsets = compiled.tree_offsets.data();
+    const uint32_t *restrict col_num = compiled.col_num.data();
+    const uint32_t *restrict tree_left = compiled.tree_left.data();
+    const double *restrict score = compiled.score.data();
+    const size_t col_stride = is_col_major? nrows : 1;
+    const size_t row_stride = is_col_major? 1 : ld_numeric;
+
+    double min_score = HUGE_VAL;
+    double max_score = -HUGE_VAL;
+    for (size_t node = 0; node < compiled.score.size(); node++)
+    {
+        if (tree_left[node]) continue;
+        min_score = std::min(min_score, score[node]);
+        max_score = std::max(max_score, score[node]);
+    }
+    /* with a confidence of 1, or an unbounded range, the bounds are never tight enough to stop early */
+    const double score_range = max_score - min_score;
+    const double log_term = std::log(4. * (double)ntrees / (1. - confidence));
+    const double log_term_bernstein = std::log(6. * (double)ntrees / (1. - confidence));
+
+    auto decide_row = [&](size_t row, int thread_id)
+    {
+        (void)thread_id;
+        const real_t *restrict row_numeric_data = numeric_data + row * row_stride;
+        double depth = 0;
+        double running_mean = 0;
+        double running_ssq = 0;
+        size_t tree;
+        int decision = -1;
+        for (tree = 0; tree < ntrees; tree++)
+        {
+            size_t st = tree_offsets[tree];
+            size_t node = st + traverse_compiled_tree(col_num + st, tree_left + st, num_split + st,
+                                                      row_numeric_data, col_stride);
+            depth += score[node];
+            double diff = score[node] - running_mean;
+            running_mean += diff / (double)(tree + 1);
+            running_ssq += diff * (score[node] - running_mean);
+
+            if (tree + 1 < ntrees)
+            {
+                double n_seen = (double)(tree + 1);
+                double eps_hoeffding = score_range * std::sqrt((1. - (double)tree / (double)ntrees) * log_term / (2. * n_seen));
+                double eps_bernstein = std::sqrt(2. * (running_ssq / n_seen) * log_term_bernstein / n_seen)
+                                        + 3. * score_range * log_term_bernstein / n_seen;
+                double eps = std::min(eps_hoeffding, eps_bernstein);
+                if (std::isnan(eps) || std::isinf(eps)) continue;
+                /* scores are monotonic in the average depth, but the direction depends on the metric */
+                double score_low  = (running_mean - eps) * (double)ntrees;
+                double score_high = (running_mean + eps) * (double)ntrees;
+                depths_to_scores(&score_low, (double*)NULL, 1, ntrees, compiled.exp_avg_depth,
+                                 compiled.scoring_metric, true);
+                depths_to_scores(&score_high, (double*)NULL, 1, ntrees, compiled.exp_avg_depth,
+                                 compiled.scoring_metric, true);
+                if (std::min(score_low, score_high) > threshold) {
+                    decision = 1;
+                    break;
+                }
+                if (std::max(score_low, score_high) <= threshold) {
+                    decision = 0;
+                    break;
+                }
+            }
+        }
+
+        if (decision < 0)
+        {
+            /* all the trees were evaluated, so the score is calculated in the same way as in
+               'predict_iforest' in order to arrive at exactly the same decision */
+            depths_to_scores(&depth, (double*)NULL, 1, ntrees, compiled.exp_avg_depth,
+                             compiled.scoring_metric, true);
+            decision = depth > threshold;
+        }
+
+        else
+        {
+            tree++;
+        }
+
+        output_decisions[row] = decision;
+        if (trees_used != NULL)
+            trees_used[row] = tree;
+    };
+    run_parallel_for(get_thread_executor(), nrows, nthreads, true, decide_row);
+}
@@ -0,0 +1,341 @@
+/*    Isolation forests and variations thereof, with adjustments for incorporation
+*     of categorical variables and missing values.
+*     Writen for C++11 standard and aimed at being used in R and Python.
+*     
+*     This library is based on the following works:
+*     [1] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation forest."
+*         2008 Eighth IEEE International Conference on Data Mining. IEEE, 2008.
+*     [2] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation-based anomaly detection."
+*         ACM Transactions on Knowledge Discovery from Data (TKDD) 6.1 (2012): 3.
+*     [3] Hariri, Sahand, Matias Carrasco Kind, and Robert J. Brunner.
+*         "Extended Isolation Forest."
+*         arXiv preprint arXiv:1811.02141 (2018).
+*     [4] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "On detecting clustered anomalies using SCiForest."
+*         Joint European Conference on Machine Learning and Knowledge Discovery in Databases. Springer, Berlin, Heidelberg, 2010.
+*     [5] https://sourceforge.net/projects/iforest/
+*     [6] https://math.stackexchange.com/questions/3388518/expected-number-of-paths-required-to-separate-elements-in-a-binary-tree
+*     [7] Quinlan, J. Ross. C4. 5: programs for machine learning. Elsevier, 2014.
+*     [8] Cortes, David.
+*         "Distance approximation using Isolation Forests."
+*         arXiv preprint arXiv:1910.12362 (2019).
+*     [9] Cortes, David.
+*         "Imputing missing values with unsupervised random trees."
+*         arXiv preprint arXiv:1911.06646 (2019).
+*     [10] https://math.stackexchange.com/questions/3333220/expected-average-depth-in-random-binary-tree-constructed-top-to-bottom
+*     [11] Cortes, David.
+*          "Revisiting randomized choices in isolation forests."
+*          arXiv preprint arXiv:2110.13402 (2021).
+*     [12] Guha, Sudipto, et al.
+*          "Robust random cut forest based anomaly detection on streams."
+*          International conference on machine learning. PMLR, 2016.
+*     [13] Cortes, David.
+*          "Isolation forests: looking beyond tree depth."
+*          arXiv preprint arXiv:2111.11639 (2021).
+*     [14] Ting, Kai Ming, Yue Zhu, and Zhi-Hua Zhou.
+*          "Isolation kernel and its effect on SVM"
+*          Proceedings of the 24th ACM SIGKDD
+*          International Conference on Knowledge Discovery & Data Mining. 2018.
+* 
+*     BSD 2-Clause License
+*     Copyright (c) 2019-2024, David Cortes
+*     All rights reserved.
+*     Redistribution and use in source and binary forms, with or without
+*     modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this
+*       list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*       this list of conditions and the following disclaimer in the documentation
+*       and/or other materials provided with the distribution.
+*     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+*     AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+*     IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*     FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*     DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*     SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*     CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*     OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*     OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "isotree.hpp"
+
+/* Predict outlier scores or average depths using a model in flat format
+* 
+* Parameters
+* ==========
+* - numeric_data[nrows * ncols_numeric]
+*       Pointer to numeric data for which to make predictions. Must be ordered by columns like Fortran,
+*       not ordered by rows like C (i.e. entries 1..n contain column 0, n+1..2n column 1, etc.),
+*       unless passing 'is_col_major=false'.
+* - is_col_major
+*       Whether 'numeric_data' comes in column-major order. If passing 'false', data must
+*       come in row-major order.
+* - ld_numeric
+*       Leading dimension of the array 'numeric_data', if it is passed in row-major format.
+*       Ignored when passing the data in column-major order.
+* - nrows
+*       Number of rows in 'numeric_data'.
+* - nthreads
+*       Number of parallel threads to use.
+* - standardize
+*       Whether to standardize the average depths for each row according to their relative magnitude
+*       compared to the expected average, in order to obtain an outlier score. If passing 'false',
+*       will output the average depth instead.
+* - model
+*       Model in flat format, as produced by 'load_flat_model' or 'load_flat_model_FromFile'.
+* - output_depths[nrows] (out)
+*       Pointer to array where the output average depths or outlier scores will be written into.
+* - tree_num[nrows * ntrees] (out)
+*       Pointer to array where the output terminal node numbers will be written into, in the
+*       same format as 'predict_iforest' (column-major order, numbered from zero).
+*       Pass NULL if this type of output is not needed.
+* - per_tree_depths[nrows * ntrees] (out)
+*       Pointer to array where to output per-tree depths for each row, in row-major order.
+*       Pass NULL if this type of output is not needed.
+*/
+template <class real_t, class sparse_ix>
+void predict_flat_model(real_t *restrict numeric_data, bool is_col_major, size_t ld_numeric,
+                        size_t nrows, int nthreads, bool standardize,
+                        const FlatModel &model,
+                        double *restrict output_depths, sparse_ix *restrict tree_num,
+                        double *restrict per_tree_depths)
+{
+    if (unlikely(!nrows)) return;
+    if ((size_t)nthreads > nrows)
+        nthreads = nrows;
+    if (!model.is_extended && model.missing_action == Divide && (tree_num != NULL || per_tree_depths != NULL))
+        throw_unsupported_pred_error();
+
+    const size_t col_stride = is_col_major? nrows : 1;
+    const size_t row_stride = is_col_major? 1 : ld_numeric;
+    if (!model.single_precision)
+        predict_flat_model_internal(numeric_data, row_stride, col_stride, nrows, nthreads,
+                                    model, model.arrays,
+                                    output_depths, tree_num, per_tree_depths);
+    else
+        predict_flat_model_internal(numeric_data, row_stride, col_stride, nrows, nthreads,
+                                    model, model.arrays_f,
+                                    output_depths, tree_num, per_tree_depths);
+
+    depths_to_scores(output_depths, per_tree_depths,
+                     nrows, model.ntrees, model.exp_avg_depth,
+                     model.scoring_metric, standardize);
+}
+
+/* Compute the largest absolute difference between the predictions from a model in flat format
+   and the predictions from the model out of which it was produced, for a given set of rows
+* 
+* This is meant for assessing the effect of saving a model in single precision, which changes
+* the scores of terminal nodes and the coefficients of extended models. For single-variable
+* models, thresholds are rounded such that 'float' inputs take the same branches as with the
+* original model, so differences will only come from the scores.
+* 
+* Parameters
+* ==========
+* - numeric_data[nrows * ncols_numeric]
+*       Pointer to numeric data, in the same format as for 'predict_flat_model'.
+* - is_col_major
+*       Whether 'numeric_data' comes in column-major order.
+* - ld_numeric
+*       Leading dimension of the array 'numeric_data', if it is passed in row-major format.
+* - nrows
+*       Number of rows in 'numeric_data'.
+* - nthreads
+*       Number of parallel threads to use.
+* - standardize
+*       Whether to compare standardized outlier scores (if passing 'true') or average depths.
+* - model_outputs
+*       Single-variable model from which 'flat_model' was produced, or NULL if it comes from
+*       an extended model.
+* - model_outputs_ext
+*       Extended model from which 'flat_model' was produced, or NULL if it comes from
+*       a single-variable model.
+* - flat_model
+*       Model in flat format.
+* 
+* Returns
+* =======
+* Maximum absolute difference in the outputs across the rows. If a row has a missing output
+* in one model but not in the other, will return infinity.
+*/
+template <class real_t>
+double get_flat_model_max_deviation(real_t *restrict numeric_data, bool is_col_major, size_t ld_numeric,
+                                    size_t nrows, int nthreads, bool standardize,
+                                    IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
+                                    const FlatModel &flat_model)
+{
+    if ((model_outputs == NULL) == (model_outputs_ext == NULL))
+        throw std::runtime_error("Must pass exactly one of single-variable or extended model.\n");
+    if (flat_model.is_extended != (model_outputs_ext != NULL))
+        throw std::runtime_error("Flat model is of a different type than the model passed.\n");
+    if (unlikely(!nrows)) return 0;
+
+    std::vector<double> ref_depths(nrows);
+    std::vector<double> flat_depths(nrows);
+    predict_iforest<real_t, size_t>(numeric_data, (int*)NULL,
+                                    is_col_major, ld_numeric, (size_t)0,
+                                    (real_t*)NULL, (size_t*)NULL, (size_t*)NULL,
+                                    (real_t*)NULL, (size_t*)NULL, (size_t*)NULL,
+                                    nrows, nthreads, standardize,
+                                    model_outputs, model_outputs_ext,
+                                    ref_depths.data(), (size_t*)NULL,
+                                    (double*)NULL, (TreesIndexer*)NULL);
+    predict_flat_model<real_t, size_t>(numeric_data, is_col_major, ld_numeric,
+                                       nrows, nthreads, standardize,
+                                       flat_model,
+                                       flat_depths.data(), (size_t*)NULL,
+                                       (double*)NULL);
+
+    double max_deviation = 0;
+    for (size_t row = 0; row < nrows; row++)
+    {
+        if (unlikely(std::isnan(ref_depths[row]) || std::isnan(flat_depths[row])))
+        {
+            if (std::isnan(ref_depths[row]) != std::isnan(flat_depths[row]))
+                return HUGE_VAL;
+            continue;
+        }
+        max_deviation = std::fmax(max_deviation, std::fabs(ref_depths[row] - flat_depths[row]));
+    }
+    return max_deviation;
+}
+
+/* Note: this outputs the sum of depths */
+template <class real_t, class sparse_ix, class idx_t, class val_t>
+void predict_flat_model_internal(real_t *restrict numeric_data, size_t row_stride, size_t col_stride,
+                                 size_t nrows, int nthreads,
+                                 const FlatModel &model, const FlatModelArrays<idx_t, val_t> &arrays,
+                                 double *restrict output_depths, sparse_ix *restrict tree_num,
+                                 double *restrict per_tree_depths)
+{
+    const size_t ntrees = model.ntrees;
+
+    auto predict_row = [&](size_t row, int thread_id)
+    {
+        (void)thread_id;
+        const real_t *restrict row_numeric_data = numeric_data + row * row_stride;
+        double depth = 0;
+        size_t terminal;
+        for (size_t tree = 0; tree < ntrees; tree++)
+        {
+            size_t st = arrays.tree_offsets[tree];
+            if (!model.is_extended)
+                depth += traverse_flat_tree(model, arrays, st, row_numeric_data, col_stride, (size_t)0, terminal);
+            else
+                traverse_flat_hplane(model, arrays, st, row_numeric_data, col_stride, depth, terminal);
+            if (unlikely(tree_num != NULL))
+                tree_num[row + tree * nrows] = arrays.tree_right[st + terminal];
+            if (unlikely(per_tree_depths != NULL))
+                per_tree_depths[tree + row * ntrees] = arrays.score[st + terminal];
+        }
+        output_depths[row] = depth;
+    };
+    run_parallel_for(get_thread_executor(), nrows, nthreads, false, predict_row);
+}
+
+/* Note: 'terminal' is not filled in when a missing value makes the row go to both branches */
+template <class real_t, class idx_t, class val_t>
+double traverse_flat_tree(const FlatModel &model, const FlatModelArrays<idx_t, val_t> &arrays, size_t st,
+                          const real_t *restrict row_numeric_data, size_t col_stride,
+                          size_t curr_lev, size_t &terminal) noexcept
+{
+    const idx_t *restrict tree_left = arrays.tree_left + st;
+    const idx_t *restrict tree_right = arrays.tree_right + st;
+    const idx_t *restrict col_num = arrays.col_num + st;
+    const val_t *restrict split = arrays.split + st;
+    double range_penalty = 0;
+    double xval;
+
+    while (tree_left[curr_lev])
+    {
+        xval = row_numeric_data[col_num[curr_lev] * col_stride];
+        if (unlikely(std::isnan(xval)))
+        {
+            switch (model.missing_action)
+            {
+                case Divide:
+                {
+                    double pct_tree_left = arrays.pct_tree_left[st + curr_lev];
+                    return
+                        pct_tree_left
+                            * traverse_flat_tree(model, arrays, st, row_numeric_data, col_stride, tree_left[curr_lev], terminal)
+                        + (1. - pct_tree_left)
+                            * traverse_flat_tree(model, arrays, st, row_numeric_data, col_stride, tree_right[curr_lev], terminal)
+                        - range_penalty;
+                }
+
+                case Impute:
+                {
+                    curr_lev = (arrays.pct_tree_left[st + curr_lev] >= .5)? tree_left[curr_lev] : tree_right[curr_lev];
+                    break;
+                }
+
+                default:
+                {
+                    terminal = curr_lev;
+                    return NAN;
+                }
+            }
+        }
+
+        else
+        {
+            range_penalty += (xval < arrays.range_low[st + curr_lev]) || (xval > arrays.range_high[st + curr_lev]);
+            curr_lev = (xval <= split[curr_lev])? tree_left[curr_lev] : tree_right[curr_lev];
+        }
+    }
+
+    terminal = curr_lev;
+    return arrays.score[st + curr_lev] - range_penalty;
+}
+
+template <class real_t, class idx_t, class val_t>
+void traverse_flat_hplane(const FlatModel &model, const FlatModelArrays<idx_t, val_t> &arrays, size_t st,
+                          const real_t *restrict row_numeric_data, size_t col_stride,
+                          double &restrict output_depth, size_t &terminal) noexcept
+{
+    const idx_t *restrict tree_left = arrays.tree_left + st;
+    const idx_t *restrict tree_right = arrays.tree_right + st;
+    const val_t *restrict split = arrays.split + st;
+    size_t curr_lev = 0;
+    double hval;
+    double xval;
+
+    while (tree_left[curr_lev])
+    {
+        hval = 0;
+        for (size_t ix = arrays.coef_offsets[st + curr_lev]; ix < arrays.coef_offsets[st + curr_lev + 1]; ix++)
+        {
+            xval = row_numeric_data[arrays.coef_col[ix] * col_stride];
+            if (unlikely(is_na_or_inf(xval)))
+            {
+                if (model.missing_action != Fail)
+                {
+                    hval += arrays.fill_val[ix];
+                }
+
+                else
+                {
+                    output_depth = NAN;
+                    terminal = curr_lev;
+                    return;
+                }
+            }
+
+            else
+            {
+                hval += (xval - arrays.mean[ix]) * arrays.coef[ix];
+            }
+        }
+
+        output_depth -= (hval < arrays.range_low[st + curr_lev]) ||
+                        (hval > arrays.range_high[st + curr_lev]);
+        curr_lev = (hval <= split[curr_lev])? tree_left[curr_lev] : tree_right[curr_lev];
+    }
+
+    terminal = curr_lev;
+    output_depth += arrays.score[st + curr_lev];
+}
@@ -0,0 +1,249 @@
+/*    Isolation forests and variations thereof, with adjustments for incorporation
+*     of categorical variables and missing values.
+*     Writen for C++11 standard and aimed at being used in R and Python.
+*     
+*     This library is based on the following works:
+*     [1] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation forest."
+*         2008 Eighth IEEE International Conference on Data Mining. IEEE, 2008.
+*     [2] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation-based anomaly detection."
+*         ACM Transactions on Knowledge Discovery from Data (TKDD) 6.1 (2012): 3.
+*     [3] Hariri, Sahand, Matias Carrasco Kind, and Robert J. Brunner.
+*         "Extended Isolation Forest."
+*         arXiv preprint arXiv:1811.02141 (2018).
+*     [4] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "On detecting clustered anomalies using SCiForest."
+*         Joint European Conference on Machine Learning and Knowledge Discovery in Databases. Springer, Berlin, Heidelberg, 2010.
+*     [5] https://sourceforge.net/projects/iforest/
+*     [6] https://math.stackexchange.com/questions/3388518/expected-number-of-paths-required-to-separate-elements-in-a-binary-tree
+*     [7] Quinlan, J. Ross. C4. 5: programs for machine learning. Elsevier, 2014.
+*     [8] Cortes, David.
+*         "Distance approximation using Isolation Forests."
+*         arXiv preprint arXiv:1910.12362 (2019).
+*     [9] Cortes, David.
+*         "Imputing missing values with unsupervised random trees."
+*         arXiv preprint arXiv:1911.06646 (2019).
+*     [10] https://math.stackexchange.com/questions/3333220/expected-average-depth-in-random-binary-tree-constructed-top-to-bottom
+*     [11] Cortes, David.
+*          "Revisiting randomized choices in isolation forests."
+*          arXiv preprint arXiv:2110.13402 (2021).
+*     [12] Guha, Sudipto, et al.
+*          "Robust random cut forest based anomaly detection on streams."
+*          International conference on machine learning. PMLR, 2016.
+*     [13] Cortes, David.
+*          "Isolation forests: looking beyond tree depth."
+*          arXiv preprint arXiv:2111.11639 (2021).
+*     [14] Ting, Kai Ming, Yue Zhu, and Zhi-Hua Zhou.
+*          "Isolation kernel and its effect on SVM"
+*          Proceedings of the 24th ACM SIGKDD
+*          International Conference on Knowledge Discovery & Data Mining. 2018.
+* 
+*     BSD 2-Clause License
+*     Copyright (c) 2019-2024, David Cortes
+*     All rights reserved.
+*     Redistribution and use in source and binary forms, with or without
+*     modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this
+*       list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*       this list of conditions and the following disclaimer in the documentation
+*       and/or other materials provided with the distribution.
+*     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+*     AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+*     IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*     FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*     DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*     SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*     CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*     OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*     OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "isotree.hpp"
+
+/* Calculate the outlier score for a single row, using a context from 'build_prediction_context'
+* 
+* Parameters
+* ==========
+* - context
+*       Prediction context, as produced by 'build_prediction_context'.
+* - numeric_row[ncols_numeric]
+*       Pointer to the numeric columns of the row for which to make a prediction, in the same order
+*       as the data to which the model was fit. Missing values are handled as in 'predict_iforest'.
+*       Pass NULL if the model was fit to categorical data only.
+* - categ_row[ncols_categ]
+*       Pointer to the categorical columns of the row, encoded in the same way as for 'predict_iforest'.
+*       Pass NULL if the model was fit to numeric data only.
+* 
+* Returns
+* =======
+* The outlier score for the row, which is the same as what 'predict_iforest' would output for it
+* (standardized or not, according to how the context was built). This function does not allocate
+* any memory nor use multi-threading, so it can be called concurrently from different threads with
+* the same context.
+*/
+template <class real_t>
+double predict_iforest_row(const PredictionContext &context,
+                           const real_t *restrict numeric_row, const int *restrict categ_row)
+{
+    double depth = 0;
+    double exp_avg_depth;
+    ScoringMetric scoring_metric;
+
+    if (context.use_compiled && context.model_outputs_ext != NULL)
+    {
+        const CompiledExtIsoForest &compiled = context.compiled_ext;
+        const size_t *restrict tree_offsets = compiled.tree_offsets.data();
+        const size_t idx_stride = compiled.ndim + 2;
+        const size_t val_stride = 2 * compiled.ndim + 1;
+        for (size_t tree = 0; tree < context.ntrees; tree++)
+        {
+            size_t st = tree_offsets[tree];
+            size_t node = st + traverse_compiled_tree(compiled.node_idx.data() + st * idx_stride,
+                                                      compiled.node_val.data() + st * val_stride,
+                                                      compiled.ndim, numeric_row, (size_t)1);
+            depth += compiled.node_val[node * val_stride];
+        }
+        exp_avg_depth = compiled.exp_avg_depth;
+        scoring_metric = compiled.scoring_metric;
+    }
+
+    else if (context.use_compiled)
+    {
+        const CompiledIsoForest &compiled = context.compiled;
+        const size_t *restrict tree_offsets = compiled.tree_offsets.data();
+        const uint32_t *restrict col_num = compiled.col_num.data();
+        const uint32_t *restrict tree_left = compiled.tree_left.data();
+        const double *restrict num_split = compiled.num_split.data();
+        const double *restrict score = compiled.score.data();
+        for (size_t tree = 0; tree < context.ntrees; tree++)
+        {
+            size_t st = tree_offsets[tree];
+            depth += score[st + traverse_compiled_tree(col_num + st, tree_left + st, num_split + st,
+                                                       numeric_row, (size_t)1)];
+        }
+        exp_avg_depth = compiled.exp_avg_depth;
+        scoring_metric = compiled.scoring_metric;
+    }
+
+    else
+    {
+        /* with a single row, column-major and row-major layouts are the same */
+        PredictionData<real_t, int>
+                       prediction_data = {(real_t*)numeric_row, (int*)categ_row, (size_t)1,
+                                          true, (size_t)0, (size_t)0,
+                                          (real_t*)NULL, (int*)NULL, (int*)NULL,
+                                          (real_t*)NULL, (int*)NULL, (int*)NULL};
+
+        if (context.model_outputs != NULL)
+        {
+            IsoForest &model_outputs = *(IsoForest*)context.model_outputs;
+            if (!predict_itree_row_specialized(prediction_data, model_outputs, depth))
+            {
+                for (size_t tree = 0; tree < context.ntrees; tree++)
+                {
+                    depth += traverse_itree(model_outputs.trees[tree],
+                                            model_outputs,
+                                            prediction_data,
+                                            (std::vector<ImputeNode>*)NULL,
+                                            (ImputedData<int, double>*)NULL,
+                                            (double)0,
+                                            (size_t)0,
+                                            (int*)NULL,
+                                            (double*)NULL,
+                                            (size_t)0);
+                }
+            }
+            exp_avg_depth = model_outputs.exp_avg_depth;
+            scoring_metric = model_outputs.scoring_metric;
+        }
+
+        else
+        {
+            ExtIsoForest &model_outputs_ext = *(ExtIsoForest*)context.model_outputs_ext;
+            if (model_outputs_ext.missing_action == Fail && categ_row == NULL && !model_outputs_ext.has_range_penalty)
+            {
+                for (size_t tree = 0; tree < context.ntrees; tree++)
+                    traverse_hplane_fast_colmajor(model_outputs_ext.hplanes[tree], model_outputs_ext, prediction_data,
+                                                  depth, (int*)NULL, (double*)NULL, (size_t)0);
+            }
+
+            else
+            {
+                for (size_t tree = 0; tree < context.ntrees; tree++)
+                    traverse_hplane(model_outputs_ext.hplanes[tree], model_outputs_ext, prediction_data,
+                                    depth, (std::vector<ImputeNode>*)NULL, (ImputedData<int, double>*)NULL,
+                                    (int*)NULL, (double*)NULL, (size_t)0);
+            }
+            exp_avg_depth = model_outputs_ext.exp_avg_depth;
+            scoring_metric = model_outputs_ext.scoring_metric;
+        }
+    }
+
+    depths_to_scores(&depth, (double*)NULL, (size_t)1, context.ntrees,
+                     exp_avg_depth, scoring_metric, context.standardize);
+    return depth;
+}
+
+/* Same choice of kernels as in 'predict_itree_specialized', but without going through a parallel region */
+template <class PredictionData>
+static inline bool predict_itree_row_specialized(PredictionData &prediction_data, const IsoForest &model_outputs,
+                                                 double &depth) noexcept
+{
+    if (model_outputs.missing_action == Divide)
+        return false;
+
+    CategConfig categ_config;
+    if (prediction_data.categ_data == NULL)
+        categ_config = CategNone;
+    else if (model_outputs.cat_split_type == SingleCateg)
+        categ_config = CategSingle;
+    else if (model_outputs.new_cat_action == Random)
+        categ_config = CategSubSetRandom;
+    else if (model_outputs.new_cat_action == Smallest)
+        categ_config = CategSubSetSmallest;
+    else
+        return false;
+
+    bool impute_missing = model_outputs.missing_action == Impute;
+    if (impute_missing && model_outputs.has_range_penalty)
+        depth = predict_itree_row_dispatch<true, true>(prediction_data, model_outputs, categ_config);
+    else if (impute_missing)
+        depth = predict_itree_row_dispatch<true, false>(prediction_data, model_outputs, categ_config);
+    else if (model_outputs.has_range_penalty)
+        depth = predict_itree_row_dispatch<false, true>(prediction_data, model_outputs, categ_config);
+    else
+        depth = predict_itree_row_dispatch<false, false>(prediction_data, model_outputs, categ_config);
+    return true;
+}
+
+template <bool impute_missing, bool has_range_penalty, class PredictionData>
+static inline double predict_itree_row_dispatch(PredictionData &prediction_data, const IsoForest &model_outputs,
+                                                CategConfig categ_config) noexcept
+{
+    switch (categ_config)
+    {
+        case CategNone:
+            return predict_itree_row_kernel<CategNone, impute_missing, has_range_penalty>(prediction_data, model_outputs);
+        case CategSingle:
+            return predict_itree_row_kernel<CategSingle, impute_missing, has_range_penalty>(prediction_data, model_outputs);
+        case CategSubSetRandom:
+            return predict_itree_row_kernel<CategSubSetRandom, impute_missing, has_range_penalty>(prediction_data, model_outputs);
+        default:
+            return predict_itree_row_kernel<CategSubSetSmallest, impute_missing, has_range_penalty>(prediction_data, model_outputs);
+    }
+}
+
+template <CategConfig categ_config, bool impute_missing, bool has_range_penalty, class PredictionData>
+static inline double predict_itree_row_kernel(PredictionData &prediction_data, const IsoForest &model_outputs) noexcept
+{
+    double depth = 0;
+    for (const auto &tree : model_outputs.trees)
+    {
+        depth += traverse_itree_specialized<DenseColMajor, categ_config, impute_missing, has_range_penalty>
+                                           (tree, prediction_data, (size_t)0, (const int*)NULL, (const int*)NULL,
+                                            (int*)NULL, (double*)NULL);
+    }
+    return depth;
+}
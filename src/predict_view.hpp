@@ -0,0 +1,357 @@
+/*    Isolation forests and variations thereof, with adjustments for incorporation
+*     of categorical variables and missing values.
+*     Writen for C++11 standard and aimed at being used in R and Python.
+*     
+*     This library is based on the following works:
+*     [1] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation forest."
+*         2008 Eighth IEEE International Conference on Data Mining. IEEE, 2008.
+*     [2] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation-based anomaly detection."
+*         ACM Transactions on Knowledge Discovery from Data (TKDD) 6.1 (2012): 3.
+*     [3] Hariri, Sahand, Matias Carrasco Kind, and Robert J. Brunner.
+*         "Extended Isolation Forest."
+*         arXiv preprint arXiv:1811.02141 (2018).
+*     [4] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "On detecting clustered anomalies using SCiForest."
+*         Joint European Conference on Machine Learning and Knowledge Discovery in Databases. Springer, Berlin, Heidelberg, 2010.
+*     [5] https://sourceforge.net/projects/iforest/
+*     [6] https://math.stackexchange.com/questions/3388518/expected-number-of-paths-required-to-separate-elements-in-a-binary-tree
+*     [7] Quinlan, J. Ross. C4. 5: programs for machine learning. Elsevier, 2014.
+*     [8] Cortes, David.
+*         "Distance approximation using Isolation Forests."
+*         arXiv preprint arXiv:1910.12362 (2019).
+*     [9] Cortes, David.
+*         "Imputing missing values with unsupervised random trees."
+*         arXiv preprint arXiv:1911.06646 (2019).
+*     [10] https://math.stackexchange.com/questions/3333220/expected-average-depth-in-random-binary-tree-constructed-top-to-bottom
+*     [11] Cortes, David.
+*          "Revisiting randomized choices in isolation forests."
+*          arXiv preprint arXiv:2110.13402 (2021).
+*     [12] Guha, Sudipto, et al.
+*          "Robust random cut forest based anomaly detection on streams."
+*          International conference on machine learning. PMLR, 2016.
+*     [13] Cortes, David.
+*          "Isolation forests: looking beyond tree depth."
+*          arXiv preprint arXiv:2111.11639 (2021).
+*     [14] Ting, Kai Ming, Yue Zhu, and Zhi-Hua Zhou.
+*          "Isolation kernel and its effect on SVM"
+*          Proceedings of the 24th ACM SIGKDD
+*          International Conference on Knowledge Discovery & Data Mining. 2018.
+* 
+*     BSD 2-Clause License
+*     Copyright (c) 2019-2024, David Cortes
+*     All rights reserved.
+*     Redistribution and use in source and binary forms, with or without
+*     modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this
+*       list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*       this list of conditions and the following disclaimer in the documentation
+*       and/or other materials provided with the distribution.
+*     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+*     AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+*     IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*     FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*     DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*     SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*     CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*     OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*     OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "isotree.hpp"
+
+/* Predict outlier scores or average depths using a view over a serialized single-variable model
+* 
+* Parameters
+* ==========
+* - numeric_data[nrows * ncols_numeric]
+*       Pointer to numeric data for which to make predictions, in the same format as for
+*       'predict_iforest'. Pass NULL if there are no dense numeric columns.
+* - categ_data[nrows * ncols_categ]
+*       Pointer to categorical data for which to make predictions, in the same format as for
+*       'predict_iforest'. Pass NULL if there are no categorical columns.
+* - is_col_major
+*       Whether 'numeric_data' and 'categ_data' come in column-major order.
+* - ld_numeric
+*       Leading dimension of the array 'numeric_data', if it is passed in row-major format.
+* - ld_categ
+*       Leading dimension of the array 'categ_data', if it is passed in row-major format.
+* - Xc[nnz], Xc_ind[nnz], Xc_indptr[ncols_numeric + 1]
+*       Numeric data in sparse CSC format. Pass NULL if not used.
+* - Xr[nnz], Xr_ind[nnz], Xr_indptr[nrows + 1]
+*       Numeric data in sparse CSR format. Pass NULL if not used.
+* - nrows
+*       Number of rows for which to make predictions.
+* - nthreads
+*       Number of parallel threads to use.
+* - standardize
+*       Whether to standardize the average depths for each row according to their relative magnitude
+*       compared to the expected average, in order to obtain an outlier score. If passing 'false',
+*       will output the average depth instead.
+* - view
+*       View over a serialized model, as produced by 'build_IsoForestView'.
+* - output_depths[nrows] (out)
+*       Pointer to array where the output average depths or outlier scores will be written into.
+* - per_tree_depths[nrows * ntrees] (out)
+*       Pointer to array where to output per-tree depths for each row, in row-major order.
+*       Pass NULL if this type of output is not needed.
+*/
+template <class real_t, class sparse_ix>
+void predict_iforest_view(real_t *restrict numeric_data, int *restrict categ_data,
+                          bool is_col_major, size_t ld_numeric, size_t ld_categ,
+                          real_t *restrict Xc, sparse_ix *restrict Xc_ind, sparse_ix *restrict Xc_indptr,
+                          real_t *restrict Xr, sparse_ix *restrict Xr_ind, sparse_ix *restrict Xr_indptr,
+                          size_t nrows, int nthreads, bool standardize,
+                          const IsoForestView &view,
+                          double *restrict output_depths, double *restrict per_tree_depths)
+{
+    if (unlikely(!nrows)) return;
+
+    PredictionData<real_t, sparse_ix>
+                   prediction_data = {numeric_data, categ_data, nrows,
+                                      is_col_major, ld_numeric, ld_categ,
+                                      Xc, Xc_ind, Xc_indptr,
+                                      Xr, Xr_ind, Xr_indptr};
+
+    if ((size_t)nthreads > nrows)
+        nthreads = nrows;
+
+    const size_t ntrees = view.trees.size();
+    const char *const *node_ptrs = view.nodes.empty()? (const char *const*)NULL : view.nodes.data();
+    std::atomic<bool> threw_exception(false);
+    std::exception_ptr ex = NULL;
+
+    auto predict_row = [&](size_t row, int thread_id)
+    {
+        (void)thread_id;
+        if (threw_exception) return;
+
+        const sparse_ix *row_st = NULL, *row_end = NULL;
+        if (prediction_data.Xr_indptr != NULL)
+        {
+            row_st  = prediction_data.Xr_ind + prediction_data.Xr_indptr[row];
+            row_end = prediction_data.Xr_ind + prediction_data.Xr_indptr[row + 1];
+        }
+
+        double score = 0;
+        try
+        {
+            for (size_t tree = 0; tree < ntrees; tree++)
+            {
+                score += traverse_itree_view(view.trees[tree],
+                                             (node_ptrs == NULL)? node_ptrs : (node_ptrs + view.tree_first_node[tree]),
+                                             view, prediction_data, row, row_st, row_end,
+                                             (per_tree_depths == NULL)? NULL : (per_tree_depths + tree + row*ntrees),
+                                             (size_t) 0);
+            }
+            output_depths[row] = score;
+        }
+        catch (...)
+        {
+            catch_task_exception(threw_exception, ex);
+        }
+    };
+    run_parallel_for(get_thread_executor(), nrows, nthreads, false, predict_row);
+
+    if (threw_exception)
+        std::rethrow_exception(ex);
+
+    depths_to_scores(output_depths, per_tree_depths,
+                     nrows, ntrees, view.exp_avg_depth,
+                     view.scoring_metric, standardize);
+}
+
+/* Nodes are read field-by-field from the layout written by 'serialize_node', which
+   has no alignment guarantees, hence the 'memcpy' calls (these get compiled to plain
+   loads on platforms that allow unaligned access). */
+static inline size_t get_size_view_node() noexcept
+{
+    return sizeof(uint8_t) + sizeof(int) + sizeof(double) * 6 + sizeof(size_t) * 4;
+}
+
+static inline double read_view_double(const char *node, size_t field) noexcept
+{
+    double out;
+    memcpy(&out, node + sizeof(uint8_t) + sizeof(int) + field * sizeof(double), sizeof(double));
+    return out;
+}
+
+static inline size_t read_view_size_t(const char *node, size_t field) noexcept
+{
+    size_t out;
+    memcpy(&out, node + sizeof(uint8_t) + sizeof(int) + 6 * sizeof(double) + field * sizeof(size_t), sizeof(size_t));
+    return out;
+}
+
+static inline const char* get_view_node(const char *tree_start, const char *const *node_ptrs, size_t node) noexcept
+{
+    return (node_ptrs == NULL)? (tree_start + node * get_size_view_node()) : node_ptrs[node];
+}
+
+template <class PredictionData, class sparse_ix>
+double traverse_itree_view(const char *tree_start, const char *const *node_ptrs,
+                           const IsoForestView &view, PredictionData &prediction_data,
+                           size_t row, const sparse_ix *row_st, const sparse_ix *row_end,
+                           double *restrict tree_depth, size_t curr_lev)
+{
+    double xval;
+    int    cval;
+    double range_penalty = 0;
+    const char *node;
+    double pct_tree_left;
+    size_t ncat;
+
+    while (true)
+    {
+        node = get_view_node(tree_start, node_ptrs, curr_lev);
+        size_t tree_left = read_view_size_t(node, 1);
+
+        if (unlikely(tree_left == 0))
+        {
+            double score = read_view_double(node, 2);
+            if (unlikely(tree_depth != NULL))
+                *tree_depth = score;
+            return score - range_penalty;
+        }
+
+        size_t col_num = read_view_size_t(node, 0);
+        size_t tree_right = read_view_size_t(node, 2);
+        bool is_missing;
+        if ((ColType)node[0] == Numeric)
+        {
+            if (prediction_data.Xr_indptr != NULL)
+                xval = extract_spR(prediction_data, row_st, row_end, col_num);
+            else if (prediction_data.Xc_indptr != NULL)
+                xval = extract_spC(prediction_data, row, col_num);
+            else if (prediction_data.is_col_major)
+                xval = prediction_data.numeric_data[row + col_num * prediction_data.nrows];
+            else
+                xval = prediction_data.numeric_data[col_num + row * prediction_data.ncols_numeric];
+            is_missing = std::isnan(xval);
+        }
+
+        else
+        {
+            cval = prediction_data.categ_data[
+                        prediction_data.is_col_major?
+                        (row + col_num * prediction_data.nrows)
+                            :
+                        (col_num + row * prediction_data.ncols_categ)
+                    ];
+            is_missing = cval < 0;
+        }
+
+        if (unlikely(is_missing))
+        {
+            switch(view.missing_action)
+            {
+                case Divide:
+                {
+                    goto divide_weight;
+                }
+
+                case Impute:
+                {
+                    curr_lev = (read_view_double(node, 1) >= .5)? tree_left : tree_right;
+                    continue;
+                }
+
+                case Fail:
+                {
+                    return NAN;
+                }
+            }
+        }
+
+        if ((ColType)node[0] == Numeric)
+        {
+            range_penalty += (xval < read_view_double(node, 3)) || (xval > read_view_double(node, 4));
+            curr_lev = (xval <= read_view_double(node, 0))? tree_left : tree_right;
+            continue;
+        }
+
+        if (view.cat_split_type == SingleCateg)
+        {
+            int chosen_cat;
+            memcpy(&chosen_cat, node + sizeof(uint8_t), sizeof(int));
+            curr_lev = (cval == chosen_cat)? tree_left : tree_right;
+            continue;
+        }
+
+        ncat = read_view_size_t(node, 3);
+        if (ncat == 0)
+        {
+            if (cval <= 1)
+            {
+                curr_lev = (cval == 0)? tree_left : tree_right;
+                continue;
+            }
+
+            switch(view.new_cat_action)
+            {
+                case Smallest:
+                {
+                    curr_lev = (read_view_double(node, 1) < .5)? tree_left : tree_right;
+                    continue;
+                }
+
+                case Weighted:
+                {
+                    goto divide_weight;
+                }
+
+                default:
+                {
+                    assert(0);
+                    curr_lev = tree_right;
+                    continue;
+                }
+            }
+        }
+
+        else
+        {
+            const signed char *cat_split = (const signed char*)(node + get_size_view_node());
+            switch(view.new_cat_action)
+            {
+                case Random:
+                {
+                    cval = (cval >= (int)ncat)? (cval % (int)ncat) : cval;
+                    curr_lev = cat_split[cval]? tree_left : tree_right;
+                    continue;
+                }
+
+                case Smallest:
+                {
+                    if (unlikely(cval >= (int)ncat))
+                        curr_lev = (read_view_double(node, 1) < .5)? tree_left : tree_right;
+                    else
+                        curr_lev = cat_split[cval]? tree_left : tree_right;
+                    continue;
+                }
+
+                case Weighted:
+                {
+                    if (cval >= (int)ncat || cat_split[cval] == (-1))
+                        goto divide_weight;
+                    curr_lev = cat_split[cval]? tree_left : tree_right;
+                    continue;
+                }
+            }
+        }
+
+        divide_weight:
+        if (tree_depth != NULL) throw_unsupported_pred_error();
+        pct_tree_left = read_view_double(node, 1);
+        return
+            pct_tree_left
+                * traverse_itree_view(tree_start, node_ptrs, view, prediction_data,
+                                      row, row_st, row_end, tree_depth, tree_left)
+            + (1. - pct_tree_left)
+                * traverse_itree_view(tree_start, node_ptrs, view, prediction_data,
+                                      row, row_st, row_end, tree_depth, tree_right)
+            - range_penalty;
+    }
+}
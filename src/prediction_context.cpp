@@ -0,0 +1,125 @@
+/*    Isolation forests and variations thereof, with adjustments for incorporation
+*     of categorical variables and missing values.
+*     Writen for C++11 standard and aimed at being used in R and Python.
+*     
+*     This library is based on the following works:
+*     [1] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation forest."
+*         2008 Eighth IEEE International Conference on Data Mining. IEEE, 2008.
+*     [2] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation-based anomaly detection."
+*         ACM Transactions on Knowledge Discovery from Data (TKDD) 6.1 (2012): 3.
+*     [3] Hariri, Sahand, Matias Carrasco Kind, and Robert J. Brunner.
+*         "Extended Isolation Forest."
+*         arXiv preprint arXiv:1811.02141 (2018).
+*     [4] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "On detecting clustered anomalies using SCiForest."
+*         Joint European Conference on Machine Learning and Knowledge Discovery in Databases. Springer, Berlin, Heidelberg, 2010.
+*     [5] https://sourceforge.net/projects/iforest/
+*     [6] https://math.stackexchange.com/questions/3388518/expected-number-of-paths-required-to-separate-elements-in-a-binary-tree
+*     [7] Quinlan, J. Ross. C4. 5: programs for machine learning. Elsevier, 2014.
+*     [8] Cortes, David.
+*         "Distance approximation using Isolation Forests."
+*         arXiv preprint arXiv:1910.12362 (2019).
+*     [9] Cortes, David.
+*         "Imputing missing values with unsupervised random trees."
+*         arXiv preprint arXiv:1911.06646 (2019).
+*     [10] https://math.stackexchange.com/questions/3333220/expected-average-depth-in-random-binary-tree-constructed-top-to-bottom
+*     [11] Cortes, David.
+*          "Revisiting randomized choices in isolation forests."
+*          arXiv preprint arXiv:2110.13402 (2021).
+*     [12] Guha, Sudipto, et al.
+*          "Robust random cut forest based anomaly detection on streams."
+*          International conference on machine learning. PMLR, 2016.
+*     [13] Cortes, David.
+*          "Isolation forests: looking beyond tree depth."
+*          arXiv preprint arXiv:2111.11639 (2021).
+*     [14] Ting, Kai Ming, Yue Zhu, and Zhi-Hua Zhou.
+*          "Isolation kernel and its effect on SVM"
+*          Proceedings of the 24th ACM SIGKDD
+*          International Conference on Knowledge Discovery & Data Mining. 2018.
+* 
+*     BSD 2-Clause License
+*     Copyright (c) 2019-2022, David Cortes
+*     All rights reserved.
+*     Redistribution and use in source and binary forms, with or without
+*     modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this
+*       list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*       this list of conditions and the following disclaimer in the documentation
+*       and/or other materials provided with the distribution.
+*     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+*     AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+*     IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*     FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*     DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*     SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*     CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*     OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*     OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "isotree.hpp"
+
+/* Prepare a context for scoring single rows with low latency
+* 
+* Parameters
+* ==========
+* - context (out)
+*       Object where the context will be stored. Any previous contents will be overwritten.
+* - model_outputs
+*       Pointer to fitted single-variable model object from function 'fit_iforest'. Pass NULL
+*       if the predictions are to be made from an extended model. Can only pass one of
+*       'model_outputs' and 'model_outputs_ext'.
+* - model_outputs_ext
+*       Pointer to fitted extended model object from function 'fit_iforest'. Pass NULL
+*       if the predictions are to be made from a single-variable model. Can only pass one of
+*       'model_outputs' and 'model_outputs_ext'.
+* - standardize
+*       Whether the scores produced with this context should be standardized, as when passing
+*       'standardize=true' to 'predict_iforest'. If passing 'false', will produce the average
+*       isolation depth instead.
+* 
+* Note that the context keeps pointers to the model objects, which must therefore outlive it and
+* must not be modified while it is in use. If the model is modified afterwards (e.g. by adding trees
+* or re-arranging its nodes), the context must be built again.
+*/
+void build_prediction_context(PredictionContext &context,
+                              const IsoForest *model_outputs, const ExtIsoForest *model_outputs_ext,
+                              bool standardize)
+{
+    if (!model_outputs && !model_outputs_ext)
+        throw std::runtime_error("'build_prediction_context' got a NULL pointer for model.\n");
+    if (model_outputs && model_outputs_ext)
+        throw std::runtime_error("'build_prediction_context' got two models as inputs.\n");
+    size_t ntrees = model_outputs? model_outputs->trees.size() : model_outputs_ext->hplanes.size();
+    if (!ntrees)
+        throw std::runtime_error("Cannot build prediction context for a model without trees.\n");
+
+    context.model_outputs = model_outputs;
+    context.model_outputs_ext = model_outputs_ext;
+    context.standardize = standardize;
+    context.ntrees = ntrees;
+
+    /* Models that only have numeric splits and don't need to check for missing values
+       are evaluated from a compiled forest, which is faster to traverse. */
+    if (model_outputs != NULL)
+        context.use_compiled = model_outputs->missing_action == Fail &&
+                               !model_outputs->has_range_penalty &&
+                               has_only_numeric_splits(*model_outputs);
+    else
+        context.use_compiled = model_outputs_ext->missing_action == Fail &&
+                               !model_outputs_ext->has_range_penalty &&
+                               has_only_numeric_splits(*model_outputs_ext);
+
+    context.compiled = CompiledIsoForest();
+    context.compiled_ext = CompiledExtIsoForest();
+    if (context.use_compiled)
+    {
+        if (model_outputs != NULL)
+            build_compiled_forest(context.compiled, *model_outputs, false, 1);
+        else
+            build_compiled_forest(context.compiled_ext, *model_outputs_ext, 1);
+    }
+}
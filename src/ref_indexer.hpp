@@ -102,15 +102,15 @@ void set_reference_points(TreesIndexer &indexer, Model &model, const bool with_d
                     &indexer);
     ignored.reset();
 
-    #pragma omp parallel for schedule(dynamic) num_threads(nthreads) \
-            shared(indexer, node_indices_predict, ntrees)
-    for (size_t_for tree = 0; tree < (decltype(tree))ntrees; tree++)
+    auto build_tree_refs = [&](size_t tree, int thread_id)
     {
+        (void)thread_id;
         indexer.indices[tree].reference_points.assign(node_indices_predict.get() + tree*nrows,
                                                       node_indices_predict.get() + (tree+1)*nrows);
         indexer.indices[tree].reference_points.shrink_to_fit();
         build_ref_node(indexer.indices[tree]);
-    }
+    };
+    run_parallel_for(get_thread_executor(), ntrees, nthreads, true, build_tree_refs);
 }
 
 template <class real_t, class sparse_ix>
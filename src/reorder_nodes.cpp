@@ -0,0 +1,334 @@
+/*    Isolation forests and variations thereof, with adjustments for incorporation
+*     of categorical variables and missing values.
+*     Writen for C++11 standard and aimed at being used in R and Python.
+*     
+*     This library is based on the following works:
+*     [1] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation forest."
+*         2008 Eighth IEEE International Conference on Data Mining. IEEE, 2008.
+*     [2] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation-based anomaly detection."
+*         ACM Transactions on Knowledge Discovery from Data (TKDD) 6.1 (2012): 3.
+*     [3] Hariri, Sahand, Matias Carrasco Kind, and Robert J. Brunner.
+*         "Extended Isolation Forest."
+*         arXiv preprint arXiv:1811.02141 (2018).
+*     [4] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "On detecting clustered anomalies using SCiForest."
+*         Joint European Conference on Machine Learning and Knowledge Discovery in Databases. Springer, Berlin, Heidelberg, 2010.
+*     [5] https://sourceforge.net/projects/iforest/
+*     [6] https://math.stackexchange.com/questions/3388518/expected-number-of-paths-required-to-separate-elements-in-a-binary-tree
+*     [7] Quinlan, J. Ross. C4. 5: programs for machine learning. Elsevier, 2014.
+*     [8] Cortes, David.
+*         "Distance approximation using Isolation Forests."
+*         arXiv preprint arXiv:1910.12362 (2019).
+*     [9] Cortes, David.
+*         "Imputing missing values with unsupervised random trees."
+*         arXiv preprint arXiv:1911.06646 (2019).
+*     [10] https://math.stackexchange.com/questions/3333220/expected-average-depth-in-random-binary-tree-constructed-top-to-bottom
+*     [11] Cortes, David.
+*          "Revisiting randomized choices in isolation forests."
+*          arXiv preprint arXiv:2110.13402 (2021).
+*     [12] Guha, Sudipto, et al.
+*          "Robust random cut forest based anomaly detection on streams."
+*          International conference on machine learning. PMLR, 2016.
+*     [13] Cortes, David.
+*          "Isolation forests: looking beyond tree depth."
+*          arXiv preprint arXiv:2111.11639 (2021).
+*     [14] Ting, Kai Ming, Yue Zhu, and Zhi-Hua Zhou.
+*          "Isolation kernel and its effect on SVM"
+*          Proceedings of the 24th ACM SIGKDD
+*          International Conference on Knowledge Discovery & Data Mining. 2018.
+* 
+*     BSD 2-Clause License
+*     Copyright (c) 2019-2022, David Cortes
+*     All rights reserved.
+*     Redistribution and use in source and binary forms, with or without
+*     modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this
+*       list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*       this list of conditions and the following disclaimer in the documentation
+*       and/or other materials provided with the distribution.
+*     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+*     AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+*     IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*     FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*     DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*     SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*     CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*     OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*     OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "isotree.hpp"
+
+/*  Trees are built depth-first, which means that the left branch of a node is always next to
+    it in memory, but the right branch can be arbitrarily far away, making that path a cache
+    miss. The functions here re-arrange the nodes so that they are laid out in blocks of
+    connected nodes, in which each block is a sub-tree in breadth-first order (which for
+    balanced sub-trees will contain the top levels of the sub-tree), and the blocks themselves
+    are laid out depth-first, with child blocks coming after their parent. Terminal nodes
+    get renumbered according to their new positions. */
+
+static inline bool is_terminal_node(const IsoTree &node)
+{
+    return node.tree_left == 0;
+}
+
+static inline bool is_terminal_node(const IsoHPlane &node)
+{
+    return node.hplane_left == 0;
+}
+
+static inline void remap_children(IsoTree &node, const size_t *restrict new_pos)
+{
+    node.tree_left = new_pos[node.tree_left];
+    node.tree_right = new_pos[node.tree_right];
+}
+
+static inline void remap_children(IsoHPlane &node, const size_t *restrict new_pos)
+{
+    node.hplane_left = new_pos[node.hplane_left];
+    node.hplane_right = new_pos[node.hplane_right];
+}
+
+static inline size_t get_idx_tree_left(const IsoTree &node)
+{
+    return node.tree_left;
+}
+
+static inline size_t get_idx_tree_left(const IsoHPlane &node)
+{
+    return node.hplane_left;
+}
+
+static inline size_t get_idx_tree_right(const IsoTree &node)
+{
+    return node.tree_right;
+}
+
+static inline size_t get_idx_tree_right(const IsoHPlane &node)
+{
+    return node.hplane_right;
+}
+
+/* Nodes are larger than a cache line, so blocks are instead meant to fit within a memory
+   page, which keeps the first levels of each sub-tree close together for the prefetchers
+   and the TLB. Sizes are taken as complete binary trees, which is what the blocks will
+   look like if the sub-tree is balanced. */
+template <class Node>
+static size_t get_block_size()
+{
+    const size_t max_bytes = 4096;
+    size_t block_size = 3;
+    while ((2 * block_size + 1) * sizeof(Node) <= max_bytes)
+        block_size = 2 * block_size + 1;
+    return block_size;
+}
+
+template <class Node>
+static void calc_blocked_order(const std::vector<Node> &tree, size_t block_size,
+                               std::vector<size_t> &new_order,
+                               std::vector<size_t> &block_roots,
+                               std::vector<size_t> &bfs_queue)
+{
+    new_order.clear();
+    block_roots.assign(1, (size_t)0);
+    while (!block_roots.empty())
+    {
+        bfs_queue.assign(1, block_roots.back());
+        block_roots.pop_back();
+
+        size_t head = 0;
+        while (head < bfs_queue.size() && head < block_size)
+        {
+            size_t node = bfs_queue[head++];
+            new_order.push_back(node);
+            if (!is_terminal_node(tree[node]))
+            {
+                bfs_queue.push_back(get_idx_tree_left(tree[node]));
+                bfs_queue.push_back(get_idx_tree_right(tree[node]));
+            }
+        }
+
+        /* nodes that didn't fit in the block start new blocks, leftmost ones first */
+        for (size_t ix = bfs_queue.size(); ix > head; ix--)
+            block_roots.push_back(bfs_queue[ix-1]);
+    }
+
+    if (unlikely(new_order.size() != tree.size())) unexpected_error();
+}
+
+template <class Node>
+static void reorder_single_tree(std::vector<Node> &tree,
+                                std::vector<ImputeNode> *imputer_tree,
+                                SingleTreeIndex *tree_index,
+                                const std::vector<size_t> &new_order,
+                                std::vector<size_t> &new_pos)
+{
+    const size_t ntree = tree.size();
+    new_pos.resize(ntree);
+    for (size_t ix = 0; ix < ntree; ix++)
+        new_pos[new_order[ix]] = ix;
+
+    std::vector<Node> new_tree(ntree);
+    for (size_t ix = 0; ix < ntree; ix++)
+    {
+        new_tree[ix] = std::move(tree[new_order[ix]]);
+        if (!is_terminal_node(new_tree[ix]))
+            remap_children(new_tree[ix], new_pos.data());
+    }
+    tree.swap(new_tree);
+
+    if (imputer_tree != NULL)
+    {
+        std::vector<ImputeNode> new_imputer_tree(ntree);
+        for (size_t ix = 0; ix < ntree; ix++)
+        {
+            new_imputer_tree[ix] = std::move((*imputer_tree)[new_order[ix]]);
+            new_imputer_tree[ix].parent = new_pos[new_imputer_tree[ix].parent];
+        }
+        imputer_tree->swap(new_imputer_tree);
+    }
+
+    if (tree_index != NULL)
+    {
+        /* terminal nodes are numbered according to their order in the tree, so the numbers
+           change, and everything indexed by them needs to be permuted accordingly */
+        std::vector<size_t> old_mappings;
+        old_mappings.swap(tree_index->terminal_node_mappings);
+        size_t n_terminal;
+        build_terminal_node_mappings_single_tree(tree_index->terminal_node_mappings, n_terminal, tree);
+        if (unlikely(n_terminal != tree_index->n_terminal)) unexpected_error();
+
+        std::vector<size_t> new_terminal(n_terminal);
+        for (size_t node = 0; node < ntree; node++)
+        {
+            if (is_terminal_node(tree[new_pos[node]]))
+                new_terminal[old_mappings[node]] = tree_index->terminal_node_mappings[new_pos[node]];
+        }
+
+        if (!tree_index->node_depths.empty())
+        {
+            std::vector<double> new_depths(n_terminal);
+            for (size_t ix = 0; ix < n_terminal; ix++)
+                new_depths[new_terminal[ix]] = tree_index->node_depths[ix];
+            tree_index->node_depths.swap(new_depths);
+        }
+
+        if (!tree_index->node_distances.empty())
+        {
+            size_t ncomb = calc_ncomb(n_terminal);
+            std::vector<double> new_distances(ncomb);
+            for (size_t i = 0; i < n_terminal; i++)
+            {
+                for (size_t j = i + 1; j < n_terminal; j++)
+                {
+                    new_distances[ix_comb(new_terminal[i], new_terminal[j], n_terminal, ncomb)]
+                        =
+                    tree_index->node_distances[ix_comb(i, j, n_terminal, ncomb)];
+                }
+            }
+            tree_index->node_distances.swap(new_distances);
+        }
+
+        if (!tree_index->reference_points.empty())
+        {
+            for (size_t &ref : tree_index->reference_points)
+                ref = new_terminal[ref];
+            build_ref_node(*tree_index);
+        }
+    }
+}
+
+template <class Node>
+static void reorder_nodes_template(std::vector<std::vector<Node>> &trees, Imputer *imputer, TreesIndexer *indexer, int nthreads)
+{
+    size_t ntrees = trees.size();
+    if (imputer != NULL && imputer->imputer_tree.empty()) imputer = NULL;
+    if (indexer != NULL && indexer->indices.empty()) indexer = NULL;
+    if (imputer != NULL && imputer->imputer_tree.size() != ntrees)
+        throw std::runtime_error("Number of trees in imputer does not match with model.\n");
+    if (indexer != NULL && indexer->indices.size() != ntrees)
+        throw std::runtime_error("Number of trees in indexer does not match with model.\n");
+    for (size_t tree = 0; tree < ntrees; tree++)
+    {
+        if (imputer != NULL && imputer->imputer_tree[tree].size() != trees[tree].size())
+            throw std::runtime_error("Imputer nodes do not match with model.\n");
+        if (indexer != NULL && indexer->indices[tree].terminal_node_mappings.size() != trees[tree].size())
+            throw std::runtime_error("Indexer nodes do not match with model.\n");
+    }
+
+    const size_t block_size = get_block_size<Node>();
+    Executor *executor = get_thread_executor();
+    if (executor != NULL)
+        nthreads = executor->num_workers();
+    #ifndef _OPENMP
+    else
+        nthreads = 1;
+    #endif
+    std::vector<std::vector<size_t>> new_order(nthreads), new_pos(nthreads), block_roots(nthreads), bfs_queue(nthreads);
+
+    std::atomic<bool> threw_exception(false);
+    std::exception_ptr ex = NULL;
+    auto reorder_tree = [&](size_t tree, int tid)
+    {
+        if (threw_exception) return;
+        try
+        {
+            std::vector<Node> &curr_tree = trees[tree];
+            if (curr_tree.size() <= 1) return;
+            calc_blocked_order(curr_tree, block_size, new_order[tid], block_roots[tid], bfs_queue[tid]);
+            reorder_single_tree(curr_tree,
+                                (imputer == NULL)? (std::vector<ImputeNode>*)NULL : &imputer->imputer_tree[tree],
+                                (indexer == NULL)? (SingleTreeIndex*)NULL : &indexer->indices[tree],
+                                new_order[tid], new_pos[tid]);
+        }
+
+        catch (...)
+        {
+            catch_task_exception(threw_exception, ex);
+        }
+    };
+    run_parallel_for(executor, ntrees, nthreads, true, reorder_tree);
+
+    if (threw_exception) std::rethrow_exception(ex);
+}
+
+/* Re-arrange the nodes of each tree for a more cache-friendly memory layout
+* 
+* Parameters
+* ==========
+* - model / model_outputs / model_outputs_ext (in, out)
+*       Fitted model object whose nodes will be re-arranged. Can be either a freshly-fitted
+*       model or a de-serialized one. Predictions from the model will not change, but
+*       the terminal node numbers from predictions will be different afterwards.
+* - imputer (in, out)
+*       Imputation object associated to the model, which will be re-arranged along with it.
+*       Pass NULL if the model was built without an imputer.
+* - indexer (in, out)
+*       Indexer object associated to the model, which will be re-arranged along with it.
+*       Pass NULL if the model was built without an indexer.
+* - nthreads
+*       Number of parallel threads to use.
+*/
+void reorder_nodes(IsoForest &model, Imputer *imputer, TreesIndexer *indexer, int nthreads)
+{
+    reorder_nodes_template(model.trees, imputer, indexer, nthreads);
+}
+
+void reorder_nodes(ExtIsoForest &model, Imputer *imputer, TreesIndexer *indexer, int nthreads)
+{
+    reorder_nodes_template(model.hplanes, imputer, indexer, nthreads);
+}
+
+void reorder_nodes(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
+                   Imputer *imputer, TreesIndexer *indexer, int nthreads)
+{
+    if (model_outputs != NULL)
+        reorder_nodes(*model_outputs, imputer, indexer, nthreads);
+    else if (model_outputs_ext != NULL)
+        reorder_nodes(*model_outputs_ext, imputer, indexer, nthreads);
+    else
+        throw std::runtime_error("Must pass a fitted model.\n");
+}
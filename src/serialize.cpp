@@ -2497,7 +2497,7 @@ template <class Model>
 std::string serialization_pipeline(const Model &model)
 {
     std::string serialized;
-    serialized.resize(get_size_model(model));
+    serialized.resize(determine_serialized_size(model));
     char *ptr = &serialized[0];
     serialization_pipeline(model, ptr);
     return serialized;
@@ -2608,6 +2608,82 @@ void deserialize_IsoForest_FromFile(IsoForest &model, const wchar_t *fname)
 }
 #endif
 
+/* Note: this requires the model to have been serialized in a machine with the same
+   characteristics (endianness, 'int' and 'size_t' sizes), as the nodes are later read
+   from the bytes as they are, without any conversion. */
+void build_IsoForestView(IsoForestView &view, const char *in)
+{
+    check_setup_info(in);
+
+    uint8_t model_in;
+    read_bytes<uint8_t>((void*)&model_in, (size_t)1, in);
+    if (model_in != IsoForestModel)
+        throw std::runtime_error("Serialized object is not a single-variable isolation forest model.\n");
+    size_t size_model;
+    read_bytes<size_t>((void*)&size_model, (size_t)1, in);
+
+    uint8_t data_en[5];
+    read_bytes<uint8_t>((void*)data_en, (size_t)5, in);
+    view.new_cat_action = (NewCategAction)data_en[0];
+    view.cat_split_type = (CategSplit)data_en[1];
+    view.missing_action = (MissingAction)data_en[2];
+    view.has_range_penalty = (bool)data_en[3];
+    view.scoring_metric = (ScoringMetric)data_en[4];
+
+    double data_doubles[2];
+    read_bytes<double>((void*)data_doubles, (size_t)2, in);
+    view.exp_avg_depth = data_doubles[0];
+    view.exp_avg_sep = data_doubles[1];
+
+    size_t data_sizets[2];
+    read_bytes<size_t>((void*)data_sizets, (size_t)2, in);
+    view.orig_sample_size = data_sizets[0];
+    const size_t ntrees = data_sizets[1];
+
+    view.trees.resize(ntrees);
+    view.trees.shrink_to_fit();
+    view.nodes.clear();
+    view.tree_first_node.clear();
+
+    /* nodes without categorical subset splits all have the same size, with the
+       length of 'cat_split' being the last field before the variable-size part */
+    const size_t size_node = get_size_node(IsoTree());
+    const size_t pos_ncat = size_node - sizeof(size_t);
+    size_t ncat;
+    size_t veclen;
+    size_t n_nodes = 0;
+    bool has_variable_size = false;
+    for (size_t tree = 0; tree < ntrees; tree++)
+    {
+        read_bytes<size_t>((void*)&veclen, (size_t)1, in);
+        view.trees[tree] = in;
+        n_nodes += veclen;
+        for (size_t node = 0; node < veclen; node++)
+        {
+            memcpy(&ncat, in + pos_ncat, sizeof(size_t));
+            has_variable_size |= ncat != 0;
+            in += size_node + ncat;
+        }
+    }
+
+    if (!has_variable_size) return;
+
+    view.nodes.reserve(n_nodes);
+    view.tree_first_node.resize(ntrees);
+    for (size_t tree = 0; tree < ntrees; tree++)
+    {
+        view.tree_first_node[tree] = view.nodes.size();
+        const char *curr_node = view.trees[tree];
+        memcpy(&veclen, curr_node - sizeof(size_t), sizeof(size_t));
+        for (size_t node = 0; node < veclen; node++)
+        {
+            view.nodes.push_back(curr_node);
+            memcpy(&ncat, curr_node + pos_ncat, sizeof(size_t));
+            curr_node += size_node + ncat;
+        }
+    }
+}
+
 void serialize_ExtIsoForest(const ExtIsoForest &model, char *out)
 {
     serialization_pipeline(model, out);
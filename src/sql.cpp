@@ -223,25 +223,25 @@ std::vector<std::string> generate_sql(const IsoForest *model_outputs, const ExtI
         max_nodes = std::max(max_nodes,
                              (model_outputs != NULL)?
                                 (model_outputs->trees[tree].size()) : (model_outputs_ext->hplanes[tree].size()));
-    std::vector<std::string> conditions_left(max_nodes);
-    std::vector<std::string> conditions_right(max_nodes);
+    Executor *executor = get_thread_executor();
+    int nworkers = (executor != NULL)? executor->num_workers() : std::max(nthreads, 1);
+    std::vector<std::vector<std::string>> thread_conditions_left(nworkers, std::vector<std::string>(max_nodes));
+    std::vector<std::vector<std::string>> thread_conditions_right(nworkers, std::vector<std::string>(max_nodes));
 
     std::vector<std::vector<std::string>> all_node_rules(ntrees_use);
     std::vector<std::string> out(ntrees_use);
 
-    size_t tree_use;
-
-    bool threw_exception = false;
+    std::atomic<bool> threw_exception(false);
     std::exception_ptr ex = NULL;
 
-    #pragma omp parallel for schedule(dynamic) num_threads(nthreads) \
-            shared(model_outputs, model_outputs_ext, numeric_colnames, categ_colnames, categ_levels, \
-                   loop_st, loop_end, index1, single_tree, all_node_rules, out, ex, threw_exception) \
-            firstprivate(conditions_left, conditions_right) private(tree_use)
-    for (size_t_for tree = loop_st; tree < loop_end; tree++)
+    auto generate_tree = [&](size_t pos, int thread_id)
     {
-        if (threw_exception) continue;
-        
+        if (threw_exception) return;
+
+        size_t tree = (size_t)loop_st + pos;
+        size_t tree_use;
+        std::vector<std::string> &conditions_left = thread_conditions_left[thread_id];
+        std::vector<std::string> &conditions_right = thread_conditions_right[thread_id];
         try
         {
             if (model_outputs != NULL)
@@ -299,16 +299,10 @@ std::vector<std::string> generate_sql(const IsoForest *model_outputs, const ExtI
 
         catch (...)
         {
-            #pragma omp critical
-            {
-                if (!threw_exception)
-                {
-                    threw_exception = true;
-                    ex = std::current_exception();
-                }
-            }
+            catch_task_exception(threw_exception, ex);
         }
-    }
+    };
+    run_parallel_for(executor, (size_t)(loop_end - loop_st), nthreads, true, generate_tree);
 
     if (threw_exception)
         std::rethrow_exception(ex);
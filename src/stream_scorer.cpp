@@ -0,0 +1,337 @@
+/*    Isolation forests and variations thereof, with adjustments for incorporation
+*     of categorical variables and missing values.
+*     Writen for C++11 standard and aimed at being used in R and Python.
+*     
+*     This library is based on the following works:
+*     [1] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation forest."
+*         2008 Eighth IEEE International Conference on Data Mining. IEEE, 2008.
+*     [2] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation-based anomaly detection."
+*         ACM Transactions on Knowledge Discovery from Data (TKDD) 6.1 (2012): 3.
+*     [3] Hariri, Sahand, Matias Carrasco Kind, and Robert J. Brunner.
+*         "Extended Isolation Forest."
+*         arXiv preprint arXiv:1811.02141 (2018).
+*     [4] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "On detecting clustered anomalies using SCiForest."
+*         Joint European Conference on Machine Learning and Knowledge Discovery in Databases. Springer, Berlin, Heidelberg, 2010.
+*     [5] https://sourceforge.net/projects/iforest/
+*     [6] https://math.stackexchange.com/questions/3388518/expected-number-of-paths-required-to-separate-elements-in-a-binary-tree
+*     [7] Quinlan, J. Ross. C4. 5: programs for machine learning. Elsevier, 2014.
+*     [8] Cortes, David.
+*         "Distance approximation using Isolation Forests."
+*         arXiv preprint arXiv:1910.12362 (2019).
+*     [9] Cortes, David.
+*         "Imputing missing values with unsupervised random trees."
+*         arXiv preprint arXiv:1911.06646 (2019).
+*     [10] https://math.stackexchange.com/questions/3333220/expected-average-depth-in-random-binary-tree-constructed-top-to-bottom
+*     [11] Cortes, David.
+*          "Revisiting randomized choices in isolation forests."
+*          arXiv preprint arXiv:2110.13402 (2021).
+*     [12] Guha, Sudipto, et al.
+*          "Robust random cut forest based anomaly detection on streams."
+*          International conference on machine learning. PMLR, 2016.
+*     [13] Cortes, David.
+*          "Isolation forests: looking beyond tree depth."
+*          arXiv preprint arXiv:2111.11639 (2021).
+*     [14] Ting, Kai Ming, Yue Zhu, and Zhi-Hua Zhou.
+*          "Isolation kernel and its effect on SVM"
+*          Proceedings of the 24th ACM SIGKDD
+*          International Conference on Knowledge Discovery & Data Mining. 2018.
+* 
+*     BSD 2-Clause License
+*     Copyright (c) 2019-2022, David Cortes
+*     All rights reserved.
+*     Redistribution and use in source and binary forms, with or without
+*     modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this
+*       list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*       this list of conditions and the following disclaimer in the documentation
+*       and/or other materials provided with the distribution.
+*     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+*     AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+*     IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*     FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*     DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*     SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*     CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*     OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*     OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "isotree.hpp"
+#include "isotree_exportable.hpp"
+#include <fstream>
+#include <future>
+#if defined(_WIN32) || defined(_WIN64)
+#   include <io.h>
+#   include <fcntl.h>
+#endif
+
+/* Files with hundreds of millions of rows cannot be loaded into memory at once, so here they
+   are read in chunks of rows, which are scored and written out before moving on to the next
+   chunk. There are two chunk buffers: while the rows in one of them are being scored (using
+   the usual multi-threaded prediction routines) and their scores written, the next chunk is
+   read and parsed into the other buffer in a separate thread. Memory usage is thus bounded by
+   twice the chunk size, regardless of the size of the input. */
+#define STREAM_CHUNK_BYTES ((size_t)1 << 23)
+
+/* Returns the number of rows read, which is less than 'chunk_rows' only at the end of the input. */
+static size_t read_binary_chunk(std::istream &input, double *restrict X,
+                                size_t chunk_rows, size_t ncols_numeric, size_t &rows_read)
+{
+    size_t row_bytes = ncols_numeric * sizeof(double);
+    input.read((char*)X, (std::streamsize)(chunk_rows * row_bytes));
+    if (input.bad())
+        throw std::runtime_error("Error: could not read from input stream.\n");
+    size_t n_bytes = (size_t)input.gcount();
+    if (n_bytes % row_bytes)
+        throw std::runtime_error("Error: input ends with an incomplete row after row " +
+                                 std::to_string(rows_read + n_bytes / row_bytes) + ".\n");
+    rows_read += n_bytes / row_bytes;
+    return n_bytes / row_bytes;
+}
+
+static inline bool is_blank(char c, char delimiter) noexcept
+{
+    return (c == ' ' || c == '\t') && c != delimiter;
+}
+
+/* Empty fields and fields containing 'NA' are taken as missing values. */
+static void parse_csv_line(const char *line, double *restrict row, size_t ncols_numeric,
+                           char delimiter, size_t line_num)
+{
+    const char *ptr = line;
+    char *end;
+    for (size_t col = 0; col < ncols_numeric; col++)
+    {
+        while (is_blank(*ptr, delimiter)) ptr++;
+        if (*ptr == delimiter || *ptr == '\0' || *ptr == '\r')
+        {
+            row[col] = NAN;
+            end = (char*)ptr;
+        }
+        else
+        {
+            row[col] = std::strtod(ptr, &end);
+            if (end == ptr && (ptr[0] == 'N' || ptr[0] == 'n') && (ptr[1] == 'A' || ptr[1] == 'a'))
+            {
+                row[col] = NAN;
+                end = (char*)ptr + 2;
+            }
+            else if (end == ptr)
+            {
+                throw std::runtime_error("Error: invalid value in line " + std::to_string(line_num) +
+                                         ", column " + std::to_string(col + 1) + " of input.\n");
+            }
+        }
+        while (is_blank(*end, delimiter) || *end == '\r') end++;
+
+        if (col < ncols_numeric - 1 && *end != delimiter)
+            throw std::runtime_error("Error: line " + std::to_string(line_num) + " of input has " +
+                                     ((*end == '\0')? "fewer columns than expected" : "an invalid value") + ".\n");
+        if (col == ncols_numeric - 1 && *end != '\0')
+            throw std::runtime_error("Error: line " + std::to_string(line_num) + " of input has " +
+                                     ((*end == delimiter)? "more columns than expected" : "an invalid value") + ".\n");
+        ptr = end + 1;
+    }
+}
+
+/* Lines that are empty (e.g. at the end of the file) are skipped. */
+static size_t read_csv_chunk(std::istream &input, double *restrict X,
+                             size_t chunk_rows, size_t ncols_numeric, char delimiter,
+                             std::string &line, size_t &line_num)
+{
+    size_t row = 0;
+    while (row < chunk_rows && std::getline(input, line))
+    {
+        line_num++;
+        if (line.empty() || (line.size() == 1 && line[0] == '\r'))
+            continue;
+        parse_csv_line(line.c_str(), X + row * ncols_numeric, ncols_numeric, delimiter, line_num);
+        row++;
+    }
+    if (input.bad())
+        throw std::runtime_error("Error: could not read from input stream.\n");
+    return row;
+}
+
+static void write_scores(std::ostream &output, const double *restrict scores, size_t nrows,
+                         bool binary_output, std::vector<char> &text_buffer)
+{
+    if (binary_output)
+    {
+        output.write((const char*)scores, (std::streamsize)(nrows * sizeof(double)));
+    }
+
+    else
+    {
+        /* at most 24 characters per number with "%.17g", plus line break and terminator */
+        text_buffer.resize(nrows * 26);
+        char *ptr = text_buffer.data();
+        for (size_t row = 0; row < nrows; row++)
+            ptr += std::snprintf(ptr, 26, "%.17g\n", scores[row]);
+        output.write(text_buffer.data(), (std::streamsize)(ptr - text_buffer.data()));
+    }
+
+    if (output.fail())
+        throw std::runtime_error("Error: could not write to output stream.\n");
+}
+
+/* Predict outlier scores for rows read from a stream, writing them to another stream
+* 
+* Parameters
+* ==========
+* - input
+*       Stream from which to read the numeric data, in row-major order. If passing 'csv_input=false',
+*       it should contain the raw bytes of the 'double' values of each row, one after another (as
+*       they are laid out in memory), in a machine with the same endianness as the current one,
+*       and should be opened in binary mode. If passing 'csv_input=true', it should contain one row
+*       per line, with the values separated by 'delimiter'. Empty fields and fields with value 'NA'
+*       are taken as missing values, which are handled as in 'predict_iforest'.
+* - output
+*       Stream to which to write the scores, in the same order as the rows of the input. If passing
+*       'binary_output=false', will write one score per line as text, otherwise will write the raw
+*       bytes of the 'double' values (in which case the stream should be opened in binary mode).
+* - ncols_numeric
+*       Number of columns in each row of the input. Must cover all of the columns used by the model.
+* - csv_input
+*       Whether the input is in text format (delimited values) or in raw binary format.
+* - delimiter
+*       Character that separates the values in each line, when passing 'csv_input=true'.
+* - skip_header
+*       Whether to skip the first line of the input, when passing 'csv_input=true'.
+* - binary_output
+*       Whether to write the scores in raw binary format or as text.
+* - chunk_rows
+*       Number of rows to read and score at a time. Memory usage is proportional to twice this number
+*       times 'ncols_numeric'. Pass zero to use chunks of around 8MB.
+* - nthreads
+*       Number of parallel threads to use for scoring each chunk, as in 'predict_iforest'. Reading
+*       and parsing the input is done in one additional thread, which runs at the same time as the
+*       scoring of the previous chunk.
+* - standardize
+*       Whether to output standardized outlier scores or average depths, as in 'predict_iforest'.
+* - model_outputs
+*       Pointer to fitted single-variable model object from function 'fit_iforest'. Pass NULL
+*       if the predictions are to be made from an extended model. Can only pass one of
+*       'model_outputs' and 'model_outputs_ext'.
+* - model_outputs_ext
+*       Pointer to fitted extended model object from function 'fit_iforest'. Pass NULL
+*       if the predictions are to be made from a single-variable model. Can only pass one of
+*       'model_outputs' and 'model_outputs_ext'.
+* 
+* The model must not have any splits on categorical columns, since those cannot be passed here.
+* 
+* Returns
+* =======
+* Number of rows that were scored.
+*/
+size_t predict_iforest_stream(std::istream &input, std::ostream &output,
+                              size_t ncols_numeric, bool csv_input, char delimiter, bool skip_header,
+                              bool binary_output, size_t chunk_rows, int nthreads, bool standardize,
+                              IsoForest *model_outputs, ExtIsoForest *model_outputs_ext)
+{
+    if (!model_outputs && !model_outputs_ext)
+        throw std::runtime_error("'predict_iforest_stream' got a NULL pointer for model.\n");
+    if (model_outputs && model_outputs_ext)
+        throw std::runtime_error("'predict_iforest_stream' got two models as inputs.\n");
+    if (!ncols_numeric)
+        throw std::runtime_error("'predict_iforest_stream' requires at least one column.\n");
+    if (model_outputs? !has_only_numeric_splits(*model_outputs) : !has_only_numeric_splits(*model_outputs_ext))
+        throw std::runtime_error("Cannot score streams with models that have categorical splits.\n");
+    if ((model_outputs? get_max_numeric_col(*model_outputs) : get_max_numeric_col(*model_outputs_ext)) >= ncols_numeric)
+        throw std::runtime_error("Model uses more columns than 'ncols_numeric'.\n");
+
+    if (!chunk_rows)
+        chunk_rows = std::max((size_t)1024, STREAM_CHUNK_BYTES / (ncols_numeric * sizeof(double)));
+
+    std::string line;
+    size_t line_num = 0;
+    size_t rows_read = 0;
+    if (csv_input && skip_header)
+    {
+        std::getline(input, line);
+        line_num++;
+    }
+
+    std::vector<double> chunks[2];
+    chunks[0].resize(chunk_rows * ncols_numeric);
+    chunks[1].resize(chunk_rows * ncols_numeric);
+    std::vector<double> scores(chunk_rows);
+    std::vector<char> text_buffer;
+
+    auto read_chunk = [&](double *X) -> size_t {
+        if (csv_input)
+            return read_csv_chunk(input, X, chunk_rows, ncols_numeric, delimiter, line, line_num);
+        else
+            return read_binary_chunk(input, X, chunk_rows, ncols_numeric, rows_read);
+    };
+
+    size_t total_rows = 0;
+    int curr = 0;
+    size_t nrows_curr = read_chunk(chunks[curr].data());
+    while (nrows_curr)
+    {
+        /* Note: if scoring throws, the destructor of the future waits for the reader to finish */
+        std::future<size_t> next_chunk = std::async(std::launch::async, read_chunk, chunks[1 - curr].data());
+
+        predict_iforest(chunks[curr].data(), (int*)NULL,
+                        false, ncols_numeric, (size_t)0,
+                        (double*)NULL, (int*)NULL, (int*)NULL,
+                        (double*)NULL, (int*)NULL, (int*)NULL,
+                        nrows_curr, nthreads, standardize,
+                        model_outputs, model_outputs_ext,
+                        scores.data(), (int*)NULL, (double*)NULL,
+                        (TreesIndexer*)NULL);
+        write_scores(output, scores.data(), nrows_curr, binary_output, text_buffer);
+        total_rows += nrows_curr;
+
+        nrows_curr = next_chunk.get();
+        curr = 1 - curr;
+    }
+
+    output.flush();
+    if (output.fail())
+        throw std::runtime_error("Error: could not write to output stream.\n");
+    return total_rows;
+}
+
+/* Same as above, but reading from and writing to files. Passing NULL or "-" as file name will
+   read from standard input or write to standard output, respectively. Existing output files
+   will be overwritten. */
+size_t predict_iforest_stream(const char *input_file, const char *output_file,
+                              size_t ncols_numeric, bool csv_input, char delimiter, bool skip_header,
+                              bool binary_output, size_t chunk_rows, int nthreads, bool standardize,
+                              IsoForest *model_outputs, ExtIsoForest *model_outputs_ext)
+{
+    bool use_stdin = !input_file || !std::strcmp(input_file, "-");
+    bool use_stdout = !output_file || !std::strcmp(output_file, "-");
+
+    std::ifstream input_fstream;
+    std::ofstream output_fstream;
+    if (!use_stdin)
+    {
+        input_fstream.open(input_file, std::ios::in | std::ios::binary);
+        if (!input_fstream.is_open())
+            throw std::runtime_error(std::string("Error: could not open input file '") + input_file + "'.\n");
+    }
+    if (!use_stdout)
+    {
+        output_fstream.open(output_file, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!output_fstream.is_open())
+            throw std::runtime_error(std::string("Error: could not open output file '") + output_file + "'.\n");
+    }
+
+    #if defined(_WIN32) || defined(_WIN64)
+    if (use_stdin && !csv_input) _setmode(_fileno(stdin), _O_BINARY);
+    if (use_stdout && binary_output) _setmode(_fileno(stdout), _O_BINARY);
+    #endif
+
+    return predict_iforest_stream(use_stdin? (std::istream&)std::cin : (std::istream&)input_fstream,
+                                  use_stdout? (std::ostream&)std::cout : (std::ostream&)output_fstream,
+                                  ncols_numeric, csv_input, delimiter, skip_header,
+                                  binary_output, chunk_rows, nthreads, standardize,
+                                  model_outputs, model_outputs_ext);
+}
@@ -3629,7 +3629,7 @@ void colmajor_to_rowmajor(const real_t *restrict X, size_t nrows, size_t ncols,
     X_row_major.resize(nrows * ncols);
     for (size_t row = 0; row < nrows; row++)
         for (size_t col = 0; col < ncols; col++)
-            X_row_major[row + col*nrows] = X[col + row*ncols];
+            X_row_major[col + row*ncols] = X[row + col*nrows];
 }
 
 template <class real_t, class sparse_ix>
@@ -0,0 +1,78 @@
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cstdio>
+#include "isotree_oop.hpp"
+
+/*  Compares the speed of predictions with regular node-by-node traversal of the trees
+    ('predict_iforest' on the model object and on a pre-built 'CompiledIsoForest') against
+    the feature-by-feature evaluation of 'BitvectorIsoForest', for different numbers of
+    columns and sample sizes, using a single thread and data in row-major order.
+
+    To compile, first build the library through the cmake system, then, from the root folder:
+      g++ -o bench timings/bitvector_benchmark.cpp -std=c++11 -O3 -I./include -l:libisotree.so -L./build -Wl,-rpath,./build
+    Then run with './bench'
+*/
+
+using namespace isotree;
+
+template <class Fun>
+static double time_ms(Fun fun)
+{
+    auto st = std::chrono::steady_clock::now();
+    fun();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - st).count();
+}
+
+int main()
+{
+    const size_t nrows = 10000;
+    const size_t ntrees = 500;
+    std::mt19937 rng(123);
+    std::normal_distribution<double> rnorm(0, 1);
+
+    printf("| Columns | Sample size | Nodes/tree | predict_iforest (ms) | Compiled (ms) | Bitvector (ms) |\n");
+    printf("| :---:   | :---:       | :---:      | :---:                | :---:         | :---:          |\n");
+    for (size_t ncols : {10, 100, 500})
+    {
+        std::vector<double> X(nrows * ncols);
+        for (double &x : X) x = rnorm(rng);
+
+        for (size_t sample_size : {64, 256, 1024})
+        {
+            IsolationForest iso;
+            iso.ndim = 1;
+            iso.ntrees = ntrees;
+            iso.sample_size = sample_size;
+            iso.missing_action = Fail;
+            iso.nthreads = 1;
+            iso.fit(X.data(), nrows, ncols);
+
+            size_t tot_nodes = 0;
+            for (const auto &tree : iso.get_model().trees) tot_nodes += tree.size();
+
+            CompiledIsoForest compiled;
+            build_compiled_forest(compiled, iso.get_model(), false, 1);
+            BitvectorIsoForest bv_forest;
+            build_bitvector_forest(bv_forest, iso.get_model());
+
+            std::vector<double> scores(nrows);
+            double t_base = time_ms([&](){
+                iso.predict(X.data(), NULL, false, nrows, ncols, 0, true, scores.data(), NULL, NULL);
+            });
+            double t_compiled = time_ms([&](){
+                predict_iforest_compiled(X.data(), false, ncols, nrows, 1, true, compiled,
+                                         scores.data(), (int*)NULL, NULL);
+            });
+            double t_bitvector = time_ms([&](){
+                predict_iforest_bitvector(X.data(), false, ncols, nrows, 1, true, bv_forest,
+                                          scores.data(), (int*)NULL, NULL);
+            });
+            printf("| %zu | %zu | %.0f | %.1f | %.1f | %.1f |\n",
+                   ncols, sample_size, (double)tot_nodes / (double)ntrees,
+                   t_base, t_compiled, t_bitvector);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,118 @@
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cstdio>
+#include "isotree_oop.hpp"
+
+/*  Checks the batch sizes at which 'predict_iforest' should build a compiled forest for each call
+    ('should_use_compiled_forest'), by predicting the same rows in batches of different sizes,
+    using a single thread and data in row-major order:
+    - 'Node-by-node': calling 'predict_iforest' with one row at a time, which never takes the
+      compiled route and traverses the model objects in the same way as larger batches would
+      without it.
+    - 'Compiled per call': building a new compiled forest through 'build_compiled_forest' for
+      each batch and predicting with it through 'predict_iforest_compiled', which is what
+      'predict_iforest' does when it takes the compiled route.
+    - 'predict_iforest': the function as it is, which decides on its own which route to take.
+
+    To compile, first build the library through the cmake system, then, from the root folder:
+      g++ -o dispatchbench timings/compiled_dispatch_benchmark.cpp -std=c++11 -O3 -I./include -l:libisotree.so -L./build -Wl,-rpath,./build
+    Then run with './dispatchbench'
+*/
+
+using namespace isotree;
+
+template <class Fun>
+static double time_ms(Fun fun)
+{
+    auto st = std::chrono::steady_clock::now();
+    fun();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - st).count();
+}
+
+int main()
+{
+    const size_t nrows = 10000;
+    const size_t ntrees = 500;
+    const size_t ncols = 10;
+    std::mt19937 rng(123);
+    std::normal_distribution<double> rnorm(0, 1);
+    std::vector<double> X(nrows * ncols);
+    for (double &x : X) x = rnorm(rng);
+    std::vector<double> scores(nrows);
+
+    printf("| ndim | Sample size | Nodes/tree | Batch size | Node-by-node (ms) | Compiled per call (ms) | predict_iforest (ms) |\n");
+    printf("| :---: | :---:      | :---:      | :---:      | :---:             | :---:                  | :---:                |\n");
+    for (size_t ndim : {(size_t)1, (size_t)2})
+    {
+        for (size_t sample_size : {(size_t)256, (size_t)1024})
+        {
+            IsolationForest iso;
+            iso.ndim = ndim;
+            iso.ntrees = ntrees;
+            iso.sample_size = sample_size;
+            iso.missing_action = Fail;
+            iso.nthreads = 1;
+            iso.fit(X.data(), nrows, ncols);
+            IsoForest *model = (ndim == 1)? &iso.get_model() : nullptr;
+            ExtIsoForest *model_ext = (ndim == 1)? nullptr : &iso.get_model_ext();
+
+            size_t tot_nodes = 0;
+            if (model != nullptr)
+                for (const auto &tree : model->trees) tot_nodes += tree.size();
+            else
+                for (const auto &hplane : model_ext->hplanes) tot_nodes += hplane.size();
+
+            auto predict_batches = [&](size_t batch_size, size_t batch_size_base)
+            {
+                for (size_t row = 0; row < nrows; row += batch_size)
+                {
+                    size_t n = std::min(batch_size, nrows - row);
+                    for (size_t st = 0; st < n; st += batch_size_base)
+                        predict_iforest(X.data() + (row + st) * ncols, (int*)nullptr,
+                                        false, ncols, (size_t)0,
+                                        (double*)nullptr, (int*)nullptr, (int*)nullptr,
+                                        (double*)nullptr, (int*)nullptr, (int*)nullptr,
+                                        std::min(batch_size_base, n - st), 1, true,
+                                        model, model_ext,
+                                        scores.data() + row + st, (int*)nullptr, (double*)nullptr,
+                                        (TreesIndexer*)nullptr);
+                }
+            };
+
+            /* the row-by-row predictions do not depend on the batch size */
+            double t_nodes = time_ms([&](){
+                predict_batches(nrows, 1);
+            });
+            for (size_t batch_size : {(size_t)16, (size_t)32, (size_t)64, (size_t)128, (size_t)256, (size_t)1024, nrows})
+            {
+                double t_compiled = time_ms([&](){
+                    for (size_t row = 0; row < nrows; row += batch_size)
+                    {
+                        size_t n = std::min(batch_size, nrows - row);
+                        if (model != nullptr) {
+                            CompiledIsoForest compiled;
+                            build_compiled_forest(compiled, *model, false, 1);
+                            predict_iforest_compiled(X.data() + row * ncols, false, ncols, n, 1, true, compiled,
+                                                     scores.data() + row, (int*)nullptr, (double*)nullptr);
+                        }
+                        else {
+                            CompiledExtIsoForest compiled_ext;
+                            build_compiled_forest(compiled_ext, *model_ext, 1);
+                            predict_iforest_compiled(X.data() + row * ncols, false, ncols, n, 1, true, compiled_ext,
+                                                     scores.data() + row, (int*)nullptr, (double*)nullptr);
+                        }
+                    }
+                });
+                double t_dispatch = time_ms([&](){
+                    predict_batches(batch_size, batch_size);
+                });
+                printf("| %d | %d | %.0f | %d | %.1f | %.1f | %.1f |\n",
+                       (int)ndim, (int)sample_size, (double)tot_nodes / (double)ntrees, (int)batch_size,
+                       t_nodes, t_compiled, t_dispatch);
+            }
+        }
+    }
+    return 0;
+}
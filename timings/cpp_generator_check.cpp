@@ -0,0 +1,192 @@
+#include <vector>
+#include <string>
+#include <random>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <dlfcn.h>
+#include "isotree_oop.hpp"
+
+/*  Checks that the source code produced by 'generate_cpp' ('IsolationForest::to_cpp') gives
+    the same outlier scores as 'predict' on the model object, for models with different
+    handling of missing values and categorical variables. The generated code is written
+    to a temporary folder, compiled into a shared object with the system's C compiler,
+    and loaded at runtime.
+
+    To compile, first build the library through the cmake system, then, from the root folder:
+      g++ -o gencheck timings/cpp_generator_check.cpp -std=c++11 -O3 -I./include -l:libisotree.so -L./build -Wl,-rpath,./build -ldl
+    Then run with './gencheck'. The compiler used for the generated code can be changed
+    through the environment variable 'CC' (default is 'cc').
+    It can also be built along with the library by configuring cmake with '-DBUILD_TIMINGS_CHECKS=ON',
+    in which case it runs through 'ctest' (using the C compiler configured for the project).
+*/
+
+using namespace isotree;
+
+typedef double (*scoring_fun)(const double*, const int*);
+
+struct CheckCase
+{
+    const char *name;
+    size_t ndim;
+    MissingAction missing_action;
+    NewCategAction new_cat_action;
+    bool penalize_range;
+    bool with_categ;
+};
+
+int main()
+{
+    const size_t nrows = 2000;
+    const size_t ncols_numeric = 4;
+    const size_t ncols_categ = 2;
+    const int ncat = 5;
+    std::mt19937 rng(123);
+    std::normal_distribution<double> rnorm(0, 1);
+    std::uniform_int_distribution<int> rcateg(0, ncat - 1);
+    std::uniform_real_distribution<double> runif(0, 1);
+
+    /* Training data does not have missing values, while the data to score has missing values
+       (except for models with 'missing_action=Fail'), new categories, and values outside of
+       the ranges seen during training, in both cases in column-major order */
+    std::vector<double> X_num(nrows * ncols_numeric);
+    std::vector<int> X_cat(nrows * ncols_categ);
+    for (double &x : X_num) x = rnorm(rng);
+    for (int &x : X_cat) x = rcateg(rng);
+
+    std::vector<double> Xtest_num(nrows * ncols_numeric);
+    std::vector<double> Xtest_num_nonan(nrows * ncols_numeric);
+    std::vector<int> Xtest_cat(nrows * ncols_categ);
+    for (size_t ix = 0; ix < Xtest_num.size(); ix++)
+    {
+        Xtest_num_nonan[ix] = 1.5 * rnorm(rng);
+        Xtest_num[ix] = (runif(rng) < 0.05)? NAN : Xtest_num_nonan[ix];
+    }
+    for (int &x : Xtest_cat)
+    {
+        double u = runif(rng);
+        x = (u < 0.05)? -1 : ((u < 0.1)? ncat : rcateg(rng));
+    }
+
+    const std::vector<CheckCase> cases = {
+        {"fail",          1, Fail,    Smallest, false, false},
+        {"fail_categ",    1, Fail,    Smallest, false, true },
+        {"impute",        1, Impute,  Smallest, false, true },
+        {"divide",        1, Divide,  Smallest, false, true },
+        {"ndim2",         2, Impute,  Smallest, false, true },
+        {"ndim2_fail",    2, Fail,    Smallest, false, false},
+        {"range_penalty", 1, Impute,  Smallest, true,  true },
+        {"range_fail",    1, Fail,    Smallest, true,  false},
+        {"weighted",      1, Impute,  Weighted, false, true },
+        {"weighted_div",  1, Divide,  Weighted, false, true },
+        {"ndim2_weighted",2, Impute,  Weighted, true,  true },
+    };
+
+    std::vector<IsolationForest> models(cases.size());
+    std::string code;
+    for (size_t ix = 0; ix < cases.size(); ix++)
+    {
+        const CheckCase &c = cases[ix];
+        IsolationForest &iso = models[ix];
+        iso.ndim = c.ndim;
+        iso.ntrees = 50;
+        iso.sample_size = 256;
+        iso.missing_action = c.missing_action;
+        iso.new_cat_action = c.new_cat_action;
+        iso.cat_split_type = SubSet;
+        iso.penalize_range = c.penalize_range;
+        iso.nthreads = 1;
+        iso.random_seed = 1 + ix;
+        iso.fit(X_num.data(), ncols_numeric, nrows,
+                c.with_categ? X_cat.data() : NULL, c.with_categ? ncols_categ : 0,
+                c.with_categ? std::vector<int>(ncols_categ, ncat).data() : NULL,
+                NULL, NULL);
+        code += iso.to_cpp(std::string("score_") + c.name, true);
+        code += "\n";
+    }
+
+    char dirname[] = "/tmp/isotree_gencheck_XXXXXX";
+    if (!mkdtemp(dirname))
+    {
+        fprintf(stderr, "Could not create temporary folder.\n");
+        return 1;
+    }
+    std::string src_file = std::string(dirname) + "/generated.c";
+    std::string lib_file = std::string(dirname) + "/generated.so";
+    FILE *out = fopen(src_file.c_str(), "w");
+    if (!out)
+    {
+        fprintf(stderr, "Could not write generated code.\n");
+        return 1;
+    }
+    fwrite(code.data(), 1, code.size(), out);
+    fclose(out);
+
+    const char *cc = getenv("CC");
+    std::string cmd = std::string(cc? cc : "cc") + " -O2 -ffp-contract=off -shared -fPIC -o "
+                      + lib_file + " " + src_file + " -lm";
+    if (system(cmd.c_str()) != 0)
+    {
+        fprintf(stderr, "Failed to compile generated code: %s\n", cmd.c_str());
+        return 1;
+    }
+    void *handle = dlopen(lib_file.c_str(), RTLD_NOW);
+    if (!handle)
+    {
+        fprintf(stderr, "Failed to load generated code: %s\n", dlerror());
+        return 1;
+    }
+
+    bool all_passed = true;
+    printf("| Model | Nodes/tree | Max. abs. diff | Rows differing |\n");
+    printf("| :---: | :---:      | :---:          | :---:          |\n");
+    for (size_t ix = 0; ix < cases.size(); ix++)
+    {
+        const CheckCase &c = cases[ix];
+        IsolationForest &iso = models[ix];
+        scoring_fun fun = (scoring_fun)dlsym(handle, (std::string("score_") + c.name).c_str());
+        if (!fun)
+        {
+            fprintf(stderr, "Generated function for '%s' not found.\n", c.name);
+            return 1;
+        }
+
+        std::vector<double> &Xnum = (c.missing_action == Fail)? Xtest_num_nonan : Xtest_num;
+        int *Xcat = c.with_categ? Xtest_cat.data() : NULL;
+        std::vector<double> scores(nrows);
+        iso.predict(Xnum.data(), Xcat, true, nrows, 0, 0, true, scores.data(), NULL, NULL);
+
+        size_t tot_nodes = 0;
+        if (c.ndim == 1)
+            for (const auto &tree : iso.get_model().trees) tot_nodes += tree.size();
+        else
+            for (const auto &tree : iso.get_model_ext().hplanes) tot_nodes += tree.size();
+
+        double max_diff = 0;
+        size_t n_diff = 0;
+        std::vector<double> row_num(ncols_numeric);
+        std::vector<int> row_cat(ncols_categ);
+        for (size_t row = 0; row < nrows; row++)
+        {
+            for (size_t col = 0; col < ncols_numeric; col++)
+                row_num[col] = Xnum[row + col*nrows];
+            for (size_t col = 0; col < ncols_categ; col++)
+                row_cat[col] = Xtest_cat[row + col*nrows];
+            double score = fun(row_num.data(), c.with_categ? row_cat.data() : NULL);
+            double diff = std::fabs(score - scores[row]);
+            if (std::isnan(score) != std::isnan(scores[row]) || diff > 1e-12)
+                n_diff++;
+            if (!std::isnan(diff) && diff > max_diff)
+                max_diff = diff;
+        }
+        printf("| %s | %.0f | %.3g | %zu |\n", c.name, (double)tot_nodes / (double)iso.get_ntrees(), max_diff, n_diff);
+        all_passed = all_passed && n_diff == 0;
+    }
+
+    dlclose(handle);
+    remove(lib_file.c_str());
+    remove(src_file.c_str());
+    remove(dirname);
+    printf("%s\n", all_passed? "All scores match." : "Some scores do not match.");
+    return all_passed? 0 : 1;
+}
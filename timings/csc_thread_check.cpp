@@ -0,0 +1,163 @@
+#include <vector>
+#include <random>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include "isotree_oop.hpp"
+
+/*  Checks that predictions on sparse data in CSC format, which are parallelized by trees, give
+    the same results for any number of threads, and the same results as for the same data in
+    dense format. Each thread reuses the same array of row indices for every tree that it
+    processes, and the traversal does not always sort it again (it doesn't at categorical
+    splits, nor below the root when the model penalizes ranges), so this is checked for models
+    with categorical columns, range penalty, and missing values and new categories at prediction
+    time, which are imputed, or divided between branches with weights.
+
+    The results compared are the raw depths, terminal node numbers, and per-tree depths. The
+    depths are added up in the same order for any number of threads, so they must match exactly
+    between threads, while against the dense format they are compared up to roundoff.
+
+    To compile, first build the library through the cmake system, then, from the root folder:
+      g++ -o cscthreadcheck timings/csc_thread_check.cpp -std=c++11 -O3 -I./include -l:libisotree.so -L./build -Wl,-rpath,./build
+    Then run with './cscthreadcheck'
+    It can also be built along with the library by configuring cmake with '-DBUILD_TIMINGS_CHECKS=ON',
+    in which case it runs through 'ctest'.
+*/
+
+using namespace isotree;
+
+struct Config {
+    const char *name;
+    size_t ndim;
+    MissingAction missing_action;
+    NewCategAction new_cat_action;
+};
+
+struct Outputs {
+    std::vector<double> depths;
+    std::vector<int> tree_num;
+    std::vector<double> per_tree_depths;
+};
+
+static bool close_enough(const std::vector<double> &a, const std::vector<double> &b)
+{
+    if (a.size() != b.size()) return false;
+    for (size_t ix = 0; ix < a.size(); ix++)
+        if (std::fabs(a[ix] - b[ix]) > 1e-8 * std::fmax(1., std::fabs(a[ix]))) return false;
+    return true;
+}
+
+int main()
+{
+    const size_t nrows = 500;
+    const size_t ncols = 3;
+    const size_t ncols_categ = 2;
+    const size_t ntrees = 50;
+    std::mt19937 rng(123);
+    std::normal_distribution<double> rnorm(0, 1);
+    std::uniform_real_distribution<double> runif(0, 1);
+
+    std::vector<int> ncat = {4, 3};
+    std::vector<double> X(nrows * ncols);
+    std::vector<int> C(nrows * ncols_categ);
+    for (double &x : X) x = (runif(rng) < 0.4)? 0. : rnorm(rng);
+    for (size_t col = 0; col < ncols_categ; col++)
+        for (size_t row = 0; row < nrows; row++)
+            C[row + col*nrows] = (int)(runif(rng) * ncat[col]);
+
+    /* new data, with missing values and categories that were not present when fitting */
+    std::vector<double> Xnew(X);
+    std::vector<int> Cnew(C);
+    for (double &x : Xnew) if (x) x *= 2.;
+    for (size_t row = 2; row < nrows; row += 7)
+        Xnew[row + nrows] = NAN;
+    for (size_t row = 0; row < nrows; row += 3)
+        Cnew[row] = ncat[0];
+    for (size_t row = 1; row < nrows; row += 5)
+        Cnew[row + nrows] = ncat[1] + 1;
+
+    std::vector<double> Xcsc_values;
+    std::vector<int> Xcsc_ind;
+    std::vector<int> Xcsc_indptr = {0};
+    for (size_t col = 0; col < ncols; col++)
+    {
+        for (size_t row = 0; row < nrows; row++)
+        {
+            if (Xnew[row + col*nrows])
+            {
+                Xcsc_values.push_back(Xnew[row + col*nrows]);
+                Xcsc_ind.push_back((int)row);
+            }
+        }
+        Xcsc_indptr.push_back((int)Xcsc_values.size());
+    }
+
+    const Config configs[] = {
+        {"single-variable, imputed, smallest", 1, Impute, Smallest},
+        {"single-variable, divided, smallest", 1, Divide, Smallest},
+        {"single-variable, imputed, weighted", 1, Impute, Weighted},
+        {"extended, imputed, weighted", 2, Impute, Weighted},
+    };
+
+    bool all_passed = true;
+    for (const Config &config : configs)
+    {
+        /* terminal nodes and per-tree depths are not available for single-variable models
+           that divide rows between branches */
+        const bool full_outputs = config.ndim > 1 || (config.missing_action != Divide && config.new_cat_action != Weighted);
+
+        IsolationForest iso;
+        iso.ndim = config.ndim;
+        iso.ntrees = ntrees;
+        iso.sample_size = 256;
+        iso.penalize_range = true;
+        iso.missing_action = config.missing_action;
+        iso.cat_split_type = SubSet;
+        iso.new_cat_action = config.new_cat_action;
+        iso.random_seed = 3;
+        iso.nthreads = 1;
+        iso.fit(X.data(), ncols, nrows, C.data(), ncols_categ, ncat.data(),
+                (double*)nullptr, (double*)nullptr);
+
+        auto get_outputs = [&](bool is_csc, int nthreads) -> Outputs
+        {
+            Outputs res;
+            res.depths.resize(nrows);
+            if (full_outputs)
+            {
+                res.tree_num.resize(nrows * ntrees);
+                res.per_tree_depths.resize(nrows * ntrees);
+            }
+            int *tree_num = full_outputs? res.tree_num.data() : nullptr;
+            double *per_tree_depths = full_outputs? res.per_tree_depths.data() : nullptr;
+            iso.nthreads = nthreads;
+            if (is_csc)
+                iso.predict(Xcsc_values.data(), Xcsc_ind.data(), Xcsc_indptr.data(), true,
+                            Cnew.data(), true, (size_t)0, nrows, false,
+                            res.depths.data(), tree_num, per_tree_depths);
+            else
+                iso.predict(Xnew.data(), Cnew.data(), true, nrows, (size_t)0, (size_t)0, false,
+                            res.depths.data(), tree_num, per_tree_depths);
+            return res;
+        };
+
+        Outputs dense = get_outputs(false, 1);
+        Outputs ref = get_outputs(true, 1);
+        bool same_as_dense = close_enough(dense.depths, ref.depths) &&
+                             dense.tree_num == ref.tree_num &&
+                             close_enough(dense.per_tree_depths, ref.per_tree_depths);
+        printf("%s, CSC, nthreads=1, against dense: %s\n", config.name, same_as_dense? "OK" : "MISMATCH");
+        all_passed = all_passed && same_as_dense;
+        for (int nthreads : {2, 3, 4})
+        {
+            Outputs res = get_outputs(true, nthreads);
+            bool passed = res.depths == ref.depths &&
+                          res.tree_num == ref.tree_num &&
+                          res.per_tree_depths == ref.per_tree_depths;
+            printf("%s, CSC, nthreads=%d, against nthreads=1: %s\n", config.name, nthreads, passed? "OK" : "MISMATCH");
+            all_passed = all_passed && passed;
+        }
+    }
+
+    return all_passed? 0 : 1;
+}
@@ -0,0 +1,279 @@
+#include <vector>
+#include <string>
+#include <random>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <algorithm>
+#include "isotree_oop.hpp"
+
+/*  Checks that every prediction engine gives the same results as 'predict_iforest' on the same
+    model and data. The engines covered are the compiled forests (single-variable with 'double' and
+    'float' thresholds, and extended, in both its row-by-row and its node-by-node mode for large
+    batches), the decision engine, the single-row prediction context, the read-only view over a
+    serialized model, the flat format (in double and single precision), the bitvector forest, and
+    the binned model.
+
+    The reference outputs come from 'predict_iforest' on batches of 8 rows, which are too small for
+    it to switch to a compiled forest, so they are produced by traversing the original trees. The
+    results compared are the average depths, terminal node numbers, and per-tree depths, which must
+    match exactly, except for the flat format in single precision, which stores the depths as 'float'
+    and is thus compared up to roundoff. The data consists of values that are exactly representable
+    as 'float', so that the engines that store thresholds as 'float' go through the same branches.
+
+    To compile, first build the library through the cmake system, then, from the root folder:
+      g++ -o engineparitycheck timings/engine_parity_check.cpp -std=c++11 -O3 -I./include -l:libisotree.so -L./build -Wl,-rpath,./build
+    Then run with './engineparitycheck'
+    It can also be built along with the library by configuring cmake with '-DBUILD_TIMINGS_CHECKS=ON',
+    in which case it runs through 'ctest'.
+*/
+
+using namespace isotree;
+
+struct Outputs {
+    std::vector<double> depths;
+    std::vector<int> tree_num;
+    std::vector<double> per_tree_depths;
+
+    Outputs(size_t nrows, size_t ntrees) : depths(nrows), tree_num(nrows * ntrees), per_tree_depths(nrows * ntrees) {}
+};
+
+static bool close_enough(const std::vector<double> &a, const std::vector<double> &b)
+{
+    if (a.size() != b.size()) return false;
+    for (size_t ix = 0; ix < a.size(); ix++)
+        if (std::fabs(a[ix] - b[ix]) > 1e-5 * std::fmax(1., std::fabs(a[ix]))) return false;
+    return true;
+}
+
+static bool report(const char *model_name, const char *engine, const Outputs &ref, const Outputs &res,
+                   bool compare_tree_num, bool exact)
+{
+    bool passed = (exact? (res.depths == ref.depths && res.per_tree_depths == ref.per_tree_depths)
+                        : (close_enough(res.depths, ref.depths) && close_enough(res.per_tree_depths, ref.per_tree_depths)))
+                  && (!compare_tree_num || res.tree_num == ref.tree_num);
+    printf("%s, %s: %s\n", model_name, engine, passed? "OK" : "MISMATCH");
+    return passed;
+}
+
+int main()
+{
+    const size_t nrows = 600;
+    const size_t ncols = 5;
+    const size_t ntrees = 50;
+    const size_t ref_batch = 8;
+    const size_t small_batch = 100;
+    const int nthreads = 2;
+    std::mt19937 rng(123);
+    std::normal_distribution<double> rnorm(0, 1);
+
+    /* column-major for fitting, and a row-major copy for the engines that take rows */
+    std::vector<double> X(nrows * ncols);
+    std::vector<double> Xrow(nrows * ncols);
+    for (double &x : X) x = (double)(float)rnorm(rng);
+    for (size_t row = 0; row < nrows; row++)
+        for (size_t col = 0; col < ncols; col++)
+            Xrow[col + row*ncols] = X[row + col*nrows];
+
+    bool all_passed = true;
+    for (size_t ndim : {(size_t)1, (size_t)3})
+    {
+        const char *model_name = (ndim == 1)? "single-variable" : "extended";
+        IsolationForest iso;
+        iso.ndim = ndim;
+        iso.ntrees = ntrees;
+        iso.sample_size = 256;
+        iso.missing_action = Fail;
+        iso.random_seed = 1;
+        iso.nthreads = 1;
+        iso.fit(X.data(), nrows, ncols);
+        IsoForest *model = (ndim == 1)? &iso.model : nullptr;
+        ExtIsoForest *model_ext = (ndim == 1)? nullptr : &iso.model_ext;
+
+        /* reference, from 'predict_iforest' traversing the trees */
+        Outputs ref(nrows, ntrees);
+        std::vector<double> ref_scores(nrows);
+        for (size_t st = 0; st < nrows; st += ref_batch)
+        {
+            size_t n = std::min(ref_batch, nrows - st);
+            std::vector<int> tree_num(n * ntrees);
+            predict_iforest(Xrow.data() + st*ncols, (int*)nullptr,
+                            false, ncols, (size_t)0,
+                            (double*)nullptr, (int*)nullptr, (int*)nullptr,
+                            (double*)nullptr, (int*)nullptr, (int*)nullptr,
+                            n, 1, false,
+                            model, model_ext,
+                            ref.depths.data() + st, tree_num.data(),
+                            ref.per_tree_depths.data() + st*ntrees,
+                            (TreesIndexer*)nullptr);
+            predict_iforest(Xrow.data() + st*ncols, (int*)nullptr,
+                            false, ncols, (size_t)0,
+                            (double*)nullptr, (int*)nullptr, (int*)nullptr,
+                            (double*)nullptr, (int*)nullptr, (int*)nullptr,
+                            n, 1, true,
+                            model, model_ext,
+                            ref_scores.data() + st, (int*)nullptr, (double*)nullptr,
+                            (TreesIndexer*)nullptr);
+            for (size_t tree = 0; tree < ntrees; tree++)
+                for (size_t row = 0; row < n; row++)
+                    ref.tree_num[st + row + tree*nrows] = tree_num[row + tree*n];
+        }
+
+        /* 'predict_iforest' on the whole batch, which goes through a compiled forest */
+        {
+            Outputs res(nrows, ntrees);
+            predict_iforest(X.data(), (int*)nullptr,
+                            true, (size_t)0, (size_t)0,
+                            (double*)nullptr, (int*)nullptr, (int*)nullptr,
+                            (double*)nullptr, (int*)nullptr, (int*)nullptr,
+                            nrows, nthreads, false,
+                            model, model_ext,
+                            res.depths.data(), res.tree_num.data(), res.per_tree_depths.data(),
+                            (TreesIndexer*)nullptr);
+            all_passed = report(model_name, "predict_iforest, whole batch", ref, res, true, true) && all_passed;
+        }
+
+        /* single-row prediction context */
+        {
+            PredictionContext context;
+            build_prediction_context(context, model, model_ext, false);
+            std::vector<double> depths(nrows);
+            for (size_t row = 0; row < nrows; row++)
+                depths[row] = predict_iforest_row(context, Xrow.data() + row*ncols, (int*)nullptr);
+            bool passed = depths == ref.depths;
+            printf("%s, prediction context: %s\n", model_name, passed? "OK" : "MISMATCH");
+            all_passed = all_passed && passed;
+        }
+
+        /* flat format */
+        for (bool single_precision : {false, true})
+        {
+            size_t n_bytes = determine_flat_model_size(model, model_ext, single_precision);
+            std::vector<double> buffer(n_bytes / sizeof(double) + 1); /* <- aligned to 8 bytes */
+            serialize_flat_model(model, model_ext, single_precision, (char*)buffer.data());
+            FlatModel flat_model;
+            load_flat_model(flat_model, (const char*)buffer.data(), n_bytes);
+            Outputs res(nrows, ntrees);
+            predict_flat_model(Xrow.data(), false, ncols, nrows, nthreads, false, flat_model,
+                               res.depths.data(), res.tree_num.data(), res.per_tree_depths.data());
+            all_passed = report(model_name, single_precision? "flat model, single precision" : "flat model, double precision",
+                                ref, res, true, !single_precision) && all_passed;
+        }
+
+        if (ndim == 1)
+        {
+            /* compiled forest, with both types of thresholds and both data layouts */
+            for (bool float_thresholds : {false, true})
+            {
+                CompiledIsoForest compiled;
+                build_compiled_forest(compiled, iso.model, float_thresholds, nthreads);
+                for (bool is_col_major : {true, false})
+                {
+                    Outputs res(nrows, ntrees);
+                    predict_iforest_compiled(is_col_major? X.data() : Xrow.data(), is_col_major, ncols,
+                                             nrows, nthreads, false, compiled,
+                                             res.depths.data(), res.tree_num.data(), res.per_tree_depths.data());
+                    std::string engine = std::string("compiled forest, ")
+                                         + (float_thresholds? "float" : "double") + " thresholds, "
+                                         + (is_col_major? "column-major" : "row-major");
+                    all_passed = report(model_name, engine.c_str(), ref, res, true, true) && all_passed;
+                }
+
+                /* decision engine, evaluating all the trees */
+                std::vector<int> decisions(nrows);
+                std::vector<size_t> trees_used(nrows);
+                const double threshold = 0.5;
+                predict_iforest_decision(Xrow.data(), false, ncols, nrows, nthreads, compiled,
+                                         threshold, 1., decisions.data(), trees_used.data());
+                bool passed = true;
+                for (size_t row = 0; row < nrows; row++)
+                    passed = passed && decisions[row] == (int)(ref_scores[row] > threshold) && trees_used[row] == ntrees;
+                printf("%s, decisions, %s thresholds: %s\n", model_name, float_thresholds? "float" : "double",
+                       passed? "OK" : "MISMATCH");
+                all_passed = all_passed && passed;
+            }
+
+            /* view over the serialized model */
+            {
+                std::string serialized = serialize_IsoForest(iso.model);
+                IsoForestView view;
+                build_IsoForestView(view, serialized.data());
+                Outputs res(nrows, ntrees);
+                predict_iforest_view(Xrow.data(), (int*)nullptr,
+                                     false, ncols, (size_t)0,
+                                     (double*)nullptr, (int*)nullptr, (int*)nullptr,
+                                     (double*)nullptr, (int*)nullptr, (int*)nullptr,
+                                     nrows, nthreads, false, view,
+                                     res.depths.data(), res.per_tree_depths.data());
+                all_passed = report(model_name, "view", ref, res, false, true) && all_passed;
+            }
+
+            /* bitvector forest */
+            {
+                BitvectorIsoForest bv_forest;
+                build_bitvector_forest(bv_forest, iso.model);
+                Outputs res(nrows, ntrees);
+                predict_iforest_bitvector(Xrow.data(), false, ncols, nrows, nthreads, false, bv_forest,
+                                          res.depths.data(), res.tree_num.data(), res.per_tree_depths.data());
+                all_passed = report(model_name, "bitvector forest", ref, res, true, true) && all_passed;
+            }
+
+            /* binned model */
+            {
+                BinPlan plan;
+                build_bin_plan(plan, iso.model, nthreads);
+                Outputs res(nrows, ntrees);
+                if (plan.wide_bins)
+                {
+                    std::vector<uint16_t> binned(nrows * ncols);
+                    bin_numeric_data(Xrow.data(), false, ncols, nrows, nthreads, plan, binned.data());
+                    predict_iforest_binned(binned.data(), nrows, nthreads, false, plan,
+                                           res.depths.data(), res.tree_num.data(), res.per_tree_depths.data());
+                }
+                else
+                {
+                    std::vector<uint8_t> binned(nrows * ncols);
+                    bin_numeric_data(Xrow.data(), false, ncols, nrows, nthreads, plan, binned.data());
+                    predict_iforest_binned(binned.data(), nrows, nthreads, false, plan,
+                                           res.depths.data(), res.tree_num.data(), res.per_tree_depths.data());
+                }
+                all_passed = report(model_name, "binned model", ref, res, true, true) && all_passed;
+            }
+        }
+
+        else
+        {
+            /* compiled forest, on batches small enough to be evaluated row by row, and on the
+               whole batch at once, which is evaluated node by node */
+            CompiledExtIsoForest compiled;
+            build_compiled_forest(compiled, iso.model_ext, nthreads);
+            for (bool is_col_major : {true, false})
+            {
+                Outputs res(nrows, ntrees);
+                predict_iforest_compiled(is_col_major? X.data() : Xrow.data(), is_col_major, ncols,
+                                         nrows, nthreads, false, compiled,
+                                         res.depths.data(), res.tree_num.data(), res.per_tree_depths.data());
+                std::string engine = std::string("compiled forest, node by node, ")
+                                     + (is_col_major? "column-major" : "row-major");
+                all_passed = report(model_name, engine.c_str(), ref, res, true, true) && all_passed;
+            }
+
+            Outputs res(nrows, ntrees);
+            for (size_t st = 0; st < nrows; st += small_batch)
+            {
+                size_t n = std::min(small_batch, nrows - st);
+                std::vector<int> tree_num(n * ntrees);
+                predict_iforest_compiled(Xrow.data() + st*ncols, false, ncols,
+                                         n, nthreads, false, compiled,
+                                         res.depths.data() + st, tree_num.data(),
+                                         res.per_tree_depths.data() + st*ntrees);
+                for (size_t tree = 0; tree < ntrees; tree++)
+                    for (size_t row = 0; row < n; row++)
+                        res.tree_num[st + row + tree*nrows] = tree_num[row + tree*n];
+            }
+            all_passed = report(model_name, "compiled forest, row by row", ref, res, true, true) && all_passed;
+        }
+    }
+
+    return all_passed? 0 : 1;
+}
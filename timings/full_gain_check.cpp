@@ -0,0 +1,78 @@
+#include <vector>
+#include <random>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include "isotree_oop.hpp"
+
+/*  Checks that the full-gain criterion ('prob_pick_by_full_gain') evaluates splits on the
+    right values. This criterion reads the data from a row-major copy of it, and if that copy
+    does not hold the same values as the original data, it ends up picking split points
+    that make no sense for the column being split.
+
+    The data here has two clusters far apart in the first column (-10 and +10) and pure
+    noise in the other columns, so every tree whose root node splits by the first column
+    should put the split point in the gap between the clusters. This is checked for data
+    passed in column-major order and in row-major order (the latter with sub-sampling,
+    which makes a copy of the sampled rows for each tree).
+
+    To compile, first build the library through the cmake system, then, from the root folder:
+      g++ -o fullgaincheck timings/full_gain_check.cpp -std=c++11 -O3 -I./include -l:libisotree.so -L./build -Wl,-rpath,./build
+    Then run with './fullgaincheck'
+    It can also be built along with the library by configuring cmake with '-DBUILD_TIMINGS_CHECKS=ON',
+    in which case it runs through 'ctest'.
+*/
+
+using namespace isotree;
+
+int main()
+{
+    const size_t nrows = 1000;
+    const size_t ncols = 4;
+    std::mt19937 rng(123);
+    std::normal_distribution<double> rnorm(0, 1);
+    std::vector<double> X_col_major(nrows * ncols);
+    std::vector<double> X_row_major(nrows * ncols);
+    for (size_t row = 0; row < nrows; row++)
+    {
+        for (size_t col = 0; col < ncols; col++)
+        {
+            double x = rnorm(rng) + ((col == 0)? ((row % 2)? 10. : -10.) : 0.);
+            X_col_major[row + col*nrows] = x;
+            X_row_major[col + row*ncols] = x;
+        }
+    }
+
+    bool all_passed = true;
+    printf("| Input | Trees splitting by first column | In the gap |\n");
+    printf("| :---: | :---:                           | :---:      |\n");
+    for (bool is_col_major : {true, false})
+    {
+        IsolationForest iso;
+        iso.ntrees = 50;
+        iso.sample_size = 256;
+        iso.ntry = ncols;
+        iso.prob_pick_by_full_gain = 1;
+        iso.missing_action = Fail;
+        iso.nthreads = 1;
+        iso.fit(is_col_major? X_col_major.data() : X_row_major.data(), ncols, nrows,
+                (int*)nullptr, 0, (int*)nullptr,
+                is_col_major, (size_t)0, (size_t)0,
+                (double*)nullptr, (double*)nullptr);
+
+        int n_first = 0;
+        int n_in_gap = 0;
+        for (const auto &tree : iso.get_model().trees)
+        {
+            if (tree.front().tree_left == 0 || tree.front().col_num != 0) continue;
+            n_first++;
+            n_in_gap += std::fabs(tree.front().num_split) < 6.;
+        }
+        bool passed = n_first > 0 && n_in_gap == n_first;
+        printf("| %s | %d | %d |%s\n", is_col_major? "column-major" : "row-major",
+               n_first, n_in_gap, passed? "" : " <- wrong split points");
+        all_passed = all_passed && passed;
+    }
+    printf("%s\n", all_passed? "Full-gain splits are placed correctly." : "Full-gain splits are misplaced.");
+    return all_passed? 0 : 1;
+}
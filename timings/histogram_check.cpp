@@ -0,0 +1,211 @@
+#include <vector>
+#include <random>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include "headers_joined.hpp"
+#include "oop_interface.hpp"
+
+/*  Checks the guided splits found through histograms ('split_search=HistogramSearch').
+
+    First, the histogram that a node obtains by building that of its sibling and subtracting it
+    from its parent's ('subtract_histogram') is compared against the histogram built directly
+    from the rows of the node, with and without weights. The counts must match exactly, the
+    weighted sums up to roundoff, and the minimum and maximum of each bin in the subtracted
+    histogram must be bounds for the ones in the direct histogram. Both histograms must then
+    give the same gain up to roundoff, and split points that divide the rows of the node in
+    the same way.
+
+    Then, models are fit with 'HistogramSearch' and with 'SortedSearch' to data in which every
+    column has fewer distinct values than there are bins. In that case, each distinct value gets
+    a bin of its own, so the thresholds between bins are the same that the sorted search considers,
+    and both should find the same splits. The trees are compared node by node, along with the
+    terminal nodes in which each row falls. The density criterion is checked with a single column
+    per split ('ntry=1'), as the gain that the sorted search reports for it is not on the same scale
+    as the one from the histograms, which only matters when comparing gains across columns.
+
+    This includes the library's internal headers (and the internal copy of the OOP interface,
+    which uses the same types), so it needs the 'src' folder too.
+    To compile, first build the library through the cmake system, then, from the root folder:
+      g++ -o histcheck timings/histogram_check.cpp -std=c++11 -O3 -I./src -I./include -l:libisotree.so -L./build -Wl,-rpath,./build
+    Then run with './histcheck'
+    It can also be built along with the library by configuring cmake with '-DBUILD_TIMINGS_CHECKS=ON',
+    in which case it runs through 'ctest', with the 'src' folder added to its include directories.
+*/
+
+typedef long double ldouble_safe;
+
+static bool close_to(double a, double b, double scale)
+{
+    return std::fabs(a - b) <= 1e-8 * std::fmax(1., scale);
+}
+
+static bool check_subtraction(bool weighted)
+{
+    const size_t nrows = 5000;
+    const size_t n_sibling = 1800;
+    const int nbins = 100;
+    std::mt19937 rng(123);
+    std::normal_distribution<double> rnorm(0, 1);
+    std::uniform_real_distribution<double> runif(0, 1);
+
+    /* bins of equal width between -3 and 3, with the values outside going to the first and last */
+    std::vector<double> x(nrows);
+    std::vector<uint8_t> x_binned(nrows);
+    std::vector<double> bin_ref(HIST_MAX_BINS);
+    std::vector<double> weights(nrows);
+    for (int bin = 0; bin < nbins; bin++)
+        bin_ref[bin] = -3. + 6. * (double)bin / (double)nbins;
+    for (size_t row = 0; row < nrows; row++)
+    {
+        x[row] = rnorm(rng);
+        int bin = (int)std::floor((x[row] + 3.) * (double)nbins / 6.);
+        x_binned[row] = (uint8_t)std::max(0, std::min(nbins - 1, bin));
+        weights[row] = 0.5 + runif(rng);
+    }
+
+    /* the parent has all the rows in a random order, the sibling the first ones, and the node the rest */
+    std::vector<size_t> ix_arr(nrows);
+    std::iota(ix_arr.begin(), ix_arr.end(), (size_t)0);
+    std::shuffle(ix_arr.begin(), ix_arr.end(), rng);
+    std::vector<HistBin> parent(HIST_MAX_BINS + 1), subtracted(HIST_MAX_BINS + 1), direct(HIST_MAX_BINS + 1);
+    if (!weighted)
+    {
+        build_histogram(ix_arr.data(), 0, nrows - 1, x.data(), x_binned.data(), bin_ref.data(), parent.data());
+        build_histogram(ix_arr.data(), 0, n_sibling - 1, x.data(), x_binned.data(), bin_ref.data(), subtracted.data());
+        build_histogram(ix_arr.data(), n_sibling, nrows - 1, x.data(), x_binned.data(), bin_ref.data(), direct.data());
+    }
+    else
+    {
+        build_histogram_weighted(ix_arr.data(), 0, nrows - 1, x.data(), x_binned.data(), bin_ref.data(), parent.data(), weights);
+        build_histogram_weighted(ix_arr.data(), 0, n_sibling - 1, x.data(), x_binned.data(), bin_ref.data(), subtracted.data(), weights);
+        build_histogram_weighted(ix_arr.data(), n_sibling, nrows - 1, x.data(), x_binned.data(), bin_ref.data(), direct.data(), weights);
+    }
+    subtract_histogram(parent.data(), subtracted.data());
+
+    bool same_bins = true;
+    for (int bin = 0; bin <= HIST_MAX_BINS; bin++)
+    {
+        const HistBin &s = subtracted[bin];
+        const HistBin &d = direct[bin];
+        same_bins = same_bins && s.cnt == d.cnt;
+        if (!d.cnt) continue;
+        same_bins = same_bins && close_to(s.w, d.w, parent[bin].w);
+        same_bins = same_bins && close_to(s.sum, d.sum, parent[bin].ssq);
+        same_bins = same_bins && close_to(s.ssq, d.ssq, parent[bin].ssq);
+        same_bins = same_bins && s.xmin <= d.xmin && s.xmax >= d.xmax;
+    }
+
+    bool same_splits = true;
+    std::vector<double> sd_arr(HIST_MAX_BINS + 1);
+    size_t n = nrows - n_sibling;
+    for (GainCriterion criterion : {Averaged, Pooled})
+    {
+        for (bool as_relative_gain : {false, true})
+        {
+            double split_sub, split_dir, xmin, xmax;
+            double gain_sub = find_split_hist<ldouble_safe>(subtracted.data(), bin_ref.data(), nbins, n, sd_arr.data(),
+                                                            criterion, 0., as_relative_gain, split_sub, xmin, xmax);
+            double gain_dir = find_split_hist<ldouble_safe>(direct.data(), bin_ref.data(), nbins, n, sd_arr.data(),
+                                                            criterion, 0., as_relative_gain, split_dir, xmin, xmax);
+            size_t n_left_sub = 0, n_left_dir = 0;
+            for (size_t row = n_sibling; row < nrows; row++)
+            {
+                n_left_sub += x[ix_arr[row]] <= split_sub;
+                n_left_dir += x[ix_arr[row]] <= split_dir;
+            }
+            same_splits = same_splits && close_to(gain_sub, gain_dir, std::fabs(gain_dir)) && n_left_sub == n_left_dir;
+        }
+    }
+
+    bool passed = same_bins && same_splits;
+    printf("| Subtraction | %s | %s | %s |%s\n", weighted? "weighted" : "unweighted",
+           same_bins? "yes" : "no", same_splits? "yes" : "no", passed? "" : " <- mismatch");
+    return passed;
+}
+
+static bool same_trees(const IsoForest &model1, const IsoForest &model2)
+{
+    if (model1.trees.size() != model2.trees.size()) return false;
+    for (size_t tree = 0; tree < model1.trees.size(); tree++)
+    {
+        const auto &nodes1 = model1.trees[tree];
+        const auto &nodes2 = model2.trees[tree];
+        if (nodes1.size() != nodes2.size()) return false;
+        for (size_t node = 0; node < nodes1.size(); node++)
+        {
+            if (nodes1[node].tree_left != nodes2[node].tree_left) return false;
+            if (nodes1[node].tree_left == 0) continue;
+            if (nodes1[node].col_num != nodes2[node].col_num) return false;
+            if (nodes1[node].num_split != nodes2[node].num_split) return false;
+        }
+    }
+    return true;
+}
+
+static bool check_search(const char *name, double prob_pick_by_gain_avg, double prob_pick_by_gain_pl,
+                         double prob_pick_by_dens, size_t ntry, bool weighted)
+{
+    const size_t nrows = 20000;
+    const size_t ncols = 4;
+    const size_t ntrees = 10;
+    std::mt19937 rng(456);
+    std::normal_distribution<double> rnorm(0, 1);
+    std::uniform_real_distribution<double> runif(0, 1);
+
+    /* numbers rounded to a few distinct values per column (fewer than 'HIST_MAX_BINS') */
+    std::vector<double> X(nrows * ncols);
+    for (size_t col = 0; col < ncols; col++)
+        for (size_t row = 0; row < nrows; row++)
+            X[row + col*nrows] = std::round(rnorm(rng) * (double)(5 * (col + 1))) / 10.;
+    std::vector<double> weights(nrows);
+    for (double &w : weights) w = 0.5 + runif(rng);
+
+    isotree::IsolationForest iso[2];
+    std::vector<int> terminal_nodes[2];
+    for (int model = 0; model < 2; model++)
+    {
+        iso[model].ntrees = ntrees;
+        iso[model].sample_size = 8192;
+        iso[model].ntry = ntry;
+        iso[model].prob_pick_by_gain_avg = prob_pick_by_gain_avg;
+        iso[model].prob_pick_by_gain_pl = prob_pick_by_gain_pl;
+        iso[model].prob_pick_by_dens = prob_pick_by_dens;
+        iso[model].missing_action = Fail;
+        iso[model].weight_as_sample = false;
+        iso[model].split_search = model? HistogramSearch : SortedSearch;
+        iso[model].nthreads = 1;
+        iso[model].fit(X.data(), ncols, nrows,
+                       (int*)nullptr, 0, (int*)nullptr,
+                       weighted? weights.data() : (double*)nullptr, (double*)nullptr);
+
+        std::vector<double> depths(nrows);
+        terminal_nodes[model].resize(nrows * ntrees);
+        iso[model].predict(X.data(), (int*)nullptr, true, nrows, (size_t)0, (size_t)0, false,
+                           depths.data(), terminal_nodes[model].data(), (double*)nullptr);
+    }
+
+    bool same_nodes = same_trees(iso[0].get_model(), iso[1].get_model());
+    bool same_terminal = terminal_nodes[0] == terminal_nodes[1];
+    bool passed = same_nodes && same_terminal;
+    printf("| Search | %s%s | %s | %s |%s\n", name, weighted? ", weighted" : "",
+           same_nodes? "yes" : "no", same_terminal? "yes" : "no", passed? "" : " <- different splits");
+    return passed;
+}
+
+int main()
+{
+    bool all_passed = true;
+    printf("| Check | Case | Same bins / trees | Same splits / terminal nodes |\n");
+    printf("| :---: | :---: | :---:            | :---:                        |\n");
+    for (bool weighted : {false, true})
+        all_passed = check_subtraction(weighted) && all_passed;
+    for (bool weighted : {false, true})
+    {
+        all_passed = check_search("gain_avg", 1, 0, 0, 4, weighted) && all_passed;
+        all_passed = check_search("gain_pl", 0, 1, 0, 4, weighted) && all_passed;
+        all_passed = check_search("dens", 0, 0, 1, 1, weighted) && all_passed;
+    }
+    printf("%s\n", all_passed? "Histogram splits match." : "Histogram splits do not match.");
+    return all_passed? 0 : 1;
+}
@@ -0,0 +1,96 @@
+#include <vector>
+#include <random>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include "isotree_oop.hpp"
+
+/*  Checks that the separation depths calculated with the help of a tree indexer
+    ('build_indexer' with 'with_distances=true') are the same as the ones calculated
+    by traversing the trees, for both the pairwise distances between all rows ('tmat')
+    and the distances between two groups of rows ('rmat'), without standardization
+    (the standardized distances use a different expected depth in each case).
+
+    With 'assume_full_distr=false', terminal nodes with more than one row add the
+    expected separation of the rows that fall there plus the node's 'remainder',
+    which is stored in the tree node, while the indexer refers to terminal nodes
+    by their number among the terminal nodes of the tree. Looking up the tree node
+    by that number gives the wrong remainder.
+
+    To compile, first build the library through the cmake system, then, from the root folder:
+      g++ -o distcheck timings/indexed_distance_check.cpp -std=c++11 -O3 -I./include -l:libisotree.so -L./build -Wl,-rpath,./build
+    Then run with './distcheck'
+    It can also be built along with the library by configuring cmake with '-DBUILD_TIMINGS_CHECKS=ON',
+    in which case it runs through 'ctest'.
+*/
+
+using namespace isotree;
+
+int main()
+{
+    const size_t nrows_fit = 2000;
+    const size_t ncols = 4;
+    const size_t nrows = 300;
+    const size_t n_from = 100;
+    std::mt19937 rng(123);
+    std::normal_distribution<double> rnorm(0, 1);
+    std::vector<double> X(nrows_fit * ncols);
+    for (double &x : X) x = rnorm(rng);
+    std::vector<double> X_pred(nrows * ncols);
+    for (size_t col = 0; col < ncols; col++)
+        for (size_t row = 0; row < nrows; row++)
+            X_pred[row + col*nrows] = X[row + col*nrows_fit];
+
+    bool all_passed = true;
+    printf("| ndim | Sample size | assume_full_distr | Output | Max. abs. difference |\n");
+    printf("| :---: | :---:      | :---:             | :---:  | :---:                |\n");
+    for (size_t ndim : {(size_t)1, (size_t)2})
+    {
+        for (size_t sample_size : {(size_t)256, nrows_fit})
+        {
+            IsolationForest iso;
+            iso.ndim = ndim;
+            iso.ntrees = 20;
+            iso.sample_size = sample_size;
+            iso.nthreads = 1;
+            iso.new_cat_action = Smallest;
+            iso.fit(X.data(), nrows_fit, ncols);
+            iso.build_indexer(true);
+            IsoForest *model = (ndim == 1)? &iso.get_model() : nullptr;
+            ExtIsoForest *model_ext = (ndim == 1)? nullptr : &iso.get_model_ext();
+
+            for (bool assume_full_distr : {false, true})
+            {
+                for (bool two_groups : {false, true})
+                {
+                    size_t n_out = two_groups? (n_from * (nrows - n_from)) : (nrows * (nrows - 1) / 2);
+                    std::vector<double> expected(n_out), indexed(n_out);
+                    for (int use_indexer = 0; use_indexer <= 1; use_indexer++)
+                    {
+                        double *out = use_indexer? indexed.data() : expected.data();
+                        calc_similarity(X_pred.data(), (int*)nullptr,
+                                        (double*)nullptr, (int*)nullptr, (int*)nullptr,
+                                        nrows, false, 1,
+                                        assume_full_distr, false, false,
+                                        model, model_ext,
+                                        two_groups? nullptr : out, two_groups? out : nullptr,
+                                        two_groups? n_from : (size_t)0, false,
+                                        use_indexer? &iso.get_indexer() : nullptr,
+                                        true, (size_t)0, (size_t)0);
+                    }
+
+                    double max_diff = 0;
+                    for (size_t ix = 0; ix < n_out; ix++)
+                        max_diff = std::fmax(max_diff, std::fabs(expected[ix] - indexed[ix]));
+                    bool passed = max_diff <= 1e-8;
+                    printf("| %d | %d | %s | %s | %.3g |%s\n",
+                           (int)ndim, (int)sample_size, assume_full_distr? "true" : "false",
+                           two_groups? "rmat" : "tmat", max_diff, passed? "" : " <- mismatch");
+                    all_passed = all_passed && passed;
+                }
+            }
+        }
+    }
+    printf("%s\n", all_passed? "Indexed distances match." : "Indexed distances do not match.");
+    return all_passed? 0 : 1;
+}
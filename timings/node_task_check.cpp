@@ -0,0 +1,131 @@
+#include <vector>
+#include <random>
+#include <string>
+#include <cmath>
+#include <cstdio>
+#include "isotree.hpp"
+
+/*  Checks that fitting a model with 'node_task_rows' (which grows the branches of large nodes as
+    separate tasks) gives the same model as fitting it without, as both draw the random numbers of
+    the branches of large nodes from their own seeds. The trees take all of the 20000 rows, so their
+    first levels have nodes with more than 8192 rows.
+
+    The results compared are the serialized models and imputers, which must be exactly the same,
+    along with the depths calculated at fit time, which are summed over the threads in an order that
+    depends on which tasks each one took, and are thus compared up to roundoff. The configurations
+    cover the single-variable model with categorical columns, the histogram and presorted split
+    searches, missing values with an imputer, and the extended model.
+
+    To compile, first build the library through the cmake system, then, from the root folder:
+      g++ -o nodetaskcheck timings/node_task_check.cpp -std=c++11 -O3 -I./include -l:libisotree.so -L./build -Wl,-rpath,./build
+    Then run with './nodetaskcheck'
+    It can also be built along with the library by configuring cmake with '-DBUILD_TIMINGS_CHECKS=ON',
+    in which case it runs through 'ctest'.
+*/
+
+struct Config {
+    const char *name;
+    size_t ndim;
+    bool categ;
+    bool with_missing;
+    double prob_pick_by_gain_avg;
+    SplitSearch split_search;
+};
+
+struct FitResult {
+    std::string model;
+    std::string imputer;
+    std::vector<double> depths;
+};
+
+static FitResult fit_model(const Config &config, std::vector<double> &X, std::vector<int> &C, std::vector<int> &ncat,
+                           size_t nrows, size_t ncols, size_t ncols_categ, size_t node_task_rows, int nthreads)
+{
+    const size_t sample_size = nrows;
+    const size_t ntrees = 20;
+    std::vector<double> X_use(X);
+    if (!config.with_missing)
+        for (double &x : X_use) if (std::isnan(x)) x = 0.;
+
+    IsoForest model;
+    ExtIsoForest model_ext;
+    Imputer imputer;
+    FitResult res;
+    res.depths.resize(nrows);
+    fit_iforest(config.ndim == 1? &model : NULL, config.ndim == 1? NULL : &model_ext,
+                X_use.data(), ncols,
+                config.categ? C.data() : NULL, config.categ? ncols_categ : 0, config.categ? ncat.data() : NULL,
+                true, (size_t)0, (size_t)0,
+                (double*)NULL, (int*)NULL, (int*)NULL,
+                config.ndim, 3, Normal, false,
+                (double*)NULL, false, false,
+                nrows, sample_size, ntrees,
+                0, 0,
+                true, false, true,
+                Depth, false,
+                false, (double*)NULL,
+                res.depths.data(), true,
+                (double*)NULL, false,
+                0., config.prob_pick_by_gain_avg,
+                0., 0.,
+                0., 0.,
+                0.,
+                0., config.split_search, Impute,
+                SubSet, Weighted,
+                false, config.with_missing? &imputer : NULL, 3,
+                Higher, Inverse, false,
+                (uint64_t)3, false, node_task_rows,
+                false, nthreads);
+
+    res.model = (config.ndim == 1)? serialize_IsoForest(model) : serialize_ExtIsoForest(model_ext);
+    if (config.with_missing)
+        res.imputer = serialize_Imputer(imputer);
+    return res;
+}
+
+static bool same_depths(const std::vector<double> &a, const std::vector<double> &b)
+{
+    if (a.size() != b.size()) return false;
+    for (size_t ix = 0; ix < a.size(); ix++)
+        if (std::fabs(a[ix] - b[ix]) > 1e-12 * std::fmax(1., std::fabs(a[ix]))) return false;
+    return true;
+}
+
+int main()
+{
+    const size_t nrows = 20000;
+    const size_t ncols = 4;
+    const size_t ncols_categ = 1;
+    std::mt19937 rng(123);
+    std::normal_distribution<double> rnorm(0, 1);
+    std::uniform_real_distribution<double> runif(0, 1);
+
+    std::vector<double> X(nrows * ncols);
+    std::vector<int> C(nrows * ncols_categ);
+    std::vector<int> ncat = {5};
+    for (double &x : X) x = (runif(rng) < 0.02)? NAN : rnorm(rng);
+    for (int &c : C) c = (int)(runif(rng) * ncat[0]);
+
+    const Config configs[] = {
+        {"single-variable, categorical columns", 1, true, false, 0.25, SortedSearch},
+        {"single-variable, histograms", 1, false, false, 1., HistogramSearch},
+        {"single-variable, presorted", 1, false, false, 1., PresortedSearch},
+        {"single-variable, missing values", 1, true, true, 0., SortedSearch},
+        {"extended, missing values", 2, false, true, 0., SortedSearch},
+    };
+
+    bool all_ok = true;
+    for (const Config &config : configs)
+    {
+        FitResult ref = fit_model(config, X, C, ncat, nrows, ncols, ncols_categ, 0, 1);
+        for (int nthreads : {1, 3})
+        {
+            FitResult res = fit_model(config, X, C, ncat, nrows, ncols, ncols_categ, 8192, nthreads);
+            bool ok = ref.model == res.model && ref.imputer == res.imputer && same_depths(ref.depths, res.depths);
+            printf("%s, node_task_rows=8192, nthreads=%d: %s\n", config.name, nthreads, ok? "OK" : "MISMATCH");
+            all_ok = all_ok && ok;
+        }
+    }
+
+    return all_ok? EXIT_SUCCESS : EXIT_FAILURE;
+}
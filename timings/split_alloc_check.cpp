@@ -0,0 +1,232 @@
+#include <vector>
+#include <random>
+#include <new>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include "isotree.hpp"
+
+/*  Checks that fitting a tree does not allocate memory at each node for the split search. The
+    global 'operator new' is replaced with one that tags each allocation with the tree during
+    which it was made, and the model is fit through an executor that runs the trees one after
+    another in a single thread, so that it can count the allocations made while fitting each
+    of them. Allocations that are still alive when the tree is finished are the nodes of the
+    model, while the ones that get freed before that are scratch space.
+
+    The first tree sets up the buffers of the thread ('SplitScratch' and the rest of the worker
+    memory), so it is taken as a warm-up. The ones after it should make a single scratch
+    allocation regardless of how many nodes they have: the vector of nodes is reserved with room
+    for the largest tree that the depth limit allows and gets trimmed to the size of the tree once
+    it is finished, which moves it to a new allocation. The cases cover the single-variable
+    model ('ndim=1') and the extended model ('ndim>1', whose linear combinations take their buffers
+    from 'SplitScratch'), with numeric and categorical columns, missing values imputed at the
+    nodes, density weights, and the averaged, pooled, full-gain and density criteria mixed in the
+    same trees, along with the histogram and presorted split searches.
+
+    To compile, first build the library through the cmake system, then, from the root folder:
+      g++ -o alloccheck timings/split_alloc_check.cpp -std=c++11 -O3 -I./include -l:libisotree.so -L./build -Wl,-rpath,./build
+    Then run with './alloccheck'
+    It can also be built along with the library by configuring cmake with '-DBUILD_TIMINGS_CHECKS=ON',
+    in which case it runs through 'ctest'.
+*/
+
+/* each allocation gets a header with the number of the tree during which it was made, or zero */
+static const size_t header_size = 16;
+static size_t curr_tree = 0;
+static size_t num_allocs = 0;
+static size_t num_freed = 0;
+
+static void* tagged_malloc(std::size_t size) noexcept
+{
+    char *ptr = (char*)std::malloc(size + header_size);
+    if (!ptr) return NULL;
+    *(size_t*)ptr = curr_tree;
+    num_allocs += curr_tree != 0;
+    return ptr + header_size;
+}
+
+static void tagged_free(void *ptr) noexcept
+{
+    if (!ptr) return;
+    char *base = (char*)ptr - header_size;
+    num_freed += curr_tree != 0 && *(size_t*)base == curr_tree;
+    std::free(base);
+}
+
+void* operator new(std::size_t size)
+{
+    void *ptr = tagged_malloc(size);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](std::size_t size)
+{
+    void *ptr = tagged_malloc(size);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return tagged_malloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return tagged_malloc(size);
+}
+
+void operator delete(void *ptr) noexcept { tagged_free(ptr); }
+void operator delete[](void *ptr) noexcept { tagged_free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { tagged_free(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { tagged_free(ptr); }
+void operator delete(void *ptr, const std::nothrow_t&) noexcept { tagged_free(ptr); }
+void operator delete[](void *ptr, const std::nothrow_t&) noexcept { tagged_free(ptr); }
+
+/* runs the tasks serially, counting the allocations made by each of them in the loop over the trees */
+class TreeCountingExecutor : public Executor
+{
+public:
+    size_t ntrees;
+    std::vector<size_t> allocs;
+    std::vector<size_t> scratch_allocs;
+
+    explicit TreeCountingExecutor(size_t ntrees) : ntrees(ntrees) {}
+    int num_workers() const noexcept override { return 1; }
+    void parallel_for(size_t n, const std::function<void(size_t, int)> &task) override
+    {
+        if (n != this->ntrees)
+        {
+            for (size_t ix = 0; ix < n; ix++)
+                task(ix, 0);
+            return;
+        }
+
+        this->allocs.assign(n, 0);
+        this->scratch_allocs.assign(n, 0);
+        for (size_t tree = 0; tree < n; tree++)
+        {
+            num_allocs = 0;
+            num_freed = 0;
+            curr_tree = tree + 1;
+            task(tree, 0);
+            curr_tree = 0;
+            this->allocs[tree] = num_allocs;
+            this->scratch_allocs[tree] = num_freed;
+        }
+    }
+};
+
+struct Config {
+    const char *name;
+    size_t ndim;
+    bool categ;
+    bool weighted;
+    bool with_missing;
+    CategSplit cat_split_type;
+    SplitSearch split_search;
+};
+
+static bool check_config(const Config &config,
+                         std::vector<double> &X, std::vector<int> &C, std::vector<int> &ncat,
+                         std::vector<double> &weights, size_t nrows, size_t ncols, size_t ncols_categ)
+{
+    const size_t ntrees = 4;
+    const size_t sample_size = 2048;
+    std::vector<double> X_use(X);
+    if (!config.with_missing)
+        for (double &x : X_use) if (std::isnan(x)) x = 0.;
+
+    /* full gain cannot be mixed with categorical columns, and it does not handle missing values */
+    double prob_full_gain = (config.categ || config.with_missing)? 0. : 0.25;
+    double prob_each = (1. - prob_full_gain) / 3.;
+
+    IsoForest model;
+    ExtIsoForest model_ext;
+    TreeCountingExecutor executor(ntrees);
+    {
+        ScopedExecutor scoped_executor(&executor);
+        fit_iforest(config.ndim == 1? &model : NULL, config.ndim == 1? NULL : &model_ext,
+                    X_use.data(), ncols,
+                    config.categ? C.data() : NULL, config.categ? ncols_categ : 0, config.categ? ncat.data() : NULL,
+                    true, (size_t)0, (size_t)0,
+                    (double*)NULL, (int*)NULL, (int*)NULL,
+                    config.ndim, 3, Normal, false,
+                    config.weighted? weights.data() : NULL, false, false,
+                    nrows, sample_size, ntrees,
+                    0, 0,
+                    false, false, true,
+                    Depth, false,
+                    false, (double*)NULL,
+                    (double*)NULL, true,
+                    (double*)NULL, false,
+                    prob_each, prob_each,
+                    prob_full_gain, prob_each,
+                    0., 0.,
+                    0.,
+                    0., config.split_search, Impute,
+                    config.cat_split_type, Weighted,
+                    false, (Imputer*)NULL, 3,
+                    Higher, Inverse, false,
+                    (uint64_t)123, true, (size_t)0,
+                    false, 1);
+    }
+
+    bool passed = executor.allocs.size() == ntrees;
+    for (size_t tree = 0; tree < executor.allocs.size(); tree++)
+    {
+        size_t nnodes = (config.ndim == 1)? model.trees[tree].size() : model_ext.hplanes[tree].size();
+        /* the only scratch allocation allowed is the one from trimming the vector of nodes */
+        bool tree_passed = tree == 0 || executor.scratch_allocs[tree] <= 1;
+        printf("| %s | %d%s | %d | %d | %d |%s\n",
+               config.name, (int)tree, (tree == 0)? " (warm-up)" : "", (int)nnodes,
+               (int)(executor.allocs[tree] - executor.scratch_allocs[tree]), (int)executor.scratch_allocs[tree],
+               tree_passed? "" : " <- allocates scratch space");
+        passed = passed && tree_passed;
+    }
+    return passed;
+}
+
+int main()
+{
+    const size_t nrows = 8192;
+    const size_t ncols = 5;
+    const size_t ncols_categ = 2;
+    std::mt19937 rng(123);
+    std::normal_distribution<double> rnorm(0, 1);
+    std::uniform_real_distribution<double> runif(0, 1);
+
+    std::vector<double> X(nrows * ncols);
+    std::vector<int> C(nrows * ncols_categ);
+    std::vector<int> ncat = {4, 7};
+    std::vector<double> weights(nrows);
+    for (double &x : X) x = (runif(rng) < 0.02)? NAN : rnorm(rng);
+    for (size_t col = 0; col < ncols_categ; col++)
+        for (size_t row = 0; row < nrows; row++)
+            C[row + col*nrows] = (runif(rng) < 0.02)? -1 : (int)(runif(rng) * ncat[col]);
+    for (double &w : weights) w = 0.5 + runif(rng);
+
+    const Config configs[] = {
+        {"ndim=1, numeric", 1, false, false, true, SubSet, SortedSearch},
+        {"ndim=1, numeric, weighted", 1, false, true, false, SubSet, SortedSearch},
+        {"ndim=1, numeric, histograms", 1, false, false, false, SubSet, HistogramSearch},
+        {"ndim=1, numeric, presorted", 1, false, false, false, SubSet, PresortedSearch},
+        {"ndim=1, categorical subsets", 1, true, false, true, SubSet, SortedSearch},
+        {"ndim=1, categorical subsets, weighted", 1, true, true, true, SubSet, SortedSearch},
+        {"ndim=1, single categories, weighted", 1, true, true, true, SingleCateg, SortedSearch},
+        {"ndim=3, numeric", 3, false, false, true, SubSet, SortedSearch},
+        {"ndim=3, numeric, weighted", 3, false, true, false, SubSet, SortedSearch},
+        {"ndim=3, categorical subsets, weighted", 3, true, true, true, SubSet, SortedSearch},
+        {"ndim=3, single categories, weighted", 3, true, true, true, SingleCateg, SortedSearch},
+    };
+
+    bool all_passed = true;
+    printf("| Model | Tree | Nodes | Allocations kept by the model | Scratch allocations |\n");
+    printf("| :---: | :---: | :---: | :---:                        | :---:               |\n");
+    for (const Config &config : configs)
+        all_passed = check_config(config, X, C, ncat, weights, nrows, ncols, ncols_categ) && all_passed;
+    printf("%s\n", all_passed? "No scratch allocations at the nodes after the first tree." : "Some trees allocate scratch space.");
+    return all_passed? EXIT_SUCCESS : EXIT_FAILURE;
+}
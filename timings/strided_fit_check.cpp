@@ -0,0 +1,191 @@
+#include <vector>
+#include <random>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include "isotree.hpp"
+
+/*  Checks that fitting a model to dense data in row-major order or with a leading dimension larger
+    than its number of rows ('fit_iforest' with 'is_col_major' and 'ld_numeric'/'ld_categ') gives
+    the same results as fitting it to the same data in contiguous column-major order, when each
+    tree takes all of the rows (in which case every tree is fit to its own column-major copy of
+    the rows, and the passes over the full data done before fitting the trees read it in place)
+    and when using sub-sampling.
+
+    The results compared are the outlier scores calculated at fit time, the imputations made at
+    fit time (written back into the array that was passed), and the predictions of the fitted
+    models on the column-major data. The models must be exactly the same, and so must their
+    predictions, while the outputs calculated at fit time are compared up to roundoff. The configurations cover
+    missing values with categorical columns, variable ranges and presorted guided splits,
+    histogram splits in the extended model, kurtosis weights, and sampling with replacement.
+
+    To compile, first build the library through the cmake system, then, from the root folder:
+      g++ -o stridedcheck timings/strided_fit_check.cpp -std=c++11 -O3 -I./include -l:libisotree.so -L./build -Wl,-rpath,./build
+    Then run with './stridedcheck'
+    It can also be built along with the library by configuring cmake with '-DBUILD_TIMINGS_CHECKS=ON',
+    in which case it runs through 'ctest'.
+*/
+
+struct Config {
+    const char *name;
+    size_t ndim;
+    size_t ncols_categ;
+    size_t sample_size;
+    bool with_replacement;
+    bool impute_at_fit;
+    bool weigh_by_kurt;
+    double prob_pick_by_gain_avg;
+    double prob_pick_col_by_range;
+    SplitSearch split_search;
+};
+
+struct FitResult {
+    std::vector<double> depths_fit;
+    std::vector<double> numeric_imputed;
+    std::vector<int> categ_imputed;
+    std::vector<double> scores;
+};
+
+static FitResult fit_model(const Config &config, const std::vector<double> &X, const std::vector<int> &C,
+                           size_t nrows, size_t ncols, bool is_col_major, size_t ld_numeric, size_t ld_categ)
+{
+    const size_t ncols_categ = config.ncols_categ;
+    const bool full_sample = config.sample_size == 0 && !config.with_replacement;
+
+    /* lay out the data with the requested orientation and padding */
+    std::vector<double> X_in(ld_numeric * (is_col_major? ncols : nrows), NAN);
+    std::vector<int> C_in(std::max((size_t)1, ld_categ * (is_col_major? ncols_categ : nrows)), -1);
+    for (size_t row = 0; row < nrows; row++)
+    {
+        for (size_t col = 0; col < ncols; col++)
+            X_in[is_col_major? (row + col*ld_numeric) : (row*ld_numeric + col)] = X[row + col*nrows];
+        for (size_t col = 0; col < ncols_categ; col++)
+            C_in[is_col_major? (row + col*ld_categ) : (row*ld_categ + col)] = C[row + col*nrows];
+    }
+    std::vector<int> ncat(std::max((size_t)1, ncols_categ), 3);
+
+    IsoForest model;
+    ExtIsoForest model_ext;
+    Imputer imputer;
+    FitResult res;
+    if (full_sample) res.depths_fit.resize(nrows);
+    fit_iforest(config.ndim == 1? &model : NULL, config.ndim == 1? NULL : &model_ext,
+                X_in.data(), ncols,
+                ncols_categ? C_in.data() : NULL, ncols_categ, ncols_categ? ncat.data() : NULL,
+                is_col_major, ld_numeric, ld_categ,
+                (double*)NULL, (int*)NULL, (int*)NULL,
+                config.ndim, 3, Normal, false,
+                (double*)NULL, config.with_replacement, false,
+                nrows, config.sample_size? config.sample_size : nrows, 20,
+                0, 0,
+                true, false, true,
+                Depth, false,
+                false, (double*)NULL,
+                full_sample? res.depths_fit.data() : NULL, true,
+                (double*)NULL, config.weigh_by_kurt,
+                0., config.prob_pick_by_gain_avg,
+                0., 0.,
+                config.prob_pick_col_by_range, 0.,
+                0.,
+                0., config.split_search, Impute,
+                SubSet, Weighted,
+                false, config.impute_at_fit? &imputer : NULL, 3,
+                Higher, Inverse, config.impute_at_fit,
+                (uint64_t)123, true, (size_t)0,
+                false, 2);
+
+    if (config.impute_at_fit)
+    {
+        res.numeric_imputed.resize(nrows * ncols);
+        res.categ_imputed.resize(nrows * ncols_categ);
+        for (size_t row = 0; row < nrows; row++)
+        {
+            for (size_t col = 0; col < ncols; col++)
+                res.numeric_imputed[row + col*nrows] = X_in[is_col_major? (row + col*ld_numeric) : (row*ld_numeric + col)];
+            for (size_t col = 0; col < ncols_categ; col++)
+                res.categ_imputed[row + col*nrows] = C_in[is_col_major? (row + col*ld_categ) : (row*ld_categ + col)];
+        }
+    }
+
+    res.scores.resize(nrows);
+    std::vector<double> X_pred(X);
+    std::vector<int> C_pred(C);
+    predict_iforest(X_pred.data(), ncols_categ? C_pred.data() : NULL,
+                    true, ncols, ncols_categ,
+                    (double*)NULL, (int*)NULL, (int*)NULL,
+                    (double*)NULL, (int*)NULL, (int*)NULL,
+                    nrows, 1, true,
+                    config.ndim == 1? &model : NULL, config.ndim == 1? NULL : &model_ext,
+                    res.scores.data(), (int*)NULL, (double*)NULL,
+                    (TreesIndexer*)NULL);
+    return res;
+}
+
+/* outputs calculated at fit time are summed over the threads in an order that depends on which
+   trees each one took, so those are compared up to roundoff */
+template <class T>
+static bool same_values(const std::vector<T> &a, const std::vector<T> &b, double tol = 0.)
+{
+    if (a.size() != b.size()) return false;
+    for (size_t ix = 0; ix < a.size(); ix++)
+    {
+        if (std::isnan((double)a[ix]) && std::isnan((double)b[ix])) continue;
+        if (std::fabs((double)a[ix] - (double)b[ix]) > tol * std::fmax(1., std::fabs((double)a[ix]))) return false;
+    }
+    return true;
+}
+
+int main()
+{
+    const size_t nrows = 3000;
+    const size_t ncols = 6;
+    const size_t ncols_categ = 2;
+    std::mt19937 rng(456);
+    std::normal_distribution<double> rnorm(0, 1);
+    std::uniform_real_distribution<double> runif(0, 1);
+    std::uniform_int_distribution<int> rcat(0, 2);
+
+    /* missing values are only generated for the configurations that impute them */
+    std::vector<double> X(nrows * ncols), X_missing;
+    std::vector<int> C(nrows * ncols_categ), C_missing;
+    for (double &x : X) x = rnorm(rng);
+    for (int &c : C) c = rcat(rng);
+    X_missing = X;
+    C_missing = C;
+    for (double &x : X_missing) if (runif(rng) < 0.05) x = NAN;
+    for (int &c : C_missing) if (runif(rng) < 0.05) c = -1;
+
+    const Config configs[] = {
+        {"missing values and categorical columns", 1, ncols_categ, 0, false, true, false, 0., 0., SortedSearch},
+        {"extended, missing values", 2, ncols_categ, 0, false, true, false, 0., 0., SortedSearch},
+        {"variable ranges and presorted splits", 1, 0, 0, false, false, false, 1., 1., PresortedSearch},
+        {"extended, histogram splits", 2, 0, 0, false, false, false, 1., 0., HistogramSearch},
+        {"kurtosis weights", 1, ncols_categ, 0, false, false, true, 0., 0., SortedSearch},
+        {"with replacement", 1, ncols_categ, nrows, true, false, false, 0., 0., SortedSearch},
+        {"sub-sampling", 2, ncols_categ, 512, false, false, false, 0., 0., SortedSearch},
+    };
+
+    bool all_ok = true;
+    for (const Config &config : configs)
+    {
+        const std::vector<double> &Xc = config.impute_at_fit? X_missing : X;
+        const std::vector<int> &Cc = config.impute_at_fit? C_missing : C;
+        FitResult ref = fit_model(config, Xc, Cc, nrows, ncols, true, nrows, nrows);
+        FitResult row_major = fit_model(config, Xc, Cc, nrows, ncols, false, ncols, config.ncols_categ);
+        FitResult row_padded = fit_model(config, Xc, Cc, nrows, ncols, false, ncols + 3, config.ncols_categ + 1);
+        FitResult col_padded = fit_model(config, Xc, Cc, nrows, ncols, true, nrows + 5, nrows + 2);
+
+        for (const FitResult *res : {&row_major, &row_padded, &col_padded})
+        {
+            const char *layout = (res == &row_major)? "row-major" : (res == &row_padded)? "padded row-major" : "padded column-major";
+            bool ok = same_values(ref.depths_fit, res->depths_fit, 1e-12) &&
+                      same_values(ref.numeric_imputed, res->numeric_imputed, 1e-12) &&
+                      same_values(ref.categ_imputed, res->categ_imputed) &&
+                      same_values(ref.scores, res->scores);
+            printf("%s, %s: %s\n", config.name, layout, ok? "OK" : "MISMATCH");
+            all_ok = all_ok && ok;
+        }
+    }
+
+    return all_ok? EXIT_SUCCESS : EXIT_FAILURE;
+}
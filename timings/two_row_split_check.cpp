@@ -0,0 +1,93 @@
+#include <vector>
+#include <random>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include "isotree_oop.hpp"
+
+/*  Checks that the default split search for guided splits ('SortedSearch') sends the rows
+    of a node to the same branches as the split that it picks. This is done by comparing
+    the trees against the ones obtained with 'PresortedSearch', which finds the same splits
+    but keeps the rows of each node in ascending order by every column beforehand.
+
+    When the rows are already split by the criterion ('missing_action=Impute' or 'Fail'
+    with dense data), the node takes the rows up to the split as its left branch. A node
+    with only two non-missing values in the column does not need to sort them in order to
+    find the split, but if they are not in ascending order, the larger one ends up in the
+    left branch. With missing values, that branch also gets the rows with missing values,
+    so it gets split further using the wrong row, and the trees end up different.
+
+    The data is small and has many missing values, and each node evaluates a single column
+    ('ntry=1'), so that many nodes end up with two non-missing values in the chosen column.
+    This is checked with and without density weights ('weight_as_sample=false'), which
+    use the weighted version of the criterion.
+
+    To compile, first build the library through the cmake system, then, from the root folder:
+      g++ -o tworowcheck timings/two_row_split_check.cpp -std=c++11 -O3 -I./include -l:libisotree.so -L./build -Wl,-rpath,./build
+    Then run with './tworowcheck'
+    It can also be built along with the library by configuring cmake with '-DBUILD_TIMINGS_CHECKS=ON',
+    in which case it runs through 'ctest'.
+*/
+
+using namespace isotree;
+
+static bool same_trees(const IsoForest &model1, const IsoForest &model2)
+{
+    if (model1.trees.size() != model2.trees.size()) return false;
+    for (size_t tree = 0; tree < model1.trees.size(); tree++)
+    {
+        const auto &nodes1 = model1.trees[tree];
+        const auto &nodes2 = model2.trees[tree];
+        if (nodes1.size() != nodes2.size()) return false;
+        for (size_t node = 0; node < nodes1.size(); node++)
+        {
+            if (nodes1[node].tree_left != nodes2[node].tree_left) return false;
+            if (nodes1[node].tree_left == 0) continue;
+            if (nodes1[node].col_num != nodes2[node].col_num) return false;
+            if (nodes1[node].num_split != nodes2[node].num_split) return false;
+        }
+    }
+    return true;
+}
+
+int main()
+{
+    const size_t nrows = 200;
+    const size_t ncols = 3;
+    std::mt19937 rng(123);
+    std::normal_distribution<double> rnorm(0, 1);
+    std::uniform_real_distribution<double> runif(0, 1);
+    std::vector<double> X(nrows * ncols);
+    for (double &x : X) x = (runif(rng) < 0.3)? NAN : rnorm(rng);
+    std::vector<double> weights(nrows);
+    for (double &w : weights) w = 0.5 + runif(rng);
+
+    bool all_passed = true;
+    printf("| Weights | Same trees |\n");
+    printf("| :---:   | :---:      |\n");
+    for (bool use_weights : {false, true})
+    {
+        IsolationForest iso[2];
+        for (int model = 0; model < 2; model++)
+        {
+            iso[model].ntrees = 100;
+            iso[model].sample_size = 0;
+            iso[model].ntry = 1;
+            iso[model].prob_pick_by_gain_pl = 1;
+            iso[model].missing_action = Impute;
+            iso[model].weight_as_sample = false;
+            iso[model].split_search = model? PresortedSearch : SortedSearch;
+            iso[model].nthreads = 1;
+            iso[model].fit(X.data(), ncols, nrows,
+                           (int*)nullptr, 0, (int*)nullptr,
+                           use_weights? weights.data() : (double*)nullptr, (double*)nullptr);
+        }
+
+        bool passed = same_trees(iso[0].get_model(), iso[1].get_model());
+        printf("| %s | %s |%s\n", use_weights? "density" : "none",
+               passed? "yes" : "no", passed? "" : " <- rows went to the wrong branch");
+        all_passed = all_passed && passed;
+    }
+    printf("%s\n", all_passed? "Two-row splits are divided correctly." : "Two-row splits are divided incorrectly.");
+    return all_passed? 0 : 1;
+}